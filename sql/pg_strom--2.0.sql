@@ -91,6 +91,414 @@ CREATE FUNCTION pgstrom.pgstrom_device_preserved_meminfo()
 CREATE VIEW pgstrom.device_preserved_meminfo
   AS SELECT * FROM pgstrom.pgstrom_device_preserved_meminfo();
 
+CREATE TYPE pgstrom.__pgstrom_gpupreagg_feedback_info AS (
+  database_id       oid,
+  fingerprint       int8,
+  estimated_ngroups float8,
+  actual_ngroups    int8,
+  fhash_conflicts   int8,
+  nitems_in         int8,
+  nexecs            int8,
+  last_update       timestamp with time zone
+);
+CREATE FUNCTION pgstrom.pgstrom_gpupreagg_feedback_info()
+  RETURNS SETOF pgstrom.__pgstrom_gpupreagg_feedback_info
+  AS 'MODULE_PATHNAME'
+  LANGUAGE C VOLATILE;
+CREATE VIEW pgstrom.gpupreagg_feedback
+  AS SELECT *, actual_ngroups / estimated_ngroups AS actual_estimated_ratio
+       FROM pgstrom.pgstrom_gpupreagg_feedback_info();
+
+CREATE TYPE pgstrom.__pgstrom_program_cache_info AS (
+  num_entries       int8,
+  total_usage       int8,
+  num_lookups       int8,
+  num_hits          int8,
+  num_file_loads    int8,
+  num_builds        int8
+);
+CREATE FUNCTION pgstrom.pgstrom_program_cache_info()
+  RETURNS pgstrom.__pgstrom_program_cache_info
+  AS 'MODULE_PATHNAME'
+  LANGUAGE C VOLATILE;
+CREATE VIEW pgstrom.program_cache_info
+  AS SELECT *, CASE WHEN num_lookups > 0
+                    THEN num_hits::float8 / num_lookups::float8
+                    ELSE NULL
+               END AS hit_ratio
+       FROM pgstrom.pgstrom_program_cache_info();
+
+-- debug functions of the persistent program cache
+CREATE FUNCTION pgstrom.program_cache_file_save(text,    -- directory
+                                                bigint,  -- size limit [kB]
+                                                text,    -- kern_define
+                                                text,    -- kern_source
+                                                bytea,   -- ptx_image
+                                                int = 0, -- target_cc
+                                                int = 0, -- extra_flags
+                                                int = 0) -- varlena_bufsz
+  RETURNS text
+  AS 'MODULE_PATHNAME','pgstrom_program_cache_file_save'
+  LANGUAGE C STRICT VOLATILE;
+REVOKE ALL ON FUNCTION
+  pgstrom.program_cache_file_save(text,bigint,text,text,bytea,int,int,int)
+  FROM public;
+CREATE FUNCTION pgstrom.program_cache_file_load(text,    -- directory
+                                                text,    -- kern_define
+                                                text,    -- kern_source
+                                                int = 0, -- target_cc
+                                                int = 0, -- extra_flags
+                                                int = 0) -- varlena_bufsz
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_program_cache_file_load'
+  LANGUAGE C STRICT VOLATILE;
+REVOKE ALL ON FUNCTION
+  pgstrom.program_cache_file_load(text,text,text,int,int,int)
+  FROM public;
+CREATE FUNCTION pgstrom.program_cache_file_evict(text,   -- directory
+                                                 bigint) -- size limit [kB]
+  RETURNS int
+  AS 'MODULE_PATHNAME','pgstrom_program_cache_file_evict'
+  LANGUAGE C STRICT VOLATILE;
+REVOKE ALL ON FUNCTION
+  pgstrom.program_cache_file_evict(text,bigint)
+  FROM public;
+
+--
+-- Functions for columnar cache
+--
+CREATE FUNCTION pgstrom.ccache_invalidator()
+  RETURNS trigger
+  AS 'MODULE_PATHNAME','pgstrom_ccache_invalidator'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION public.pgstrom_ccache_enabled(regclass)
+  RETURNS text
+AS $$
+DECLARE
+  qualified_name text;
+  trig_name_r text;
+  trig_name_s text;
+BEGIN
+  qualified_name = $1::regclass::text;
+  trig_name_r = '__ccache_' || $1::oid || '_inval_r';
+  trig_name_s = '__ccache_' || $1::oid || '_inval_s';
+  EXECUTE format('CREATE TRIGGER %I AFTER INSERT OR UPDATE OR DELETE '
+                 'ON %s FOR ROW EXECUTE PROCEDURE '
+                 'pgstrom.ccache_invalidator()',
+                 trig_name_r, qualified_name);
+  EXECUTE format('CREATE TRIGGER %I AFTER TRUNCATE '
+                 'ON %s FOR STATEMENT EXECUTE PROCEDURE '
+                 'pgstrom.ccache_invalidator()',
+                 trig_name_s, qualified_name);
+  EXECUTE format('ALTER TABLE %s ENABLE ALWAYS TRIGGER %I',
+                 qualified_name, trig_name_r);
+  EXECUTE format('ALTER TABLE %s ENABLE ALWAYS TRIGGER %I',
+                 qualified_name, trig_name_s);
+  RETURN 'enabled';
+END
+$$ LANGUAGE 'plpgsql';
+
+CREATE FUNCTION public.pgstrom_ccache_disabled(regclass)
+  RETURNS text
+AS $$
+DECLARE
+  qualified_name text;
+  trig_name_r text;
+  trig_name_s text;
+BEGIN
+  qualified_name = $1::regclass::text;
+  trig_name_r = '__ccache_' || $1::oid || '_inval_r';
+  trig_name_s = '__ccache_' || $1::oid || '_inval_s';
+  EXECUTE format('DROP TRIGGER IF EXISTS %I ON %s RESTRICT',
+                 trig_name_r, qualified_name);
+  EXECUTE format('DROP TRIGGER IF EXISTS %I ON %s RESTRICT',
+                 trig_name_s, qualified_name);
+  RETURN 'disabled';
+END
+$$ LANGUAGE 'plpgsql';
+
+CREATE FUNCTION public.pgstrom_ccache_prewarm(regclass)
+  RETURNS int4
+  AS 'MODULE_PATHNAME','pgstrom_ccache_prewarm'
+  LANGUAGE C STRICT;
+
+CREATE TYPE pgstrom.__pgstrom_ccache_info AS (
+  database_id oid,
+  table_id    regclass,
+  block_nr    int4,
+  nitems      int8,
+  length      int8,
+  ctime       timestamp with time zone,
+  atime       timestamp with time zone
+);
+CREATE FUNCTION pgstrom.pgstrom_ccache_info()
+  RETURNS SETOF pgstrom.__pgstrom_ccache_info
+  AS 'MODULE_PATHNAME'
+  LANGUAGE C VOLATILE;
+CREATE VIEW pgstrom.ccache_info
+  AS SELECT * FROM pgstrom.pgstrom_ccache_info();
+
+CREATE TYPE pgstrom.__pgstrom_ccache_builder_info AS (
+  builder_id  int4,
+  database_id oid,
+  state       text,
+  table_id    regclass,
+  block_nr    int4
+);
+CREATE FUNCTION pgstrom.pgstrom_ccache_builder_info()
+  RETURNS SETOF pgstrom.__pgstrom_ccache_builder_info
+  AS 'MODULE_PATHNAME'
+  LANGUAGE C VOLATILE;
+CREATE VIEW pgstrom.ccache_builder_info
+  AS SELECT * FROM pgstrom.pgstrom_ccache_builder_info();
+
+--
+-- Cost profiles for the planner
+--
+CREATE TABLE pgstrom.cost_profile (
+  device_nr         int NOT NULL,   -- -1 means any GPU device
+  tablespace        oid NOT NULL,   --  0 means any tablespace
+  gpu_setup_cost    float8,
+  gpu_dma_cost      float8,
+  gpu_operator_cost float8,
+  cpu_repack_cost   float8,
+  calibrated        timestamp with time zone NOT NULL DEFAULT now(),
+  PRIMARY KEY (device_nr, tablespace)
+);
+SELECT pg_catalog.pg_extension_config_dump('pgstrom.cost_profile', '');
+
+CREATE FUNCTION pgstrom.cost_profile_invalidator()
+  RETURNS trigger
+  AS 'MODULE_PATHNAME','pgstrom_cost_profile_invalidator'
+  LANGUAGE C STRICT;
+CREATE TRIGGER cost_profile_inval
+  AFTER INSERT OR UPDATE OR DELETE OR TRUNCATE ON pgstrom.cost_profile
+  FOR EACH STATEMENT EXECUTE PROCEDURE pgstrom.cost_profile_invalidator();
+
+CREATE FUNCTION pgstrom.tablespace_optimal_gpu(oid)
+  RETURNS int
+  AS 'MODULE_PATHNAME','pgstrom_tablespace_optimal_gpu'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION pgstrom.calibrate_host_repack(regclass, int = 3,
+                                              OUT ntuples bigint,
+                                              OUT scan_ms float8,
+                                              OUT repack_ms float8)
+  RETURNS record
+  AS 'MODULE_PATHNAME','pgstrom_calibrate_host_repack'
+  LANGUAGE C STRICT;
+
+-- elapsed time [ms] and estimated cost of the first plan node of the label
+CREATE FUNCTION pgstrom.__calibrate_plan_node(json, text,
+                                              OUT elapsed float8,
+                                              OUT cost float8)
+  RETURNS record
+AS $$
+WITH RECURSIVE n(node) AS (
+  SELECT $1->0->'Plan'
+  UNION ALL
+  SELECT p FROM n, json_array_elements(n.node->'Plans') p
+)
+SELECT (node->>'Actual Total Time')::float8 *
+       (node->>'Actual Loops')::float8,
+       (node->>'Total Cost')::float8
+  FROM n
+ WHERE coalesce(node->>'Custom Plan Provider', node->>'Node Type') = $2
+ LIMIT 1
+$$ LANGUAGE sql STRICT;
+
+--
+-- pgstrom.calibrate_cost_model
+--
+-- It runs synthetic scan/join/aggregate workloads on the tablespace, then
+-- fits the elapsed time of GPU nodes (net of the plain SeqScan) to
+--   setup + dma * (# of chunks) + operator * (# of rows * # of operators)
+-- by least squares. The elapsed time is translated to the cost unit by
+-- the ratio of the plain SeqScan. If cpu_only, it calibrates the host
+-- side costs only, for the profile of device_nr = -1.
+--
+CREATE FUNCTION pgstrom.calibrate_cost_model(tablespace_name name = NULL,
+                                             nrows int = 2000000,
+                                             cpu_only bool = false)
+  RETURNS SETOF pgstrom.cost_profile
+AS $$
+DECLARE
+  tbl           text := 'pgstrom.__calibrate_' || pg_backend_pid();
+  dim           text := 'pgstrom.__calibrate_' || pg_backend_pid() || '_d';
+  tblspc_oid    oid := 0;
+  tblspc_clause text := '';
+  dev_nr        int := -1;
+  chunk_sz      float8;
+  curr_nrows    int := 0;
+  step          int;
+  nchunks       float8;
+  x2            float8;
+  y             float8;
+  plan          json;
+  base          record;
+  r             record;
+  h             record;
+  w             text[];
+  workloads     text[] := ARRAY[
+    ['GpuScan',   'SELECT count(*) FROM %1$s WHERE a + b > c', '2'],
+    ['GpuScan',   'SELECT count(*) FROM %1$s WHERE sqrt(a * a + b * b) + '
+                  'ln(c + 1.0) > c * 2.0 - a', '10'],
+    ['GpuJoin',   'SELECT count(*) FROM %1$s t JOIN %2$s d '
+                  'ON t.id %% 1000 = d.id', '3'],
+    ['GpuPreAgg', 'SELECT id %% 100, sum(a), avg(b), max(c) '
+                  'FROM %1$s GROUP BY 1', '5']];
+  sum_ms        float8 := 0.0;
+  sum_cost      float8 := 0.0;
+  unit_ms       float8;
+  -- normal equations of y = a + b * x1 + c * x2
+  n   float8 := 0;  s1  float8 := 0;  s2  float8 := 0;
+  s11 float8 := 0;  s12 float8 := 0;  s22 float8 := 0;
+  sy  float8 := 0;  s1y float8 := 0;  s2y float8 := 0;
+  det           float8;
+  setup_cost    float8;
+  dma_cost      float8;
+  operator_cost float8;
+  repack_cost   float8;
+BEGIN
+  IF nrows < 1000 THEN
+    RAISE EXCEPTION 'nrows must be 1000 or larger';
+  END IF;
+  -- 0 is reserved for the profile of any tablespace
+  IF tablespace_name IS NOT NULL THEN
+    SELECT oid INTO tblspc_oid FROM pg_tablespace
+     WHERE spcname = tablespace_name;
+    IF NOT FOUND THEN
+      RAISE EXCEPTION 'tablespace "%" does not exist', tablespace_name;
+    END IF;
+    tblspc_clause := format('TABLESPACE %I', tablespace_name);
+  ELSE
+    SELECT dattablespace INTO tblspc_oid FROM pg_database
+     WHERE datname = current_database();
+  END IF;
+  SELECT setting::float8 * 1024.0 INTO chunk_sz
+    FROM pg_settings WHERE name = 'pg_strom.chunk_size';
+
+  EXECUTE format('CREATE UNLOGGED TABLE %s (id int, a float8, b float8, '
+                 'c float8, memo text) %s', tbl, tblspc_clause);
+  EXECUTE format('CREATE UNLOGGED TABLE %s (id int, label text) %s',
+                 dim, tblspc_clause);
+  EXECUTE format('INSERT INTO %s SELECT x, md5(x::text) '
+                 'FROM generate_series(0,999) x', dim);
+  EXECUTE format('ANALYZE %s', dim);
+
+  FOREACH step IN ARRAY ARRAY[nrows / 4, nrows / 2, nrows]
+  LOOP
+    EXECUTE format('INSERT INTO %s SELECT x, random() * 100.0, '
+                   'random() * 100.0, random() * 100.0, md5(x::text) '
+                   'FROM generate_series(%s,%s) x',
+                   tbl, curr_nrows + 1, step);
+    curr_nrows := step;
+    EXECUTE format('ANALYZE %s', tbl);
+    nchunks := pg_relation_size(tbl::regclass)::float8 / chunk_sz;
+
+    -- baseline by the plain SeqScan
+    PERFORM set_config('pg_strom.enabled', 'off', true);
+    PERFORM set_config('enable_seqscan', 'on', true);
+    EXECUTE format('EXPLAIN (ANALYZE, FORMAT JSON) SELECT count(*) FROM %s',
+                   tbl) INTO plan;
+    base := pgstrom.__calibrate_plan_node(plan, 'Seq Scan');
+    IF base.elapsed IS NULL THEN
+      RAISE EXCEPTION 'SeqScan was not chosen for the baseline workload';
+    END IF;
+    sum_ms := sum_ms + base.elapsed;
+    sum_cost := sum_cost + base.cost;
+
+    CONTINUE WHEN cpu_only;
+
+    -- GPU workloads
+    PERFORM set_config('pg_strom.enabled', 'on', true);
+    PERFORM set_config('enable_seqscan', 'off', true);
+    FOREACH w SLICE 1 IN ARRAY workloads
+    LOOP
+      PERFORM set_config('pg_strom.enable_gpupreagg',
+                         CASE WHEN w[1] = 'GpuPreAgg'
+                              THEN 'on' ELSE 'off' END, true);
+      EXECUTE 'EXPLAIN (ANALYZE, FORMAT JSON) ' || format(w[2], tbl, dim)
+         INTO plan;
+      r := pgstrom.__calibrate_plan_node(plan, w[1]);
+      IF r.elapsed IS NULL THEN
+        RAISE EXCEPTION '% was not chosen for the calibration workload: %',
+                        w[1], w[2];
+      END IF;
+      x2 := curr_nrows::float8 * w[3]::float8;
+      y  := r.elapsed - base.elapsed;
+      n   := n + 1;
+      s1  := s1 + nchunks;
+      s2  := s2 + x2;
+      s11 := s11 + nchunks * nchunks;
+      s12 := s12 + nchunks * x2;
+      s22 := s22 + x2 * x2;
+      sy  := sy + y;
+      s1y := s1y + nchunks * y;
+      s2y := s2y + x2 * y;
+    END LOOP;
+  END LOOP;
+  unit_ms := sum_ms / sum_cost;
+
+  -- host side costs
+  h := pgstrom.calibrate_host_repack(tbl::regclass);
+  repack_cost := greatest(h.repack_ms - h.scan_ms, 0.0) /
+                 greatest(h.ntuples, 1) / unit_ms;
+
+  IF NOT cpu_only THEN
+    det := n   * (s11 * s22 - s12 * s12)
+         - s1  * (s1  * s22 - s12 * s2)
+         + s2  * (s1  * s12 - s11 * s2);
+    IF abs(det) < 1.0e-9 THEN
+      RAISE EXCEPTION 'calibration workloads are degenerated';
+    END IF;
+    setup_cost    := (sy  * (s11 * s22 - s12 * s12)
+                    - s1  * (s1y * s22 - s12 * s2y)
+                    + s2  * (s1y * s12 - s11 * s2y)) / det;
+    dma_cost      := (n   * (s1y * s22 - s2y * s12)
+                    - sy  * (s1  * s22 - s12 * s2)
+                    + s2  * (s1  * s2y - s1y * s2)) / det;
+    operator_cost := (n   * (s11 * s2y - s12 * s1y)
+                    - s1  * (s1  * s2y - s1y * s2)
+                    + sy  * (s1  * s12 - s11 * s2)) / det;
+    setup_cost    := greatest(setup_cost, 0.0) / unit_ms;
+    dma_cost      := greatest(dma_cost, 0.0) / unit_ms;
+    operator_cost := greatest(operator_cost, 0.0) / unit_ms;
+    dev_nr := pgstrom.tablespace_optimal_gpu(tblspc_oid);
+  END IF;
+
+  EXECUTE format('DROP TABLE %s, %s', tbl, dim);
+
+  INSERT INTO pgstrom.cost_profile AS p
+       VALUES (dev_nr, tblspc_oid, setup_cost, dma_cost,
+               operator_cost, repack_cost, now())
+  ON CONFLICT (device_nr, tablespace) DO UPDATE
+     SET gpu_setup_cost    = coalesce(EXCLUDED.gpu_setup_cost,
+                                      p.gpu_setup_cost),
+         gpu_dma_cost      = coalesce(EXCLUDED.gpu_dma_cost,
+                                      p.gpu_dma_cost),
+         gpu_operator_cost = coalesce(EXCLUDED.gpu_operator_cost,
+                                      p.gpu_operator_cost),
+         cpu_repack_cost   = EXCLUDED.cpu_repack_cost,
+         calibrated        = EXCLUDED.calibrated;
+
+  RETURN QUERY SELECT * FROM pgstrom.cost_profile p
+                WHERE p.device_nr = dev_nr AND p.tablespace = tblspc_oid;
+END
+$$ LANGUAGE 'plpgsql'
+   SET max_parallel_workers_per_gather = 0
+   SET pg_strom.enabled = on
+   SET pg_strom.enable_gpupreagg = on
+   SET pg_strom.enable_cost_profile = off
+   SET pg_strom.gpu_setup_cost = 0
+   SET pg_strom.gpu_dma_cost = 0
+   SET pg_strom.gpu_operator_cost = 0
+   SET enable_seqscan = on
+   SET enable_hashjoin = off
+   SET enable_mergejoin = off
+   SET enable_nestloop = off;
+
 --
 -- Functions/Languages to support PL/CUDA
 --
@@ -248,6 +656,13 @@ CREATE FUNCTION pgstrom.gstore_fdw_chunk_info()
 CREATE VIEW pgstrom.gstore_fdw_chunk_info AS
   SELECT * FROM pgstrom.gstore_fdw_chunk_info();
 
+CREATE FUNCTION pgstrom.gstore_fdw_checkpoint_validate(reggstore, bytea)
+  RETURNS text
+  AS 'MODULE_PATHNAME','pgstrom_gstore_fdw_checkpoint_validate'
+  LANGUAGE C STRICT VOLATILE;
+REVOKE ALL ON FUNCTION pgstrom.gstore_fdw_checkpoint_validate(reggstore, bytea)
+  FROM public;
+
 CREATE FUNCTION public.lo_import_gpu(int, bytea, bigint, bigint, oid=0)
   RETURNS oid
   AS 'MODULE_PATHNAME','pgstrom_lo_import_gpu'
@@ -258,6 +673,26 @@ CREATE FUNCTION public.lo_export_gpu(oid, int, bytea, bigint, bigint)
   AS 'MODULE_PATHNAME','pgstrom_lo_export_gpu'
   LANGUAGE C STRICT VOLATILE;
 
+--
+-- Handlers for arrow_fdw extension
+--
+CREATE FUNCTION pgstrom.arrow_fdw_handler()
+  RETURNS fdw_handler
+  AS  'MODULE_PATHNAME','pgstrom_arrow_fdw_handler'
+  LANGUAGE C STRICT;
+
+CREATE FUNCTION pgstrom.arrow_fdw_validator(text[],oid)
+  RETURNS void
+  AS 'MODULE_PATHNAME','pgstrom_arrow_fdw_validator'
+  LANGUAGE C STRICT;
+
+CREATE FOREIGN DATA WRAPPER arrow_fdw
+  HANDLER   pgstrom.arrow_fdw_handler
+  VALIDATOR pgstrom.arrow_fdw_validator;
+
+CREATE SERVER arrow_fdw
+  FOREIGN DATA WRAPPER arrow_fdw;
+
 --
 -- Type re-interpretation routines
 --
@@ -2273,6 +2708,22 @@ CREATE OPERATOR CLASS pg_catalog.float2_ops
 -- SQL functions to support PG-Strom regression test
 --
 -- ==================================================================
+CREATE TYPE pgstrom.__pgstrom_bench_tuple_deform AS (
+  format          text,
+  nitems          bigint,
+  generic_ms      float8,
+  specialized_ms  float8,
+  speedup         float8
+);
+CREATE FUNCTION pgstrom.bench_tuple_deform(regclass,
+                                           int = 100000,
+                                           int = 10)
+  RETURNS SETOF pgstrom.__pgstrom_bench_tuple_deform
+  AS 'MODULE_PATHNAME','pgstrom_bench_tuple_deform'
+  LANGUAGE C STRICT VOLATILE;
+REVOKE ALL ON FUNCTION pgstrom.bench_tuple_deform(regclass,int,int)
+  FROM public;
+
 CREATE FUNCTION pgstrom.random_int(float=0.0,      -- NULL ratio (%)
                                    bigint=null,    -- lower bound
                                    bigint=null)    -- upper bound
@@ -0,0 +1,1757 @@
+/*
+ * arrow_fdw.c
+ *
+ * Routines to map Apache Arrow files as PG's Foreign-Table.
+ * ----
+ * Copyright 2011-2018 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2018 (C) The PG-Strom Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "pg_strom.h"
+
+/*
+ * Definitions of Apache Arrow (Schema.fbs / Message.fbs / File.fbs)
+ *
+ * We only pick up the enum values and table layouts we actually use.
+ * See the flatbuffer definitions in the Apache Arrow project for details.
+ */
+#define ARROW_SIGNATURE					"ARROW1"
+#define ARROW_SIGNATURE_SZ				6
+
+/* Arrow::Type */
+#define ArrowType__Int					2
+#define ArrowType__FloatingPoint		3
+#define ArrowType__Binary				4
+#define ArrowType__Utf8					5
+#define ArrowType__Bool					6
+#define ArrowType__Date					8
+#define ArrowType__Timestamp			10
+
+/* Arrow::Precision */
+#define ArrowPrecision__Single			1
+#define ArrowPrecision__Double			2
+
+/* Arrow::DateUnit */
+#define ArrowDateUnit__Day				0
+#define ArrowDateUnit__MilliSecond		1
+
+/* Arrow::TimeUnit */
+#define ArrowTimeUnit__Second			0
+#define ArrowTimeUnit__MilliSecond		1
+#define ArrowTimeUnit__MicroSecond		2
+#define ArrowTimeUnit__NanoSecond		3
+
+/* Arrow::MessageHeader */
+#define ArrowMessageHeader__RecordBatch	3
+
+/* Arrow::Endianness */
+#define ArrowEndianness__Little			0
+
+/* Arrow::FieldNode and Arrow::Buffer; both are 16bytes struct */
+#define ARROW_FIELD_NODE_SZ				16
+#define ARROW_BUFFER_SZ					16
+/* Arrow::Block; 24bytes struct */
+#define ARROW_BLOCK_SZ					24
+
+/*
+ * FBTable - a reference to flatbuffer's table
+ */
+typedef struct
+{
+	const char	   *base;		/* head of the mapped region */
+	const char	   *end;		/* tail of the mapped region */
+	const char	   *pos;		/* head of the table */
+	const int16	   *vtable;		/* vtable of the table */
+	int				vtable_sz;	/* length of the vtable in bytes */
+} FBTable;
+
+/*
+ * ArrowFieldInfo - properties of Arrow::Field
+ */
+typedef struct
+{
+	char	   *field_name;
+	int			type_tag;		/* one of ArrowType__* */
+	int			bit_width;		/* Int, FloatingPoint, Date or Timestamp */
+	int			unit;			/* Date or Timestamp */
+	Oid			atttypid;		/* compatible PostgreSQL type */
+	int			buffer_index;	/* index of the first buffer */
+	int			nbuffers;		/* number of buffers per record batch */
+	/* statistics per record batch, if any (from custom_metadata) */
+	char	   *min_values;
+	char	   *max_values;
+} ArrowFieldInfo;
+
+/*
+ * ArrowColumnChunk - location of the buffers in a record batch
+ *
+ * buffer[0] is always validity bitmap. Fixed-length types have values at
+ * buffer[1]. Binary and Utf8 have offsets at buffer[1] and data at [2].
+ */
+typedef struct
+{
+	int64		null_count;
+	int64		offset[3];		/* offset from the head of message body */
+	int64		length[3];
+} ArrowColumnChunk;
+
+typedef struct
+{
+	int64		body_offset;	/* offset of the message body in the file */
+	int64		body_length;
+	int64		nitems;
+	ArrowColumnChunk columns[FLEXIBLE_ARRAY_MEMBER];
+} ArrowRecordBatch;
+
+/*
+ * ArrowFileInfo - properties of an Arrow file
+ */
+typedef struct
+{
+	char	   *filename;
+	char	   *mmap_head;
+	size_t		mmap_size;
+	int			nfields;
+	ArrowFieldInfo *fields;
+	int			nbatches;
+	ArrowRecordBatch **batches;
+	int64		total_nitems;
+	MemoryContextCallback callback;	/* to unmap the file on release */
+} ArrowFileInfo;
+
+/*
+ * ArrowStatsHint - a qualifier which can skip record batches
+ */
+typedef struct
+{
+	AttrNumber	attnum;
+	Oid			collid;
+	Datum		value;			/* constant to be compared */
+	FmgrInfo	flinfo_min;		/* (min_value OP const), if valid */
+	FmgrInfo	flinfo_max;		/* (max_value OP const), if valid */
+	Datum	   *min_values;		/* min value per record batch, or NULL */
+	Datum	   *max_values;		/* max value per record batch, or NULL */
+} ArrowStatsHint;
+
+/*
+ * ArrowFdwState - runtime state of Arrow_fdw scan
+ */
+struct ArrowFdwState
+{
+	Relation	relation;
+	ArrowFileInfo *af_info;
+	int		   *attr_field;		/* field index of attributes, or -1 */
+	Bitmapset  *referenced;		/* referenced columns */
+	List	   *stats_hints;	/* list of ArrowStatsHint */
+	MemoryContext memcxt;		/* memory context for the CPU scan */
+	int			curr_batch;		/* next record batch to be read */
+	/* for the CPU scan */
+	kern_data_store *curr_kds;
+	size_t		curr_index;
+	/* statistics */
+	long		skip_count;		/* # of record batches skipped by stats */
+	long		load_count;		/* # of record batches loaded */
+};
+
+/* ---- static variables ---- */
+static bool		arrow_fdw_enabled;			/* GUC */
+static bool		arrow_fdw_stats_hint_enabled;	/* GUC */
+
+Datum pgstrom_arrow_fdw_handler(PG_FUNCTION_ARGS);
+Datum pgstrom_arrow_fdw_validator(PG_FUNCTION_ARGS);
+
+static void ArrowGetForeignRelSize(PlannerInfo *root,
+								   RelOptInfo *baserel,
+								   Oid foreigntableid);
+
+/* ----------------------------------------------------------------
+ *
+ * Minimum flatbuffer reader
+ *
+ * ----------------------------------------------------------------
+ */
+static inline void
+__fbCheckRange(const char *base, const char *end,
+			   const char *pos, size_t sz)
+{
+	if (pos < base || pos > end || sz > (size_t)(end - pos))
+		elog(ERROR, "arrow_fdw: corrupted flatbuffer metadata");
+}
+
+static FBTable
+fetchFBTable(const char *base, const char *end, const char *pos)
+{
+	FBTable		t;
+	int32		soffset;
+
+	__fbCheckRange(base, end, pos, sizeof(int32));
+	memcpy(&soffset, pos, sizeof(int32));
+	t.base = base;
+	t.end = end;
+	t.pos = pos;
+	t.vtable = (const int16 *)(pos - soffset);
+	__fbCheckRange(base, end, (const char *)t.vtable, 2 * sizeof(int16));
+	t.vtable_sz = t.vtable[0];
+	__fbCheckRange(base, end, (const char *)t.vtable, t.vtable_sz);
+
+	return t;
+}
+
+static FBTable
+fetchFBRootTable(const char *base, const char *end)
+{
+	uint32		offset;
+
+	__fbCheckRange(base, end, base, sizeof(uint32));
+	memcpy(&offset, base, sizeof(uint32));
+	return fetchFBTable(base, end, base + offset);
+}
+
+static const char *
+__fetchFBField(const FBTable *t, int index, size_t sz)
+{
+	int			offset;
+
+	if (sizeof(int16) * (index + 3) > t->vtable_sz)
+		return NULL;
+	offset = t->vtable[index + 2];
+	if (offset == 0)
+		return NULL;
+	__fbCheckRange(t->base, t->end, t->pos + offset, sz);
+	return t->pos + offset;
+}
+
+static int64
+fetchFBLong(const FBTable *t, int index, int64 defval)
+{
+	const char *addr = __fetchFBField(t, index, sizeof(int64));
+	int64		value;
+
+	if (!addr)
+		return defval;
+	memcpy(&value, addr, sizeof(int64));
+	return value;
+}
+
+static int32
+fetchFBInt(const FBTable *t, int index, int32 defval)
+{
+	const char *addr = __fetchFBField(t, index, sizeof(int32));
+	int32		value;
+
+	if (!addr)
+		return defval;
+	memcpy(&value, addr, sizeof(int32));
+	return value;
+}
+
+static int16
+fetchFBShort(const FBTable *t, int index, int16 defval)
+{
+	const char *addr = __fetchFBField(t, index, sizeof(int16));
+	int16		value;
+
+	if (!addr)
+		return defval;
+	memcpy(&value, addr, sizeof(int16));
+	return value;
+}
+
+static uint8
+fetchFBByte(const FBTable *t, int index, uint8 defval)
+{
+	const char *addr = __fetchFBField(t, index, sizeof(uint8));
+
+	if (!addr)
+		return defval;
+	return *((const uint8 *)addr);
+}
+
+static const char *
+__fetchFBOffset(const FBTable *t, int index)
+{
+	const char *addr = __fetchFBField(t, index, sizeof(uint32));
+	uint32		offset;
+
+	if (!addr)
+		return NULL;
+	memcpy(&offset, addr, sizeof(uint32));
+	__fbCheckRange(t->base, t->end, addr + offset, sizeof(uint32));
+	return addr + offset;
+}
+
+static bool
+fetchFBSubTable(const FBTable *t, int index, FBTable *result)
+{
+	const char *pos = __fetchFBOffset(t, index);
+
+	if (!pos)
+		return false;
+	*result = fetchFBTable(t->base, t->end, pos);
+	return true;
+}
+
+static char *
+fetchFBString(const FBTable *t, int index)
+{
+	const char *pos = __fetchFBOffset(t, index);
+	uint32		len;
+
+	if (!pos)
+		return NULL;
+	memcpy(&len, pos, sizeof(uint32));
+	__fbCheckRange(t->base, t->end, pos + sizeof(uint32), len);
+	return pnstrdup(pos + sizeof(uint32), len);
+}
+
+static const char *
+fetchFBVector(const FBTable *t, int index, size_t unitsz, int *p_nitems)
+{
+	const char *pos = __fetchFBOffset(t, index);
+	uint32		nitems;
+
+	if (!pos)
+	{
+		*p_nitems = 0;
+		return NULL;
+	}
+	memcpy(&nitems, pos, sizeof(uint32));
+	if (nitems > INT_MAX / Max(unitsz, 1))
+		elog(ERROR, "arrow_fdw: corrupted flatbuffer metadata");
+	__fbCheckRange(t->base, t->end, pos + sizeof(uint32), unitsz * nitems);
+	*p_nitems = nitems;
+	return pos + sizeof(uint32);
+}
+
+static FBTable
+fetchFBVectorTable(const FBTable *t, const char *vector, int index)
+{
+	const char *addr = vector + sizeof(uint32) * index;
+	uint32		offset;
+
+	memcpy(&offset, addr, sizeof(uint32));
+	return fetchFBTable(t->base, t->end, addr + offset);
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Routines to parse Arrow files
+ *
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * arrowSetupFieldInfo - parse Arrow::Field
+ */
+static void
+arrowSetupFieldInfo(ArrowFileInfo *af_info, FBTable *field,
+					ArrowFieldInfo *finfo)
+{
+	FBTable		type;
+	const char *vector;
+	int			i, nitems;
+
+	finfo->field_name = fetchFBString(field, 0);
+	if (!finfo->field_name)
+		finfo->field_name = "";
+	finfo->type_tag = fetchFBByte(field, 2, 0);
+	if (!fetchFBSubTable(field, 3, &type))
+		elog(ERROR, "arrow_fdw: field \"%s\" of \"%s\" has no type",
+			 finfo->field_name, af_info->filename);
+	if (__fetchFBOffset(field, 4) != NULL)
+		elog(ERROR, "arrow_fdw: dictionary encoded field \"%s\" of \"%s\" is not supported",
+			 finfo->field_name, af_info->filename);
+	(void) fetchFBVector(field, 5, sizeof(uint32), &nitems);
+	if (nitems > 0)
+		elog(ERROR, "arrow_fdw: nested field \"%s\" of \"%s\" is not supported",
+			 finfo->field_name, af_info->filename);
+
+	finfo->nbuffers = 2;
+	switch (finfo->type_tag)
+	{
+		case ArrowType__Int:
+			finfo->bit_width = fetchFBInt(&type, 0, 0);
+			if (!fetchFBByte(&type, 1, 0))
+				finfo->atttypid = InvalidOid;	/* unsigned integer */
+			else if (finfo->bit_width == 16)
+				finfo->atttypid = INT2OID;
+			else if (finfo->bit_width == 32)
+				finfo->atttypid = INT4OID;
+			else if (finfo->bit_width == 64)
+				finfo->atttypid = INT8OID;
+			break;
+
+		case ArrowType__FloatingPoint:
+			switch (fetchFBShort(&type, 0, 0))
+			{
+				case ArrowPrecision__Single:
+					finfo->bit_width = 32;
+					finfo->atttypid = FLOAT4OID;
+					break;
+				case ArrowPrecision__Double:
+					finfo->bit_width = 64;
+					finfo->atttypid = FLOAT8OID;
+					break;
+			}
+			break;
+
+		case ArrowType__Bool:
+			finfo->bit_width = 1;
+			finfo->atttypid = BOOLOID;
+			break;
+
+		case ArrowType__Utf8:
+			finfo->atttypid = TEXTOID;
+			finfo->nbuffers = 3;
+			break;
+
+		case ArrowType__Binary:
+			finfo->atttypid = BYTEAOID;
+			finfo->nbuffers = 3;
+			break;
+
+		case ArrowType__Date:
+			finfo->unit = fetchFBShort(&type, 0, ArrowDateUnit__MilliSecond);
+			if (finfo->unit == ArrowDateUnit__Day)
+				finfo->bit_width = 32;
+			else
+				finfo->bit_width = 64;
+			finfo->atttypid = DATEOID;
+			break;
+
+		case ArrowType__Timestamp:
+			finfo->unit = fetchFBShort(&type, 0, ArrowTimeUnit__Second);
+			finfo->bit_width = 64;
+			if (__fetchFBOffset(&type, 1) != NULL)
+				finfo->atttypid = TIMESTAMPTZOID;
+			else
+				finfo->atttypid = TIMESTAMPOID;
+			break;
+
+		default:
+			break;
+	}
+	if (!OidIsValid(finfo->atttypid))
+		elog(ERROR, "arrow_fdw: field \"%s\" of \"%s\" has unsupported type",
+			 finfo->field_name, af_info->filename);
+
+	/* min/max statistics, if any */
+	vector = fetchFBVector(field, 6, sizeof(uint32), &nitems);
+	for (i=0; i < nitems; i++)
+	{
+		FBTable		kv = fetchFBVectorTable(field, vector, i);
+		char	   *key = fetchFBString(&kv, 0);
+
+		if (!key)
+			continue;
+		if (strcmp(key, "min_values") == 0)
+			finfo->min_values = fetchFBString(&kv, 1);
+		else if (strcmp(key, "max_values") == 0)
+			finfo->max_values = fetchFBString(&kv, 1);
+	}
+}
+
+/*
+ * arrowSetupRecordBatch - parse Arrow::Block and the Arrow::Message
+ */
+static ArrowRecordBatch *
+arrowSetupRecordBatch(ArrowFileInfo *af_info, const char *block)
+{
+	const char *tail = af_info->mmap_head + af_info->mmap_size;
+	const char *pos;
+	const char *nodes;
+	const char *buffers;
+	int64		offset;
+	int32		meta_length;
+	int64		body_length;
+	int32		temp;
+	int			j, k, nnodes, nbuffers;
+	FBTable		message;
+	FBTable		rbatch;
+	ArrowRecordBatch *rb;
+
+	memcpy(&offset, block, sizeof(int64));
+	memcpy(&meta_length, block + 8, sizeof(int32));
+	memcpy(&body_length, block + 16, sizeof(int64));
+	if (offset < 0 || meta_length <= 0 || body_length < 0 ||
+		offset + meta_length > af_info->mmap_size ||
+		offset + meta_length + body_length > af_info->mmap_size)
+		elog(ERROR, "arrow_fdw: corrupted record batch in \"%s\"",
+			 af_info->filename);
+
+	/* Arrow::Message, with or without continuation token */
+	pos = af_info->mmap_head + offset;
+	memcpy(&temp, pos, sizeof(int32));
+	if (temp == -1)
+		pos += 2 * sizeof(int32);
+	else
+		pos += sizeof(int32);
+	message = fetchFBRootTable(pos, Min(tail, af_info->mmap_head +
+										offset + meta_length));
+	if (fetchFBByte(&message, 1, 0) != ArrowMessageHeader__RecordBatch ||
+		!fetchFBSubTable(&message, 2, &rbatch))
+		elog(ERROR, "arrow_fdw: block in \"%s\" is not a record batch",
+			 af_info->filename);
+	if (__fetchFBOffset(&rbatch, 3) != NULL)
+		elog(ERROR, "arrow_fdw: compressed record batch in \"%s\" is not supported",
+			 af_info->filename);
+
+	rb = palloc0(offsetof(ArrowRecordBatch, columns[af_info->nfields]));
+	rb->body_offset = offset + meta_length;
+	rb->body_length = body_length;
+	rb->nitems = fetchFBLong(&rbatch, 0, 0);
+	if (rb->nitems < 0 || rb->nitems > UINT_MAX)
+		elog(ERROR, "arrow_fdw: record batch in \"%s\" has too many rows",
+			 af_info->filename);
+
+	nodes = fetchFBVector(&rbatch, 1, ARROW_FIELD_NODE_SZ, &nnodes);
+	buffers = fetchFBVector(&rbatch, 2, ARROW_BUFFER_SZ, &nbuffers);
+	if (nnodes != af_info->nfields ||
+		(af_info->nfields > 0 &&
+		 nbuffers != (af_info->fields[af_info->nfields - 1].buffer_index +
+					  af_info->fields[af_info->nfields - 1].nbuffers)))
+		elog(ERROR, "arrow_fdw: record batch in \"%s\" is not consistent with the schema",
+			 af_info->filename);
+
+	for (j=0; j < af_info->nfields; j++)
+	{
+		ArrowFieldInfo *finfo = &af_info->fields[j];
+		ArrowColumnChunk *chunk = &rb->columns[j];
+		int64		length;
+
+		memcpy(&length, nodes + ARROW_FIELD_NODE_SZ * j, sizeof(int64));
+		memcpy(&chunk->null_count, nodes + ARROW_FIELD_NODE_SZ * j + 8,
+			   sizeof(int64));
+		if (length != rb->nitems)
+			elog(ERROR, "arrow_fdw: record batch in \"%s\" has inconsistent length",
+				 af_info->filename);
+
+		for (k=0; k < finfo->nbuffers; k++)
+		{
+			const char *buf = buffers + ARROW_BUFFER_SZ *
+				(finfo->buffer_index + k);
+
+			memcpy(&chunk->offset[k], buf, sizeof(int64));
+			memcpy(&chunk->length[k], buf + 8, sizeof(int64));
+			if (chunk->offset[k] < 0 || chunk->length[k] < 0 ||
+				chunk->offset[k] + chunk->length[k] > body_length)
+				elog(ERROR, "arrow_fdw: buffer of \"%s\" in \"%s\" is out of range",
+					 finfo->field_name, af_info->filename);
+		}
+		/* sanity checks for the buffer length */
+		if (chunk->null_count > 0 &&
+			chunk->length[0] < BITMAPLEN(rb->nitems))
+			elog(ERROR, "arrow_fdw: validity bitmap of \"%s\" in \"%s\" is too short",
+				 finfo->field_name, af_info->filename);
+		if (finfo->nbuffers == 3
+			? chunk->length[1] < sizeof(int32) * (rb->nitems + 1)
+			: chunk->length[1] < (finfo->bit_width * rb->nitems + 7) / 8)
+			elog(ERROR, "arrow_fdw: values of \"%s\" in \"%s\" are too short",
+				 finfo->field_name, af_info->filename);
+	}
+	return rb;
+}
+
+/*
+ * arrowCloseFile
+ */
+static void
+arrowCloseFile(void *arg)
+{
+	ArrowFileInfo *af_info = arg;
+
+	if (af_info->mmap_head)
+	{
+		if (munmap(af_info->mmap_head, af_info->mmap_size) != 0)
+			elog(WARNING, "failed on munmap('%s'): %m", af_info->filename);
+		af_info->mmap_head = NULL;
+	}
+}
+
+/*
+ * arrowOpenFile - maps an Arrow file and parses its footer
+ *
+ * The file is unmapped when the current memory context is released, so
+ * we don't need to care about the error path.
+ */
+static ArrowFileInfo *
+arrowOpenFile(const char *filename)
+{
+	ArrowFileInfo *af_info = palloc0(sizeof(ArrowFileInfo));
+	struct stat	st_buf;
+	int			fdesc;
+	const char *head;
+	const char *tail;
+	const char *vector;
+	int32		footer_len;
+	int32		buffer_index = 0;
+	int			i, nitems;
+	FBTable		footer;
+	FBTable		schema;
+
+	af_info->filename = pstrdup(filename);
+	fdesc = open(filename, O_RDONLY);
+	if (fdesc < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", filename)));
+	if (fstat(fdesc, &st_buf) != 0)
+	{
+		close(fdesc);
+		elog(ERROR, "failed on fstat('%s'): %m", filename);
+	}
+	if (st_buf.st_size < 2 * MAXALIGN(ARROW_SIGNATURE_SZ) + sizeof(int32))
+	{
+		close(fdesc);
+		ereport(ERROR,
+				(errcode(ERRCODE_FDW_ERROR),
+				 errmsg("arrow_fdw: \"%s\" is too small for Arrow file",
+						filename)));
+	}
+	af_info->mmap_head = mmap(NULL, st_buf.st_size,
+							  PROT_READ, MAP_SHARED,
+							  fdesc, 0);
+	if (af_info->mmap_head == MAP_FAILED)
+	{
+		af_info->mmap_head = NULL;
+		close(fdesc);
+		elog(ERROR, "failed on mmap('%s'): %m", filename);
+	}
+	af_info->mmap_size = st_buf.st_size;
+	close(fdesc);
+
+	af_info->callback.func = arrowCloseFile;
+	af_info->callback.arg = af_info;
+	MemoryContextRegisterResetCallback(CurrentMemoryContext,
+									   &af_info->callback);
+
+	/* check signatures */
+	head = af_info->mmap_head;
+	tail = af_info->mmap_head + af_info->mmap_size;
+	if (memcmp(head, ARROW_SIGNATURE, ARROW_SIGNATURE_SZ) != 0 ||
+		memcmp(tail - ARROW_SIGNATURE_SZ,
+			   ARROW_SIGNATURE, ARROW_SIGNATURE_SZ) != 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FDW_ERROR),
+				 errmsg("arrow_fdw: \"%s\" is not an Arrow file", filename)));
+
+	/* Arrow::Footer */
+	memcpy(&footer_len, tail - ARROW_SIGNATURE_SZ - sizeof(int32),
+		   sizeof(int32));
+	if (footer_len <= 0 ||
+		footer_len > (tail - head) - (ARROW_SIGNATURE_SZ + sizeof(int32) +
+									  MAXALIGN(ARROW_SIGNATURE_SZ)))
+		elog(ERROR, "arrow_fdw: corrupted footer in \"%s\"", filename);
+	footer = fetchFBRootTable(tail - ARROW_SIGNATURE_SZ -
+							  sizeof(int32) - footer_len,
+							  tail - ARROW_SIGNATURE_SZ - sizeof(int32));
+	if (!fetchFBSubTable(&footer, 1, &schema))
+		elog(ERROR, "arrow_fdw: \"%s\" has no schema", filename);
+	if (fetchFBShort(&schema, 0, ArrowEndianness__Little)
+		!= ArrowEndianness__Little)
+		elog(ERROR, "arrow_fdw: big-endian Arrow file \"%s\" is not supported",
+			 filename);
+
+	/* Arrow::Schema */
+	vector = fetchFBVector(&schema, 1, sizeof(uint32), &nitems);
+	af_info->nfields = nitems;
+	af_info->fields = palloc0(sizeof(ArrowFieldInfo) * Max(nitems, 1));
+	for (i=0; i < nitems; i++)
+	{
+		FBTable		field = fetchFBVectorTable(&schema, vector, i);
+		ArrowFieldInfo *finfo = &af_info->fields[i];
+
+		arrowSetupFieldInfo(af_info, &field, finfo);
+		finfo->buffer_index = buffer_index;
+		buffer_index += finfo->nbuffers;
+	}
+
+	/* Arrow::Block of record batches */
+	vector = fetchFBVector(&footer, 3, ARROW_BLOCK_SZ, &nitems);
+	af_info->nbatches = nitems;
+	af_info->batches = palloc0(sizeof(ArrowRecordBatch *) * Max(nitems, 1));
+	for (i=0; i < nitems; i++)
+	{
+		ArrowRecordBatch *rb
+			= arrowSetupRecordBatch(af_info, vector + ARROW_BLOCK_SZ * i);
+		af_info->batches[i] = rb;
+		af_info->total_nitems += rb->nitems;
+	}
+	return af_info;
+}
+
+/*
+ * arrowCheckSchema - checks compatibility of the foreign table definition
+ * and the Arrow file, then returns field index of the attributes.
+ */
+static int *
+arrowCheckSchema(ArrowFileInfo *af_info, Relation relation)
+{
+	TupleDesc	tupdesc = RelationGetDescr(relation);
+	int		   *attr_field = palloc(sizeof(int) * tupdesc->natts);
+	int			j, k = 0;
+
+	for (j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = tupleDescAttr(tupdesc, j);
+		ArrowFieldInfo *finfo;
+
+		if (attr->attisdropped)
+		{
+			attr_field[j] = -1;
+			continue;
+		}
+		if (k >= af_info->nfields)
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_COLUMN_NUMBER),
+					 errmsg("foreign table \"%s\" has more columns than \"%s\"",
+							RelationGetRelationName(relation),
+							af_info->filename)));
+		finfo = &af_info->fields[k];
+		if (attr->atttypid != finfo->atttypid &&
+			!(finfo->atttypid == TEXTOID && attr->atttypid == VARCHAROID))
+			ereport(ERROR,
+					(errcode(ERRCODE_FDW_INVALID_DATA_TYPE),
+					 errmsg("column \"%s\" of foreign table \"%s\" is not compatible to field \"%s\" of \"%s\"",
+							NameStr(attr->attname),
+							RelationGetRelationName(relation),
+							finfo->field_name,
+							af_info->filename)));
+		attr_field[j] = k++;
+	}
+	if (k != af_info->nfields)
+		ereport(ERROR,
+				(errcode(ERRCODE_FDW_INVALID_COLUMN_NUMBER),
+				 errmsg("foreign table \"%s\" has less columns than \"%s\"",
+						RelationGetRelationName(relation),
+						af_info->filename)));
+	return attr_field;
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Statistics hint to skip record batches
+ *
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * arrowStatsValues - parse comma separated min/max values
+ */
+static Datum *
+arrowStatsValues(ArrowFileInfo *af_info, ArrowFieldInfo *finfo,
+				 const char *str)
+{
+	Datum	   *values;
+	char	   *copy;
+	char	   *tok;
+	char	   *pos;
+	char	   *end;
+	int			i = 0;
+
+	if (!str)
+		return NULL;
+	values = palloc(sizeof(Datum) * Max(af_info->nbatches, 1));
+	copy = pstrdup(str);
+	for (tok = strtok_r(copy, ",", &pos);
+		 tok != NULL;
+		 tok = strtok_r(NULL, ",", &pos))
+	{
+		int64		ival = 0;
+		double		fval = 0.0;
+
+		if (i >= af_info->nbatches)
+			goto bailout;
+		errno = 0;
+		if (finfo->type_tag == ArrowType__FloatingPoint)
+			fval = strtod(tok, &end);
+		else
+			ival = strtoll(tok, &end, 10);
+		while (isspace(*end))
+			end++;
+		if (errno != 0 || end == tok || *end != '\0')
+			goto bailout;
+
+		switch (finfo->type_tag)
+		{
+			case ArrowType__Int:
+				if (finfo->bit_width == 16)
+					values[i] = Int16GetDatum(ival);
+				else if (finfo->bit_width == 32)
+					values[i] = Int32GetDatum(ival);
+				else
+					values[i] = Int64GetDatum(ival);
+				break;
+			case ArrowType__FloatingPoint:
+				if (finfo->bit_width == 32)
+					values[i] = Float4GetDatum(fval);
+				else
+					values[i] = Float8GetDatum(fval);
+				break;
+			case ArrowType__Date:
+				if (finfo->unit == ArrowDateUnit__MilliSecond)
+					ival = ival / (SECS_PER_DAY * 1000L) - (ival < 0 &&
+						   ival % (SECS_PER_DAY * 1000L) != 0 ? 1 : 0);
+				values[i] = DateADTGetDatum(ival - (POSTGRES_EPOCH_JDATE -
+													UNIX_EPOCH_JDATE));
+				break;
+			case ArrowType__Timestamp:
+				if (finfo->unit == ArrowTimeUnit__Second)
+					ival *= 1000000L;
+				else if (finfo->unit == ArrowTimeUnit__MilliSecond)
+					ival *= 1000L;
+				else if (finfo->unit == ArrowTimeUnit__NanoSecond)
+					ival /= 1000L;
+				values[i] = TimestampGetDatum(ival - (POSTGRES_EPOCH_JDATE -
+													  UNIX_EPOCH_JDATE) *
+											  USECS_PER_DAY);
+				break;
+			default:
+				goto bailout;
+		}
+		i++;
+	}
+	if (i == af_info->nbatches)
+		return values;
+bailout:
+	elog(DEBUG2, "arrow_fdw: statistics of \"%s\" in \"%s\" are ignored",
+		 finfo->field_name, af_info->filename);
+	pfree(values);
+	return NULL;
+}
+
+/*
+ * arrowAddStatsHint - checks whether the qualifier is (Var OP Const) form
+ * on the field with min/max statistics, and adds a hint if possible.
+ */
+static void
+arrowAddStatsHint(ArrowFdwState *af_state, Expr *expr)
+{
+	ArrowFileInfo *af_info = af_state->af_info;
+	OpExpr	   *op = (OpExpr *) expr;
+	Oid			opno;
+	Var		   *var;
+	Const	   *con;
+	ArrowFieldInfo *finfo;
+	TypeCacheEntry *tcache;
+	ArrowStatsHint *hint;
+	int			fidx;
+	int			strategy;
+
+	if (!IsA(op, OpExpr) || list_length(op->args) != 2)
+		return;
+	if (IsA(linitial(op->args), Var) && IsA(lsecond(op->args), Const))
+	{
+		var = linitial(op->args);
+		con = lsecond(op->args);
+		opno = op->opno;
+	}
+	else if (IsA(linitial(op->args), Const) && IsA(lsecond(op->args), Var))
+	{
+		var = lsecond(op->args);
+		con = linitial(op->args);
+		opno = get_commutator(op->opno);
+		if (!OidIsValid(opno))
+			return;
+	}
+	else
+		return;
+
+	if (con->constisnull ||
+		var->varattno <= 0 ||
+		var->varattno > RelationGetNumberOfAttributes(af_state->relation))
+		return;
+	fidx = af_state->attr_field[var->varattno - 1];
+	if (fidx < 0)
+		return;
+	finfo = &af_info->fields[fidx];
+	if (!finfo->min_values && !finfo->max_values)
+		return;
+
+	tcache = lookup_type_cache(var->vartype, TYPECACHE_BTREE_OPFAMILY);
+	if (!OidIsValid(tcache->btree_opf))
+		return;
+	strategy = get_op_opfamily_strategy(opno, tcache->btree_opf);
+
+	hint = palloc0(sizeof(ArrowStatsHint));
+	hint->attnum = var->varattno;
+	hint->collid = op->inputcollid;
+	hint->value = con->constvalue;
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+		case BTLessEqualStrategyNumber:
+			/* skip, if NOT (min_value OP const) */
+			hint->min_values = arrowStatsValues(af_info, finfo,
+												finfo->min_values);
+			if (!hint->min_values)
+				return;
+			fmgr_info(get_opcode(opno), &hint->flinfo_min);
+			break;
+
+		case BTGreaterStrategyNumber:
+		case BTGreaterEqualStrategyNumber:
+			/* skip, if NOT (max_value OP const) */
+			hint->max_values = arrowStatsValues(af_info, finfo,
+												finfo->max_values);
+			if (!hint->max_values)
+				return;
+			fmgr_info(get_opcode(opno), &hint->flinfo_max);
+			break;
+
+		case BTEqualStrategyNumber:
+			/* skip, if NOT (min_value <= const AND max_value >= const) */
+			{
+				Oid		le_opno = get_opfamily_member(tcache->btree_opf,
+													  var->vartype,
+													  con->consttype,
+													  BTLessEqualStrategyNumber);
+				Oid		ge_opno = get_opfamily_member(tcache->btree_opf,
+													  var->vartype,
+													  con->consttype,
+													  BTGreaterEqualStrategyNumber);
+				if (!OidIsValid(le_opno) || !OidIsValid(ge_opno))
+					return;
+				hint->min_values = arrowStatsValues(af_info, finfo,
+													finfo->min_values);
+				hint->max_values = arrowStatsValues(af_info, finfo,
+													finfo->max_values);
+				if (!hint->min_values || !hint->max_values)
+					return;
+				fmgr_info(get_opcode(le_opno), &hint->flinfo_min);
+				fmgr_info(get_opcode(ge_opno), &hint->flinfo_max);
+			}
+			break;
+
+		default:
+			return;
+	}
+	af_state->stats_hints = lappend(af_state->stats_hints, hint);
+}
+
+static void
+arrowSetupStatsHint(ArrowFdwState *af_state, List *quals)
+{
+	ListCell   *lc;
+
+	foreach (lc, quals)
+	{
+		Expr   *expr = lfirst(lc);
+
+		if (IsA(expr, RestrictInfo))
+			expr = ((RestrictInfo *) expr)->clause;
+		if (and_clause((Node *) expr))
+			arrowSetupStatsHint(af_state, ((BoolExpr *) expr)->args);
+		else
+			arrowAddStatsHint(af_state, expr);
+	}
+}
+
+/*
+ * arrowStatsHintCanSkip - true, if the record batch never contains rows
+ * which satisfy the scan qualifiers
+ */
+static bool
+arrowStatsHintCanSkip(ArrowFdwState *af_state, int rb_index)
+{
+	ListCell   *lc;
+
+	if (!arrow_fdw_stats_hint_enabled)
+		return false;
+
+	foreach (lc, af_state->stats_hints)
+	{
+		ArrowStatsHint *hint = lfirst(lc);
+
+		if (hint->min_values &&
+			!DatumGetBool(FunctionCall2Coll(&hint->flinfo_min,
+											hint->collid,
+											hint->min_values[rb_index],
+											hint->value)))
+			return true;
+		if (hint->max_values &&
+			!DatumGetBool(FunctionCall2Coll(&hint->flinfo_max,
+											hint->collid,
+											hint->max_values[rb_index],
+											hint->value)))
+			return true;
+	}
+	return false;
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Routines to load record batches onto KDS_FORMAT_COLUMN
+ *
+ * ----------------------------------------------------------------
+ */
+static inline bool
+arrowIsNull(const char *nullmap, size_t index)
+{
+	return (nullmap && (nullmap[index >> 3] & (1 << (index & 7))) == 0);
+}
+
+static inline const char *
+arrowNullMap(ArrowColumnChunk *chunk, const char *body)
+{
+	return (chunk->null_count > 0 ? body + chunk->offset[0] : NULL);
+}
+
+/*
+ * arrowColumnLength - length of the column on KDS_FORMAT_COLUMN
+ */
+static size_t
+arrowColumnLength(ArrowFdwState *af_state, ArrowRecordBatch *rb,
+				  int fidx, Form_pg_attribute attr)
+{
+	ArrowFileInfo  *af_info = af_state->af_info;
+	ArrowColumnChunk *chunk = &rb->columns[fidx];
+	const char	   *body = af_info->mmap_head + rb->body_offset;
+	size_t			nitems = rb->nitems;
+	size_t			length;
+
+	if (attr->attlen > 0)
+	{
+		int		unitsz = att_align_nominal(attr->attlen, attr->attalign);
+
+		length = MAXALIGN(unitsz * nitems);
+		if (chunk->null_count > 0)
+			length += MAXALIGN(BITMAPLEN(nitems));
+	}
+	else
+	{
+		const char *nullmap = arrowNullMap(chunk, body);
+		const char *offsets = body + chunk->offset[1];
+		int32		head, tail;
+		size_t		i;
+
+		length = MAXALIGN(sizeof(cl_uint) * nitems);
+		for (i=0; i < nitems; i++)
+		{
+			if (arrowIsNull(nullmap, i))
+				continue;
+			memcpy(&head, offsets + sizeof(int32) * i, sizeof(int32));
+			memcpy(&tail, offsets + sizeof(int32) * (i+1), sizeof(int32));
+			if (head < 0 || head > tail || tail > chunk->length[2])
+				elog(ERROR, "arrow_fdw: corrupted offsets of \"%s\" in \"%s\"",
+					 af_info->fields[fidx].field_name, af_info->filename);
+			length += MAXALIGN(VARHDRSZ + tail - head);
+		}
+	}
+	if (length >= KDS_OFFSET_MAX_SIZE)
+		elog(ERROR, "arrow_fdw: too large record batch in \"%s\"",
+			 af_info->filename);
+	return length;
+}
+
+/*
+ * arrowSetupColumn - writes out a column of the record batch on the KDS
+ */
+static size_t
+arrowSetupColumn(ArrowFdwState *af_state, ArrowRecordBatch *rb,
+				 int fidx, kern_data_store *kds, int j, size_t offset)
+{
+	ArrowFileInfo  *af_info = af_state->af_info;
+	ArrowFieldInfo *finfo = &af_info->fields[fidx];
+	ArrowColumnChunk *chunk = &rb->columns[fidx];
+	kern_colmeta   *cmeta = &kds->colmeta[j];
+	const char	   *body = af_info->mmap_head + rb->body_offset;
+	const char	   *nullmap = arrowNullMap(chunk, body);
+	const char	   *values = body + chunk->offset[1];
+	char		   *base = (char *)kds + offset;
+	size_t			nitems = rb->nitems;
+	size_t			length;
+	size_t			i;
+
+	Assert(offset == MAXALIGN(offset));
+	if (cmeta->attlen > 0)
+	{
+		int		unitsz = TYPEALIGN(cmeta->attalign, cmeta->attlen);
+
+		length = MAXALIGN(unitsz * nitems);
+		switch (finfo->type_tag)
+		{
+			case ArrowType__Int:
+			case ArrowType__FloatingPoint:
+				Assert(finfo->bit_width == 8 * unitsz);
+				memcpy(base, values, unitsz * nitems);
+				break;
+
+			case ArrowType__Bool:
+				for (i=0; i < nitems; i++)
+					((cl_bool *)base)[i] = !arrowIsNull(values, i);
+				break;
+
+			case ArrowType__Date:
+				for (i=0; i < nitems; i++)
+				{
+					int64	ival;
+
+					if (finfo->unit == ArrowDateUnit__Day)
+					{
+						int32	temp;
+
+						memcpy(&temp, values + sizeof(int32) * i,
+							   sizeof(int32));
+						ival = temp;
+					}
+					else
+					{
+						memcpy(&ival, values + sizeof(int64) * i,
+							   sizeof(int64));
+						ival = (ival / (SECS_PER_DAY * 1000L) -
+								(ival < 0 &&
+								 ival % (SECS_PER_DAY * 1000L) != 0 ? 1 : 0));
+					}
+					((DateADT *)base)[i] = ival - (POSTGRES_EPOCH_JDATE -
+												   UNIX_EPOCH_JDATE);
+				}
+				break;
+
+			case ArrowType__Timestamp:
+				for (i=0; i < nitems; i++)
+				{
+					int64	ival;
+
+					memcpy(&ival, values + sizeof(int64) * i, sizeof(int64));
+					if (finfo->unit == ArrowTimeUnit__Second)
+						ival *= 1000000L;
+					else if (finfo->unit == ArrowTimeUnit__MilliSecond)
+						ival *= 1000L;
+					else if (finfo->unit == ArrowTimeUnit__NanoSecond)
+						ival /= 1000L;
+					((Timestamp *)base)[i] = ival - (POSTGRES_EPOCH_JDATE -
+													 UNIX_EPOCH_JDATE) *
+						USECS_PER_DAY;
+				}
+				break;
+
+			default:
+				elog(ERROR, "Bug? unexpected Arrow type: %d",
+					 finfo->type_tag);
+		}
+		if (length > unitsz * nitems)
+			memset(base + unitsz * nitems, 0, length - unitsz * nitems);
+
+		/* nullmap uses the same convention with Arrow's validity bitmap */
+		if (nullmap)
+		{
+			memcpy(base + length, nullmap, BITMAPLEN(nitems));
+			if (MAXALIGN(BITMAPLEN(nitems)) > BITMAPLEN(nitems))
+				memset(base + length + BITMAPLEN(nitems), 0,
+					   MAXALIGN(BITMAPLEN(nitems)) - BITMAPLEN(nitems));
+			length += MAXALIGN(BITMAPLEN(nitems));
+		}
+	}
+	else
+	{
+		const char *data = body + chunk->offset[2];
+		cl_uint	   *vl_offsets = (cl_uint *)base;
+		int32		head, tail;
+
+		length = MAXALIGN(sizeof(cl_uint) * nitems);
+		memset(base, 0, length);
+		for (i=0; i < nitems; i++)
+		{
+			char   *vl;
+
+			if (arrowIsNull(nullmap, i))
+				continue;
+			memcpy(&head, values + sizeof(int32) * i, sizeof(int32));
+			memcpy(&tail, values + sizeof(int32) * (i+1), sizeof(int32));
+			Assert(head >= 0 && head <= tail && tail <= chunk->length[2]);
+			vl = base + length;
+			SET_VARSIZE(vl, VARHDRSZ + tail - head);
+			memcpy(VARDATA(vl), data + head, tail - head);
+			vl_offsets[i] = __kds_packed(length);
+			length += MAXALIGN(VARHDRSZ + tail - head);
+		}
+	}
+	cmeta->va_offset = __kds_packed(offset);
+	cmeta->va_length = __kds_packed(length);
+
+	return length;
+}
+
+/*
+ * arrowRecordBatchLength - length of the KDS to load the record batch
+ */
+static size_t
+arrowRecordBatchLength(ArrowFdwState *af_state, ArrowRecordBatch *rb)
+{
+	TupleDesc	tupdesc = RelationGetDescr(af_state->relation);
+	size_t		length = KDS_CALCULATE_HEAD_LENGTH(tupdesc->natts, false);
+	int			i, j;
+
+	for (i = bms_next_member(af_state->referenced, -1);
+		 i >= 0;
+		 i = bms_next_member(af_state->referenced, i))
+	{
+		j = i + FirstLowInvalidHeapAttributeNumber - 1;
+		if (j < 0 || af_state->attr_field[j] < 0)
+			continue;
+		length += arrowColumnLength(af_state, rb, af_state->attr_field[j],
+									tupleDescAttr(tupdesc, j));
+	}
+	return length;
+}
+
+/*
+ * arrowLoadRecordBatch - loads the referenced columns of the record batch
+ * onto the KDS_FORMAT_COLUMN. Unreferenced columns are read as NULL.
+ */
+static void
+arrowLoadRecordBatch(ArrowFdwState *af_state, ArrowRecordBatch *rb,
+					 kern_data_store *kds, size_t length)
+{
+	TupleDesc	tupdesc = RelationGetDescr(af_state->relation);
+	size_t		offset;
+	int			i, j;
+
+	init_kernel_data_store(kds, tupdesc, length,
+						   KDS_FORMAT_COLUMN, rb->nitems, false);
+	kds->table_oid = RelationGetRelid(af_state->relation);
+
+	offset = KERN_DATA_STORE_HEAD_LENGTH(kds);
+	for (i = bms_next_member(af_state->referenced, -1);
+		 i >= 0;
+		 i = bms_next_member(af_state->referenced, i))
+	{
+		j = i + FirstLowInvalidHeapAttributeNumber - 1;
+		if (j < 0 || af_state->attr_field[j] < 0)
+			continue;
+		offset += arrowSetupColumn(af_state, rb, af_state->attr_field[j],
+								   kds, j, offset);
+	}
+	Assert(offset == length);
+	kds->nitems = rb->nitems;
+	kds->usage = __kds_packed(offset);
+}
+
+/*
+ * arrowNextRecordBatch - returns the next record batch to be loaded,
+ * or NULL if no more record batches.
+ */
+static ArrowRecordBatch *
+arrowNextRecordBatch(ArrowFdwState *af_state)
+{
+	ArrowFileInfo *af_info = af_state->af_info;
+
+	while (af_state->curr_batch < af_info->nbatches)
+	{
+		int		rb_index = af_state->curr_batch++;
+		ArrowRecordBatch *rb = af_info->batches[rb_index];
+
+		if (rb->nitems == 0)
+			continue;
+		if (arrowStatsHintCanSkip(af_state, rb_index))
+		{
+			af_state->skip_count++;
+			continue;
+		}
+		af_state->load_count++;
+		return rb;
+	}
+	return NULL;
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Interfaces for GpuScan, GpuJoin and GpuPreAgg
+ *
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * baseRelIsArrowFdw
+ */
+bool
+baseRelIsArrowFdw(RelOptInfo *baserel)
+{
+	if (!arrow_fdw_enabled)
+		return false;
+	if ((baserel->reloptkind == RELOPT_BASEREL ||
+		 baserel->reloptkind == RELOPT_OTHER_MEMBER_REL) &&
+		baserel->rtekind == RTE_RELATION &&
+		OidIsValid(baserel->serverid) &&
+		baserel->fdwroutine &&
+		baserel->fdwroutine->GetForeignRelSize == ArrowGetForeignRelSize)
+		return true;
+	return false;
+}
+
+/*
+ * RelationIsArrowFdw
+ */
+bool
+RelationIsArrowFdw(Relation frel)
+{
+	FdwRoutine *routine;
+
+	if (RelationGetForm(frel)->relkind != RELKIND_FOREIGN_TABLE)
+		return false;
+	routine = GetFdwRoutineForRelation(frel, false);
+	return (routine->GetForeignRelSize == ArrowGetForeignRelSize);
+}
+
+/*
+ * arrowFdwFilename - 'file' option of the foreign table
+ */
+static char *
+arrowFdwFilename(Oid ftable_oid)
+{
+	ForeignTable *ft = GetForeignTable(ftable_oid);
+	ListCell   *lc;
+
+	foreach (lc, ft->options)
+	{
+		DefElem	   *defel = lfirst(lc);
+
+		if (strcmp(defel->defname, "file") == 0)
+			return defGetString(defel);
+	}
+	elog(ERROR, "arrow_fdw: foreign table \"%s\" has no 'file' option",
+		 get_rel_name(ftable_oid));
+	return NULL;	/* be compiler quiet */
+}
+
+/*
+ * ExecInitArrowFdw
+ */
+ArrowFdwState *
+ExecInitArrowFdw(Relation relation, Bitmapset *referenced, List *outer_quals)
+{
+	ArrowFdwState *af_state = palloc0(sizeof(ArrowFdwState));
+	TupleDesc	tupdesc = RelationGetDescr(relation);
+	int			j;
+
+	af_state->relation = relation;
+	af_state->af_info = arrowOpenFile(arrowFdwFilename(RelationGetRelid(relation)));
+	af_state->attr_field = arrowCheckSchema(af_state->af_info, relation);
+	/* whole-row reference needs all the columns */
+	if (bms_is_member(-FirstLowInvalidHeapAttributeNumber, referenced))
+	{
+		for (j=0; j < tupdesc->natts; j++)
+			referenced = bms_add_member(referenced, j + 1 -
+										FirstLowInvalidHeapAttributeNumber);
+	}
+	af_state->referenced = referenced;
+	af_state->memcxt = CurrentMemoryContext;
+	arrowSetupStatsHint(af_state, outer_quals);
+
+	return af_state;
+}
+
+/*
+ * ExecScanChunkArrowFdw - loads the next record batch onto a PDS
+ */
+pgstrom_data_store *
+ExecScanChunkArrowFdw(GpuTaskState *gts)
+{
+	ArrowFdwState  *af_state = gts->af_state;
+	ArrowRecordBatch *rb;
+	pgstrom_data_store *pds;
+	CUdeviceptr		m_deviceptr;
+	CUresult		rc;
+	size_t			length;
+
+	rb = arrowNextRecordBatch(af_state);
+	if (!rb)
+		return NULL;
+
+	length = arrowRecordBatchLength(af_state, rb);
+	rc = gpuMemAllocManaged(gts->gcontext,
+							&m_deviceptr,
+							offsetof(pgstrom_data_store, kds) + length,
+							CU_MEM_ATTACH_GLOBAL);
+	if (rc != CUDA_SUCCESS)
+		elog(ERROR, "failed on gpuMemAllocManaged: %s", errorText(rc));
+	pds = (pgstrom_data_store *) m_deviceptr;
+	pds->gcontext = gts->gcontext;
+	pg_atomic_init_u32(&pds->refcnt, 1);
+	pds->nblocks_uncached = 0;
+	pds->filedesc = -1;
+	PG_TRY();
+	{
+		arrowLoadRecordBatch(af_state, rb, &pds->kds, length);
+	}
+	PG_CATCH();
+	{
+		PDS_release(pds);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	return pds;
+}
+
+/*
+ * ExecReScanArrowFdw
+ */
+void
+ExecReScanArrowFdw(ArrowFdwState *af_state)
+{
+	if (af_state->curr_kds)
+		pfree(af_state->curr_kds);
+	af_state->curr_kds = NULL;
+	af_state->curr_index = 0;
+	af_state->curr_batch = 0;
+}
+
+/*
+ * ExecEndArrowFdw
+ */
+void
+ExecEndArrowFdw(ArrowFdwState *af_state)
+{
+	ExecReScanArrowFdw(af_state);
+	arrowCloseFile(af_state->af_info);
+}
+
+/*
+ * ExplainArrowFdw
+ */
+void
+ExplainArrowFdw(ArrowFdwState *af_state, Relation frel, ExplainState *es)
+{
+	ArrowFileInfo *af_info = af_state->af_info;
+	char		temp[128];
+
+	ExplainPropertyText("Arrow File", af_info->filename, es);
+	if (af_state->stats_hints == NIL)
+		return;
+	if (!es->analyze)
+		ExplainPropertyInteger("Stats-Hint Quals", NULL,
+							   list_length(af_state->stats_hints), es);
+	else if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		snprintf(temp, sizeof(temp), "%ld of %d (%.2f%%)",
+				 af_state->skip_count,
+				 af_info->nbatches,
+				 100.0 * ((double) af_state->skip_count /
+						  (double) Max(af_info->nbatches, 1)));
+		ExplainPropertyText("Stats-Hint skipped", temp, es);
+	}
+	else
+	{
+		ExplainPropertyInteger("Stats-Hint fetched", NULL,
+							   af_state->load_count, es);
+		ExplainPropertyInteger("Stats-Hint skipped", NULL,
+							   af_state->skip_count, es);
+	}
+}
+
+/* ----------------------------------------------------------------
+ *
+ * FDW callbacks for the CPU scan
+ *
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * ArrowGetForeignRelSize
+ */
+static void
+ArrowGetForeignRelSize(PlannerInfo *root,
+					   RelOptInfo *baserel,
+					   Oid foreigntableid)
+{
+	ArrowFileInfo *af_info;
+	Relation	relation;
+	Selectivity	selectivity;
+
+	af_info = arrowOpenFile(arrowFdwFilename(foreigntableid));
+	relation = heap_open(foreigntableid, NoLock);
+	(void) arrowCheckSchema(af_info, relation);
+	heap_close(relation, NoLock);
+
+	baserel->tuples = (double) af_info->total_nitems;
+	baserel->pages = (af_info->mmap_size + BLCKSZ - 1) / BLCKSZ;
+	selectivity = clauselist_selectivity(root,
+										 baserel->baserestrictinfo,
+										 baserel->relid,
+										 JOIN_INNER,
+										 NULL);
+	baserel->rows = clamp_row_est(baserel->tuples * selectivity);
+	arrowCloseFile(af_info);
+}
+
+/*
+ * ArrowGetForeignPaths
+ */
+static void
+ArrowGetForeignPaths(PlannerInfo *root,
+					 RelOptInfo *baserel,
+					 Oid foreigntableid)
+{
+	ForeignPath *fpath;
+	Cost		startup_cost = baserel->baserestrictcost.startup;
+	Cost		run_cost;
+
+	run_cost = (seq_page_cost * baserel->pages +
+				(cpu_tuple_cost + baserel->baserestrictcost.per_tuple) *
+				baserel->tuples);
+	fpath = create_foreignscan_path(root, baserel,
+									NULL,	/* default pathtarget */
+									baserel->rows,
+									startup_cost,
+									startup_cost + run_cost,
+									NIL,	/* no pathkeys */
+									NULL,	/* no outer rel either */
+									NULL,	/* no extra plan */
+									NIL);	/* no particular private */
+	add_path(baserel, (Path *) fpath);
+}
+
+/*
+ * ArrowGetForeignPlan
+ */
+static ForeignScan *
+ArrowGetForeignPlan(PlannerInfo *root,
+					RelOptInfo *baserel,
+					Oid foreigntableid,
+					ForeignPath *best_path,
+					List *tlist,
+					List *scan_clauses,
+					Plan *outer_plan)
+{
+	Bitmapset  *referenced = NULL;
+	List	   *referenced_list = NIL;
+	ListCell   *lc;
+	int			j;
+
+	pull_varattnos((Node *)baserel->reltarget->exprs,
+				   baserel->relid, &referenced);
+	foreach (lc, baserel->baserestrictinfo)
+	{
+		RestrictInfo   *rinfo = lfirst(lc);
+
+		pull_varattnos((Node *)rinfo->clause,
+					   baserel->relid, &referenced);
+	}
+	j = -1;
+	while ((j = bms_next_member(referenced, j)) >= 0)
+		referenced_list = lappend_int(referenced_list, j);
+
+	return make_foreignscan(tlist,
+							extract_actual_clauses(scan_clauses, false),
+							baserel->relid,
+							NIL,		/* no expressions to evaluate */
+							referenced_list,
+							NIL,		/* no custom tlist */
+							NIL,		/* no remote quals */
+							outer_plan);
+}
+
+/*
+ * ArrowIsForeignScanParallelSafe
+ *
+ * Each process maps the Arrow file by itself, so ForeignScan can run on
+ * the background workers as a non-partial scan, like the inner side of
+ * a parallel join. Partial scan that distributes record batches over the
+ * workers is not supported, so GpuScan adds no partial paths on Arrow_fdw.
+ */
+static bool
+ArrowIsForeignScanParallelSafe(PlannerInfo *root,
+							   RelOptInfo *rel,
+							   RangeTblEntry *rte)
+{
+	return true;
+}
+
+/*
+ * ArrowBeginForeignScan
+ */
+static void
+ArrowBeginForeignScan(ForeignScanState *node, int eflags)
+{
+	ForeignScan *fscan = (ForeignScan *) node->ss.ps.plan;
+	Bitmapset  *referenced = NULL;
+	ListCell   *lc;
+
+	foreach (lc, fscan->fdw_private)
+		referenced = bms_add_member(referenced, lfirst_int(lc));
+
+	node->fdw_state = ExecInitArrowFdw(node->ss.ss_currentRelation,
+									   referenced,
+									   fscan->scan.plan.qual);
+}
+
+/*
+ * ArrowIterateForeignScan
+ */
+static TupleTableSlot *
+ArrowIterateForeignScan(ForeignScanState *node)
+{
+	ArrowFdwState  *af_state = node->fdw_state;
+	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
+	ArrowRecordBatch *rb;
+	size_t			length;
+
+	for (;;)
+	{
+		if (af_state->curr_kds &&
+			KDS_fetch_tuple_column(slot, af_state->curr_kds,
+								   af_state->curr_index++))
+			return slot;
+
+		if (af_state->curr_kds)
+			pfree(af_state->curr_kds);
+		af_state->curr_kds = NULL;
+		af_state->curr_index = 0;
+
+		rb = arrowNextRecordBatch(af_state);
+		if (!rb)
+			break;
+		length = arrowRecordBatchLength(af_state, rb);
+		af_state->curr_kds = MemoryContextAllocHuge(af_state->memcxt, length);
+		arrowLoadRecordBatch(af_state, rb, af_state->curr_kds, length);
+	}
+	return ExecClearTuple(slot);
+}
+
+/*
+ * ArrowReScanForeignScan
+ */
+static void
+ArrowReScanForeignScan(ForeignScanState *node)
+{
+	ExecReScanArrowFdw((ArrowFdwState *) node->fdw_state);
+}
+
+/*
+ * ArrowEndForeignScan
+ */
+static void
+ArrowEndForeignScan(ForeignScanState *node)
+{
+	ExecEndArrowFdw((ArrowFdwState *) node->fdw_state);
+}
+
+/*
+ * ArrowExplainForeignScan
+ */
+static void
+ArrowExplainForeignScan(ForeignScanState *node, ExplainState *es)
+{
+	ExplainArrowFdw((ArrowFdwState *) node->fdw_state,
+					node->ss.ss_currentRelation, es);
+}
+
+/*
+ * pgstrom_arrow_fdw_validator
+ */
+Datum
+pgstrom_arrow_fdw_validator(PG_FUNCTION_ARGS)
+{
+	List	   *options = untransformRelOptions(PG_GETARG_DATUM(0));
+	Oid			catalog = PG_GETARG_OID(1);
+	ListCell   *lc;
+	char	   *filename = NULL;
+
+	switch (catalog)
+	{
+		case ForeignTableRelationId:
+			foreach (lc, options)
+			{
+				DefElem	   *defel = lfirst(lc);
+
+				if (strcmp(defel->defname, "file") == 0)
+				{
+					if (filename)
+						ereport(ERROR,
+								(errcode(ERRCODE_SYNTAX_ERROR),
+								 errmsg("\"file\" option appears twice")));
+					filename = defGetString(defel);
+				}
+				else
+					ereport(ERROR,
+							(errcode(ERRCODE_SYNTAX_ERROR),
+							 errmsg("arrow_fdw: unknown option \"%s\"",
+									defel->defname)));
+			}
+			if (!filename)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("arrow_fdw: No Arrow file is specified"),
+						 errhint("use 'file' option to specify Arrow file")));
+			break;
+
+		case AttributeRelationId:
+			if (options)
+				elog(ERROR, "arrow_fdw: no options are supported on column");
+			break;
+
+		case ForeignServerRelationId:
+			if (options)
+				elog(ERROR, "arrow_fdw: no options are supported on SERVER");
+			break;
+
+		case ForeignDataWrapperRelationId:
+			if (options)
+				elog(ERROR, "arrow_fdw: no options are supported on FOREIGN DATA WRAPPER");
+			break;
+
+		default:
+			elog(ERROR, "arrow_fdw: no options are supported on catalog %s",
+				 get_rel_name(catalog));
+			break;
+	}
+	PG_RETURN_VOID();
+}
+PG_FUNCTION_INFO_V1(pgstrom_arrow_fdw_validator);
+
+/*
+ * pgstrom_arrow_fdw_handler
+ */
+Datum
+pgstrom_arrow_fdw_handler(PG_FUNCTION_ARGS)
+{
+	FdwRoutine *routine = makeNode(FdwRoutine);
+
+	/* functions for scanning foreign tables */
+	routine->GetForeignRelSize	= ArrowGetForeignRelSize;
+	routine->GetForeignPaths	= ArrowGetForeignPaths;
+	routine->GetForeignPlan		= ArrowGetForeignPlan;
+	routine->IsForeignScanParallelSafe = ArrowIsForeignScanParallelSafe;
+	routine->BeginForeignScan	= ArrowBeginForeignScan;
+	routine->IterateForeignScan	= ArrowIterateForeignScan;
+	routine->ReScanForeignScan	= ArrowReScanForeignScan;
+	routine->EndForeignScan		= ArrowEndForeignScan;
+	routine->ExplainForeignScan = ArrowExplainForeignScan;
+
+	PG_RETURN_POINTER(routine);
+}
+PG_FUNCTION_INFO_V1(pgstrom_arrow_fdw_handler);
+
+/*
+ * pgstrom_init_arrow_fdw
+ */
+void
+pgstrom_init_arrow_fdw(void)
+{
+	DefineCustomBoolVariable("pg_strom.enable_arrow_fdw",
+							 "Enables GPU scan on Arrow_fdw foreign tables",
+							 NULL,
+							 &arrow_fdw_enabled,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.arrow_fdw_stats_hint",
+							 "Enables to skip record batches using min/max statistics",
+							 NULL,
+							 &arrow_fdw_stats_hint_enabled,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+}
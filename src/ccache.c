@@ -0,0 +1,2107 @@
+/*
+ * ccache.c
+ *
+ * In-memory columnar cache implementation of PG-Strom
+ * ----
+ * Copyright 2011-2018 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2018 (C) The PG-Strom Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "pg_strom.h"
+#include <dirent.h>
+
+/*
+ * ccacheBuilder - state of the background ccache builder
+ */
+typedef struct
+{
+	Oid			database_oid;	/* database the builder is connected to */
+	Latch	   *latch;			/* valid only while the builder is running */
+	Oid			table_oid;		/* relation being loaded, if any */
+	BlockNumber	block_nr;		/* head block being loaded, if any */
+} ccacheBuilder;
+
+/*
+ * ccacheState - shared state of the columnar cache
+ */
+typedef struct
+{
+	/* management of ccache chunks */
+	size_t			ccache_usage;
+	slock_t			chunks_lock;
+	dlist_head		lru_misshit_list;
+	dlist_head		lru_active_list;
+	dlist_head		free_chunks_list;
+	dlist_head		unlink_chunks_list;	/* released, but file remains */
+	dlist_head	   *active_slots;
+	/* background ccache builders */
+	int				num_builders;
+	ccacheBuilder	builders[FLEXIBLE_ARRAY_MEMBER];
+} ccacheState;
+
+/*
+ * ccacheChunk
+ *
+ * A chunk is tracked by the hash slot while it is a misshit entry, under
+ * the construction or ready to use. The hash slot itself owns a reference
+ * of the chunk, and backends which load the chunk acquire extra ones.
+ */
+struct ccacheChunk
+{
+	dlist_node	lru_chain;		/* link to LRU list */
+	dlist_node	hash_chain;		/* link to Hash list */
+	pg_crc32	hash;			/* hash value */
+	Oid			database_oid;	/* OID of the cached database */
+	Oid			table_oid;		/* OID of the cached table */
+	Oid			relfilenode;	/* relfilenode of the table on build */
+	BlockNumber	block_nr;		/* block number where is head of the chunk */
+	size_t		length;			/* length of the ccache file */
+	cl_uint		nitems;			/* number of valid rows cached */
+	cl_int		nattrs;			/* number of regular columns */
+	cl_int		refcnt;			/* reference counter */
+	TimestampTz	ctime;			/* timestamp of the cache creation.
+								 * may be zero, if not constructed yet. */
+	TimestampTz	atime;			/* time of the latest access */
+};
+
+#define CCACHE_CTIME_NOT_BUILD		(0)
+#define CCACHE_CTIME_IN_PROGRESS	(DT_NOEND)
+#define CCACHE_CTIME_IS_READY(ctime)			\
+	((ctime) != CCACHE_CTIME_NOT_BUILD && (ctime) != CCACHE_CTIME_IN_PROGRESS)
+
+/*
+ * ccacheBuffer - temporary buffer to construct a ccache chunk
+ */
+typedef struct
+{
+	cl_int		nattrs;
+	size_t		nitems;
+	size_t		nrooms;
+	bool	   *hasnull;
+	bits8	  **nullmap;
+	void	  **values;		/* array of values, or varlena pointers */
+	size_t	   *extra_sz;	/* consumption of varlena body */
+} ccacheBuffer;
+
+/* static variables */
+static shmem_startup_hook_type shmem_startup_next = NULL;
+static size_t		ccache_total_size;			/* GUC */
+static char		   *ccache_base_dir_name;		/* GUC */
+static char		   *ccache_databases;			/* GUC */
+static DIR		   *ccache_base_dir = NULL;
+static ccacheState *ccache_state = NULL;		/* shmem */
+static cl_int		ccache_num_chunks;
+static cl_int		ccache_num_slots;
+static cl_int		ccache_num_builders = 0;
+static char		  **ccache_builder_dbnames = NULL;
+static Oid			ccache_invalidator_func_oid = InvalidOid;
+static volatile bool ccache_builder_got_sigterm = false;
+
+/* long-life resources for preload */
+static char		   *PerChunkLoadBuffer = NULL;
+static Buffer		VisibilityMapBuffer = InvalidBuffer;
+
+/* functions */
+Datum pgstrom_ccache_invalidator(PG_FUNCTION_ARGS);
+Datum pgstrom_ccache_info(PG_FUNCTION_ARGS);
+Datum pgstrom_ccache_builder_info(PG_FUNCTION_ARGS);
+Datum pgstrom_ccache_prewarm(PG_FUNCTION_ARGS);
+extern void ccacheBuilderMain(Datum arg);
+
+/*
+ * ccache_compute_hashvalue
+ */
+static inline pg_crc32
+ccache_compute_hashvalue(Oid database_oid, Oid table_oid, BlockNumber block_nr)
+{
+	pg_crc32	hash;
+
+	Assert((block_nr & (CCACHE_CHUNK_NBLOCKS - 1)) == 0);
+	INIT_LEGACY_CRC32(hash);
+	COMP_LEGACY_CRC32(hash, &database_oid, sizeof(Oid));
+	COMP_LEGACY_CRC32(hash, &table_oid, sizeof(Oid));
+	COMP_LEGACY_CRC32(hash, &block_nr, sizeof(BlockNumber));
+	FIN_LEGACY_CRC32(hash);
+
+	return hash;
+}
+
+/*
+ * ccache_chunk_filename
+ */
+static inline void
+ccache_chunk_filename(char *fname,
+					  Oid database_oid, Oid table_oid, BlockNumber block_nr)
+{
+	Assert((block_nr & (CCACHE_CHUNK_NBLOCKS - 1)) == 0);
+
+	snprintf(fname, MAXPGPATH, "CC%u_%u:%ld.dat",
+			 database_oid, table_oid,
+			 block_nr / CCACHE_CHUNK_NBLOCKS);
+}
+
+/*
+ * ccache_check_filename
+ */
+static bool
+ccache_check_filename(const char *fname)
+{
+	const char *pos = fname;
+	cl_long		database_oid = -1;
+	cl_long		table_oid = -1;
+	cl_long		chunk_id = -1;
+
+	if (fname[0] != 'C' || fname[1] != 'C')
+		return false;
+	pos = fname + 2;
+	while (isdigit(*pos))
+	{
+		database_oid = Max(database_oid, 0) * 10 + (*pos - '0');
+		if (database_oid > OID_MAX)
+			return false;
+		pos++;
+	}
+	if (database_oid < 0 || *pos++ != '_')
+		return false;
+	while (isdigit(*pos))
+	{
+		table_oid = Max(table_oid, 0) * 10 + (*pos - '0');
+		if (table_oid > OID_MAX)
+			return false;
+		pos++;
+	}
+	if (table_oid < 0 || *pos++ != ':')
+		return false;
+	while (isdigit(*pos))
+	{
+		chunk_id = Max(chunk_id, 0) * 10 + (*pos - '0');
+		if (chunk_id > MaxBlockNumber / CCACHE_CHUNK_NBLOCKS)
+			return false;
+		pos++;
+	}
+	if (chunk_id < 0 || strcmp(pos, ".dat") != 0)
+		return false;
+
+	return true;
+}
+
+/*
+ * ccache_put_chunk_nolock
+ *
+ * Once the last reference is released, the chunk goes back to the free
+ * list. If it has a ccache file, the chunk is queued on the unlink list
+ * instead, because we shall not issue system calls under the spinlock;
+ * ccache_chunks_lock_release() removes the file later.
+ */
+static void
+ccache_put_chunk_nolock(ccacheChunk *cc_chunk)
+{
+	Assert(cc_chunk->refcnt > 0);
+	if (--cc_chunk->refcnt == 0)
+	{
+		Assert(cc_chunk->hash_chain.prev == NULL &&
+			   cc_chunk->hash_chain.next == NULL);
+		if (cc_chunk->lru_chain.prev != NULL ||
+			cc_chunk->lru_chain.next != NULL)
+			dlist_delete(&cc_chunk->lru_chain);
+		memset(&cc_chunk->lru_chain, 0, sizeof(dlist_node));
+		if (!CCACHE_CTIME_IS_READY(cc_chunk->ctime))
+		{
+			Assert(cc_chunk->length == 0);
+			/* back to the free list */
+			memset(cc_chunk, 0, sizeof(ccacheChunk));
+			dlist_push_head(&ccache_state->free_chunks_list,
+							&cc_chunk->hash_chain);
+		}
+		else
+		{
+			Assert(cc_chunk->length > 0);
+			Assert(ccache_state->ccache_usage >= TYPEALIGN(BLCKSZ,
+														   cc_chunk->length));
+			ccache_state->ccache_usage -= TYPEALIGN(BLCKSZ, cc_chunk->length);
+			/* back to the free list after unlink of the file */
+			dlist_push_tail(&ccache_state->unlink_chunks_list,
+							&cc_chunk->hash_chain);
+		}
+	}
+}
+
+/*
+ * ccache_unlink_chunk_files
+ *
+ * It removes ccache files of the chunks on the unlink list, then moves
+ * them to the free list. A chunk under the removal is marked by
+ * CCACHE_CTIME_IN_PROGRESS, and stays on the unlink list until the file
+ * is gone, so nobody builds a new file with the same name meanwhile.
+ */
+static void
+ccache_unlink_chunk_files(void)
+{
+	ccacheChunk *cc_chunk;
+	dlist_iter	iter;
+	char		fname[MAXPGPATH];
+
+	for (;;)
+	{
+		cc_chunk = NULL;
+		SpinLockAcquire(&ccache_state->chunks_lock);
+		dlist_foreach(iter, &ccache_state->unlink_chunks_list)
+		{
+			ccacheChunk	   *cc_temp = dlist_container(ccacheChunk,
+													  hash_chain,
+													  iter.cur);
+			if (cc_temp->ctime != CCACHE_CTIME_IN_PROGRESS)
+			{
+				cc_temp->ctime = CCACHE_CTIME_IN_PROGRESS;
+				cc_chunk = cc_temp;
+				break;
+			}
+		}
+		SpinLockRelease(&ccache_state->chunks_lock);
+		if (!cc_chunk)
+			break;
+
+		ccache_chunk_filename(fname,
+							  cc_chunk->database_oid,
+							  cc_chunk->table_oid,
+							  cc_chunk->block_nr);
+		if (unlinkat(dirfd(ccache_base_dir), fname, 0) != 0)
+			elog(WARNING, "failed on unlinkat \"%s\": %m", fname);
+
+		SpinLockAcquire(&ccache_state->chunks_lock);
+		dlist_delete(&cc_chunk->hash_chain);
+		memset(cc_chunk, 0, sizeof(ccacheChunk));
+		dlist_push_head(&ccache_state->free_chunks_list,
+						&cc_chunk->hash_chain);
+		SpinLockRelease(&ccache_state->chunks_lock);
+	}
+}
+
+/*
+ * ccache_chunks_lock_release
+ *
+ * It releases the chunks_lock, then removes ccache files of the chunks
+ * released under the lock, if any.
+ */
+static inline void
+ccache_chunks_lock_release(void)
+{
+	bool		has_unlink_chunks
+		= !dlist_is_empty(&ccache_state->unlink_chunks_list);
+
+	SpinLockRelease(&ccache_state->chunks_lock);
+	if (has_unlink_chunks)
+		ccache_unlink_chunk_files();
+}
+
+/*
+ * ccache_detach_chunk_nolock
+ *
+ * It detaches the chunk from the hash slot and LRU list, then releases
+ * the reference by the hash slot. Chunk shall be released when the last
+ * backend which is loading the chunk puts it.
+ */
+static void
+ccache_detach_chunk_nolock(ccacheChunk *cc_chunk)
+{
+	if (cc_chunk->hash_chain.prev == NULL &&
+		cc_chunk->hash_chain.next == NULL)
+		return;		/* already detached */
+
+	dlist_delete(&cc_chunk->hash_chain);
+	memset(&cc_chunk->hash_chain, 0, sizeof(dlist_node));
+	if (cc_chunk->lru_chain.prev != NULL &&
+		cc_chunk->lru_chain.next != NULL)
+	{
+		dlist_delete(&cc_chunk->lru_chain);
+		memset(&cc_chunk->lru_chain, 0, sizeof(dlist_node));
+	}
+	ccache_put_chunk_nolock(cc_chunk);
+}
+
+/*
+ * ccache_builder_latch_nolock - latch of the builder for the database
+ */
+static Latch *
+ccache_builder_latch_nolock(Oid database_oid)
+{
+	int		i;
+
+	for (i=0; i < ccache_state->num_builders; i++)
+	{
+		ccacheBuilder  *builder = &ccache_state->builders[i];
+
+		if (builder->database_oid == database_oid && builder->latch)
+			return builder->latch;
+	}
+	return NULL;
+}
+
+/*
+ * pgstrom_ccache_put_chunk
+ */
+void
+pgstrom_ccache_put_chunk(ccacheChunk *cc_chunk)
+{
+	SpinLockAcquire(&ccache_state->chunks_lock);
+	ccache_put_chunk_nolock(cc_chunk);
+	ccache_chunks_lock_release();
+}
+
+/*
+ * pgstrom_ccache_get_chunk
+ *
+ * It returns a ccache chunk which is ready to load, if any. Elsewhere,
+ * it tracks the block range as a misshit entry, then kicks the background
+ * builder of the current database to construct the chunk.
+ */
+ccacheChunk *
+pgstrom_ccache_get_chunk(Relation relation, BlockNumber block_nr)
+{
+	Oid			table_oid = RelationGetRelid(relation);
+	TimestampTz	now = GetCurrentTimestamp();
+	pg_crc32	hash;
+	cl_int		index;
+	dlist_iter	iter;
+	dlist_node *dnode;
+	ccacheChunk *cc_chunk = NULL;
+	ccacheChunk *cc_temp;
+	Latch	   *builder_latch = NULL;
+
+	hash = ccache_compute_hashvalue(MyDatabaseId, table_oid, block_nr);
+	index = hash % ccache_num_slots;
+
+	SpinLockAcquire(&ccache_state->chunks_lock);
+	dlist_foreach (iter, &ccache_state->active_slots[index])
+	{
+		cc_temp = dlist_container(ccacheChunk, hash_chain, iter.cur);
+		if (cc_temp->hash == hash &&
+			cc_temp->database_oid == MyDatabaseId &&
+			cc_temp->table_oid == table_oid &&
+			cc_temp->block_nr == block_nr)
+		{
+			cc_temp->atime = now;
+			if (cc_temp->ctime == CCACHE_CTIME_NOT_BUILD)
+			{
+				Assert(cc_temp->length == 0 &&
+					   cc_temp->lru_chain.next != NULL &&
+					   cc_temp->lru_chain.prev != NULL);
+				dlist_move_head(&ccache_state->lru_misshit_list,
+								&cc_temp->lru_chain);
+				builder_latch = ccache_builder_latch_nolock(MyDatabaseId);
+			}
+			else if (cc_temp->ctime == CCACHE_CTIME_IN_PROGRESS)
+			{
+				Assert(cc_temp->length == 0 &&
+					   cc_temp->lru_chain.next == NULL &&
+					   cc_temp->lru_chain.prev == NULL);
+			}
+			else if (cc_temp->relfilenode != relation->rd_node.relNode ||
+					 cc_temp->nattrs != RelationGetNumberOfAttributes(relation))
+			{
+				/* table was rewritten or altered after the construction */
+				elog(DEBUG2, "ccache: relation %s, block %u is obsoleted",
+					 RelationGetRelationName(relation), block_nr);
+				ccache_detach_chunk_nolock(cc_temp);
+			}
+			else
+			{
+				Assert(cc_temp->length > 0);
+				dlist_move_head(&ccache_state->lru_active_list,
+								&cc_temp->lru_chain);
+				cc_chunk = cc_temp;
+				cc_chunk->refcnt++;
+			}
+			goto found;
+		}
+	}
+	Assert(cc_chunk == NULL);
+	/* no chunks are tracked, add it as misshit entry */
+	if (!dlist_is_empty(&ccache_state->free_chunks_list))
+	{
+		dnode = dlist_pop_head_node(&ccache_state->free_chunks_list);
+		cc_temp = dlist_container(ccacheChunk, hash_chain, dnode);
+		Assert(cc_temp->lru_chain.prev == NULL &&
+			   cc_temp->lru_chain.next == NULL &&
+			   cc_temp->refcnt == 0 &&
+			   cc_temp->ctime == CCACHE_CTIME_NOT_BUILD);
+	}
+	else if (!dlist_is_empty(&ccache_state->lru_misshit_list))
+	{
+		dnode = dlist_tail_node(&ccache_state->lru_misshit_list);
+		cc_temp = dlist_container(ccacheChunk, lru_chain, dnode);
+		Assert(cc_temp->hash_chain.prev != NULL &&
+			   cc_temp->hash_chain.next != NULL &&
+			   cc_temp->refcnt == 1 &&
+			   cc_temp->ctime == CCACHE_CTIME_NOT_BUILD);
+		dlist_delete(&cc_temp->hash_chain);
+		dlist_delete(&cc_temp->lru_chain);
+	}
+	else
+		goto found;		/* no room to track the misshit */
+
+	memset(cc_temp, 0, sizeof(ccacheChunk));
+	cc_temp->hash = hash;
+	cc_temp->database_oid = MyDatabaseId;
+	cc_temp->table_oid = table_oid;
+	cc_temp->block_nr = block_nr;
+	cc_temp->refcnt = 1;
+	cc_temp->atime = now;
+	dlist_push_tail(&ccache_state->active_slots[index],
+					&cc_temp->hash_chain);
+	dlist_push_head(&ccache_state->lru_misshit_list,
+					&cc_temp->lru_chain);
+	builder_latch = ccache_builder_latch_nolock(MyDatabaseId);
+found:
+	ccache_chunks_lock_release();
+	if (builder_latch)
+		SetLatch(builder_latch);
+
+	return cc_chunk;
+}
+
+/*
+ * ccache_check_kds_header
+ *
+ * It checks whether the ccache file is compatible to the current definition
+ * of the relation. Binary compatible ALTER COLUMN TYPE or DROP COLUMN does
+ * not change relfilenode.
+ */
+static bool
+ccache_check_kds_header(kern_data_store *kds, TupleDesc tupdesc)
+{
+	int		j;
+
+	if (kds->format != KDS_FORMAT_COLUMN ||
+		kds->ncols != tupdesc->natts)
+		return false;
+	for (j=0; j < kds->ncols; j++)
+	{
+		Form_pg_attribute attr = tupleDescAttr(tupdesc, j);
+		kern_colmeta   *cmeta = &kds->colmeta[j];
+
+		if (attr->attisdropped)
+		{
+			if (cmeta->va_offset != 0)
+				return false;
+			continue;
+		}
+		if (cmeta->attbyval  != attr->attbyval ||
+			cmeta->attalign  != typealign_get_width(attr->attalign) ||
+			cmeta->attlen    != attr->attlen ||
+			cmeta->attnum    != attr->attnum ||
+			cmeta->atttypid  != attr->atttypid ||
+			cmeta->atttypmod != attr->atttypmod)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * pgstrom_ccache_load_chunk
+ *
+ * It loads the columns referenced by @ccache_refs (a bitmap of attribute
+ * numbers offset by FirstLowInvalidHeapAttributeNumber) from the ccache
+ * file into a PDS of KDS_FORMAT_COLUMN. Unreferenced columns are left as
+ * all-null. It returns NULL if the chunk is not compatible to the current
+ * relation definition; the chunk is invalidated at the same time.
+ */
+pgstrom_data_store *
+pgstrom_ccache_load_chunk(ccacheChunk *cc_chunk,
+						  GpuContext *gcontext,
+						  Relation relation,
+						  Bitmapset *ccache_refs)
+{
+	TupleDesc	tupdesc = RelationGetDescr(relation);
+	int			i, j, fdesc;
+	size_t		nitems;
+	size_t		offset;
+	size_t		length;
+	CUdeviceptr	m_deviceptr;
+	CUresult	rc;
+	char		fname[MAXPGPATH];
+	kern_data_store *kds_head = NULL;
+	pgstrom_data_store *pds = NULL;
+
+	/* open the ccache file */
+	Assert(CCACHE_CTIME_IS_READY(cc_chunk->ctime));
+	ccache_chunk_filename(fname,
+						  cc_chunk->database_oid,
+						  cc_chunk->table_oid,
+						  cc_chunk->block_nr);
+	fdesc = openat(dirfd(ccache_base_dir), fname, O_RDONLY);
+	if (fdesc < 0)
+		elog(ERROR, "failed on openat('%s'): %m", fname);
+
+	PG_TRY();
+	{
+		/* load the header portion of kds-column */
+		length = KDS_CALCULATE_HEAD_LENGTH(tupdesc->natts, false);
+		kds_head = palloc(length);
+		if (pread(fdesc, kds_head, length, 0) != length)
+			elog(ERROR, "failed on pread('%s'): %m", fname);
+		if (!ccache_check_kds_header(kds_head, tupdesc))
+		{
+			elog(DEBUG2, "ccache: relation %s, block %u is incompatible",
+				 RelationGetRelationName(relation), cc_chunk->block_nr);
+			SpinLockAcquire(&ccache_state->chunks_lock);
+			ccache_detach_chunk_nolock(cc_chunk);
+			ccache_chunks_lock_release();
+			goto bailout;
+		}
+		nitems = kds_head->nitems;
+
+		/* count length of the PDS_column */
+		for (i = bms_next_member(ccache_refs, -1);
+			 i >= 0;
+			 i = bms_next_member(ccache_refs, i))
+		{
+			j = i + FirstLowInvalidHeapAttributeNumber - 1;
+			if (j < 0)
+				continue;	/* tableoid is kept in the KDS header */
+			length += __kds_unpack(kds_head->colmeta[j].va_length);
+		}
+
+		/* allocation of pds_column buffer */
+		rc = gpuMemAllocManaged(gcontext,
+								&m_deviceptr,
+								offsetof(pgstrom_data_store,
+										 kds) + length,
+								CU_MEM_ATTACH_GLOBAL);
+		if (rc != CUDA_SUCCESS)
+			elog(ERROR, "out of managed memory");
+		pds = (pgstrom_data_store *)m_deviceptr;
+		pds->gcontext = gcontext;
+		pg_atomic_init_u32(&pds->refcnt, 1);
+		pds->nblocks_uncached = 0;
+		pds->filedesc = -1;
+		init_kernel_data_store(&pds->kds, tupdesc, length,
+							   KDS_FORMAT_COLUMN, nitems, false);
+		pds->kds.table_oid = RelationGetRelid(relation);
+
+		/* load the referenced columns from the ccache file */
+		offset = KERN_DATA_STORE_HEAD_LENGTH(&pds->kds);
+		for (i = bms_next_member(ccache_refs, -1);
+			 i >= 0;
+			 i = bms_next_member(ccache_refs, i))
+		{
+			kern_colmeta   *cmeta;
+			size_t			nbytes;
+
+			j = i + FirstLowInvalidHeapAttributeNumber - 1;
+			if (j < 0)
+				continue;
+			cmeta = &kds_head->colmeta[j];
+			nbytes = __kds_unpack(cmeta->va_length);
+			if (nbytes == 0)
+				continue;
+			Assert(offset == MAXALIGN(offset));
+			pds->kds.colmeta[j].va_offset = __kds_packed(offset);
+			pds->kds.colmeta[j].va_length = cmeta->va_length;
+			if (pread(fdesc,
+					  (char *)&pds->kds + offset,
+					  nbytes,
+					  __kds_unpack(cmeta->va_offset)) != nbytes)
+				elog(ERROR, "failed on pread('%s'): %m", fname);
+			offset += nbytes;
+		}
+		Assert(offset == length);
+		pds->kds.nitems = nitems;
+		pds->kds.usage = __kds_packed(offset);
+	bailout:
+		;
+	}
+	PG_CATCH();
+	{
+		if (pds)
+			PDS_release(pds);
+		close(fdesc);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	close(fdesc);
+	if (kds_head)
+		pfree(kds_head);
+
+	return pds;
+}
+
+/*
+ * ccache_invalidator_oid - returns OID of invalidator trigger function
+ */
+static Oid
+ccache_invalidator_oid(bool missing_ok)
+{
+	Oid			pgstrom_namespace_oid;
+	oidvector	proc_args;
+	Form_pg_proc proc_form;
+	HeapTuple	tup;
+	PGFunction	invalidator_fn;
+	Oid			invalidator_oid;
+	Datum		datum;
+	bool		isnull;
+	char	   *probin;
+	char	   *prosrc;
+
+	if (OidIsValid(ccache_invalidator_func_oid))
+		return ccache_invalidator_func_oid;
+
+	pgstrom_namespace_oid = get_namespace_oid(PGSTROM_SCHEMA_NAME,
+											  missing_ok);
+	if (!OidIsValid(pgstrom_namespace_oid))
+		return InvalidOid;
+
+	SET_VARSIZE(&proc_args, offsetof(oidvector, values));
+	proc_args.ndim = 1;
+	proc_args.dataoffset = 0;
+	proc_args.elemtype = OIDOID;
+	proc_args.dim1 = 0;
+	proc_args.lbound1 = 1;
+
+	tup = SearchSysCache3(PROCNAMEARGSNSP,
+						  CStringGetDatum("ccache_invalidator"),
+						  PointerGetDatum(&proc_args),
+						  ObjectIdGetDatum(pgstrom_namespace_oid));
+	if (!HeapTupleIsValid(tup))
+	{
+		if (!missing_ok)
+			elog(ERROR, "cache lookup failed for function pgstrom.ccache_invalidator");
+		return InvalidOid;
+	}
+	invalidator_oid = HeapTupleGetOid(tup);
+	proc_form = (Form_pg_proc) GETSTRUCT(tup);
+
+	if (proc_form->prolang != ClanguageId)
+		elog(ERROR, "pgstrom.ccache_invalidator is not C function");
+
+	datum = SysCacheGetAttr(PROCOID, tup, Anum_pg_proc_prosrc, &isnull);
+	if (isnull)
+		elog(ERROR, "null prosrc for pgstrom.ccache_invalidator function");
+	prosrc = TextDatumGetCString(datum);
+
+	datum = SysCacheGetAttr(PROCOID, tup, Anum_pg_proc_probin, &isnull);
+	if (isnull)
+		elog(ERROR, "null probin for pgstrom.ccache_invalidator function");
+	probin = TextDatumGetCString(datum);
+	ReleaseSysCache(tup);
+
+	invalidator_fn = load_external_function(probin, prosrc,
+											!missing_ok, NULL);
+	if (invalidator_fn != pgstrom_ccache_invalidator)
+		return InvalidOid;
+
+	ccache_invalidator_func_oid = invalidator_oid;
+	return ccache_invalidator_func_oid;
+}
+
+/*
+ * ccache_callback_on_procoid - catcache callback on PROCOID
+ */
+static void
+ccache_callback_on_procoid(Datum arg, int cacheid, uint32 hashvalue)
+{
+	Assert(cacheid == PROCOID);
+	if (OidIsValid(ccache_invalidator_func_oid))
+	{
+		Datum	fnoid = ObjectIdGetDatum(ccache_invalidator_func_oid);
+		uint32	inval_hash = GetSysCacheHashValue(PROCOID, fnoid, 0, 0, 0);
+
+		if (hashvalue == 0 || inval_hash == hashvalue)
+			ccache_invalidator_func_oid = InvalidOid;
+	}
+}
+
+/*
+ * RelationCanUseColumnarCache
+ *
+ * The columnar cache is available only if the relation has the invalidator
+ * triggers on all the write operations, and these are enabled always.
+ */
+bool
+RelationCanUseColumnarCache(Relation relation)
+{
+	TriggerDesc *trigdesc = relation->trigdesc;
+	Oid		invalidator_oid;
+	bool	has_row_insert = false;
+	bool	has_row_update = false;
+	bool	has_row_delete = false;
+	bool	has_stmt_truncate = false;
+	int		i;
+
+	if (!ccache_state ||
+		RelationGetForm(relation)->relkind != RELKIND_RELATION)
+		return false;
+	if (!trigdesc ||
+		!trigdesc->trig_insert_after_row ||
+		!trigdesc->trig_update_after_row ||
+		!trigdesc->trig_delete_after_row ||
+		!trigdesc->trig_truncate_after_statement)
+		return false;
+
+	invalidator_oid = ccache_invalidator_oid(true);
+	if (!OidIsValid(invalidator_oid))
+		return false;
+
+	for (i=0; i < trigdesc->numtriggers; i++)
+	{
+		Trigger	   *trigger = &trigdesc->triggers[i];
+
+		if (trigger->tgfoid != invalidator_oid)
+			continue;
+		if (trigger->tgenabled != TRIGGER_FIRES_ALWAYS)
+			continue;
+		if (TRIGGER_FOR_AFTER(trigger->tgtype))
+		{
+			if (TRIGGER_FOR_ROW(trigger->tgtype))
+			{
+				if (TRIGGER_FOR_INSERT(trigger->tgtype))
+					has_row_insert = true;
+				if (TRIGGER_FOR_UPDATE(trigger->tgtype))
+					has_row_update = true;
+				if (TRIGGER_FOR_DELETE(trigger->tgtype))
+					has_row_delete = true;
+			}
+			else
+			{
+				if (TRIGGER_FOR_TRUNCATE(trigger->tgtype))
+					has_stmt_truncate = true;
+			}
+		}
+	}
+	return (has_row_insert &&
+			has_row_update &&
+			has_row_delete &&
+			has_stmt_truncate);
+}
+
+/*
+ * ccache_invalidate_block - invalidation of the chunk that contains
+ * the supplied block, if any.
+ */
+static void
+ccache_invalidate_block(Relation rel, BlockNumber block_nr)
+{
+	pg_crc32	hash;
+	int			index;
+	dlist_iter	iter;
+	bool		invalidated = false;
+
+	Assert((block_nr & (CCACHE_CHUNK_NBLOCKS - 1)) == 0);
+	hash = ccache_compute_hashvalue(MyDatabaseId,
+									RelationGetRelid(rel),
+									block_nr);
+	index = hash % ccache_num_slots;
+	SpinLockAcquire(&ccache_state->chunks_lock);
+	dlist_foreach(iter, &ccache_state->active_slots[index])
+	{
+		ccacheChunk *cc_temp = dlist_container(ccacheChunk,
+											   hash_chain,
+											   iter.cur);
+		if (cc_temp->hash == hash &&
+			cc_temp->database_oid == MyDatabaseId &&
+			cc_temp->table_oid == RelationGetRelid(rel) &&
+			cc_temp->block_nr == block_nr)
+		{
+			ccache_detach_chunk_nolock(cc_temp);
+			invalidated = true;
+			break;
+		}
+	}
+	ccache_chunks_lock_release();
+	if (invalidated)
+		elog(DEBUG2, "ccache: relation %s, block %u invalidation",
+			 RelationGetRelationName(rel), block_nr);
+}
+
+/*
+ * pgstrom_ccache_invalidator
+ */
+Datum
+pgstrom_ccache_invalidator(PG_FUNCTION_ARGS)
+{
+	FmgrInfo	   *flinfo = fcinfo->flinfo;
+	TriggerData	   *trigdata = (TriggerData *) fcinfo->context;
+	Relation		rel;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "%s: must be called as trigger", __FUNCTION__);
+	if (!TRIGGER_FIRED_AFTER(trigdata->tg_event))
+		elog(ERROR, "%s: must be configured as AFTER trigger", __FUNCTION__);
+	if (!ccache_state)
+		PG_RETURN_VOID();
+	rel = trigdata->tg_relation;
+
+	if (TRIGGER_FIRED_FOR_ROW(trigdata->tg_event))
+	{
+		HeapTuple	tuples[2];
+		int			i, ntuples = 0;
+
+		if (TRIGGER_FIRED_BY_INSERT(trigdata->tg_event) ||
+			TRIGGER_FIRED_BY_DELETE(trigdata->tg_event))
+			tuples[ntuples++] = trigdata->tg_trigtuple;
+		else if (TRIGGER_FIRED_BY_UPDATE(trigdata->tg_event))
+		{
+			/* new version of the tuple may be put on another chunk */
+			tuples[ntuples++] = trigdata->tg_trigtuple;
+			tuples[ntuples++] = trigdata->tg_newtuple;
+		}
+		else
+			elog(ERROR, "%s: triggered by unknown event", __FUNCTION__);
+
+		for (i=0; i < ntuples; i++)
+		{
+			BlockNumber	block_nr;
+			BlockNumber	block_nr_last;
+
+			block_nr = BlockIdGetBlockNumber(&tuples[i]->t_self.ip_blkid);
+			block_nr &= ~(CCACHE_CHUNK_NBLOCKS - 1);
+			/*
+			 * Several least bits of @block_nr should be always zero.
+			 * So, we use the least bit as a mark of valid @block_nr_last.
+			 */
+			block_nr_last = (BlockNumber)((uintptr_t)flinfo->fn_extra);
+			if ((block_nr_last & 1) != 0 &&
+				(block_nr_last & ~(CCACHE_CHUNK_NBLOCKS - 1)) == block_nr)
+				continue;
+			ccache_invalidate_block(rel, block_nr);
+			flinfo->fn_extra = (void *)((uintptr_t)(block_nr + 1));
+		}
+	}
+	else
+	{
+		int			index;
+		dlist_mutable_iter iter;
+
+		if (!TRIGGER_FIRED_BY_TRUNCATE(trigdata->tg_event))
+			elog(ERROR, "%s: triggered by unknown event", __FUNCTION__);
+
+		for (index=0; index < ccache_num_slots; index++)
+		{
+			SpinLockAcquire(&ccache_state->chunks_lock);
+			dlist_foreach_modify(iter, &ccache_state->active_slots[index])
+			{
+				ccacheChunk *cc_temp = dlist_container(ccacheChunk,
+													   hash_chain,
+													   iter.cur);
+				if (cc_temp->database_oid == MyDatabaseId &&
+					cc_temp->table_oid == RelationGetRelid(rel))
+					ccache_detach_chunk_nolock(cc_temp);
+			}
+			ccache_chunks_lock_release();
+		}
+		elog(DEBUG2, "ccache: relation %s invalidation",
+			 RelationGetRelationName(rel));
+	}
+	PG_RETURN_VOID();
+}
+PG_FUNCTION_INFO_V1(pgstrom_ccache_invalidator);
+
+/*
+ * pgstrom_ccache_info
+ */
+Datum
+pgstrom_ccache_info(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *fncxt;
+	ccacheChunk	   *cc_chunk;
+	List		   *cc_chunks_list = NIL;
+	HeapTuple		tuple;
+	bool			isnull[7];
+	Datum			values[7];
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc		tupdesc;
+		MemoryContext	oldcxt;
+		dlist_iter		iter;
+		int				i, nitems = 0;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(7, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "database_id",
+						   OIDOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "table_id",
+						   REGCLASSOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "block_nr",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "nitems",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "length",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 6, "ctime",
+						   TIMESTAMPTZOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 7, "atime",
+						   TIMESTAMPTZOID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+
+		/* collect current cache state; no palloc under the spinlock */
+		cc_chunk = palloc(sizeof(ccacheChunk) * ccache_num_chunks);
+		if (ccache_state)
+		{
+			SpinLockAcquire(&ccache_state->chunks_lock);
+			for (i=0; i < ccache_num_slots; i++)
+			{
+				dlist_foreach(iter, &ccache_state->active_slots[i])
+				{
+					ccacheChunk	   *cc_temp = dlist_container(ccacheChunk,
+															  hash_chain,
+															  iter.cur);
+					if (!CCACHE_CTIME_IS_READY(cc_temp->ctime))
+						continue;
+					Assert(nitems < ccache_num_chunks);
+					memcpy(&cc_chunk[nitems++], cc_temp, sizeof(ccacheChunk));
+				}
+			}
+			SpinLockRelease(&ccache_state->chunks_lock);
+		}
+		for (i=0; i < nitems; i++)
+			cc_chunks_list = lappend(cc_chunks_list, &cc_chunk[i]);
+		fncxt->user_fctx = cc_chunks_list;
+		MemoryContextSwitchTo(oldcxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+	cc_chunks_list = fncxt->user_fctx;
+
+	if (cc_chunks_list == NIL)
+		SRF_RETURN_DONE(fncxt);
+	cc_chunk = linitial(cc_chunks_list);
+	fncxt->user_fctx = list_delete_first(cc_chunks_list);
+
+	memset(isnull, 0, sizeof(isnull));
+	values[0] = ObjectIdGetDatum(cc_chunk->database_oid);
+	values[1] = ObjectIdGetDatum(cc_chunk->table_oid);
+	values[2] = Int32GetDatum(cc_chunk->block_nr);
+	values[3] = Int64GetDatum(cc_chunk->nitems);
+	values[4] = Int64GetDatum(cc_chunk->length);
+	values[5] = TimestampTzGetDatum(cc_chunk->ctime);
+	values[6] = TimestampTzGetDatum(cc_chunk->atime);
+
+	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+
+	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+}
+PG_FUNCTION_INFO_V1(pgstrom_ccache_info);
+
+/*
+ * pgstrom_ccache_builder_info
+ */
+Datum
+pgstrom_ccache_builder_info(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *fncxt;
+	ccacheBuilder  *builder;
+	HeapTuple		tuple;
+	bool			isnull[5];
+	Datum			values[5];
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc		tupdesc;
+		MemoryContext	oldcxt;
+		int				i;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(5, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "builder_id",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "database_id",
+						   OIDOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "state",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "table_id",
+						   REGCLASSOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "block_nr",
+						   INT4OID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+
+		builder = palloc(sizeof(ccacheBuilder) * Max(ccache_num_builders, 1));
+		if (ccache_state)
+		{
+			SpinLockAcquire(&ccache_state->chunks_lock);
+			for (i=0; i < ccache_num_builders; i++)
+				memcpy(&builder[i], &ccache_state->builders[i],
+					   sizeof(ccacheBuilder));
+			SpinLockRelease(&ccache_state->chunks_lock);
+		}
+		fncxt->user_fctx = builder;
+		fncxt->max_calls = ccache_num_builders;
+		MemoryContextSwitchTo(oldcxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+
+	if (fncxt->call_cntr >= fncxt->max_calls)
+		SRF_RETURN_DONE(fncxt);
+	builder = (ccacheBuilder *)fncxt->user_fctx + fncxt->call_cntr;
+
+	memset(isnull, 0, sizeof(isnull));
+	values[0] = Int32GetDatum(fncxt->call_cntr);
+	if (OidIsValid(builder->database_oid))
+		values[1] = ObjectIdGetDatum(builder->database_oid);
+	else
+		isnull[1] = true;
+	if (!builder->latch)
+		values[2] = CStringGetTextDatum("startup");
+	else if (!OidIsValid(builder->table_oid))
+		values[2] = CStringGetTextDatum("idle");
+	else
+		values[2] = CStringGetTextDatum("loading");
+	if (OidIsValid(builder->table_oid))
+	{
+		values[3] = ObjectIdGetDatum(builder->table_oid);
+		values[4] = Int32GetDatum(builder->block_nr);
+	}
+	else
+	{
+		isnull[3] = true;
+		isnull[4] = true;
+	}
+	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+
+	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+}
+PG_FUNCTION_INFO_V1(pgstrom_ccache_builder_info);
+
+/*
+ * ccache_setup_buffer
+ */
+static void
+ccache_setup_buffer(TupleDesc tupdesc, ccacheBuffer *cc_buf, size_t nrooms)
+{
+	int		j, nattrs = tupdesc->natts;
+
+	memset(cc_buf, 0, sizeof(ccacheBuffer));
+	cc_buf->nattrs = nattrs;
+	cc_buf->nitems = 0;
+	cc_buf->nrooms = nrooms;
+	cc_buf->hasnull = palloc0(sizeof(bool) * nattrs);
+	cc_buf->nullmap = palloc0(sizeof(bits8 *) * nattrs);
+	cc_buf->values = palloc0(sizeof(void *) * nattrs);
+	cc_buf->extra_sz = palloc0(sizeof(size_t) * nattrs);
+	for (j=0; j < nattrs; j++)
+	{
+		Form_pg_attribute attr = tupleDescAttr(tupdesc, j);
+
+		if (attr->attisdropped)
+			continue;
+		if (attr->attlen < 0)
+			cc_buf->values[j] = palloc_huge(sizeof(struct varlena *) *
+											Max(nrooms, 1));
+		else
+		{
+			int		unitsz = att_align_nominal(attr->attlen,
+											   attr->attalign);
+			cc_buf->nullmap[j] = palloc_huge(BITMAPLEN(Max(nrooms, 1)));
+			cc_buf->values[j] = palloc_huge(unitsz * Max(nrooms, 1));
+		}
+	}
+}
+
+/*
+ * ccache_buffer_append_row
+ */
+static void
+ccache_buffer_append_row(TupleDesc tupdesc,
+						 ccacheBuffer *cc_buf,
+						 bool *tup_isnull,
+						 Datum *tup_values)
+{
+	size_t		nitems = cc_buf->nitems;
+	int			j;
+
+	if (nitems >= cc_buf->nrooms)
+		elog(ERROR, "lack of ccache buffer rooms");
+
+	for (j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = tupleDescAttr(tupdesc, j);
+		bool	isnull = tup_isnull[j];
+		Datum	datum = tup_values[j];
+
+		if (attr->attisdropped)
+			continue;
+
+		if (attr->attlen < 0)
+		{
+			struct varlena *vl = NULL;
+
+			if (!isnull)
+			{
+				/* device code cannot de-toast external/compressed datum */
+				vl = PG_DETOAST_DATUM(datum);
+				cc_buf->extra_sz[j] += MAXALIGN(VARSIZE_ANY(vl));
+				if (MAXALIGN(sizeof(cl_uint) * (nitems + 1)) +
+					cc_buf->extra_sz[j] >= KDS_OFFSET_MAX_SIZE)
+					elog(ERROR, "attribute \"%s\" consumed too much",
+						 NameStr(attr->attname));
+			}
+			((struct varlena **)cc_buf->values[j])[nitems] = vl;
+		}
+		else
+		{
+			bits8  *nullmap = cc_buf->nullmap[j];
+			char   *base = cc_buf->values[j];
+
+			base += att_align_nominal(attr->attlen,
+									  attr->attalign) * nitems;
+			if (isnull)
+			{
+				cc_buf->hasnull[j] = true;
+				nullmap[nitems >> 3] &= ~(1 << (nitems & 7));
+				memset(base, 0, attr->attlen);
+			}
+			else
+			{
+				nullmap[nitems >> 3] |= (1 << (nitems & 7));
+				if (!attr->attbyval)
+					memcpy(base, DatumGetPointer(datum), attr->attlen);
+				else
+					store_att_byval(base, datum, attr->attlen);
+			}
+		}
+	}
+	cc_buf->nitems++;
+}
+
+/*
+ * ccache_buffer_length - length of the KDS to be written
+ */
+static size_t
+ccache_buffer_length(TupleDesc tupdesc, ccacheBuffer *cc_buf)
+{
+	size_t		length = KDS_CALCULATE_HEAD_LENGTH(cc_buf->nattrs, false);
+	size_t		nitems = cc_buf->nitems;
+	int			j;
+
+	for (j=0; j < cc_buf->nattrs; j++)
+	{
+		Form_pg_attribute attr = tupleDescAttr(tupdesc, j);
+
+		if (attr->attisdropped)
+			continue;
+		if (attr->attlen < 0)
+			length += (MAXALIGN(sizeof(cl_uint) * nitems) +
+					   cc_buf->extra_sz[j]);
+		else
+		{
+			int		unitsz = att_align_nominal(attr->attlen,
+											   attr->attalign);
+			length += MAXALIGN(unitsz * nitems);
+			if (cc_buf->hasnull[j])
+				length += MAXALIGN(BITMAPLEN(nitems));
+		}
+	}
+	return length;
+}
+
+/*
+ * ccache_copy_buffer_to_kds
+ */
+static void
+ccache_copy_buffer_to_kds(kern_data_store *kds,
+						  TupleDesc tupdesc,
+						  ccacheBuffer *cc_buf,
+						  size_t length)
+{
+	size_t	nitems = cc_buf->nitems;
+	char   *pos;
+	size_t	i, j;
+
+	init_kernel_data_store(kds,
+						   tupdesc,
+						   length,
+						   KDS_FORMAT_COLUMN,
+						   nitems,
+						   false);
+	pos = KERN_DATA_STORE_BODY(kds);
+	for (j=0; j < cc_buf->nattrs; j++)
+	{
+		Form_pg_attribute attr = tupleDescAttr(tupdesc, j);
+		kern_colmeta   *cmeta = &kds->colmeta[j];
+		char		   *base = pos;
+		size_t			nbytes;
+
+		/* skip dropped columns */
+		if (attr->attisdropped)
+			continue;
+
+		cmeta->va_offset = __kds_packed(pos - (char *)kds);
+		if (cmeta->attlen < 0)
+		{
+			cl_uint	   *offsets = (cl_uint *)base;
+			char	   *extra = base + MAXALIGN(sizeof(cl_uint) * nitems);
+			struct varlena **vl_array = cc_buf->values[j];
+
+			for (i=0; i < nitems; i++)
+			{
+				struct varlena *vl = vl_array[i];
+
+				if (!vl)
+					offsets[i] = 0;
+				else
+				{
+					nbytes = VARSIZE_ANY(vl);
+					offsets[i] = __kds_packed(extra - base);
+					memcpy(extra, vl, nbytes);
+					extra += MAXALIGN(nbytes);
+				}
+			}
+			pos = extra;
+		}
+		else
+		{
+			int		unitsz = TYPEALIGN(cmeta->attalign, cmeta->attlen);
+
+			nbytes = MAXALIGN(unitsz * nitems);
+			memcpy(pos, cc_buf->values[j], unitsz * nitems);
+			pos += nbytes;
+			/* null bitmap, if any */
+			if (cc_buf->hasnull[j])
+			{
+				nbytes = MAXALIGN(BITMAPLEN(nitems));
+				memcpy(pos, cc_buf->nullmap[j], BITMAPLEN(nitems));
+				pos += nbytes;
+			}
+		}
+		cmeta->va_length = __kds_packed(pos - base);
+	}
+	Assert(pos - (char *)kds == length);
+	kds->nitems = nitems;
+	kds->usage = __kds_packed(pos - (char *)kds);
+}
+
+/*
+ * __ccache_preload_chunk - construction of a ccache chunk
+ *
+ * It requires all the blocks in the chunk are all-visible, so any tuples
+ * are visible to any transactions, thus, we don't need to carry MVCC
+ * attributes on the columnar cache.
+ */
+static bool
+__ccache_preload_chunk(ccacheChunk *cc_chunk,
+					   Relation relation,
+					   BlockNumber block_nr)
+{
+	TupleDesc	tupdesc = RelationGetDescr(relation);
+	size_t		nrooms = 0;
+	Datum	   *tup_values;
+	bool	   *tup_isnull;
+	ccacheBuffer cc_buf;
+	int			i, j, fdesc;
+	size_t		kds_length;
+	char		fname[MAXPGPATH];
+	kern_data_store *kds;
+	BufferAccessStrategy strategy;
+
+	/* check visibility map first */
+	Assert((block_nr & (CCACHE_CHUNK_NBLOCKS-1)) == 0);
+	if (block_nr + CCACHE_CHUNK_NBLOCKS > RelationGetNumberOfBlocks(relation))
+		return false;
+	for (i=0; i < CCACHE_CHUNK_NBLOCKS; i++)
+	{
+		if (!VM_ALL_VISIBLE(relation, block_nr+i, &VisibilityMapBuffer))
+		{
+			elog(DEBUG2, "ccache: relation %s, block_nr %u - %lu not all visible",
+				 RelationGetRelationName(relation),
+				 block_nr, block_nr + CCACHE_CHUNK_NBLOCKS - 1);
+			return false;
+		}
+	}
+
+	/* load buffers */
+	strategy = GetAccessStrategy(BAS_BULKREAD);
+	for (i=0; i < CCACHE_CHUNK_NBLOCKS; i++)
+	{
+		Buffer	buffer;
+		Page	page;
+
+		CHECK_FOR_INTERRUPTS();
+		buffer = ReadBufferExtended(relation, MAIN_FORKNUM, block_nr+i,
+									RBM_NORMAL, strategy);
+		LockBuffer(buffer, BUFFER_LOCK_SHARE);
+		page = (Page) BufferGetPage(buffer);
+		if (!PageIsAllVisible(page))
+		{
+			UnlockReleaseBuffer(buffer);
+			FreeAccessStrategy(strategy);
+			elog(DEBUG2, "ccache: relation %s, block_nr %u is not all visible",
+				 RelationGetRelationName(relation), block_nr + i);
+			return false;
+		}
+		nrooms += PageGetMaxOffsetNumber(page);
+		memcpy(PerChunkLoadBuffer + i * BLCKSZ, page, BLCKSZ);
+		UnlockReleaseBuffer(buffer);
+	}
+	FreeAccessStrategy(strategy);
+
+	/*
+	 * OK, all the buffers are all-visible, let's extract rows
+	 */
+	ccache_setup_buffer(tupdesc, &cc_buf, nrooms);
+	tup_values = palloc(sizeof(Datum) * tupdesc->natts);
+	tup_isnull = palloc(sizeof(bool) * tupdesc->natts);
+	for (i=0; i < CCACHE_CHUNK_NBLOCKS; i++)
+	{
+		Page	page = (Page)(PerChunkLoadBuffer + BLCKSZ * i);
+		int		lines = PageGetMaxOffsetNumber(page);
+		OffsetNumber lineoff;
+		ItemId	lpp;
+
+		CHECK_FOR_INTERRUPTS();
+		for (lineoff = FirstOffsetNumber, lpp = PageGetItemId(page, lineoff);
+			 lineoff <= lines;
+			 lineoff++, lpp++)
+		{
+			HeapTupleData	tup;
+
+			if (!ItemIdIsNormal(lpp))
+				continue;
+			tup.t_tableOid = RelationGetRelid(relation);
+			tup.t_data = (HeapTupleHeader) PageGetItem(page, lpp);
+			tup.t_len = ItemIdGetLength(lpp);
+			ItemPointerSet(&tup.t_self, block_nr+i, lineoff);
+
+			heap_deform_tuple(&tup, tupdesc, tup_values, tup_isnull);
+			ccache_buffer_append_row(tupdesc, &cc_buf,
+									 tup_isnull, tup_values);
+		}
+	}
+
+	/* write out to the ccache file */
+	kds_length = ccache_buffer_length(tupdesc, &cc_buf);
+	ccache_chunk_filename(fname,
+						  MyDatabaseId,
+						  RelationGetRelid(relation),
+						  block_nr);
+	fdesc = openat(dirfd(ccache_base_dir), fname,
+				   O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (fdesc < 0)
+		elog(ERROR, "failed on openat('%s'): %m", fname);
+	while (fallocate(fdesc, 0, 0, kds_length) < 0)
+	{
+		if (errno == EINTR)
+		{
+			CHECK_FOR_INTERRUPTS();
+			continue;
+		}
+		close(fdesc);
+		unlinkat(dirfd(ccache_base_dir), fname, 0);
+		elog(ERROR, "failed on fallocate('%s'): %m", fname);
+	}
+	kds = mmap(NULL, kds_length,
+			   PROT_READ | PROT_WRITE,
+			   MAP_SHARED,
+			   fdesc, 0);
+	if (kds == MAP_FAILED)
+	{
+		close(fdesc);
+		unlinkat(dirfd(ccache_base_dir), fname, 0);
+		elog(ERROR, "failed on mmap('%s'): %m", fname);
+	}
+	ccache_copy_buffer_to_kds(kds, tupdesc, &cc_buf, kds_length);
+	kds->table_oid = RelationGetRelid(relation);
+	if (munmap(kds, kds_length) != 0)
+		elog(WARNING, "failed on munmap('%s'): %m", fname);
+	if (close(fdesc) != 0)
+		elog(WARNING, "failed on close('%s'): %m", fname);
+
+	/*
+	 * Ensure all-visible flags are still valid, because concurrent updates
+	 * may clear the flags prior to the invalidation by the trigger.
+	 * This check does not need the chunks_lock. Updates clear the flag
+	 * before the AFTER ROW trigger runs, and the trigger detaches the chunk
+	 * under the lock. So, if an update slips in after the check below,
+	 * its trigger either detaches the chunk prior to the registration (then
+	 * we see hash_chain is cleared), or invalidates the registered one.
+	 */
+	for (j=0; j < CCACHE_CHUNK_NBLOCKS; j++)
+	{
+		if (!VM_ALL_VISIBLE(relation, block_nr+j, &VisibilityMapBuffer))
+		{
+			kds_length = 0;
+			break;
+		}
+	}
+	SpinLockAcquire(&ccache_state->chunks_lock);
+	Assert(cc_chunk->lru_chain.next == NULL &&
+		   cc_chunk->lru_chain.prev == NULL &&
+		   cc_chunk->ctime == CCACHE_CTIME_IN_PROGRESS);
+	if (kds_length > 0 &&
+		cc_chunk->hash_chain.prev != NULL &&
+		cc_chunk->hash_chain.next != NULL)
+	{
+		dlist_iter		iter;
+		ccacheChunk	   *cc_temp;
+
+		ccache_state->ccache_usage += TYPEALIGN(BLCKSZ, kds_length);
+
+		cc_chunk->relfilenode = relation->rd_node.relNode;
+		cc_chunk->length = kds_length;
+		cc_chunk->nitems = cc_buf.nitems;
+		cc_chunk->nattrs = RelationGetNumberOfAttributes(relation);
+		cc_chunk->ctime = GetCurrentTimestamp();
+		/* move to the LRU active list, according to the access time */
+		dlist_foreach(iter, &ccache_state->lru_active_list)
+		{
+			cc_temp = dlist_container(ccacheChunk, lru_chain, iter.cur);
+			if (cc_chunk->atime > cc_temp->atime)
+			{
+				dlist_insert_before(&cc_temp->lru_chain,
+									&cc_chunk->lru_chain);
+				break;
+			}
+		}
+		if (cc_chunk->lru_chain.prev == NULL &&
+			cc_chunk->lru_chain.next == NULL)
+			dlist_push_tail(&ccache_state->lru_active_list,
+							&cc_chunk->lru_chain);
+		/* release the reference by the builder */
+		ccache_put_chunk_nolock(cc_chunk);
+		ccache_chunks_lock_release();
+
+		return true;
+	}
+	ccache_chunks_lock_release();
+
+	/* chunk was invalidated during the construction */
+	if (unlinkat(dirfd(ccache_base_dir), fname, 0) != 0)
+		elog(WARNING, "failed on unlinkat('%s'): %m", fname);
+	elog(DEBUG2, "ccache: relation %s, block_nr %u - %lu got invalidated",
+		 RelationGetRelationName(relation),
+		 block_nr, block_nr + CCACHE_CHUNK_NBLOCKS - 1);
+	return false;
+}
+
+/*
+ * ccache_preload_chunk
+ */
+static bool
+ccache_preload_chunk(ccacheChunk *cc_chunk,
+					 Relation relation,
+					 BlockNumber block_nr,
+					 MemoryContext PerChunkMemCxt)
+{
+	MemoryContext	oldcxt;
+	bool			retval;
+
+	oldcxt = MemoryContextSwitchTo(PerChunkMemCxt);
+	PG_TRY();
+	{
+		retval = __ccache_preload_chunk(cc_chunk, relation, block_nr);
+		MemoryContextSwitchTo(oldcxt);
+		MemoryContextReset(PerChunkMemCxt);
+	}
+	PG_CATCH();
+	{
+		MemoryContextSwitchTo(oldcxt);
+		MemoryContextReset(PerChunkMemCxt);
+		/* see comment below */
+		SpinLockAcquire(&ccache_state->chunks_lock);
+		ccache_detach_chunk_nolock(cc_chunk);
+		ccache_put_chunk_nolock(cc_chunk);
+		ccache_chunks_lock_release();
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	if (!retval)
+	{
+		/*
+		 * Fail of ccache_preload_chunk() is likely due to partial
+		 * all-visible blocks. It needs to be set by auto or manual
+		 * vacuum analyze, thus it is hopeless to cache this segment
+		 * very soon.
+		 * So, we purge this ccache misshit at this moment.
+		 */
+		SpinLockAcquire(&ccache_state->chunks_lock);
+		Assert(cc_chunk->ctime == CCACHE_CTIME_IN_PROGRESS);
+		ccache_detach_chunk_nolock(cc_chunk);
+		ccache_put_chunk_nolock(cc_chunk);
+		ccache_chunks_lock_release();
+	}
+	return retval;
+}
+
+/*
+ * ccache_tryload_one_chunk
+ *
+ * It returns 1 if a chunk is newly built, 0 if not built but we can
+ * continue, or -1 if no more chunks can be built right now.
+ */
+static int
+ccache_tryload_one_chunk(Relation relation, BlockNumber block_nr,
+						 MemoryContext PerChunkMemCxt)
+{
+	ccacheChunk	   *cc_chunk = NULL;
+	ccacheChunk	   *cc_temp;
+	pg_crc32		hashvalue;
+	dlist_iter		iter;
+	dlist_node	   *dnode;
+	TimestampTz		now = GetCurrentTimestamp();
+	cl_int			k;
+
+	Assert((block_nr & (CCACHE_CHUNK_NBLOCKS - 1)) == 0);
+	/* try to lookup a ccache chunk already built */
+	hashvalue = ccache_compute_hashvalue(MyDatabaseId,
+										 RelationGetRelid(relation),
+										 block_nr);
+	SpinLockAcquire(&ccache_state->chunks_lock);
+	k = hashvalue % ccache_num_slots;
+	dlist_foreach(iter, &ccache_state->active_slots[k])
+	{
+		cc_temp = dlist_container(ccacheChunk, hash_chain, iter.cur);
+		if (cc_temp->hash == hashvalue &&
+			cc_temp->database_oid == MyDatabaseId &&
+			cc_temp->table_oid == RelationGetRelid(relation) &&
+			cc_temp->block_nr == block_nr)
+		{
+			if (cc_temp->ctime == CCACHE_CTIME_NOT_BUILD)
+			{
+				cc_chunk = cc_temp;
+				break;
+			}
+			/* elsewhere, this chunk is already loaded, or in-progress */
+			SpinLockRelease(&ccache_state->chunks_lock);
+			return 0;
+		}
+	}
+	/* the file of the previous chunk is not removed yet */
+	dlist_foreach(iter, &ccache_state->unlink_chunks_list)
+	{
+		cc_temp = dlist_container(ccacheChunk, hash_chain, iter.cur);
+		if (cc_temp->database_oid == MyDatabaseId &&
+			cc_temp->table_oid == RelationGetRelid(relation) &&
+			cc_temp->block_nr == block_nr)
+		{
+			SpinLockRelease(&ccache_state->chunks_lock);
+			return 0;
+		}
+	}
+
+	/*
+	 * Evict the least recently used chunks, if ccache usage exceeds
+	 * the configured limitation. Chunks which are not accessed since
+	 * the last access to the chunk to be built are only evicted.
+	 */
+	while (ccache_state->ccache_usage + CCACHE_CHUNK_SIZE > ccache_total_size)
+	{
+		TimestampTz		atime = (cc_chunk ? cc_chunk->atime : now);
+
+		if (dlist_is_empty(&ccache_state->lru_active_list))
+			break;
+		dnode = dlist_tail_node(&ccache_state->lru_active_list);
+		cc_temp = dlist_container(ccacheChunk, lru_chain, dnode);
+		if (cc_temp->atime >= atime)
+			break;
+		elog(DEBUG2, "ccache: relation oid:%u block_nr %u was evicted",
+			 cc_temp->table_oid, cc_temp->block_nr);
+		ccache_detach_chunk_nolock(cc_temp);
+	}
+	if (ccache_state->ccache_usage + CCACHE_CHUNK_SIZE > ccache_total_size)
+	{
+		ccache_chunks_lock_release();
+		return -1;	/* exceeds the resource limit */
+	}
+
+	if (cc_chunk)
+	{
+		/* once detach cc_chunk from the LRU misshit list */
+		dlist_delete(&cc_chunk->lru_chain);
+		memset(&cc_chunk->lru_chain, 0, sizeof(dlist_node));
+		cc_chunk->ctime = CCACHE_CTIME_IN_PROGRESS;
+		cc_chunk->refcnt++;
+	}
+	else
+	{
+		if (!dlist_is_empty(&ccache_state->free_chunks_list))
+		{
+			/* try to fetch a free ccacheChunk object */
+			dnode = dlist_pop_head_node(&ccache_state->free_chunks_list);
+			cc_chunk = dlist_container(ccacheChunk, hash_chain, dnode);
+			Assert(cc_chunk->lru_chain.prev == NULL &&
+				   cc_chunk->lru_chain.next == NULL &&
+				   cc_chunk->refcnt == 0);
+		}
+		else if (!dlist_is_empty(&ccache_state->lru_misshit_list))
+		{
+			/* purge oldest misshit entry, if any */
+			dnode = dlist_tail_node(&ccache_state->lru_misshit_list);
+			cc_chunk = dlist_container(ccacheChunk, lru_chain, dnode);
+			dlist_delete(&cc_chunk->hash_chain);
+			dlist_delete(&cc_chunk->lru_chain);
+			Assert(cc_chunk->length == 0 &&
+				   cc_chunk->refcnt == 1 &&
+				   cc_chunk->ctime == CCACHE_CTIME_NOT_BUILD);
+		}
+		else
+		{
+			ccache_chunks_lock_release();
+			return -1;		/* no more ccache entry (should not happen) */
+		}
+		memset(cc_chunk, 0, sizeof(ccacheChunk));
+		cc_chunk->hash = hashvalue;
+		cc_chunk->database_oid = MyDatabaseId;
+		cc_chunk->table_oid = RelationGetRelid(relation);
+		cc_chunk->block_nr = block_nr;
+		cc_chunk->refcnt = 2;
+		cc_chunk->ctime = CCACHE_CTIME_IN_PROGRESS;
+		cc_chunk->atime = now;
+		dlist_push_head(&ccache_state->active_slots[k],
+						&cc_chunk->hash_chain);
+	}
+	ccache_chunks_lock_release();
+
+	/* try to load this chunk */
+	if (ccache_preload_chunk(cc_chunk, relation, block_nr, PerChunkMemCxt))
+		return 1;
+
+	/*
+	 * Elsewhere, ccache_preload_chunk() could not construct a columnar
+	 * cache chunk, because of (likely) all-visible restriction.
+	 */
+	return 0;
+}
+
+/*
+ * pgstrom_ccache_prewarm
+ *
+ * API for synchronous ccache build
+ */
+Datum
+pgstrom_ccache_prewarm(PG_FUNCTION_ARGS)
+{
+	Oid			table_oid = PG_GETARG_OID(0);
+	Relation	relation;
+	cl_uint		i, nchunks;
+	cl_uint		load_count = 0;
+	cl_int		rc;
+	MemoryContext PerChunkMemCxt;
+
+	relation = heap_open(table_oid, AccessShareLock);
+	if (!RelationCanUseColumnarCache(relation))
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("columnar cache is not configured on the table \"%s\"",
+						RelationGetRelationName(relation)),
+				 errhint("run pgstrom_ccache_enabled() on the table first")));
+
+	PerChunkMemCxt = AllocSetContextCreate(CurrentMemoryContext,
+										   "pgstrom_ccache_prewarm",
+										   ALLOCSET_DEFAULT_SIZES);
+	nchunks = RelationGetNumberOfBlocks(relation) / CCACHE_CHUNK_NBLOCKS;
+
+	Assert(!PerChunkLoadBuffer);
+	PerChunkLoadBuffer = palloc_huge(CCACHE_CHUNK_SIZE);
+	VisibilityMapBuffer = InvalidBuffer;
+	PG_TRY();
+	{
+		for (i=0; i < nchunks; i++)
+		{
+			BlockNumber		block_nr = i * CCACHE_CHUNK_NBLOCKS;
+
+			rc = ccache_tryload_one_chunk(relation, block_nr,
+										  PerChunkMemCxt);
+			if (rc < 0)
+				break;		/* cannot continue to load any more */
+			if (rc > 0)
+				load_count++;
+		}
+	}
+	PG_CATCH();
+	{
+		pfree(PerChunkLoadBuffer);
+		PerChunkLoadBuffer = NULL;
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	if (VisibilityMapBuffer != InvalidBuffer)
+		ReleaseBuffer(VisibilityMapBuffer);
+	VisibilityMapBuffer = InvalidBuffer;
+	pfree(PerChunkLoadBuffer);
+	PerChunkLoadBuffer = NULL;
+
+	heap_close(relation, NoLock);
+	MemoryContextDelete(PerChunkMemCxt);
+
+	PG_RETURN_INT32(load_count);
+}
+PG_FUNCTION_INFO_V1(pgstrom_ccache_prewarm);
+
+/*
+ * ccacheBuilderSigTerm
+ */
+static void
+ccacheBuilderSigTerm(SIGNAL_ARGS)
+{
+	int		saved_errno = errno;
+
+	ccache_builder_got_sigterm = true;
+
+	pg_memory_barrier();
+
+	SetLatch(MyLatch);
+
+	errno = saved_errno;
+}
+
+/*
+ * ccacheBuilderDetach - on_shmem_exit callback
+ */
+static void
+ccacheBuilderDetach(int code, Datum arg)
+{
+	ccacheBuilder  *builder = &ccache_state->builders[DatumGetInt32(arg)];
+
+	SpinLockAcquire(&ccache_state->chunks_lock);
+	builder->latch = NULL;
+	builder->table_oid = InvalidOid;
+	builder->block_nr = InvalidBlockNumber;
+	SpinLockRelease(&ccache_state->chunks_lock);
+}
+
+/*
+ * ccacheBuilderRunOnce
+ *
+ * It picks up the most recent misshit entry of the current database,
+ * then tries to build the ccache chunk. It returns false if nothing to do
+ * right now.
+ */
+static bool
+ccacheBuilderRunOnce(ccacheBuilder *builder, MemoryContext PerChunkMemCxt)
+{
+	Oid			table_oid = InvalidOid;
+	BlockNumber	block_nr = InvalidBlockNumber;
+	Relation	relation;
+	dlist_iter	iter;
+	int			rc = 0;
+
+	SpinLockAcquire(&ccache_state->chunks_lock);
+	dlist_foreach(iter, &ccache_state->lru_misshit_list)
+	{
+		ccacheChunk	   *cc_temp = dlist_container(ccacheChunk,
+												  lru_chain,
+												  iter.cur);
+		if (cc_temp->database_oid == MyDatabaseId)
+		{
+			table_oid = cc_temp->table_oid;
+			block_nr = cc_temp->block_nr;
+			break;
+		}
+	}
+	builder->table_oid = table_oid;
+	builder->block_nr = block_nr;
+	SpinLockRelease(&ccache_state->chunks_lock);
+	if (!OidIsValid(table_oid))
+		return false;
+
+	SetCurrentStatementStartTimestamp();
+	StartTransactionCommand();
+	relation = try_relation_open(table_oid, AccessShareLock);
+	if (relation && RelationCanUseColumnarCache(relation))
+		rc = ccache_tryload_one_chunk(relation, block_nr, PerChunkMemCxt);
+	else
+	{
+		pg_crc32	hash;
+		int			index;
+
+		/* relation was dropped, or ccache is no longer configured */
+		hash = ccache_compute_hashvalue(MyDatabaseId, table_oid, block_nr);
+		index = hash % ccache_num_slots;
+		SpinLockAcquire(&ccache_state->chunks_lock);
+		dlist_foreach(iter, &ccache_state->active_slots[index])
+		{
+			ccacheChunk	   *cc_temp = dlist_container(ccacheChunk,
+													  hash_chain,
+													  iter.cur);
+			if (cc_temp->hash == hash &&
+				cc_temp->database_oid == MyDatabaseId &&
+				cc_temp->table_oid == table_oid &&
+				cc_temp->block_nr == block_nr)
+			{
+				if (cc_temp->ctime == CCACHE_CTIME_NOT_BUILD)
+					ccache_detach_chunk_nolock(cc_temp);
+				break;
+			}
+		}
+		ccache_chunks_lock_release();
+	}
+	if (VisibilityMapBuffer != InvalidBuffer)
+		ReleaseBuffer(VisibilityMapBuffer);
+	VisibilityMapBuffer = InvalidBuffer;
+	if (relation)
+		relation_close(relation, AccessShareLock);
+	CommitTransactionCommand();
+
+	SpinLockAcquire(&ccache_state->chunks_lock);
+	builder->table_oid = InvalidOid;
+	builder->block_nr = InvalidBlockNumber;
+	SpinLockRelease(&ccache_state->chunks_lock);
+
+	if (rc > 0)
+		elog(DEBUG1, "ccache: relation oid:%u block_nr %u was loaded",
+			 table_oid, block_nr);
+	return (rc >= 0);
+}
+
+/*
+ * ccacheBuilderMain - main loop of the background ccache builder
+ */
+void
+ccacheBuilderMain(Datum arg)
+{
+	int				builder_id = DatumGetInt32(arg);
+	ccacheBuilder  *builder;
+	MemoryContext	PerChunkMemCxt;
+
+	pqsignal(SIGTERM, ccacheBuilderSigTerm);
+	BackgroundWorkerUnblockSignals();
+
+	Assert(builder_id >= 0 && builder_id < ccache_num_builders);
+	BackgroundWorkerInitializeConnection(ccache_builder_dbnames[builder_id],
+										 NULL, 0);
+	builder = &ccache_state->builders[builder_id];
+	SpinLockAcquire(&ccache_state->chunks_lock);
+	builder->database_oid = MyDatabaseId;
+	builder->latch = MyLatch;
+	builder->table_oid = InvalidOid;
+	builder->block_nr = InvalidBlockNumber;
+	SpinLockRelease(&ccache_state->chunks_lock);
+	on_shmem_exit(ccacheBuilderDetach, Int32GetDatum(builder_id));
+
+	PerChunkLoadBuffer = MemoryContextAllocHuge(TopMemoryContext,
+												CCACHE_CHUNK_SIZE);
+	PerChunkMemCxt = AllocSetContextCreate(TopMemoryContext,
+										   "ccache builder per-chunk context",
+										   ALLOCSET_DEFAULT_SIZES);
+	elog(LOG, "PG-Strom ccache builder-%d is now ready on database \"%s\"",
+		 builder_id, ccache_builder_dbnames[builder_id]);
+
+	/*
+	 * Event loop
+	 */
+	while (!ccache_builder_got_sigterm)
+	{
+		CHECK_FOR_INTERRUPTS();
+		if (!ccacheBuilderRunOnce(builder, PerChunkMemCxt))
+		{
+			int		ev;
+
+			ev = WaitLatch(MyLatch,
+						   WL_LATCH_SET |
+						   WL_TIMEOUT |
+						   WL_POSTMASTER_DEATH,
+						   10000L,
+						   PG_WAIT_EXTENSION);
+			ResetLatch(MyLatch);
+			if (ev & WL_POSTMASTER_DEATH)
+				elog(FATAL, "unexpected Postmaster dead");
+		}
+	}
+	elog(LOG, "PG-Strom ccache builder-%d is terminated", builder_id);
+	proc_exit(0);
+}
+
+/*
+ * pgstrom_startup_ccache
+ */
+static void
+pgstrom_startup_ccache(void)
+{
+	ccacheChunk *cc_chunk;
+	size_t		required;
+	bool		found;
+	int			i;
+	struct dirent *dent;
+
+	if (shmem_startup_next)
+		(*shmem_startup_next)();
+
+	required = MAXALIGN(offsetof(ccacheState,
+								 builders[ccache_num_builders])) +
+		MAXALIGN(sizeof(dlist_head) * ccache_num_slots) +
+		MAXALIGN(sizeof(ccacheChunk) * ccache_num_chunks);
+	ccache_state = ShmemInitStruct("Columnar Cache Shared Segment",
+								   required, &found);
+	if (found)
+		elog(ERROR, "Bug? Columnar Cache Shared Segment is already built");
+	memset(ccache_state, 0, required);
+	ccache_state->active_slots = (dlist_head *)
+		((char *)ccache_state +
+		 MAXALIGN(offsetof(ccacheState, builders[ccache_num_builders])));
+	/* hash slot of ccache chunks */
+	SpinLockInit(&ccache_state->chunks_lock);
+	dlist_init(&ccache_state->lru_misshit_list);
+	dlist_init(&ccache_state->lru_active_list);
+	dlist_init(&ccache_state->free_chunks_list);
+	dlist_init(&ccache_state->unlink_chunks_list);
+	for (i=0; i < ccache_num_slots; i++)
+		dlist_init(&ccache_state->active_slots[i]);
+	/* ccache-chunks */
+	cc_chunk = (ccacheChunk *)
+		((char *)ccache_state->active_slots +
+		 MAXALIGN(sizeof(dlist_head) * ccache_num_slots));
+	for (i=0; i < ccache_num_chunks; i++)
+	{
+		dlist_push_tail(&ccache_state->free_chunks_list,
+						&cc_chunk->hash_chain);
+		cc_chunk++;
+	}
+	/* ccache builders */
+	ccache_state->num_builders = ccache_num_builders;
+	for (i=0; i < ccache_num_builders; i++)
+	{
+		ccache_state->builders[i].database_oid = InvalidOid;
+		ccache_state->builders[i].latch = NULL;
+		ccache_state->builders[i].table_oid = InvalidOid;
+		ccache_state->builders[i].block_nr = InvalidBlockNumber;
+	}
+
+	/* cleanup ccache files */
+	rewinddir(ccache_base_dir);
+	while ((dent = readdir(ccache_base_dir)) != NULL)
+	{
+		if (ccache_check_filename(dent->d_name))
+		{
+			if (unlinkat(dirfd(ccache_base_dir), dent->d_name, 0) != 0)
+				elog(WARNING, "failed on unlinkat('%s','%s'): %m",
+					 ccache_base_dir_name, dent->d_name);
+		}
+	}
+}
+
+/*
+ * pgstrom_init_ccache
+ */
+void
+pgstrom_init_ccache(void)
+{
+	static int	ccache_total_size_kb;
+	int			ccache_total_size_default;
+	long		sc_pagesize = sysconf(_SC_PAGESIZE);
+	long		sc_phys_pages = sysconf(_SC_PHYS_PAGES);
+	struct statfs statbuf;
+	size_t		required = 0;
+	char		pathname[MAXPGPATH];
+	char	   *rawnames;
+	List	   *namelist;
+	ListCell   *lc;
+	int			i;
+
+	DefineCustomStringVariable("pg_strom.ccache_base_dir",
+							   "directory name used by ccache",
+							   NULL,
+							   &ccache_base_dir_name,
+							   "/dev/shm",
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	if (statfs(ccache_base_dir_name, &statbuf) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not stat ccache base directory \"%s\": %m",
+						ccache_base_dir_name)));
+
+	/* calculation of the default 'pg_strom.ccache_total_size' */
+	ccache_total_size_default =
+		Min((((3 * statbuf.f_blocks) / 4) * statbuf.f_bsize) >> 10,
+			(((2 * sc_phys_pages) / 3) * (sc_pagesize >> 10)));
+	DefineCustomIntVariable("pg_strom.ccache_total_size",
+							"possible maximum allocation of ccache",
+							NULL,
+							&ccache_total_size_kb,
+							ccache_total_size_default,
+							0,
+							INT_MAX,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+	ccache_total_size = (size_t)ccache_total_size_kb << 10;
+	ccache_num_slots = Max(ccache_total_size / CCACHE_CHUNK_SIZE, 300);
+	ccache_num_chunks = 5 * ccache_num_slots;
+
+	DefineCustomStringVariable("pg_strom.ccache_databases",
+							   "databases where ccache builder works on",
+							   NULL,
+							   &ccache_databases,
+							   "",
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	/* no directory and shared memory are needed, if ccache is disabled */
+	if (ccache_total_size == 0)
+		return;
+
+	snprintf(pathname, sizeof(pathname), "%s/.pg_strom.ccache.%u",
+			 ccache_base_dir_name, PostPortNumber);
+	ccache_base_dir = opendir(pathname);
+	if (!ccache_base_dir)
+	{
+		if (errno != ENOENT)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not open ccache directory \"%s\": %m",
+							pathname)));
+		if (mkdir(pathname, 0700) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not make a ccache directory \"%s\": %m",
+							pathname)));
+		ccache_base_dir = opendir(pathname);
+		if (!ccache_base_dir)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not open ccache directory \"%s\": %m",
+							pathname)));
+	}
+
+	rawnames = pstrdup(ccache_databases);
+	if (!SplitIdentifierString(rawnames, ',', &namelist))
+		elog(ERROR, "pg_strom.ccache_databases has invalid list syntax");
+	ccache_num_builders = list_length(namelist);
+	ccache_builder_dbnames = palloc0(sizeof(char *) *
+									 Max(ccache_num_builders, 1));
+	i = 0;
+	foreach (lc, namelist)
+	{
+		const char *dbname = lfirst(lc);
+		BackgroundWorker worker;
+
+		ccache_builder_dbnames[i] = pstrdup(dbname);
+
+		memset(&worker, 0, sizeof(BackgroundWorker));
+		snprintf(worker.bgw_name, sizeof(worker.bgw_name),
+				 "PG-Strom ccache builder-%d", i);
+		worker.bgw_flags = BGWORKER_SHMEM_ACCESS |
+			BGWORKER_BACKEND_DATABASE_CONNECTION;
+		worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+		worker.bgw_restart_time = 5;
+		snprintf(worker.bgw_library_name, BGW_MAXLEN, "pg_strom");
+		snprintf(worker.bgw_function_name, BGW_MAXLEN, "ccacheBuilderMain");
+		worker.bgw_main_arg = Int32GetDatum(i);
+		RegisterBackgroundWorker(&worker);
+		i++;
+	}
+
+	/* request for static shared memory */
+	required = MAXALIGN(offsetof(ccacheState,
+								 builders[ccache_num_builders])) +
+		MAXALIGN(sizeof(dlist_head) * ccache_num_slots) +
+		MAXALIGN(sizeof(ccacheChunk) * ccache_num_chunks);
+	RequestAddinShmemSpace(required);
+
+	shmem_startup_next = shmem_startup_hook;
+	shmem_startup_hook = pgstrom_startup_ccache;
+
+	CacheRegisterSyscacheCallback(PROCOID, ccache_callback_on_procoid, 0);
+}
@@ -23,6 +23,8 @@ static bool		devtype_info_is_built;
 static List	   *devtype_info_slot[128];
 static List	   *devfunc_info_slot[1024];
 bool			pgstrom_enable_numeric_type;	/* GUC */
+static bool		pgstrom_enable_device_cse;		/* GUC */
+static int		pgstrom_scalar_array_hash_threshold;	/* GUC */
 
 static pg_crc32 generic_devtype_hashfunc(devtype_info *dtype,
 										 pg_crc32 hash,
@@ -2314,15 +2316,209 @@ skip:
 		pgstrom_devtype_track(context, (devtype_info *) lfirst(lc));
 }
 
+/*
+ * scalar_array_op_hashable
+ *
+ * It checks whether the ScalarArrayOpExpr is (scalar = ANY(array)) on the
+ * integer based data types, and the constant array has many elements enough
+ * to pay the cost of hash-set.
+ * Number of elements is unknown at the planning time if array is given by
+ * the parameter (PARAM_EXTERN), so hash-set is built on execution time for
+ * any number of elements.
+ */
+static bool
+scalar_array_op_hashable(ScalarArrayOpExpr *opexpr)
+{
+	Node	   *arg;
+	Oid			elemtype;
+	int16		typlen;
+	bool		typbyval;
+
+	if (pgstrom_scalar_array_hash_threshold <= 0 ||
+		!opexpr->useOr ||
+		list_length(opexpr->args) != 2)
+		return false;
+	arg = lsecond(opexpr->args);
+	if (IsA(arg, Const))
+	{
+		if (((Const *) arg)->constisnull)
+			return false;
+	}
+	else if (IsA(arg, Param))
+	{
+		if (((Param *) arg)->paramkind != PARAM_EXTERN)
+			return false;
+	}
+	else
+		return false;
+	/*
+	 * equality operators on the integer based data types, where both of
+	 * arguments have identical type, so bitwise comparison is sufficient.
+	 */
+	set_sa_opfuncid(opexpr);
+	switch (opexpr->opfuncid)
+	{
+		case F_INT2EQ:
+		case F_INT4EQ:
+		case F_INT8EQ:
+		case F_DATE_EQ:
+		case F_TIMESTAMP_EQ:
+		case F_TIMESTAMPTZ_EQ:
+			break;
+		default:
+			return false;
+	}
+	elemtype = get_element_type(exprType(arg));
+	if (!OidIsValid(elemtype))
+		return false;
+	get_typlenbyval(elemtype, &typlen, &typbyval);
+	if (!typbyval || (typlen != 2 && typlen != 4 && typlen != 8))
+		return false;
+	if (IsA(arg, Const))
+	{
+		ArrayType  *array = DatumGetArrayTypeP(((Const *) arg)->constvalue);
+
+		if (ArrayGetNItems(ARR_NDIM(array),
+						   ARR_DIMS(array)) < pgstrom_scalar_array_hash_threshold)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * pgstrom_build_array_hashset
+ *
+ * It builds a kern_hashset from the array of integer based data types.
+ * It returns NULL if hash-set is too large to allocate.
+ */
+kern_hashset *
+pgstrom_build_array_hashset(ArrayType *array)
+{
+	Datum	   *elem_values;
+	bool	   *elem_isnull;
+	int			elem_nitems;
+	int16		typlen;
+	bool		typbyval;
+	char		typalign;
+	kern_hashset *hset;
+	cl_uint	   *usemap;
+	cl_uint		nslots;
+	Size		length;
+	int			i;
+
+	get_typlenbyvalalign(ARR_ELEMTYPE(array), &typlen, &typbyval, &typalign);
+	Assert(typbyval && (typlen == 2 || typlen == 4 || typlen == 8));
+	deconstruct_array(array, ARR_ELEMTYPE(array),
+					  typlen, typbyval, typalign,
+					  &elem_values, &elem_isnull, &elem_nitems);
+	/* keep at least half of the slots empty */
+	nslots = 16;
+	while (nslots < 2 * (Size) elem_nitems)
+		nslots <<= 1;
+	length = KERN_HASHSET_LENGTH(nslots);
+	if (!AllocSizeIsValid(length))
+		return NULL;
+	hset = palloc0(length);
+	SET_VARSIZE(hset, length);
+	hset->nslots = nslots;
+	usemap = KERN_HASHSET_USEMAP(hset);
+	for (i=0; i < elem_nitems; i++)
+	{
+		cl_long		key;
+		cl_uint		k;
+
+		if (elem_isnull[i])
+		{
+			hset->has_null = true;
+			continue;
+		}
+		if (typlen == sizeof(cl_short))
+			key = DatumGetInt16(elem_values[i]);
+		else if (typlen == sizeof(cl_int))
+			key = DatumGetInt32(elem_values[i]);
+		else
+			key = DatumGetInt64(elem_values[i]);
+
+		k = kern_hashset_hash(key) & (nslots - 1);
+		while ((usemap[k / 32] & (1U << (k % 32))) != 0)
+		{
+			if (hset->keys[k] == key)
+				break;		/* duplicated element */
+			k = (k + 1) & (nslots - 1);
+		}
+		if ((usemap[k / 32] & (1U << (k % 32))) == 0)
+		{
+			hset->keys[k] = key;
+			usemap[k / 32] |= (1U << (k % 32));
+			hset->nitems++;
+		}
+	}
+	pfree(elem_values);
+	pfree(elem_isnull);
+
+	return hset;
+}
+
+/*
+ * pgstrom_scalar_array_hashset
+ *
+ * It builds a kern_hashset from the constant array of ScalarArrayOpExpr,
+ * if hashable. Elsewhere, it returns NULL, and the array shall be walked
+ * on linearly. Hash-set of the parameter array is built on execution time
+ * by construct_kern_parambuf(), so it also returns NULL.
+ */
+kern_hashset *
+pgstrom_scalar_array_hashset(ScalarArrayOpExpr *opexpr)
+{
+	Const	   *con;
+
+	if (!scalar_array_op_hashable(opexpr))
+		return NULL;
+	con = (Const *) lsecond(opexpr->args);
+	if (!IsA(con, Const))
+		return NULL;
+	return pgstrom_build_array_hashset(DatumGetArrayTypeP(con->constvalue));
+}
+
 /*
  * codegen_expression_walker - main logic of run-time code generator
  */
 static int codegen_function_expression(codegen_context *context,
 									   devfunc_info *dfunc, List *args);
+static void __codegen_expression_walker(codegen_context *context,
+										Node *node, int *p_varlena_sz);
 
 static void
 codegen_expression_walker(codegen_context *context,
 						  Node *node, int *p_varlena_sz)
+{
+	ListCell   *lc;
+	int			index = 0;
+
+	/*
+	 * If @node is a common sub-expression, its result is kept in KCSE_n
+	 * once evaluated, then reused on the next occurrence within the same
+	 * device function. See pgstrom_codegen_cse_setup().
+	 */
+	foreach (lc, context->cse_exprs)
+	{
+		if (equal(node, lfirst(lc)))
+		{
+			appendStringInfo(&context->str,
+							 "PG_CSE_EVAL(KCSE_%u, ", index);
+			__codegen_expression_walker(context, node, p_varlena_sz);
+			appendStringInfoChar(&context->str, ')');
+			context->cse_refs = bms_add_member(context->cse_refs, index);
+			return;
+		}
+		index++;
+	}
+	__codegen_expression_walker(context, node, p_varlena_sz);
+}
+
+static void
+__codegen_expression_walker(codegen_context *context,
+							Node *node, int *p_varlena_sz)
 {
 	devtype_info   *dtype;
 	devfunc_info   *dfunc;
@@ -2787,6 +2983,66 @@ codegen_expression_walker(codegen_context *context,
 		ScalarArrayOpExpr *opexpr = (ScalarArrayOpExpr *) node;
 		Oid		func_oid = get_opcode(opexpr->opno);
 		Node   *expr;
+		kern_hashset *hset;
+
+		if (scalar_array_op_hashable(opexpr) &&
+			IsA(lsecond(opexpr->args), Param))
+		{
+			ScalarArrayOpExpr *marker;
+			cl_uint		index = 0;
+
+			/*
+			 * Hash-set of the parameter array is built on execution time,
+			 * so we put a ScalarArrayOpExpr on the @used_params as a marker
+			 * of the kern_hashset (bytea) in the kparams. Its first argument
+			 * is replaced by a dummy, not to reference any Var-nodes.
+			 */
+			if (!pgstrom_devtype_lookup_and_track(BYTEAOID, context))
+				elog(ERROR, "codegen: faied to lookup device type: %s",
+					 format_type_be(BYTEAOID));
+			expr = (Node *) makeNullConst(exprType(linitial(opexpr->args)),
+										  -1, InvalidOid);
+			marker = copyObject(opexpr);
+			marker->args = list_make2(expr, copyObject(lsecond(opexpr->args)));
+			foreach (cell, context->used_params)
+			{
+				if (equal(marker, lfirst(cell)))
+					break;
+				index++;
+			}
+			if (!cell)
+				context->used_params = lappend(context->used_params, marker);
+			context->param_refs = bms_add_member(context->param_refs, index);
+
+			appendStringInfo(&context->str, "PG_SCALAR_ARRAY_HASH(kcxt, ");
+			expr = linitial(opexpr->args);
+			codegen_expression_walker(context, expr, NULL);
+			appendStringInfo(&context->str, ", KPARAM_%u)", index);
+			context->extra_flags |= DEVKERNEL_NEEDS_MATRIX;
+			varlena_sz = 0;
+			goto out;
+		}
+		hset = pgstrom_scalar_array_hashset(opexpr);
+		if (hset)
+		{
+			Const  *con = makeConst(BYTEAOID,
+									-1,
+									InvalidOid,
+									-1,
+									PointerGetDatum(hset),
+									false,
+									false);
+
+			appendStringInfo(&context->str, "PG_SCALAR_ARRAY_HASH(kcxt, ");
+			expr = linitial(opexpr->args);
+			codegen_expression_walker(context, expr, NULL);
+			appendStringInfo(&context->str, ", ");
+			codegen_expression_walker(context, (Node *) con, NULL);
+			appendStringInfo(&context->str, ")");
+			context->extra_flags |= DEVKERNEL_NEEDS_MATRIX;
+			varlena_sz = 0;
+			goto out;
+		}
 
 		dfunc = pgstrom_devfunc_lookup(func_oid,
 									   get_func_rettype(func_oid),
@@ -2883,6 +3139,8 @@ pgstrom_codegen_expression(Node *expr, codegen_context *context)
 	walker_context.kds_label  = context->kds_label;
 	walker_context.kds_index_label = context->kds_index_label;
 	walker_context.pseudo_tlist = context->pseudo_tlist;
+	walker_context.cse_exprs = context->cse_exprs;
+	walker_context.cse_refs = bms_copy(context->cse_refs);
 	walker_context.extra_flags = context->extra_flags;
 	walker_context.varlena_bufsz = context->varlena_bufsz;
 
@@ -2911,6 +3169,7 @@ pgstrom_codegen_expression(Node *expr, codegen_context *context)
 	context->used_params = walker_context.used_params;
 	context->used_vars = walker_context.used_vars;
 	context->param_refs = walker_context.param_refs;
+	context->cse_refs = walker_context.cse_refs;
 	/* no need to write back xxx_label fields because read-only */
 	context->extra_flags = walker_context.extra_flags;
 	context->varlena_bufsz = walker_context.varlena_bufsz;
@@ -2973,6 +3232,14 @@ pgstrom_codegen_param_declarations(StringInfo buf, codegen_context *context)
 				"  pg_%s_t KPARAM_%u = pg_%s_param(kcxt,%d);\n",
 				dtype->type_name, index, dtype->type_name, index);
 		}
+		else if (IsA(lfirst(cell), ScalarArrayOpExpr))
+		{
+			/* hash-set of the parameter array, built on execution time */
+			appendStringInfo(
+				buf,
+				"  pg_bytea_t KPARAM_%u = pg_bytea_param(kcxt,%d);\n",
+				index, index);
+		}
 		else
 			elog(ERROR, "unexpected node: %s", nodeToString(lfirst(cell)));
 	lnext:
@@ -2980,6 +3247,131 @@ pgstrom_codegen_param_declarations(StringInfo buf, codegen_context *context)
 	}
 }
 
+/*
+ * pgstrom_codegen_cse_setup
+ *
+ * It picks up sub-expressions which appear multiple times in the supplied
+ * expressions, to be evaluated only once per device function invocation.
+ * Caller must call this function with @exprs = NIL once code generation of
+ * the device function is done, not to apply the common sub-expressions to
+ * the next one.
+ */
+typedef struct
+{
+	List	   *exprs;
+	List	   *counts;
+} codegen_cse_context;
+
+static bool
+codegen_cse_candidate_walker(Node *node, codegen_cse_context *con)
+{
+	ListCell   *lc1;
+	ListCell   *lc2;
+
+	if (!node)
+		return false;
+	if (!IsA(node, FuncExpr) &&
+		!IsA(node, OpExpr) &&
+		!IsA(node, DistinctExpr) &&
+		!IsA(node, ScalarArrayOpExpr) &&
+		!IsA(node, CoalesceExpr) &&
+		!IsA(node, MinMaxExpr) &&
+		!IsA(node, CaseExpr))
+		return expression_tree_walker(node, codegen_cse_candidate_walker,
+									  (void *) con);
+
+	forboth (lc1, con->exprs,
+			 lc2, con->counts)
+	{
+		if (equal(node, lfirst(lc1)))
+		{
+			/* sub-expressions are already counted on the first one */
+			lfirst_int(lc2)++;
+			return false;
+		}
+	}
+	con->exprs = lappend(con->exprs, node);
+	con->counts = lappend_int(con->counts, 1);
+
+	return expression_tree_walker(node, codegen_cse_candidate_walker,
+								  (void *) con);
+}
+
+static bool
+codegen_cse_casetest_walker(Node *node, void *context)
+{
+	if (!node)
+		return false;
+	if (IsA(node, CaseTestExpr))
+		return true;
+	return expression_tree_walker(node, codegen_cse_casetest_walker, context);
+}
+
+void
+pgstrom_codegen_cse_setup(codegen_context *context, List *exprs)
+{
+	codegen_cse_context con;
+	ListCell   *lc1;
+	ListCell   *lc2;
+
+	context->cse_exprs = NIL;
+	context->cse_refs = NULL;
+	if (!pgstrom_enable_device_cse || exprs == NIL)
+		return;
+
+	memset(&con, 0, sizeof(codegen_cse_context));
+	codegen_cse_candidate_walker((Node *) exprs, &con);
+	forboth (lc1, con.exprs,
+			 lc2, con.counts)
+	{
+		Node   *expr = lfirst(lc1);
+
+		if (lfirst_int(lc2) < 2)
+			continue;
+		/*
+		 * CaseTestExpr is a placeholder of the CASE argument, so its value
+		 * depends on the location; volatile functions must be evaluated
+		 * for each occurrence.
+		 */
+		if (codegen_cse_casetest_walker(expr, NULL) ||
+			contain_volatile_functions(expr))
+			continue;
+		context->cse_exprs = lappend(context->cse_exprs, expr);
+	}
+	list_free(con.exprs);
+	list_free(con.counts);
+}
+
+/*
+ * pgstrom_codegen_cse_declarations
+ */
+void
+pgstrom_codegen_cse_declarations(StringInfo buf, codegen_context *context)
+{
+	ListCell	   *lc;
+	devtype_info   *dtype;
+	Oid				type_oid;
+	int				index = 0;
+
+	foreach (lc, context->cse_exprs)
+	{
+		if (bms_is_member(index, context->cse_refs))
+		{
+			type_oid = exprType((Node *) lfirst(lc));
+			dtype = pgstrom_devtype_lookup(type_oid);
+			if (!dtype)
+				elog(ERROR, "failed to lookup device type: %s",
+					 format_type_be(type_oid));
+			appendStringInfo(
+				buf,
+				"  pg_%s_t KCSE_%u;\n"
+				"  cl_bool KCSE_%u_done = false;\n",
+				dtype->type_name, index, index);
+		}
+		index++;
+	}
+}
+
 /*
  * device_expression_walker
  */
@@ -3332,8 +3724,13 @@ device_expression_walker(device_expression_walker_context *con,
 		 * cost for PG_SCALAR_ARRAY_OP - It repeats invocation of the operator
 		 * function for each array elements. Tentatively, we assume an array
 		 * has 32 elements in average.
+		 * Large constant array, or parameter array, is probed by the
+		 * hash-set, instead.
 		 */
-		con->devcost += 32 * dfunc->func_devcost;
+		if (scalar_array_op_hashable(opexpr))
+			con->devcost += 2 * dfunc->func_devcost;
+		else
+			con->devcost += 32 * dfunc->func_devcost;
 		varlena_sz = 0;
 		return true;
 	}
@@ -3461,4 +3858,24 @@ pgstrom_init_codegen(void)
 							 NULL,
 							 guc_assign_cache_invalidator,
 							 NULL);
+	/* pg_strom.scalar_array_hash_threshold */
+	DefineCustomIntVariable("pg_strom.scalar_array_hash_threshold",
+							"Minimum number of array elements to build hash-set for IN-list",
+							NULL,
+							&pgstrom_scalar_array_hash_threshold,
+							32,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* pg_strom.enable_device_cse */
+	DefineCustomBoolVariable("pg_strom.enable_device_cse",
+							 "Enables common sub-expression elimination on the device code",
+							 NULL,
+							 &pgstrom_enable_device_cse,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 }
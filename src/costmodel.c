@@ -0,0 +1,454 @@
+/*
+ * costmodel.c
+ *
+ * Per-device / per-tablespace cost profiles of the GPU and host side
+ * operations, to be referenced by the planner instead of the global
+ * cost parameters.
+ * ----
+ * Copyright 2011-2018 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2018 (C) The PG-Strom Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "pg_strom.h"
+
+/*
+ * NOTE: pgstrom.cost_profile is a regular table of the extension, filled
+ * by pgstrom.calibrate_cost_model(). Each row is identified by the pair
+ * of device number (-1 means any GPU device) and tablespace (0 means any
+ * tablespace), and a NULL coefficient means "not calibrated"; the planner
+ * takes the first non-NULL value from the most specific profile, then
+ * falls back to the global cost parameters.
+ * The default tablespace of the database is identified by its own OID,
+ * not 0, so its profile is never confused with the one for any tablespace.
+ * Backend caches the entire table once, then the AFTER trigger on the
+ * table sends relcache invalidation on update.
+ */
+#define Anum_cost_profile_device_nr			1
+#define Anum_cost_profile_tablespace		2
+#define Anum_cost_profile_gpu_setup_cost	3
+#define Anum_cost_profile_gpu_dma_cost		4
+#define Anum_cost_profile_gpu_operator_cost	5
+#define Anum_cost_profile_cpu_repack_cost	6
+#define Natts_cost_profile					7
+
+#define COST_PROFILE_GPU_SETUP		0x0001
+#define COST_PROFILE_GPU_DMA		0x0002
+#define COST_PROFILE_GPU_OPERATOR	0x0004
+#define COST_PROFILE_CPU_REPACK		0x0008
+#define COST_PROFILE_ALL			0x000f
+
+typedef struct
+{
+	cl_int		device_nr;
+	Oid			tablespace;
+	cl_uint		valid;			/* mask of COST_PROFILE_* */
+	pgstromCostFactors factors;
+} costProfileEntry;
+
+/* static variables */
+static bool		pgstrom_enable_cost_profile;	/* GUC */
+static Oid		cost_profile_relid = InvalidOid;
+static int		cost_profile_nitems = -1;	/* -1 means not loaded */
+static costProfileEntry *cost_profile_entries = NULL;
+static bool		cost_profile_callback_registered = false;
+
+Datum pgstrom_cost_profile_invalidator(PG_FUNCTION_ARGS);
+Datum pgstrom_tablespace_optimal_gpu(PG_FUNCTION_ARGS);
+Datum pgstrom_calibrate_host_repack(PG_FUNCTION_ARGS);
+
+/*
+ * cost_profile_callback - relcache callback on pgstrom.cost_profile
+ */
+static void
+cost_profile_callback(Datum arg, Oid relid)
+{
+	if (!OidIsValid(relid) || relid == cost_profile_relid)
+	{
+		if (cost_profile_entries)
+			pfree(cost_profile_entries);
+		cost_profile_entries = NULL;
+		cost_profile_nitems = -1;
+		cost_profile_relid = InvalidOid;
+	}
+}
+
+/*
+ * cost_profile_fetch_factor
+ */
+static inline void
+cost_profile_fetch_factor(Datum *values, bool *isnull, int anum,
+						  cl_uint mask, costProfileEntry *entry,
+						  double *p_factor)
+{
+	double		factor;
+
+	if (isnull[anum - 1])
+		return;
+	factor = DatumGetFloat8(values[anum - 1]);
+	if (isnan(factor) || factor < 0.0)
+		return;
+	*p_factor = factor;
+	entry->valid |= mask;
+}
+
+/*
+ * cost_profile_load - loads pgstrom.cost_profile onto the local cache,
+ * if not yet. It returns false if no profile is available.
+ */
+static bool
+cost_profile_load(void)
+{
+	Oid			namespace_oid;
+	Oid			relid;
+	Relation	rel;
+	TupleDesc	tupdesc;
+	Snapshot	snapshot;
+	SysScanDesc	scan;
+	HeapTuple	tuple;
+	int			nrooms = 32;
+	int			nitems = 0;
+	costProfileEntry *entries;
+
+	if (cost_profile_nitems >= 0)
+		return (cost_profile_nitems > 0);
+
+	/* pg_strom extension may not be installed on this database */
+	namespace_oid = get_namespace_oid("pgstrom", true);
+	if (!OidIsValid(namespace_oid))
+		return false;
+	relid = get_relname_relid("cost_profile", namespace_oid);
+	if (!OidIsValid(relid))
+		return false;
+
+	if (!cost_profile_callback_registered)
+	{
+		CacheRegisterRelcacheCallback(cost_profile_callback, (Datum) 0);
+		cost_profile_callback_registered = true;
+	}
+
+	rel = heap_open(relid, AccessShareLock);
+	tupdesc = RelationGetDescr(rel);
+	if (tupdesc->natts != Natts_cost_profile ||
+		tupleDescAttr(tupdesc, Anum_cost_profile_device_nr-1)->atttypid
+			!= INT4OID ||
+		tupleDescAttr(tupdesc, Anum_cost_profile_tablespace-1)->atttypid
+			!= OIDOID ||
+		tupleDescAttr(tupdesc, Anum_cost_profile_gpu_setup_cost-1)->atttypid
+			!= FLOAT8OID ||
+		tupleDescAttr(tupdesc, Anum_cost_profile_gpu_dma_cost-1)->atttypid
+			!= FLOAT8OID ||
+		tupleDescAttr(tupdesc, Anum_cost_profile_gpu_operator_cost-1)->atttypid
+			!= FLOAT8OID ||
+		tupleDescAttr(tupdesc, Anum_cost_profile_cpu_repack_cost-1)->atttypid
+			!= FLOAT8OID)
+		elog(ERROR, "pgstrom.cost_profile has unexpected definition");
+
+	/*
+	 * The entries are built on the current memory context, then copied to
+	 * the CacheMemoryContext at the end, so an error during the scan does
+	 * not leave a half-built cache.
+	 */
+	entries = palloc(sizeof(costProfileEntry) * nrooms);
+
+	snapshot = RegisterSnapshot(GetLatestSnapshot());
+	scan = systable_beginscan(rel, InvalidOid, false, snapshot, 0, NULL);
+	while ((tuple = systable_getnext(scan)) != NULL)
+	{
+		costProfileEntry *entry;
+		Datum		values[Natts_cost_profile];
+		bool		isnull[Natts_cost_profile];
+
+		heap_deform_tuple(tuple, tupdesc, values, isnull);
+		if (isnull[Anum_cost_profile_device_nr - 1] ||
+			isnull[Anum_cost_profile_tablespace - 1])
+			continue;
+		if (nitems >= nrooms)
+		{
+			nrooms *= 2;
+			entries = repalloc(entries, sizeof(costProfileEntry) * nrooms);
+		}
+		entry = &entries[nitems];
+		memset(entry, 0, sizeof(costProfileEntry));
+		entry->device_nr =
+			DatumGetInt32(values[Anum_cost_profile_device_nr - 1]);
+		entry->tablespace =
+			DatumGetObjectId(values[Anum_cost_profile_tablespace - 1]);
+		cost_profile_fetch_factor(values, isnull,
+								  Anum_cost_profile_gpu_setup_cost,
+								  COST_PROFILE_GPU_SETUP, entry,
+								  &entry->factors.gpu_setup_cost);
+		cost_profile_fetch_factor(values, isnull,
+								  Anum_cost_profile_gpu_dma_cost,
+								  COST_PROFILE_GPU_DMA, entry,
+								  &entry->factors.gpu_dma_cost);
+		cost_profile_fetch_factor(values, isnull,
+								  Anum_cost_profile_gpu_operator_cost,
+								  COST_PROFILE_GPU_OPERATOR, entry,
+								  &entry->factors.gpu_operator_cost);
+		cost_profile_fetch_factor(values, isnull,
+								  Anum_cost_profile_cpu_repack_cost,
+								  COST_PROFILE_CPU_REPACK, entry,
+								  &entry->factors.cpu_repack_cost);
+		if (entry->valid != 0)
+			nitems++;
+	}
+	systable_endscan(scan);
+	UnregisterSnapshot(snapshot);
+	heap_close(rel, AccessShareLock);
+
+	cost_profile_entries = MemoryContextAlloc(CacheMemoryContext,
+											  sizeof(costProfileEntry) *
+											  Max(nitems, 1));
+	memcpy(cost_profile_entries, entries,
+		   sizeof(costProfileEntry) * nitems);
+	pfree(entries);
+	cost_profile_relid = relid;
+	cost_profile_nitems = nitems;
+
+	return (nitems > 0);
+}
+
+/*
+ * cost_profile_merge - fills up the factors not decided yet
+ */
+static cl_uint
+cost_profile_merge(pgstromCostFactors *cf, cl_uint valid,
+				   cl_int device_nr, Oid tablespace)
+{
+	int			i;
+
+	for (i=0; i < cost_profile_nitems; i++)
+	{
+		costProfileEntry *entry = &cost_profile_entries[i];
+		cl_uint		mask;
+
+		if (entry->device_nr != device_nr ||
+			entry->tablespace != tablespace)
+			continue;
+		mask = entry->valid & ~valid;
+		if (mask & COST_PROFILE_GPU_SETUP)
+			cf->gpu_setup_cost = entry->factors.gpu_setup_cost;
+		if (mask & COST_PROFILE_GPU_DMA)
+			cf->gpu_dma_cost = entry->factors.gpu_dma_cost;
+		if (mask & COST_PROFILE_GPU_OPERATOR)
+			cf->gpu_operator_cost = entry->factors.gpu_operator_cost;
+		if (mask & COST_PROFILE_CPU_REPACK)
+			cf->cpu_repack_cost = entry->factors.cpu_repack_cost;
+		return valid | mask;
+	}
+	return valid;
+}
+
+/*
+ * pgstrom_get_cost_factors
+ *
+ * It returns cost factors to be applied on the supplied relation. If @rel
+ * is a base relation, the profile of its tablespace and the GPU device
+ * closest to the tablespace is preferred. Elsewhere, or once no profile
+ * matched, the generic profile (device_nr = -1, tablespace = 0) and the
+ * global cost parameters are applied.
+ */
+void
+pgstrom_get_cost_factors(PlannerInfo *root, RelOptInfo *rel,
+						 pgstromCostFactors *cf)
+{
+	cl_int		device_nr = -1;
+	Oid			tablespace = InvalidOid;
+	cl_uint		valid = 0;
+
+	cf->gpu_setup_cost		= pgstrom_gpu_setup_cost;
+	cf->gpu_dma_cost		= pgstrom_gpu_dma_cost;
+	cf->gpu_operator_cost	= pgstrom_gpu_operator_cost;
+	cf->cpu_repack_cost		= 0.0;
+
+	if (!pgstrom_enable_cost_profile || !cost_profile_load())
+		return;
+
+	if (rel && (rel->reloptkind == RELOPT_BASEREL ||
+				rel->reloptkind == RELOPT_OTHER_MEMBER_REL) &&
+		rel->rtekind == RTE_RELATION)
+	{
+		/* planner considers the default tablespace as 0 */
+		tablespace = (OidIsValid(rel->reltablespace)
+					  ? rel->reltablespace
+					  : MyDatabaseTableSpace);
+		device_nr = GetOptimalGpuForRelation(root, rel);
+	}
+
+	if (device_nr >= 0 && OidIsValid(tablespace))
+		valid = cost_profile_merge(cf, valid, device_nr, tablespace);
+	if (device_nr >= 0 && valid != COST_PROFILE_ALL)
+		valid = cost_profile_merge(cf, valid, device_nr, InvalidOid);
+	if (OidIsValid(tablespace) && valid != COST_PROFILE_ALL)
+		valid = cost_profile_merge(cf, valid, -1, tablespace);
+	if (valid != COST_PROFILE_ALL)
+		valid = cost_profile_merge(cf, valid, -1, InvalidOid);
+}
+
+/*
+ * pgstrom_cost_profile_invalidator
+ *
+ * AFTER statement trigger on pgstrom.cost_profile; to reload the profile
+ * on the next planning.
+ */
+Datum
+pgstrom_cost_profile_invalidator(PG_FUNCTION_ARGS)
+{
+	TriggerData	   *trigdata = (TriggerData *) fcinfo->context;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "%s: must be called as trigger", __FUNCTION__);
+	if (!TRIGGER_FIRED_AFTER(trigdata->tg_event))
+		elog(ERROR, "%s: must be configured as AFTER trigger", __FUNCTION__);
+	CacheInvalidateRelcache(trigdata->tg_relation);
+
+	PG_RETURN_POINTER(NULL);
+}
+PG_FUNCTION_INFO_V1(pgstrom_cost_profile_invalidator);
+
+/*
+ * pgstrom_tablespace_optimal_gpu
+ *
+ * It returns the GPU device closest to the tablespace, or -1 if any.
+ * The calibration command uses this number as device_nr of the profile.
+ */
+Datum
+pgstrom_tablespace_optimal_gpu(PG_FUNCTION_ARGS)
+{
+	Oid			tablespace_oid = PG_GETARG_OID(0);
+
+	PG_RETURN_INT32(GetOptimalGpuForTablespace(tablespace_oid));
+}
+PG_FUNCTION_INFO_V1(pgstrom_tablespace_optimal_gpu);
+
+/*
+ * pgstrom_calibrate_host_repack
+ *
+ * It measures the time to scan the relation, and the time to scan and
+ * load the tuples onto KDS_FORMAT_ROW chunks, as the CPU fallback and
+ * row-format data store do. The best result of @nloops is returned.
+ */
+Datum
+pgstrom_calibrate_host_repack(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	int			nloops = PG_GETARG_INT32(1);
+	Relation	relation;
+	TupleDesc	tupdesc;
+	TupleTableSlot *slot;
+	kern_data_store *kds;
+	Size		chunk_sz = pgstrom_chunk_size();
+	int64		ntuples = 0;
+	double		scan_ms = -1.0;
+	double		repack_ms = -1.0;
+	Datum		values[3];
+	bool		isnull[3];
+	int			loop;
+
+	if (nloops < 1)
+		elog(ERROR, "number of loops must be positive");
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	aclcheck_error(pg_class_aclcheck(relid, GetUserId(), ACL_SELECT),
+#if PG_VERSION_NUM < 110000
+				   ACL_KIND_CLASS,
+#else
+				   OBJECT_TABLE,
+#endif
+				   get_rel_name(relid));
+
+	relation = heap_open(relid, AccessShareLock);
+	if (RelationGetForm(relation)->relkind != RELKIND_RELATION &&
+		RelationGetForm(relation)->relkind != RELKIND_MATVIEW)
+		elog(ERROR, "\"%s\" is not a table or materialized view",
+			 RelationGetRelationName(relation));
+	slot = MakeSingleTupleTableSlot(RelationGetDescr(relation));
+	kds = palloc_huge(chunk_sz);
+
+	for (loop=0; loop < nloops; loop++)
+	{
+		HeapScanDesc scan;
+		HeapTuple	tuple;
+		instr_time	tv1, tv2, tv3;
+		double		elapsed;
+
+		/* plain heap scan */
+		INSTR_TIME_SET_CURRENT(tv1);
+		ntuples = 0;
+		scan = heap_beginscan(relation, GetActiveSnapshot(), 0, NULL);
+		while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+		{
+			ExecStoreTuple(tuple, slot, scan->rs_cbuf, false);
+			ntuples++;
+		}
+		heap_endscan(scan);
+		INSTR_TIME_SET_CURRENT(tv2);
+
+		/* heap scan with repacking onto the chunks */
+		init_kernel_data_store(kds, RelationGetDescr(relation), chunk_sz,
+							   KDS_FORMAT_ROW, INT_MAX, false);
+		scan = heap_beginscan(relation, GetActiveSnapshot(), 0, NULL);
+		while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+		{
+			ExecStoreTuple(tuple, slot, scan->rs_cbuf, false);
+			if (!KDS_insert_tuple(kds, slot))
+			{
+				init_kernel_data_store(kds, RelationGetDescr(relation),
+									   chunk_sz, KDS_FORMAT_ROW,
+									   INT_MAX, false);
+				if (!KDS_insert_tuple(kds, slot))
+					elog(ERROR, "tuple is too large to load on a chunk");
+			}
+			CHECK_FOR_INTERRUPTS();
+		}
+		heap_endscan(scan);
+		INSTR_TIME_SET_CURRENT(tv3);
+		ExecClearTuple(slot);
+
+		INSTR_TIME_SUBTRACT(tv3, tv2);
+		INSTR_TIME_SUBTRACT(tv2, tv1);
+		elapsed = INSTR_TIME_GET_MILLISEC(tv2);
+		if (scan_ms < 0.0 || elapsed < scan_ms)
+			scan_ms = elapsed;
+		elapsed = INSTR_TIME_GET_MILLISEC(tv3);
+		if (repack_ms < 0.0 || elapsed < repack_ms)
+			repack_ms = elapsed;
+	}
+	pfree(kds);
+	ExecDropSingleTupleTableSlot(slot);
+	heap_close(relation, AccessShareLock);
+
+	memset(isnull, 0, sizeof(isnull));
+	values[0] = Int64GetDatum(ntuples);
+	values[1] = Float8GetDatum(scan_ms);
+	values[2] = Float8GetDatum(repack_ms);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(BlessTupleDesc(tupdesc),
+													  values, isnull)));
+}
+PG_FUNCTION_INFO_V1(pgstrom_calibrate_host_repack);
+
+/*
+ * pgstrom_init_costmodel
+ */
+void
+pgstrom_init_costmodel(void)
+{
+	/* pg_strom.enable_cost_profile */
+	DefineCustomBoolVariable("pg_strom.enable_cost_profile",
+							 "Enables to use calibrated cost profiles",
+							 NULL,
+							 &pgstrom_enable_cost_profile,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+}
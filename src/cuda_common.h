@@ -988,6 +988,63 @@ pointer_on_kparams(void *ptr, kern_parambuf *kparams)
 					   (char *)ptr <  (char *)kparams + kparams->length);
 }
 
+/*
+ * kern_hashset
+ *
+ * Open-addressing hash set of the array elements on ScalarArrayOpExpr,
+ * like (Var = ANY(large constant array)). It is built on the host side,
+ * then delivered to the device as a bytea constant on the kern_parambuf.
+ * Elements are integer based types, and kept as 64bit signed integer.
+ */
+typedef struct
+{
+	cl_uint		__vl_len;		/* 4B varlena header */
+	cl_uint		nslots;			/* number of hash slots; power of 2 */
+	cl_uint		nitems;			/* number of unique non-NULL elements */
+	cl_bool		has_null;		/* true, if array contains NULL */
+	cl_char		__padding__[3];
+	cl_long		keys[FLEXIBLE_ARRAY_MEMBER];
+	/* <-- cl_uint usemap[(nslots + 31) / 32] --> */
+} kern_hashset;
+
+#define KERN_HASHSET_USEMAP(hset)						\
+	((cl_uint *)((hset)->keys + (hset)->nslots))
+#define KERN_HASHSET_LENGTH(nslots)						\
+	(offsetof(kern_hashset, keys[(nslots)]) +			\
+	 sizeof(cl_uint) * (((nslots) + 31) / 32))
+
+STATIC_INLINE(cl_uint)
+kern_hashset_hash(cl_long key)
+{
+	cl_ulong	h = (cl_ulong) key;
+
+	/* finalizer of MurmurHash3 */
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdUL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53UL;
+	h ^= h >> 33;
+
+	return (cl_uint) h;
+}
+
+STATIC_INLINE(cl_bool)
+kern_hashset_lookup(kern_hashset *hset, cl_long key)
+{
+	cl_uint	   *usemap = KERN_HASHSET_USEMAP(hset);
+	cl_uint		mask = hset->nslots - 1;
+	cl_uint		i = kern_hashset_hash(key) & mask;
+
+	/* nslots is larger than nitems, so we always meet an empty slot */
+	while ((usemap[i / 32] & (1U << (i % 32))) != 0)
+	{
+		if (hset->keys[i] == key)
+			return true;
+		i = (i + 1) & mask;
+	}
+	return false;
+}
+
 /*
  * GstoreIpcHandle
  *
@@ -2638,6 +2695,16 @@ to_bool(cl_bool value)
 	return result;
 }
 
+/*
+ * PG_CSE_EVAL - evaluation of the common sub-expression
+ *
+ * The expression is evaluated at the first reference only, then the result
+ * is reused. It shall not be evaluated if no one references, thus, it does
+ * not break the short-circuit evaluation of AND/OR/CASE.
+ */
+#define PG_CSE_EVAL(label,expr)							\
+	((label##_done) ? (label) : ((label##_done) = true, (label) = (expr)))
+
 /*
  * Support routine for CASE x WHEN y then ... else ... end
  */
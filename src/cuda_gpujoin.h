@@ -37,7 +37,9 @@ typedef struct
 		cl_bool		is_nestloop;	/* true, if NestLoop. */
 		cl_bool		left_outer;		/* true, if JOIN_LEFT or JOIN_FULL */
 		cl_bool		right_outer;	/* true, if JOIN_RIGHT or JOIN_FULL */
-		cl_char		__padding__[5];
+		cl_bool		semi_join;		/* true, if JOIN_SEMI */
+		cl_bool		anti_join;		/* true, if JOIN_ANTI */
+		cl_char		__padding__[3];
 	} chunks[FLEXIBLE_ARRAY_MEMBER];
 } kern_multirels;
 
@@ -60,6 +62,12 @@ typedef struct
 #define KERN_MULTIRELS_RIGHT_OUTER_JOIN(kmrels, depth)	\
 	__ldg(&((kmrels)->chunks[(depth)-1].right_outer))
 
+#define KERN_MULTIRELS_SEMI_JOIN(kmrels, depth)			\
+	__ldg(&((kmrels)->chunks[(depth)-1].semi_join))
+
+#define KERN_MULTIRELS_ANTI_JOIN(kmrels, depth)			\
+	__ldg(&((kmrels)->chunks[(depth)-1].anti_join))
+
 /*
  * kern_gpujoin - control object of GpuJoin
  *
@@ -987,28 +995,34 @@ gpujoin_exec_nestloop(kern_context *kcxt,
 	if (y_unitsz * l_state[depth] >= kds_in->nitems)
 	{
 		/*
-		 * In case of LEFT OUTER JOIN, we need to check whether the outer
-		 * combination had any matched inner tuples, or not.
+		 * In case of LEFT OUTER, SEMI or ANTI JOIN, we need to check
+		 * whether the outer combination had any matched inner tuples,
+		 * or not. SEMI JOIN emits the matched one, and others emit the
+		 * unmatched one, at most once per outer combination.
 		 */
-		if (KERN_MULTIRELS_LEFT_OUTER_JOIN(kmrels, depth))
+		if (KERN_MULTIRELS_LEFT_OUTER_JOIN(kmrels, depth) ||
+			KERN_MULTIRELS_SEMI_JOIN(kmrels, depth) ||
+			KERN_MULTIRELS_ANTI_JOIN(kmrels, depth))
 		{
+			cl_bool		semi_join = KERN_MULTIRELS_SEMI_JOIN(kmrels, depth);
+
 			if (get_local_id() < x_unitsz)
 				matched_sync[get_local_id()] = false;
 			__syncthreads();
 			if (matched[depth])
 				matched_sync[x_index] = true;
-			if (__syncthreads_count(!matched_sync[x_index]) > 0)
+			if (__syncthreads_count(matched_sync[x_index] == semi_join) > 0)
 			{
 				if (y_index == 0 && y_index < y_unitsz)
-					result = !matched_sync[x_index];
+					result = (matched_sync[x_index] == semi_join);
 				else
 					result = false;
 				/* adjust x_index and rd_stack as usual */
 				x_index += read_pos[depth-1];
 				assert(x_index < write_pos[depth-1]);
 				rd_stack += (x_index * depth);
-				/* don't generate LEFT OUTER tuple any more */
-				matched[depth] = true;
+				/* don't generate LEFT OUTER/SEMI/ANTI tuple any more */
+				matched[depth] = !semi_join;
 				goto left_outer;
 			}
 		}
@@ -1042,6 +1056,10 @@ gpujoin_exec_nestloop(kern_context *kcxt,
 				matched[depth] = true;
 				if (oj_map && !oj_map[y_index])
 					oj_map[y_index] = true;
+				/* SEMI/ANTI JOIN emits nothing until end of the inner */
+				if (KERN_MULTIRELS_SEMI_JOIN(kmrels, depth) ||
+					KERN_MULTIRELS_ANTI_JOIN(kmrels, depth))
+					result = false;
 			}
 		}
 	}
@@ -1197,6 +1215,8 @@ gpujoin_exec_hashjoin(kern_context *kcxt,
 									&khitem->t.htup,
 									&joinquals_matched);
 		assert(result == joinquals_matched);
+		t_offset = __kds_packed((char *)&khitem->t.htup -
+								(char *)kds_hash);
 		if (joinquals_matched)
 		{
 			/* No LEFT/FULL JOIN are needed */
@@ -1205,15 +1225,26 @@ gpujoin_exec_hashjoin(kern_context *kcxt,
 			assert(khitem->rowid < kds_hash->nitems);
 			if (oj_map && !oj_map[khitem->rowid])
 				oj_map[khitem->rowid] = true;
+			/*
+			 * SEMI JOIN emits the outer row on the first match, and
+			 * ANTI JOIN never emits it. Both need not walk on the
+			 * hash-slot chain any more.
+			 */
+			if (KERN_MULTIRELS_SEMI_JOIN(kmrels, depth))
+				t_offset = UINT_MAX;
+			else if (KERN_MULTIRELS_ANTI_JOIN(kmrels, depth))
+			{
+				t_offset = UINT_MAX;
+				result = false;
+			}
 		}
-		t_offset = __kds_packed((char *)&khitem->t.htup -
-								(char *)kds_hash);
 	}
-	else if (KERN_MULTIRELS_LEFT_OUTER_JOIN(kmrels, depth) &&
+	else if ((KERN_MULTIRELS_LEFT_OUTER_JOIN(kmrels, depth) ||
+			  KERN_MULTIRELS_ANTI_JOIN(kmrels, depth)) &&
 			 l_state[depth] != UINT_MAX &&
 			 !matched[depth])
 	{
-		/* No matched outer rows, but LEFT/FULL OUTER */
+		/* No matched outer rows, but LEFT/FULL OUTER or ANTI */
 		result = true;
 	}
 	else
@@ -1232,10 +1263,14 @@ gpujoin_exec_hashjoin(kern_context *kcxt,
 	if (result)
 	{
 		memcpy(wr_stack, rd_stack, sizeof(cl_uint) * depth);
-		wr_stack[depth] = (!khitem ? 0U : t_offset);
+		/* SEMI/ANTI JOIN never references the inner columns */
+		wr_stack[depth] = (!khitem ||
+						   KERN_MULTIRELS_SEMI_JOIN(kmrels, depth) ||
+						   KERN_MULTIRELS_ANTI_JOIN(kmrels, depth)
+						   ? 0U : t_offset);
 	}
 	/* count number of threads still in-progress */
-	count = __syncthreads_count(khitem != NULL);
+	count = __syncthreads_count(t_offset != UINT_MAX);
 	if (get_local_id() == 0)
 		wip_count[depth] = count;
 	/* enough room exists on this depth? */
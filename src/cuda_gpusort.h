@@ -19,88 +19,96 @@
 #define CUDA_GPUSORT_H
 
 /*
- * gpuscan_quals_eval_column - evaluation of device qualifier
+ * kern_gpusort
+ *
+ * GpuSort sorts rows of a KDS_FORMAT_ROW chunk; the result is an array of
+ * row indexes in the sorted order, so the chunk itself is never moved.
  */
-STATIC_FUNCTION(cl_bool)
-gpuscan_quals_eval_column(kern_context *kcxt,
-						  kern_data_store *kds,
-						  cl_uint src_index);
+struct kern_gpusort {
+	kern_errorbuf	kerror;
+	cl_uint			nitems;			/* number of rows to be sorted */
+	kern_parambuf	kparams;
+	/* <-- cl_uint results[nitems] --> */
+};
+typedef struct kern_gpusort		kern_gpusort;
+
+#define KERN_GPUSORT_PARAMBUF(kgpusort)			\
+	((kern_parambuf *)(&(kgpusort)->kparams))
+#define KERN_GPUSORT_PARAMBUF_LENGTH(kgpusort)	\
+	STROMALIGN((kgpusort)->kparams.length)
+#define KERN_GPUSORT_RESULT_INDEX(kgpusort)		\
+	((cl_uint *)((char *)KERN_GPUSORT_PARAMBUF(kgpusort) +	\
+				 KERN_GPUSORT_PARAMBUF_LENGTH(kgpusort)))
+#define KERN_GPUSORT_DMASEND_LENGTH(kgpusort)	\
+	(offsetof(kern_gpusort, kparams) +			\
+	 KERN_GPUSORT_PARAMBUF_LENGTH(kgpusort))
+
 /*
- * gpuscan_projection_column
+ * Number of row indexes sorted by a thread-block at once; it consumes
+ * 32kB of shared memory.
  */
-STATIC_FUNCTION(void)
-gpuscan_projection_column(kern_context *kcxt,
-                          kern_data_store *kds_src,
-                          size_t src_index,
-                          Datum *tup_values,
-                          cl_bool *tup_isnull);
+#define BITONIC_MAX_LOCAL_SHIFT		13
+#define BITONIC_MAX_LOCAL_SZ		(1<<BITONIC_MAX_LOCAL_SHIFT)
+
+#ifdef __CUDACC__
 /*
- * gpusort_keycomp - comparison of two keys for sorting
+ * gpusort_keycomp - comparison of two rows by the sort keys
+ *
+ * It returns a negative value if x is prior to y, a positive value if y is
+ * prior to x, or zero if both rows have equivalent keys.
+ * (auto generated function)
  */
 STATIC_FUNCTION(cl_int)
-gpustore_keycomp(kern_context *kcxt,
-				 kern_data_store *kds_column,
-				 cl_uint x_index,
-				 cl_uint y_index);
+gpusort_keycomp(kern_context *kcxt,
+				kern_data_store *kds_src,
+				cl_uint x_index,
+				cl_uint y_index);
+
 /*
- *
+ * gpusort_setup_index - initialization of the result index
  */
 KERNEL_FUNCTION(void)
-gpusort_setup_index(kern_gpuscan *kgpuscan,
+gpusort_setup_index(kern_gpusort *kgpusort,
 					kern_data_store *kds_src)
 {
-	gpuscanResultIndex *gs_results = KERN_GPUSCAN_RESULT_INDEX(kgpuscan);
-	kern_context	kcxt;
-	cl_uint			base;
-	__shared__ cl_uint pos;
+	cl_uint	   *results = KERN_GPUSORT_RESULT_INDEX(kgpusort);
+	cl_uint		index;
 
-	INIT_KERNEL_CONTEXT(&kcxt, gpusort_setup_index, &kgpuscan->kparams);
-	for (base = get_global_base();
-		 base < kds_src->nitems;
-		 base += get_global_size())
+	assert(kds_src->format == KDS_FORMAT_ROW);
+	for (index = get_global_id();
+		 index < kgpusort->nitems;
+		 index += get_global_size())
 	{
-		cl_uint		index = base + get_local_id();
-		cl_uint		offset;
-		cl_uint		count;
-		cl_bool		retval;
-
-		retval = gpuscan_quals_eval_column(&kcxt, kds_src, index);
-		/* bailout if any error */
-		if (__syncthreads_count(kcxt.e.errcode) > 0)
-			break;
-		offset = pgstromStairlikeSum(retval ? 1 : 0, &count);
-		if (get_local_id() == 0 && count > 0)
-			pos = atomicAdd(&gs_results->nitems, count);
-		__syncthreads();
-		if (retval)
-			gs_results->results[pos + offset] = index;
-		__syncthreads();
+		results[index] = index;
 	}
-	kern_writeback_error_status(&kgpuscan->kerror, &kcxt.e);
 }
 
-#define BITONIC_MAX_LOCAL_SHIFT		13
-#define BITONIC_MAX_LOCAL_SZ		(1<<13)
-
+/*
+ * gpusort_bitonic_local
+ *
+ * It sorts every BITONIC_MAX_LOCAL_SZ items on the shared memory. Each unit
+ * begins with a reversed comparison, so the rest of the unit beyond the
+ * @nitems can be considered as infinite, and simply skipped.
+ */
 KERNEL_FUNCTION_MAXTHREADS(void)
-gpusort_bitonic_local(kern_gpuscan *kgpuscan,
+gpusort_bitonic_local(kern_gpusort *kgpusort,
 					  kern_data_store *kds_src)
 {
-	gpuscanResultIndex *gs_results = KERN_GPUSCAN_RESULT_INDEX(kgpuscan);
-	kern_context	kcxt;
-	cl_uint			localLimit;
-	cl_uint			nitems = gs_results->nitems;
-	cl_uint			partSize = 2 * BITONIC_MAX_LOCAL_SZ;
-	cl_uint			partBase = get_global_index() * partSize;
-	cl_uint			blockSize;
-	cl_uint			unitSize;
-	cl_uint			i;
+	cl_uint	   *results = KERN_GPUSORT_RESULT_INDEX(kgpusort);
+	kern_context kcxt;
+	cl_uint		nitems = kgpusort->nitems;
+	cl_uint		partSize = BITONIC_MAX_LOCAL_SZ;
+	cl_uint		partBase = get_group_id() * partSize;
+	cl_uint		localLimit;
+	cl_uint		blockSize;
+	cl_uint		unitSize;
+	cl_uint		i;
 	__shared__ cl_uint localIdx[BITONIC_MAX_LOCAL_SZ];		/* 32kB */
 
 	/* quick bailout if any error happen in the prior kernel */
-	if (__syncthreads_count(kgpuscan->kerror.errcode) != 0)
+	if (__syncthreads_count(kgpusort->kerror.errcode) != 0)
 		return;
-	INIT_KERNEL_CONTEXT(&kcxt, gpusort_bitonic_local, &kgpuscan->kparams);
+	INIT_KERNEL_CONTEXT(&kcxt, gpusort_bitonic_local, &kgpusort->kparams);
 
 	/* Load index to localIdx[] */
 	if (partBase + partSize <= nitems)
@@ -111,7 +119,7 @@ gpusort_bitonic_local(kern_gpuscan *kgpuscan,
 		return;		/* too much thread-blocks are launched? */
 
 	for (i = get_local_id(); i < localLimit; i += get_local_size())
-		localIdx[i] = gs_results->results[partBase + i];
+		localIdx[i] = results[partBase + i];
 	__syncthreads();
 
 	for (blockSize = 2; blockSize <= partSize; blockSize *= 2)
@@ -126,11 +134,11 @@ gpusort_bitonic_local(kern_gpuscan *kgpuscan,
 			cl_uint		idx0, idx1;
 
 			for (localId = get_local_id();
-				 localId < partSize;
+				 localId < partSize / 2;
 				 localId += get_local_size())
 			{
-				idx0 = (((localId  & ~halfUnitMask) << 1) +
-						 (localId  &  halfUnitMask));
+				idx0 = (((localId & ~halfUnitMask) << 1) +
+						 (localId &  halfUnitMask));
 				idx1 = (reversing
 						? ((idx0 & ~unitMask) | (~idx0 & unitMask))
 						: (halfUnitSize + idx0));
@@ -139,7 +147,7 @@ gpusort_bitonic_local(kern_gpuscan *kgpuscan,
 					cl_uint		pos0 = localIdx[idx0];
 					cl_uint		pos1 = localIdx[idx1];
 
-					if (gpustore_keycomp(&kcxt, kds_src, pos0, pos1) > 0)
+					if (gpusort_keycomp(&kcxt, kds_src, pos0, pos1) > 0)
 					{
 						/* swap */
 						localIdx[idx0] = pos1;
@@ -152,71 +160,88 @@ gpusort_bitonic_local(kern_gpuscan *kgpuscan,
 	}
 	/* Store index on localIdx[] */
 	for (i = get_local_id(); i < localLimit; i += get_local_size())
-		gs_results->results[partBase + i] = localIdx[i];
+		results[partBase + i] = localIdx[i];
 	__syncthreads();
 	/* any errors on run-time? */
-	kern_writeback_error_status(&kgstore->kerror, &kcxt.e);
+	kern_writeback_error_status(&kgpusort->kerror, &kcxt.e);
 }
 
+/*
+ * gpusort_bitonic_step
+ *
+ * A step of comparison between items more distant than BITONIC_MAX_LOCAL_SZ
+ * on the device memory.
+ */
 KERNEL_FUNCTION_MAXTHREADS(void)
-gpustore_bitonic_step(kern_gpustore *kgpuscan,
-					  kern_data_store *kds_src,
-					  cl_uint unitsz,
-					  cl_bool reversing)
+gpusort_bitonic_step(kern_gpusort *kgpusort,
+					 kern_data_store *kds_src,
+					 cl_uint unitSize,
+					 cl_bool reversing)
 {
-	gpuscanResultIndex *gs_results = KERN_GPUSCAN_RESULT_INDEX(kgpuscan);
-	kern_context	kcxt;
-	cl_uint			nitems = gs_results->nitems;
-	cl_uint			halfUnitSize = unitsz >> 1;
-	cl_uint			halfUnitMask = halfUnitSize - 1;
-	cl_uint			unitMask = unitsz - 1;
-	cl_uint			idx0, idx1;
-	cl_uint			pos0, pos1;
-	cl_uint			index;
+	cl_uint	   *results = KERN_GPUSORT_RESULT_INDEX(kgpusort);
+	kern_context kcxt;
+	cl_uint		nitems = kgpusort->nitems;
+	cl_uint		halfUnitSize = (unitSize >> 1);
+	cl_uint		halfUnitMask = (halfUnitSize - 1);
+	cl_uint		unitMask = (unitSize - 1);
+	cl_uint		idx0, idx1;
+	cl_uint		pos0, pos1;
+	cl_uint		index;
 
 	/* quick bailout if any error happen in the prior kernel */
-	if (__syncthreads_count(kgpuscan->kerror.errcode) != 0)
+	if (__syncthreads_count(kgpusort->kerror.errcode) != 0)
 		return;
-	INIT_KERNEL_CONTEXT(&kcxt, gpustore_bitonic_step, &kgstore->kparams);
+	INIT_KERNEL_CONTEXT(&kcxt, gpusort_bitonic_step, &kgpusort->kparams);
 
-	idx0 = (((get_global_id() & ~halfUnitMask) << 1)
-			+ (get_global_id() & halfUnitMask));
-	idx1 = (reversing
-			? ((idx0 & ~unitMask) | (~idx0 & unitMask))
-			: (idx0 + halfUnitSize));
-	if (idx1 < nitems)
+	for (index = get_global_id();
+		 index < nitems;
+		 index += get_global_size())
 	{
-		pos0 = gs_results->results[idx0];
-		pos1 = gs_results->results[idx1];
-        if (gpusort_keycomp(&kcxt, kds_slot, pos0, pos1) > 0)
-        {
-            /* swap */
-            gs_results->results[idx0] = pos1;
-			gs_results->results[idx1] = pos0;
-        }
-    }
-	kern_writeback_error_status(&kgstore->kerror);
+		idx0 = (((index & ~halfUnitMask) << 1) +
+				 (index &  halfUnitMask));
+		idx1 = (reversing
+				? ((idx0 & ~unitMask) | (~idx0 & unitMask))
+				: (halfUnitSize + idx0));
+		if (idx1 < nitems)
+		{
+			pos0 = results[idx0];
+			pos1 = results[idx1];
+			if (gpusort_keycomp(&kcxt, kds_src, pos0, pos1) > 0)
+			{
+				/* swap */
+				results[idx0] = pos1;
+				results[idx1] = pos0;
+			}
+		}
+	}
+	kern_writeback_error_status(&kgpusort->kerror, &kcxt.e);
 }
 
+/*
+ * gpusort_bitonic_merge
+ *
+ * The last steps of merging bitonic sequences; comparison between items
+ * within BITONIC_MAX_LOCAL_SZ on the shared memory.
+ */
 KERNEL_FUNCTION_MAXTHREADS(void)
-gpusort_bitonic_merge(kern_gpustore *kgstore,
+gpusort_bitonic_merge(kern_gpusort *kgpusort,
 					  kern_data_store *kds_src)
 {
-	gpuscanResultIndex *gs_results = KERN_GPUSCAN_RESULT_INDEX(kgpuscan);
-	kern_context	kcxt;
-	cl_uint			localLimit;
-	cl_uint			nitems = gs_results->nitems;
-	cl_uint			partSize = 2 * BITONIC_MAX_LOCAL_SZ;
-	cl_uint			partBase = get_global_index() * partSize;
-	cl_uint			blockSize = partSize;
-	cl_uint			unitSize;
-	cl_uint			i;
+	cl_uint	   *results = KERN_GPUSORT_RESULT_INDEX(kgpusort);
+	kern_context kcxt;
+	cl_uint		nitems = kgpusort->nitems;
+	cl_uint		partSize = BITONIC_MAX_LOCAL_SZ;
+	cl_uint		partBase = get_group_id() * partSize;
+	cl_uint		localLimit;
+	cl_uint		unitSize;
+	cl_uint		i;
 	__shared__ cl_uint localIdx[BITONIC_MAX_LOCAL_SZ];		/* 32kB */
 
 	/* quick bailout if any error happen in the prior kernel */
-	if (__syncthreads_count(kgpuscan->kerror.errcode) != 0)
+	if (__syncthreads_count(kgpusort->kerror.errcode) != 0)
 		return;
-	INIT_KERNEL_CONTEXT(&kcxt, gpusort_bitonic_merge, &kgpuscan->kparams);
+	INIT_KERNEL_CONTEXT(&kcxt, gpusort_bitonic_merge, &kgpusort->kparams);
+
 	/* Load index to localIdx[] */
 	if (partBase + partSize <= nitems)
 		localLimit = partSize;
@@ -225,11 +250,11 @@ gpusort_bitonic_merge(kern_gpustore *kgstore,
 	else
 		return;		/* out of range */
 	for (i = get_local_id(); i < localLimit; i += get_local_size())
-		localIdx[i] = gs_results->results[partBase + i];
+		localIdx[i] = results[partBase + i];
 	__syncthreads();
 
 	/* merge two sorted blocks */
-	for (unitSize = blockSize; unitSize >= 2; unitSize >>= 1)
+	for (unitSize = partSize; unitSize >= 2; unitSize >>= 1)
 	{
 		cl_uint		halfUnitSize = (unitSize >> 1);
 		cl_uint		halfUnitMask = (halfUnitSize - 1);
@@ -237,11 +262,11 @@ gpusort_bitonic_merge(kern_gpustore *kgstore,
 		cl_uint		localId;
 
 		for (localId = get_local_id();
-			 localId < BITONIC_MAX_LOCAL_SZ;
+			 localId < partSize / 2;
 			 localId += get_local_size())
 		{
-			idx0 = (((localId & ~halfUnitMask) << 1)
-					+ (localId & halfUnitMask));
+			idx0 = (((localId & ~halfUnitMask) << 1) +
+					 (localId &  halfUnitMask));
 			idx1 = halfUnitSize + idx0;
 			if (idx1 < localLimit)
 			{
@@ -250,6 +275,7 @@ gpusort_bitonic_merge(kern_gpustore *kgstore,
 
 				if (gpusort_keycomp(&kcxt, kds_src, pos0, pos1) > 0)
 				{
+					/* swap */
 					localIdx[idx0] = pos1;
 					localIdx[idx1] = pos0;
 				}
@@ -259,132 +285,10 @@ gpusort_bitonic_merge(kern_gpustore *kgstore,
 	}
 	/* Store index from localIdx[] */
 	for (i = get_local_id(); i < localLimit; i += get_local_size())
-		gs_results->results[partBase + i] = localIdx[i];
+		results[partBase + i] = localIdx[i];
 	__syncthreads();
-	/* any error status? */
-	kern_writeback_error_status(&kgstore->kerror);
-}
-
-
-KERNEL_FUNCTION(void)
-gpusort_projection(kern_gpuscan *kgpuscan,
-				   kern_data_store *kds_src,
-				   kern_data_store *kds_dst)
-{
-	gpuscanResultIndex *gs_results = KERN_GPUSCAN_RESULT_INDEX(kgpuscan);
-	gpuscanSuspendContext *my_suspend
-		= KERN_GPUSCAN_SUSPEND_CONTEXT(kgpuscan, get_group_id());
-	kern_context	kcxt;
-	cl_uint			part_index = 0;
-	cl_uint			base;
-	cl_uint			index;
-	cl_uint			required;
-#if GPUSTORE_DEVICE_PROJECTION_NFIELDS > 0
-	Datum			tup_values[GPUSTORE_DEVICE_PROJECTION_NFIELDS];
-	cl_bool			tup_isnull[GPUSTORE_DEVICE_PROJECTION_NFIELDS];
-#else
-	Datum		   *tup_values = NULL;
-	cl_bool		   *tup_isnull = NULL;
-#endif
-	__shared__ cl_uint pos;
-
-	/* quick bailout if any error happen in the prior kernel */
-	if (__syncthreads_count(kgstore->kerror.errcode) != 0)
-		return;
-	INIT_KERNEL_CONTEXT(&kcxt, gpustore_projection, &kgstore->kparams);
-	/* resume kernel from the point where suspended, if any */
-	if (kgstore->resume_context)
-	{
-		assert(my_suspend != NULL);
-		part_index = my_suspend->part_index;
-	}
-
-	for (base = get_global_base() + part_index * get_global_size();
-		 base < gs_results->nitems;
-		 base += get_global_size(), part_index++)
-	{
-		if (base + get_local_id() < gs_results->nitems)
-		{
-			index = gs_results->results[base + get_local_id()];
-			assert(index < kds_src->nitems);
-			gpustore_projection(&kcxt,
-								kds_src,
-								index,
-								tup_values,
-								tup_isnull);
-			required = MAXALIGN(offsetof(kern_tupitem, htup) +
-								compute_heaptuple_size(&kcxt,
-													   kds_dst,
-													   tup_values,
-													   tup_isnull));
-		}
-		else
-			required = 0;
-
-		usage_offset = pgstromStairlikeSum(required, &extra_sz);
-		if (get_local_id() == 0)
-		{
-			union {
-				struct {
-					cl_uint		nitems;
-					cl_uint		usage;
-				} i;
-				cl_ulong		v64;
-			} oldval, curval, newval;
-
-			nvalids = Min(gs_results->nitems - base, get_local_size());
-
-			curval.i.nitems = kds_dst->nitems;
-            curval.i.usage  = kds_dst->usage;
-			do {
-				newval = oldval = curval;
-				newval.i.nitems += nvalids;
-				newval.i.usage  += __kds_packed(extra_sz);
-
-				if (KERN_DATA_STORE_HEAD_LENGTH(kds_dst) +
-					STROMALIGN(sizeof(cl_uint) * newval.i.nitems) +
-					__kds_unpack(newval.i.usage) > kds_dst->length)
-				{
-					atomicAdd(&kgstore->suspend_count, 1);
-					suspend_kernel = 1;
-					break;
-				}
-			} while ((curval.v64 = atomicCAS((cl_ulong *)&kds_dst->nitems,
-											 oldval.v64,
-											 newval.v64)) != oldval.v64);
-			nitems_base = oldval.i.nitems;
-			usage_base = __kds_unpack(oldval.i.usage);
-		}
-		if (__syncthreads_count(suspend_kernel) > 0)
-			break;
-
-		/* store the result heap-tuple on the destination buffer */
-		if (required > 0)
-		{
-			cl_uint	   *dst_index = KERN_DATA_STORE_ROWINDEX(kds_dst);
-			size_t		pos;
-
-			pos = kds_dst->length - (usage_base + usage_offset + required);
-			dst_index[nitems_base + nitems_offset] = __kds_packed(pos);
-			form_kern_heaptuple((kern_tupitem *)((char *)kds_dst + pos),
-								kds_dst->ncols,
-								kds_dst->colmeta,
-								NULL,	/* ItemPointerData */
-								NULL,	/* HeapTupleFields */
-								kds_dst->tdhasoid ? kds_dst->table_oid : 0,
-								tup_values,
-								tup_isnull);
-		}
-		/* bailout if any error */
-		if (__syncthreads_count(kcxt.e.errcode) > 0)
-			break;
-	}
-	/* suspend the current position (even if normal exit) */
-	if (my_suspend && get_local_id() == 0)
-	{
-		my_suspend->part_index = part_index;
-	}
-	kern_writeback_error_status(&kgpuscan->kerror, &kcxt.e);
+	/* any errors on run-time? */
+	kern_writeback_error_status(&kgpusort->kerror, &kcxt.e);
 }
-
-#endif	/* CUDA_GSTORE_H */
+#endif	/* __CUDACC__ */
+#endif	/* CUDA_GPUSORT_H */
@@ -206,6 +206,40 @@ PG_SCALAR_ARRAY_OP(kern_context *kcxt,
 	return result;
 }
 
+/*
+ * Support routine for ScalarArrayOpExpr on a large constant array; its
+ * elements are already built into kern_hashset on the host side, so we
+ * can probe the scalar value in O(1), instead of the linear search.
+ */
+template <typename ScalarType>
+STATIC_FUNCTION(pg_bool_t)
+PG_SCALAR_ARRAY_HASH(kern_context *kcxt,
+					 ScalarType scalar,
+					 pg_bytea_t hashset)
+{
+	kern_hashset *hset;
+	pg_bool_t	result;
+
+	result.isnull = false;
+	result.value = false;
+	if (hashset.isnull)
+	{
+		result.isnull = true;
+		return result;
+	}
+	hset = (kern_hashset *) hashset.value;
+	if (hset->nitems == 0 && !hset->has_null)
+		return result;		/* empty array */
+	if (scalar.isnull)
+		result.isnull = true;
+	else if (kern_hashset_lookup(hset, (cl_long) scalar.value))
+		result.value = true;
+	else if (hset->has_null)
+		result.isnull = true;
+
+	return result;
+}
+
 /* ----------------------------------------------------------------
  *
  * MATRIX data type support
@@ -60,6 +60,13 @@ typedef struct
 #define CUDA_PROGRAM_BUILD_FAILURE			((void *)(~0UL))
 
 #define PGCACHE_HASH_SIZE	960
+#define PGCACHE_MIN_VARLENA_BUFSZ	256
+#define PGCACHE_MAX_VARLENA_BUFSZ	((uint64) MaxAllocSize)
+#define PGCACHE_FILE_MAGIC	0x50544350		/* 'PCTP' */
+#define PGCACHE_FILE_SUFFIX	".ptx"
+#define PGCACHE_FILE_PTX_IMAGE(pfile)					\
+	((char *)(pfile) + sizeof(program_cache_file) +		\
+	 (pfile)->kern_deflen + (pfile)->kern_srclen)
 #define WORDNUM(x)			((x) / BITS_PER_BITMAPWORD)
 #define BITNUM(x)			((x) % BITS_PER_BITMAPWORD)
 
@@ -73,6 +80,11 @@ typedef struct
 	dlist_head	build_list;		/* build pending list */
 	dlist_head	addr_list;
 	dlist_head	free_list[PGCACHE_CHUNKSZ_MAX_BIT + 1];
+	/* statistics of the program cache */
+	pg_atomic_uint64 num_lookups;	/* # of pgstrom_create_cuda_program */
+	pg_atomic_uint64 num_hits;		/* # of lookups hit on the cache */
+	pg_atomic_uint64 num_file_loads;/* # of binaries loaded from the file */
+	pg_atomic_uint64 num_builds;	/* # of NVRTC invocations */
 	char		base[FLEXIBLE_ARRAY_MEMBER];
 } program_cache_head;
 
@@ -84,9 +96,33 @@ typedef struct
 	} builders[FLEXIBLE_ARRAY_MEMBER];
 } program_builder_state;
 
+/*
+ * program_cache_file - header of the CUDA binary file stored on the
+ * pg_strom.program_cache_directory. Its filename is consists of the same
+ * crc, target_cc and extra_flags of program_cache_entry, then kern_define,
+ * kern_source and ptx_image follow the header.
+ */
+typedef struct
+{
+	cl_uint			magic;			/* PGCACHE_FILE_MAGIC */
+	pg_crc32		headers_crc;	/* crc of the installed cuda_*.h files */
+	cl_int			nvrtc_version;	/* major * 1000 + minor */
+	pg_crc32		crc;
+	cl_int			target_cc;
+	cl_uint			extra_flags;
+	cl_uint			varlena_bufsz;
+	pg_crc32		ptx_crc;
+	cl_ulong		kern_deflen;
+	cl_ulong		kern_srclen;
+	cl_ulong		ptx_length;
+} program_cache_file;
+
 /* ---- GUC variables ---- */
 static int		program_cache_size_kb;
+static char	   *program_cache_directory;
+static int		program_cache_disk_size_kb;
 static int		num_program_builders;
+static bool		program_cache_share_literals;
 static bool		pgstrom_debug_jit_compile_options;
 
 /* ---- static variables ---- */
@@ -99,11 +135,17 @@ static program_builder_state *pgbuilder_state = NULL;
 #undef PGSTROM_CUDA
 
 static bool		cuda_program_builder_got_signal = false;
+static bool		cuda_headers_crc_ready = false;
+static pg_crc32	cuda_headers_crc;
 
 /* ---- forward declarations ---- */
 static void put_cuda_program_entry_nolock(program_cache_entry *entry);
 void cudaProgramBuilderMain(Datum arg);
 static void cudaProgramBuilderWakeUp(bool error_if_no_builders);
+Datum pgstrom_program_cache_info(PG_FUNCTION_ARGS);
+Datum pgstrom_program_cache_file_save(PG_FUNCTION_ARGS);
+Datum pgstrom_program_cache_file_load(PG_FUNCTION_ARGS);
+Datum pgstrom_program_cache_file_evict(PG_FUNCTION_ARGS);
 
 /*
  * lookup_cuda_program_entry_nolock - lookup a program_cache_entry by the
@@ -472,6 +514,10 @@ construct_flat_cuda_source(cl_uint extra_flags,
 	if (extra_flags & DEVKERNEL_NEEDS_GPUPREAGG)
 		ofs += snprintf(source + ofs, len - ofs,
 						"#include \"cuda_gpupreagg.h\"\n");
+	/* GpuSort */
+	if (extra_flags & DEVKERNEL_NEEDS_GPUSORT)
+		ofs += snprintf(source + ofs, len - ofs,
+						"#include \"cuda_gpusort.h\"\n");
 	/* automatically generated portion */
 	ofs += snprintf(source + ofs, len - ofs, "%s\n", kern_source);
 	/* code to be included at the last */
@@ -717,6 +763,503 @@ pgstrom_cuda_binary_file(ProgramId program_id)
 	return pstrdup(tempfilepath);
 }
 
+/*
+ * setup_cuda_program_binary
+ *
+ * It allocates a new entry to keep ptx_image and build log, then replaces
+ * the src_entry (build in-progress) by the new one.
+ */
+static program_cache_entry *
+setup_cuda_program_binary(program_cache_entry *src_entry,
+						  cl_uint varlena_bufsz,
+						  const char *ptx_image, size_t ptx_length,
+						  const char *message_fmt,
+						  const char *build_log,
+						  const char *build_source)
+{
+	program_cache_entry *bin_entry;
+	int			pindex;
+	int			hindex;
+	size_t		offset;
+	size_t		length;
+
+	length = (MAXALIGN(src_entry->kern_deflen + 1) +
+			  MAXALIGN(src_entry->kern_srclen + 1) +
+			  MAXALIGN(ptx_length + 1) +
+			  MAXALIGN(strlen(build_log) + 1) +
+			  PGCACHE_MIN_ERRORMSG_BUFSIZE);
+	SpinLockAcquire(&pgcache_head->lock);
+	bin_entry = create_cuda_program_entry_nolock(length);
+	if (!bin_entry)
+	{
+		SpinLockRelease(&pgcache_head->lock);
+		werror("out of CUDA program cache");
+	}
+	offset = 0;
+	bin_entry->program_id		= src_entry->program_id;
+	bin_entry->crc				= src_entry->crc;
+	bin_entry->target_cc        = src_entry->target_cc;
+	bin_entry->extra_flags		= src_entry->extra_flags;
+	bin_entry->varlena_bufsz	= varlena_bufsz;
+	bin_entry->kern_deflen		= src_entry->kern_deflen;
+	bin_entry->kern_define		= bin_entry->data + offset;
+	strcpy(bin_entry->kern_define, src_entry->kern_define);
+	offset += MAXALIGN(bin_entry->kern_deflen + 1);
+
+	bin_entry->kern_srclen		= src_entry->kern_srclen;
+	bin_entry->kern_source		= bin_entry->data + offset;
+	strcpy(bin_entry->kern_source, src_entry->kern_source);
+	offset += MAXALIGN(bin_entry->kern_srclen + 1);
+
+	if (!ptx_image)
+		bin_entry->ptx_image	= CUDA_PROGRAM_BUILD_FAILURE;
+	else
+	{
+		pg_crc32	ptx_crc;
+
+		bin_entry->ptx_image	= bin_entry->data + offset;
+		bin_entry->ptx_length	= ptx_length;
+		memcpy(bin_entry->ptx_image, ptx_image, ptx_length);
+		offset += MAXALIGN(ptx_length);
+
+		INIT_LEGACY_CRC32(ptx_crc);
+		COMP_LEGACY_CRC32(ptx_crc, ptx_image, ptx_length);
+		FIN_LEGACY_CRC32(ptx_crc);
+		bin_entry->ptx_crc		= ptx_crc;
+	}
+	bin_entry->error_msg		= bin_entry->data + offset;
+	snprintf(bin_entry->error_msg, length - offset,
+			 message_fmt, build_log, build_source);
+
+	/* OK, bin_entry was built */
+	pindex = bin_entry->program_id % PGCACHE_HASH_SIZE;
+	hindex = bin_entry->crc % PGCACHE_HASH_SIZE;
+	dlist_push_head(&pgcache_head->pgid_slots[pindex],
+					&bin_entry->pgid_chain);
+	dlist_push_head(&pgcache_head->hash_slots[hindex],
+					&bin_entry->hash_chain);
+	dlist_push_head(&pgcache_head->lru_list,
+					&bin_entry->lru_chain);
+	memset(&bin_entry->build_chain, 0, sizeof(dlist_node));
+	bin_entry->refcnt = src_entry->refcnt;
+	/* release src_entry */
+	src_entry->refcnt = 0;
+	dlist_delete(&src_entry->pgid_chain);
+	dlist_delete(&src_entry->hash_chain);
+	dlist_delete(&src_entry->lru_chain);
+	memset(&src_entry->pgid_chain, 0, sizeof(dlist_node));
+	memset(&src_entry->hash_chain, 0, sizeof(dlist_node));
+	memset(&src_entry->lru_chain, 0, sizeof(dlist_node));
+	put_cuda_program_entry_nolock(src_entry);
+	SpinLockRelease(&pgcache_head->lock);
+
+	return bin_entry;
+}
+
+/*
+ * get_cuda_headers_crc
+ *
+ * It returns crc of the installed cuda_*.h files. Binaries built on the
+ * different set of the headers (e.g, by version up) shall not be reused.
+ */
+static pg_crc32
+get_cuda_headers_crc(void)
+{
+	pg_crc32	crc;
+	char		buffer[8192];
+	FILE	   *filp;
+	size_t		nbytes;
+
+	if (cuda_headers_crc_ready)
+		return cuda_headers_crc;
+
+	INIT_LEGACY_CRC32(crc);
+#define PGSTROM_CUDA(x)											\
+	filp = fopen(pgstrom_cuda_##x##_pathname, "rb");			\
+	if (filp)													\
+	{															\
+		while ((nbytes = fread(buffer, 1, sizeof(buffer), filp)) > 0) \
+			COMP_LEGACY_CRC32(crc, buffer, nbytes);				\
+		fclose(filp);											\
+	}
+#include "cuda_filelist"
+#undef PGSTROM_CUDA
+	FIN_LEGACY_CRC32(crc);
+
+	cuda_headers_crc = crc;
+	pg_memory_barrier();
+	cuda_headers_crc_ready = true;
+
+	return crc;
+}
+
+/*
+ * get_nvrtc_version - version of NVRTC that builds the binary
+ */
+static cl_int
+get_nvrtc_version(void)
+{
+	int			major;
+	int			minor;
+
+	if (nvrtcVersion(&major, &minor) != NVRTC_SUCCESS)
+		return -1;
+	return major * 1000 + minor;
+}
+
+/*
+ * compute_cuda_program_crc - hash value of the program cache entry
+ */
+static pg_crc32
+compute_cuda_program_crc(cl_int target_cc, cl_uint extra_flags,
+						 const char *kern_source, size_t kern_srclen,
+						 const char *kern_define, size_t kern_deflen)
+{
+	pg_crc32	crc;
+
+	INIT_LEGACY_CRC32(crc);
+	COMP_LEGACY_CRC32(crc, &target_cc, sizeof(cl_int));
+	COMP_LEGACY_CRC32(crc, &extra_flags, sizeof(int32));
+	COMP_LEGACY_CRC32(crc, kern_source, kern_srclen);
+	COMP_LEGACY_CRC32(crc, kern_define, kern_deflen);
+	FIN_LEGACY_CRC32(crc);
+
+	return crc;
+}
+
+/*
+ * program_cache_file_enabled - persistent program cache is enabled?
+ */
+static inline bool
+program_cache_file_enabled(void)
+{
+	return (program_cache_directory != NULL &&
+			program_cache_directory[0] != '\0' &&
+			program_cache_disk_size_kb > 0);
+}
+
+/*
+ * program_cache_file_name
+ *
+ * It makes a filename of the program cache, on the content-addressed
+ * directory by the same crc of program_cache_entry.
+ */
+static void
+program_cache_file_name(char *fname, size_t fname_sz, const char *dirname,
+						pg_crc32 crc, cl_int target_cc, cl_uint extra_flags)
+{
+	snprintf(fname, fname_sz, "%s/%08x-%d-%08x" PGCACHE_FILE_SUFFIX,
+			 dirname, crc, target_cc, extra_flags);
+}
+
+/*
+ * read_cuda_program_file
+ *
+ * It reads the CUDA binary file, then returns the buffer (to be released
+ * by the caller) only if it is built from the identical program by the
+ * current headers and compiler, and it is not corrupted.
+ */
+static program_cache_file *
+read_cuda_program_file(const char *fname, program_cache_entry *src_entry)
+{
+	program_cache_file *pfile;
+	char	   *buffer = NULL;
+	char	   *kern_define;
+	char	   *kern_source;
+	int			fdesc;
+	struct stat	st_buf;
+	ssize_t		nbytes;
+	pg_crc32	ptx_crc;
+
+	fdesc = open(fname, O_RDONLY);
+	if (fdesc < 0)
+	{
+		if (errno != ENOENT)
+			wlog("failed to open \"%s\": %m", fname);
+		return NULL;
+	}
+	if (fstat(fdesc, &st_buf) != 0 ||
+		st_buf.st_size < sizeof(program_cache_file))
+		goto bailout;
+	buffer = malloc(st_buf.st_size);
+	if (!buffer)
+		goto bailout;
+	nbytes = read(fdesc, buffer, st_buf.st_size);
+	if (nbytes != st_buf.st_size)
+	{
+		wlog("failed on read(\"%s\"): %m", fname);
+		goto bailout;
+	}
+
+	/* Is it the identical program? */
+	pfile = (program_cache_file *) buffer;
+	if (pfile->magic != PGCACHE_FILE_MAGIC ||
+		pfile->headers_crc != get_cuda_headers_crc() ||
+		pfile->nvrtc_version != get_nvrtc_version() ||
+		pfile->crc != src_entry->crc ||
+		pfile->target_cc != src_entry->target_cc ||
+		pfile->extra_flags != src_entry->extra_flags ||
+		pfile->varlena_bufsz < src_entry->varlena_bufsz ||
+		pfile->kern_deflen != src_entry->kern_deflen ||
+		pfile->kern_srclen != src_entry->kern_srclen ||
+		sizeof(program_cache_file) + pfile->kern_deflen +
+		pfile->kern_srclen + pfile->ptx_length != st_buf.st_size)
+		goto bailout;
+	kern_define = buffer + sizeof(program_cache_file);
+	kern_source = kern_define + pfile->kern_deflen;
+	if (memcmp(kern_define, src_entry->kern_define,
+			   pfile->kern_deflen) != 0 ||
+		memcmp(kern_source, src_entry->kern_source,
+			   pfile->kern_srclen) != 0)
+		goto bailout;
+	/* Is the binary image not corrupted? */
+	INIT_LEGACY_CRC32(ptx_crc);
+	COMP_LEGACY_CRC32(ptx_crc, PGCACHE_FILE_PTX_IMAGE(pfile),
+					  pfile->ptx_length);
+	FIN_LEGACY_CRC32(ptx_crc);
+	if (pfile->ptx_crc != ptx_crc)
+	{
+		wlog("CUDA binary \"%s\" looks corrupted", fname);
+		goto bailout;
+	}
+	/* mark it recently used, for LRU eviction */
+	if (utime(fname, NULL) != 0)
+		wlog("failed on utime(\"%s\"): %m", fname);
+	close(fdesc);
+
+	return pfile;
+
+bailout:
+	if (buffer)
+		free(buffer);
+	close(fdesc);
+
+	return NULL;
+}
+
+/*
+ * load_cuda_program_file
+ *
+ * It tries to load the CUDA binary from the program cache directory, then
+ * returns a new entry that replaced the src_entry, or NULL if not found.
+ */
+static program_cache_entry *
+load_cuda_program_file(program_cache_entry *src_entry)
+{
+	program_cache_entry *bin_entry = NULL;
+	program_cache_file *pfile;
+	char		fname[MAXPGPATH];
+
+	if (!program_cache_file_enabled())
+		return NULL;
+	program_cache_file_name(fname, sizeof(fname),
+							program_cache_directory,
+							src_entry->crc,
+							src_entry->target_cc,
+							src_entry->extra_flags);
+	pfile = read_cuda_program_file(fname, src_entry);
+	if (!pfile)
+		return NULL;
+
+	STROM_TRY();
+	{
+		bin_entry = setup_cuda_program_binary(src_entry,
+											  pfile->varlena_bufsz,
+											  PGCACHE_FILE_PTX_IMAGE(pfile),
+											  pfile->ptx_length,
+											  "build success:\n%s%s\n",
+											  "loaded from ", fname);
+	}
+	STROM_CATCH();
+	{
+		free(pfile);
+		STROM_RE_THROW();
+	}
+	STROM_END_TRY();
+	free(pfile);
+
+	return bin_entry;
+}
+
+/*
+ * evict_cuda_program_files
+ *
+ * It removes least recently used files in the program cache directory
+ * until total size gets less than the limit, then returns number of the
+ * removed files.
+ */
+typedef struct
+{
+	time_t		mtime;
+	off_t		length;
+	char		fname[MAXPGPATH];
+} program_cache_file_item;
+
+static int
+__compare_program_cache_file_mtime(const void *__a, const void *__b)
+{
+	const program_cache_file_item *a = __a;
+	const program_cache_file_item *b = __b;
+
+	if (a->mtime < b->mtime)
+		return -1;
+	if (a->mtime > b->mtime)
+		return 1;
+	return 0;
+}
+
+static int
+evict_cuda_program_files(const char *dirname, size_t limit)
+{
+	program_cache_file_item *items = NULL;
+	program_cache_file_item *temp;
+	DIR		   *dir;
+	struct dirent *dent;
+	struct stat	st_buf;
+	size_t		total_sz = 0;
+	int			nitems = 0;
+	int			nrooms = 0;
+	int			nremoved = 0;
+	int			i;
+
+	dir = opendir(dirname);
+	if (!dir)
+	{
+		wlog("failed on opendir(\"%s\"): %m", dirname);
+		return 0;
+	}
+	while ((dent = readdir(dir)) != NULL)
+	{
+		size_t		len = strlen(dent->d_name);
+		program_cache_file_item *item;
+
+		if (len <= strlen(PGCACHE_FILE_SUFFIX) ||
+			strcmp(dent->d_name + len - strlen(PGCACHE_FILE_SUFFIX),
+				   PGCACHE_FILE_SUFFIX) != 0)
+			continue;
+		if (nitems == nrooms)
+		{
+			nrooms = 2 * nrooms + 20;
+			temp = realloc(items, sizeof(program_cache_file_item) * nrooms);
+			if (!temp)
+				goto out;
+			items = temp;
+		}
+		item = &items[nitems];
+		snprintf(item->fname, MAXPGPATH, "%s/%s",
+				 dirname, dent->d_name);
+		if (stat(item->fname, &st_buf) != 0)
+			continue;	/* concurrently removed? */
+		item->mtime = st_buf.st_mtime;
+		item->length = st_buf.st_size;
+		total_sz += st_buf.st_size;
+		nitems++;
+	}
+	if (total_sz <= limit)
+		goto out;
+
+	/* remove the least recently used ones first */
+	qsort(items, nitems, sizeof(program_cache_file_item),
+		  __compare_program_cache_file_mtime);
+	for (i=0; i < nitems && total_sz > limit; i++)
+	{
+		if (unlink(items[i].fname) != 0)
+		{
+			if (errno != ENOENT)
+				wlog("failed on unlink(\"%s\"): %m", items[i].fname);
+			continue;
+		}
+		total_sz -= items[i].length;
+		nremoved++;
+	}
+out:
+	if (items)
+		free(items);
+	closedir(dir);
+
+	return nremoved;
+}
+
+/*
+ * save_cuda_program_file
+ *
+ * It writes out the CUDA binary onto the program cache directory, to reuse
+ * it after restart, then evicts the old files beyond the limit. Any errors
+ * are not critical here, so just logged.
+ */
+static bool
+save_cuda_program_file(program_cache_entry *bin_entry,
+					   const char *dirname, size_t limit)
+{
+	program_cache_file pfile;
+	char		fname[MAXPGPATH];
+	char		tname[MAXPGPATH];
+	FILE	   *filp;
+	size_t		length;
+
+	Assert(bin_entry->ptx_image != NULL &&
+		   bin_entry->ptx_image != CUDA_PROGRAM_BUILD_FAILURE);
+	program_cache_file_name(fname, sizeof(fname), dirname,
+							bin_entry->crc,
+							bin_entry->target_cc,
+							bin_entry->extra_flags);
+	length = (sizeof(program_cache_file) +
+			  bin_entry->kern_deflen +
+			  bin_entry->kern_srclen +
+			  bin_entry->ptx_length);
+	if (length > limit)
+		return false;	/* too large to keep */
+
+	memset(&pfile, 0, sizeof(program_cache_file));
+	pfile.magic			= PGCACHE_FILE_MAGIC;
+	pfile.headers_crc	= get_cuda_headers_crc();
+	pfile.nvrtc_version	= get_nvrtc_version();
+	pfile.crc			= bin_entry->crc;
+	pfile.target_cc		= bin_entry->target_cc;
+	pfile.extra_flags	= bin_entry->extra_flags;
+	pfile.varlena_bufsz	= bin_entry->varlena_bufsz;
+	pfile.ptx_crc		= bin_entry->ptx_crc;
+	pfile.kern_deflen	= bin_entry->kern_deflen;
+	pfile.kern_srclen	= bin_entry->kern_srclen;
+	pfile.ptx_length	= bin_entry->ptx_length;
+
+	/* write to a temporary file, then rename it atomically */
+	snprintf(tname, sizeof(tname), "%s.%d.tmp", fname, MyProcPid);
+	filp = fopen(tname, "wb");
+	if (!filp)
+	{
+		if (errno == ENOENT && mkdir(dirname, S_IRWXU) == 0)
+			filp = fopen(tname, "wb");
+		if (!filp)
+		{
+			wlog("failed to open \"%s\": %m", tname);
+			return false;
+		}
+	}
+	if (fwrite(&pfile, sizeof(program_cache_file), 1, filp) != 1 ||
+		fwrite(bin_entry->kern_define, 1, bin_entry->kern_deflen,
+			   filp) != bin_entry->kern_deflen ||
+		fwrite(bin_entry->kern_source, 1, bin_entry->kern_srclen,
+			   filp) != bin_entry->kern_srclen ||
+		fwrite(bin_entry->ptx_image, 1, bin_entry->ptx_length,
+			   filp) != bin_entry->ptx_length)
+	{
+		wlog("failed on write \"%s\": %m", tname);
+		fclose(filp);
+		unlink(tname);
+		return false;
+	}
+	if (fclose(filp) != 0 || rename(tname, fname) != 0)
+	{
+		wlog("failed to save CUDA binary \"%s\": %m", fname);
+		unlink(tname);
+		return false;
+	}
+	evict_cuda_program_files(dirname, limit);
+
+	return true;
+}
+
 /*
  * build_cuda_program - an interface to run synchronous build process
  */
@@ -734,13 +1277,18 @@ build_cuda_program(program_cache_entry *src_entry)
 	size_t			ptx_length = 0;
 	char		   *build_log = NULL;
 	size_t			log_length;
-	int				pindex;
-	int				hindex;
-	size_t			offset;
-	size_t			length;
 
 	Assert(!src_entry->build_chain.prev && !src_entry->build_chain.next);
 
+	/* Try to load the binary built before the last restart */
+	bin_entry = load_cuda_program_file(src_entry);
+	if (bin_entry)
+	{
+		pg_atomic_fetch_add_u64(&pgcache_head->num_file_loads, 1);
+		return bin_entry;
+	}
+	pg_atomic_fetch_add_u64(&pgcache_head->num_builds, 1);
+
 	/* Make a nvrtcProgram object */
 	source = construct_flat_cuda_source(src_entry->extra_flags,
 										src_entry->varlena_bufsz,
@@ -845,86 +1393,19 @@ build_cuda_program(program_cache_entry *src_entry)
 			werror("failed on nvrtcDestroyProgram: %s",
 				   nvrtcGetErrorString(rc));
 
-		/*
-		 * Allocation of a new entry, to keep ptx_image/build_log
-		 */
-		length = (MAXALIGN(src_entry->kern_deflen + 1) +
-				  MAXALIGN(src_entry->kern_srclen + 1) +
-				  MAXALIGN(ptx_length + 1) +
-				  MAXALIGN(log_length + 1) +
-				  PGCACHE_MIN_ERRORMSG_BUFSIZE);
-		SpinLockAcquire(&pgcache_head->lock);
-		bin_entry = create_cuda_program_entry_nolock(length);
-		if (!bin_entry)
-		{
-			SpinLockRelease(&pgcache_head->lock);
-			werror("out of CUDA program cache");
-		}
-		/*
-		 * OK, replace the src_entry by the bin_entry
-		 */
-		offset = 0;
-		bin_entry->program_id		= src_entry->program_id;
-		bin_entry->crc				= src_entry->crc;
-		bin_entry->target_cc        = src_entry->target_cc;
-		bin_entry->extra_flags		= src_entry->extra_flags;
-		bin_entry->kern_deflen		= src_entry->kern_deflen;
-		bin_entry->kern_define		= bin_entry->data + offset;
-		strcpy(bin_entry->kern_define, src_entry->kern_define);
-		offset += MAXALIGN(bin_entry->kern_deflen + 1);
-
-		bin_entry->kern_srclen		= src_entry->kern_srclen;
-		bin_entry->kern_source		= bin_entry->data + offset;
-		strcpy(bin_entry->kern_source, src_entry->kern_source);
-		offset += MAXALIGN(bin_entry->kern_srclen + 1);
-
-		if (!ptx_image)
-			bin_entry->ptx_image	= CUDA_PROGRAM_BUILD_FAILURE;
-		else
-		{
-			pg_crc32	ptx_crc;
-
-			bin_entry->ptx_image	= bin_entry->data + offset;
-			bin_entry->ptx_length	= ptx_length;
-			memcpy(bin_entry->ptx_image, ptx_image, ptx_length);
-			offset += MAXALIGN(ptx_length);
-
-			INIT_LEGACY_CRC32(ptx_crc);
-			COMP_LEGACY_CRC32(ptx_crc, ptx_image, ptx_length);
-			FIN_LEGACY_CRC32(ptx_crc);
-			bin_entry->ptx_crc		= ptx_crc;
-		}
-
-		bin_entry->error_msg		= bin_entry->data + offset;
-		if (!ptx_image)
-			snprintf(bin_entry->error_msg, length - offset,
-					 "build failure:\n%s\nsource: %s",
-					 build_log, tempfile);
-		else
-			snprintf(bin_entry->error_msg, length - offset,
-					 "build success:\n%s\n",
-					 build_log);
-		/* OK, bin_entry was built */
-		pindex = bin_entry->program_id % PGCACHE_HASH_SIZE;
-		hindex = bin_entry->crc % PGCACHE_HASH_SIZE;
-		dlist_push_head(&pgcache_head->pgid_slots[pindex],
-						&bin_entry->pgid_chain);
-		dlist_push_head(&pgcache_head->hash_slots[hindex],
-						&bin_entry->hash_chain);
-		dlist_push_head(&pgcache_head->lru_list,
-						&bin_entry->lru_chain);
-		memset(&bin_entry->build_chain, 0, sizeof(dlist_node));
-		bin_entry->refcnt = src_entry->refcnt;
-		/* release src_entry */
-		src_entry->refcnt = 0;
-		dlist_delete(&src_entry->pgid_chain);
-		dlist_delete(&src_entry->hash_chain);
-		dlist_delete(&src_entry->lru_chain);
-		memset(&src_entry->pgid_chain, 0, sizeof(dlist_node));
-		memset(&src_entry->hash_chain, 0, sizeof(dlist_node));
-		memset(&src_entry->lru_chain, 0, sizeof(dlist_node));
-		put_cuda_program_entry_nolock(src_entry);
-		SpinLockRelease(&pgcache_head->lock);
+		/* OK, replace the src_entry by the bin_entry */
+		bin_entry = setup_cuda_program_binary(src_entry,
+											  src_entry->varlena_bufsz,
+											  ptx_image, ptx_length,
+											  ptx_image
+											  ? "build success:\n%s\n"
+											  : "build failure:\n%s\nsource: %s",
+											  build_log, tempfile);
+		/* save the binary for the next restart */
+		if (ptx_image && program_cache_file_enabled())
+			save_cuda_program_file(bin_entry,
+								   program_cache_directory,
+								   (size_t)program_cache_disk_size_kb << 10);
 	}
 	STROM_CATCH();
 	{
@@ -978,6 +1459,7 @@ __pgstrom_create_cuda_program(GpuContext *gcontext,
 	int			dindex = gcontext->cuda_dindex;
 	int			hindex;
 	cl_int		target_cc;
+	cl_uint		entry_bufsz;
 	dlist_iter	iter;
 	pg_crc32	crc;
 
@@ -989,14 +1471,51 @@ __pgstrom_create_cuda_program(GpuContext *gcontext,
 	target_cc = (devAttrs[dindex].COMPUTE_CAPABILITY_MAJOR * 10 +
 				 devAttrs[dindex].COMPUTE_CAPABILITY_MINOR);
 	/* makes a hash value */
-	INIT_LEGACY_CRC32(crc);
-	COMP_LEGACY_CRC32(crc, &target_cc, sizeof(cl_int));
-	COMP_LEGACY_CRC32(crc, &extra_flags, sizeof(int32));
-	COMP_LEGACY_CRC32(crc, kern_source, kern_srclen);
-	COMP_LEGACY_CRC32(crc, kern_define, kern_deflen);
-	FIN_LEGACY_CRC32(crc);
+	crc = compute_cuda_program_crc(target_cc, extra_flags,
+								   kern_source, kern_srclen,
+								   kern_define, kern_deflen);
+
+	/*
+	 * An extra margin on the @varlena_bufsz might be valuable to avoid
+	 * unnecessary program rebuild if program contains device functions
+	 * that can return varlena datum. Because @varlena_bufsz estimation
+	 * can be affected by small changes in query;
+	 * e.g, substring(X from 0 for 3) will make different value from
+	 * the substring(X from 1 for 4), but code itself shall not be
+	 * changed. So, extra margin will help the case.
+	 *
+	 * Const nodes are always delivered via kern_parambuf, so queries which
+	 * differ only in literals generate identical kern_source; however,
+	 * length of the literals still affects the estimation. If
+	 * pg_strom.program_cache_share_literals is enabled, we round up the
+	 * buffer size to power of 2, to share the program in this case also.
+	 * The estimation is not bounded, so the calculation is done in 64bit.
+	 * No varlena datum can be larger than MaxAllocSize, so we raise an error
+	 * beyond the limit, and skip the rounding if it goes beyond the limit.
+	 */
+	if (varlena_bufsz == 0)
+		entry_bufsz = 0;
+	else
+	{
+		uint64		bufsz = MAXALIGN((uint64) varlena_bufsz + 36);
+
+		if (bufsz > PGCACHE_MAX_VARLENA_BUFSZ)
+			elog(ERROR, "varlena buffer size (%u) is too large",
+				 varlena_bufsz);
+		if (program_cache_share_literals)
+		{
+			uint64		temp = PGCACHE_MIN_VARLENA_BUFSZ;
+
+			while (temp < bufsz)
+				temp <<= 1;
+			if (temp <= PGCACHE_MAX_VARLENA_BUFSZ)
+				bufsz = temp;
+		}
+		entry_bufsz = (cl_uint) bufsz;
+	}
 
 	hindex = crc % PGCACHE_HASH_SIZE;
+	pg_atomic_fetch_add_u64(&pgcache_head->num_lookups, 1);
 	SpinLockAcquire(&pgcache_head->lock);
 	dlist_foreach (iter, &pgcache_head->hash_slots[hindex])
 	{
@@ -1013,6 +1532,7 @@ __pgstrom_create_cuda_program(GpuContext *gcontext,
 		{
 			program_id = entry->program_id;
 			get_cuda_program_entry_nolock(entry);
+			pg_atomic_fetch_add_u64(&pgcache_head->num_hits, 1);
 			/* Move this entry to the head of LRU list */
 			dlist_move_head(&pgcache_head->lru_list, &entry->lru_chain);
 		retry_checks:
@@ -1107,19 +1627,8 @@ __pgstrom_create_cuda_program(GpuContext *gcontext,
 	memcpy(entry->kern_source, kern_source, kern_srclen + 1);
 	usage += MAXALIGN(kern_srclen + 1);
 
-	/*
-	 * An extra margin on the @varlena_bufsz might be valuable to avoid
-	 * unnecessary program rebuild if program contains device functions
-	 * that can return varlena datum. Because @varlena_bufsz estimation
-	 * can be affected by small changes in query;
-	 * e.g, substring(X from 0 for 3) will make different value from
-	 * the substring(X from 1 for 4), but code itself shall not be
-	 * changed. So, extra margin will help the case.
-	 */
-	if (varlena_bufsz == 0)
-		entry->varlena_bufsz = 0;
-	else
-		entry->varlena_bufsz = MAXALIGN(varlena_bufsz + 36);
+	/* varlena buffer size with margin; see above */
+	entry->varlena_bufsz = entry_bufsz;
 
 	/* no cuda binary at this moment */
 	entry->ptx_image = NULL;
@@ -1261,6 +1770,34 @@ pgstrom_build_session_info(StringInfo buf,
 		assign_gpupreagg_session_info(buf, gts);
 }
 
+/*
+ * pgstrom_cuda_program_is_ready
+ *
+ * It checks whether pgstrom_load_cuda_program() can return the module
+ * without waiting for the program builders. Unknown or failed program
+ * is considered as ready, so the caller shall report the error on load.
+ * If no builders are running, it is also ready because the caller will
+ * build the program by itself.
+ */
+bool
+pgstrom_cuda_program_is_ready(ProgramId program_id)
+{
+	program_cache_entry *entry;
+	bool		retval = true;
+
+	SpinLockAcquire(&pgcache_head->lock);
+	entry = lookup_cuda_program_entry_nolock(program_id);
+	if (entry && !entry->ptx_image)
+	{
+		if ((!entry->build_chain.prev && !entry->build_chain.next) ||
+			pg_atomic_read_u32(&pgbuilder_state->num_active_builders) > 0)
+			retval = false;
+	}
+	SpinLockRelease(&pgcache_head->lock);
+
+	return retval;
+}
+
 /*
  * pgstrom_load_cuda_program
  */
@@ -1585,6 +2122,182 @@ build_wrapper_libraries(const char *wrapper_filename,
 }
 #endif
 
+/*
+ * pgstrom_program_cache_info
+ *
+ * It shows statistics of the program cache, to check how many lookups
+ * could reuse the CUDA programs built in the past.
+ */
+Datum
+pgstrom_program_cache_info(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	HeapTuple	tuple;
+	dlist_iter	iter;
+	int64		num_entries = 0;
+	int64		total_usage = 0;
+	Datum		values[6];
+	bool		isnull[6];
+
+	tupdesc = CreateTemplateTupleDesc(6, false);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "num_entries",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "total_usage",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "num_lookups",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 4, "num_hits",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 5, "num_file_loads",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 6, "num_builds",
+					   INT8OID, -1, 0);
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	SpinLockAcquire(&pgcache_head->lock);
+	dlist_foreach(iter, &pgcache_head->lru_list)
+	{
+		program_cache_entry *entry
+			= dlist_container(program_cache_entry, lru_chain, iter.cur);
+
+		num_entries++;
+		total_usage += (1UL << entry->mclass);
+	}
+	SpinLockRelease(&pgcache_head->lock);
+
+	memset(isnull, 0, sizeof(isnull));
+	values[0] = Int64GetDatum(num_entries);
+	values[1] = Int64GetDatum(total_usage);
+	values[2] = Int64GetDatum(pg_atomic_read_u64(&pgcache_head->num_lookups));
+	values[3] = Int64GetDatum(pg_atomic_read_u64(&pgcache_head->num_hits));
+	values[4] = Int64GetDatum(pg_atomic_read_u64(&pgcache_head->num_file_loads));
+	values[5] = Int64GetDatum(pg_atomic_read_u64(&pgcache_head->num_builds));
+	tuple = heap_form_tuple(tupdesc, values, isnull);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
+}
+PG_FUNCTION_INFO_V1(pgstrom_program_cache_info);
+
+/*
+ * pgstrom_program_cache_file_(save|load|evict)
+ *
+ * Debug functions to drive the persistent program cache on the supplied
+ * directory, with the binary images given by the caller. Because they
+ * need no GPU device, the regression test uses them to validate keying,
+ * load and eviction of the stored files.
+ */
+static program_cache_entry *
+__setup_program_cache_file_key(const char *dirname,
+							   text *kern_define, text *kern_source,
+							   cl_int target_cc, cl_uint extra_flags,
+							   cl_uint varlena_bufsz)
+{
+	program_cache_entry *entry;
+
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 (errmsg("only superuser can access the program cache files"))));
+	if (strlen(dirname) == 0)
+		elog(ERROR, "program cache directory is not specified");
+
+	entry = palloc0(offsetof(program_cache_entry, data));
+	entry->target_cc		= target_cc;
+	entry->extra_flags		= extra_flags;
+	entry->kern_define		= text_to_cstring(kern_define);
+	entry->kern_deflen		= strlen(entry->kern_define);
+	entry->kern_source		= text_to_cstring(kern_source);
+	entry->kern_srclen		= strlen(entry->kern_source);
+	entry->varlena_bufsz	= varlena_bufsz;
+	entry->crc = compute_cuda_program_crc(entry->target_cc,
+										  entry->extra_flags,
+										  entry->kern_source,
+										  entry->kern_srclen,
+										  entry->kern_define,
+										  entry->kern_deflen);
+	return entry;
+}
+
+Datum
+pgstrom_program_cache_file_save(PG_FUNCTION_ARGS)
+{
+	char	   *dirname = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	int64		limit_kb = PG_GETARG_INT64(1);
+	bytea	   *ptx_image = PG_GETARG_BYTEA_PP(4);
+	program_cache_entry *entry;
+	char		fname[MAXPGPATH];
+
+	entry = __setup_program_cache_file_key(dirname,
+										   PG_GETARG_TEXT_PP(2),
+										   PG_GETARG_TEXT_PP(3),
+										   PG_GETARG_INT32(5),
+										   PG_GETARG_INT32(6),
+										   PG_GETARG_INT32(7));
+	if (limit_kb < 0)
+		elog(ERROR, "size limit must not be negative");
+	entry->ptx_image = VARDATA_ANY(ptx_image);
+	entry->ptx_length = VARSIZE_ANY_EXHDR(ptx_image);
+	INIT_LEGACY_CRC32(entry->ptx_crc);
+	COMP_LEGACY_CRC32(entry->ptx_crc, entry->ptx_image, entry->ptx_length);
+	FIN_LEGACY_CRC32(entry->ptx_crc);
+
+	if (!save_cuda_program_file(entry, dirname, (size_t)limit_kb << 10))
+		PG_RETURN_NULL();
+	program_cache_file_name(fname, sizeof(fname), dirname,
+							entry->crc,
+							entry->target_cc,
+							entry->extra_flags);
+	PG_RETURN_TEXT_P(cstring_to_text(fname));
+}
+PG_FUNCTION_INFO_V1(pgstrom_program_cache_file_save);
+
+Datum
+pgstrom_program_cache_file_load(PG_FUNCTION_ARGS)
+{
+	char	   *dirname = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	program_cache_entry *entry;
+	program_cache_file *pfile;
+	char		fname[MAXPGPATH];
+	bytea	   *result;
+
+	entry = __setup_program_cache_file_key(dirname,
+										   PG_GETARG_TEXT_PP(1),
+										   PG_GETARG_TEXT_PP(2),
+										   PG_GETARG_INT32(3),
+										   PG_GETARG_INT32(4),
+										   PG_GETARG_INT32(5));
+	program_cache_file_name(fname, sizeof(fname), dirname,
+							entry->crc,
+							entry->target_cc,
+							entry->extra_flags);
+	pfile = read_cuda_program_file(fname, entry);
+	if (!pfile)
+		PG_RETURN_NULL();
+	result = palloc(VARHDRSZ + pfile->ptx_length);
+	SET_VARSIZE(result, VARHDRSZ + pfile->ptx_length);
+	memcpy(VARDATA(result), PGCACHE_FILE_PTX_IMAGE(pfile), pfile->ptx_length);
+	free(pfile);
+
+	PG_RETURN_BYTEA_P(result);
+}
+PG_FUNCTION_INFO_V1(pgstrom_program_cache_file_load);
+
+Datum
+pgstrom_program_cache_file_evict(PG_FUNCTION_ARGS)
+{
+	char	   *dirname = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	int64		limit_kb = PG_GETARG_INT64(1);
+
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 (errmsg("only superuser can access the program cache files"))));
+	if (limit_kb < 0)
+		elog(ERROR, "size limit must not be negative");
+	PG_RETURN_INT32(evict_cuda_program_files(dirname, (size_t)limit_kb << 10));
+}
+PG_FUNCTION_INFO_V1(pgstrom_program_cache_file_evict);
+
 static void
 pgstrom_startup_cuda_program(void)
 {
@@ -1616,6 +2329,10 @@ pgstrom_startup_cuda_program(void)
 	dlist_init(&pgcache_head->addr_list);
 	for (i=0; i <= PGCACHE_CHUNKSZ_MAX_BIT; i++)
 		dlist_init(&pgcache_head->free_list[i]);
+	pg_atomic_init_u64(&pgcache_head->num_lookups, 0);
+	pg_atomic_init_u64(&pgcache_head->num_hits, 0);
+	pg_atomic_init_u64(&pgcache_head->num_file_loads, 0);
+	pg_atomic_init_u64(&pgcache_head->num_builds, 0);
 
 	length = ((size_t)program_cache_size_kb << 10);
 	offset = 0;
@@ -1681,6 +2398,44 @@ pgstrom_init_cuda_program(void)
 							GUC_NOT_IN_SAMPLE,
 							NULL, NULL, NULL);
 
+	/*
+	 * directory to keep CUDA binaries across restart
+	 */
+	DefineCustomStringVariable("pg_strom.program_cache_directory",
+							   "directory of the persistent program cache",
+							   NULL,
+							   &program_cache_directory,
+							   "pg_strom_program_cache",
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE | GUC_SUPERUSER_ONLY,
+							   NULL, NULL, NULL);
+
+	/*
+	 * size limit of the persistent program cache
+	 */
+	DefineCustomIntVariable("pg_strom.program_cache_disk_size",
+							"size limit of the persistent program cache",
+							NULL,
+							&program_cache_disk_size_kb,
+							1024 * 1024,	/* 1GB */
+							0,				/* disabled */
+							INT_MAX,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+
+	/*
+	 * Share the program across queries that differ only in literals
+	 */
+	DefineCustomBoolVariable("pg_strom.program_cache_share_literals",
+							 "Share GPU programs across queries that differ only in literals",
+							 NULL,
+							 &program_cache_share_literals,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+
 	/*
 	 * Enables debug option on GPU kernel build
 	 */
@@ -20,6 +20,12 @@
 #include "cuda_numeric.h"
 #include "nvme_strom.h"
 
+/* alignment and maximum size of i/o request on NVMe-Strom emulation */
+#define NVME_EMULATION_IO_ALIGN		4096
+#define NVME_EMULATION_MAX_IOSZ		(256 << 10)
+/* number of i/o queues (duplicated file descriptors) per chunk */
+#define NVME_EMULATION_NQUEUES		8
+
 /*
  * estimate_num_chunks
  *
@@ -120,10 +126,10 @@ KDS_fetch_tuple_column(TupleTableSlot *slot,
 
 	/*
 	 * XXX - Is a mode to fetch system columns (if any) valuable?
-	 * Right now, KDS_fetch_tuple_column() is only used by gstore_fdw.c
-	 * to fetch rows from KDS(column), however, its transaction control
-	 * properties are separately saved, thus, nobody tries to pick up
-	 * system columns via this API.
+	 * Right now, KDS_fetch_tuple_column() is used by gstore_fdw.c and
+	 * the columnar cache to fetch rows from KDS(column), however, their
+	 * transaction control properties are separately saved or all-visible,
+	 * thus, nobody tries to pick up system columns via this API.
 	 */
 	Assert(kds->format == KDS_FORMAT_COLUMN);
 	Assert(kds->ncols == tupdesc->natts);
@@ -209,21 +215,20 @@ PDS_fetch_tuple(TupleTableSlot *slot,
 				pgstrom_data_store *pds,
 				GpuTaskState *gts)
 {
+	KDSDeformer *dfm;
+
 	switch (pds->kds.format)
 	{
 		case KDS_FORMAT_ROW:
 		case KDS_FORMAT_HASH:
-			return KDS_fetch_tuple_row(slot, &pds->kds,
-									   &gts->curr_tuple,
-									   gts->curr_index++);
 		case KDS_FORMAT_SLOT:
-			return KDS_fetch_tuple_slot(slot, &pds->kds,
-										gts->curr_index++);
+		case KDS_FORMAT_COLUMN:
+			dfm = pgstromGetTupleDeformer(gts, slot->tts_tupleDescriptor);
+			return KDS_deform_tuple(dfm, slot, &pds->kds,
+									&gts->curr_tuple,
+									gts->curr_index++);
 		case KDS_FORMAT_BLOCK:
 			return KDS_fetch_tuple_block(slot, &pds->kds, gts);
-		case KDS_FORMAT_COLUMN:
-			return KDS_fetch_tuple_column(slot, &pds->kds,
-										  gts->curr_index++);
 		default:
 			elog(ERROR, "Bug? unsupported data store format: %d",
 				pds->kds.format);
@@ -583,7 +588,7 @@ typedef struct _MdfdVec
 } MdfdVec;
 
 static int
-nvme_sstate_open_segment(SMgrRelation rd_smgr, int seg_nr)
+nvme_sstate_open_segment(SMgrRelation rd_smgr, int seg_nr, bool direct_io)
 {
 	/* see _mdfd_openseg() and _mdfd_segpath() */
 	char	   *temp;
@@ -599,7 +604,19 @@ nvme_sstate_open_segment(SMgrRelation rd_smgr, int seg_nr)
 	else
 		path = temp;
 
-	fdesc = open(path, O_RDWR | PG_BINARY, 0600);
+	if (!direct_io)
+		fdesc = open(path, O_RDWR | PG_BINARY, 0600);
+	else
+	{
+		/*
+		 * NVMe-Strom emulation reads the blocks bypassing the page cache,
+		 * if filesystem supports. Elsewhere, it still bypasses the shared
+		 * buffer, but uses the page cache.
+		 */
+		fdesc = open(path, O_RDONLY | O_DIRECT | PG_BINARY);
+		if (fdesc < 0 && errno == EINVAL)
+			fdesc = open(path, O_RDONLY | PG_BINARY);
+	}
 	if (fdesc < 0)
 		elog(ERROR, "failed on open('%s'): %m", path);
 	pfree(path);
@@ -617,6 +634,25 @@ nvme_sstate_open_files(GpuContext *gcontext,
 	int			i, nr_segs;
 	int			fdesc;
 
+	/*
+	 * NVMe-Strom emulation needs its own file descriptors, because O_DIRECT
+	 * flag is shared with the duplicated file descriptors.
+	 */
+	if (nvme_sstate->emulated)
+	{
+		for (i=0; i < nvme_sstate->nr_segs; i++)
+		{
+			fdesc = nvme_sstate_open_segment(rd_smgr, i, true);
+			if (!trackRawFileDesc(gcontext, fdesc, __FILE__, __LINE__))
+			{
+				close(fdesc);
+				elog(ERROR, "out of memory");
+			}
+			nvme_sstate->fdesc[i] = fdesc;
+		}
+		return;
+	}
+
 #if PG_VERSION_NUM < 100000
 	/* PG9.6 */
 	nr_segs = nvme_sstate->nr_segs;
@@ -633,7 +669,7 @@ nvme_sstate_open_files(GpuContext *gcontext,
 
 		fdesc = FileGetRawDesc(vec->mdfd_vfd);
 		if (fdesc < 0)
-			fdesc = nvme_sstate_open_segment(rd_smgr, vec->mdfd_segno);
+			fdesc = nvme_sstate_open_segment(rd_smgr, vec->mdfd_segno, false);
 		else
 		{
 			fdesc = dup(fdesc);
@@ -653,7 +689,7 @@ nvme_sstate_open_files(GpuContext *gcontext,
 	{
 		if (nvme_sstate->fdesc[i] >= 0)
 			continue;
-		fdesc = nvme_sstate_open_segment(rd_smgr, i);
+		fdesc = nvme_sstate_open_segment(rd_smgr, i, false);
 		if (!trackRawFileDesc(gcontext, fdesc, __FILE__, __LINE__))
 		{
 			close(fdesc);
@@ -675,7 +711,7 @@ nvme_sstate_open_files(GpuContext *gcontext,
 				 i, RelationGetRelationName(relation));
 		fdesc = FileGetRawDesc(vec->mdfd_vfd);
 		if (fdesc < 0)
-			fdesc = nvme_sstate_open_segment(rd_smgr, i);
+			fdesc = nvme_sstate_open_segment(rd_smgr, i, false);
 		else
 		{
 			fdesc = dup(fdesc);
@@ -693,7 +729,7 @@ nvme_sstate_open_files(GpuContext *gcontext,
 
 	while (i < nvme_sstate->nr_segs)
 	{
-		fdesc = nvme_sstate_open_segment(rd_smgr, i);
+		fdesc = nvme_sstate_open_segment(rd_smgr, i, false);
 		if (!trackRawFileDesc(gcontext, fdesc, __FILE__, __LINE__))
 		{
 			close(fdesc);
@@ -706,7 +742,8 @@ nvme_sstate_open_files(GpuContext *gcontext,
 
 /*
  * PDS_init_heapscan_state - construct a per-query state for heap-scan
- * with KDS_FORMAT_BLOCK / NVMe-Strom.
+ * with KDS_FORMAT_BLOCK / NVMe-Strom, or whole-page copy of the buffered
+ * blocks if NVMe-Strom is not available.
  */
 void
 PDS_init_heapscan_state(GpuTaskState *gts)
@@ -723,15 +760,60 @@ PDS_init_heapscan_state(GpuTaskState *gts)
 	cl_uint			nrooms_max;
 	cl_uint			nchunks;
 	cl_uint			nblocks_per_chunk;
+	bool			direct_load = false;
+	bool			emulated = false;
 
 	/*
-	 * Check storage capability of NVMe-Strom
+	 * Check storage capability of NVMe-Strom, or its emulation
 	 */
-	if (nrows_per_block == 0 ||
-		!RelationCanUseNvmeStrom(relation) ||
-		(nr_blocks = RelationGetNumberOfBlocks(relation)) <= RELSEG_SIZE)
+	nr_blocks = RelationGetNumberOfBlocks(relation);
+	if (nrows_per_block > 0)
 	{
-		return;
+		/*
+		 * Unlike nvme_strom, the emulation is also applied on the tables
+		 * smaller than a segment, if pg_strom.nvme_strom_threshold allows.
+		 */
+		if (nr_blocks > RELSEG_SIZE && RelationCanUseNvmeStrom(relation))
+			direct_load = true;
+		else if (RelationCanUseNvmeStromEmulation(relation))
+			direct_load = emulated = true;
+	}
+
+	/*
+	 * Elsewhere, we copy the whole page of buffered blocks onto the
+	 * KDS_FORMAT_BLOCK, instead of tuple-by-tuple copy onto the
+	 * KDS_FORMAT_ROW. All-visible pages need no per-tuple works on the
+	 * host side, so the format of each chunk is chosen by the visibility
+	 * map of its first block (see pgstromCreateScanChunk).
+	 * Not all-visible pages in the KDS_FORMAT_BLOCK chunk are also copied
+	 * as is, but line pointers of the invisible tuples are invalidated.
+	 * Because per-tuple check of the serialization conflict is skipped
+	 * on the all-visible pages, it is not used on serializable mode.
+	 */
+	if (!direct_load)
+	{
+		if (!pgstrom_enable_page_copy || IsolationIsSerializable())
+			return;
+		if (nrows_per_block == 0)
+		{
+			/* see estimate_rel_size() */
+			Form_pg_class	relform = RelationGetForm(relation);
+			size_t			tuple_width;
+
+			if (relform->relpages > 0 && relform->reltuples > 0.0)
+				nrows_per_block = ceil(relform->reltuples /
+									   (double)relform->relpages);
+			else
+			{
+				tuple_width = get_relation_data_width(relation->rd_id, NULL);
+				tuple_width += MAXALIGN(SizeofHeapTupleHeader);
+				tuple_width += sizeof(ItemIdData);
+				/* note: integer division is intentional here */
+				nrows_per_block = ((BLCKSZ - SizeOfPageHeaderData) /
+								   tuple_width);
+			}
+			nrows_per_block = Max(nrows_per_block, 1);
+		}
 	}
 
 	/*
@@ -758,7 +840,10 @@ PDS_init_heapscan_state(GpuTaskState *gts)
 	nblocks_per_chunk = (RELSEG_SIZE + nchunks - 1) / nchunks;
 
 	/* allocation of NVMEScanState structure */
-	nr_segs = (nr_blocks + (BlockNumber) RELSEG_SIZE - 1) / RELSEG_SIZE;
+	if (!direct_load)
+		nr_segs = 0;	/* no need to open the files */
+	else
+		nr_segs = (nr_blocks + (BlockNumber) RELSEG_SIZE - 1) / RELSEG_SIZE;
 	nvme_sstate = MemoryContextAllocZero(estate->es_query_cxt,
 										 offsetof(NVMEScanState,
 												  fdesc[nr_segs]));
@@ -767,7 +852,18 @@ PDS_init_heapscan_state(GpuTaskState *gts)
 	nvme_sstate->curr_segno = InvalidBlockNumber;
 	nvme_sstate->curr_vmbuffer = InvalidBuffer;
 	nvme_sstate->nr_segs = nr_segs;
-	nvme_sstate_open_files(gcontext, nvme_sstate, relation);
+	nvme_sstate->direct_load = direct_load;
+	nvme_sstate->emulated = emulated;
+	if (emulated)
+	{
+		char   *temp = MemoryContextAlloc(estate->es_query_cxt,
+										  BLCKSZ * nblocks_per_chunk +
+										  NVME_EMULATION_IO_ALIGN);
+		nvme_sstate->bounce_buffer
+			= (char *)TYPEALIGN(NVME_EMULATION_IO_ALIGN, temp);
+	}
+	if (direct_load)
+		nvme_sstate_open_files(gcontext, nvme_sstate, relation);
 
 	gts->nvme_sstate = nvme_sstate;
 }
@@ -810,7 +906,8 @@ static bool
 PDS_exec_heapscan_block(pgstrom_data_store *pds,
 						Relation relation,
 						HeapScanDesc hscan,
-						NVMEScanState *nvme_sstate)
+						NVMEScanState *nvme_sstate,
+						zoneMapState *zm_state)
 {
 	BlockNumber		blknum = hscan->rs_cblock;
 	BlockNumber	   *block_nums;
@@ -835,7 +932,8 @@ PDS_exec_heapscan_block(pgstrom_data_store *pds,
 	 * and the current source block is all-visible.
 	 * Elsewhere, we will go fallback with synchronized buffer scan.
 	 */
-	if (RelationCanUseNvmeStrom(relation) &&
+	if (nvme_sstate->direct_load &&
+		(nvme_sstate->emulated || RelationCanUseNvmeStrom(relation)) &&
 		VM_ALL_VISIBLE(relation, blknum,
 					   &nvme_sstate->curr_vmbuffer))
 	{
@@ -876,6 +974,9 @@ PDS_exec_heapscan_block(pgstrom_data_store *pds,
 				pds->nblocks_uncached++;
 				pds->kds.nitems++;
 				block_nums[pds->kds.nrooms - pds->nblocks_uncached] = blknum;
+				/* zone map is observed after the load, if emulated */
+				if (nvme_sstate->emulated)
+					pgstromZoneMapExpect(zm_state, blknum);
 
 				retval = true;
 			}
@@ -903,6 +1004,8 @@ PDS_exec_heapscan_block(pgstrom_data_store *pds,
 	dpage = (Page) KERN_DATA_STORE_BLOCK_PGPAGE(&pds->kds, nr_loaded);
 	memcpy(dpage, spage, BLCKSZ);
 	block_nums[nr_loaded] = blknum;
+	/* accumulate zone map of the range, if any */
+	pgstromZoneMapObserve(zm_state, blknum, spage);
 
 	/*
 	 * Logic is almost same as heapgetpage() doing. We have to invalidate
@@ -951,7 +1054,8 @@ PDS_exec_heapscan_block(pgstrom_data_store *pds,
 static bool
 PDS_exec_heapscan_row(pgstrom_data_store *pds,
 					  Relation relation,
-					  HeapScanDesc hscan)
+					  HeapScanDesc hscan,
+					  zoneMapState *zm_state)
 {
 	BlockNumber		blknum = hscan->rs_cblock;
 	Snapshot		snapshot = hscan->rs_snapshot;
@@ -1003,6 +1107,8 @@ PDS_exec_heapscan_row(pgstrom_data_store *pds,
 		UnlockReleaseBuffer(buffer);
 		return false;
 	}
+	/* accumulate zone map of the range, if any */
+	pgstromZoneMapObserve(zm_state, blknum, page);
 
 	/*
 	 * Logic is almost same as heapgetpage() doing.
@@ -1073,12 +1179,14 @@ PDS_exec_heapscan(GpuTaskState *gts, pgstrom_data_store *pds)
 	CHECK_FOR_INTERRUPTS();
 
 	if (pds->kds.format == KDS_FORMAT_ROW)
-		retval = PDS_exec_heapscan_row(pds, relation, hscan);
+		retval = PDS_exec_heapscan_row(pds, relation, hscan,
+									   gts->zm_state);
 	else if (pds->kds.format == KDS_FORMAT_BLOCK)
 	{
 		Assert(gts->nvme_sstate);
 		retval = PDS_exec_heapscan_block(pds, relation, hscan,
-										 gts->nvme_sstate);
+										 gts->nvme_sstate,
+										 gts->zm_state);
 	}
 	else
 		elog(ERROR, "Bug? unexpected PDS format: %d", pds->kds.format);
@@ -1183,6 +1291,41 @@ KDS_insert_hashitem(kern_data_store *kds,
 	return true;
 }
 
+/*
+ * __PDS_sort_uncached_blocks
+ *
+ * Block-numbers of the uncached blocks are stored from the tail of the
+ * array, so they are usually descending order. It sorts them in ascending
+ * order to merge continuous blocks into a larger i/o request.
+ * Pages are not loaded yet, so we can reorder block-numbers freely.
+ */
+static int
+__compare_block_number(const void *__a, const void *__b)
+{
+	BlockNumber	a = *((const BlockNumber *)__a);
+	BlockNumber	b = *((const BlockNumber *)__b);
+
+	if (a < b)
+		return -1;
+	if (a > b)
+		return 1;
+	return 0;
+}
+
+static BlockNumber *
+__PDS_sort_uncached_blocks(pgstrom_data_store *pds)
+{
+	BlockNumber	   *block_nums;
+	cl_uint			nr_loaded;
+
+	Assert(pds->nblocks_uncached <= pds->kds.nitems);
+	nr_loaded = pds->kds.nitems - pds->nblocks_uncached;
+	block_nums = (BlockNumber *)KERN_DATA_STORE_BODY(&pds->kds) + nr_loaded;
+	qsort(block_nums, pds->nblocks_uncached,
+		  sizeof(BlockNumber), __compare_block_number);
+	return block_nums;
+}
+
 /*
  * PDS_fillup_blocks
  *
@@ -1192,7 +1335,7 @@ void
 PDS_fillup_blocks(pgstrom_data_store *pds)
 {
 	cl_int			filedesc = pds->filedesc;
-	cl_int			i, nr_loaded;
+	cl_int			i;
 	ssize_t			nbytes;
 	char		   *dest_addr;
 	loff_t			curr_fpos;
@@ -1206,13 +1349,13 @@ PDS_fillup_blocks(pgstrom_data_store *pds)
 		return;		/* already filled up */
 
 	Assert(filedesc >= 0);
-	Assert(pds->nblocks_uncached <= pds->kds.nitems);
-	nr_loaded = pds->kds.nitems - pds->nblocks_uncached;
-	block_nums = (BlockNumber *)KERN_DATA_STORE_BODY(&pds->kds);
-	dest_addr = (char *)KERN_DATA_STORE_BLOCK_PGPAGE(&pds->kds, nr_loaded);
+	block_nums = __PDS_sort_uncached_blocks(pds);
+	dest_addr = (char *)
+		KERN_DATA_STORE_BLOCK_PGPAGE(&pds->kds, (pds->kds.nitems -
+												 pds->nblocks_uncached));
 	curr_fpos = 0;
 	curr_size = 0;
-	for (i=pds->nblocks_uncached-1; i >=0; i--)
+	for (i=0; i < pds->nblocks_uncached; i++)
 	{
 		loff_t	file_pos = (block_nums[i] & (RELSEG_SIZE - 1)) * BLCKSZ;
 
@@ -1253,3 +1396,155 @@ PDS_fillup_blocks(pgstrom_data_store *pds)
 															 pds->kds.nitems));
 	pds->nblocks_uncached = 0;
 }
+
+/*
+ * PDS_fillup_blocks_direct
+ *
+ * It fills up uncached blocks using asynchronous O_DIRECT reads, as
+ * emulation of NVMe-Strom. Continuous blocks are merged to a request up
+ * to NVME_EMULATION_MAX_IOSZ, then all the requests are submitted at once
+ * to keep the storage busy. Because destination pages of KDS_FORMAT_BLOCK
+ * are not aligned for O_DIRECT, blocks are read to the bounce buffer,
+ * then copied to the PDS. Zone map is also accumulated from the pages
+ * on the bounce buffer, because they never go through the shared buffer.
+ *
+ * NOTE: glibc's POSIX AIO runs requests on the same file descriptor one by
+ * one on a helper thread, so requests are distributed over the duplicated
+ * file descriptors to have up to NVME_EMULATION_NQUEUES reads in-flight.
+ */
+void
+PDS_fillup_blocks_direct(pgstrom_data_store *pds,
+						 NVMEScanState *nvme_sstate,
+						 zoneMapState *zm_state)
+{
+	cl_int			filedesc = pds->filedesc;
+	cl_uint			nblocks = pds->nblocks_uncached;
+	char		   *bounce = nvme_sstate->bounce_buffer;
+	BlockNumber	   *block_nums;
+	struct aiocb   *aio_reqs;
+	int				fdesc_queues[NVME_EMULATION_NQUEUES];
+	cl_uint			nr_queues;
+	cl_uint			nr_reqs = 0;
+	cl_uint			i;
+	int				errno_saved = 0;
+
+	if (pds->kds.format != KDS_FORMAT_BLOCK)
+		elog(ERROR, "Bug? only KDS_FORMAT_BLOCK can be filled up");
+	if (nblocks == 0)
+		return;		/* already filled up */
+	Assert(filedesc >= 0 && nvme_sstate->emulated && bounce != NULL);
+	Assert(nblocks <= nvme_sstate->nblocks_per_chunk);
+
+	/* setup i/o requests */
+	block_nums = __PDS_sort_uncached_blocks(pds);
+	aio_reqs = palloc0(sizeof(struct aiocb) * nblocks);
+	for (i=0; i < nblocks; i++)
+	{
+		off_t	file_pos = (block_nums[i] & (RELSEG_SIZE - 1)) * BLCKSZ;
+
+		if (nr_reqs > 0)
+		{
+			struct aiocb *curr = &aio_reqs[nr_reqs - 1];
+
+			if (curr->aio_offset + curr->aio_nbytes == file_pos &&
+				curr->aio_nbytes + BLCKSZ <= NVME_EMULATION_MAX_IOSZ)
+			{
+				/* merge with the pending i/o */
+				curr->aio_nbytes += BLCKSZ;
+				continue;
+			}
+		}
+		aio_reqs[nr_reqs].aio_buf = bounce + BLCKSZ * i;
+		aio_reqs[nr_reqs].aio_nbytes = BLCKSZ;
+		aio_reqs[nr_reqs].aio_offset = file_pos;
+		aio_reqs[nr_reqs].aio_sigevent.sigev_notify = SIGEV_NONE;
+		nr_reqs++;
+	}
+
+	/*
+	 * duplicate the file descriptor for each i/o queue; O_DIRECT flag is
+	 * shared with the duplicated ones. If dup(2) fails, the requests are
+	 * just distributed over the less queues.
+	 */
+	fdesc_queues[0] = filedesc;
+	for (nr_queues = 1;
+		 nr_queues < Min(nr_reqs, NVME_EMULATION_NQUEUES);
+		 nr_queues++)
+	{
+		int		temp = dup(filedesc);
+
+		if (temp < 0)
+			break;
+		fdesc_queues[nr_queues] = temp;
+	}
+
+	/*
+	 * submit the requests
+	 *
+	 * NOTE: we must not raise an error until completion of the submitted
+	 * requests, because they write on the bounce buffer asynchronously.
+	 */
+	for (i=0; i < nr_reqs; i++)
+	{
+		aio_reqs[i].aio_fildes = fdesc_queues[i % nr_queues];
+		if (aio_read(&aio_reqs[i]) != 0)
+		{
+			errno_saved = errno;
+			break;
+		}
+	}
+	nr_reqs = i;
+
+	/* wait for completion */
+	for (i=0; i < nr_reqs; i++)
+	{
+		struct aiocb   *curr = &aio_reqs[i];
+		const struct aiocb *list[1];
+		ssize_t			nbytes;
+		int				rv;
+
+		list[0] = curr;
+		while ((rv = aio_error(curr)) == EINPROGRESS)
+			aio_suspend(list, 1, NULL);		/* EINTR shall be retried */
+		nbytes = aio_return(curr);
+		if (rv != 0)
+		{
+			if (errno_saved == 0)
+				errno_saved = rv;
+			continue;
+		}
+		/* short read is unlikely, but not an error */
+		while (nbytes < curr->aio_nbytes)
+		{
+			ssize_t		temp = pread(filedesc,
+									 (char *)curr->aio_buf + nbytes,
+									 curr->aio_nbytes - nbytes,
+									 curr->aio_offset + nbytes);
+			if (temp > 0)
+				nbytes += temp;
+			else if (temp == 0 || errno != EINTR)
+			{
+				if (errno_saved == 0)
+					errno_saved = (temp == 0 ? EIO : errno);
+				break;
+			}
+		}
+	}
+	for (i=1; i < nr_queues; i++)
+		close(fdesc_queues[i]);
+	pfree(aio_reqs);
+	if (errno_saved != 0)
+	{
+		errno = errno_saved;
+		elog(ERROR, "failed on asynchronous read of uncached blocks: %m");
+	}
+
+	/* copy to the PDS */
+	memcpy(KERN_DATA_STORE_BLOCK_PGPAGE(&pds->kds, pds->kds.nitems - nblocks),
+		   bounce, BLCKSZ * nblocks);
+	/* accumulate zone map of the range, if any */
+	for (i=0; i < nblocks; i++)
+		pgstromZoneMapObserve(zm_state, block_nums[i],
+							  (Page)(bounce + BLCKSZ * i));
+	pds->nblocks_uncached = 0;
+}
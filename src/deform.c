@@ -0,0 +1,817 @@
+/*
+ * deform.c
+ *
+ * Tuple deformer specialized for a particular TupleDesc, to deliver rows
+ * in PDS (KDS_FORMAT_ROW, SLOT and COLUMN) to the upper node.
+ * ----
+ * Copyright 2011-2018 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2018 (C) The PG-Strom Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "pg_strom.h"
+
+/*
+ * NOTE: The generic path (KDS_fetch_tuple_*) stores a heap tuple on the
+ * slot, then slot_deform_tuple() walks the attributes with checks of
+ * attlen, attbyval and attalign for each attribute of each row.
+ * The deformer pre-computes the fetch method of individual attributes
+ * once per TupleDesc, and the fixed offset of the leading fixed-length
+ * attributes; which is always valid if they are NOT NULL, or valid for
+ * tuples without null bitmap.
+ * Once a tuple is deformed, slot->tts_nvalid is set, so slot_getattr()
+ * never walks on the tuple again. The heap tuple is still kept on the
+ * slot for the system columns.
+ */
+#define DEFORM_ATTR__INT8		1	/* by-value, 1 byte */
+#define DEFORM_ATTR__INT16		2	/* by-value, 2 bytes */
+#define DEFORM_ATTR__INT32		3	/* by-value, 4 bytes */
+#define DEFORM_ATTR__INT64		4	/* by-value, 8 bytes */
+#define DEFORM_ATTR__FIXED_REF	5	/* fixed-length, by-reference */
+#define DEFORM_ATTR__VARLENA	6	/* variable-length (attlen = -1) */
+#define DEFORM_ATTR__CSTRING	7	/* null-terminated (attlen = -2) */
+
+typedef struct
+{
+	cl_char		kind;			/* one of DEFORM_ATTR__* */
+	char		attalign;		/* typalign code of the attribute */
+	cl_short	attlen;
+	cl_int		attcacheoff;	/* fixed offset from t_hoff, or -1 */
+} deformAttr;
+
+struct KDSDeformer
+{
+	struct KDSDeformer *next;	/* next deformer of the GpuTaskState */
+	TupleDesc	tupdesc;
+	int			natts;
+	int			nfixed;			/* # of leading fixed-length NOT NULL
+								 * attributes */
+	int			nfixed_nonull;	/* # of leading fixed-length attributes;
+								 * usable if tuple has no null bitmap */
+	bool		has_cstring;	/* true, if any attlen = -2 */
+	/* properties of the current KDS, if KDS_FORMAT_COLUMN */
+	kern_data_store *curr_kds;
+	char	  **col_values;		/* base address of values array */
+	bits8	  **col_nullmap;	/* nullmap, or NULL if no nulls */
+	cl_int	   *col_unitsz;		/* unit size of fixed-length values */
+	deformAttr	attrs[FLEXIBLE_ARRAY_MEMBER];
+};
+
+Datum pgstrom_bench_tuple_deform(PG_FUNCTION_ARGS);
+
+/*
+ * KDS_create_deformer - construct a deformer for the supplied TupleDesc
+ */
+KDSDeformer *
+KDS_create_deformer(TupleDesc tupdesc)
+{
+	KDSDeformer *dfm;
+	int			natts = tupdesc->natts;
+	int			attcacheoff = 0;
+	bool		fixed_notnull = true;
+	int			j;
+
+	dfm = palloc0(offsetof(KDSDeformer, attrs[natts]));
+	dfm->tupdesc = tupdesc;
+	dfm->natts = natts;
+	dfm->col_values = palloc0(sizeof(char *) * Max(natts, 1));
+	dfm->col_nullmap = palloc0(sizeof(bits8 *) * Max(natts, 1));
+	dfm->col_unitsz = palloc0(sizeof(cl_int) * Max(natts, 1));
+
+	for (j=0; j < natts; j++)
+	{
+		Form_pg_attribute attr = tupleDescAttr(tupdesc, j);
+		deformAttr *dattr = &dfm->attrs[j];
+
+		dattr->attalign = attr->attalign;
+		dattr->attlen = attr->attlen;
+		if (attr->attbyval)
+		{
+			if (attr->attlen == sizeof(cl_char))
+				dattr->kind = DEFORM_ATTR__INT8;
+			else if (attr->attlen == sizeof(cl_short))
+				dattr->kind = DEFORM_ATTR__INT16;
+			else if (attr->attlen == sizeof(cl_int))
+				dattr->kind = DEFORM_ATTR__INT32;
+			else if (attr->attlen == sizeof(cl_long))
+				dattr->kind = DEFORM_ATTR__INT64;
+			else
+				elog(ERROR, "unexpected attlen: %d", attr->attlen);
+		}
+		else if (attr->attlen > 0)
+			dattr->kind = DEFORM_ATTR__FIXED_REF;
+		else if (attr->attlen == -1)
+			dattr->kind = DEFORM_ATTR__VARLENA;
+		else if (attr->attlen == -2)
+		{
+			dattr->kind = DEFORM_ATTR__CSTRING;
+			dfm->has_cstring = true;
+		}
+		else
+			elog(ERROR, "unexpected attlen: %d", attr->attlen);
+
+		/* fixed offset of the leading fixed-length attributes */
+		if (attcacheoff >= 0 && attr->attlen > 0)
+		{
+			attcacheoff = att_align_nominal(attcacheoff, attr->attalign);
+			dattr->attcacheoff = attcacheoff;
+			attcacheoff += attr->attlen;
+			dfm->nfixed_nonull++;
+			if (fixed_notnull && attr->attnotnull && !attr->attisdropped)
+				dfm->nfixed++;
+			else
+				fixed_notnull = false;
+		}
+		else
+		{
+			dattr->attcacheoff = -1;
+			attcacheoff = -1;
+		}
+	}
+	return dfm;
+}
+
+/*
+ * pgstromGetTupleDeformer - lookup a deformer for the TupleDesc; it is
+ * constructed on the first call, then kept until end of the executor.
+ */
+KDSDeformer *
+pgstromGetTupleDeformer(GpuTaskState *gts, TupleDesc tupdesc)
+{
+	EState	   *estate = gts->css.ss.ps.state;
+	KDSDeformer *dfm;
+	MemoryContext oldcxt;
+
+	for (dfm = gts->deformers; dfm != NULL; dfm = dfm->next)
+	{
+		if (dfm->tupdesc == tupdesc && dfm->natts == tupdesc->natts)
+			return dfm;
+	}
+	oldcxt = MemoryContextSwitchTo(estate->es_query_cxt);
+	dfm = KDS_create_deformer(tupdesc);
+	MemoryContextSwitchTo(oldcxt);
+
+	dfm->next = gts->deformers;
+	gts->deformers = dfm;
+
+	return dfm;
+}
+
+/*
+ * pgstromResetTupleDeformers - forget the KDS_FORMAT_COLUMN cached by the
+ * deformers. A KDS may be released then reused on the same address, so
+ * it shall be called whenever GpuTaskState switches to a new KDS.
+ */
+void
+pgstromResetTupleDeformers(GpuTaskState *gts)
+{
+	KDSDeformer *dfm;
+
+	for (dfm = gts->deformers; dfm != NULL; dfm = dfm->next)
+		dfm->curr_kds = NULL;
+}
+
+/*
+ * deform_fetch_datum - fetch a fixed-length datum
+ */
+static inline Datum
+deform_fetch_datum(deformAttr *dattr, char *addr)
+{
+	switch (dattr->kind)
+	{
+		case DEFORM_ATTR__INT8:
+			return CharGetDatum(*((cl_char *)addr));
+		case DEFORM_ATTR__INT16:
+			return Int16GetDatum(*((cl_short *)addr));
+		case DEFORM_ATTR__INT32:
+			return Int32GetDatum(*((cl_int *)addr));
+		case DEFORM_ATTR__INT64:
+			return Int64GetDatum(*((cl_long *)addr));
+		default:
+			return PointerGetDatum(addr);
+	}
+}
+
+/*
+ * deform_heap_tuple - deform a heap tuple onto tts_values/tts_isnull
+ */
+static bool
+deform_heap_tuple(KDSDeformer *dfm, TupleTableSlot *slot,
+				  HeapTupleHeader htup)
+{
+	Datum	   *values = slot->tts_values;
+	bool	   *isnull = slot->tts_isnull;
+	char	   *tp = (char *)htup + htup->t_hoff;
+	bits8	   *bp = htup->t_bits;
+	bool		hasnulls = HeapTupleHeaderHasNulls(htup);
+	int			natts = dfm->natts;
+	int			nfast;
+	long		off = 0;
+	int			j;
+
+	/* tuple may have less attributes, if ALTER TABLE ADD COLUMN */
+	if (HeapTupleHeaderGetNatts(htup) != natts)
+		return false;
+
+	/* leading fixed-length attributes by the fixed offset */
+	nfast = (hasnulls ? dfm->nfixed : dfm->nfixed_nonull);
+	for (j=0; j < nfast; j++)
+	{
+		deformAttr *dattr = &dfm->attrs[j];
+
+		values[j] = deform_fetch_datum(dattr, tp + dattr->attcacheoff);
+		isnull[j] = false;
+	}
+	if (nfast > 0)
+		off = dfm->attrs[nfast-1].attcacheoff + dfm->attrs[nfast-1].attlen;
+
+	/* rest of the attributes */
+	for (; j < natts; j++)
+	{
+		deformAttr *dattr = &dfm->attrs[j];
+
+		if (hasnulls && att_isnull(j, bp))
+		{
+			values[j] = (Datum) 0;
+			isnull[j] = true;
+			continue;
+		}
+		isnull[j] = false;
+		switch (dattr->kind)
+		{
+			case DEFORM_ATTR__VARLENA:
+				off = att_align_pointer(off, dattr->attalign, -1, tp + off);
+				values[j] = PointerGetDatum(tp + off);
+				off += VARSIZE_ANY(tp + off);
+				break;
+			case DEFORM_ATTR__CSTRING:
+				values[j] = PointerGetDatum(tp + off);
+				off += strlen(tp + off) + 1;
+				break;
+			default:
+				off = att_align_nominal(off, dattr->attalign);
+				values[j] = deform_fetch_datum(dattr, tp + off);
+				off += dattr->attlen;
+				break;
+		}
+	}
+	return true;
+}
+
+/*
+ * deform_setup_column - setup properties of the KDS_FORMAT_COLUMN
+ */
+static void
+deform_setup_column(KDSDeformer *dfm, kern_data_store *kds)
+{
+	int		j;
+
+	for (j=0; j < dfm->natts; j++)
+	{
+		kern_colmeta *cmeta = &kds->colmeta[j];
+		size_t		offset = __kds_unpack(cmeta->va_offset);
+		size_t		length = __kds_unpack(cmeta->va_length);
+		char	   *values;
+
+		dfm->col_values[j] = NULL;
+		dfm->col_nullmap[j] = NULL;
+		dfm->col_unitsz[j] = 0;
+		/* special case handling if 'tableoid' system column */
+		if (cmeta->attnum == TableOidAttributeNumber)
+		{
+			dfm->col_values[j] = (char *)&kds->table_oid;
+			continue;
+		}
+		if (offset == 0)
+			continue;		/* all null */
+		values = (char *)kds + offset;
+		dfm->col_values[j] = values;
+		if (cmeta->attlen > 0)
+		{
+			cl_int	unitsz = TYPEALIGN(cmeta->attalign, cmeta->attlen);
+			size_t	array_sz = MAXALIGN(unitsz * kds->nitems);
+
+			dfm->col_unitsz[j] = unitsz;
+			if (length > array_sz)
+				dfm->col_nullmap[j] = (bits8 *)(values + array_sz);
+		}
+	}
+	dfm->curr_kds = kds;
+}
+
+/*
+ * deform_column_row - deform a row of KDS_FORMAT_COLUMN
+ */
+static void
+deform_column_row(KDSDeformer *dfm, TupleTableSlot *slot,
+				  size_t row_index)
+{
+	Datum	   *values = slot->tts_values;
+	bool	   *isnull = slot->tts_isnull;
+	int			j;
+
+	for (j=0; j < dfm->natts; j++)
+	{
+		deformAttr *dattr = &dfm->attrs[j];
+		char	   *base = dfm->col_values[j];
+		bits8	   *nullmap = dfm->col_nullmap[j];
+
+		if (!base || (nullmap && att_isnull(row_index, nullmap)))
+		{
+			values[j] = (Datum) 0;
+			isnull[j] = true;
+		}
+		else if (dattr->kind != DEFORM_ATTR__VARLENA)
+		{
+			values[j] = deform_fetch_datum(dattr, base + (dfm->col_unitsz[j] *
+														  row_index));
+			isnull[j] = false;
+		}
+		else
+		{
+			cl_uint		offset = ((cl_uint *)base)[row_index];
+
+			if (offset == 0)
+			{
+				values[j] = (Datum) 0;
+				isnull[j] = true;
+			}
+			else
+			{
+				values[j] = PointerGetDatum(base + __kds_unpack(offset));
+				isnull[j] = false;
+			}
+		}
+	}
+}
+
+/*
+ * KDS_deform_tuple - fetch a row from the KDS (ROW, HASH, SLOT or COLUMN)
+ * using the specialized deformer.
+ */
+bool
+KDS_deform_tuple(KDSDeformer *dfm,
+				 TupleTableSlot *slot,
+				 kern_data_store *kds,
+				 HeapTuple tuple_buf,
+				 size_t row_index)
+{
+	Assert(dfm->tupdesc == slot->tts_tupleDescriptor);
+	switch (kds->format)
+	{
+		case KDS_FORMAT_ROW:
+		case KDS_FORMAT_HASH:
+			if (row_index < kds->nitems)
+			{
+				kern_tupitem   *tup_item = KERN_DATA_STORE_TUPITEM(kds,
+																   row_index);
+				ExecClearTuple(slot);
+				tuple_buf->t_len  = tup_item->t_len;
+				tuple_buf->t_self = tup_item->t_self;
+				tuple_buf->t_tableOid = kds->table_oid;
+				tuple_buf->t_data = &tup_item->htup;
+
+				ExecStoreTuple(tuple_buf, slot, InvalidBuffer, false);
+				if (deform_heap_tuple(dfm, slot, &tup_item->htup))
+					slot->tts_nvalid = dfm->natts;
+				return true;
+			}
+			return false;
+
+		case KDS_FORMAT_SLOT:
+			if (row_index < kds->nitems)
+			{
+				ExecClearTuple(slot);
+				memcpy(slot->tts_values,
+					   KERN_DATA_STORE_VALUES(kds, row_index),
+					   sizeof(Datum) * dfm->natts);
+				memcpy(slot->tts_isnull,
+					   KERN_DATA_STORE_ISNULL(kds, row_index),
+					   sizeof(bool) * dfm->natts);
+				ExecStoreVirtualTuple(slot);
+				return true;
+			}
+			return false;
+
+		case KDS_FORMAT_COLUMN:
+			if (kds->ncols != dfm->natts || dfm->has_cstring)
+				return KDS_fetch_tuple_column(slot, kds, row_index);
+			if (row_index >= kds->nitems)
+			{
+				ExecClearTuple(slot);
+				return false;
+			}
+			/* pgstromResetTupleDeformers() shall be called on a new KDS */
+			if (dfm->curr_kds != kds)
+				deform_setup_column(dfm, kds);
+			ExecClearTuple(slot);
+			deform_column_row(dfm, slot, row_index);
+			ExecStoreVirtualTuple(slot);
+			return true;
+
+		default:
+			elog(ERROR, "Bug? unsupported data store format: %d",
+				 kds->format);
+	}
+	return false;	/* not reachable */
+}
+
+/*
+ * ----------------------------------------------------------------
+ *
+ * Micro-benchmark of the deformer
+ *
+ * ----------------------------------------------------------------
+ */
+#define BENCH_DEFORM_MAX_NROWS		10000000
+
+typedef struct
+{
+	int			ntuples;
+	HeapTuple  *tuples;
+	Datum	  **values;
+	bool	  **isnull;
+} benchDeformSource;
+
+/*
+ * bench_build_kds_row
+ */
+static kern_data_store *
+bench_build_kds_row(TupleDesc tupdesc, TupleTableSlot *slot,
+					benchDeformSource *src)
+{
+	kern_data_store *kds;
+	size_t		usage = 0;
+	size_t		length;
+	int			i;
+
+	for (i=0; i < src->ntuples; i++)
+		usage += MAXALIGN(offsetof(kern_tupitem, htup) +
+						  src->tuples[i]->t_len);
+	length = KDS_CALCULATE_ROW_LENGTH(tupdesc->natts, src->ntuples, usage);
+	kds = palloc_huge(length);
+	init_kernel_data_store(kds, tupdesc, length,
+						   KDS_FORMAT_ROW, src->ntuples, false);
+	for (i=0; i < src->ntuples; i++)
+	{
+		ExecStoreTuple(src->tuples[i], slot, InvalidBuffer, false);
+		if (!KDS_insert_tuple(kds, slot))
+			elog(ERROR, "Bug? KDS_FORMAT_ROW has no room");
+	}
+	ExecClearTuple(slot);
+
+	return kds;
+}
+
+/*
+ * bench_build_kds_slot
+ */
+static kern_data_store *
+bench_build_kds_slot(TupleDesc tupdesc, benchDeformSource *src)
+{
+	kern_data_store *kds;
+	size_t		length;
+	int			i;
+
+	length = KDS_CALCULATE_SLOT_LENGTH(tupdesc->natts, src->ntuples);
+	kds = palloc_huge(length);
+	init_kernel_data_store(kds, tupdesc, length,
+						   KDS_FORMAT_SLOT, src->ntuples, false);
+	for (i=0; i < src->ntuples; i++)
+	{
+		memcpy(KERN_DATA_STORE_VALUES(kds, i), src->values[i],
+			   sizeof(Datum) * tupdesc->natts);
+		memcpy(KERN_DATA_STORE_ISNULL(kds, i), src->isnull[i],
+			   sizeof(bool) * tupdesc->natts);
+	}
+	kds->nitems = src->ntuples;
+
+	return kds;
+}
+
+/*
+ * bench_build_kds_column - see ccache_copy_buffer_to_kds
+ */
+static kern_data_store *
+bench_build_kds_column(TupleDesc tupdesc, benchDeformSource *src)
+{
+	kern_data_store *kds;
+	size_t		nitems = src->ntuples;
+	size_t		length = KDS_CALCULATE_HEAD_LENGTH(tupdesc->natts, false);
+	char	   *pos;
+	size_t		i, j;
+
+	for (j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = tupleDescAttr(tupdesc, j);
+
+		if (attr->attisdropped)
+			continue;
+		if (attr->attlen == -2)
+			return NULL;	/* cstring is not supported */
+		if (attr->attlen < 0)
+		{
+			length += MAXALIGN(sizeof(cl_uint) * nitems);
+			for (i=0; i < nitems; i++)
+			{
+				if (!src->isnull[i][j])
+					length += MAXALIGN(VARSIZE_ANY(src->values[i][j]));
+			}
+		}
+		else
+		{
+			length += MAXALIGN(att_align_nominal(attr->attlen,
+												 attr->attalign) * nitems);
+			length += MAXALIGN(BITMAPLEN(nitems));
+		}
+	}
+	kds = palloc_huge(length);
+	init_kernel_data_store(kds, tupdesc, length,
+						   KDS_FORMAT_COLUMN, nitems, false);
+	pos = KERN_DATA_STORE_BODY(kds);
+	for (j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = tupleDescAttr(tupdesc, j);
+		kern_colmeta   *cmeta = &kds->colmeta[j];
+		char		   *base = pos;
+
+		if (attr->attisdropped)
+			continue;
+		cmeta->va_offset = __kds_packed(pos - (char *)kds);
+		if (attr->attlen < 0)
+		{
+			cl_uint	   *offsets = (cl_uint *)base;
+			char	   *extra = base + MAXALIGN(sizeof(cl_uint) * nitems);
+
+			for (i=0; i < nitems; i++)
+			{
+				if (src->isnull[i][j])
+					offsets[i] = 0;
+				else
+				{
+					struct varlena *vl = (struct varlena *)
+						DatumGetPointer(src->values[i][j]);
+
+					offsets[i] = __kds_packed(extra - base);
+					memcpy(extra, vl, VARSIZE_ANY(vl));
+					extra += MAXALIGN(VARSIZE_ANY(vl));
+				}
+			}
+			pos = extra;
+		}
+		else
+		{
+			int		unitsz = att_align_nominal(attr->attlen,
+											   attr->attalign);
+			bits8  *nullmap = (bits8 *)(pos + MAXALIGN(unitsz * nitems));
+
+			memset(nullmap, 0, MAXALIGN(BITMAPLEN(nitems)));
+			for (i=0; i < nitems; i++)
+			{
+				char   *dest = pos + unitsz * i;
+
+				if (src->isnull[i][j])
+					memset(dest, 0, attr->attlen);
+				else
+				{
+					nullmap[i >> 3] |= (1 << (i & 7));
+					if (!attr->attbyval)
+						memcpy(dest, DatumGetPointer(src->values[i][j]),
+							   attr->attlen);
+					else
+						store_att_byval(dest, src->values[i][j],
+										attr->attlen);
+				}
+			}
+			pos += MAXALIGN(unitsz * nitems) + MAXALIGN(BITMAPLEN(nitems));
+		}
+		cmeta->va_length = __kds_packed(pos - base);
+	}
+	Assert(pos - (char *)kds == length);
+	kds->nitems = nitems;
+	kds->usage = __kds_packed(pos - (char *)kds);
+
+	return kds;
+}
+
+/*
+ * bench_fetch_kds - fetch all the rows in KDS @nloops times, then returns
+ * the elapsed time in milliseconds.
+ */
+static double
+bench_fetch_kds(KDSDeformer *dfm, TupleTableSlot *slot,
+				kern_data_store *kds, int nloops)
+{
+	HeapTupleData	tuple_buf;
+	instr_time		tv1, tv2;
+	size_t			i;
+	int				loop;
+
+	INSTR_TIME_SET_CURRENT(tv1);
+	for (loop=0; loop < nloops; loop++)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		for (i=0; ; i++)
+		{
+			bool	status;
+
+			if (dfm)
+				status = KDS_deform_tuple(dfm, slot, kds, &tuple_buf, i);
+			else if (kds->format == KDS_FORMAT_ROW)
+				status = KDS_fetch_tuple_row(slot, kds, &tuple_buf, i);
+			else if (kds->format == KDS_FORMAT_SLOT)
+				status = KDS_fetch_tuple_slot(slot, kds, i);
+			else
+				status = KDS_fetch_tuple_column(slot, kds, i);
+			if (!status)
+				break;
+			/* consumer references all the attributes */
+			slot_getallattrs(slot);
+		}
+	}
+	INSTR_TIME_SET_CURRENT(tv2);
+	INSTR_TIME_SUBTRACT(tv2, tv1);
+
+	return INSTR_TIME_GET_MILLISEC(tv2);
+}
+
+/*
+ * pgstrom_bench_tuple_deform
+ *
+ * It loads the first @nrows rows of the relation onto KDS of ROW, SLOT
+ * and COLUMN format, then compares the generic fetch and the specialized
+ * deformer.
+ */
+Datum
+pgstrom_bench_tuple_deform(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *fncxt;
+	HeapTuple		tuple;
+	Datum		   *results;
+	Datum			values[5];
+	bool			isnull[5];
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		Oid				relid = PG_GETARG_OID(0);
+		int				nrows = PG_GETARG_INT32(1);
+		int				nloops = PG_GETARG_INT32(2);
+		TupleDesc		tupdesc;
+		TupleDesc		rel_tupdesc;
+		TupleTableSlot *slot;
+		Relation		relation;
+		HeapScanDesc	scan;
+		KDSDeformer	   *dfm;
+		benchDeformSource src;
+		MemoryContext	oldcxt;
+		MemoryContext	bench_cxt;
+		int				fmt;
+
+		if (nrows < 1 || nloops < 1)
+			elog(ERROR, "number of rows and loops must be positive");
+		if (nrows > BENCH_DEFORM_MAX_NROWS)
+			elog(ERROR, "number of rows must be less than or equal to %d",
+				 BENCH_DEFORM_MAX_NROWS);
+		aclcheck_error(pg_class_aclcheck(relid, GetUserId(), ACL_SELECT),
+#if PG_VERSION_NUM < 110000
+					   ACL_KIND_CLASS,
+#else
+					   OBJECT_TABLE,
+#endif
+					   get_rel_name(relid));
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(5, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "format",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "nitems",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "generic_ms",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "specialized_ms",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "speedup",
+						   FLOAT8OID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+		results = palloc0(sizeof(Datum) * 3 * 4);
+		fncxt->user_fctx = results;
+		MemoryContextSwitchTo(oldcxt);
+
+		bench_cxt = AllocSetContextCreate(CurrentMemoryContext,
+										  "tuple deform benchmark",
+										  ALLOCSET_DEFAULT_SIZES);
+		oldcxt = MemoryContextSwitchTo(bench_cxt);
+
+		/* load the source rows */
+		relation = heap_open(relid, AccessShareLock);
+		if (RelationGetForm(relation)->relkind != RELKIND_RELATION &&
+			RelationGetForm(relation)->relkind != RELKIND_MATVIEW)
+			elog(ERROR, "\"%s\" is not a table or materialized view",
+				 RelationGetRelationName(relation));
+		rel_tupdesc = CreateTupleDescCopyConstr(RelationGetDescr(relation));
+		slot = MakeSingleTupleTableSlot(rel_tupdesc);
+
+		memset(&src, 0, sizeof(benchDeformSource));
+		src.tuples = palloc_huge(sizeof(HeapTuple) * nrows);
+		src.values = palloc_huge(sizeof(Datum *) * nrows);
+		src.isnull = palloc_huge(sizeof(bool *) * nrows);
+		scan = heap_beginscan(relation, GetActiveSnapshot(), 0, NULL);
+		while (src.ntuples < nrows &&
+			   (tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+		{
+			HeapTuple	htup = heap_copytuple(tuple);
+			int			i = src.ntuples++;
+			int			j;
+
+			src.tuples[i] = htup;
+			src.values[i] = palloc(sizeof(Datum) * rel_tupdesc->natts);
+			src.isnull[i] = palloc(sizeof(bool) * rel_tupdesc->natts);
+			heap_deform_tuple(htup, rel_tupdesc,
+							  src.values[i], src.isnull[i]);
+			/* device code cannot de-toast external/compressed datum */
+			for (j=0; j < rel_tupdesc->natts; j++)
+			{
+				Form_pg_attribute attr = tupleDescAttr(rel_tupdesc, j);
+
+				if (attr->attlen == -1 && !src.isnull[i][j])
+					src.values[i][j] =
+						PointerGetDatum(PG_DETOAST_DATUM(src.values[i][j]));
+			}
+		}
+		heap_endscan(scan);
+		heap_close(relation, AccessShareLock);
+
+		dfm = KDS_create_deformer(rel_tupdesc);
+		for (fmt=0; fmt < 3; fmt++)
+		{
+			kern_data_store *kds;
+			const char *label;
+			double		generic_ms;
+			double		special_ms;
+
+			if (fmt == 0)
+			{
+				label = "row";
+				kds = bench_build_kds_row(rel_tupdesc, slot, &src);
+			}
+			else if (fmt == 1)
+			{
+				label = "slot";
+				kds = bench_build_kds_slot(rel_tupdesc, &src);
+			}
+			else
+			{
+				label = "column";
+				kds = bench_build_kds_column(rel_tupdesc, &src);
+			}
+			if (!kds)
+				continue;
+			generic_ms = bench_fetch_kds(NULL, slot, kds, nloops);
+			dfm->curr_kds = NULL;	/* previous KDS is already released */
+			special_ms = bench_fetch_kds(dfm, slot, kds, nloops);
+			ExecClearTuple(slot);
+
+			MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+			results[4 * fncxt->max_calls + 0] = CStringGetTextDatum(label);
+			results[4 * fncxt->max_calls + 1] = Int64GetDatum(kds->nitems);
+			results[4 * fncxt->max_calls + 2] = Float8GetDatum(generic_ms);
+			results[4 * fncxt->max_calls + 3] = Float8GetDatum(special_ms);
+			fncxt->max_calls++;
+			MemoryContextSwitchTo(bench_cxt);
+			pfree(kds);
+		}
+		ExecDropSingleTupleTableSlot(slot);
+		MemoryContextSwitchTo(oldcxt);
+		MemoryContextDelete(bench_cxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+
+	if (fncxt->call_cntr >= fncxt->max_calls)
+		SRF_RETURN_DONE(fncxt);
+	results = (Datum *)fncxt->user_fctx + 4 * fncxt->call_cntr;
+
+	memset(isnull, 0, sizeof(isnull));
+	values[0] = results[0];
+	values[1] = results[1];
+	values[2] = results[2];
+	values[3] = results[3];
+	if (DatumGetFloat8(results[3]) > 0.0)
+		values[4] = Float8GetDatum(DatumGetFloat8(results[2]) /
+								   DatumGetFloat8(results[3]));
+	else
+		isnull[4] = true;
+	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+
+	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+}
+PG_FUNCTION_INFO_V1(pgstrom_bench_tuple_deform);
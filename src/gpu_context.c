@@ -704,6 +704,34 @@ GpuContextWorkerMain(void *arg)
 				pthreadMutexUnlock(gcontext->mutex);
 
 				gts = gtask->gts;
+				if (gts->cb_build_fallback)
+				{
+					/*
+					 * If GPU program is still being built, this chunk is
+					 * processed by the CPU fallback code, instead of the
+					 * synchronous wait for the program builders.
+					 * pg_strom.debug_force_cpu_fallback also makes all the
+					 * chunks processed by the CPU fallback code.
+					 */
+					if ((pgstrom_debug_force_cpu_fallback ||
+						 !pgstrom_cuda_program_is_ready(gtask->program_id)) &&
+						gts->cb_build_fallback(gtask))
+					{
+						pthreadMutexLock(gcontext->mutex);
+						dlist_push_tail(&gts->ready_tasks,
+										&gtask->chain);
+						gts->num_running_tasks--;
+						gts->num_ready_tasks++;
+						gts->num_build_fallbacks++;
+						pthreadMutexUnlock(gcontext->mutex);
+
+						SetLatch(MyLatch);
+						continue;
+					}
+					pthreadMutexLock(gcontext->mutex);
+					gts->num_build_switched++;
+					pthreadMutexUnlock(gcontext->mutex);
+				}
 				cuda_module = GpuContextLookupModule(gcontext,
 													 gtask->program_id);
 			retry_gputask:
@@ -17,6 +17,77 @@
  */
 #include "pg_strom.h"
 
+/*
+ * fetch_kern_param_value
+ *
+ * It fetches the current value of the Param node. See ExecEvalParamExec
+ * and ExecEvalParamExtern also.
+ */
+static Datum
+fetch_kern_param_value(Param *param, ExprContext *econtext, bool *p_isnull)
+{
+	ParamListInfo param_info = econtext->ecxt_param_list_info;
+	int		param_id = param->paramid;
+	Datum	param_value;
+	bool	param_isnull;
+
+	if (!param_info ||
+		param_id < 1 || param_id > param_info->numParams)
+		elog(ERROR, "no value found for parameter %d", param_id);
+
+	if (param->paramkind == PARAM_EXEC)
+	{
+		/* See ExecEvalParamExec */
+		ParamExecData  *prm
+			= &(econtext->ecxt_param_exec_vals[param_id]);
+		if (prm->execPlan != NULL)
+		{
+			/* Parameter not evaluated yet, so go do it */
+			ExecSetParamPlan(prm->execPlan, econtext);
+			/* ExecSetParamPlan should have processed this param... */
+			Assert(prm->execPlan == NULL);
+		}
+		param_isnull = prm->isnull;
+		param_value  = prm->value;
+	}
+	else if (param->paramkind == PARAM_EXTERN)
+	{
+		/* ExecEvalParamExtern */
+		ParamExternData *prm;
+		ParamExternData  prmData __attribute__((unused));
+
+#if PG_VERSION_NUM < 110000
+		prm = &param_info->params[param_id - 1];
+		if (!OidIsValid(prm->ptype) && param_info->paramFetch != NULL)
+			(*param_info->paramFetch) (param_info, param_id);
+#else
+		if (param_info->paramFetch != NULL)
+			prm = param_info->paramFetch(param_info, param_id,
+										 false, &prmData);
+		else
+			prm = &param_info->params[param_id - 1];
+#endif
+		if (!OidIsValid(prm->ptype))
+			elog(ERROR, "no value found for parameter %d", param_id);
+		else if (prm->ptype != param->paramtype)
+			elog(ERROR,
+				 "type of parameter %d (%s) does not match that "
+				 "when preparing the plan (%s)",
+				 param_id,
+				 format_type_be(prm->ptype),
+				 format_type_be(param->paramtype));
+		param_isnull = prm->isnull;
+		param_value  = prm->value;
+	}
+	else
+	{
+		elog(ERROR, "Bug? unexpected parameter kind: %d",
+			 (int)param->paramkind);
+	}
+	*p_isnull = param_isnull;
+	return param_value;
+}
+
 /*
  * construct_kern_parambuf
  *
@@ -79,65 +150,12 @@ construct_kern_parambuf(List *used_params, ExprContext *econtext,
 		}
 		else if (IsA(node, Param))
 		{
-			ParamListInfo param_info = econtext->ecxt_param_list_info;
 			Param  *param = (Param *) node;
-			int		param_id = param->paramid;
 			Datum	param_value;
 			bool	param_isnull;
 
-			if (!param_info ||
-				param_id < 1 || param_id > param_info->numParams)
-				elog(ERROR, "no value found for parameter %d", param_id);
-
-			if (param->paramkind == PARAM_EXEC)
-			{
-				/* See ExecEvalParamExec */
-				ParamExecData  *prm
-					= &(econtext->ecxt_param_exec_vals[param_id]);
-				if (prm->execPlan != NULL)
-				{
-					/* Parameter not evaluated yet, so go do it */
-					ExecSetParamPlan(prm->execPlan, econtext);
-					/* ExecSetParamPlan should have processed this param... */
-					Assert(prm->execPlan == NULL);
-				}
-				param_isnull = prm->isnull;
-				param_value  = prm->value;
-			}
-			else if (param->paramkind == PARAM_EXTERN)
-			{
-				/* ExecEvalParamExtern */
-				ParamExternData *prm;
-				ParamExternData  prmData __attribute__((unused));
-
-#if PG_VERSION_NUM < 110000
-				prm = &param_info->params[param_id - 1];
-				if (!OidIsValid(prm->ptype) && param_info->paramFetch != NULL)
-					(*param_info->paramFetch) (param_info, param_id);
-#else
-				if (param_info->paramFetch != NULL)
-					prm = param_info->paramFetch(param_info, param_id,
-												 false, &prmData);
-				else
-					prm = &param_info->params[param_id - 1];
-#endif
-				if (!OidIsValid(prm->ptype))
-					elog(ERROR, "no value found for parameter %d", param_id);
-				else if (prm->ptype != param->paramtype)
-					elog(ERROR,
-						 "type of parameter %d (%s) does not match that "
-						 "when preparing the plan (%s)",
-						 param_id,
-						 format_type_be(prm->ptype),
-						 format_type_be(param->paramtype));
-				param_isnull = prm->isnull;
-				param_value  = prm->value;
-			}
-			else
-			{
-				elog(ERROR, "Bug? unexpected parameter kind: %d",
-					 (int)param->paramkind);
-			}
+			param_value = fetch_kern_param_value(param, econtext,
+												 &param_isnull);
 			kparams = (kern_parambuf *)str.data;
 			if (param_isnull)
 				kparams->poffset[index] = 0;	/* null */
@@ -171,6 +189,44 @@ construct_kern_parambuf(List *used_params, ExprContext *econtext,
 				}
 			}
 		}
+		else if (IsA(node, ScalarArrayOpExpr))
+		{
+			/*
+			 * hash-set of (scalar = ANY($n)); see codegen.c. The array
+			 * parameter is only available on execution time.
+			 */
+			Node   *arg = lsecond(((ScalarArrayOpExpr *) node)->args);
+			Datum	param_value;
+			bool	param_isnull;
+
+			if (IsA(arg, Var) &&
+				((Var *)arg)->varno == INDEX_VAR &&
+				((Var *)arg)->varattno <= list_length(custom_scan_tlist))
+			{
+				TargetEntry *tle = list_nth(custom_scan_tlist,
+											((Var *)arg)->varattno - 1);
+				arg = (Node *)tle->expr;
+			}
+			if (!IsA(arg, Param))
+				elog(ERROR, "unexpected node: %s", nodeToString(node));
+			param_value = fetch_kern_param_value((Param *) arg, econtext,
+												 &param_isnull);
+			kparams = (kern_parambuf *)str.data;
+			if (param_isnull)
+				kparams->poffset[index] = 0;	/* null */
+			else
+			{
+				ArrayType	   *array = DatumGetArrayTypeP(param_value);
+				kern_hashset   *hset = pgstrom_build_array_hashset(array);
+
+				if (!hset)
+					elog(ERROR, "array of parameter %d is too large to build hash-set",
+						 ((Param *) arg)->paramid);
+				kparams->poffset[index] = str.len;
+				appendBinaryStringInfo(&str, (char *)hset, VARSIZE(hset));
+				pfree(hset);
+			}
+		}
 		else if (!nested_custom_scan_tlist &&
 				 IsA(node, Var) &&
 				 custom_scan_tlist != NIL &&
@@ -269,6 +325,7 @@ pgstromInitGpuTaskState(GpuTaskState *gts,
 	gts->scan_overflow = NULL;
 	gts->outer_nrows_per_block = outer_nrows_per_block;
 	gts->nvme_sstate = NULL;
+	gts->deformers = NULL;
 
 	/*
 	 * NOTE: initialization of HeapScanDesc was moved to the first try of
@@ -476,6 +533,7 @@ pgstromExecGpuTaskState(GpuTaskState *gts)
 		gts->curr_task = gtask;
 		gts->curr_index = 0;
 		gts->curr_lp_index = 0;
+		pgstromResetTupleDeformers(gts);
 		/* notify a new task is assigned */
 		if (gts->cb_switch_task)
 			gts->cb_switch_task(gts, gtask);
@@ -510,6 +568,8 @@ pgstromRescanGpuTaskState(GpuTaskState *gts)
 	{
 		InstrEndLoop(&gts->outer_instrument);
 		heap_rescan(scan, NULL);
+		pgstromExecRewindBrinIndexMap(gts);
+		pgstromExecRewindZoneMap(gts);
 #if PG_VERSION_NUM < 100000
 		/*
 		 * In PG9.6, re-initialization of DSM segment is a role of ReScan
@@ -521,13 +581,17 @@ pgstromRescanGpuTaskState(GpuTaskState *gts)
 			GpuTaskSharedState *gtss = gts->gtss;
 
 			Assert(&gtss->phscan == scan->rs_parallel);
-			SpinLockAcquire(&gtss->phscan.phs_mutex);
-			
-			SpinLockRelease(&gtss->phscan.phs_mutex);
+			pg_atomic_write_u64(&gtss->nr_allocated, 0);
 		}
 #endif
 		ExecScanReScan(&gts->css.ss);
 	}
+	else if (gts->af_state)
+	{
+		InstrEndLoop(&gts->outer_instrument);
+		ExecReScanArrowFdw(gts->af_state);
+		ExecScanReScan(&gts->css.ss);
+	}
 }
 
 /*
@@ -553,6 +617,11 @@ pgstromReleaseGpuTaskState(GpuTaskState *gts, GpuTaskRuntimeStat *gt_rtstat)
 	/* release scan-desc if any */
 	if (gts->css.ss.ss_currentScanDesc)
 		heap_endscan(gts->css.ss.ss_currentScanDesc);
+	/* release Arrow_fdw state if any */
+	if (gts->af_state)
+		ExecEndArrowFdw(gts->af_state);
+	/* release zone map state if any */
+	pgstromExecEndZoneMap(gts);
 	/* unreference CUDA program */
 	if (gts->program_id != INVALID_PROGRAM_ID)
 		pgstrom_put_cuda_program(gts->gcontext, gts->program_id);
@@ -587,7 +656,7 @@ pgstromExplainGpuTaskState(GpuTaskState *gts, ExplainState *es)
 	if (gts->css.ss.ss_currentRelation &&
 		(!es->analyze
 		 ? gts->outer_nrows_per_block > 0
-		 : gts->nvme_sstate != NULL))
+		 : gts->nvme_sstate != NULL && gts->nvme_sstate->direct_load))
 	{
 		if (!gts->nvme_sstate)
 			ExplainPropertyText("NVMe-Strom", "enabled", es);
@@ -597,7 +666,8 @@ pgstromExplainGpuTaskState(GpuTaskState *gts, ExplainState *es)
 				ExplainPropertyText("NVMe-Strom", "enabled", es);
 			else
 			{
-				snprintf(temp, sizeof(temp), "load=%ld", gts->nvme_count);
+				snprintf(temp, sizeof(temp), "load=%ld%s", gts->nvme_count,
+						 gts->nvme_sstate->emulated ? " (emulated)" : "");
 				ExplainPropertyText("NVMe-Strom", temp, es);
 			}
 		}
@@ -611,11 +681,58 @@ pgstromExplainGpuTaskState(GpuTaskState *gts, ExplainState *es)
 	else if (es->format != EXPLAIN_FORMAT_TEXT)
 		ExplainPropertyText("NVMe-Strom", "disabled", es);
 
+	/* Whole-page copy of the buffered blocks */
+	if (es->analyze &&
+		gts->nvme_sstate != NULL && !gts->nvme_sstate->direct_load)
+		ExplainPropertyText("Page Copy", "enabled", es);
+
+	/* Columnar cache support */
+	if (gts->css.ss.ss_currentRelation &&
+		RelationCanUseColumnarCache(gts->css.ss.ss_currentRelation))
+	{
+		if (!es->analyze)
+			ExplainPropertyText("CCache", "enabled", es);
+		else
+			ExplainPropertyInteger("CCache Hits",
+								   NULL, gts->ccache_count, es);
+	}
+	else if (es->format != EXPLAIN_FORMAT_TEXT)
+		ExplainPropertyText("CCache", "disabled", es);
+
+	/* Arrow_fdw support */
+	if (gts->af_state)
+		ExplainArrowFdw(gts->af_state, gts->css.ss.ss_currentRelation, es);
+
+	/* Zone map support */
+	pgstromExplainZoneMap(gts, es);
+
 	/* Number of CPU fallbacks, if any */
 	if (es->analyze && gts->num_cpu_fallbacks > 0)
 		ExplainPropertyInteger("CPU fallbacks",
 							   NULL, gts->num_cpu_fallbacks, es);
 
+	/* Number of chunks processed prior to/after the JIT build */
+	if (es->analyze && gts->num_build_fallbacks > 0)
+	{
+		if (es->format == EXPLAIN_FORMAT_TEXT)
+		{
+			char	temp[200];
+
+			snprintf(temp, sizeof(temp),
+					 "%ld chunks on CPU, then %ld chunks on GPU",
+					 gts->num_build_fallbacks,
+					 gts->num_build_switched);
+			ExplainPropertyText("JIT Build Fallback", temp, es);
+		}
+		else
+		{
+			ExplainPropertyInteger("JIT Build Fallback CPU Chunks",
+								   NULL, gts->num_build_fallbacks, es);
+			ExplainPropertyInteger("JIT Build Fallback GPU Chunks",
+								   NULL, gts->num_build_switched, es);
+		}
+	}
+
 	/* Source path of the GPU kernel */
 	if (es->verbose &&
 		gts->program_id != INVALID_PROGRAM_ID &&
@@ -662,7 +779,12 @@ pgstromInitDSMGpuTaskState(GpuTaskState *gts,
 
 	if (relation)
 	{
-		gtss->nr_allocated = 0;
+		pg_atomic_init_u64(&gtss->nr_allocated, 0);
+		/*
+		 * including the leader; workers are not launched yet, so the leader
+		 * replaces it by the number of launched ones on the scan.
+		 */
+		pg_atomic_init_u32(&gtss->nr_workers, pcxt->nworkers + 1);
 		heap_parallelscan_initialize(&gtss->phscan, relation, snapshot);
 		/* per workers initialization inclusing the coordinator */
 		pgstromInitWorkerGpuTaskState(gts, coordinate);
@@ -702,9 +824,10 @@ pgstromReInitializeDSMGpuTaskState(GpuTaskState *gts)
 	if (gtss)
 	{
 		/* see heap_parallelscan_reinitialize */
-		SpinLockAcquire(&gtss->phscan.phs_mutex);
-		gtss->nr_allocated = 0;
-		SpinLockRelease(&gtss->phscan.phs_mutex);
+		pg_atomic_write_u64(&gtss->nr_allocated, 0);
+		/* workers shall be launched again */
+		if (gts->pcxt)
+			pg_atomic_write_u32(&gtss->nr_workers, gts->pcxt->nworkers + 1);
 	}
 }
 
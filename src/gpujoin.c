@@ -36,6 +36,8 @@ typedef struct
 	List		   *index_quals;
 	cl_long			index_nblocks;
 	cl_int		   *sibling_param_id; /* only if partition-wise join child */
+	bool			inner_reordered; /* true, if inners[] were permuted */
+	Bitmapset	   *late_attrs;		/* outer columns to be fetched late */
 	struct {
 		JoinType	join_type;		/* one of JOIN_* */
 		double		join_nrows;		/* intermediate nrows in this depth */
@@ -78,6 +80,11 @@ typedef struct
 	List	   *other_quals;
 	List	   *hash_inner_keys;	/* if hash-join */
 	List	   *hash_outer_keys;	/* if hash-join */
+	bool		inner_reordered;	/* true, if inner relations were permuted */
+	List	   *inner_order;		/* list of String; name of inner relations */
+	/* late materialization of the outer columns */
+	List	   *late_refs;		/* ps_tlist resno to be fetched by host */
+	int			late_ctid;		/* ps_tlist resno of the outer ctid */
 	/* supplemental information of ps_tlist */
 	List	   *ps_src_depth;	/* source depth of the ps_tlist entry */
 	List	   *ps_src_resno;	/* source resno of the ps_tlist entry */
@@ -116,6 +123,10 @@ form_gpujoin_info(CustomScan *cscan, GpuJoinInfo *gj_info)
 	exprs = lappend(exprs, gj_info->other_quals);
 	exprs = lappend(exprs, gj_info->hash_inner_keys);
 	exprs = lappend(exprs, gj_info->hash_outer_keys);
+	privs = lappend(privs, makeInteger(gj_info->inner_reordered));
+	privs = lappend(privs, gj_info->inner_order);
+	privs = lappend(privs, gj_info->late_refs);
+	privs = lappend(privs, makeInteger(gj_info->late_ctid));
 
 	privs = lappend(privs, gj_info->ps_src_depth);
 	privs = lappend(privs, gj_info->ps_src_resno);
@@ -160,6 +171,10 @@ deform_gpujoin_info(CustomScan *cscan)
 	gj_info->other_quals = list_nth(exprs, eindex++);
 	gj_info->hash_inner_keys = list_nth(exprs, eindex++);
     gj_info->hash_outer_keys = list_nth(exprs, eindex++);
+	gj_info->inner_reordered = intVal(list_nth(privs, pindex++));
+	gj_info->inner_order = list_nth(privs, pindex++);
+	gj_info->late_refs = list_nth(privs, pindex++);
+	gj_info->late_ctid = intVal(list_nth(privs, pindex++));
 
 	gj_info->ps_src_depth = list_nth(privs, pindex++);
 	gj_info->ps_src_resno = list_nth(privs, pindex++);
@@ -255,6 +270,24 @@ typedef struct
 	cl_long			fallback_thread_count;
 	cl_long			fallback_outer_index;
 
+	/*
+	 * Bloom filter on the depth-1 inner join-keys
+	 */
+	bool			bloom_ready;	/* true, if already set up */
+	struct GpuJoinBloomFilter *bloom; /* on the kmrels DSM, if active */
+	TupleTableSlot *slot_bloom;		/* outer row to evaluate hash-keys */
+	cl_ulong		bloom_nprobed;	/* # of rows probed in this process */
+	cl_ulong		bloom_nremoved;	/* # of rows removed in this process */
+
+	/*
+	 * Late materialization of the wide outer columns
+	 */
+	TupleTableSlot *slot_late;		/* virtual slot to fill up late columns */
+	int				late_nattrs;
+	AttrNumber	   *late_dst_resno;	/* resno on the scan tuple slot */
+	AttrNumber	   *late_src_anum;	/* attnum on the outer relation */
+	AttrNumber		late_ctid_resno; /* resno of the outer ctid */
+
 	/*
 	 * Properties of underlying inner relations
 	 */
@@ -309,6 +342,7 @@ typedef struct GpuJoinSiblingState	GpuJoinSiblingState;
 struct GpuJoinRuntimeStat
 {
 	GpuTaskRuntimeStat	c;		/* common statistics */
+	pg_atomic_uint64	bloom_nremoved;	/* # of rows removed by bloom filter */
 	struct {
 		pg_atomic_uint64 inner_nitems;
 		pg_atomic_uint64 right_nitems;
@@ -320,6 +354,49 @@ typedef struct GpuJoinRuntimeStat	GpuJoinRuntimeStat;
 	((GpuJoinRuntimeStat *)((char *)(gj_sstate) +				\
 							(gj_sstate)->offset_runtime_stat))
 
+/*
+ * GpuJoinBloomFilter - bloom filter on the hash-value of the depth-1 inner
+ * relation, and range of its join-keys, built during the inner preload.
+ * It is located next to the outer-join maps on the kmrels DSM segment, so
+ * parallel workers and partition siblings can share it, but never sent to
+ * the device memory.
+ * Outer rows which never match the inner relation are removed prior to
+ * the DMA send, if outer rows are fetched from the child plan. If outer
+ * relation scan is pulled up, the range of join-keys is given to the zone
+ * map, to skip block ranges instead.
+ */
+#define GPUJOIN_BLOOM_NKEYS_MAX		4
+#define GPUJOIN_BLOOM_NHASHES		3
+#define GPUJOIN_BLOOM_BITS_PER_ITEM	8
+#define GPUJOIN_BLOOM_NBITS_MAX		(1UL << 29)		/* 64MB */
+#define GPUJOIN_BLOOM_PROBE_NROWS	10000
+#define GPUJOIN_BLOOM_MIN_RATIO		0.05
+
+typedef struct
+{
+	Oid			type_oid;		/* InvalidOid, if range is not tracked */
+	Oid			collid;
+	cl_bool		has_value;		/* true, if min/max_value are valid */
+	Datum		min_value;
+	Datum		max_value;
+} GpuJoinBloomKey;
+
+struct GpuJoinBloomFilter
+{
+	cl_ulong		nbits;		/* number of bits (power of 2), or zero */
+	cl_int			nkeys;		/* number of join-keys tracked */
+	GpuJoinBloomKey	keys[GPUJOIN_BLOOM_NKEYS_MAX];
+	cl_ulong		bitmap[FLEXIBLE_ARRAY_MEMBER];
+};
+typedef struct GpuJoinBloomFilter	GpuJoinBloomFilter;
+
+#define GPUJOIN_BLOOM_FILTER_OFFSET(h_kmrels)					\
+	STROMALIGN((h_kmrels)->kmrels_length +						\
+			   (h_kmrels)->ojmaps_length * (numDevAttrs + 1))
+#define GPUJOIN_BLOOM_FILTER(h_kmrels)							\
+	((GpuJoinBloomFilter *)((char *)(h_kmrels) +				\
+							GPUJOIN_BLOOM_FILTER_OFFSET(h_kmrels)))
+
 /*
  * GpuJoinTask - task object of GpuJoin
  */
@@ -342,6 +419,9 @@ static CustomExecMethods	gpujoin_exec_methods;
 static bool					enable_gpunestloop;				/* GUC */
 static bool					enable_gpuhashjoin;				/* GUC */
 static bool					enable_partitionwise_gpujoin;	/* GUC */
+static bool					enable_gpujoin_inner_reorder;	/* GUC */
+static bool					enable_gpujoin_bloom_filter;	/* GUC */
+static bool					enable_gpujoin_late_materialization; /* GUC */
 
 static int					num_partition_siblings = 0;
 
@@ -351,6 +431,7 @@ static GpuTask *gpujoin_next_task(GpuTaskState *gts);
 static GpuTask *gpujoin_terminator_task(GpuTaskState *gts,
 										cl_bool *task_is_ready);
 static TupleTableSlot *gpujoin_next_tuple(GpuTaskState *gts);
+static bool gpujoin_build_fallback(GpuTask *gtask);
 static pg_crc32 get_tuple_hashvalue(innerState *istate,
 									bool is_inner_hashkeys,
 									TupleTableSlot *slot,
@@ -549,6 +630,88 @@ estimate_inner_buffersize(PlannerInfo *root,
 	return inner_total_sz;
 }
 
+/*
+ * estimate_intermediate_nitems
+ *
+ * It estimates number of the items written on the pseudo-stack of
+ * kern_gpujoin as intermediate results. A row at the depth-N consumes
+ * (N+1) items to track the combination of outer/inner rows, and rows
+ * of the last depth are written to the destination buffer instead.
+ */
+static double
+estimate_intermediate_nitems(GpuJoinPath *gpath)
+{
+	double		nitems = 0.0;
+	int			i;
+
+	for (i=0; i < gpath->num_rels - 1; i++)
+		nitems += gpath->inners[i].join_nrows * (double)(i + 2);
+	return nitems;
+}
+
+/*
+ * gpujoin_late_materialize_columns
+ *
+ * It picks up wide variable-length columns of the pulled-up outer relation
+ * that are referenced by the host side. Device projection does not need to
+ * write them onto the result buffer, if host fetches them later using ctid
+ * of the surviving rows only.
+ */
+#define GPUJOIN_LATE_MATERIALIZE_MIN_WIDTH		64
+
+static Bitmapset *
+gpujoin_late_materialize_columns(PlannerInfo *root,
+								 GpuJoinPath *gpath,
+								 RelOptInfo *joinrel,
+								 Path *outer_path,
+								 int *p_late_width)
+{
+	RelOptInfo	   *outer_rel = outer_path->parent;
+	RangeTblEntry  *rte;
+	Bitmapset	   *late_attrs = NULL;
+	int				late_width = 0;
+	ListCell	   *lc;
+
+	*p_late_width = 0;
+	if (!enable_gpujoin_late_materialization || gpath->outer_relid == 0)
+		return NULL;
+	/* only heap relations can fetch rows by ctid */
+	rte = planner_rt_fetch(gpath->outer_relid, root);
+	if (rte->rtekind != RTE_RELATION ||
+		(rte->relkind != RELKIND_RELATION &&
+		 rte->relkind != RELKIND_MATVIEW))
+		return NULL;
+	Assert(outer_rel->relid == gpath->outer_relid);
+	/*
+	 * GpuPreAgg may take the final join-relation as a combined GpuJoin,
+	 * then it needs all the columns on the device projection.
+	 */
+	if ((root->parse->hasAggs || root->parse->groupClause != NIL) &&
+		bms_equal(joinrel->relids, root->all_baserels))
+		return NULL;
+
+	foreach (lc, joinrel->reltarget->exprs)
+	{
+		Var	   *var = lfirst(lc);
+		int32	width;
+
+		if (!IsA(var, Var) ||
+			var->varno != gpath->outer_relid ||
+			var->varattno <= 0 ||
+			var->varlevelsup > 0 ||
+			get_typlen(var->vartype) != -1)
+			continue;
+		width = outer_rel->attr_widths[var->varattno - outer_rel->min_attr];
+		if (width < GPUJOIN_LATE_MATERIALIZE_MIN_WIDTH)
+			continue;
+		late_attrs = bms_add_member(late_attrs, var->varattno);
+		late_width += width;
+	}
+	*p_late_width = late_width;
+
+	return late_attrs;
+}
+
 /*
  * cost_gpujoin
  *
@@ -567,13 +730,19 @@ cost_gpujoin(PlannerInfo *root,
 	Cost		run_cost_per_chunk = 0.0;
 	Cost		startup_delay;
 	Size		inner_buffer_sz = 0;
-	double		gpu_ratio = pgstrom_gpu_operator_cost / cpu_operator_cost;
+	double		gpu_ratio;
 	double		parallel_divisor = 1.0;
 	double		num_chunks;
 	double		outer_ntuples;
 	Cost		inner_cost;
+	int			late_width;
 	int			i, num_rels = gpath->num_rels;
 	bool		retval = false;
+	pgstromCostFactors cf;
+
+	/* cost factors of the device / tablespace */
+	pgstrom_get_cost_factors(root, outer_path->parent, &cf);
+	gpu_ratio = cf.gpu_operator_cost / cpu_operator_cost;
 
 	/*
 	 * Cost comes from the outer-path
@@ -599,7 +768,7 @@ cost_gpujoin(PlannerInfo *root,
 	}
 	else
 	{
-		startup_cost = pgstrom_gpu_setup_cost;
+		startup_cost = cf.gpu_setup_cost;
 		if (num_partition_siblings > 0)
 			startup_cost /= (Cost)num_partition_siblings;
 		startup_cost += outer_path->startup_cost;
@@ -687,7 +856,7 @@ cost_gpujoin(PlannerInfo *root,
 			startup_cost += inner_cost;
 
 			/* cost to comput hash value by GPU */
-			run_cost += (pgstrom_gpu_operator_cost *
+			run_cost += (cf.gpu_operator_cost *
 						 num_hashkeys *
 						 outer_ntuples);
 			/* cost to evaluate join qualifiers */
@@ -718,11 +887,14 @@ cost_gpujoin(PlannerInfo *root,
 		/* number of outer items on the next depth */
 		outer_ntuples = join_nrows / parallel_divisor;
 	}
+	/* cost to write out/read back intermediate results */
+	run_cost += (cf.gpu_operator_cost *
+				 estimate_intermediate_nitems(gpath) / parallel_divisor);
 	/* outer DMA send cost */
-	run_cost += (double)num_chunks * pgstrom_gpu_dma_cost;
+	run_cost += (double)num_chunks * cf.gpu_dma_cost;
 	/* inner DMA send cost */
 	inner_cost = ((double)inner_buffer_sz /
-				  (double)pgstrom_chunk_size()) * pgstrom_gpu_dma_cost;
+				  (double)pgstrom_chunk_size()) * cf.gpu_dma_cost;
 	if (num_partition_siblings > 0)
 		inner_cost /= (Cost) num_partition_siblings;
 	run_cost += inner_cost;
@@ -731,7 +903,56 @@ cost_gpujoin(PlannerInfo *root,
 	run_cost += joinrel->reltarget->cost.per_tuple * gpath->cpath.path.rows;
 
 	/* cost for DMA receive (GPU-->host) */
-	run_cost += cost_for_dma_receive(joinrel, -1.0);
+	run_cost += cost_for_dma_receive(root, joinrel, -1.0);
+
+	/*
+	 * Late materialization of the wide outer columns; device projection
+	 * writes only ctid instead of them, then host fetches the heap tuple
+	 * for each surviving row. It is worthwhile only if the saved DMA and
+	 * device-side copy are larger than the heap fetch cost.
+	 */
+	gpath->late_attrs = gpujoin_late_materialize_columns(root, gpath,
+														 joinrel,
+														 outer_path,
+														 &late_width);
+	if (gpath->late_attrs)
+	{
+		RelOptInfo *outer_rel = outer_path->parent;
+		double		join_nrows = gpath->cpath.path.rows;
+		double		late_nattrs = bms_num_members(gpath->late_attrs);
+		double		pages_fetched;
+		double		spc_random_page_cost;
+		Cost		late_saving;
+		Cost		late_cost;
+
+		late_width -= MAXALIGN(sizeof(ItemPointerData));
+		/* DMA receive, and word-by-word copy on device projection */
+		late_saving = (cf.gpu_dma_cost *
+					   ((double)late_width * join_nrows /
+						(double)pgstrom_chunk_size()) +
+					   cf.gpu_operator_cost *
+					   ((double)late_width / sizeof(Datum)) * join_nrows);
+		/*
+		 * heap fetch by ctid, and extraction of the late columns. The heap
+		 * pages were just read by the outer scan, so we expect they are
+		 * still cached unless relation is larger than effective_cache_size.
+		 */
+		late_cost = cpu_operator_cost * (1.0 + late_nattrs) * join_nrows;
+		if ((double) outer_rel->pages > effective_cache_size)
+		{
+			get_tablespace_page_costs(outer_rel->reltablespace,
+									  &spc_random_page_cost, NULL);
+			pages_fetched = index_pages_fetched(join_nrows,
+												outer_rel->pages,
+												(double) outer_rel->pages,
+												root);
+			late_cost += pages_fetched * spc_random_page_cost;
+		}
+		if (late_cost < late_saving)
+			run_cost += (late_cost - late_saving);
+		else
+			gpath->late_attrs = NULL;
+	}
 
 	/* cost to exchange tuples */
 	run_cost += cpu_tuple_cost * gpath->cpath.path.rows;
@@ -775,7 +996,9 @@ cost_gpujoin(PlannerInfo *root,
 			appendStringInfo(&buf, " %s%s ",
 							 join_type == JOIN_FULL ? "F" :
 							 join_type == JOIN_LEFT ? "L" :
-							 join_type == JOIN_RIGHT ? "R" : "I",
+							 join_type == JOIN_RIGHT ? "R" :
+							 join_type == JOIN_SEMI ? "S" :
+							 join_type == JOIN_ANTI ? "A" : "I",
 							 is_nestloop ? "NL" : "HJ");
 
 			__dump_gpujoin_path(&buf, root, inner_path);
@@ -799,6 +1022,119 @@ typedef struct
 	double		join_nrows;
 } inner_path_item;
 
+/*
+ * gpujoin_reorder_inner_relations
+ *
+ * The order of inner relations given by the join search of PostgreSQL is
+ * not always optimal for GpuJoin, because all the depths are processed in
+ * a single kernel and the intermediate results of each depth are kept on
+ * the pseudo-stack of kern_gpujoin. So, if INNER JOIN only, we put the
+ * most selective inner relation on the earlier depth as long as all the
+ * relations referenced by its join qualifiers are already available.
+ * The selectivity (fan-out) of each depth is assumed to be independent
+ * from the order. Inner relations are permuted only if the number of
+ * intermediate results gets reduced.
+ */
+static void
+gpujoin_reorder_inner_relations(PlannerInfo *root,
+								GpuJoinPath *gjpath,
+								Path *outer_path)
+{
+	int			num_rels = gjpath->num_rels;
+	size_t		unitsz = sizeof(gjpath->inners[0]);
+	char	   *inners_saved;
+	double	   *fanout;
+	double	   *width;
+	Relids	   *depends;
+	bool	   *placed;
+	Relids		available;
+	double		nrows_in;
+	double		nitems_old;
+	double		joinrel_nrows;
+	bool		reordered = false;
+	ListCell   *lc;
+	int			i, k;
+
+	if (!enable_gpujoin_inner_reorder || num_rels < 2)
+		return;
+	for (i=0; i < num_rels; i++)
+	{
+		if (gjpath->inners[i].join_type != JOIN_INNER)
+			return;
+	}
+
+	inners_saved = palloc(unitsz * num_rels);
+	memcpy(inners_saved, gjpath->inners, unitsz * num_rels);
+	fanout = palloc(sizeof(double) * num_rels);
+	width = palloc(sizeof(double) * num_rels);
+	depends = palloc(sizeof(Relids) * num_rels);
+	placed = palloc0(sizeof(bool) * num_rels);
+
+	nrows_in = Max(outer_path->rows, 1.0);
+	for (i=0; i < num_rels; i++)
+	{
+		Path	   *scan_path = gjpath->inners[i].scan_path;
+		Relids		relids = NULL;
+
+		fanout[i] = gjpath->inners[i].join_nrows / nrows_in;
+		nrows_in = Max(gjpath->inners[i].join_nrows, 1.0);
+		width[i] = scan_path->rows * (double)scan_path->pathtarget->width;
+		/* relations to be joined prior to this depth */
+		foreach (lc, gjpath->inners[i].join_quals)
+		{
+			RestrictInfo   *rinfo = lfirst(lc);
+
+			relids = bms_add_members(relids, rinfo->clause_relids);
+		}
+		depends[i] = bms_del_members(relids, scan_path->parent->relids);
+	}
+	nitems_old = estimate_intermediate_nitems(gjpath);
+	joinrel_nrows = gjpath->inners[num_rels-1].join_nrows;
+
+	available = bms_copy(outer_path->parent->relids);
+	nrows_in = outer_path->rows;
+	for (k=0; k < num_rels; k++)
+	{
+		int		best = -1;
+
+		for (i=0; i < num_rels; i++)
+		{
+			if (placed[i] || !bms_is_subset(depends[i], available))
+				continue;
+			if (best < 0 ||
+				fanout[i] < fanout[best] ||
+				(fanout[i] == fanout[best] && width[i] < width[best]))
+				best = i;
+		}
+		if (best < 0)
+			goto out_restore;	/* should not happen */
+		memcpy(&gjpath->inners[k], inners_saved + unitsz * best, unitsz);
+		placed[best] = true;
+		available = bms_add_members(available,
+									gjpath->inners[k].scan_path->parent->relids);
+		nrows_in *= fanout[best];
+		gjpath->inners[k].join_nrows = nrows_in;
+		if (best != k)
+			reordered = true;
+	}
+	/* the last depth always produces the rows of joinrel */
+	gjpath->inners[num_rels-1].join_nrows = joinrel_nrows;
+
+	if (reordered && estimate_intermediate_nitems(gjpath) < nitems_old)
+	{
+		gjpath->inner_reordered = true;
+		goto out;
+	}
+out_restore:
+	memcpy(gjpath->inners, inners_saved, unitsz * num_rels);
+out:
+	pfree(inners_saved);
+	pfree(fanout);
+	pfree(width);
+	pfree(depends);
+	pfree(placed);
+}
+
 static GpuJoinPath *
 create_gpujoin_path(PlannerInfo *root,
 					RelOptInfo *joinrel,
@@ -854,7 +1190,9 @@ create_gpujoin_path(PlannerInfo *root,
 			hash_quals = ip_item->hash_quals;
 		else if (enable_gpunestloop &&
 				 (ip_item->join_type == JOIN_INNER ||
-				  ip_item->join_type == JOIN_LEFT))
+				  ip_item->join_type == JOIN_LEFT ||
+				  ip_item->join_type == JOIN_SEMI ||
+				  ip_item->join_type == JOIN_ANTI))
 			hash_quals = NIL;
 		else
 		{
@@ -873,6 +1211,9 @@ create_gpujoin_path(PlannerInfo *root,
 	}
 	Assert(i == num_rels);
 
+	/* Try to put the most selective inner relation first */
+	gpujoin_reorder_inner_relations(root, gjpath, outer_path);
+
 	/* Try to pull up outer scan if enough simple */
 	pgstrom_pullup_outer_scan(root, outer_path,
 							  &gjpath->outer_relid,
@@ -1629,7 +1970,9 @@ try_add_gpujoin_paths(PlannerInfo *root,
 	if (join_type != JOIN_INNER &&
 		join_type != JOIN_FULL &&
 		join_type != JOIN_RIGHT &&
-		join_type != JOIN_LEFT)
+		join_type != JOIN_LEFT &&
+		join_type != JOIN_SEMI &&
+		join_type != JOIN_ANTI)
 		return;
 
 	/*
@@ -1698,6 +2041,14 @@ try_add_gpujoin_paths(PlannerInfo *root,
 
 		if (!pgstrom_device_expression(root, rinfo->clause))
 			return;
+		/*
+		 * ANTI JOIN emits outer rows with no matched inner rows, so
+		 * the filter qualifiers pushed down to the join have to be
+		 * applied on the emitted rows, not on the join combinations.
+		 * GpuJoin does not support this right now.
+		 */
+		if (join_type == JOIN_ANTI && rinfo->is_pushed_down)
+			return;
 	}
 
 	/*
@@ -2140,6 +2491,43 @@ build_device_targetlist(PlannerInfo *root,
 			build_device_tlist_walker((Node *)lfirst(lc), &context);
 	}
 
+	/*
+	 * Late materialization of the wide outer columns, if any. Device
+	 * projection writes ctid of the outer relation, instead of these
+	 * columns, then host-side fetches them for the surviving rows.
+	 */
+	if (gpath->late_attrs != NULL)
+	{
+		ListCell   *lc1, *lc2, *lc3;
+		List	   *late_refs = NIL;
+
+		forthree (lc1, context.ps_tlist,
+				  lc2, context.ps_depth,
+				  lc3, context.ps_resno)
+		{
+			TargetEntry *tle = lfirst(lc1);
+
+			if (lfirst_int(lc2) == 0 &&
+				IsA(tle->expr, Var) &&
+				bms_is_member(lfirst_int(lc3), gpath->late_attrs))
+				late_refs = lappend_int(late_refs, tle->resno);
+		}
+
+		if (late_refs != NIL)
+		{
+			Var		   *ctid = makeVar(context.outer_scanrelid,
+									   SelfItemPointerAttributeNumber,
+									   TIDOID, -1, InvalidOid, 0);
+			TargetEntry *tle;
+
+			build_device_tlist_walker((Node *)ctid, &context);
+			tle = tlist_member((void *)ctid, context.ps_tlist);
+			Assert(tle != NULL && !tle->resjunk);
+			gj_info->late_refs = late_refs;
+			gj_info->late_ctid = tle->resno;
+		}
+	}
+
 	/*
 	 * Above are host referenced columns. On the other hands, the columns
 	 * newly added below are device-only columns, so it will never
@@ -2280,6 +2668,7 @@ PlanGpuJoinPath(PlannerInfo *root,
 	gj_info.outer_startup_cost = outer_plan->startup_cost;
 	gj_info.outer_total_cost = outer_plan->total_cost;
 	gj_info.num_rels = gjpath->num_rels;
+	gj_info.inner_reordered = gjpath->inner_reordered;
 
 	if (!gjpath->sibling_param_id)
 		gj_info.sibling_param_id = -1;
@@ -2376,6 +2765,16 @@ PlanGpuJoinPath(PlannerInfo *root,
 										  hash_outer_keys);
 		outer_nrows = gjpath->inners[i].join_nrows;
 
+		/* name of the inner relation, for EXPLAIN */
+		{
+			StringInfoData	buf;
+
+			initStringInfo(&buf);
+			__dump_gpujoin_path(&buf, root, gjpath->inners[i].scan_path);
+			gj_info.inner_order = lappend(gj_info.inner_order,
+										  makeString(buf.data));
+		}
+
 		if (outer_relid)
 		{
 			pull_varattnos((Node *)hash_outer_keys, outer_relid, &varattnos);
@@ -2593,6 +2992,9 @@ ExecInitGpuJoin(CustomScanState *node, EState *estate, int eflags)
 	gjs->gts.cb_switch_task		= gpujoin_switch_task;
 	gjs->gts.cb_process_task	= gpujoin_process_task;
 	gjs->gts.cb_release_task	= gpujoin_release_task;
+	if (pgstrom_cpu_fallback_during_build ||
+		pgstrom_debug_force_cpu_fallback)
+		gjs->gts.cb_build_fallback = gpujoin_build_fallback;
 
 	/* DSM & GPU memory of inner buffer */
 	gjs->m_kmrels = 0UL;
@@ -2650,6 +3052,12 @@ ExecInitGpuJoin(CustomScanState *node, EState *estate, int eflags)
 		pgstromExecInitBrinIndexMap(&gjs->gts,
 									gj_info->index_oid,
 									gj_info->index_conds);
+		if (RelationIsArrowFdw(gjs->gts.css.ss.ss_currentRelation))
+			gjs->gts.af_state =
+				ExecInitArrowFdw(gjs->gts.css.ss.ss_currentRelation,
+								 gjs->gts.outer_refs,
+								 gj_info->outer_quals);
+		pgstromExecInitZoneMap(&gjs->gts, gj_info->outer_quals);
 	}
 	else
 	{
@@ -2661,6 +3069,29 @@ ExecInitGpuJoin(CustomScanState *node, EState *estate, int eflags)
 		Assert(!OidIsValid(gj_info->index_oid));
 	}
 
+	/*
+	 * Init late materialization stuff
+	 */
+	if (gj_info->late_refs != NIL)
+	{
+		Assert(gjs->gts.css.ss.ss_currentRelation != NULL);
+		gjs->slot_late = MakeSingleTupleTableSlot(scan_tupdesc);
+		gjs->late_nattrs = list_length(gj_info->late_refs);
+		gjs->late_dst_resno = palloc(sizeof(AttrNumber) * gjs->late_nattrs);
+		gjs->late_src_anum = palloc(sizeof(AttrNumber) * gjs->late_nattrs);
+		i = 0;
+		foreach (lc1, gj_info->late_refs)
+		{
+			AttrNumber	resno = lfirst_int(lc1);
+
+			gjs->late_dst_resno[i] = resno;
+			gjs->late_src_anum[i] = list_nth_int(gj_info->ps_src_resno,
+												 resno - 1);
+			i++;
+		}
+		gjs->late_ctid_resno = gj_info->late_ctid;
+	}
+
 	/*
 	 * Init CPU fallback stuff
 	 */
@@ -2958,6 +3389,10 @@ ExecEndGpuJoin(CustomScanState *node)
 		ExecEndNode(gjs->inners[i].state);
 	/* then other private resources */
 	GpuJoinInnerUnload(&gjs->gts, false);
+	if (gjs->slot_bloom)
+		ExecDropSingleTupleTableSlot(gjs->slot_bloom);
+	if (gjs->slot_late)
+		ExecDropSingleTupleTableSlot(gjs->slot_late);
 	pgstromReleaseGpuTaskState(&gjs->gts, gt_rtstat);
 }
 
@@ -3056,6 +3491,24 @@ ExplainGpuJoin(CustomScanState *node, List *ancestors, ExplainState *es)
 		ExplainPropertyText("GPU Projection", str.data, es);
 	}
 
+	/* outer columns to be fetched by late materialization, if any */
+	if (gj_info->late_refs != NIL)
+	{
+		resetStringInfo(&str);
+		foreach (lc1, gj_info->late_refs)
+		{
+			TargetEntry	   *tle = list_nth(cscan->custom_scan_tlist,
+										   lfirst_int(lc1) - 1);
+
+			if (lc1 != list_head(gj_info->late_refs))
+				appendStringInfo(&str, ", ");
+			temp = deparse_expression((Node *)tle->expr,
+									  dcontext, es->verbose, false);
+			appendStringInfo(&str, "%s", temp);
+		}
+		ExplainPropertyText("Late Materialization", str.data, es);
+	}
+
 	/* statistics for outer scan, if any */
 	pgstromExplainOuterScan(&gjs->gts, dcontext, ancestors, es,
 							gj_info->outer_quals,
@@ -3063,6 +3516,18 @@ ExplainGpuJoin(CustomScanState *node, List *ancestors, ExplainState *es)
                             gj_info->outer_total_cost,
                             gj_info->outer_nrows,
                             gj_info->outer_width);
+	/* order of inner relations, if reordered */
+	if (gj_info->inner_reordered)
+	{
+		resetStringInfo(&str);
+		foreach (lc1, gj_info->inner_order)
+		{
+			if (lc1 != list_head(gj_info->inner_order))
+				appendStringInfo(&str, ", ");
+			appendStringInfo(&str, "%s", strVal(lfirst(lc1)));
+		}
+		ExplainPropertyText("Inner Order", str.data, es);
+	}
 	/* join-qualifiers */
 	depth = 1;
 	forfour (lc1, gj_info->join_types,
@@ -3109,14 +3574,18 @@ ExplainGpuJoin(CustomScanState *node, List *ancestors, ExplainState *es)
 			appendStringInfo(&str, "GpuHash%sJoin",
 							 join_type == JOIN_FULL ? "Full" :
 							 join_type == JOIN_LEFT ? "Left" :
-							 join_type == JOIN_RIGHT ? "Right" : "");
+							 join_type == JOIN_RIGHT ? "Right" :
+							 join_type == JOIN_SEMI ? "Semi" :
+							 join_type == JOIN_ANTI ? "Anti" : "");
 		}
 		else
 		{
 			appendStringInfo(&str, "GpuNestLoop%s",
 							 join_type == JOIN_FULL ? "Full" :
 							 join_type == JOIN_LEFT ? "Left" :
-							 join_type == JOIN_RIGHT ? "Right" : "");
+							 join_type == JOIN_RIGHT ? "Right" :
+							 join_type == JOIN_SEMI ? "Semi" :
+							 join_type == JOIN_ANTI ? "Anti" : "");
 		}
 		snprintf(qlabel, sizeof(qlabel), "Depth% 2d", depth);
 		indent_width = es->indent * 2 + strlen(qlabel) + 2;
@@ -3271,6 +3740,40 @@ ExplainGpuJoin(CustomScanState *node, List *ancestors, ExplainState *es)
 				ExplainPropertyText(qlabel, format_bytesz(len), es);
 			}
 		}
+
+		/*
+		 * Bloom filter on the depth-1 inner relation, if any
+		 */
+		if (depth == 1 && es->analyze && gj_rtstat && kds_in &&
+			!gjs->gts.css.ss.ss_currentRelation)
+		{
+			kern_multirels *kmrels = dsm_segment_address(gjs->seg_kmrels);
+			GpuJoinBloomFilter *bloom = GPUJOIN_BLOOM_FILTER(kmrels);
+			cl_ulong	nremoved
+				= pg_atomic_read_u64(&gj_rtstat->bloom_nremoved);
+
+			if (bloom->nbits > 0)
+			{
+				if (es->format == EXPLAIN_FORMAT_TEXT)
+				{
+					appendStringInfoSpaces(es->str, indent_width);
+					appendStringInfo(es->str,
+									 "Bloom Filter (size: %s, removed: %lu)\n",
+									 format_bytesz(bloom->nbits / BITS_PER_BYTE),
+									 nremoved);
+				}
+				else
+				{
+					snprintf(qlabel, sizeof(qlabel),
+							 "Depth% 2d Bloom Filter Size", depth);
+					ExplainPropertyText(qlabel,
+								format_bytesz(bloom->nbits / BITS_PER_BYTE),
+										es);
+					ExplainPropertyInteger("Rows Removed by Bloom Filter",
+										   NULL, nremoved, es);
+				}
+			}
+		}
 		depth++;
 	}
 	/* other common field */
@@ -3507,6 +4010,7 @@ gpujoin_codegen_var_param_decl(StringInfo source,
 	 * parameter declaration
 	 */
 	pgstrom_codegen_param_declarations(source, context);
+	pgstrom_codegen_cse_declarations(source, context);
 
 	/*
 	 * variable declarations
@@ -3688,20 +4192,31 @@ gpujoin_codegen_join_quals(StringInfo source,
 						   int cur_depth,
 						   codegen_context *context)
 {
+	JoinType	join_type;
 	List	   *join_quals;
 	List	   *other_quals;
 	char	   *join_quals_code = NULL;
 	char	   *other_quals_code = NULL;
 
 	Assert(cur_depth > 0 && cur_depth <= gj_info->num_rels);
+	join_type = (JoinType) list_nth_int(gj_info->join_types, cur_depth - 1);
 	join_quals = list_nth(gj_info->join_quals, cur_depth - 1);
 	other_quals = list_nth(gj_info->other_quals, cur_depth - 1);
+	/*
+	 * SEMI/ANTI JOIN uses the result of join_quals only to check whether
+	 * the outer row has any matched inner rows, so other_quals (which
+	 * shall be applied on the emitted rows) must not be mixed.
+	 */
+	if ((join_type == JOIN_SEMI || join_type == JOIN_ANTI) &&
+		other_quals != NIL)
+		elog(ERROR, "Bug? GpuJoin has filter quals on SEMI/ANTI JOIN");
 
 	/*
 	 * make a text representation of join_qual
 	 */
 	context->used_vars = NIL;
 	context->param_refs = NULL;
+	pgstrom_codegen_cse_setup(context, list_make2(join_quals, other_quals));
 	if (join_quals != NIL)
 		join_quals_code = pgstrom_codegen_expression((Node *)join_quals,
 													 context);
@@ -3728,6 +4243,7 @@ gpujoin_codegen_join_quals(StringInfo source,
 	 */
 	gpujoin_codegen_var_param_decl(source, gj_info,
 								   cur_depth, context);
+	pgstrom_codegen_cse_setup(context, NIL);
 
 	/*
 	 * evaluation of other-quals and join-quals
@@ -3804,6 +4320,7 @@ gpujoin_codegen_hash_value(StringInfo source,
 
 	context->used_vars = NIL;
 	context->param_refs = NULL;
+	pgstrom_codegen_cse_setup(context, hash_outer_keys);
 
 	initStringInfo(&body);
 	appendStringInfo(
@@ -3839,6 +4356,7 @@ gpujoin_codegen_hash_value(StringInfo source,
 	 */
 	gpujoin_codegen_var_param_decl(source, gj_info,
 								   cur_depth, context);
+	pgstrom_codegen_cse_setup(context, NIL);
 	appendStringInfo(
 		source,
 		"%s"
@@ -3865,6 +4383,7 @@ gpujoin_codegen_projection(StringInfo source,
 	List		   *tlist_dev = cscan->custom_scan_tlist;
 	List		   *ps_src_depth = gj_info->ps_src_depth;
 	List		   *ps_src_resno = gj_info->ps_src_resno;
+	List		   *proj_exprs = NIL;
 	ListCell	   *lc1;
 	ListCell	   *lc2;
 	ListCell	   *lc3;
@@ -4149,6 +4668,7 @@ gpujoin_codegen_projection(StringInfo source,
 			int16			typelen;
 			bool			typebyval;
 			cl_bool			referenced = false;
+			cl_bool			late_materialized;
 
 			foreach (lc1, tlist_dev)
 			{
@@ -4166,6 +4686,23 @@ gpujoin_codegen_projection(StringInfo source,
 						" : kern_get_datum_column(%s,%d,offset-1));\n",
 						kds_label, i-1);
 
+				/*
+				 * Late materialized column is fetched by host-side later,
+				 * unless GpuPreAgg consumes the projection on the device.
+				 */
+				late_materialized = (depth == 0 &&
+									 list_member_int(gj_info->late_refs,
+													 tle->resno));
+				if (late_materialized)
+				{
+					appendStringInfoString(
+						&temp,
+						"#ifdef GPUPREAGG_COMBINED_JOIN\n");
+					appendStringInfoString(
+						&column,
+						"#ifdef GPUPREAGG_COMBINED_JOIN\n");
+				}
+
 				if (!typebyval)
 				{
 					appendStringInfo(
@@ -4200,6 +4737,26 @@ gpujoin_codegen_projection(StringInfo source,
 						tle->resno - 1,
 						8 * typelen);
 				}
+
+				if (late_materialized)
+				{
+					appendStringInfo(
+						&temp,
+						"#else\n"
+						"    tup_isnull[%d] = true;   /* late materialization */\n"
+						"    tup_values[%d] = 0;\n"
+						"#endif\n",
+						tle->resno - 1,
+						tle->resno - 1);
+					appendStringInfo(
+						&column,
+						"#else\n"
+						"    tup_isnull[%d] = true;   /* late materialization */\n"
+						"    tup_values[%d] = 0;\n"
+						"#endif\n",
+						tle->resno - 1,
+						tle->resno - 1);
+				}
 				/* NULL-initialization for LEFT OUTER JOIN */
 				if (depth == 0)
 				{
@@ -4300,6 +4857,17 @@ gpujoin_codegen_projection(StringInfo source,
 	/*
 	 * Execution of the expression
 	 */
+	forboth (lc1, tlist_dev,
+			 lc2, ps_src_depth)
+	{
+		TargetEntry	   *tle = lfirst(lc1);
+		cl_int			src_depth = lfirst_int(lc2);
+
+		if (!tle->resjunk && src_depth < 0)
+			proj_exprs = lappend(proj_exprs, tle->expr);
+	}
+	pgstrom_codegen_cse_setup(context, proj_exprs);
+
 	is_first = true;
 	forboth (lc1, tlist_dev,
 			 lc2, ps_src_depth)
@@ -4371,11 +4939,14 @@ gpujoin_codegen_projection(StringInfo source,
 				context->varlena_bufsz += MAXALIGN(dtype->extra_sz);
 		}
 	}
-	/* add parameter declarations */
+	/* add parameter and common sub-expression declarations */
 	pgstrom_codegen_param_declarations(source, context);
+	pgstrom_codegen_cse_declarations(source, context);
+	pgstrom_codegen_cse_setup(context, NIL);
 	/* merge with declaration part */
 	appendStringInfo(source, "\n%s}\n", body.data);
 
+	list_free(proj_exprs);
 	pfree(body.data);
 	pfree(temp.data);
 }
@@ -4609,6 +5180,232 @@ gpujoin_create_task(GpuJoinState *gjs,
 	return &pgjoin->task;
 }
 
+/*
+ * gpujoin_bloom_filter_insert / gpujoin_bloom_filter_lookup
+ *
+ * Bit positions are derived from the hash-value by double hashing.
+ */
+static void
+gpujoin_bloom_filter_insert(GpuJoinBloomFilter *bloom, pg_crc32 hash)
+{
+	cl_uint		h2 = DatumGetUInt32(hash_uint32(hash)) | 1;
+	cl_ulong	mask = bloom->nbits - 1;
+	cl_ulong	pos;
+	int			k;
+
+	for (k=0; k < GPUJOIN_BLOOM_NHASHES; k++)
+	{
+		pos = (cl_uint)(hash + k * h2) & mask;
+		bloom->bitmap[pos / 64] |= (1UL << (pos % 64));
+	}
+}
+
+static bool
+gpujoin_bloom_filter_lookup(GpuJoinBloomFilter *bloom, pg_crc32 hash)
+{
+	cl_uint		h2 = DatumGetUInt32(hash_uint32(hash)) | 1;
+	cl_ulong	mask = bloom->nbits - 1;
+	cl_ulong	pos;
+	int			k;
+
+	for (k=0; k < GPUJOIN_BLOOM_NHASHES; k++)
+	{
+		pos = (cl_uint)(hash + k * h2) & mask;
+		if ((bloom->bitmap[pos / 64] & (1UL << (pos % 64))) == 0)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * gpujoin_bloom_filter_check - false, if the outer row obviously never
+ * match with the depth-1 inner relation
+ */
+static bool
+gpujoin_bloom_filter_check(GpuJoinState *gjs, TupleTableSlot *slot)
+{
+	innerState	   *istate = &gjs->inners[0];
+	TupleTableSlot *slot_bloom = gjs->slot_bloom;
+	AttrNumber	   *outer_dst_resno = gjs->outer_dst_resno;
+	AttrNumber		anum;
+	AttrNumber		dst;
+	pg_crc32		hash;
+	bool			is_null_keys;
+	bool			retval;
+
+	/* deploy the outer row on the slot, as CPU fallback doing */
+	slot_getallattrs(slot);
+	ExecClearTuple(slot_bloom);
+	memset(slot_bloom->tts_isnull, true,
+		   sizeof(bool) * slot_bloom->tts_tupleDescriptor->natts);
+	for (anum = Max(gjs->outer_src_anum_min, 1);
+		 anum <= gjs->outer_src_anum_max;
+		 anum++)
+	{
+		dst = outer_dst_resno[anum - FirstLowInvalidHeapAttributeNumber - 1];
+		if (dst <= 0)
+			continue;
+		slot_bloom->tts_values[dst - 1] = slot->tts_values[anum - 1];
+		slot_bloom->tts_isnull[dst - 1] = slot->tts_isnull[anum - 1];
+	}
+	ExecStoreVirtualTuple(slot_bloom);
+
+	ResetExprContext(istate->econtext);
+	hash = get_tuple_hashvalue(istate, false, slot_bloom, &is_null_keys);
+	/* all-null keys never match to inner rows */
+	retval = (!is_null_keys && gpujoin_bloom_filter_lookup(gjs->bloom, hash));
+
+	/*
+	 * Bloom filter is not worth to evaluate if it removes only a little
+	 * portion of the outer rows.
+	 */
+	gjs->bloom_nprobed++;
+	if (!retval)
+		gjs->bloom_nremoved++;
+	if (gjs->bloom_nprobed == GPUJOIN_BLOOM_PROBE_NROWS &&
+		gjs->bloom_nremoved < (cl_ulong)(GPUJOIN_BLOOM_MIN_RATIO *
+										 (double)GPUJOIN_BLOOM_PROBE_NROWS))
+		gjs->bloom = NULL;
+
+	return retval;
+}
+
+/*
+ * gpujoin_outer_key_attnum - returns attribute number of the outer relation
+ * if the supplied hash-key is a simple reference to the outer column.
+ */
+static AttrNumber
+gpujoin_outer_key_attnum(GpuJoinState *gjs, Expr *expr)
+{
+	Var		   *var = (Var *) expr;
+	AttrNumber	anum;
+
+	if (!IsA(var, Var) || var->varno != INDEX_VAR)
+		return InvalidAttrNumber;
+	for (anum = Max(gjs->outer_src_anum_min, 1);
+		 anum <= gjs->outer_src_anum_max;
+		 anum++)
+	{
+		if (gjs->outer_dst_resno[anum -
+								 FirstLowInvalidHeapAttributeNumber - 1]
+			== var->varattno)
+			return anum;
+	}
+	return InvalidAttrNumber;
+}
+
+/*
+ * gpujoin_make_key_range_quals - makes (key >= min AND key <= max) on the
+ * outer relation, according to the range of the inner join-keys.
+ *
+ * NOTE: type of the outer key may be different from the inner key on
+ * cross-type hash-join (like float4 = float8). Zone map evaluates the
+ * operators on its min/max values of the outer column, so we have to
+ * choose the cross-type operators (outer_type, inner_type) here.
+ */
+static List *
+gpujoin_make_key_range_quals(GpuJoinState *gjs,
+							 GpuJoinBloomKey *bkey,
+							 Oid outer_type,
+							 AttrNumber anum)
+{
+	Index		scanrelid = ((Scan *)gjs->gts.css.ss.ps.plan)->scanrelid;
+	Oid			inner_type = bkey->type_oid;
+	Oid			collid = bkey->collid;
+	TypeCacheEntry *tcache;
+	Oid			ge_opno;
+	Oid			le_opno;
+	int16		typlen;
+	bool		typbyval;
+	Var		   *var;
+	Expr	   *ge_expr;
+	Expr	   *le_expr;
+
+	tcache = lookup_type_cache(outer_type, TYPECACHE_BTREE_OPFAMILY);
+	if (!OidIsValid(tcache->btree_opf))
+		return NIL;
+	ge_opno = get_opfamily_member(tcache->btree_opf, outer_type, inner_type,
+								  BTGreaterEqualStrategyNumber);
+	le_opno = get_opfamily_member(tcache->btree_opf, outer_type, inner_type,
+								  BTLessEqualStrategyNumber);
+	if (!OidIsValid(ge_opno) || !OidIsValid(le_opno))
+		return NIL;
+	get_typlenbyval(inner_type, &typlen, &typbyval);
+	Assert(typbyval);
+
+	var = makeVar(scanrelid, anum, outer_type, -1, collid, 0);
+	ge_expr = make_opclause(ge_opno, BOOLOID, false,
+							(Expr *) var,
+							(Expr *) makeConst(inner_type, -1, collid, typlen,
+											   bkey->min_value,
+											   false, typbyval),
+							InvalidOid, collid);
+	le_expr = make_opclause(le_opno, BOOLOID, false,
+							(Expr *) copyObject(var),
+							(Expr *) makeConst(inner_type, -1, collid, typlen,
+											   bkey->max_value,
+											   false, typbyval),
+							InvalidOid, collid);
+	return list_make2(ge_expr, le_expr);
+}
+
+/*
+ * gpujoin_setup_bloom_filter
+ *
+ * It attaches the bloom filter built on the inner preload, if outer rows
+ * are fetched from the child plan. Elsewhere, range of the join-keys is
+ * given to the zone map of the outer relation scan.
+ */
+static void
+gpujoin_setup_bloom_filter(GpuJoinState *gjs)
+{
+	innerState	   *istate = &gjs->inners[0];
+	kern_multirels *h_kmrels;
+	GpuJoinBloomFilter *bloom;
+	List		   *quals = NIL;
+	ListCell	   *lc;
+	int				index = 0;
+
+	gjs->bloom_ready = true;
+	gjs->bloom = NULL;
+	if (!gjs->seg_kmrels)
+		return;
+	h_kmrels = dsm_segment_address(gjs->seg_kmrels);
+	bloom = GPUJOIN_BLOOM_FILTER(h_kmrels);
+
+	if (!gjs->gts.css.ss.ss_currentRelation)
+	{
+		if (bloom->nbits == 0)
+			return;
+		if (!gjs->slot_bloom)
+			gjs->slot_bloom = MakeSingleTupleTableSlot(
+				gjs->slot_fallback->tts_tupleDescriptor);
+		gjs->bloom = bloom;
+		return;
+	}
+
+	foreach (lc, istate->hash_outer_keys)
+	{
+		ExprState	   *clause = lfirst(lc);
+		GpuJoinBloomKey *bkey;
+		AttrNumber		anum;
+
+		if (index >= bloom->nkeys)
+			break;
+		bkey = &bloom->keys[index++];
+		if (!OidIsValid(bkey->type_oid) || !bkey->has_value)
+			continue;
+		anum = gpujoin_outer_key_attnum(gjs, clause->expr);
+		if (anum > 0)
+			quals = list_concat(quals,
+								gpujoin_make_key_range_quals(gjs, bkey,
+									exprType((Node *) clause->expr),
+									anum));
+	}
+	/* also clears the range of the previous scan, if rescan */
+	pgstromExecSetZoneMapRuntimeQuals(&gjs->gts, quals);
+}
+
 /*
  * gpujoinExecOuterScanChunk
  */
@@ -4618,6 +5415,9 @@ GpuJoinExecOuterScanChunk(GpuTaskState *gts)
 	GpuJoinState   *gjs = (GpuJoinState *) gts;
 	pgstrom_data_store *pds = NULL;
 
+	if (!gjs->bloom_ready)
+		gpujoin_setup_bloom_filter(gjs);
+
 	if (gjs->gts.css.ss.ss_currentRelation)
 	{
 		pds = pgstromExecScanChunk(gts);
@@ -4626,6 +5426,7 @@ GpuJoinExecOuterScanChunk(GpuTaskState *gts)
 	{
 		PlanState	   *outer_node = outerPlanState(gjs);
 		TupleTableSlot *slot;
+		cl_ulong		nremoved = 0;
 
 		for (;;)
 		{
@@ -4647,6 +5448,12 @@ GpuJoinExecOuterScanChunk(GpuTaskState *gts)
 					gjs->gts.scan_overflow = (void *)(~0UL);
 					break;
 				}
+				/* remove rows which never match the depth-1 inner */
+				if (gjs->bloom && !gpujoin_bloom_filter_check(gjs, slot))
+				{
+					nremoved++;
+					continue;
+				}
 			}
 
 			/* creation of a new data-store on demand */
@@ -4663,6 +5470,9 @@ GpuJoinExecOuterScanChunk(GpuTaskState *gts)
 				break;
 			}
 		}
+		if (nremoved > 0)
+			pg_atomic_fetch_add_u64(&gjs->gj_rtstat->bloom_nremoved,
+									nremoved);
 	}
 	return pds;
 }
@@ -4805,6 +5615,69 @@ gpujoin_terminator_task(GpuTaskState *gts, cl_bool *task_is_ready)
 	return gtask;
 }
 
+/*
+ * gpujoin_late_materialization
+ *
+ * It fetches the outer heap tuple by ctid of the result row, then fills up
+ * the columns that were not written by the device projection.
+ */
+static TupleTableSlot *
+gpujoin_late_materialization(GpuJoinState *gjs, TupleTableSlot *slot)
+{
+	Relation		relation = gjs->gts.css.ss.ss_currentRelation;
+	TupleDesc		tupdesc = RelationGetDescr(relation);
+	EState		   *estate = gjs->gts.css.ss.ps.state;
+	ExprContext	   *econtext = gjs->gts.css.ss.ps.ps_ExprContext;
+	TupleTableSlot *late_slot = gjs->slot_late;
+	cl_int			ctid_index = gjs->late_ctid_resno - 1;
+	cl_int			i, natts = late_slot->tts_tupleDescriptor->natts;
+
+	slot_getallattrs(slot);
+	ExecClearTuple(late_slot);
+	memcpy(late_slot->tts_values, slot->tts_values, sizeof(Datum) * natts);
+	memcpy(late_slot->tts_isnull, slot->tts_isnull, sizeof(bool) * natts);
+
+	/* ctid is NULL, if outer side is empty by RIGHT/FULL OUTER JOIN */
+	if (!slot->tts_isnull[ctid_index])
+	{
+		HeapTupleData	tuple;
+		Buffer			buffer;
+		MemoryContext	oldcxt;
+
+		ItemPointerCopy((ItemPointer)
+						DatumGetPointer(slot->tts_values[ctid_index]),
+						&tuple.t_self);
+		if (!heap_fetch(relation, estate->es_snapshot,
+						&tuple, &buffer, false, NULL))
+			elog(ERROR, "failed to fetch tuple (%u,%u) of \"%s\" for late materialization",
+				 ItemPointerGetBlockNumber(&tuple.t_self),
+				 ItemPointerGetOffsetNumber(&tuple.t_self),
+				 RelationGetRelationName(relation));
+
+		oldcxt = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+		for (i=0; i < gjs->late_nattrs; i++)
+		{
+			AttrNumber	dst = gjs->late_dst_resno[i] - 1;
+			AttrNumber	anum = gjs->late_src_anum[i];
+			Form_pg_attribute attr = tupleDescAttr(tupdesc, anum - 1);
+			Datum		datum;
+			bool		isnull;
+
+			datum = heap_getattr(&tuple, anum, tupdesc, &isnull);
+			late_slot->tts_isnull[dst] = isnull;
+			if (isnull)
+				late_slot->tts_values[dst] = 0;
+			else
+				late_slot->tts_values[dst] = datumCopy(datum,
+													   attr->attbyval,
+													   attr->attlen);
+		}
+		MemoryContextSwitchTo(oldcxt);
+		ReleaseBuffer(buffer);
+	}
+	return ExecStoreVirtualTuple(late_slot);
+}
+
 static TupleTableSlot *
 gpujoin_next_tuple(GpuTaskState *gts)
 {
@@ -4832,6 +5705,8 @@ gpujoin_next_tuple(GpuTaskState *gts)
 		ExecClearTuple(slot);
 		if (!PDS_fetch_tuple(slot, pgjoin->pds_dst, &gjs->gts))
 			slot = NULL;
+		else if (gjs->slot_late)
+			slot = gpujoin_late_materialization(gjs, slot);
 	}
 	return slot;
 }
@@ -5106,6 +5981,12 @@ gpujoinFallbackHashJoin(int depth, GpuJoinState *gjs)
 	cl_uint			hash;
 	bool			retval;
 
+	/* SEMI/ANTI JOIN already made a decision on the current outer row */
+	if (istate->fallback_inner_matched &&
+		(istate->join_type == JOIN_SEMI ||
+		 istate->join_type == JOIN_ANTI))
+		return depth-1;
+
 	do {
 		if (istate->fallback_inner_index == 0)
 		{
@@ -5147,15 +6028,27 @@ gpujoinFallbackHashJoin(int depth, GpuJoinState *gjs)
 									   istate->inner_src_anum_min,
 									   istate->inner_src_anum_max);
 #if PG_VERSION_NUM < 100000
-		retval = ExecQual(istate->other_quals, econtext, false);
+		retval = ExecQual(istate->join_quals, econtext, false);
+#else
+		retval = ExecQual(istate->join_quals, econtext);
+#endif
+		if (retval)
+		{
+			istate->fallback_inner_matched = true;
+			/* update outer join map */
+			if (ojmaps)
+				ojmaps[khitem->rowid] = 1;
+			/* ANTI JOIN never emits the matched outer row */
+			if (istate->join_type == JOIN_ANTI)
+				return depth-1;
+#if PG_VERSION_NUM < 100000
+			retval = ExecQual(istate->other_quals, econtext, false);
 #else
-		retval = ExecQual(istate->other_quals, econtext);
+			retval = ExecQual(istate->other_quals, econtext);
 #endif
+		}
 	} while (!retval);
 
-	/* update outer join map */
-	if (ojmaps)
-		ojmaps[khitem->rowid] = 1;
 	/* rewind the next depth */
 	if (depth < gjs->num_rels)
 	{
@@ -5168,16 +6061,19 @@ gpujoinFallbackHashJoin(int depth, GpuJoinState *gjs)
 end:
 	if (!istate->fallback_inner_matched &&
 		(istate->join_type == JOIN_LEFT ||
-		 istate->join_type == JOIN_FULL))
+		 istate->join_type == JOIN_FULL ||
+		 istate->join_type == JOIN_ANTI))
 	{
 		istate->fallback_inner_matched = true;
-		gpujoin_fallback_tuple_extract(gjs->slot_fallback,
-									   kds_in,
-                                       NULL,
-                                       NULL,
-									   istate->inner_dst_resno,
-									   istate->inner_src_anum_min,
-									   istate->inner_src_anum_max);
+		/* ANTI JOIN never references the inner columns */
+		if (istate->join_type != JOIN_ANTI)
+			gpujoin_fallback_tuple_extract(gjs->slot_fallback,
+										   kds_in,
+										   NULL,
+										   NULL,
+										   istate->inner_dst_resno,
+										   istate->inner_src_anum_min,
+										   istate->inner_src_anum_max);
 		if (depth < gjs->num_rels)
 		{
 			istate++;
@@ -5203,6 +6099,12 @@ gpujoinFallbackNestLoop(int depth, GpuJoinState *gjs)
 	cl_bool		   *ojmaps = KERN_MULTIRELS_OUTER_JOIN_MAP(h_kmrels, depth);
 	cl_uint			index;
 
+	/* SEMI/ANTI JOIN already made a decision on the current outer row */
+	if (istate->fallback_inner_matched &&
+		(istate->join_type == JOIN_SEMI ||
+		 istate->join_type == JOIN_ANTI))
+		return depth-1;
+
 	for (index = istate->fallback_inner_index;
 		 index < kds_in->nitems;
 		 index++)
@@ -5225,9 +6127,13 @@ gpujoinFallbackNestLoop(int depth, GpuJoinState *gjs)
 		if (retval)
 		{
 			istate->fallback_inner_index = index + 1;
+			istate->fallback_inner_matched = true;
 			/* update outer join map */
 			if (ojmaps)
 				ojmaps[index] = 1;
+			/* ANTI JOIN never emits the matched outer row */
+			if (istate->join_type == JOIN_ANTI)
+				return depth-1;
 			/* rewind the next depth */
 			if (depth < gjs->num_rels)
 			{
@@ -5241,18 +6147,21 @@ gpujoinFallbackNestLoop(int depth, GpuJoinState *gjs)
 
 	if (!istate->fallback_inner_matched &&
 		(istate->join_type == JOIN_LEFT ||
-		 istate->join_type == JOIN_FULL))
+		 istate->join_type == JOIN_FULL ||
+		 istate->join_type == JOIN_ANTI))
 	{
 		istate->fallback_inner_index = kds_in->nitems;
 		istate->fallback_inner_matched = true;
 
-		gpujoin_fallback_tuple_extract(gjs->slot_fallback,
-									   kds_in,
-									   NULL,
-									   NULL,
-									   istate->inner_dst_resno,
-									   istate->inner_src_anum_min,
-									   istate->inner_src_anum_max);
+		/* ANTI JOIN never references the inner columns */
+		if (istate->join_type != JOIN_ANTI)
+			gpujoin_fallback_tuple_extract(gjs->slot_fallback,
+										   kds_in,
+										   NULL,
+										   NULL,
+										   istate->inner_dst_resno,
+										   istate->inner_src_anum_min,
+										   istate->inner_src_anum_max);
 		/* rewind the next depth */
 		if (depth < gjs->num_rels)
 		{
@@ -5392,6 +6301,7 @@ gpujoinFallbackLoadSource(int depth, GpuJoinState *gjs,
 
 	/* rewind the next depth */
 	gjs->inners[0].fallback_inner_index = 0;
+	gjs->inners[0].fallback_inner_matched = false;
 	return 1;
 }
 
@@ -5604,7 +6514,25 @@ lnext:
 										   kgjoin->grid_sz);
 				cl_uint		y_unitsz = kgjoin->grid_sz / x_unitsz;
 
-				istate->fallback_inner_index = l_state + y_unitsz;
+				if (istate->join_type == JOIN_SEMI ||
+					istate->join_type == JOIN_ANTI)
+				{
+					/*
+					 * SEMI/ANTI JOIN makes a decision after the scan on
+					 * all the inner rows, but the suspend context does not
+					 * keep the matched state of the sibling threads. So, we
+					 * restart from the head unless already decided.
+					 */
+					if ((cl_ulong)l_state * y_unitsz >= kds_in->nitems)
+					{
+						gjs->fallback_thread_count = (thread_index + 1) << 10;
+						goto lnext;
+					}
+					istate->fallback_inner_index = 0;
+					istate->fallback_inner_matched = false;
+				}
+				else
+					istate->fallback_inner_index = l_state + y_unitsz;
 			}
 			else
 				elog(ERROR, "Bug? unexpected inner buffer format: %d",
@@ -6325,6 +7253,29 @@ resume_kernel:
 	return retval;
 }
 
+/*
+ * gpujoin_build_fallback
+ *
+ * It makes the GpuJoinTask processed by the CPU fallback code, because
+ * GPU program is not built yet. RIGHT OUTER JOIN task has no outer chunk,
+ * so it waits for the program build.
+ */
+static bool
+gpujoin_build_fallback(GpuTask *gtask)
+{
+	GpuJoinTask	   *pgjoin = (GpuJoinTask *) gtask;
+	pgstrom_data_store *pds_src = pgjoin->pds_src;
+
+	if (!pds_src)
+		return false;
+	/* NVMe-Strom mode may not load the blocks onto the host memory yet */
+	if (pds_src->kds.format == KDS_FORMAT_BLOCK)
+		PDS_fillup_blocks(pds_src);
+	pgjoin->task.cpu_fallback = true;
+
+	return true;
+}
+
 int
 gpujoin_process_task(GpuTask *gtask, CUmodule cuda_module)
 {
@@ -6479,6 +7430,169 @@ gpujoin_compaction_inner_kds(kern_data_store *kds_in)
 	}
 }
 
+/*
+ * gpujoin_bloom_filter_available - true, if bloom filter can be built on
+ * the depth-1 inner relation; only INNER/SEMI hash-join can remove outer
+ * rows which have no matched inner rows.
+ */
+static bool
+gpujoin_bloom_filter_available(GpuJoinState *gjs)
+{
+	innerState *istate = &gjs->inners[0];
+
+	if (!enable_gpujoin_bloom_filter || gjs->num_rels < 1)
+		return false;
+	if (istate->hash_inner_keys == NIL)
+		return false;
+	return (istate->join_type == JOIN_INNER ||
+			istate->join_type == JOIN_SEMI);
+}
+
+/*
+ * gpujoin_bloom_filter_init_keys - setup join-keys whose range shall be
+ * tracked. Only fixed-length inline types with btree comparison function
+ * are tracked, as zone map doing.
+ */
+static void
+gpujoin_bloom_filter_init_keys(innerState *istate,
+							   GpuJoinBloomFilter *bf_head)
+{
+	ListCell   *lc;
+
+	memset(bf_head, 0, offsetof(GpuJoinBloomFilter, bitmap));
+	foreach (lc, istate->hash_inner_keys)
+	{
+		ExprState	   *clause = lfirst(lc);
+		GpuJoinBloomKey *bkey = &bf_head->keys[bf_head->nkeys++];
+		Oid				type_oid = exprType((Node *)clause->expr);
+		TypeCacheEntry *tcache;
+
+		if (get_typbyval(type_oid))
+		{
+			tcache = lookup_type_cache(type_oid, TYPECACHE_CMP_PROC_FINFO);
+			if (OidIsValid(tcache->cmp_proc_finfo.fn_oid))
+			{
+				bkey->type_oid = type_oid;
+				bkey->collid = exprCollation((Node *)clause->expr);
+			}
+		}
+		if (bf_head->nkeys >= GPUJOIN_BLOOM_NKEYS_MAX)
+			break;
+	}
+}
+
+/*
+ * gpujoin_bloom_filter_track_keys - update the range of join-keys by the
+ * current inner row; ecxt_innertuple is already set by get_tuple_hashvalue
+ */
+static void
+gpujoin_bloom_filter_track_keys(innerState *istate,
+								GpuJoinBloomFilter *bf_head)
+{
+	ListCell   *lc;
+	int			index = 0;
+
+	foreach (lc, istate->hash_inner_keys)
+	{
+		ExprState	   *clause = lfirst(lc);
+		GpuJoinBloomKey *bkey;
+		TypeCacheEntry *tcache;
+		Datum			datum;
+		bool			isnull;
+
+		if (index >= bf_head->nkeys)
+			break;
+		bkey = &bf_head->keys[index++];
+		if (!OidIsValid(bkey->type_oid))
+			continue;
+#if PG_VERSION_NUM < 100000
+		datum = ExecEvalExpr(clause, istate->econtext, &isnull, NULL);
+#else
+		datum = ExecEvalExpr(clause, istate->econtext, &isnull);
+#endif
+		if (isnull)
+			continue;
+		tcache = lookup_type_cache(bkey->type_oid, TYPECACHE_CMP_PROC_FINFO);
+		if (!bkey->has_value)
+		{
+			bkey->has_value = true;
+			bkey->min_value = datum;
+			bkey->max_value = datum;
+		}
+		else if (DatumGetInt32(FunctionCall2Coll(&tcache->cmp_proc_finfo,
+												 bkey->collid,
+												 datum,
+												 bkey->min_value)) < 0)
+			bkey->min_value = datum;
+		else if (DatumGetInt32(FunctionCall2Coll(&tcache->cmp_proc_finfo,
+												 bkey->collid,
+												 datum,
+												 bkey->max_value)) > 0)
+			bkey->max_value = datum;
+	}
+}
+
+/*
+ * gpujoin_build_bloom_filter
+ *
+ * It constructs the bloom filter next to the outer-join maps, according to
+ * the hash-values of the depth-1 inner relation. If @bf_head is NULL, an
+ * empty header is written, to tell other processes no bloom filter here.
+ * It may expand and remap the DSM segment, thus returns the new address.
+ */
+static kern_multirels *
+gpujoin_build_bloom_filter(dsm_segment *seg, GpuJoinBloomFilter *bf_head)
+{
+	kern_multirels *h_kmrels = dsm_segment_address(seg);
+	kern_data_store *kds_hash = KERN_MULTIRELS_INNER_KDS(h_kmrels, 1);
+	GpuJoinBloomFilter *bloom;
+	size_t		bloom_offset = GPUJOIN_BLOOM_FILTER_OFFSET(h_kmrels);
+	size_t		required;
+	cl_ulong	nbits = 0;
+	cl_uint	   *row_index;
+	cl_uint		i;
+
+	if (bf_head)
+	{
+		Assert(kds_hash->format == KDS_FORMAT_HASH);
+		nbits = 1024;
+		while (nbits < ((cl_ulong)kds_hash->nitems *
+						GPUJOIN_BLOOM_BITS_PER_ITEM))
+			nbits <<= 1;
+		if (nbits > GPUJOIN_BLOOM_NBITS_MAX)
+			nbits = 0;		/* too large, range of the keys only */
+	}
+	required = (bloom_offset +
+				offsetof(GpuJoinBloomFilter, bitmap[nbits / 64]));
+	if (required > dsm_segment_map_length(seg))
+	{
+		h_kmrels = dsm_resize(seg, TYPEALIGN(BLCKSZ, required));
+		kds_hash = KERN_MULTIRELS_INNER_KDS(h_kmrels, 1);
+	}
+	bloom = (GpuJoinBloomFilter *)((char *)h_kmrels + bloom_offset);
+	if (!bf_head)
+	{
+		memset(bloom, 0, offsetof(GpuJoinBloomFilter, bitmap));
+		return h_kmrels;
+	}
+	memcpy(bloom, bf_head, offsetof(GpuJoinBloomFilter, bitmap));
+	bloom->nbits = nbits;
+	if (nbits > 0)
+	{
+		memset(bloom->bitmap, 0, nbits / BITS_PER_BYTE);
+		row_index = KERN_DATA_STORE_ROWINDEX(kds_hash);
+		for (i=0; i < kds_hash->nitems; i++)
+		{
+			kern_hashitem  *khitem = (kern_hashitem *)
+				((char *)kds_hash
+				 + __kds_unpack(row_index[i])
+				 - offsetof(kern_hashitem, t));
+			gpujoin_bloom_filter_insert(bloom, khitem->hash);
+		}
+	}
+	return h_kmrels;
+}
+
 /*
  * gpujoin_inner_hash_preload
  *
@@ -6489,7 +7603,8 @@ static void
 gpujoin_inner_hash_preload(innerState *istate,
 						   dsm_segment *seg,
 						   kern_data_store *kds_hash,
-						   size_t kds_offset)
+						   size_t kds_offset,
+						   GpuJoinBloomFilter *bf_head)
 {
 	TupleTableSlot *scan_slot;
 	cl_uint		   *row_index;
@@ -6518,6 +7633,8 @@ gpujoin_inner_hash_preload(innerState *istate,
 
 		while (!KDS_insert_hashitem(kds_hash, scan_slot, hash))
 			kds_hash = gpujoin_expand_inner_kds(seg, kds_offset);
+		if (bf_head)
+			gpujoin_bloom_filter_track_keys(istate, bf_head);
 	}
 	kds_hash->nslots = __KDS_NSLOTS(kds_hash->nitems);
 	gpujoin_compaction_inner_kds(kds_hash);
@@ -6589,6 +7706,8 @@ __gpujoin_inner_preload(GpuJoinState *gjs, bool preload_multi_gpu)
 	size_t			kmrels_usage = 0;
 	size_t			required;
 	bool			result = true;
+	bool			use_bloom = gpujoin_bloom_filter_available(gjs);
+	GpuJoinBloomFilter bf_head;
 
 	Assert(!IsParallelWorker());
 	gjs->m_kmrels_array = MemoryContextAllocZero(CurTransactionContext,
@@ -6606,6 +7725,8 @@ __gpujoin_inner_preload(GpuJoinState *gjs, bool preload_multi_gpu)
 	memcpy(h_kmrels->pg_crc32_table,
 		   pg_crc32_table,
 		   sizeof(pg_crc32_table));
+	if (use_bloom)
+		gpujoin_bloom_filter_init_keys(&gjs->inners[0], &bf_head);
 	for (i=0; i < num_rels; i++)
 	{
 		innerState	   *istate = &gjs->inners[i];
@@ -6637,7 +7758,9 @@ __gpujoin_inner_preload(GpuJoinState *gjs, bool preload_multi_gpu)
 							   false);
 		h_kmrels->chunks[i].chunk_offset = kmrels_usage;
 		if (istate->hash_inner_keys != NIL)
-			gpujoin_inner_hash_preload(istate, seg, kds, kmrels_usage);
+			gpujoin_inner_hash_preload(istate, seg, kds, kmrels_usage,
+									   (i == 0 && use_bloom
+										? &bf_head : NULL));
 		else
 			gpujoin_inner_heap_preload(istate, seg, kds, kmrels_usage);
 
@@ -6659,6 +7782,10 @@ __gpujoin_inner_preload(GpuJoinState *gjs, bool preload_multi_gpu)
 		{
 			h_kmrels->chunks[i].left_outer = true;
 		}
+		if (istate->join_type == JOIN_SEMI)
+			h_kmrels->chunks[i].semi_join = true;
+		if (istate->join_type == JOIN_ANTI)
+			h_kmrels->chunks[i].anti_join = true;
 		kmrels_usage += STROMALIGN(kds->length);
 	}
 	Assert(kmrels_usage <= dsm_segment_map_length(seg));
@@ -6666,6 +7793,8 @@ __gpujoin_inner_preload(GpuJoinState *gjs, bool preload_multi_gpu)
 	h_kmrels->ojmaps_length = ojmaps_usage;
 	h_kmrels->cuda_dindex = numDevAttrs;	/* host side */
 	h_kmrels->nrels = num_rels;
+	/* bloom filter is located next to the ojmaps, never sent to GPU */
+	h_kmrels = gpujoin_build_bloom_filter(seg, use_bloom ? &bf_head : NULL);
 
 	/*
 	 * NOTE: Special optimization case. In case when any chunk has no items,
@@ -6676,8 +7805,9 @@ __gpujoin_inner_preload(GpuJoinState *gjs, bool preload_multi_gpu)
 	for (i=num_rels; i > 0; i--)
 	{
 		kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, i);
-		/* outer join can produce something from empty */
-		if (gjs->inners[i-1].join_type != JOIN_INNER)
+		/* outer/anti join can produce something from empty */
+		if (gjs->inners[i-1].join_type != JOIN_INNER &&
+			gjs->inners[i-1].join_type != JOIN_SEMI)
 			break;
 		if (kds->nitems == 0)
 		{
@@ -7034,6 +8164,10 @@ GpuJoinInnerUnload(GpuTaskState *gts, bool is_rescan)
 	gjs->curr_outer_depth = -1;
 	gjs->m_kmrels = 0UL;
 	gjs->seg_kmrels = NULL;
+	gjs->bloom_ready = false;
+	gjs->bloom = NULL;
+	gjs->bloom_nprobed = 0;
+	gjs->bloom_nremoved = 0;
 }
 
 /*
@@ -7140,6 +8274,33 @@ pgstrom_init_gpujoin(void)
 #else
 	enable_partitionwise_gpujoin = false;
 #endif
+	/* turn on/off reordering of inner relations */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_inner_reorder",
+							 "Enables reordering of inner relations of GpuJoin by selectivity",
+							 NULL,
+							 &enable_gpujoin_inner_reorder,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off bloom filter on the inner join-keys */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_bloom_filter",
+							 "Enables bloom filter on the inner join-keys of GpuJoin to remove outer rows in advance",
+							 NULL,
+							 &enable_gpujoin_bloom_filter,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* turn on/off late materialization of wide outer columns */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_late_materialization",
+							 "Enables late materialization of wide outer columns by GpuJoin",
+							 NULL,
+							 &enable_gpujoin_late_materialization,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/* setup path methods */
 	gpujoin_path_methods.CustomName				= "GpuJoin";
 	gpujoin_path_methods.PlanCustomPath			= PlanGpuJoinPath;
@@ -28,11 +28,55 @@ static bool					enable_gpupreagg;				/* GUC */
 static bool					enable_pullup_outer_join;		/* GUC */
 static bool					enable_partitionwise_gpupreagg;	/* GUC */
 static double				gpupreagg_reduction_threshold;	/* GUC */
+static bool					enable_gpupreagg_feedback;		/* GUC */
+static int					gpupreagg_feedback_num_entries;	/* GUC */
+static int					gpupreagg_feedback_num_slots;
+static shmem_startup_hook_type shmem_startup_next = NULL;
+
+/*
+ * gpreaggFeedbackEntry - actual number of groups of GpuPreAgg per plan
+ * fingerprint, on the shared memory
+ *
+ * The fingerprint is just a hash of the key, so the full key is also kept
+ * to distinguish the conflicted ones. Plans with longer key than
+ * GPUPREAGG_FEEDBACK_KEYLEN do not use the feedback.
+ */
+#define GPUPREAGG_FEEDBACK_KEYLEN	2048
+
+typedef struct
+{
+	dlist_node		hash_chain;		/* link to the hash slot or free list */
+	dlist_node		lru_chain;		/* link to LRU list */
+	Oid				database_oid;	/* OID of the database */
+	cl_uint			fingerprint;	/* fingerprint of the grouping */
+	char			key[GPUPREAGG_FEEDBACK_KEYLEN];	/* key of the grouping */
+	double			est_ngroups;	/* planner's estimation */
+	cl_ulong		num_groups;		/* actual number of groups */
+	cl_ulong		fhash_conflicts; /* actual number of fhash conflicts */
+	cl_ulong		nitems_in;		/* actual number of input rows */
+	cl_ulong		nexecs;			/* number of executions */
+	TimestampTz		last_update;	/* timestamp of the last execution */
+} gpreaggFeedbackEntry;
+
+typedef struct
+{
+	slock_t			lock;
+	dlist_head		lru_list;
+	dlist_head		free_list;
+	dlist_head		slots[FLEXIBLE_ARRAY_MEMBER];
+} gpreaggFeedbackHead;
+
+static gpreaggFeedbackHead *gpupreagg_feedback_head = NULL;	/* shmem */
+
+Datum pgstrom_gpupreagg_feedback_info(PG_FUNCTION_ARGS);
 
 typedef struct
 {
 	cl_int			num_group_keys;	/* number of grouping keys */
 	double			plan_ngroups;	/* planned number of groups */
+	double			plan_ngroups_est; /* planner's estimation w/o feedback */
+	cl_uint			plan_fingerprint; /* fingerprint of the grouping */
+	char		   *plan_feedback_key; /* key of the grouping */
 	cl_int			plan_nchunks;	/* planned number of chunks */
 	cl_int			plan_extra_sz;	/* planned size of extra-sz per tuple */
 	Cost			outer_startup_cost; /* copy of @startup_cost in outer */
@@ -64,6 +108,9 @@ form_gpupreagg_info(CustomScan *cscan, GpuPreAggInfo *gpa_info)
 
 	privs = lappend(privs, makeInteger(gpa_info->num_group_keys));
 	privs = lappend(privs, pmakeFloat(gpa_info->plan_ngroups));
+	privs = lappend(privs, pmakeFloat(gpa_info->plan_ngroups_est));
+	privs = lappend(privs, makeInteger(gpa_info->plan_fingerprint));
+	privs = lappend(privs, makeString(gpa_info->plan_feedback_key));
 	privs = lappend(privs, makeInteger(gpa_info->plan_nchunks));
 	privs = lappend(privs, makeInteger(gpa_info->plan_extra_sz));
 	privs = lappend(privs, pmakeFloat(gpa_info->outer_startup_cost));
@@ -99,6 +146,9 @@ deform_gpupreagg_info(CustomScan *cscan)
 
 	gpa_info->num_group_keys = intVal(list_nth(privs, pindex++));
 	gpa_info->plan_ngroups = floatVal(list_nth(privs, pindex++));
+	gpa_info->plan_ngroups_est = floatVal(list_nth(privs, pindex++));
+	gpa_info->plan_fingerprint = intVal(list_nth(privs, pindex++));
+	gpa_info->plan_feedback_key = strVal(list_nth(privs, pindex++));
 	gpa_info->plan_nchunks = intVal(list_nth(privs, pindex++));
 	gpa_info->plan_extra_sz = intVal(list_nth(privs, pindex++));
 	gpa_info->outer_startup_cost = floatVal(list_nth(privs, pindex++));
@@ -156,6 +206,9 @@ typedef struct
 	size_t			plan_nrows_in;	/* num of outer rows planned */
 	size_t			plan_ngroups;	/* num of groups planned */
 	size_t			plan_extra_sz;	/* size of varlena planned */
+	double			plan_ngroups_est; /* planner's estimation w/o feedback */
+	cl_uint			plan_fingerprint; /* fingerprint of the grouping */
+	char		   *plan_feedback_key; /* key of the grouping */
 } GpuPreAggState;
 
 struct GpuPreAggRuntimeStat
@@ -164,6 +217,8 @@ struct GpuPreAggRuntimeStat
 	pg_atomic_uint64	source_nitems;
 	pg_atomic_uint64	nitems_filtered;
 	pg_atomic_uint64	num_fallback_rows;
+	pg_atomic_uint64	num_groups;
+	pg_atomic_uint64	fhash_conflicts;
 };
 typedef struct GpuPreAggRuntimeStat	GpuPreAggRuntimeStat;
 
@@ -233,6 +288,7 @@ static GpuTask *gpupreagg_next_task(GpuTaskState *gts);
 static GpuTask *gpupreagg_terminator_task(GpuTaskState *gts,
 										  cl_bool *task_is_ready);
 static int  gpupreagg_process_task(GpuTask *gtask, CUmodule cuda_module);
+static bool gpupreagg_build_fallback(GpuTask *gtask);
 static void gpupreagg_release_task(GpuTask *gtask);
 static TupleTableSlot *gpupreagg_next_tuple(GpuTaskState *gts);
 
@@ -925,6 +981,184 @@ aggfunc_lookup_by_oid(Oid aggfnoid)
 	return NULL;
 }
 
+/*
+ * gpupreagg_plan_fingerprint
+ *
+ * It identifies the grouping on a particular input; hash of the OIDs of
+ * the underlying relations, their scan qualifiers and the grouping keys
+ * on the device side, including arguments of DISTINCT aggregates.
+ * The key to be hashed is also returned on @p_key.
+ * Zero means no grouping keys, or too long key to be kept.
+ */
+static cl_uint
+gpupreagg_plan_fingerprint(PlannerInfo *root,
+						   PathTarget *target_device,
+						   Path *input_path,
+						   char **p_key)
+{
+	Relids		relids = input_path->parent->relids;
+	StringInfoData buf;
+	List	   *group_exprs = NIL;
+	ListCell   *lc;
+	cl_uint		fingerprint;
+	int			index = 0;
+	int			k = -1;
+
+	foreach (lc, target_device->exprs)
+	{
+		if (get_pathtarget_sortgroupref(target_device, index))
+			group_exprs = lappend(group_exprs, lfirst(lc));
+		index++;
+	}
+	*p_key = "";
+	if (group_exprs == NIL)
+		return 0;
+
+	initStringInfo(&buf);
+	while ((k = bms_next_member(relids, k)) >= 0)
+	{
+		RangeTblEntry *rte;
+		RelOptInfo *rel;
+
+		if (k >= root->simple_rel_array_size)
+			continue;
+		rte = root->simple_rte_array[k];
+		rel = root->simple_rel_array[k];
+		if (!rte || !rel)
+			continue;
+		appendStringInfo(&buf, "%u:", rte->relid);
+		foreach (lc, rel->baserestrictinfo)
+		{
+			RestrictInfo *rinfo = lfirst(lc);
+
+			appendStringInfoString(&buf, nodeToString(rinfo->clause));
+		}
+	}
+	appendStringInfoString(&buf, nodeToString(group_exprs));
+	if (buf.len >= GPUPREAGG_FEEDBACK_KEYLEN)
+	{
+		pfree(buf.data);
+		return 0;
+	}
+	fingerprint = DatumGetUInt32(hash_any((unsigned char *)buf.data,
+										  buf.len));
+	*p_key = buf.data;
+
+	return (fingerprint != 0 ? fingerprint : 1);
+}
+
+/*
+ * gpupreagg_feedback_lookup
+ *
+ * It returns the actual number of groups in the last execution of the plan
+ * with the same key, if any.
+ */
+static bool
+gpupreagg_feedback_lookup(cl_uint fingerprint, const char *key,
+						  double *p_num_groups)
+{
+	gpreaggFeedbackHead *head = gpupreagg_feedback_head;
+	dlist_iter	iter;
+	int			index;
+	bool		found = false;
+
+	if (!head || !enable_gpupreagg_feedback || fingerprint == 0)
+		return false;
+
+	index = fingerprint % gpupreagg_feedback_num_slots;
+	SpinLockAcquire(&head->lock);
+	dlist_foreach(iter, &head->slots[index])
+	{
+		gpreaggFeedbackEntry *entry
+			= dlist_container(gpreaggFeedbackEntry, hash_chain, iter.cur);
+
+		if (entry->database_oid == MyDatabaseId &&
+			entry->fingerprint == fingerprint &&
+			strcmp(entry->key, key) == 0)
+		{
+			*p_num_groups = Max((double)entry->num_groups, 1.0);
+			dlist_move_head(&head->lru_list, &entry->lru_chain);
+			found = true;
+			break;
+		}
+	}
+	SpinLockRelease(&head->lock);
+
+	return found;
+}
+
+/*
+ * gpupreagg_feedback_record
+ *
+ * It records the actual number of groups and fhash conflicts at the end of
+ * GpuPreAgg execution. The least recently used entry is reclaimed, if full.
+ */
+static void
+gpupreagg_feedback_record(GpuPreAggState *gpas)
+{
+	gpreaggFeedbackHead *head = gpupreagg_feedback_head;
+	GpuPreAggRuntimeStat *gpa_rtstat = gpas->gpa_rtstat;
+	gpreaggFeedbackEntry *entry = NULL;
+	cl_uint		fingerprint = gpas->plan_fingerprint;
+	const char *key = gpas->plan_feedback_key;
+	uint64		nitems_in;
+	dlist_iter	iter;
+	int			index;
+
+	if (!head || !enable_gpupreagg_feedback || fingerprint == 0 ||
+		!gpa_rtstat || IsParallelWorker())
+		return;
+	/* not executed, or EXPLAIN without ANALYZE */
+	nitems_in = pg_atomic_read_u64(&gpa_rtstat->source_nitems);
+	if (nitems_in == 0)
+		return;
+
+	index = fingerprint % gpupreagg_feedback_num_slots;
+	SpinLockAcquire(&head->lock);
+	dlist_foreach(iter, &head->slots[index])
+	{
+		gpreaggFeedbackEntry *temp
+			= dlist_container(gpreaggFeedbackEntry, hash_chain, iter.cur);
+
+		if (temp->database_oid == MyDatabaseId &&
+			temp->fingerprint == fingerprint &&
+			strcmp(temp->key, key) == 0)
+		{
+			entry = temp;
+			dlist_move_head(&head->lru_list, &entry->lru_chain);
+			break;
+		}
+	}
+
+	if (!entry)
+	{
+		if (!dlist_is_empty(&head->free_list))
+			entry = dlist_container(gpreaggFeedbackEntry, hash_chain,
+									dlist_pop_head_node(&head->free_list));
+		else
+		{
+			/* reclaim the least recently used entry */
+			entry = dlist_container(gpreaggFeedbackEntry, lru_chain,
+									dlist_tail_node(&head->lru_list));
+			dlist_delete(&entry->hash_chain);
+			dlist_delete(&entry->lru_chain);
+		}
+		memset(entry, 0, sizeof(gpreaggFeedbackEntry));
+		entry->database_oid = MyDatabaseId;
+		entry->fingerprint = fingerprint;
+		strcpy(entry->key, key);
+		dlist_push_head(&head->slots[index], &entry->hash_chain);
+		dlist_push_head(&head->lru_list, &entry->lru_chain);
+	}
+	entry->est_ngroups = gpas->plan_ngroups_est;
+	entry->num_groups = pg_atomic_read_u64(&gpa_rtstat->num_groups);
+	entry->fhash_conflicts = pg_atomic_read_u64(&gpa_rtstat->fhash_conflicts);
+	entry->nitems_in = nitems_in;
+	entry->nexecs++;
+	entry->last_update = GetCurrentTimestamp();
+	SpinLockRelease(&head->lock);
+}
+
 /*
  * cost_gpupreagg
  *
@@ -943,7 +1177,7 @@ cost_gpupreagg(PlannerInfo *root,
 			   List *index_quals,
 			   cl_long index_nblocks)
 {
-	double		gpu_cpu_ratio = pgstrom_gpu_operator_cost / cpu_operator_cost;
+	double		gpu_cpu_ratio;
 	double		ntuples_out;
 	Cost		startup_cost;
 	Cost		run_cost;
@@ -953,6 +1187,14 @@ cost_gpupreagg(PlannerInfo *root,
 	cl_int		key_dist_salt;
 	cl_int		index;
 	ListCell   *lc;
+	pgstromCostFactors cf;
+	double		num_groups_est = num_groups;
+	cl_uint		fingerprint = 0;
+	char	   *feedback_key = "";
+
+	/* cost factors of the device / tablespace */
+	pgstrom_get_cost_factors(root, input_path->parent, &cf);
+	gpu_cpu_ratio = cf.gpu_operator_cost / cpu_operator_cost;
 
 	/* Cost come from the underlying path */
 	if (gpa_info->outer_scanrelid == 0)
@@ -969,11 +1211,11 @@ cost_gpupreagg(PlannerInfo *root,
 			pgstrom_path_is_gpujoin(input_path) &&
 			pgstrom_device_expression(root, (Expr *)outer_tlist))
 		{
-			outer_total -= cost_for_dma_receive(input_path->parent, -1.0);
+			outer_total -= cost_for_dma_receive(root, input_path->parent, -1.0);
 			outer_total -= cpu_tuple_cost * input_path->rows;
 		}
 		else
-			outer_total += pgstrom_gpu_setup_cost;
+			outer_total += cf.gpu_setup_cost;
 
 		gpa_info->outer_startup_cost = outer_startup;
 		gpa_info->outer_total_cost   = outer_total;
@@ -1039,6 +1281,14 @@ cost_gpupreagg(PlannerInfo *root,
 	}
 	if (num_group_keys == 0)
 		num_groups = 1.0;	/* AGG_PLAIN */
+	else
+	{
+		/* actual number of groups in the last execution, if any */
+		fingerprint = gpupreagg_plan_fingerprint(root, target_device,
+												 input_path,
+												 &feedback_key);
+		gpupreagg_feedback_lookup(fingerprint, feedback_key, &num_groups);
+	}
 	/*
 	 * NOTE: In case when the number of groups are too small, it leads too
 	 * many atomic contention on the device. So, we add a small salt to
@@ -1071,7 +1321,7 @@ cost_gpupreagg(PlannerInfo *root,
 	startup_cost += (target_device->cost.per_tuple * input_path->rows +
 					 target_device->cost.startup) * gpu_cpu_ratio;
 	/* Cost estimation for grouping */
-	startup_cost += (pgstrom_gpu_operator_cost *
+	startup_cost += (cf.gpu_operator_cost *
 					 num_group_keys *
 					 input_path->rows);
 	/* Cost estimation for aggregate function */
@@ -1090,6 +1340,9 @@ cost_gpupreagg(PlannerInfo *root,
 
 	gpa_info->num_group_keys    = num_group_keys;
 	gpa_info->plan_ngroups		= num_groups;
+	gpa_info->plan_ngroups_est	= num_groups_est;
+	gpa_info->plan_fingerprint	= fingerprint;
+	gpa_info->plan_feedback_key	= feedback_key;
 	gpa_info->plan_nchunks		= estimate_num_chunks(input_path);
 	gpa_info->plan_extra_sz		= extra_sz;
 
@@ -1380,6 +1633,17 @@ try_add_final_aggregation_paths(PlannerInfo *root,
 				}
 				if (!lc)
 					return;		/* give up */
+#if PG_VERSION_NUM >= 100000
+				/* all the grouping sets are hashed, so no need to sort */
+				if (rollup_strategy == AGG_HASHED)
+					sort_path = partial_path;
+#endif
+				/*
+				 * GpuPreAgg runs partial aggregation by the finest grouping
+				 * set, that is the union of all the grouping-keys, once.
+				 * Then, GroupingSets node derives the coarser grouping sets
+				 * from the partial results.
+				 */
 				final_path = (Path *)
 					create_groupingsets_path(root,
 											 group_rel,
@@ -1387,7 +1651,7 @@ try_add_final_aggregation_paths(PlannerInfo *root,
 #if PG_VERSION_NUM < 110000
 											 target_final,
 #endif
-											 (List *) parse->havingQual,
+											 havingQuals,
 #if PG_VERSION_NUM < 100000
 											 rollup_lists,
 											 rollup_groupclauses,
@@ -1494,6 +1758,7 @@ try_add_gpupreagg_append_paths(PlannerInfo *root,
 							   Bitmapset *pfunc_bitmap,
 							   List *havingQual,
 							   double num_groups,
+							   double num_partial_groups,
 							   AggClauseCosts *agg_final_costs,
 							   bool can_pullup_outerscan,
 							   bool try_parallel_path)
@@ -1541,7 +1806,7 @@ try_add_gpupreagg_append_paths(PlannerInfo *root,
 											  curr_device,
 											  sub_path,
 											  pfunc_bitmap,
-											  num_groups,
+											  num_partial_groups,
 											  can_pullup_outerscan,
 											  false);
 		if (!partial_path)
@@ -1616,22 +1881,13 @@ try_add_gpupreagg_paths(PlannerInfo *root,
 	Path		   *partial_path;
 	Bitmapset	   *pfunc_bitmap;
 	Node		   *havingQual;
+	List		   *distinct_keys;
 	double			num_groups;
+	double			num_partial_groups;
 	double			reduction_ratio;
 	bool			can_pullup_outerscan = true;
 	AggClauseCosts	agg_final_costs;
 
-	/*
-	 * MEMO: The 'pg_strom.gpupreagg_reduction_threshold' is a tentative
-	 * solution to avoid overflow of GPU device memory for GpuPreAgg.
-	 * In case of large table scan with small reduction ratio is almost
-	 * equivalent to cache most of input records in GPU device memory.
-	 * Then, it shall be aggregated on CPU-side again, it is usually waste
-	 * of computing power and data transfer.
-	 * Of course, a threshold is not a perfect solution. We may need to
-	 * switch to bypass GPU once reduction ratio (or absolute data size) is
-	 * worse than the estimation at the planning stage.
-	 */
 	if (!parse->groupClause)
 		num_groups = 1.0;
 	else
@@ -1640,13 +1896,6 @@ try_add_gpupreagg_paths(PlannerInfo *root,
 
 		num_groups = Max(pathnode->rows, 1.0);
 	}
-	reduction_ratio = input_path->rows / num_groups;
-	if (reduction_ratio < gpupreagg_reduction_threshold)
-	{
-		elog(DEBUG2, "GpuPreAgg: %.0f -> %.0f reduction ratio (%.2f) is bad",
-			 input_path->rows, num_groups, reduction_ratio);
-		return;
-	}
 
 	/* construction of the target-list for each level */
 	if (!gpupreagg_build_path_target(root,
@@ -1657,9 +1906,48 @@ try_add_gpupreagg_paths(PlannerInfo *root,
 									 input_path->pathtarget,
 									 &pfunc_bitmap,
 									 &havingQual,
+									 &distinct_keys,
 									 &can_pullup_outerscan))
 		return;
 
+	/*
+	 * Number of groups in the partial aggregation. GpuPreAgg runs with
+	 * the finest grouping set, if GROUPING SETS, and arguments of DISTINCT
+	 * aggregates are also grouping-keys. So, it is not equivalent to the
+	 * number of groups in the final aggregation.
+	 */
+	num_partial_groups = num_groups;
+	if (parse->groupingSets != NIL || distinct_keys != NIL)
+	{
+		List   *group_exprs = get_sortgrouplist_exprs(parse->groupClause,
+													  parse->targetList);
+
+		group_exprs = list_concat(group_exprs, list_copy(distinct_keys));
+		num_partial_groups = estimate_num_groups(root, group_exprs,
+												 input_path->rows, NULL);
+		if (parse->groupingSets == NIL)
+			num_partial_groups = Max(num_partial_groups, num_groups);
+	}
+
+	/*
+	 * MEMO: The 'pg_strom.gpupreagg_reduction_threshold' is a tentative
+	 * solution to avoid overflow of GPU device memory for GpuPreAgg.
+	 * In case of large table scan with small reduction ratio is almost
+	 * equivalent to cache most of input records in GPU device memory.
+	 * Then, it shall be aggregated on CPU-side again, it is usually waste
+	 * of computing power and data transfer.
+	 * Of course, a threshold is not a perfect solution. We may need to
+	 * switch to bypass GPU once reduction ratio (or absolute data size) is
+	 * worse than the estimation at the planning stage.
+	 */
+	reduction_ratio = input_path->rows / num_partial_groups;
+	if (reduction_ratio < gpupreagg_reduction_threshold)
+	{
+		elog(DEBUG2, "GpuPreAgg: %.0f -> %.0f reduction ratio (%.2f) is bad",
+			 input_path->rows, num_partial_groups, reduction_ratio);
+		return;
+	}
+
 	/* Get cost of aggregations */
 	memset(&agg_final_costs, 0, sizeof(AggClauseCosts));
 	if (parse->hasAggs)
@@ -1669,12 +1957,12 @@ try_add_gpupreagg_paths(PlannerInfo *root,
 		get_agg_clause_costs(root, havingQual,
 							 AGGSPLIT_SIMPLE, &agg_final_costs);
 	}
-	/* GpuPreAgg does not support ordered aggregation */
-	if (agg_final_costs.numOrderedAggs > 0)
-	{
-		elog(DEBUG2, "GpuPreAgg does not support ordered aggregation");
-		return;
-	}
+	/*
+	 * GpuPreAgg does not support ordered aggregation, except for DISTINCT
+	 * aggregates which are processed by the final Agg node. Note that
+	 * numOrderedAggs counts them also, so hash aggregation is not chosen.
+	 */
+	Assert(agg_final_costs.numOrderedAggs == 0 || distinct_keys != NIL);
 
 	if (enable_partitionwise_gpupreagg)
 		try_add_gpupreagg_append_paths(root,
@@ -1686,6 +1974,7 @@ try_add_gpupreagg_paths(PlannerInfo *root,
 									   pfunc_bitmap,
 									   (List *) havingQual,
 									   num_groups,
+									   num_partial_groups,
 									   &agg_final_costs,
 									   can_pullup_outerscan,
 									   try_parallel_path);
@@ -1696,7 +1985,7 @@ try_add_gpupreagg_paths(PlannerInfo *root,
 										  target_device,
 										  input_path,
 										  pfunc_bitmap,
-										  num_groups,
+										  num_partial_groups,
 										  can_pullup_outerscan,
 										  try_parallel_path);
 	if (!partial_path ||
@@ -2146,6 +2435,68 @@ make_altfunc_pcov_xy(Aggref *aggref, const char *func_name)
 						COERCE_EXPLICIT_CALL);
 }
 
+/*
+ * make_alternative_distinct_aggref
+ *
+ * Aggregate with DISTINCT is processed by two-level reduction. Its arguments
+ * are added to the grouping-keys of GpuPreAgg, so partial aggregation
+ * eliminates duplicated pairs of the grouping-keys and the distinct values.
+ * Then, the final Agg node runs the original aggregate function with
+ * DISTINCT on the partial results, to eliminate rest of the duplications
+ * across the chunks. So, the aggregate function itself needs not to be
+ * device executable.
+ */
+static Node *
+make_alternative_distinct_aggref(PlannerInfo *root,
+								 Aggref *aggref,
+								 PathTarget *target_input,
+								 List **p_distinct_keys)
+{
+	List	   *distinct_keys = *p_distinct_keys;
+	ListCell   *lc;
+
+	if (aggref->aggfilter)
+	{
+		elog(DEBUG2, "DISTINCT aggregate with FILTER is not supported: %s",
+			 nodeToString(aggref));
+		return NULL;
+	}
+
+	foreach (lc, aggref->args)
+	{
+		TargetEntry	   *tle = lfirst(lc);
+		Expr		   *expr = tle->expr;
+		devtype_info   *dtype;
+		Oid				coll_oid;
+
+		/*
+		 * Argument of the DISTINCT aggregate performs as a grouping-key,
+		 * so its type must have device equality-function.
+		 */
+		dtype = pgstrom_devtype_lookup(exprType((Node *)expr));
+		coll_oid = exprCollation((Node *)expr);
+		if (!dtype || !pgstrom_devfunc_lookup_type_equal(dtype, coll_oid))
+		{
+			elog(DEBUG2, "DISTINCT aggregate has unsupported type (%s): %s",
+				 format_type_be(exprType((Node *)expr)),
+				 nodeToString((Node *)expr));
+			return NULL;
+		}
+		/* grouping-key should be on the any of input items */
+		if (!list_member(target_input->exprs, expr))
+		{
+			elog(DEBUG2, "argument of DISTINCT aggregate is not on the input tlist: %s",
+				 nodeToString((Node *)expr));
+			return NULL;
+		}
+		distinct_keys = list_append_unique(distinct_keys, expr);
+	}
+	*p_distinct_keys = distinct_keys;
+
+	/* final aggregate function is the original one, as is */
+	return (Node *)copyObject(aggref);
+}
+
 /*
  * make_alternative_aggref
  *
@@ -2158,7 +2509,8 @@ make_alternative_aggref(PlannerInfo *root,
 						PathTarget *target_partial,
 						PathTarget *target_device,
 						PathTarget *target_input,
-						Bitmapset **p_pfunc_bitmap)
+						Bitmapset **p_pfunc_bitmap,
+						List **p_distinct_keys)
 {
 	const aggfunc_catalog_t *aggfn_cat;
 	Aggref	   *aggref_new;
@@ -2173,9 +2525,9 @@ make_alternative_aggref(PlannerInfo *root,
 	Form_pg_proc proc_form;
 	Form_pg_aggregate agg_form;
 
-	if (aggref->aggorder || aggref->aggdistinct)
+	if (aggref->aggorder)
 	{
-		elog(DEBUG2, "Aggregate with DISTINCT/ORDER BY is not supported: %s",
+		elog(DEBUG2, "Aggregate with ORDER BY is not supported: %s",
 			 nodeToString(aggref));
 		return NULL;
 	}
@@ -2185,6 +2537,10 @@ make_alternative_aggref(PlannerInfo *root,
 			 nodeToString(aggref));
 		return NULL;
 	}
+	if (aggref->aggdistinct)
+		return make_alternative_distinct_aggref(root, aggref,
+												target_input,
+												p_distinct_keys);
 
 	/*
 	 * Lookup properties of aggregate function
@@ -2380,6 +2736,7 @@ typedef struct
 	PathTarget *target_device;
 	PathTarget *target_input;
 	Bitmapset  *pfunc_bitmap;
+	List	   *distinct_keys;
 } gpupreagg_build_path_target_context;
 
 static Node *
@@ -2391,6 +2748,12 @@ replace_expression_by_altfunc(Node *node,
 
 	if (!node)
 		return NULL;
+	/*
+	 * GROUPING() is evaluated by the final GroupingSets node according to
+	 * the current grouping set, and its arguments are grouping-keys.
+	 */
+	if (IsA(node, GroupingFunc))
+		return copyObject(node);
 	if (IsA(node, Aggref))
 	{
 		Node   *aggfn = make_alternative_aggref(con->root,
@@ -2398,7 +2761,8 @@ replace_expression_by_altfunc(Node *node,
 												con->target_partial,
 												con->target_device,
 												con->target_input,
-												&con->pfunc_bitmap);
+												&con->pfunc_bitmap,
+												&con->distinct_keys);
 		if (!aggfn)
 			con->device_executable = false;
 		return aggfn;
@@ -2423,6 +2787,40 @@ replace_expression_by_altfunc(Node *node,
 	return expression_tree_mutator(node, replace_expression_by_altfunc, con);
 }
 
+/*
+ * add_grouping_key_to_partial_target
+ *
+ * It marks the expression on the target_partial as a grouping-key, or adds
+ * a new grouping-key column if not found.
+ */
+static void
+add_grouping_key_to_partial_target(PathTarget *target_partial,
+								   Expr *expr, Index sortgroupref)
+{
+	ListCell   *lc;
+	int			j = 0;
+	int			n;
+
+	foreach (lc, target_partial->exprs)
+	{
+		if (equal(expr, lfirst(lc)) &&
+			(!target_partial->sortgrouprefs ||
+			 target_partial->sortgrouprefs[j] == 0))
+		{
+			n = list_length(target_partial->exprs);
+			target_partial->sortgrouprefs =
+				(!target_partial->sortgrouprefs
+				 ? palloc0(sizeof(Index) * (n+1))
+				 : repalloc(target_partial->sortgrouprefs,
+							sizeof(Index) * (n+1)));
+			target_partial->sortgrouprefs[j] = sortgroupref;
+			return;
+		}
+		j++;
+	}
+	add_column_to_pathtarget(target_partial, expr, sortgroupref);
+}
+
 /*
  * gpupreagg_build_path_target
  *
@@ -2438,6 +2836,7 @@ gpupreagg_build_path_target(PlannerInfo *root,			/* in */
 							PathTarget *target_input,	/* in */
 							Bitmapset **p_pfunc_bitmap,	/* out */
 							Node **p_havingQual,		/* out */
+							List **p_distinct_keys,		/* out */
 							bool *p_can_pullup_outerscan) /* out */
 {
 	gpupreagg_build_path_target_context con;
@@ -2525,27 +2924,8 @@ gpupreagg_build_path_target(PlannerInfo *root,			/* in */
 			 * OK, It's a grouping-key column, so add it to both of
 			 * the target_final, target_partial and target_device as-is.
 			 */
-			j=0;
-			foreach (cell, target_partial->exprs)
-			{
-				if (equal(expr, lfirst(cell)) &&
-					(!target_partial->sortgrouprefs ||
-					 target_partial->sortgrouprefs[j] == 0))
-				{
-					n = list_length(target_partial->exprs);
-					target_partial->sortgrouprefs =
-						(!target_partial->sortgrouprefs
-						 ? palloc0(sizeof(Index) * (n+1))
-						 : repalloc(target_partial->sortgrouprefs,
-									sizeof(Index) * (n+1)));
-					target_partial->sortgrouprefs[j] = sortgroupref;
-					break;
-				}
-				j++;
-			}
-			if (!cell)
-				add_column_to_pathtarget(target_partial, expr, sortgroupref);
-
+			add_grouping_key_to_partial_target(target_partial,
+											   expr, sortgroupref);
 			add_column_to_pathtarget(target_final, expr, sortgroupref);
 		}
 		else
@@ -2583,6 +2963,49 @@ gpupreagg_build_path_target(PlannerInfo *root,			/* in */
 	}
 	*p_havingQual = havingQual;
 
+	/*
+	 * Arguments of DISTINCT aggregates are added to the grouping-keys of
+	 * the target_partial and target_device, with sortgroupref which is not
+	 * used in the query.
+	 */
+	if (con.distinct_keys != NIL)
+	{
+		Index	max_sortgroupref = 0;
+
+		foreach (lc, parse->targetList)
+		{
+			TargetEntry *tle = lfirst(lc);
+
+			max_sortgroupref = Max(max_sortgroupref, tle->ressortgroupref);
+		}
+
+		foreach (lc, con.distinct_keys)
+		{
+			Expr	   *expr = lfirst(lc);
+			ListCell   *cell;
+
+			if (!pgstrom_device_expression(root, expr))
+				*p_can_pullup_outerscan = false;
+
+			j = 0;
+			foreach (cell, target_device->exprs)
+			{
+				if (equal(expr, lfirst(cell)))
+					break;
+				j++;
+			}
+			if (!cell)
+				elog(ERROR, "Bug? DISTINCT key is not found on input tlist");
+			/* already a grouping-key? */
+			if (target_device->sortgrouprefs[j] != 0)
+				continue;
+			target_device->sortgrouprefs[j] = ++max_sortgroupref;
+			add_grouping_key_to_partial_target(target_partial, expr,
+											   max_sortgroupref);
+		}
+	}
+	*p_distinct_keys = con.distinct_keys;
+
 	set_pathtarget_cost_width(root, target_final);
 	set_pathtarget_cost_width(root, target_partial);
 	set_pathtarget_cost_width(root, target_device);
@@ -3081,6 +3504,9 @@ gpupreagg_codegen_projection_row(StringInfo kern,
 	StringInfoData	temp;
 	Relation		outer_rel = NULL;
 	TupleDesc		outer_desc = NULL;
+	Expr		  **proj_exprs;
+	const char	  **proj_nulls;
+	List		   *cse_exprs = NIL;
 	ListCell	   *lc;
 	int				i, k, nattrs;
 
@@ -3276,16 +3702,14 @@ gpupreagg_codegen_projection_row(StringInfo kern,
 	}
 
 	/*
-	 * Execute expression and store the value on dst_values/dst_isnull
+	 * Pick up the expressions to be executed; grouping-keys and arguments
+	 * of the partial aggregate functions often share sub-expressions.
 	 */
-	resetStringInfo(&temp);
+	proj_exprs = palloc0(sizeof(Expr *) * list_length(tlist_alt));
+	proj_nulls = palloc0(sizeof(const char *) * list_length(tlist_alt));
 	foreach (lc, tlist_alt)
 	{
 		TargetEntry	   *tle = lfirst(lc);
-		Expr		   *expr;
-		devtype_info   *dtype;
-		const char	   *null_const_value = NULL;
-		const char	   *projection_label = NULL;
 
 		if (tle->resjunk)
 			continue;
@@ -3295,20 +3719,41 @@ gpupreagg_codegen_projection_row(StringInfo kern,
 		{
 			FuncExpr   *f = (FuncExpr *) tle->expr;
 
-			expr = codegen_projection_partial_funcion(f,
-													  context,
-													  &null_const_value);
-			projection_label = "aggfunc-arg";
+			proj_exprs[tle->resno - 1] =
+				codegen_projection_partial_funcion(f,
+												   context,
+												   &proj_nulls[tle->resno - 1]);
 		}
 		else if (tle->ressortgroupref)
 		{
-			expr = tle->expr;
-			null_const_value = "0";
-			projection_label = "grouping-key";
+			proj_exprs[tle->resno - 1] = tle->expr;
+			proj_nulls[tle->resno - 1] = "0";
 		}
 		else
 			elog(ERROR, "Bug? unexpected expression: %s",
                  nodeToString(tle->expr));
+		cse_exprs = lappend(cse_exprs, proj_exprs[tle->resno - 1]);
+	}
+	pgstrom_codegen_cse_setup(context, cse_exprs);
+
+	/*
+	 * Execute expression and store the value on dst_values/dst_isnull
+	 */
+	resetStringInfo(&temp);
+	foreach (lc, tlist_alt)
+	{
+		TargetEntry	   *tle = lfirst(lc);
+		Expr		   *expr = proj_exprs[tle->resno - 1];
+		devtype_info   *dtype;
+		const char	   *null_const_value = proj_nulls[tle->resno - 1];
+		const char	   *projection_label;
+
+		if (!expr)
+			continue;
+		if (is_altfunc_expression((Node *)tle->expr))
+			projection_label = "aggfunc-arg";
+		else
+			projection_label = "grouping-key";
 
 		dtype = pgstrom_devtype_lookup_and_track(exprType((Node *)expr),
 												 context);
@@ -3368,8 +3813,10 @@ gpupreagg_codegen_projection_row(StringInfo kern,
 	appendStringInfoString(&sbody, temp.data);
 	appendStringInfoString(&cbody, temp.data);
 
-	/* const/params */
+	/* const/params and common sub-expressions */
 	pgstrom_codegen_param_declarations(&decl, context);
+	pgstrom_codegen_cse_declarations(&decl, context);
+	pgstrom_codegen_cse_setup(context, NIL);
 
 	/* writeout kernel functions */
 	appendStringInfo(
@@ -3425,6 +3872,9 @@ gpupreagg_codegen_projection_row(StringInfo kern,
 	pfree(sbody.data);
 	pfree(cbody.data);
 	pfree(temp.data);
+	pfree(proj_exprs);
+	pfree(proj_nulls);
+	list_free(cse_exprs);
 }
 
 /*
@@ -4065,6 +4515,7 @@ ExecInitGpuPreAgg(CustomScanState *node, EState *estate, int eflags)
 	StringInfoData	kern_define;
 	ProgramId		program_id;
 	size_t			length;
+	double			num_groups;
 	bool			explain_only = ((eflags & EXEC_FLAG_EXPLAIN_ONLY) != 0);
 	bool			has_oid;
 
@@ -4086,6 +4537,9 @@ ExecInitGpuPreAgg(CustomScanState *node, EState *estate, int eflags)
 	gpas->gts.cb_next_tuple      = gpupreagg_next_tuple;
 	gpas->gts.cb_process_task    = gpupreagg_process_task;
 	gpas->gts.cb_release_task    = gpupreagg_release_task;
+	if (pgstrom_cpu_fallback_during_build ||
+		pgstrom_debug_force_cpu_fallback)
+		gpas->gts.cb_build_fallback = gpupreagg_build_fallback;
 	gpas->num_group_keys	= gpa_info->num_group_keys;
 
 	/* initialization of the outer relation */
@@ -4122,6 +4576,11 @@ ExecInitGpuPreAgg(CustomScanState *node, EState *estate, int eflags)
 		pgstromExecInitBrinIndexMap(&gpas->gts,
 									gpa_info->index_oid,
 									gpa_info->index_conds);
+		if (RelationIsArrowFdw(scan_rel))
+			gpas->gts.af_state = ExecInitArrowFdw(scan_rel,
+												  gpas->gts.outer_refs,
+												  gpa_info->outer_quals);
+		pgstromExecInitZoneMap(&gpas->gts, gpa_info->outer_quals);
 	}
 
 	/*
@@ -4167,6 +4626,15 @@ ExecInitGpuPreAgg(CustomScanState *node, EState *estate, int eflags)
     gpas->plan_nrows_in		= gpa_info->outer_nrows;
 	gpas->plan_ngroups		= gpa_info->plan_ngroups;
 	gpas->plan_extra_sz		= gpa_info->plan_extra_sz;
+	gpas->plan_ngroups_est	= gpa_info->plan_ngroups_est;
+	gpas->plan_fingerprint	= gpa_info->plan_fingerprint;
+	gpas->plan_feedback_key	= gpa_info->plan_feedback_key;
+	/* final buffer follows the latest feedback, if larger than the plan */
+	if (gpupreagg_feedback_lookup(gpas->plan_fingerprint,
+								  gpas->plan_feedback_key,
+								  &num_groups) &&
+		num_groups > (double)gpas->plan_ngroups)
+		gpas->plan_ngroups = (size_t)num_groups;
 
 	/* Get CUDA program and async build if any */
 	if (gpas->combined_gpujoin)
@@ -4252,6 +4720,8 @@ ExecEndGpuPreAgg(CustomScanState *node)
 	/* clean up subtree, if any */
 	if (outerPlanState(node))
 		ExecEndNode(outerPlanState(node));
+	/* feedback of the actual number of groups */
+	gpupreagg_feedback_record(gpas);
 
 	/* release final buffer / hashslot */
 	if (gpas->pds_final)
@@ -5049,7 +5519,10 @@ gpupreaggUpdateRunTimeStat(GpuTaskState *gts, kern_gpupreagg *kgpreagg)
 							(int64)kgpreagg->nitems_real);
 	pg_atomic_add_fetch_u64(&gpa_rtstat->nitems_filtered,
 							(int64)kgpreagg->nitems_filtered);
-	//TODO: other statistics
+	pg_atomic_add_fetch_u64(&gpa_rtstat->num_groups,
+							(int64)kgpreagg->num_groups);
+	pg_atomic_add_fetch_u64(&gpa_rtstat->fhash_conflicts,
+							(int64)kgpreagg->fhash_conflicts);
 }
 
 /*
@@ -5805,6 +6278,31 @@ out_of_resource:
 	return retval;
 }
 
+/*
+ * gpupreagg_build_fallback
+ *
+ * It makes the GpuPreAggTask processed by the CPU fallback code, because
+ * GPU program is not built yet. The CPU fallback returns the rows of the
+ * initial projection without partial aggregation, like CpuReCheck on the
+ * setup kernel. Combined RIGHT OUTER JOIN task has no outer chunk, so it
+ * waits for the program build. The terminator task never comes here.
+ */
+static bool
+gpupreagg_build_fallback(GpuTask *gtask)
+{
+	GpuPreAggTask  *gpreagg = (GpuPreAggTask *) gtask;
+	pgstrom_data_store *pds_src = gpreagg->pds_src;
+
+	if (!pds_src)
+		return false;
+	/* NVMe-Strom mode may not load the blocks onto the host memory yet */
+	if (pds_src->kds.format == KDS_FORMAT_BLOCK)
+		PDS_fillup_blocks(pds_src);
+	gpreagg->task.cpu_fallback = true;
+
+	return true;
+}
+
 /*
  * gpupreagg_process_task
  */
@@ -5838,6 +6336,134 @@ gpupreagg_release_task(GpuTask *gtask)
 	gpuMemFree(gcontext, (CUdeviceptr)gpreagg);
 }
 
+/*
+ * pgstrom_gpupreagg_feedback_info
+ */
+Datum
+pgstrom_gpupreagg_feedback_info(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *fncxt;
+	gpreaggFeedbackEntry *entry;
+	List	   *results;
+	HeapTuple	tuple;
+	Datum		values[8];
+	bool		isnull[8];
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		gpreaggFeedbackHead *head = gpupreagg_feedback_head;
+		TupleDesc	tupdesc;
+		MemoryContext oldcxt;
+		dlist_iter	iter;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(8, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "database_id",
+						   OIDOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "fingerprint",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "estimated_ngroups",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "actual_ngroups",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "fhash_conflicts",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 6, "nitems_in",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 7, "nexecs",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 8, "last_update",
+						   TIMESTAMPTZOID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+
+		results = NIL;
+		if (head)
+		{
+			SpinLockAcquire(&head->lock);
+			dlist_foreach(iter, &head->lru_list)
+			{
+				gpreaggFeedbackEntry *temp
+					= dlist_container(gpreaggFeedbackEntry,
+									  lru_chain, iter.cur);
+
+				/* entries of other databases are not visible */
+				if (temp->database_oid != MyDatabaseId)
+					continue;
+				entry = palloc(sizeof(gpreaggFeedbackEntry));
+				memcpy(entry, temp, sizeof(gpreaggFeedbackEntry));
+				results = lappend(results, entry);
+			}
+			SpinLockRelease(&head->lock);
+		}
+		fncxt->user_fctx = results;
+		MemoryContextSwitchTo(oldcxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+	results = fncxt->user_fctx;
+
+	if (fncxt->call_cntr >= list_length(results))
+		SRF_RETURN_DONE(fncxt);
+	entry = list_nth(results, fncxt->call_cntr);
+
+	memset(isnull, 0, sizeof(isnull));
+	values[0] = ObjectIdGetDatum(entry->database_oid);
+	values[1] = Int64GetDatum((int64) entry->fingerprint);
+	values[2] = Float8GetDatum(entry->est_ngroups);
+	values[3] = Int64GetDatum(entry->num_groups);
+	values[4] = Int64GetDatum(entry->fhash_conflicts);
+	values[5] = Int64GetDatum(entry->nitems_in);
+	values[6] = Int64GetDatum(entry->nexecs);
+	values[7] = TimestampTzGetDatum(entry->last_update);
+	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+
+	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+}
+PG_FUNCTION_INFO_V1(pgstrom_gpupreagg_feedback_info);
+
+/*
+ * pgstrom_startup_gpupreagg
+ */
+static void
+pgstrom_startup_gpupreagg(void)
+{
+	gpreaggFeedbackEntry *entry;
+	size_t		required;
+	bool		found;
+	int			i;
+
+	if (shmem_startup_next)
+		(*shmem_startup_next)();
+	if (gpupreagg_feedback_num_entries == 0)
+		return;
+
+	required = MAXALIGN(offsetof(gpreaggFeedbackHead,
+								 slots[gpupreagg_feedback_num_slots])) +
+		MAXALIGN(sizeof(gpreaggFeedbackEntry) *
+				 gpupreagg_feedback_num_entries);
+	gpupreagg_feedback_head = ShmemInitStruct("GpuPreAgg Feedback Segment",
+											  required, &found);
+	if (found)
+		elog(ERROR, "Bug? GpuPreAgg Feedback Segment is already built");
+	memset(gpupreagg_feedback_head, 0, required);
+	SpinLockInit(&gpupreagg_feedback_head->lock);
+	dlist_init(&gpupreagg_feedback_head->lru_list);
+	dlist_init(&gpupreagg_feedback_head->free_list);
+	for (i=0; i < gpupreagg_feedback_num_slots; i++)
+		dlist_init(&gpupreagg_feedback_head->slots[i]);
+	entry = (gpreaggFeedbackEntry *)
+		((char *)gpupreagg_feedback_head +
+		 MAXALIGN(offsetof(gpreaggFeedbackHead,
+						   slots[gpupreagg_feedback_num_slots])));
+	for (i=0; i < gpupreagg_feedback_num_entries; i++)
+	{
+		dlist_push_tail(&gpupreagg_feedback_head->free_list,
+						&entry->hash_chain);
+		entry++;
+	}
+}
+
 /*
  * entrypoint of GpuPreAgg
  */
@@ -5886,6 +6512,37 @@ pgstrom_init_gpupreagg(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* pg_strom.enable_gpupreagg_feedback */
+	DefineCustomBoolVariable("pg_strom.enable_gpupreagg_feedback",
+							 "Enables feedback of the actual number of groups to GpuPreAgg",
+							 NULL,
+							 &enable_gpupreagg_feedback,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.gpupreagg_feedback_num_entries */
+	DefineCustomIntVariable("pg_strom.gpupreagg_feedback_num_entries",
+							"Number of GpuPreAgg feedback entries on shared memory",
+							NULL,
+							&gpupreagg_feedback_num_entries,
+							4096,
+							0,
+							INT_MAX / sizeof(gpreaggFeedbackEntry),
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	gpupreagg_feedback_num_slots = Max(gpupreagg_feedback_num_entries / 4,
+									   64);
+	/* request for static shared memory */
+	if (gpupreagg_feedback_num_entries > 0)
+		RequestAddinShmemSpace(MAXALIGN(offsetof(gpreaggFeedbackHead,
+										slots[gpupreagg_feedback_num_slots])) +
+							   MAXALIGN(sizeof(gpreaggFeedbackEntry) *
+										gpupreagg_feedback_num_entries));
+	shmem_startup_next = shmem_startup_hook;
+	shmem_startup_hook = pgstrom_startup_gpupreagg;
+
 	/* initialization of path method table */
 	memset(&gpupreagg_path_methods, 0, sizeof(CustomPathMethods));
 	gpupreagg_path_methods.CustomName          = "GpuPreAgg";
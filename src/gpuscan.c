@@ -25,6 +25,7 @@ static CustomScanMethods	gpuscan_plan_methods;
 static CustomExecMethods	gpuscan_exec_methods;
 static bool					enable_gpuscan;
 static bool					enable_pullup_outer_scan;
+static bool					enable_vectorized_fallback;
 
 /*
  * form/deform interface of private field of CustomScan(GpuScan)
@@ -97,6 +98,8 @@ deform_gpuscan_info(CustomScan *cscan)
 
 typedef struct {
 	GpuTaskRuntimeStat	c;		/* common statistics */
+	pg_atomic_uint64	fallback_vectorized; /* # of rows processed by
+											  * vectorized CPU fallback */
 } GpuScanRuntimeStat;
 
 typedef struct {
@@ -105,6 +108,39 @@ typedef struct {
 	GpuScanRuntimeStat gs_rtstat;
 } GpuScanSharedState;
 
+/*
+ * gpuscanVecQual - a simple device qualifier in the form of (Var OP Const)
+ * or (Var = ANY(large constant array)) on the fixed-length data types,
+ * which can be evaluated on the column vectors deformed from the entire
+ * PDS when CPU fallback happen.
+ */
+#define GSVEC_TYPE__INT2		1
+#define GSVEC_TYPE__INT4		2
+#define GSVEC_TYPE__INT8		3
+#define GSVEC_TYPE__FLOAT4		4
+#define GSVEC_TYPE__FLOAT8		5
+
+#define GSVEC_OP__EQ			1
+#define GSVEC_OP__NE			2
+#define GSVEC_OP__LT			3
+#define GSVEC_OP__LE			4
+#define GSVEC_OP__GT			5
+#define GSVEC_OP__GE			6
+#define GSVEC_OP__IN			7
+
+typedef struct {
+	AttrNumber	attnum;		/* attribute number of the Var */
+	cl_int		vtype;		/* one of GSVEC_TYPE__* */
+	cl_int		vop;		/* one of GSVEC_OP__* */
+	Datum		value;		/* value of the Const */
+	kern_hashset *hset;		/* hash-set of the array, if GSVEC_OP__IN */
+} gpuscanVecQual;
+
+typedef struct {
+	cl_uint		index;		/* copy of gts->curr_index */
+	cl_uint		lp_index;	/* copy of gts->curr_lp_index */
+} gpuscanVecPos;
+
 typedef struct {
 	GpuTaskState	gts;
 	GpuScanSharedState *gs_sstate;
@@ -123,6 +159,24 @@ typedef struct {
 	cl_uint			fallback_local_id;
 	TupleTableSlot *base_slot;
 	ProjectionInfo *base_proj;
+	/* resource for vectorized CPU fallback */
+	List		   *vec_quals;		/* list of gpuscanVecQual */
+	List		   *vec_attnums;	/* attnums to be deformed (unique) */
+	bool			vec_virtual;	/* true, if rows are built from vectors */
+#if PG_VERSION_NUM < 100000
+	List		   *vec_rest_quals;	/* dev_quals not in @vec_quals */
+#else
+	ExprState	   *vec_rest_quals;	/* dev_quals not in @vec_quals */
+#endif
+	AttrNumber		vec_maxattno;	/* max attnum referenced by @vec_quals */
+	Datum		  **vec_values;		/* column vector of values (by attnum) */
+	bool		  **vec_isnull;		/* column vector of nulls (by attnum) */
+	gpuscanVecPos  *vec_pos;		/* position of the rows in PDS */
+	cl_uint		   *vec_selection;	/* selection vector */
+	cl_uint			vec_nrooms;		/* capacity of the vectors above */
+	cl_uint			vec_nselected;	/* # of rows in the selection vector */
+	cl_uint			vec_index;		/* current index of selection vector */
+	bool			vec_ready;		/* true, if vectors are built */
 } GpuScanState;
 
 typedef struct
@@ -143,7 +197,10 @@ static GpuTask  *gpuscan_next_task(GpuTaskState *gts);
 static TupleTableSlot *gpuscan_next_tuple(GpuTaskState *gts);
 static void gpuscan_switch_task(GpuTaskState *gts, GpuTask *gtask);
 static int gpuscan_process_task(GpuTask *gtask, CUmodule cuda_module);
+static bool gpuscan_build_fallback(GpuTask *gtask);
 static void gpuscan_release_task(GpuTask *gtask);
+static void gpuscan_setup_vectorized_fallback(GpuScanState *gss,
+											  List *dev_quals_raw);
 
 static void createGpuScanSharedState(GpuScanState *gss,
 									 ParallelContext *pcxt,
@@ -154,11 +211,12 @@ static void resetGpuScanSharedState(GpuScanState *gss);
  * cost_for_dma_receive - cost estimation for DMA receive (GPU->host)
  */
 Cost
-cost_for_dma_receive(RelOptInfo *rel, double ntuples)
+cost_for_dma_receive(PlannerInfo *root, RelOptInfo *rel, double ntuples)
 {
 	PathTarget *reltarget = rel->reltarget;
 	cl_int		nattrs = list_length(reltarget->exprs);
 	cl_int		width_per_tuple;
+	pgstromCostFactors cf;
 
 	if (ntuples < 0.0)
 		ntuples = rel->rows;
@@ -166,7 +224,8 @@ cost_for_dma_receive(RelOptInfo *rel, double ntuples)
 		MAXALIGN(offsetof(HeapTupleHeaderData,
 						  t_bits[BITMAPLEN(nattrs)])) +
 		MAXALIGN(reltarget->width);
-	return pgstrom_gpu_dma_cost *
+	pgstrom_get_cost_factors(root, rel, &cf);
+	return cf.gpu_dma_cost *
 		(((double)width_per_tuple * ntuples) / (double)pgstrom_chunk_size());
 }
 
@@ -238,7 +297,7 @@ create_gpuscan_path(PlannerInfo *root,
 						: baserel->rows) / parallel_divisor;
 
 	/* cost for DMA receive (GPU-->host) */
-	run_cost += cost_for_dma_receive(baserel, scan_ntuples);
+	run_cost += cost_for_dma_receive(root, baserel, scan_ntuples);
 
 	/* cost for CPU qualifiers */
 	cost_qual_eval(&qcost, host_quals, root);
@@ -320,7 +379,9 @@ gpuscan_add_scan_path(PlannerInfo *root,
 	if (rte->rtekind != RTE_RELATION)
 		return;
 	if (rte->relkind != RELKIND_RELATION &&
-		rte->relkind != RELKIND_MATVIEW)
+		rte->relkind != RELKIND_MATVIEW &&
+		!(rte->relkind == RELKIND_FOREIGN_TABLE &&
+		  baseRelIsArrowFdw(baserel)))
 		return;
 
 	/* Check whether the qualifier can run on GPU device */
@@ -353,8 +414,12 @@ gpuscan_add_scan_path(PlannerInfo *root,
 								   indexNBlocks);
 	add_path(baserel, pathnode);
 
-	/* If appropriate, consider parallel GpuScan */
-	if (baserel->consider_parallel && baserel->lateral_relids == NULL)
+	/*
+	 * If appropriate, consider parallel GpuScan. Arrow_fdw cannot distribute
+	 * record batches over the workers right now.
+	 */
+	if (baserel->consider_parallel && baserel->lateral_relids == NULL &&
+		rte->relkind != RELKIND_FOREIGN_TABLE)
 	{
 		int		parallel_nworkers
 			= compute_parallel_worker(baserel,
@@ -482,10 +547,15 @@ codegen_gpuscan_quals(StringInfo kern, codegen_context *context,
 		goto output;
 	/* Let's walk on the device expression tree */
 	dev_quals = (Node *)make_flat_ands_explicit(dev_quals_list);
+	pgstrom_codegen_cse_setup(context, dev_quals_list);
 	expr_code = pgstrom_codegen_expression(dev_quals, context);
 	/* Const/Param declarations */
 	pgstrom_codegen_param_declarations(&cfunc, context);
 	pgstrom_codegen_param_declarations(&tfunc, context);
+	/* common sub-expressions */
+	pgstrom_codegen_cse_declarations(&cfunc, context);
+	pgstrom_codegen_cse_declarations(&tfunc, context);
+	pgstrom_codegen_cse_setup(context, NIL);
 	/* Sanity check of used_vars */
 	foreach (lc, context->used_vars)
 	{
@@ -646,6 +716,7 @@ codegen_gpuscan_projection(StringInfo kern, codegen_context *context,
 {
 	TupleDesc		tupdesc = RelationGetDescr(relation);
 	List		   *tlist_dev = NIL;
+	List		   *proj_exprs = NIL;
 	AttrNumber	   *varremaps;
 	Bitmapset	   *varattnos;
 	ListCell	   *lc;
@@ -935,6 +1006,14 @@ codegen_gpuscan_projection(StringInfo kern, codegen_context *context,
 	/*
 	 * step.3 - execute expression node, then store the result onto KVAR_xx
 	 */
+	foreach (lc, tlist_dev)
+	{
+		TargetEntry	   *tle = lfirst(lc);
+
+		if (!IsA(tle->expr, Var))
+			proj_exprs = lappend(proj_exprs, tle->expr);
+	}
+	pgstrom_codegen_cse_setup(context, proj_exprs);
     foreach (lc, tlist_dev)
     {
         TargetEntry    *tle = lfirst(lc);
@@ -1021,6 +1100,10 @@ codegen_gpuscan_projection(StringInfo kern, codegen_context *context,
 	/* parameter references */
 	pgstrom_codegen_param_declarations(&tdecl, context);
 	pgstrom_codegen_param_declarations(&cdecl, context);
+	/* common sub-expressions */
+	pgstrom_codegen_cse_declarations(&tdecl, context);
+	pgstrom_codegen_cse_declarations(&cdecl, context);
+	pgstrom_codegen_cse_setup(context, NIL);
 
 	/* OK, write back the kernel source */
 	appendStringInfo(
@@ -1031,6 +1114,7 @@ codegen_gpuscan_projection(StringInfo kern, codegen_context *context,
 		cdecl.data,
 		cbody.data);
 	list_free(tlist_dev);
+	list_free(proj_exprs);
 	pfree(temp.data);
 	pfree(tdecl.data);
 	pfree(cdecl.data);
@@ -1766,6 +1850,9 @@ ExecInitGpuScan(CustomScanState *node, EState *estate, int eflags)
 	gss->gts.cb_switch_task = gpuscan_switch_task;
 	gss->gts.cb_process_task = gpuscan_process_task;
 	gss->gts.cb_release_task = gpuscan_release_task;
+	if (pgstrom_cpu_fallback_during_build ||
+		pgstrom_debug_force_cpu_fallback)
+		gss->gts.cb_build_fallback = gpuscan_build_fallback;
 
 	/*
 	 * initialize device qualifiers/projection stuff, for CPU fallback
@@ -1782,6 +1869,7 @@ ExecInitGpuScan(CustomScanState *node, EState *estate, int eflags)
 #else
 	gss->dev_quals = ExecInitQual(dev_quals_raw, &gss->gts.css.ss.ps);
 #endif
+	gpuscan_setup_vectorized_fallback(gss, dev_quals_raw);
 
 	foreach (lc, cscan->custom_scan_tlist)
 	{
@@ -1826,6 +1914,13 @@ ExecInitGpuScan(CustomScanState *node, EState *estate, int eflags)
 	pgstromExecInitBrinIndexMap(&gss->gts,
 								gs_info->index_oid,
 								gs_info->index_conds);
+	/* init Arrow_fdw support, if any */
+	if (RelationIsArrowFdw(scan_rel))
+		gss->gts.af_state = ExecInitArrowFdw(scan_rel,
+											 gss->gts.outer_refs,
+											 dev_quals_raw);
+	/* init zone map support, if any */
+	pgstromExecInitZoneMap(&gss->gts, dev_quals_raw);
 
 	/* Get CUDA program and async build if any */
 	initStringInfo(&kern_define);
@@ -2120,6 +2215,14 @@ ExplainGpuScan(CustomScanState *node, List *ancestors, ExplainState *es)
 								   gss->gts.outer_instrument.nfiltered1 /
 								   gss->gts.outer_instrument.nloops, es);
 	}
+	/* Number of rows processed by vectorized CPU fallback, if any */
+	if (es->analyze && gs_rtstat)
+	{
+		uint64		nrows = pg_atomic_read_u64(&gs_rtstat->fallback_vectorized);
+
+		if (nrows > 0)
+			ExplainPropertyInteger("CPU Fallback Vectorized", NULL, nrows, es);
+	}
 	/* BRIN-index properties */
 	pgstromExplainBrinIndexMap(&gss->gts, es, dcontext);
 	/* common portion of EXPLAIN */
@@ -2150,6 +2253,7 @@ createGpuScanSharedState(GpuScanState *gss,
 
 	gs_rtstat = &gs_sstate->gs_rtstat;
 	SpinLockInit(&gs_rtstat->c.lock);
+	pg_atomic_init_u64(&gs_rtstat->fallback_vectorized, 0);
 #if PG_VERSION_NUM < 100000
 	/*
 	 * MEMO: PG9.6 does not support ShutdownCustomScan() callback, so we have
@@ -2162,6 +2266,7 @@ createGpuScanSharedState(GpuScanState *gss,
 		gs_rtstat = MemoryContextAllocZero(estate->es_query_cxt,
 										   sizeof(GpuScanRuntimeStat));
 		SpinLockInit(&gs_rtstat->c.lock);
+		pg_atomic_init_u64(&gs_rtstat->fallback_vectorized, 0);
 	}
 #endif
 	gss->gs_sstate = gs_sstate;
@@ -2265,6 +2370,7 @@ gpuscan_switch_task(GpuTaskState *gts, GpuTask *gtask)
 
 	gss->fallback_group_id = 0;
 	gss->fallback_local_id = 0;
+	gss->vec_ready = false;
 }
 
 /*
@@ -2427,6 +2533,592 @@ gpuscan_next_tuple_suspended_block(GpuScanState *gss, GpuScanTask *gscan)
 	return false;
 }
 
+/*
+ * gpuscan_setup_vectorized_fallback
+ *
+ * It picks up device qualifiers in the form of (Var OP Const) on the simple
+ * fixed-length data types, to evaluate them on the column vectors when
+ * CPU fallback happen. The rest of qualifiers are evaluated per row using
+ * the ExecQual() as usual.
+ * If no system columns are referenced, all the referenced columns are also
+ * deformed to the vectors, then the rows on the selection vector are built
+ * as virtual tuples without deforming them again.
+ */
+static struct {
+	Oid			func_oid;
+	cl_int		vtype;
+	cl_int		vop;
+} gpuscan_vecqual_catalog[] = {
+	{ F_INT2EQ,   GSVEC_TYPE__INT2,   GSVEC_OP__EQ },
+	{ F_INT2NE,   GSVEC_TYPE__INT2,   GSVEC_OP__NE },
+	{ F_INT2LT,   GSVEC_TYPE__INT2,   GSVEC_OP__LT },
+	{ F_INT2LE,   GSVEC_TYPE__INT2,   GSVEC_OP__LE },
+	{ F_INT2GT,   GSVEC_TYPE__INT2,   GSVEC_OP__GT },
+	{ F_INT2GE,   GSVEC_TYPE__INT2,   GSVEC_OP__GE },
+	{ F_INT4EQ,   GSVEC_TYPE__INT4,   GSVEC_OP__EQ },
+	{ F_INT4NE,   GSVEC_TYPE__INT4,   GSVEC_OP__NE },
+	{ F_INT4LT,   GSVEC_TYPE__INT4,   GSVEC_OP__LT },
+	{ F_INT4LE,   GSVEC_TYPE__INT4,   GSVEC_OP__LE },
+	{ F_INT4GT,   GSVEC_TYPE__INT4,   GSVEC_OP__GT },
+	{ F_INT4GE,   GSVEC_TYPE__INT4,   GSVEC_OP__GE },
+	{ F_INT8EQ,   GSVEC_TYPE__INT8,   GSVEC_OP__EQ },
+	{ F_INT8NE,   GSVEC_TYPE__INT8,   GSVEC_OP__NE },
+	{ F_INT8LT,   GSVEC_TYPE__INT8,   GSVEC_OP__LT },
+	{ F_INT8LE,   GSVEC_TYPE__INT8,   GSVEC_OP__LE },
+	{ F_INT8GT,   GSVEC_TYPE__INT8,   GSVEC_OP__GT },
+	{ F_INT8GE,   GSVEC_TYPE__INT8,   GSVEC_OP__GE },
+	{ F_FLOAT4EQ, GSVEC_TYPE__FLOAT4, GSVEC_OP__EQ },
+	{ F_FLOAT4NE, GSVEC_TYPE__FLOAT4, GSVEC_OP__NE },
+	{ F_FLOAT4LT, GSVEC_TYPE__FLOAT4, GSVEC_OP__LT },
+	{ F_FLOAT4LE, GSVEC_TYPE__FLOAT4, GSVEC_OP__LE },
+	{ F_FLOAT4GT, GSVEC_TYPE__FLOAT4, GSVEC_OP__GT },
+	{ F_FLOAT4GE, GSVEC_TYPE__FLOAT4, GSVEC_OP__GE },
+	{ F_FLOAT8EQ, GSVEC_TYPE__FLOAT8, GSVEC_OP__EQ },
+	{ F_FLOAT8NE, GSVEC_TYPE__FLOAT8, GSVEC_OP__NE },
+	{ F_FLOAT8LT, GSVEC_TYPE__FLOAT8, GSVEC_OP__LT },
+	{ F_FLOAT8LE, GSVEC_TYPE__FLOAT8, GSVEC_OP__LE },
+	{ F_FLOAT8GT, GSVEC_TYPE__FLOAT8, GSVEC_OP__GT },
+	{ F_FLOAT8GE, GSVEC_TYPE__FLOAT8, GSVEC_OP__GE },
+	/* DateADT is internally int32 */
+	{ F_DATE_EQ,  GSVEC_TYPE__INT4,   GSVEC_OP__EQ },
+	{ F_DATE_NE,  GSVEC_TYPE__INT4,   GSVEC_OP__NE },
+	{ F_DATE_LT,  GSVEC_TYPE__INT4,   GSVEC_OP__LT },
+	{ F_DATE_LE,  GSVEC_TYPE__INT4,   GSVEC_OP__LE },
+	{ F_DATE_GT,  GSVEC_TYPE__INT4,   GSVEC_OP__GT },
+	{ F_DATE_GE,  GSVEC_TYPE__INT4,   GSVEC_OP__GE },
+	{ InvalidOid, -1, -1 },
+};
+
+static gpuscanVecQual *
+gpuscan_vectorizable_qual(Node *clause, Index scanrelid)
+{
+	OpExpr	   *op = (OpExpr *) clause;
+	Node	   *larg;
+	Node	   *rarg;
+	Var		   *var;
+	Const	   *con;
+	bool		commuted = false;
+	gpuscanVecQual *vqual;
+	int			i;
+
+	/* (Var = ANY(large constant array)) shall be probed by the hash-set */
+	if (IsA(clause, ScalarArrayOpExpr))
+	{
+		ScalarArrayOpExpr *saop = (ScalarArrayOpExpr *) clause;
+		kern_hashset *hset;
+		int16		typlen;
+
+		var = linitial(saop->args);
+		if (!IsA(var, Var) ||
+			var->varno != scanrelid ||
+			var->varlevelsup != 0 ||
+			var->varattno <= 0)
+			return NULL;
+		hset = pgstrom_scalar_array_hashset(saop);
+		if (!hset)
+			return NULL;
+
+		vqual = palloc0(sizeof(gpuscanVecQual));
+		vqual->attnum = var->varattno;
+		typlen = get_typlen(var->vartype);
+		if (typlen == sizeof(cl_short))
+			vqual->vtype = GSVEC_TYPE__INT2;
+		else if (typlen == sizeof(cl_int))
+			vqual->vtype = GSVEC_TYPE__INT4;
+		else
+			vqual->vtype = GSVEC_TYPE__INT8;
+		vqual->vop = GSVEC_OP__IN;
+		vqual->hset = hset;
+		return vqual;
+	}
+
+	if (!IsA(op, OpExpr) || list_length(op->args) != 2)
+		return NULL;
+	larg = linitial(op->args);
+	rarg = lsecond(op->args);
+	if (IsA(larg, Var) && IsA(rarg, Const))
+	{
+		var = (Var *) larg;
+		con = (Const *) rarg;
+	}
+	else if (IsA(larg, Const) && IsA(rarg, Var))
+	{
+		var = (Var *) rarg;
+		con = (Const *) larg;
+		commuted = true;
+	}
+	else
+		return NULL;
+
+	if (var->varno != scanrelid ||
+		var->varlevelsup != 0 ||
+		var->varattno <= 0 ||
+		var->vartype != con->consttype ||
+		con->constisnull)
+		return NULL;
+
+	set_opfuncid(op);
+	for (i=0; OidIsValid(gpuscan_vecqual_catalog[i].func_oid); i++)
+	{
+		if (gpuscan_vecqual_catalog[i].func_oid != op->opfuncid)
+			continue;
+
+		vqual = palloc0(sizeof(gpuscanVecQual));
+		vqual->attnum = var->varattno;
+		vqual->vtype = gpuscan_vecqual_catalog[i].vtype;
+		vqual->vop = gpuscan_vecqual_catalog[i].vop;
+		vqual->value = con->constvalue;
+		if (commuted)
+		{
+			/* (Const OP Var) is equivalent to (Var commutator(OP) Const) */
+			if (vqual->vop == GSVEC_OP__LT)
+				vqual->vop = GSVEC_OP__GT;
+			else if (vqual->vop == GSVEC_OP__LE)
+				vqual->vop = GSVEC_OP__GE;
+			else if (vqual->vop == GSVEC_OP__GT)
+				vqual->vop = GSVEC_OP__LT;
+			else if (vqual->vop == GSVEC_OP__GE)
+				vqual->vop = GSVEC_OP__LE;
+		}
+		return vqual;
+	}
+	return NULL;
+}
+
+static void
+gpuscan_setup_vectorized_fallback(GpuScanState *gss, List *dev_quals_raw)
+{
+	CustomScan *cscan = (CustomScan *) gss->gts.css.ss.ps.plan;
+	Index		scanrelid = cscan->scan.scanrelid;
+	List	   *vec_quals = NIL;
+	List	   *vec_attnums = NIL;
+	List	   *rest_quals = NIL;
+	List	   *ref_attnums = NIL;
+	AttrNumber	maxattno = 0;
+	bool		vec_virtual = true;
+	ListCell   *lc;
+	int			k;
+
+	foreach (lc, dev_quals_raw)
+	{
+		Node	   *clause = lfirst(lc);
+		gpuscanVecQual *vqual = gpuscan_vectorizable_qual(clause, scanrelid);
+
+		if (!vqual)
+			rest_quals = lappend(rest_quals, clause);
+		else
+		{
+			vec_quals = lappend(vec_quals, vqual);
+			vec_attnums = list_append_unique_int(vec_attnums, vqual->attnum);
+			maxattno = Max(maxattno, vqual->attnum);
+		}
+	}
+
+	if (vec_quals == NIL)
+	{
+		/* no benefit to deform PDS into the column vectors */
+		gss->vec_quals = NIL;
+		gss->vec_rest_quals = NULL;
+		return;
+	}
+
+	/* referenced columns, to build virtual tuples from the vectors */
+	for (k = bms_next_member(gss->gts.outer_refs, -1);
+		 k >= 0;
+		 k = bms_next_member(gss->gts.outer_refs, k))
+	{
+		AttrNumber	anum = k + FirstLowInvalidHeapAttributeNumber;
+
+		if (anum <= 0)
+		{
+			vec_virtual = false;	/* system column is referenced */
+			break;
+		}
+		ref_attnums = lappend_int(ref_attnums, anum);
+	}
+	if (vec_virtual)
+	{
+		foreach (lc, ref_attnums)
+		{
+			vec_attnums = list_append_unique_int(vec_attnums, lfirst_int(lc));
+			maxattno = Max(maxattno, lfirst_int(lc));
+		}
+	}
+	list_free(ref_attnums);
+
+	gss->vec_quals = vec_quals;
+	gss->vec_attnums = vec_attnums;
+	gss->vec_virtual = vec_virtual;
+#if PG_VERSION_NUM < 100000
+	gss->vec_rest_quals = (List *)ExecInitExpr((Expr *)rest_quals,
+											   &gss->gts.css.ss.ps);
+#else
+	gss->vec_rest_quals = ExecInitQual(rest_quals, &gss->gts.css.ss.ps);
+#endif
+	gss->vec_maxattno = maxattno;
+	gss->vec_values = palloc0(sizeof(Datum *) * maxattno);
+	gss->vec_isnull = palloc0(sizeof(bool *) * maxattno);
+	gss->vec_pos = NULL;
+	gss->vec_selection = NULL;
+	gss->vec_nrooms = 0;
+	gss->vec_ready = false;
+}
+
+/*
+ * gpuscan_vectorized_expand - expand the column vectors
+ */
+static void
+gpuscan_vectorized_expand(GpuScanState *gss, cl_uint nrooms)
+{
+	MemoryContext	memcxt = gss->gts.css.ss.ps.state->es_query_cxt;
+	ListCell	   *lc;
+
+	nrooms = Max(nrooms, 2 * gss->vec_nrooms);
+	if (!gss->vec_pos)
+	{
+		gss->vec_pos = MemoryContextAllocHuge(memcxt, sizeof(gpuscanVecPos) *
+											  nrooms);
+		gss->vec_selection = MemoryContextAllocHuge(memcxt, sizeof(cl_uint) *
+													nrooms);
+	}
+	else
+	{
+		gss->vec_pos = repalloc_huge(gss->vec_pos, sizeof(gpuscanVecPos) *
+									 nrooms);
+		gss->vec_selection = repalloc_huge(gss->vec_selection,
+										   sizeof(cl_uint) * nrooms);
+	}
+
+	foreach (lc, gss->vec_attnums)
+	{
+		int			j = lfirst_int(lc) - 1;
+
+		if (!gss->vec_values[j])
+		{
+			gss->vec_values[j] = MemoryContextAllocHuge(memcxt,
+														sizeof(Datum) * nrooms);
+			gss->vec_isnull[j] = MemoryContextAllocHuge(memcxt,
+														sizeof(bool) * nrooms);
+		}
+		else
+		{
+			gss->vec_values[j] = repalloc_huge(gss->vec_values[j],
+											   sizeof(Datum) * nrooms);
+			gss->vec_isnull[j] = repalloc_huge(gss->vec_isnull[j],
+											   sizeof(bool) * nrooms);
+		}
+	}
+	gss->vec_nrooms = nrooms;
+}
+
+/*
+ * gpuscan_vectorized_filter_XXXX
+ *
+ * Type specialized loops to apply (Var OP Const) on the selection vector.
+ * They compact the selection vector without branches on the comparison
+ * result, so compiler can generate tight loops.
+ */
+#define GSVEC_CMP_INTEGER(a,b)						\
+	((a) < (b) ? -1 : ((a) > (b) ? 1 : 0))
+/* same as float[48]_cmp_internal; NaN is larger than any other values */
+#define GSVEC_CMP_FLOAT(a,b)						\
+	(isnan(a) ? (isnan(b) ? 0 : 1) :				\
+	 (isnan(b) ? -1 : GSVEC_CMP_INTEGER(a,b)))
+
+#define GSVEC_FILTER_LOOP(BASE,GETARG,CMP,COND)					\
+	for (i=0; i < nselected; i++)								\
+	{															\
+		cl_uint		k = selection[i];							\
+		BASE		x = GETARG(values[k]);						\
+																\
+		selection[j] = k;										\
+		j += (!isnull[k] && (CMP(x, arg) COND));				\
+	}
+
+#define GSVEC_FILTER_TEMPLATE(NAME,BASE,GETARG,CMP)					\
+	static cl_uint													\
+	gpuscan_vectorized_filter_##NAME(cl_uint *selection,			\
+									 cl_uint nselected,				\
+									 Datum *values,					\
+									 bool *isnull,					\
+									 cl_int vop, Datum cval)		\
+	{																\
+		BASE		arg = GETARG(cval);								\
+		cl_uint		i, j = 0;										\
+																	\
+		switch (vop)												\
+		{															\
+			case GSVEC_OP__EQ:										\
+				GSVEC_FILTER_LOOP(BASE,GETARG,CMP, == 0);			\
+				break;												\
+			case GSVEC_OP__NE:										\
+				GSVEC_FILTER_LOOP(BASE,GETARG,CMP, != 0);			\
+				break;												\
+			case GSVEC_OP__LT:										\
+				GSVEC_FILTER_LOOP(BASE,GETARG,CMP, < 0);			\
+				break;												\
+			case GSVEC_OP__LE:										\
+				GSVEC_FILTER_LOOP(BASE,GETARG,CMP, <= 0);			\
+				break;												\
+			case GSVEC_OP__GT:										\
+				GSVEC_FILTER_LOOP(BASE,GETARG,CMP, > 0);			\
+				break;												\
+			case GSVEC_OP__GE:										\
+				GSVEC_FILTER_LOOP(BASE,GETARG,CMP, >= 0);			\
+				break;												\
+			default:												\
+				elog(ERROR, "Bug? unexpected vectorized operator: %d", \
+					 vop);											\
+		}															\
+		return j;													\
+	}
+
+/*
+ * gpuscan_vectorized_filter_hashset
+ *
+ * It applies (Var = ANY(array)) on the selection vector by probe on the
+ * hash-set, which is identical to the one delivered to GPU device.
+ * Unlike the ExecQual(), NULL result is not distinguished from false, but
+ * it is harmless for the qualifiers.
+ */
+static cl_uint
+gpuscan_vectorized_filter_hashset(cl_uint *selection,
+								  cl_uint nselected,
+								  Datum *values,
+								  bool *isnull,
+								  cl_int vtype,
+								  kern_hashset *hset)
+{
+	cl_uint		i, j = 0;
+
+	for (i=0; i < nselected; i++)
+	{
+		cl_uint		k = selection[i];
+		cl_long		key;
+
+		if (isnull[k])
+			continue;
+		if (vtype == GSVEC_TYPE__INT2)
+			key = DatumGetInt16(values[k]);
+		else if (vtype == GSVEC_TYPE__INT4)
+			key = DatumGetInt32(values[k]);
+		else
+			key = DatumGetInt64(values[k]);
+		if (kern_hashset_lookup(hset, key))
+			selection[j++] = k;
+	}
+	return j;
+}
+
+GSVEC_FILTER_TEMPLATE(int2,   cl_short,  DatumGetInt16,  GSVEC_CMP_INTEGER)
+GSVEC_FILTER_TEMPLATE(int4,   cl_int,    DatumGetInt32,  GSVEC_CMP_INTEGER)
+GSVEC_FILTER_TEMPLATE(int8,   cl_long,   DatumGetInt64,  GSVEC_CMP_INTEGER)
+GSVEC_FILTER_TEMPLATE(float4, cl_float,  DatumGetFloat4, GSVEC_CMP_FLOAT)
+GSVEC_FILTER_TEMPLATE(float8, cl_double, DatumGetFloat8, GSVEC_CMP_FLOAT)
+
+/*
+ * gpuscan_vectorized_fallback_build
+ *
+ * It deforms the entire PDS (ROW, SLOT, BLOCK or COLUMN format) into the column
+ * vectors, then applies the vectorizable qualifiers on them to build up
+ * the selection vector.
+ */
+static void
+gpuscan_vectorized_fallback_build(GpuScanState *gss, GpuScanTask *gscan)
+{
+	pgstrom_data_store *pds_src = gscan->pds_src;
+	kern_data_store	   *kds = &pds_src->kds;
+	GpuScanRuntimeStat *gs_rtstat = gss->gs_rtstat;
+	TupleTableSlot	   *slot = gss->base_slot;
+	cl_uint				nitems = 0;
+	cl_uint				nselected;
+	ListCell		   *lc;
+
+	if (gss->vec_nrooms == 0)
+	{
+		cl_uint		nrooms = kds->nitems;
+
+		if (kds->format == KDS_FORMAT_BLOCK)
+			nrooms *= Max(kds->nrows_per_block, 1);
+		gpuscan_vectorized_expand(gss, Max(nrooms, 1024));
+	}
+
+	gss->gts.curr_index = 0;
+	gss->gts.curr_lp_index = 0;
+	for (;;)
+	{
+		gpuscanVecPos	pos;
+
+		pos.index = gss->gts.curr_index;
+		pos.lp_index = gss->gts.curr_lp_index;
+		ExecClearTuple(slot);
+		if (!PDS_fetch_tuple(slot, pds_src, &gss->gts))
+			break;
+		if (nitems >= gss->vec_nrooms)
+			gpuscan_vectorized_expand(gss, nitems + 1);
+		slot_getsomeattrs(slot, gss->vec_maxattno);
+		foreach (lc, gss->vec_attnums)
+		{
+			int			j = lfirst_int(lc) - 1;
+
+			gss->vec_values[j][nitems] = slot->tts_values[j];
+			gss->vec_isnull[j][nitems] = slot->tts_isnull[j];
+		}
+		gss->vec_pos[nitems] = pos;
+		gss->vec_selection[nitems] = nitems;
+		nitems++;
+	}
+	ExecClearTuple(slot);
+
+	/* apply the vectorizable qualifiers */
+	nselected = nitems;
+	foreach (lc, gss->vec_quals)
+	{
+		gpuscanVecQual *vqual = lfirst(lc);
+		int			j = vqual->attnum - 1;
+
+		if (nselected == 0)
+			break;
+		if (vqual->vop == GSVEC_OP__IN)
+		{
+			nselected = gpuscan_vectorized_filter_hashset(
+				gss->vec_selection, nselected,
+				gss->vec_values[j], gss->vec_isnull[j],
+				vqual->vtype, vqual->hset);
+			continue;
+		}
+		switch (vqual->vtype)
+		{
+			case GSVEC_TYPE__INT2:
+				nselected = gpuscan_vectorized_filter_int2(
+					gss->vec_selection, nselected,
+					gss->vec_values[j], gss->vec_isnull[j],
+					vqual->vop, vqual->value);
+				break;
+			case GSVEC_TYPE__INT4:
+				nselected = gpuscan_vectorized_filter_int4(
+					gss->vec_selection, nselected,
+					gss->vec_values[j], gss->vec_isnull[j],
+					vqual->vop, vqual->value);
+				break;
+			case GSVEC_TYPE__INT8:
+				nselected = gpuscan_vectorized_filter_int8(
+					gss->vec_selection, nselected,
+					gss->vec_values[j], gss->vec_isnull[j],
+					vqual->vop, vqual->value);
+				break;
+			case GSVEC_TYPE__FLOAT4:
+				nselected = gpuscan_vectorized_filter_float4(
+					gss->vec_selection, nselected,
+					gss->vec_values[j], gss->vec_isnull[j],
+					vqual->vop, vqual->value);
+				break;
+			case GSVEC_TYPE__FLOAT8:
+				nselected = gpuscan_vectorized_filter_float8(
+					gss->vec_selection, nselected,
+					gss->vec_values[j], gss->vec_isnull[j],
+					vqual->vop, vqual->value);
+				break;
+			default:
+				elog(ERROR, "Bug? unexpected vectorized type: %d",
+					 vqual->vtype);
+		}
+	}
+	pg_atomic_add_fetch_u64(&gs_rtstat->c.source_nitems, nitems);
+	pg_atomic_add_fetch_u64(&gs_rtstat->c.nitems_filtered, nitems - nselected);
+	pg_atomic_add_fetch_u64(&gs_rtstat->fallback_vectorized, nitems);
+
+	gss->vec_nselected = nselected;
+	gss->vec_index = 0;
+	gss->vec_ready = true;
+}
+
+/*
+ * gpuscan_next_tuple_fallback_vectorized
+ *
+ * It returns the rows on the selection vector, after the evaluation of
+ * the non-vectorizable qualifiers and projection, if any.
+ */
+static TupleTableSlot *
+gpuscan_next_tuple_fallback_vectorized(GpuScanState *gss, GpuScanTask *gscan)
+{
+	pgstrom_data_store *pds_src = gscan->pds_src;
+	GpuScanRuntimeStat *gs_rtstat = gss->gs_rtstat;
+	ExprContext		   *econtext = gss->gts.css.ss.ps.ps_ExprContext;
+	TupleTableSlot	   *slot = NULL;
+
+	if (!gss->vec_ready)
+		gpuscan_vectorized_fallback_build(gss, gscan);
+
+	while (gss->vec_index < gss->vec_nselected)
+	{
+		cl_uint		k = gss->vec_selection[gss->vec_index++];
+
+		ExecClearTuple(gss->base_slot);
+		if (gss->vec_virtual)
+		{
+			/* build a virtual tuple from the column vectors */
+			TupleTableSlot *base_slot = gss->base_slot;
+			ListCell   *lc;
+
+			memset(base_slot->tts_isnull, true,
+				   sizeof(bool) * base_slot->tts_tupleDescriptor->natts);
+			foreach (lc, gss->vec_attnums)
+			{
+				int		j = lfirst_int(lc) - 1;
+
+				base_slot->tts_values[j] = gss->vec_values[j][k];
+				base_slot->tts_isnull[j] = gss->vec_isnull[j][k];
+			}
+			ExecStoreVirtualTuple(base_slot);
+		}
+		else
+		{
+			/* fetch the row again from the position */
+			gss->gts.curr_index = gss->vec_pos[k].index;
+			gss->gts.curr_lp_index = gss->vec_pos[k].lp_index;
+			if (!PDS_fetch_tuple(gss->base_slot, pds_src, &gss->gts))
+				elog(ERROR, "Bug? row in the selection vector is missing");
+		}
+		ResetExprContext(econtext);
+		econtext->ecxt_scantuple = gss->base_slot;
+
+		if (gss->vec_rest_quals)
+		{
+			bool		retval;
+#if PG_VERSION_NUM < 100000
+			retval = ExecQual(gss->vec_rest_quals, econtext, false);
+#else
+			retval = ExecQual(gss->vec_rest_quals, econtext);
+#endif
+			if (!retval)
+			{
+				pg_atomic_add_fetch_u64(&gs_rtstat->c.nitems_filtered, 1);
+				continue;
+			}
+		}
+
+		if (!gss->base_proj)
+			slot = gss->base_slot;
+		else
+		{
+#if PG_VERSION_NUM < 100000
+			ExprDoneCond		is_done;
+
+			slot = ExecProject(gss->base_proj, &is_done);
+			if (is_done == ExprMultipleResult)
+				gss->gts.css.ss.ps.ps_TupFromTlist = true;
+			else if (is_done != ExprEndResult)
+				gss->gts.css.ss.ps.ps_TupFromTlist = false;
+#else
+			slot = ExecProject(gss->base_proj);
+#endif
+		}
+		return slot;
+	}
+	return NULL;
+}
+
 /*
  * gpuscan_next_tuple_fallback - GPU fallback case
  */
@@ -2439,6 +3131,16 @@ gpuscan_next_tuple_fallback(GpuScanState *gss, GpuScanTask *gscan)
 	TupleTableSlot	   *slot = NULL;
 	bool				status;
 
+	/* vectorized CPU fallback, if available */
+	if (enable_vectorized_fallback &&
+		gss->vec_quals != NIL &&
+		!gscan->kern.resume_context &&
+		(pds_src->kds.format == KDS_FORMAT_ROW ||
+		 pds_src->kds.format == KDS_FORMAT_SLOT ||
+		 pds_src->kds.format == KDS_FORMAT_BLOCK ||
+		 pds_src->kds.format == KDS_FORMAT_COLUMN))
+		return gpuscan_next_tuple_fallback_vectorized(gss, gscan);
+
 retry_next:
 	ExecClearTuple(gss->base_slot);
 	if (!gscan->kern.resume_context)
@@ -2587,6 +3289,26 @@ gpuscan_throw_partial_result(GpuScanTask *gscan, pgstrom_data_store *pds_dst)
 	SetLatch(MyLatch);
 }
 
+/*
+ * gpuscan_build_fallback
+ *
+ * It makes the GpuScanTask processed by the CPU fallback code, because
+ * GPU program is not built yet.
+ */
+static bool
+gpuscan_build_fallback(GpuTask *gtask)
+{
+	GpuScanTask	   *gscan = (GpuScanTask *) gtask;
+	pgstrom_data_store *pds_src = gscan->pds_src;
+
+	/* NVMe-Strom mode may not load the blocks onto the host memory yet */
+	if (pds_src->kds.format == KDS_FORMAT_BLOCK)
+		PDS_fillup_blocks(pds_src);
+	gscan->task.cpu_fallback = true;
+
+	return true;
+}
+
 /*
  * gpuscan_process_task
  */
@@ -2920,6 +3642,15 @@ pgstrom_init_gpuscan(void)
 							 PGC_USERSET,
                              GUC_NOT_IN_SAMPLE,
                              NULL, NULL, NULL);
+	/* pg_strom.cpu_fallback_vectorized */
+	DefineCustomBoolVariable("pg_strom.cpu_fallback_vectorized",
+							 "Enables vectorized CPU fallback of GpuScan",
+							 NULL,
+							 &enable_vectorized_fallback,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 
 	/* setup path methods */
 	memset(&gpuscan_path_methods, 0, sizeof(gpuscan_path_methods));
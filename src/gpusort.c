@@ -0,0 +1,1758 @@
+/*
+ * gpusort.c
+ *
+ * GPU accelerated sorting on the results of GpuScan/GpuJoin
+ * ----
+ * Copyright 2011-2018 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2018 (C) The PG-Strom Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "pg_strom.h"
+#include "cuda_gpusort.h"
+
+static create_upper_paths_hook_type create_upper_paths_next;
+static CustomPathMethods	gpusort_path_methods;
+static CustomScanMethods	gpusort_scan_methods;
+static CustomExecMethods	gpusort_exec_methods;
+static bool					enable_gpusort;		/* GUC */
+
+/*
+ * GpuSortInfo - private plan information of GpuSort
+ */
+typedef struct
+{
+	int				optimal_gpu;
+	char		   *kern_source;
+	cl_uint			extra_flags;
+	cl_uint			varlena_bufsz;
+	List		   *used_params;	/* referenced Const/Param */
+	List		   *sort_keys;		/* resno of the sort keys on tlist_dev */
+	List		   *sort_ops;		/* OID of the ordering operators */
+	List		   *sort_collations; /* OID of the collations */
+	List		   *sort_nulls_first; /* NULLS FIRST, or not */
+	cl_long			bound;			/* number of rows required, if LIMIT */
+} GpuSortInfo;
+
+static inline void
+form_gpusort_info(CustomScan *cscan, GpuSortInfo *gs_info)
+{
+	List	   *privs = NIL;
+	List	   *exprs = NIL;
+
+	privs = lappend(privs, makeInteger(gs_info->optimal_gpu));
+	privs = lappend(privs, makeString(gs_info->kern_source));
+	privs = lappend(privs, makeInteger(gs_info->extra_flags));
+	privs = lappend(privs, makeInteger(gs_info->varlena_bufsz));
+	exprs = lappend(exprs, gs_info->used_params);
+	privs = lappend(privs, gs_info->sort_keys);
+	privs = lappend(privs, gs_info->sort_ops);
+	privs = lappend(privs, gs_info->sort_collations);
+	privs = lappend(privs, gs_info->sort_nulls_first);
+	privs = lappend(privs, makeInteger(gs_info->bound));
+
+	cscan->custom_private = privs;
+	cscan->custom_exprs = exprs;
+}
+
+static inline GpuSortInfo *
+deform_gpusort_info(CustomScan *cscan)
+{
+	GpuSortInfo *gs_info = palloc0(sizeof(GpuSortInfo));
+	List	   *privs = cscan->custom_private;
+	List	   *exprs = cscan->custom_exprs;
+	int			pindex = 0;
+	int			eindex = 0;
+
+	gs_info->optimal_gpu = intVal(list_nth(privs, pindex++));
+	gs_info->kern_source = strVal(list_nth(privs, pindex++));
+	gs_info->extra_flags = intVal(list_nth(privs, pindex++));
+	gs_info->varlena_bufsz = intVal(list_nth(privs, pindex++));
+	gs_info->used_params = list_nth(exprs, eindex++);
+	gs_info->sort_keys = list_nth(privs, pindex++);
+	gs_info->sort_ops = list_nth(privs, pindex++);
+	gs_info->sort_collations = list_nth(privs, pindex++);
+	gs_info->sort_nulls_first = list_nth(privs, pindex++);
+	gs_info->bound = intVal(list_nth(privs, pindex++));
+	Assert(pindex == list_length(privs));
+	Assert(eindex == list_length(exprs));
+
+	return gs_info;
+}
+
+/*
+ * GpuSortTask - a chunk of rows to be sorted on GPU
+ */
+typedef struct
+{
+	GpuTask				task;
+	pgstrom_data_store *pds_src;	/* rows to be sorted (KDS_FORMAT_ROW) */
+	cl_uint				bound;		/* number of rows to be returned */
+	kern_gpusort		kern;
+} GpuSortTask;
+
+/*
+ * GpuSortRun - a sorted run; a GpuSortTask with sorted row index
+ */
+typedef struct
+{
+	GpuSortTask	   *gsort;		/* GpuSortTask that owns the rows */
+	cl_uint		   *results;	/* row index in the sorted order */
+	cl_uint			nitems;		/* number of rows in this run */
+	cl_uint			curr;		/* current position in this run */
+	HeapTupleData	tuple;		/* head tuple of this run */
+	Datum		   *values;		/* sort key values of the head tuple */
+	bool		   *isnull;		/* sort key nulls of the head tuple */
+} GpuSortRun;
+
+/*
+ * GpuSortState - execution state object of GpuSort
+ */
+typedef struct
+{
+	GpuTaskState	gts;
+	HeapTupleData	scan_tuple;		/* buffer to fetch tuple */
+	/* sort keys */
+	int				num_keys;
+	AttrNumber	   *sort_attnums;	/* attnums of the keys on the scan slot */
+	SortSupport		sort_keys;		/* SortSupport of the keys */
+	Oid			   *sort_ops;		/* ordering operators of the keys */
+	Oid			   *sort_collations;
+	bool		   *sort_nulls_first;
+	/* sorted runs and k-way merge */
+	bool			sort_done;		/* true, if all the runs are ready */
+	GpuSortRun	   *runs;
+	cl_int			num_runs;
+	cl_int			max_runs;
+	cl_int		   *losertree;		/* [0] is the winner, others are losers */
+	cl_int			last_winner;	/* run of the last tuple, or -1 */
+	Size			runs_usage;		/* consumption of the retained runs */
+	Tuplesortstate *tuplesort;		/* valid, if runs exceeded work_mem */
+	/* top-k (ORDER BY ... LIMIT) */
+	cl_long			bound;			/* number of rows required, or 0 */
+	cl_int			bound_run;		/* run that gives the bound key, or -1 */
+	Datum		   *bound_values;	/* the bound-th key of the @bound_run */
+	bool		   *bound_isnull;
+	/* run-time statistics */
+	cl_long			num_runs_gpu;	/* # of runs sorted on GPU */
+	cl_long			num_runs_cpu;	/* # of runs sorted on CPU (fallback) */
+	cl_long			num_rows_bounded; /* # of rows filtered by the bound */
+	bool			used_tuplesort;	/* true, if tuplesort took over runs */
+} GpuSortState;
+
+/*
+ * static functions
+ */
+static GpuTask *gpusort_next_task(GpuTaskState *gts);
+static int	gpusort_process_task(GpuTask *gtask, CUmodule cuda_module);
+static void	gpusort_release_task(GpuTask *gtask);
+static bool gpusort_build_fallback(GpuTask *gtask);
+
+/*
+ * gpusort_lookup_sortkey
+ *
+ * It looks up a member of the equivalence class of the @pathkey in the
+ * @exprs, then returns its index, or -1 if not found.
+ */
+static int
+gpusort_lookup_sortkey(PathKey *pathkey, List *exprs,
+					   EquivalenceMember **p_em)
+{
+	EquivalenceClass *ec = pathkey->pk_eclass;
+	ListCell   *lc1, *lc2;
+	int			index;
+
+	foreach (lc1, ec->ec_members)
+	{
+		EquivalenceMember *em = lfirst(lc1);
+		Expr	   *em_expr = em->em_expr;
+
+		if (em->em_is_const)
+			continue;
+		while (em_expr && IsA(em_expr, RelabelType))
+			em_expr = ((RelabelType *) em_expr)->arg;
+
+		index = 0;
+		foreach (lc2, exprs)
+		{
+			Expr   *expr = lfirst(lc2);
+
+			while (expr && IsA(expr, RelabelType))
+				expr = ((RelabelType *) expr)->arg;
+			if (equal(expr, em_expr))
+			{
+				if (p_em)
+					*p_em = em;
+				return index;
+			}
+			index++;
+		}
+	}
+	return -1;
+}
+
+/*
+ * gpusort_device_sortkey
+ *
+ * It checks whether the sort key can be compared on the device. Device
+ * comparison function follows the default btree operator family of the
+ * data type, so any other operator family is not supported.
+ */
+static bool
+gpusort_device_sortkey(PathKey *pathkey, Expr *expr)
+{
+	Oid				type_oid = exprType((Node *) expr);
+	TypeCacheEntry *tcache;
+	devtype_info   *dtype;
+
+	if (pathkey->pk_eclass->ec_has_volatile)
+		return false;
+	if (pathkey->pk_strategy != BTLessStrategyNumber &&
+		pathkey->pk_strategy != BTGreaterStrategyNumber)
+		return false;
+	dtype = pgstrom_devtype_lookup(type_oid);
+	if (!dtype)
+		return false;
+	tcache = lookup_type_cache(type_oid, TYPECACHE_BTREE_OPFAMILY);
+	if (tcache->btree_opf != pathkey->pk_opfamily)
+		return false;
+	if (!pgstrom_devfunc_lookup_type_compare(dtype,
+											 pathkey->pk_eclass->ec_collation))
+		return false;
+	return true;
+}
+
+/*
+ * cost_gpusort
+ *
+ * GpuSort loads the input rows onto chunks, sorts individual chunks on GPU
+ * by bitonic-sorting, then merges the sorted chunks on CPU.
+ * If @bound is given, once a chunk gets sorted, its bound-th key filters out
+ * rows of the later chunks prior to loading, so most of the rows are never
+ * sent to GPU.
+ */
+static void
+cost_gpusort(PlannerInfo *root, CustomPath *cpath, Path *input_path,
+			 double bound)
+{
+	pgstromCostFactors cf;
+	double		ntuples = Max(input_path->rows, 1.0);
+	double		nsorted = ntuples;
+	double		tuple_size;
+	double		nchunks;
+	double		nrows_per_chunk;
+	double		log2_nrows;
+	Cost		startup_cost;
+	Cost		run_cost;
+
+	pgstrom_get_cost_factors(root, input_path->parent, &cf);
+
+	/* number of chunks, and rows per chunk */
+	tuple_size = MAXALIGN(offsetof(HeapTupleHeaderData, t_bits) +
+						  input_path->pathtarget->width) +
+		sizeof(kern_tupitem) + sizeof(cl_uint);
+	nrows_per_chunk = Max(floor((double) pgstrom_chunk_size() / tuple_size),
+						  1.0);
+	startup_cost = input_path->total_cost;
+	startup_cost += cf.gpu_setup_cost;
+	startup_cost += cpu_tuple_cost * ntuples;
+	if (bound > 0.0 && ntuples > nrows_per_chunk)
+	{
+		/*
+		 * The first chunk is sorted as is, then rows of the later chunks
+		 * are checked by the bound key; we assume half of the rooms are
+		 * consumed by rows that are prior to the bound.
+		 */
+		nsorted = nrows_per_chunk +
+			Min(2.0 * bound, nrows_per_chunk) *
+			(ntuples - nrows_per_chunk) / nrows_per_chunk;
+		startup_cost += cpu_operator_cost * (ntuples - nrows_per_chunk);
+	}
+	nchunks = Max(ceil(nsorted / nrows_per_chunk), 1.0);
+	nrows_per_chunk = nsorted / nchunks;
+	log2_nrows = Max(log(nrows_per_chunk) / 0.693147180559945, 1.0);
+
+	/* input rows must be fetched and sorted, prior to the first row */
+	startup_cost += cf.gpu_dma_cost * nchunks;
+	/* bitonic sorting needs log2(N) * (log2(N) + 1) / 2 steps */
+	startup_cost += 2.0 * cf.gpu_operator_cost * nsorted *
+		log2_nrows * (log2_nrows + 1.0) / 4.0;
+	/* k-way merge on CPU for each row to be returned */
+	run_cost = cpu_operator_cost * ntuples;
+	if (nchunks > 1.0)
+		run_cost += 2.0 * cpu_operator_cost * ntuples *
+			(log(nchunks) / 0.693147180559945);
+	/*
+	 * Once sorted runs exceed work_mem, tuplesort takes over the merge;
+	 * rows are sorted again and written out to temporary files.
+	 */
+	if (nchunks > 1.0 && nsorted * tuple_size > (double) work_mem * 1024.0)
+	{
+		double	npages = ceil(nsorted * tuple_size / (double) BLCKSZ);
+
+		startup_cost += 2.0 * cpu_operator_cost * nsorted *
+			Max(log(nsorted) / 0.693147180559945, 1.0);
+		startup_cost += 2.0 * seq_page_cost * npages;
+	}
+
+	cpath->path.rows = input_path->rows;
+	cpath->path.startup_cost = startup_cost;
+	cpath->path.total_cost = startup_cost + run_cost;
+}
+
+/*
+ * gpusort_add_ordered_paths
+ */
+static void
+gpusort_add_ordered_paths(PlannerInfo *root,
+						  UpperRelationKind stage,
+						  RelOptInfo *input_rel,
+						  RelOptInfo *ordered_rel
+#if PG_VERSION_NUM >= 110000
+						  ,void *extra
+#endif
+	)
+{
+	Path	   *input_path;
+	Path	   *sub_path;
+	Path	   *final_path;
+	PathTarget *final_target;
+	CustomPath *cpath;
+	GpuSortInfo *gs_info;
+	cl_int		optimal_gpu;
+	ListCell   *lc;
+
+	if (create_upper_paths_next)
+	{
+#if PG_VERSION_NUM < 110000
+		(*create_upper_paths_next)(root, stage, input_rel, ordered_rel);
+#else
+		(*create_upper_paths_next)(root, stage, input_rel, ordered_rel, extra);
+#endif
+	}
+
+	if (stage != UPPERREL_ORDERED)
+		return;
+	if (!pgstrom_enabled || !enable_gpusort)
+		return;
+	if (root->sort_pathkeys == NIL)
+		return;
+
+	input_path = input_rel->cheapest_total_path;
+	if (pathkeys_contained_in(root->sort_pathkeys, input_path->pathkeys))
+		return;
+
+	/* GpuSort takes the results of GpuScan or GpuJoin */
+	sub_path = input_path;
+	if (IsA(sub_path, ProjectionPath))
+		sub_path = ((ProjectionPath *) sub_path)->subpath;
+	if (pgstrom_path_is_gpuscan(sub_path))
+		optimal_gpu = gpuscan_get_optimal_gpu(sub_path);
+	else if (pgstrom_path_is_gpujoin(sub_path))
+		optimal_gpu = gpujoin_get_optimal_gpu(sub_path);
+	else
+		return;
+
+	/* all the sort keys must be comparable on the device */
+	foreach (lc, root->sort_pathkeys)
+	{
+		PathKey	   *pathkey = lfirst(lc);
+		int			index;
+
+		index = gpusort_lookup_sortkey(pathkey,
+									   input_path->pathtarget->exprs,
+									   NULL);
+		if (index < 0)
+			return;
+		if (!gpusort_device_sortkey(pathkey,
+									list_nth(input_path->pathtarget->exprs,
+											 index)))
+			return;
+	}
+
+	gs_info = palloc0(sizeof(GpuSortInfo));
+	gs_info->optimal_gpu = optimal_gpu;
+	/*
+	 * A constant LIMIT gives the number of rows to be required, unless any
+	 * rows may be dropped between GpuSort and Limit (e.g, FOR UPDATE).
+	 *
+	 * NOTE: the bound is applied on the chunks of GpuSort, not pushed down
+	 * to the GpuScan/GpuJoin kernels underneath; rows behind the bound key
+	 * are still produced by them, but never loaded onto the later chunks.
+	 * Per-task bound of GpuScan needs the sort keys and the bound values
+	 * delivered to its kernel for each task, which is not supported yet.
+	 * GpuPreAgg is not bounded, because its partial results cannot be cut
+	 * before the final aggregation.
+	 */
+	if (root->limit_tuples > 0.0 &&
+		root->limit_tuples < (double) INT_MAX &&
+		root->parse->rowMarks == NIL)
+		gs_info->bound = (cl_long) root->limit_tuples;
+
+	cpath = makeNode(CustomPath);
+	cpath->path.pathtype = T_CustomScan;
+	cpath->path.parent = ordered_rel;
+	cpath->path.pathtarget = input_path->pathtarget;
+	cpath->path.param_info = NULL;
+	cpath->path.parallel_aware = false;
+	cpath->path.parallel_safe = false;
+	cpath->path.parallel_workers = 0;
+	cpath->path.pathkeys = root->sort_pathkeys;
+	cpath->flags = 0;
+	cpath->custom_paths = list_make1(input_path);
+	cpath->custom_private = list_make1(gs_info);
+	cpath->methods = &gpusort_path_methods;
+	cost_gpusort(root, cpath, input_path, (double) gs_info->bound);
+
+	final_path = &cpath->path;
+	final_target = root->upper_targets[UPPERREL_FINAL];
+	if (final_target && final_path->pathtarget != final_target)
+		final_path = apply_projection_to_path(root, ordered_rel,
+											  final_path, final_target);
+	add_path(ordered_rel, final_path);
+}
+
+/*
+ * gpusort_codegen_keycomp
+ */
+static char *
+gpusort_codegen_keycomp(codegen_context *context,
+						List *tlist_dev,
+						List *pathkeys,
+						GpuSortInfo *gs_info)
+{
+	StringInfoData	kern;
+	StringInfoData	body;
+	ListCell	   *lc1, *lc2;
+
+	initStringInfo(&kern);
+	initStringInfo(&body);
+	forboth (lc1, pathkeys,
+			 lc2, gs_info->sort_keys)
+	{
+		PathKey		   *pathkey = lfirst(lc1);
+		TargetEntry	   *tle = list_nth(tlist_dev, lfirst_int(lc2) - 1);
+		Oid				type_oid;
+		devtype_info   *dtype;
+		devfunc_info   *dfunc;
+
+		type_oid = exprType((Node *) tle->expr);
+		dtype = pgstrom_devtype_lookup_and_track(type_oid, context);
+		if (!dtype)
+			elog(ERROR, "Bug? type %s is not supported on device",
+				 format_type_be(type_oid));
+		dfunc = pgstrom_devfunc_lookup_type_compare(dtype,
+									pathkey->pk_eclass->ec_collation);
+		if (!dfunc)
+			elog(ERROR, "Bug? type %s has no device comparison function",
+				 format_type_be(type_oid));
+		pgstrom_devfunc_track(context, dfunc);
+
+		appendStringInfo(
+			&body,
+			"  /* -- compare attribute %d -- */\n"
+			"  addr = kern_get_datum_row(kds_src, %d, x_index);\n"
+			"  xval.%s_v = pg_%s_datum_ref(kcxt, addr);\n"
+			"  addr = kern_get_datum_row(kds_src, %d, y_index);\n"
+			"  yval.%s_v = pg_%s_datum_ref(kcxt, addr);\n"
+			"  if (!xval.%s_v.isnull && !yval.%s_v.isnull)\n"
+			"  {\n"
+			"    comp = pgfn_%s(kcxt, xval.%s_v, yval.%s_v);\n"
+			"    if (comp.isnull)\n"
+			"      return 0;\n"
+			"    if (comp.value != 0)\n"
+			"      return %s;\n"
+			"  }\n"
+			"  else if (xval.%s_v.isnull && !yval.%s_v.isnull)\n"
+			"    return %d;\n"
+			"  else if (!xval.%s_v.isnull && yval.%s_v.isnull)\n"
+			"    return %d;\n",
+			tle->resno,
+			tle->resno - 1,
+			dtype->type_name, dtype->type_name,
+			tle->resno - 1,
+			dtype->type_name, dtype->type_name,
+			dtype->type_name, dtype->type_name,
+			dfunc->func_devname,
+			dtype->type_name, dtype->type_name,
+			pathkey->pk_strategy == BTLessStrategyNumber
+			? "comp.value" : "-comp.value",
+			dtype->type_name, dtype->type_name,
+			pathkey->pk_nulls_first ? -1 :  1,
+			dtype->type_name, dtype->type_name,
+			pathkey->pk_nulls_first ?  1 : -1);
+	}
+
+	appendStringInfo(
+		&kern,
+		"STATIC_FUNCTION(cl_int)\n"
+		"gpusort_keycomp(kern_context *kcxt,\n"
+		"                kern_data_store *kds_src,\n"
+		"                cl_uint x_index,\n"
+		"                cl_uint y_index)\n"
+		"{\n"
+		"  void *addr        __attribute__((unused));\n"
+		"  pg_anytype_t xval __attribute__((unused));\n"
+		"  pg_anytype_t yval __attribute__((unused));\n"
+		"  pg_int4_t comp    __attribute__((unused));\n"
+		"\n"
+		"  assert(kds_src->format == KDS_FORMAT_ROW);\n"
+		"  assert(x_index < kds_src->nitems &&\n"
+		"         y_index < kds_src->nitems);\n"
+		"%s"
+		"  return 0;\n"
+		"}\n\n",
+		body.data);
+	pfree(body.data);
+
+	return kern.data;
+}
+
+/*
+ * PlanGpuSortPath
+ */
+static Plan *
+PlanGpuSortPath(PlannerInfo *root,
+				RelOptInfo *rel,
+				CustomPath *best_path,
+				List *tlist,
+				List *clauses,
+				List *custom_plans)
+{
+	GpuSortInfo	   *gs_info = linitial(best_path->custom_private);
+	CustomScan	   *cscan;
+	Plan		   *outer_plan;
+	List		   *tlist_dev = NIL;
+	List		   *exprs_dev = NIL;
+	ListCell	   *lc;
+	codegen_context	context;
+
+	Assert(list_length(custom_plans) == 1);
+	outer_plan = linitial(custom_plans);
+
+	/* GpuSort returns the outer rows as is */
+	foreach (lc, outer_plan->targetlist)
+	{
+		TargetEntry	   *tle = lfirst(lc);
+		TargetEntry	   *tle_new;
+
+		tle_new = makeTargetEntry(copyObject(tle->expr),
+								  list_length(tlist_dev) + 1,
+								  tle->resname ? pstrdup(tle->resname) : NULL,
+								  false);
+		tlist_dev = lappend(tlist_dev, tle_new);
+		exprs_dev = lappend(exprs_dev, tle_new->expr);
+	}
+
+	/* sort keys */
+	foreach (lc, best_path->path.pathkeys)
+	{
+		PathKey	   *pathkey = lfirst(lc);
+		EquivalenceMember *em;
+		Oid			sortop;
+		int			index;
+
+		index = gpusort_lookup_sortkey(pathkey, exprs_dev, &em);
+		if (index < 0)
+			elog(ERROR, "Bug? GpuSort key is not in the target-list");
+		sortop = get_opfamily_member(pathkey->pk_opfamily,
+									 em->em_datatype,
+									 em->em_datatype,
+									 pathkey->pk_strategy);
+		if (!OidIsValid(sortop))
+			elog(ERROR, "missing operator %d(%u,%u) in opfamily %u",
+				 pathkey->pk_strategy, em->em_datatype, em->em_datatype,
+				 pathkey->pk_opfamily);
+		gs_info->sort_keys = lappend_int(gs_info->sort_keys, index + 1);
+		gs_info->sort_ops = lappend_oid(gs_info->sort_ops, sortop);
+		gs_info->sort_collations = lappend_oid(gs_info->sort_collations,
+										pathkey->pk_eclass->ec_collation);
+		gs_info->sort_nulls_first = lappend_int(gs_info->sort_nulls_first,
+												pathkey->pk_nulls_first);
+	}
+
+	/* code generation of the key comparison */
+	pgstrom_init_codegen_context(&context, root);
+	gs_info->kern_source = gpusort_codegen_keycomp(&context, tlist_dev,
+												   best_path->path.pathkeys,
+												   gs_info);
+	gs_info->extra_flags = context.extra_flags | DEVKERNEL_NEEDS_GPUSORT;
+	gs_info->varlena_bufsz = context.varlena_bufsz;
+	gs_info->used_params = context.used_params;
+
+	/* build a CustomScan node */
+	cscan = makeNode(CustomScan);
+	cscan->scan.plan.targetlist = tlist;
+	cscan->scan.plan.qual = NIL;
+	outerPlan(cscan) = outer_plan;
+	cscan->scan.scanrelid = 0;
+	cscan->flags = best_path->flags;
+	cscan->custom_scan_tlist = tlist_dev;
+	cscan->methods = &gpusort_scan_methods;
+	form_gpusort_info(cscan, gs_info);
+
+	return &cscan->scan.plan;
+}
+
+/*
+ * CreateGpuSortScanState - constructor of GpuSortState
+ */
+static Node *
+CreateGpuSortScanState(CustomScan *cscan)
+{
+	/*
+	 * NOTE: GpuSortState is referenced by the worker threads, so it shall
+	 * be allocated on CurTransactionContext as other GpuTaskStates are.
+	 */
+	GpuSortState   *gss = MemoryContextAllocZero(CurTransactionContext,
+												 sizeof(GpuSortState));
+	/* Set tag and executor callbacks */
+	NodeSetTag(gss, T_CustomScanState);
+	gss->gts.css.flags = cscan->flags;
+	gss->gts.css.methods = &gpusort_exec_methods;
+
+	return (Node *) gss;
+}
+
+/*
+ * ExecInitGpuSort
+ */
+static void
+ExecInitGpuSort(CustomScanState *node, EState *estate, int eflags)
+{
+	GpuSortState   *gss = (GpuSortState *) node;
+	CustomScan	   *cscan = (CustomScan *) node->ss.ps.plan;
+	GpuSortInfo	   *gs_info = deform_gpusort_info(cscan);
+	StringInfoData	kern_define;
+	ProgramId		program_id;
+	ListCell	   *lc1, *lc2, *lc3, *lc4;
+	int				index = 0;
+	bool			explain_only = ((eflags & EXEC_FLAG_EXPLAIN_ONLY) != 0);
+
+	Assert(node->ss.ss_currentRelation == NULL && outerPlan(cscan) != NULL);
+	/* activate a GpuContext for CUDA kernel execution */
+	gss->gts.gcontext = AllocGpuContext(gs_info->optimal_gpu,
+										false, false, false);
+	/* setup common GpuTaskState fields */
+	pgstromInitGpuTaskState(&gss->gts,
+							gss->gts.gcontext,
+							GpuTaskKind_GpuSort,
+							NIL,
+							gs_info->used_params,
+							gs_info->optimal_gpu,
+							0,
+							estate);
+	gss->gts.cb_next_task		= gpusort_next_task;
+	gss->gts.cb_process_task	= gpusort_process_task;
+	gss->gts.cb_release_task	= gpusort_release_task;
+	if (pgstrom_cpu_fallback_during_build ||
+		pgstrom_debug_force_cpu_fallback)
+		gss->gts.cb_build_fallback = gpusort_build_fallback;
+
+	/*
+	 * initialization of the outer plan; GpuSort reads the whole of outer
+	 * rows once, so it never rewinds the subplan.
+	 */
+	outerPlanState(gss) = ExecInitNode(outerPlan(cscan), estate,
+									   eflags & ~(EXEC_FLAG_REWIND |
+												  EXEC_FLAG_BACKWARD |
+												  EXEC_FLAG_MARK));
+
+	/* SortSupport for the k-way merge and CPU fallback */
+	gss->num_keys = list_length(gs_info->sort_keys);
+	gss->sort_attnums = palloc0(sizeof(AttrNumber) * gss->num_keys);
+	gss->sort_keys = palloc0(sizeof(SortSupportData) * gss->num_keys);
+	gss->sort_ops = palloc0(sizeof(Oid) * gss->num_keys);
+	gss->sort_collations = palloc0(sizeof(Oid) * gss->num_keys);
+	gss->sort_nulls_first = palloc0(sizeof(bool) * gss->num_keys);
+	forfour (lc1, gs_info->sort_keys,
+			 lc2, gs_info->sort_ops,
+			 lc3, gs_info->sort_collations,
+			 lc4, gs_info->sort_nulls_first)
+	{
+		SortSupport	ssup = &gss->sort_keys[index];
+
+		gss->sort_attnums[index] = lfirst_int(lc1);
+		gss->sort_ops[index] = lfirst_oid(lc2);
+		gss->sort_collations[index] = lfirst_oid(lc3);
+		gss->sort_nulls_first[index] = (lfirst_int(lc4) != 0);
+		ssup->ssup_cxt = estate->es_query_cxt;
+		ssup->ssup_collation = lfirst_oid(lc3);
+		ssup->ssup_nulls_first = (lfirst_int(lc4) != 0);
+		ssup->ssup_attno = lfirst_int(lc1);
+		ssup->abbreviate = false;
+		PrepareSortSupportFromOrderingOp(lfirst_oid(lc2), ssup);
+		index++;
+	}
+	gss->last_winner = -1;
+	/* top-k, if ORDER BY ... LIMIT */
+	gss->bound = gs_info->bound;
+	gss->bound_run = -1;
+	gss->bound_values = palloc0(sizeof(Datum) * Max(gss->num_keys, 1));
+	gss->bound_isnull = palloc0(sizeof(bool) * Max(gss->num_keys, 1));
+
+	/* Get CUDA program and async build if any */
+	initStringInfo(&kern_define);
+	pgstrom_build_session_info(&kern_define,
+							   &gss->gts,
+							   gs_info->extra_flags);
+	program_id = pgstrom_create_cuda_program(gss->gts.gcontext,
+											 gs_info->extra_flags,
+											 gs_info->varlena_bufsz,
+											 gs_info->kern_source,
+											 kern_define.data,
+											 false,
+											 explain_only);
+	gss->gts.program_id = program_id;
+	pfree(kern_define.data);
+}
+
+/*
+ * gpusort_create_task - constructor of GpuSortTask
+ */
+static GpuSortTask *
+gpusort_create_task(GpuSortState *gss, pgstrom_data_store *pds_src)
+{
+	GpuContext	   *gcontext = gss->gts.gcontext;
+	GpuSortTask	   *gsort;
+	size_t			length;
+	CUdeviceptr		m_deviceptr;
+	CUresult		rc;
+
+	Assert(pds_src->kds.format == KDS_FORMAT_ROW);
+	length = (STROMALIGN(offsetof(GpuSortTask, kern.kparams)) +
+			  STROMALIGN(gss->gts.kern_params->length) +
+			  STROMALIGN(sizeof(cl_uint) * pds_src->kds.nitems));
+	rc = gpuMemAllocManaged(gcontext,
+							&m_deviceptr,
+							length,
+							CU_MEM_ATTACH_GLOBAL);
+	if (rc != CUDA_SUCCESS)
+		elog(ERROR, "failed on gpuMemAllocManaged: %s", errorText(rc));
+	gsort = (GpuSortTask *) m_deviceptr;
+	memset(gsort, 0, length);
+	pgstromInitGpuTask(&gss->gts, &gsort->task);
+	gsort->pds_src = pds_src;
+	gsort->kern.nitems = pds_src->kds.nitems;
+	if (gss->bound > 0 && gss->bound < pds_src->kds.nitems)
+		gsort->bound = gss->bound;
+	else
+		gsort->bound = pds_src->kds.nitems;
+	/* kern_parambuf */
+	memcpy(KERN_GPUSORT_PARAMBUF(&gsort->kern),
+		   gss->gts.kern_params,
+		   gss->gts.kern_params->length);
+	return gsort;
+}
+
+/*
+ * gpusort_slot_precedes_bound
+ *
+ * It checks whether the row on the @slot precedes the bound key; the rows
+ * behind the bound-th row of a sorted run are never returned.
+ */
+static bool
+gpusort_slot_precedes_bound(GpuSortState *gss, TupleTableSlot *slot)
+{
+	Datum		value;
+	bool		isnull;
+	int			i, comp;
+
+	for (i=0; i < gss->num_keys; i++)
+	{
+		value = slot_getattr(slot, gss->sort_attnums[i], &isnull);
+		comp = ApplySortComparator(value, isnull,
+								   gss->bound_values[i],
+								   gss->bound_isnull[i],
+								   &gss->sort_keys[i]);
+		if (comp != 0)
+			return (comp < 0);
+	}
+	return false;
+}
+
+/*
+ * gpusort_next_task
+ *
+ * It loads the rows of outer plan onto a chunk, up to pgstrom_chunk_size().
+ */
+static GpuTask *
+gpusort_next_task(GpuTaskState *gts)
+{
+	GpuSortState   *gss = (GpuSortState *) gts;
+	GpuContext	   *gcontext = gss->gts.gcontext;
+	PlanState	   *outer_ps = outerPlanState(gss);
+	TupleDesc		tupdesc = ExecGetResultType(outer_ps);
+	TupleTableSlot *slot;
+	pgstrom_data_store *pds = NULL;
+
+	while (true)
+	{
+		if (gss->gts.scan_overflow)
+		{
+			if (gss->gts.scan_overflow == (void *)(~0UL))
+				break;
+			slot = gss->gts.scan_overflow;
+			gss->gts.scan_overflow = NULL;
+		}
+		else
+		{
+			slot = ExecProcNode(outer_ps);
+			if (TupIsNull(slot))
+			{
+				gss->gts.scan_overflow = (void *)(~0UL);
+				break;
+			}
+		}
+
+		/* skip rows behind the bound key, if top-k */
+		if (gss->bound_run >= 0 &&
+			!gpusort_slot_precedes_bound(gss, slot))
+		{
+			gss->num_rows_bounded++;
+			continue;
+		}
+
+		/* create a new data-store on demand */
+		if (!pds)
+		{
+			pds = PDS_create_row(gcontext,
+								 tupdesc,
+								 pgstrom_chunk_size());
+		}
+
+		if (!PDS_insert_tuple(pds, slot))
+		{
+			gss->gts.scan_overflow = slot;
+			break;
+		}
+	}
+	if (!pds)
+		return NULL;
+	return &gpusort_create_task(gss, pds)->task;
+}
+
+/*
+ * gpusort_launch_kernel - launch a bitonic sorting kernel synchronously
+ */
+static void
+gpusort_launch_kernel(CUfunction kern_function,
+					  cl_int grid_sz, cl_int block_sz,
+					  void **kern_args)
+{
+	CUresult	rc;
+
+	rc = cuLaunchKernel(kern_function,
+						grid_sz, 1, 1,
+						block_sz, 1, 1,
+						0,
+						CU_STREAM_PER_THREAD,
+						kern_args,
+						NULL);
+	if (rc != CUDA_SUCCESS)
+		werror("failed on cuLaunchKernel: %s", errorText(rc));
+}
+
+/*
+ * gpusort_process_task
+ */
+static int
+gpusort_process_task(GpuTask *gtask, CUmodule cuda_module)
+{
+	GpuSortTask	   *gsort = (GpuSortTask *) gtask;
+	pgstrom_data_store *pds_src = gsort->pds_src;
+	CUfunction		kern_setup_index;
+	CUfunction		kern_bitonic_local;
+	CUfunction		kern_bitonic_step;
+	CUfunction		kern_bitonic_merge;
+	CUdeviceptr		m_gpusort = (CUdeviceptr)&gsort->kern;
+	CUdeviceptr		m_kds_src = (CUdeviceptr)&pds_src->kds;
+	cl_uint			nitems = gsort->kern.nitems;
+	cl_uint			block_size;
+	cl_uint			unit_size;
+	cl_bool			reversing;
+	void		   *kern_args[4];
+	cl_int			grid_sz;
+	cl_int			block_sz;
+	CUresult		rc;
+
+	/*
+	 * Lookup GPU kernel functions
+	 */
+	rc = cuModuleGetFunction(&kern_setup_index,
+							 cuda_module,
+							 "gpusort_setup_index");
+	if (rc != CUDA_SUCCESS)
+		werror("failed on cuModuleGetFunction: %s", errorText(rc));
+	rc = cuModuleGetFunction(&kern_bitonic_local,
+							 cuda_module,
+							 "gpusort_bitonic_local");
+	if (rc != CUDA_SUCCESS)
+		werror("failed on cuModuleGetFunction: %s", errorText(rc));
+	rc = cuModuleGetFunction(&kern_bitonic_step,
+							 cuda_module,
+							 "gpusort_bitonic_step");
+	if (rc != CUDA_SUCCESS)
+		werror("failed on cuModuleGetFunction: %s", errorText(rc));
+	rc = cuModuleGetFunction(&kern_bitonic_merge,
+							 cuda_module,
+							 "gpusort_bitonic_merge");
+	if (rc != CUDA_SUCCESS)
+		werror("failed on cuModuleGetFunction: %s", errorText(rc));
+
+	/*
+	 * OK, enqueue a series of requests
+	 */
+	rc = cuMemPrefetchAsync(m_gpusort,
+							KERN_GPUSORT_DMASEND_LENGTH(&gsort->kern),
+							CU_DEVICE_PER_THREAD,
+							CU_STREAM_PER_THREAD);
+	if (rc != CUDA_SUCCESS)
+		werror("failed on cuMemPrefetchAsync: %s", errorText(rc));
+	rc = cuMemPrefetchAsync(m_kds_src,
+							pds_src->kds.length,
+							CU_DEVICE_PER_THREAD,
+							CU_STREAM_PER_THREAD);
+	if (rc != CUDA_SUCCESS)
+		werror("failed on cuMemPrefetchAsync: %s", errorText(rc));
+
+	kern_args[0] = &m_gpusort;
+	kern_args[1] = &m_kds_src;
+	kern_args[2] = &unit_size;
+	kern_args[3] = &reversing;
+
+	/*
+	 * KERNEL_FUNCTION(void)
+	 * gpusort_setup_index(kern_gpusort *kgpusort,
+	 *                     kern_data_store *kds_src)
+	 */
+	rc = gpuOptimalBlockSize(&grid_sz,
+							 &block_sz,
+							 kern_setup_index,
+							 CU_DEVICE_PER_THREAD,
+							 0, 0);
+	if (rc != CUDA_SUCCESS)
+		werror("failed on gpuOptimalBlockSize: %s", errorText(rc));
+	gpusort_launch_kernel(kern_setup_index, grid_sz, block_sz, kern_args);
+
+	/*
+	 * KERNEL_FUNCTION_MAXTHREADS(void)
+	 * gpusort_bitonic_local(kern_gpusort *kgpusort,
+	 *                       kern_data_store *kds_src)
+	 *
+	 * Every BITONIC_MAX_LOCAL_SZ items are sorted by a thread-block.
+	 */
+	rc = gpuLargestBlockSize(&grid_sz,
+							 &block_sz,
+							 kern_bitonic_local,
+							 CU_DEVICE_PER_THREAD,
+							 0, 0);
+	if (rc != CUDA_SUCCESS)
+		werror("failed on gpuLargestBlockSize: %s", errorText(rc));
+	block_sz = Min(block_sz, BITONIC_MAX_LOCAL_SZ / 2);
+	grid_sz = (nitems + BITONIC_MAX_LOCAL_SZ - 1) / BITONIC_MAX_LOCAL_SZ;
+	gpusort_launch_kernel(kern_bitonic_local, grid_sz, block_sz, kern_args);
+
+	/*
+	 * Merge the sorted units, if the chunk has more rows than a unit.
+	 *
+	 * KERNEL_FUNCTION_MAXTHREADS(void)
+	 * gpusort_bitonic_step(kern_gpusort *kgpusort,
+	 *                      kern_data_store *kds_src,
+	 *                      cl_uint unitSize,
+	 *                      cl_bool reversing)
+	 *
+	 * KERNEL_FUNCTION_MAXTHREADS(void)
+	 * gpusort_bitonic_merge(kern_gpusort *kgpusort,
+	 *                       kern_data_store *kds_src)
+	 */
+	for (block_size = 2 * BITONIC_MAX_LOCAL_SZ;
+		 block_size / 2 < nitems;
+		 block_size *= 2)
+	{
+		for (unit_size = block_size;
+			 unit_size > BITONIC_MAX_LOCAL_SZ;
+			 unit_size /= 2)
+		{
+			reversing = (unit_size == block_size);
+			rc = gpuOptimalBlockSize(&grid_sz,
+									 &block_sz,
+									 kern_bitonic_step,
+									 CU_DEVICE_PER_THREAD,
+									 0, 0);
+			if (rc != CUDA_SUCCESS)
+				werror("failed on gpuOptimalBlockSize: %s", errorText(rc));
+			gpusort_launch_kernel(kern_bitonic_step,
+								  grid_sz, block_sz, kern_args);
+		}
+		rc = gpuLargestBlockSize(&grid_sz,
+								 &block_sz,
+								 kern_bitonic_merge,
+								 CU_DEVICE_PER_THREAD,
+								 0, 0);
+		if (rc != CUDA_SUCCESS)
+			werror("failed on gpuLargestBlockSize: %s", errorText(rc));
+		block_sz = Min(block_sz, BITONIC_MAX_LOCAL_SZ / 2);
+		grid_sz = (nitems + BITONIC_MAX_LOCAL_SZ - 1) / BITONIC_MAX_LOCAL_SZ;
+		gpusort_launch_kernel(kern_bitonic_merge,
+							  grid_sz, block_sz, kern_args);
+	}
+
+	rc = cuEventRecord(CU_EVENT0_PER_THREAD, CU_STREAM_PER_THREAD);
+	if (rc != CUDA_SUCCESS)
+		werror("failed on cuEventRecord: %s", errorText(rc));
+
+	/* Point of synchronization */
+	rc = cuEventSynchronize(CU_EVENT0_PER_THREAD);
+	if (rc != CUDA_SUCCESS)
+		werror("failed on cuEventSynchronize: %s", errorText(rc));
+
+	/*
+	 * Check GPU kernel status
+	 */
+	gsort->task.kerror = gsort->kern.kerror;
+	if (gsort->task.kerror.errcode == StromError_Success)
+	{
+		rc = cuMemPrefetchAsync((CUdeviceptr)
+								KERN_GPUSORT_RESULT_INDEX(&gsort->kern),
+								sizeof(cl_uint) * gsort->bound,
+								CU_DEVICE_CPU,
+								CU_STREAM_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+			werror("failed on cuMemPrefetchAsync: %s", errorText(rc));
+	}
+	else if (pgstrom_cpu_fallback_enabled &&
+			 gsort->task.kerror.errcode == StromError_CpuReCheck)
+	{
+		/* the chunk shall be sorted by CPU, then merged */
+		memset(&gsort->task.kerror, 0, sizeof(kern_errorbuf));
+		gsort->task.cpu_fallback = true;
+	}
+	return 0;
+}
+
+/*
+ * gpusort_release_task
+ */
+static void
+gpusort_release_task(GpuTask *gtask)
+{
+	GpuSortTask	   *gsort = (GpuSortTask *) gtask;
+	GpuTaskState   *gts = gsort->task.gts;
+
+	if (gsort->pds_src)
+		PDS_release(gsort->pds_src);
+	gpuMemFree(gts->gcontext, (CUdeviceptr) gsort);
+}
+
+/*
+ * gpusort_build_fallback
+ *
+ * It makes the chunk sorted by CPU, because GPU program is not built yet.
+ * The chunk is merged with the other runs as if GPU kernel gave up.
+ */
+static bool
+gpusort_build_fallback(GpuTask *gtask)
+{
+	GpuSortTask	   *gsort = (GpuSortTask *) gtask;
+
+	gsort->task.cpu_fallback = true;
+
+	return true;
+}
+
+/*
+ * gpusort_fetch_run_row - load the @index'th tuple of the run and its keys
+ */
+static void
+gpusort_fetch_run_row(GpuSortState *gss, GpuSortRun *run, cl_uint index)
+{
+	kern_data_store *kds = &run->gsort->pds_src->kds;
+	TupleDesc	tupdesc = gss->gts.css.ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+	HeapTuple	tuple = &run->tuple;
+	int			i;
+
+	Assert(index < run->nitems);
+	tuple->t_data = KDS_ROW_REF_HTUP(kds,
+						KERN_DATA_STORE_ROWINDEX(kds)[run->results[index]],
+						&tuple->t_self,
+						&tuple->t_len);
+	for (i=0; i < gss->num_keys; i++)
+	{
+		run->values[i] = heap_getattr(tuple,
+									  gss->sort_attnums[i],
+									  tupdesc,
+									  &run->isnull[i]);
+	}
+}
+
+/*
+ * gpusort_fetch_run_head - load the head tuple of the run and its keys
+ */
+static void
+gpusort_fetch_run_head(GpuSortState *gss, GpuSortRun *run)
+{
+	if (run->curr < run->nitems)
+		gpusort_fetch_run_row(gss, run, run->curr);
+}
+
+/*
+ * gpusort_update_bound
+ *
+ * It tightens the bound key by the bound-th row of the new run, if top-k.
+ * Rows behind the bound key are never loaded onto the later chunks.
+ */
+static void
+gpusort_update_bound(GpuSortState *gss, cl_int run_index)
+{
+	GpuSortRun *run = &gss->runs[run_index];
+	int			i, comp;
+
+	Assert(gss->bound > 0 && run->nitems >= gss->bound);
+	gpusort_fetch_run_row(gss, run, gss->bound - 1);
+	if (gss->bound_run >= 0)
+	{
+		for (i=0; i < gss->num_keys; i++)
+		{
+			comp = ApplySortComparator(run->values[i],
+									   run->isnull[i],
+									   gss->bound_values[i],
+									   gss->bound_isnull[i],
+									   &gss->sort_keys[i]);
+			if (comp > 0)
+				return;		/* the current bound is tighter */
+			if (comp < 0)
+				break;
+		}
+		if (i == gss->num_keys)
+			return;			/* same bound key */
+	}
+	memcpy(gss->bound_values, run->values, sizeof(Datum) * gss->num_keys);
+	memcpy(gss->bound_isnull, run->isnull, sizeof(bool) * gss->num_keys);
+	gss->bound_run = run_index;
+}
+
+/*
+ * gpusort_run_precedes - true, if head of the run @x precedes the run @y
+ *
+ * An exhausted run is considered as infinite.
+ */
+static bool
+gpusort_run_precedes(GpuSortState *gss, cl_int x, cl_int y)
+{
+	GpuSortRun *xrun = &gss->runs[x];
+	GpuSortRun *yrun = &gss->runs[y];
+	int			i, comp;
+
+	if (yrun->curr >= yrun->nitems)
+		return true;
+	if (xrun->curr >= xrun->nitems)
+		return false;
+	for (i=0; i < gss->num_keys; i++)
+	{
+		comp = ApplySortComparator(xrun->values[i], xrun->isnull[i],
+								   yrun->values[i], yrun->isnull[i],
+								   &gss->sort_keys[i]);
+		if (comp != 0)
+			return (comp < 0);
+	}
+	/* keep the order of the runs for stability */
+	return (x < y);
+}
+
+/*
+ * gpusort_cpu_sort_run - sort a chunk by CPU, if GPU kernel gave up
+ */
+typedef struct
+{
+	cl_uint		index;
+	Datum	   *values;
+	bool	   *isnull;
+} GpuSortCpuItem;
+
+static int
+gpusort_cpu_comparator(const void *a, const void *b, void *arg)
+{
+	const GpuSortCpuItem *x = a;
+	const GpuSortCpuItem *y = b;
+	GpuSortState *gss = arg;
+	int			i, comp;
+
+	for (i=0; i < gss->num_keys; i++)
+	{
+		comp = ApplySortComparator(x->values[i], x->isnull[i],
+								   y->values[i], y->isnull[i],
+								   &gss->sort_keys[i]);
+		if (comp != 0)
+			return comp;
+	}
+	return 0;
+}
+
+/*
+ * gpusort_cpu_heap_push / gpusort_cpu_heap_replace
+ *
+ * Bounded heap to keep the best items; the worst item is on the top.
+ */
+static void
+gpusort_cpu_heap_push(GpuSortState *gss, GpuSortCpuItem *heap, cl_uint nitems)
+{
+	GpuSortCpuItem	item = heap[nitems];
+	cl_uint			curr = nitems;
+	cl_uint			parent;
+
+	while (curr > 0)
+	{
+		parent = (curr - 1) / 2;
+		if (gpusort_cpu_comparator(&item, &heap[parent], gss) <= 0)
+			break;
+		heap[curr] = heap[parent];
+		curr = parent;
+	}
+	heap[curr] = item;
+}
+
+static void
+gpusort_cpu_heap_replace(GpuSortState *gss, GpuSortCpuItem *heap,
+						 cl_uint nitems, GpuSortCpuItem *item)
+{
+	cl_uint		curr = 0;
+	cl_uint		child;
+
+	for (;;)
+	{
+		child = 2 * curr + 1;
+		if (child >= nitems)
+			break;
+		if (child + 1 < nitems &&
+			gpusort_cpu_comparator(&heap[child + 1], &heap[child], gss) > 0)
+			child++;
+		if (gpusort_cpu_comparator(item, &heap[child], gss) >= 0)
+			break;
+		heap[curr] = heap[child];
+		curr = child;
+	}
+	heap[curr] = *item;
+}
+
+/*
+ * gpusort_cpu_sort_run
+ *
+ * It returns the number of rows in the sorted run; it may be less than the
+ * number of rows in the chunk, if top-k.
+ */
+static cl_uint
+gpusort_cpu_sort_run(GpuSortState *gss, GpuSortTask *gsort)
+{
+	kern_data_store *kds = &gsort->pds_src->kds;
+	TupleDesc	tupdesc = gss->gts.css.ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+	cl_uint	   *results = KERN_GPUSORT_RESULT_INDEX(&gsort->kern);
+	cl_uint		nitems = gsort->kern.nitems;
+	GpuSortCpuItem *items;
+	Datum	   *values;
+	bool	   *isnull;
+	HeapTupleData tuple;
+	cl_uint		i;
+	int			j;
+
+	if (nitems == 0)
+		return 0;
+	items = palloc(sizeof(GpuSortCpuItem) * nitems);
+	values = palloc(sizeof(Datum) * gss->num_keys * nitems);
+	isnull = palloc(sizeof(bool) * gss->num_keys * nitems);
+	for (i=0; i < nitems; i++)
+	{
+		tuple.t_data = KDS_ROW_REF_HTUP(kds,
+										KERN_DATA_STORE_ROWINDEX(kds)[i],
+										&tuple.t_self,
+										&tuple.t_len);
+		items[i].index = i;
+		items[i].values = values + gss->num_keys * i;
+		items[i].isnull = isnull + gss->num_keys * i;
+		for (j=0; j < gss->num_keys; j++)
+		{
+			items[i].values[j] = heap_getattr(&tuple,
+											  gss->sort_attnums[j],
+											  tupdesc,
+											  &items[i].isnull[j]);
+		}
+	}
+	/* keep the best @bound items only, if top-k */
+	if (gsort->bound < nitems)
+	{
+		cl_uint		nkeep = 0;
+
+		for (i=0; i < nitems; i++)
+		{
+			if (nkeep < gsort->bound)
+			{
+				Assert(nkeep == i);
+				gpusort_cpu_heap_push(gss, items, nkeep++);
+			}
+			else if (gpusort_cpu_comparator(&items[i], &items[0], gss) < 0)
+				gpusort_cpu_heap_replace(gss, items, nkeep, &items[i]);
+		}
+		nitems = nkeep;
+	}
+	qsort_arg(items, nitems, sizeof(GpuSortCpuItem),
+			  gpusort_cpu_comparator, gss);
+	for (i=0; i < nitems; i++)
+		results[i] = items[i].index;
+
+	pfree(items);
+	pfree(values);
+	pfree(isnull);
+
+	return nitems;
+}
+
+/*
+ * gpusort_build_losertree - build a loser tree from the @node recursively
+ *
+ * The internal nodes are 1..(k-1), and the leaf nodes are k..(2k-1) that
+ * correspond to the runs. It returns the winner of the sub-tree.
+ */
+static cl_int
+gpusort_build_losertree(GpuSortState *gss, cl_int node)
+{
+	cl_int		k = gss->num_runs;
+	cl_int		lwin, rwin;
+
+	if (node >= k)
+		return node - k;
+	lwin = gpusort_build_losertree(gss, 2 * node);
+	rwin = gpusort_build_losertree(gss, 2 * node + 1);
+	if (gpusort_run_precedes(gss, rwin, lwin))
+	{
+		gss->losertree[node] = lwin;
+		return rwin;
+	}
+	gss->losertree[node] = rwin;
+	return lwin;
+}
+
+/*
+ * gpusort_spill_runs
+ *
+ * It moves rows of the retained runs to tuplesort, then releases the chunks.
+ * Once sorted runs exceed work_mem, tuplesort takes over the rest of sorting
+ * and may spill out the rows to temporary files, like a regular Sort.
+ */
+static void
+gpusort_spill_runs(GpuSortState *gss)
+{
+	TupleTableSlot *slot = gss->gts.css.ss.ss_ScanTupleSlot;
+	cl_int		i;
+	cl_uint		j;
+
+	if (!gss->tuplesort)
+	{
+		gss->tuplesort = tuplesort_begin_heap(slot->tts_tupleDescriptor,
+											  gss->num_keys,
+											  gss->sort_attnums,
+											  gss->sort_ops,
+											  gss->sort_collations,
+											  gss->sort_nulls_first,
+											  work_mem,
+											  NULL,
+											  false);
+		if (gss->bound > 0)
+			tuplesort_set_bound(gss->tuplesort, gss->bound);
+		gss->used_tuplesort = true;
+		/*
+		 * The bound key refers a retained run; tuplesort applies its own
+		 * bounded heap instead.
+		 */
+		gss->bound_run = -1;
+	}
+
+	for (i=0; i < gss->num_runs; i++)
+	{
+		GpuSortRun *run = &gss->runs[i];
+
+		for (j=0; j < run->nitems; j++)
+		{
+			gpusort_fetch_run_row(gss, run, j);
+			gss->scan_tuple = run->tuple;
+			ExecStoreTuple(&gss->scan_tuple, slot, InvalidBuffer, false);
+			tuplesort_puttupleslot(gss->tuplesort, slot);
+		}
+		ExecClearTuple(slot);
+		gpusort_release_task(&run->gsort->task);
+		pfree(run->values);
+		pfree(run->isnull);
+	}
+	gss->num_runs = 0;
+	gss->runs_usage = 0;
+}
+
+/*
+ * gpusort_build_runs
+ *
+ * It collects all the sorted chunks, then set up the loser tree for k-way
+ * merge on CPU. If sorted runs exceed work_mem, tuplesort merges them.
+ */
+static void
+gpusort_build_runs(GpuSortState *gss)
+{
+	MemoryContext	memcxt = gss->gts.css.ss.ps.state->es_query_cxt;
+	GpuTask		   *gtask;
+	GpuSortRun	   *run;
+	cl_int			i;
+
+	while ((gtask = fetch_next_gputask(&gss->gts)) != NULL)
+	{
+		GpuSortTask	   *gsort = (GpuSortTask *) gtask;
+		kern_data_store *kds;
+
+		if (gss->num_runs == gss->max_runs)
+		{
+			gss->max_runs = Max(2 * gss->max_runs, 32);
+			if (!gss->runs)
+				gss->runs = MemoryContextAlloc(memcxt, sizeof(GpuSortRun) *
+											   gss->max_runs);
+			else
+				gss->runs = repalloc(gss->runs, sizeof(GpuSortRun) *
+									 gss->max_runs);
+		}
+		run = &gss->runs[gss->num_runs++];
+		memset(run, 0, sizeof(GpuSortRun));
+		run->gsort = gsort;
+		run->results = KERN_GPUSORT_RESULT_INDEX(&gsort->kern);
+		run->curr = 0;
+		run->values = MemoryContextAlloc(memcxt, sizeof(Datum) *
+										 Max(gss->num_keys, 1));
+		run->isnull = MemoryContextAlloc(memcxt, sizeof(bool) *
+										 Max(gss->num_keys, 1));
+		if (gtask->cpu_fallback)
+		{
+			run->nitems = gpusort_cpu_sort_run(gss, gsort);
+			gss->gts.num_cpu_fallbacks++;
+			gss->num_runs_cpu++;
+		}
+		else
+		{
+			run->nitems = gsort->bound;
+			gss->num_runs_gpu++;
+		}
+		/* tighten the bound key for the later chunks, if top-k */
+		if (gss->bound > 0 && run->nitems >= gss->bound &&
+			!gss->tuplesort)
+			gpusort_update_bound(gss, gss->num_runs - 1);
+
+		/*
+		 * Retained runs must not consume more than work_mem, except for
+		 * a single run which can be returned as is.
+		 */
+		kds = &gsort->pds_src->kds;
+		gss->runs_usage +=
+			KDS_CALCULATE_ROW_LENGTH(kds->ncols,
+									 kds->nitems,
+									 __kds_unpack(kds->usage)) +
+			sizeof(cl_uint) * kds->nitems;
+		if (gss->tuplesort ||
+			(gss->num_runs > 1 &&
+			 gss->runs_usage > (Size) work_mem * 1024L))
+			gpusort_spill_runs(gss);
+	}
+
+	if (gss->tuplesort)
+	{
+		tuplesort_performsort(gss->tuplesort);
+		gss->sort_done = true;
+		return;
+	}
+
+	/* setup the head of runs, and the loser tree */
+	for (i=0; i < gss->num_runs; i++)
+		gpusort_fetch_run_head(gss, &gss->runs[i]);
+	gss->losertree = MemoryContextAllocZero(memcxt, sizeof(cl_int) *
+											Max(gss->num_runs, 1));
+	if (gss->num_runs > 0)
+		gss->losertree[0] = gpusort_build_losertree(gss, 1);
+	gss->last_winner = -1;
+	gss->sort_done = true;
+}
+
+/*
+ * gpusort_release_runs
+ */
+static void
+gpusort_release_runs(GpuSortState *gss)
+{
+	cl_int		i;
+
+	for (i=0; i < gss->num_runs; i++)
+	{
+		GpuSortRun *run = &gss->runs[i];
+
+		gpusort_release_task(&run->gsort->task);
+		if (run->values)
+			pfree(run->values);
+		if (run->isnull)
+			pfree(run->isnull);
+	}
+	if (gss->runs)
+		pfree(gss->runs);
+	if (gss->losertree)
+		pfree(gss->losertree);
+	if (gss->tuplesort)
+		tuplesort_end(gss->tuplesort);
+	gss->runs = NULL;
+	gss->num_runs = 0;
+	gss->max_runs = 0;
+	gss->losertree = NULL;
+	gss->last_winner = -1;
+	gss->runs_usage = 0;
+	gss->tuplesort = NULL;
+	gss->bound_run = -1;
+	gss->sort_done = false;
+}
+
+/*
+ * gpusort_next_tuple - returns the next tuple by k-way merge
+ */
+static TupleTableSlot *
+gpusort_next_tuple(GpuSortState *gss)
+{
+	TupleTableSlot *slot = gss->gts.css.ss.ss_ScanTupleSlot;
+	GpuSortRun	   *run;
+	cl_int			winner;
+	cl_int			node;
+	cl_int			temp;
+
+	if (!gss->sort_done)
+		gpusort_build_runs(gss);
+	if (gss->tuplesort)
+	{
+		if (!tuplesort_gettupleslot(gss->tuplesort, true, false, slot, NULL))
+			return NULL;
+		return slot;
+	}
+	if (gss->num_runs == 0)
+		return NULL;
+
+	/* move forward the run of the last winner, then replay the games */
+	if (gss->last_winner >= 0)
+	{
+		winner = gss->last_winner;
+		run = &gss->runs[winner];
+		run->curr++;
+		gpusort_fetch_run_head(gss, run);
+		for (node = (winner + gss->num_runs) / 2; node > 0; node /= 2)
+		{
+			temp = gss->losertree[node];
+			if (gpusort_run_precedes(gss, temp, winner))
+			{
+				gss->losertree[node] = winner;
+				winner = temp;
+			}
+		}
+		gss->losertree[0] = winner;
+	}
+	winner = gss->losertree[0];
+	run = &gss->runs[winner];
+	if (run->curr >= run->nitems)
+	{
+		/* all the runs are exhausted */
+		gss->last_winner = -1;
+		return NULL;
+	}
+	gss->last_winner = winner;
+	gss->scan_tuple = run->tuple;
+	ExecStoreTuple(&gss->scan_tuple, slot, InvalidBuffer, false);
+
+	return slot;
+}
+
+/*
+ * ExecReCheckGpuSort
+ */
+static bool
+ExecReCheckGpuSort(CustomScanState *node, TupleTableSlot *slot)
+{
+	/*
+	 * GpuSort shall be never located under the LockRows, so we don't
+	 * expect that we need to have valid EPQ recheck here.
+	 */
+	return true;
+}
+
+/*
+ * ExecGpuSort
+ */
+static TupleTableSlot *
+ExecGpuSort(CustomScanState *node)
+{
+	GpuSortState   *gss = (GpuSortState *) node;
+
+	ActivateGpuContext(gss->gts.gcontext);
+	return ExecScan(&node->ss,
+					(ExecScanAccessMtd) gpusort_next_tuple,
+					(ExecScanRecheckMtd) ExecReCheckGpuSort);
+}
+
+/*
+ * ExecEndGpuSort
+ */
+static void
+ExecEndGpuSort(CustomScanState *node)
+{
+	GpuSortState   *gss = (GpuSortState *) node;
+
+	/* wait for completion of any asynchronous GpuTask */
+	SynchronizeGpuContext(gss->gts.gcontext);
+	/* release sorted runs */
+	gpusort_release_runs(gss);
+	/* clean up subtree */
+	ExecEndNode(outerPlanState(node));
+	/* release any other resources */
+	pgstromReleaseGpuTaskState(&gss->gts, NULL);
+}
+
+/*
+ * ExecReScanGpuSort
+ */
+static void
+ExecReScanGpuSort(CustomScanState *node)
+{
+	GpuSortState   *gss = (GpuSortState *) node;
+
+	/* wait for completion of any asynchronous GpuTask */
+	SynchronizeGpuContext(gss->gts.gcontext);
+	/* release sorted runs */
+	gpusort_release_runs(gss);
+	/* also rescan subtree */
+	ExecReScan(outerPlanState(node));
+	/* common rescan handling */
+	pgstromRescanGpuTaskState(&gss->gts);
+	gss->gts.scan_done = false;
+	gss->gts.scan_overflow = NULL;
+	ExecScanReScan(&gss->gts.css.ss);
+}
+
+/*
+ * ExplainGpuSort
+ */
+static void
+ExplainGpuSort(CustomScanState *node, List *ancestors, ExplainState *es)
+{
+	GpuSortState   *gss = (GpuSortState *) node;
+	CustomScan	   *cscan = (CustomScan *) node->ss.ps.plan;
+	GpuSortInfo	   *gs_info = deform_gpusort_info(cscan);
+	List		   *dcontext;
+	List		   *sort_keys = NIL;
+	ListCell	   *lc1, *lc2, *lc3, *lc4;
+
+	/* Set up deparsing context */
+	dcontext = set_deparse_context_planstate(es->deparse_cxt,
+											 (Node *)&gss->gts.css.ss.ps,
+											 ancestors);
+	/* Show sort keys */
+	forfour (lc1, gs_info->sort_keys,
+			 lc2, gs_info->sort_ops,
+			 lc3, gs_info->sort_collations,
+			 lc4, gs_info->sort_nulls_first)
+	{
+		TargetEntry	   *tle = list_nth(cscan->custom_scan_tlist,
+									   lfirst_int(lc1) - 1);
+		Oid				sortop = lfirst_oid(lc2);
+		Oid				collid = lfirst_oid(lc3);
+		bool			nulls_first = (lfirst_int(lc4) != 0);
+		bool			reverse = false;
+		StringInfoData	buf;
+
+		initStringInfo(&buf);
+		appendStringInfoString(&buf,
+							   deparse_expression((Node *) tle->expr,
+												  dcontext,
+												  es->verbose,
+												  false));
+		if (OidIsValid(collid) &&
+			collid != exprCollation((Node *) tle->expr))
+			appendStringInfo(&buf, " COLLATE %s",
+							 quote_identifier(get_collation_name(collid)));
+		if (!OidIsValid(get_equality_op_for_ordering_op(sortop, &reverse)))
+			elog(ERROR, "operator %u is not a valid ordering operator",
+				 sortop);
+		if (reverse)
+			appendStringInfoString(&buf, " DESC");
+		if (nulls_first != reverse)
+			appendStringInfoString(&buf, nulls_first
+								   ? " NULLS FIRST"
+								   : " NULLS LAST");
+		sort_keys = lappend(sort_keys, buf.data);
+	}
+	ExplainPropertyList("Sort Key", sort_keys, es);
+
+	/* Show number of sorted runs */
+	if (es->analyze)
+	{
+		ExplainPropertyInteger("Sorted Runs by GPU", NULL,
+							   gss->num_runs_gpu, es);
+		ExplainPropertyInteger("Sorted Runs by CPU", NULL,
+							   gss->num_runs_cpu, es);
+		ExplainPropertyText("Merge Method",
+							gss->used_tuplesort
+							? "tuplesort (runs exceeded work_mem)"
+							: "k-way merge", es);
+	}
+	/* Show top-k bound, if any */
+	if (gss->bound > 0)
+	{
+		ExplainPropertyInteger("Top-K Bound", NULL, gss->bound, es);
+		if (es->analyze)
+			ExplainPropertyInteger("Rows Removed by Top-K Bound", NULL,
+								   gss->num_rows_bounded, es);
+	}
+	/* other common fields */
+	pgstromExplainGpuTaskState(&gss->gts, es);
+}
+
+/*
+ * pgstrom_init_gpusort
+ */
+void
+pgstrom_init_gpusort(void)
+{
+	/* pg_strom.enable_gpusort */
+	DefineCustomBoolVariable("pg_strom.enable_gpusort",
+							 "Enables the use of GPU accelerated sorting",
+							 NULL,
+							 &enable_gpusort,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+
+	/* initialization of path method table */
+	memset(&gpusort_path_methods, 0, sizeof(CustomPathMethods));
+	gpusort_path_methods.CustomName			= "GpuSort";
+	gpusort_path_methods.PlanCustomPath		= PlanGpuSortPath;
+
+	/* initialization of plan method table */
+	memset(&gpusort_scan_methods, 0, sizeof(CustomScanMethods));
+	gpusort_scan_methods.CustomName			= "GpuSort";
+	gpusort_scan_methods.CreateCustomScanState = CreateGpuSortScanState;
+	RegisterCustomScanMethods(&gpusort_scan_methods);
+
+	/* initialization of exec method table */
+	memset(&gpusort_exec_methods, 0, sizeof(CustomExecMethods));
+	gpusort_exec_methods.CustomName			= "GpuSort";
+	gpusort_exec_methods.BeginCustomScan	= ExecInitGpuSort;
+	gpusort_exec_methods.ExecCustomScan		= ExecGpuSort;
+	gpusort_exec_methods.EndCustomScan		= ExecEndGpuSort;
+	gpusort_exec_methods.ReScanCustomScan	= ExecReScanGpuSort;
+	gpusort_exec_methods.ExplainCustomScan	= ExplainGpuSort;
+
+	/* hook registration */
+	create_upper_paths_next = create_upper_paths_hook;
+	create_upper_paths_hook = gpusort_add_ordered_paths;
+}
@@ -94,6 +94,40 @@ struct GpuStoreBuffer
 	MVCCAttrs  *gs_mvcc;		/* MVCC attributes */
 };
 
+/*
+ * GpuStoreCheckpointHead - header of the checkpoint file
+ *
+ * A checkpoint file keeps the read-only image of the latest committed
+ * chunk as is, next to this header. So, it can be bulk-loaded on the
+ * first reference after the restart, without per-row decoding.
+ */
+#define GSTORE_CHECKPOINT_DIR		"pg_strom_gstore"
+#define GSTORE_CHECKPOINT_MAGIC		"GSTORE01"
+#define GSTORE_CHECKPOINT_VERSION	1
+
+typedef struct
+{
+	char			magic[8];		/* GSTORE_CHECKPOINT_MAGIC */
+	cl_uint			version;		/* GSTORE_CHECKPOINT_VERSION */
+	Oid				database_oid;
+	Oid				table_oid;
+	cl_int			format;			/* one of GSTORE_FDW_FORMAT__* */
+	size_t			rawsize;		/* length of the image */
+	size_t			nitems;
+	pg_crc32c		image_crc;		/* CRC32C of the image */
+} GpuStoreCheckpointHead;
+#define GSTORE_CHECKPOINT_HEAD_SZ	MAXALIGN(sizeof(GpuStoreCheckpointHead))
+
+/*
+ * GpuStoreCheckpointPending - file operation to be done on commit
+ */
+typedef struct
+{
+	bool		is_unlink;		/* true, if file_path shall be removed */
+	char		temp_path[MAXPGPATH];
+	char		file_path[MAXPGPATH];
+} GpuStoreCheckpointPending;
+
 /*
  * vl_dict_key - dictionary of varlena datum
  */
@@ -105,6 +139,8 @@ typedef struct
 
 /* static variables */
 static int				gstore_max_relations;	/* GUC */
+static bool				gstore_checkpoint_enabled;	/* GUC */
+static List			   *gstore_checkpoint_pending = NIL;
 static object_access_hook_type object_access_next;
 static shmem_startup_hook_type shmem_startup_next;
 static GpuStoreHead	   *gstore_head = NULL;
@@ -117,6 +153,7 @@ Datum pgstrom_gstore_fdw_nitems(PG_FUNCTION_ARGS);
 Datum pgstrom_gstore_fdw_nattrs(PG_FUNCTION_ARGS);
 Datum pgstrom_gstore_fdw_rawsize(PG_FUNCTION_ARGS);
 Datum pgstrom_gstore_export_ipchandle(PG_FUNCTION_ARGS);
+Datum pgstrom_gstore_fdw_checkpoint_validate(PG_FUNCTION_ARGS);
 
 /*
  * gstore_buf_chunk_visibility - equivalent to HeapTupleSatisfiesMVCC,
@@ -283,6 +320,461 @@ gstore_buf_chunk_hashvalue(Oid ftable_oid)
 	return hash;
 }
 
+/*
+ * gstore_checkpoint_filename - path of the checkpoint file, relative to
+ * the data directory.
+ */
+static void
+gstore_checkpoint_filename(char *fname, Oid database_oid, Oid table_oid)
+{
+	snprintf(fname, MAXPGPATH, "%s/%u_%u.kds",
+			 GSTORE_CHECKPOINT_DIR, database_oid, table_oid);
+}
+
+/*
+ * gstore_checkpoint_validate
+ *
+ * It checks whether the checkpoint image is consistent to the current
+ * definition of the gstore_fdw table. It touches only host memory, and
+ * returns a message if not valid, or NULL.
+ */
+static const char *
+gstore_checkpoint_validate(GpuStoreCheckpointHead *cp_head, size_t filesize,
+						   Oid table_oid, int format, TupleDesc tupdesc)
+{
+	kern_data_store *kds;
+	pg_crc32c	crc;
+	size_t		i;
+	int			j;
+
+	if (filesize < GSTORE_CHECKPOINT_HEAD_SZ ||
+		memcmp(cp_head->magic, GSTORE_CHECKPOINT_MAGIC,
+			   sizeof(cp_head->magic)) != 0)
+		return "wrong magic";
+	if (cp_head->version != GSTORE_CHECKPOINT_VERSION)
+		return "unsupported version";
+	if (cp_head->database_oid != MyDatabaseId ||
+		cp_head->table_oid != table_oid)
+		return "database or table mismatch";
+	if (cp_head->format != format ||
+		cp_head->format != GSTORE_FDW_FORMAT__PGSTROM)
+		return "format mismatch";
+	if (cp_head->rawsize != filesize - GSTORE_CHECKPOINT_HEAD_SZ ||
+		cp_head->rawsize < offsetof(kern_data_store, colmeta))
+		return "wrong image length";
+
+	kds = (kern_data_store *)((char *)cp_head + GSTORE_CHECKPOINT_HEAD_SZ);
+	if (kds->length != cp_head->rawsize ||
+		kds->format != KDS_FORMAT_COLUMN ||
+		kds->nitems != cp_head->nitems ||
+		kds->nitems > kds->nrooms)
+		return "corrupted kern_data_store header";
+	if (kds->ncols != tupdesc->natts ||
+		KERN_DATA_STORE_HEAD_LENGTH(kds) > kds->length)
+		return "number of columns mismatch";
+	for (j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = tupleDescAttr(tupdesc, j);
+		kern_colmeta   *cmeta = &kds->colmeta[j];
+		size_t			va_offset = __kds_unpack(cmeta->va_offset);
+		size_t			va_length = __kds_unpack(cmeta->va_length);
+
+		if (cmeta->atttypid != (cl_uint)attr->atttypid ||
+			cmeta->attlen != attr->attlen)
+			return "column definition mismatch";
+		/* considered as all-null */
+		if (va_offset == 0)
+			continue;
+		if (va_offset < KERN_DATA_STORE_HEAD_LENGTH(kds) ||
+			va_offset + va_length > kds->length)
+			return "column out of range";
+		if (cmeta->attlen > 0)
+		{
+			int		unitsz = TYPEALIGN(cmeta->attalign, cmeta->attlen);
+
+			if (va_length < MAXALIGN((size_t)unitsz * kds->nitems))
+				return "column too short";
+		}
+		else
+		{
+			/*
+			 * Offsets of varlena datum are relative to the head of the
+			 * column, and the datum must be within the column.
+			 */
+			char	   *base = (char *)kds + va_offset;
+			size_t		head_sz = MAXALIGN(sizeof(cl_uint) * kds->nitems);
+
+			if (va_length < head_sz)
+				return "column too short";
+			for (i=0; i < kds->nitems; i++)
+			{
+				size_t		offset = __kds_unpack(((cl_uint *)base)[i]);
+				char	   *vl;
+
+				if (offset == 0)
+					continue;		/* NULL */
+				if (offset < head_sz || offset >= va_length)
+					return "varlena out of range";
+				vl = base + offset;
+				if (VARATT_IS_1B_E(vl) ||
+					(!VARATT_IS_1B(vl) && offset + VARHDRSZ > va_length) ||
+					VARSIZE_ANY(vl) < VARHDRSZ_SHORT ||
+					offset + VARSIZE_ANY(vl) > va_length)
+					return "varlena out of range";
+			}
+		}
+	}
+	/* finally, check the entire image */
+	INIT_CRC32C(crc);
+	COMP_CRC32C(crc, kds, kds->length);
+	FIN_CRC32C(crc);
+	if (!EQ_CRC32C(crc, cp_head->image_crc))
+		return "checksum mismatch";
+
+	return NULL;
+}
+
+/*
+ * __gstore_checkpoint_write
+ */
+static bool
+__gstore_checkpoint_write(int fdesc, const char *buf, size_t len)
+{
+	ssize_t		nbytes;
+
+	while (len > 0)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		nbytes = write(fdesc, buf, len);
+		if (nbytes < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		buf += nbytes;
+		len -= nbytes;
+	}
+	return true;
+}
+
+/*
+ * gstore_checkpoint_dump
+ *
+ * It writes out the read-only image of the new chunk to a temporary file.
+ * It shall be renamed to the checkpoint file on commit, or removed on abort.
+ */
+static void
+gstore_checkpoint_dump(GpuStoreBuffer *gs_buffer,
+					   kern_data_store *kds, size_t nitems)
+{
+	GpuStoreCheckpointPending *cp_pend;
+	MemoryContext	oldcxt;
+	char		file_path[MAXPGPATH];
+	char		temp_path[MAXPGPATH];
+	union {
+		GpuStoreCheckpointHead h;
+		char		__data[GSTORE_CHECKPOINT_HEAD_SZ];
+	} cp_head;
+	int			fdesc;
+
+	gstore_checkpoint_filename(file_path,
+							   MyDatabaseId, gs_buffer->table_oid);
+	snprintf(temp_path, MAXPGPATH, "%s.tmp.%d", file_path, MyProcPid);
+
+	memset(&cp_head, 0, sizeof(cp_head));
+	memcpy(cp_head.h.magic, GSTORE_CHECKPOINT_MAGIC,
+		   sizeof(cp_head.h.magic));
+	cp_head.h.version = GSTORE_CHECKPOINT_VERSION;
+	cp_head.h.database_oid = MyDatabaseId;
+	cp_head.h.table_oid = gs_buffer->table_oid;
+	cp_head.h.format = gs_buffer->format;
+	cp_head.h.rawsize = kds->length;
+	cp_head.h.nitems = nitems;
+	INIT_CRC32C(cp_head.h.image_crc);
+	COMP_CRC32C(cp_head.h.image_crc, kds, kds->length);
+	FIN_CRC32C(cp_head.h.image_crc);
+
+	if (mkdir(GSTORE_CHECKPOINT_DIR, S_IRWXU) != 0 && errno != EEXIST)
+		elog(ERROR, "could not create directory \"%s\": %m",
+			 GSTORE_CHECKPOINT_DIR);
+	fdesc = open(temp_path,
+				 O_WRONLY | O_CREAT | O_TRUNC | PG_BINARY,
+				 S_IRUSR | S_IWUSR);
+	if (fdesc < 0)
+		elog(ERROR, "could not create file \"%s\": %m", temp_path);
+	if (!__gstore_checkpoint_write(fdesc, cp_head.__data,
+								   GSTORE_CHECKPOINT_HEAD_SZ) ||
+		!__gstore_checkpoint_write(fdesc, (char *)kds, kds->length) ||
+		pg_fsync(fdesc) != 0)
+	{
+		int		errno_saved = errno;
+
+		close(fdesc);
+		unlink(temp_path);
+		errno = errno_saved;
+		elog(ERROR, "could not write file \"%s\": %m", temp_path);
+	}
+	close(fdesc);
+
+	/* rename to the checkpoint file on commit */
+	PG_TRY();
+	{
+		cp_pend = MemoryContextAllocZero(TopMemoryContext,
+										 sizeof(GpuStoreCheckpointPending));
+		strcpy(cp_pend->temp_path, temp_path);
+		strcpy(cp_pend->file_path, file_path);
+		oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+		gstore_checkpoint_pending = lappend(gstore_checkpoint_pending,
+											cp_pend);
+		MemoryContextSwitchTo(oldcxt);
+	}
+	PG_CATCH();
+	{
+		unlink(temp_path);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+}
+
+/*
+ * gstore_checkpoint_remove
+ *
+ * It schedules removal of the checkpoint file on commit, because it is
+ * no longer the latest image of the table.
+ */
+static void
+gstore_checkpoint_remove(Oid table_oid)
+{
+	GpuStoreCheckpointPending *cp_pend;
+	MemoryContext	oldcxt;
+
+	cp_pend = MemoryContextAllocZero(TopMemoryContext,
+									 sizeof(GpuStoreCheckpointPending));
+	cp_pend->is_unlink = true;
+	gstore_checkpoint_filename(cp_pend->file_path,
+							   MyDatabaseId, table_oid);
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	gstore_checkpoint_pending = lappend(gstore_checkpoint_pending, cp_pend);
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * gstore_checkpoint_on_xact_end
+ */
+static void
+gstore_checkpoint_on_xact_end(bool is_commit)
+{
+	ListCell   *lc;
+
+	foreach (lc, gstore_checkpoint_pending)
+	{
+		GpuStoreCheckpointPending *cp_pend = lfirst(lc);
+
+		if (cp_pend->is_unlink)
+		{
+			if (is_commit &&
+				unlink(cp_pend->file_path) != 0 && errno != ENOENT)
+				elog(WARNING, "could not remove file \"%s\": %m",
+					 cp_pend->file_path);
+		}
+		else if (is_commit)
+			durable_rename(cp_pend->temp_path, cp_pend->file_path, WARNING);
+		else if (unlink(cp_pend->temp_path) != 0 && errno != ENOENT)
+			elog(WARNING, "could not remove file \"%s\": %m",
+				 cp_pend->temp_path);
+	}
+	list_free_deep(gstore_checkpoint_pending);
+	gstore_checkpoint_pending = NIL;
+}
+
+/*
+ * gstore_buf_restore_chunk
+ *
+ * It registers a GpuStoreChunk loaded from the checkpoint file. It is
+ * visible to everybody because the image was committed before the restart.
+ * Returns false if someone concurrently registered a chunk of the table.
+ */
+static bool
+gstore_buf_restore_chunk(Oid table_oid, cl_int pinning,
+						 GpuStoreCheckpointHead *cp_head,
+						 CUipcMemHandle ipc_mhandle,
+						 dsm_handle dsm_mhandle)
+{
+	GpuStoreChunk  *gs_chunk;
+	pg_crc32		hash = gstore_buf_chunk_hashvalue(table_oid);
+	int				index = hash % GSTORE_CHUNK_HASH_NSLOTS;
+	dlist_node	   *dnode;
+	dlist_iter		iter;
+
+	SpinLockAcquire(&gstore_head->lock);
+	dlist_foreach(iter, &gstore_head->active_chunks[index])
+	{
+		GpuStoreChunk  *gs_temp = dlist_container(GpuStoreChunk,
+												  chain, iter.cur);
+		if (gs_temp->hash == hash &&
+			gs_temp->database_oid == MyDatabaseId &&
+			gs_temp->table_oid == table_oid)
+		{
+			SpinLockRelease(&gstore_head->lock);
+			return false;
+		}
+	}
+	if (dlist_is_empty(&gstore_head->free_chunks))
+	{
+		SpinLockRelease(&gstore_head->lock);
+		elog(ERROR, "gstore_fdw: out of GpuStoreChunk strucure");
+	}
+	dnode = dlist_pop_head_node(&gstore_head->free_chunks);
+	gs_chunk = dlist_container(GpuStoreChunk, chain, dnode);
+
+	gs_chunk->revision
+		= pg_atomic_add_fetch_u32(&gstore_head->revision_seed, 1);
+	gs_chunk->hash = hash;
+	gs_chunk->database_oid = MyDatabaseId;
+	gs_chunk->table_oid = table_oid;
+	gs_chunk->xmax = InvalidTransactionId;
+	gs_chunk->xmin = FrozenTransactionId;
+	gs_chunk->xmax_committed = false;
+	gs_chunk->xmin_committed = true;
+	gs_chunk->pinning = pinning;
+	gs_chunk->format = cp_head->format;
+	gs_chunk->rawsize = cp_head->rawsize;
+	gs_chunk->nitems = cp_head->nitems;
+	gs_chunk->ipc_mhandle = ipc_mhandle;
+	gs_chunk->dsm_mhandle = dsm_mhandle;
+	dlist_push_head(&gstore_head->active_chunks[index],
+					&gs_chunk->chain);
+	SpinLockRelease(&gstore_head->lock);
+
+	return true;
+}
+
+/*
+ * gstore_checkpoint_restore
+ *
+ * It bulk-loads the checkpoint image of the gstore_fdw table, if any,
+ * onto the preserved device memory. Broken or stale images are removed.
+ */
+static bool
+gstore_checkpoint_restore(Oid table_oid)
+{
+	char		fname[MAXPGPATH];
+	int			fdesc;
+	struct stat	st_buf;
+	GpuStoreCheckpointHead *cp_head;
+	bool		retval = false;
+
+	if (!gstore_checkpoint_enabled)
+		return false;
+
+	gstore_checkpoint_filename(fname, MyDatabaseId, table_oid);
+	fdesc = open(fname, O_RDONLY | PG_BINARY);
+	if (fdesc < 0)
+	{
+		if (errno == ENOENT)
+			return false;
+		elog(ERROR, "failed on open('%s'): %m", fname);
+	}
+	if (fstat(fdesc, &st_buf) != 0)
+	{
+		close(fdesc);
+		elog(ERROR, "failed on fstat('%s'): %m", fname);
+	}
+	if (st_buf.st_size < GSTORE_CHECKPOINT_HEAD_SZ)
+	{
+		close(fdesc);
+		elog(LOG, "gstore_fdw: checkpoint file \"%s\" is too short, removed",
+			 fname);
+		unlink(fname);
+		return false;
+	}
+	cp_head = mmap(NULL, st_buf.st_size, PROT_READ, MAP_SHARED, fdesc, 0);
+	if (cp_head == MAP_FAILED)
+	{
+		close(fdesc);
+		elog(ERROR, "failed on mmap('%s'): %m", fname);
+	}
+	close(fdesc);
+
+	PG_TRY();
+	{
+		TupleDesc	tupdesc;
+		const char *errmsg;
+		int			pinning;
+		int			format;
+
+		gstore_fdw_table_options(table_oid, &pinning, &format);
+		tupdesc = lookup_rowtype_tupdesc(get_rel_type_id(table_oid), -1);
+		errmsg = gstore_checkpoint_validate(cp_head, st_buf.st_size,
+											table_oid, format, tupdesc);
+		ReleaseTupleDesc(tupdesc);
+		if (errmsg)
+		{
+			elog(LOG, "gstore_fdw: checkpoint file \"%s\" is not valid (%s), removed",
+				 fname, errmsg);
+			unlink(fname);
+		}
+		else
+		{
+			CUresult		rc;
+			CUipcMemHandle	ipc_mhandle;
+			dsm_handle		dsm_mhandle;
+
+			rc = gpuMemAllocPreserved(pinning,
+									  &ipc_mhandle,
+									  &dsm_mhandle,
+									  cp_head->rawsize);
+			if (rc != CUDA_SUCCESS)
+				elog(ERROR, "failed on gpuMemAllocPreserved: %s",
+					 errorText(rc));
+			PG_TRY();
+			{
+				dsm_segment *h_seg = dsm_attach(dsm_mhandle);
+
+				/* bulk-load, no per-row decoding */
+				memcpy(dsm_segment_address(h_seg),
+					   (char *)cp_head + GSTORE_CHECKPOINT_HEAD_SZ,
+					   cp_head->rawsize);
+				dsm_detach(h_seg);
+				rc = gpuMemLoadPreserved(pinning, ipc_mhandle);
+				if (rc != CUDA_SUCCESS)
+					elog(ERROR, "failed on gpuMemLoadPreserved: %s",
+						 errorText(rc));
+				retval = gstore_buf_restore_chunk(table_oid, pinning,
+												  cp_head,
+												  ipc_mhandle,
+												  dsm_mhandle);
+				if (!retval)
+				{
+					/* someone already restored or inserted */
+					gpuMemFreePreserved(pinning, ipc_mhandle);
+					retval = true;
+				}
+				else
+					elog(DEBUG1, "gstore_fdw: restored %zu rows of \"%s\" from checkpoint",
+						 cp_head->nitems, get_rel_name(table_oid));
+			}
+			PG_CATCH();
+			{
+				gpuMemFreePreserved(pinning, ipc_mhandle);
+				PG_RE_THROW();
+			}
+			PG_END_TRY();
+		}
+	}
+	PG_CATCH();
+	{
+		munmap(cp_head, st_buf.st_size);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	munmap(cp_head, st_buf.st_size);
+
+	return retval;
+}
+
 /*
  * gstore_buf_lookup_chunk
  */
@@ -290,7 +782,10 @@ static GpuStoreChunk *
 gstore_buf_lookup_chunk(Oid ftable_oid, Snapshot snapshot)
 {
 	GpuStoreChunk  *gs_chunk = NULL;
+	bool			has_any_chunk = false;
+	bool			try_restore = true;
 
+retry:
 	SpinLockAcquire(&gstore_head->lock);
 	PG_TRY();
 	{
@@ -304,9 +799,11 @@ gstore_buf_lookup_chunk(Oid ftable_oid, Snapshot snapshot)
 													  chain, iter.cur);
 			if (gs_temp->hash == hash &&
 				gs_temp->database_oid == MyDatabaseId &&
-				gs_temp->table_oid == ftable_oid &&
-				gstore_buf_chunk_visibility(gs_temp, snapshot))
+				gs_temp->table_oid == ftable_oid)
 			{
+				has_any_chunk = true;
+				if (!gstore_buf_chunk_visibility(gs_temp, snapshot))
+					continue;
 				if (!gs_chunk)
 					gs_chunk = gs_temp;
 				else
@@ -322,6 +819,17 @@ gstore_buf_lookup_chunk(Oid ftable_oid, Snapshot snapshot)
 	PG_END_TRY();
 	SpinLockRelease(&gstore_head->lock);
 
+	/*
+	 * No chunk of the table at all; it may be the first reference after
+	 * the restart, so try to restore the chunk from the checkpoint file.
+	 */
+	if (!has_any_chunk && try_restore)
+	{
+		try_restore = false;
+		if (gstore_checkpoint_restore(ftable_oid))
+			goto retry;
+	}
+
 	return gs_chunk;
 }
 
@@ -1571,6 +2079,8 @@ gstoreXactCallbackOnPreCommit(void)
 			}
 			pg_atomic_add_fetch_u32(&gstore_head->has_warm_chunks, 1);
 			SpinLockRelease(&gstore_head->lock);
+			/* checkpoint file is no longer valid */
+			gstore_checkpoint_remove(gstore_oid);
 			/* also remove the buffer */
 			MemoryContextDelete(gs_buffer->memcxt);
 			hash_search(gstore_buffer_htab,
@@ -1604,6 +2114,11 @@ gstoreXactCallbackOnPreCommit(void)
 										RelationGetDescr(frel),
 										rowmap, nrooms);
 				Assert(kds->length == rawsize);
+				/* write out the image for the restart, if required */
+				if (gstore_checkpoint_enabled)
+					gstore_checkpoint_dump(gs_buffer, kds, nrooms);
+				else
+					gstore_checkpoint_remove(gs_buffer->table_oid);
 			}
 			else
 				elog(ERROR, "Gstore_Fdw: unknown format %d",
@@ -1752,6 +2267,9 @@ gstoreXactCallback(XactEvent event, void *arg)
 			/* do nothing */
 			return;
 	}
+	/* rename or remove the checkpoint files */
+	if (gstore_checkpoint_pending != NIL)
+		gstore_checkpoint_on_xact_end(is_commit);
 #if 0
 	elog(INFO, "gstoreXactCallback xid=%u (oldestXmin=%u)",
 		 GetCurrentTransactionIdIfAny(), oldestXmin);
@@ -1862,6 +2380,8 @@ gstore_fdw_post_drop(Oid relid, AttrNumber attnum)
 	}
 	pg_atomic_add_fetch_u32(&gstore_head->has_warm_chunks, 1);
 	SpinLockRelease(&gstore_head->lock);
+	/* also remove the checkpoint file on commit */
+	gstore_checkpoint_remove(relid);
 }
 
 /*
@@ -1933,6 +2453,8 @@ gstore_fdw_object_access(ObjectAccessType access,
 static void
 pgstrom_startup_gstore_buf(void)
 {
+	DIR		   *dir;
+	struct dirent *dent;
 	bool		found;
 	int			i;
 
@@ -1957,6 +2479,28 @@ pgstrom_startup_gstore_buf(void)
 		memset(gs_chunk, 0, sizeof(GpuStoreChunk));
 		dlist_push_tail(&gstore_head->free_chunks, &gs_chunk->chain);
 	}
+
+	/*
+	 * cleanup temporary checkpoint files by the crashed transactions.
+	 * Valid checkpoint files are restored on the first reference, because
+	 * catalog access and GPU memory keeper are not available here.
+	 */
+	dir = AllocateDir(GSTORE_CHECKPOINT_DIR);
+	if (dir)
+	{
+		while ((dent = ReadDir(dir, GSTORE_CHECKPOINT_DIR)) != NULL)
+		{
+			char	path[MAXPGPATH];
+
+			if (!strstr(dent->d_name, ".tmp."))
+				continue;
+			snprintf(path, MAXPGPATH, "%s/%s",
+					 GSTORE_CHECKPOINT_DIR, dent->d_name);
+			if (unlink(path) != 0)
+				elog(LOG, "could not remove file \"%s\": %m", path);
+		}
+		FreeDir(dir);
+	}
 }
 
 /*
@@ -1977,6 +2521,14 @@ pgstrom_init_gstore_buf(void)
 							PGC_POSTMASTER,
 							GUC_NOT_IN_SAMPLE,
 							NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.gstore_checkpoint",
+							 "Enables checkpoint/restore of gstore_fdw",
+							 NULL,
+							 &gstore_checkpoint_enabled,
+							 false,
+							 PGC_SUSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	required = offsetof(GpuStoreHead, gs_chunks[gstore_max_relations]);
 	RequestAddinShmemSpace(MAXALIGN(required));
 
@@ -2241,3 +2793,44 @@ pgstrom_gstore_export_ipchandle(PG_FUNCTION_ARGS)
 	PG_RETURN_POINTER(handle);
 }
 PG_FUNCTION_INFO_V1(pgstrom_gstore_export_ipchandle);
+
+/*
+ * pgstrom_gstore_fdw_checkpoint_validate
+ *
+ * It applies the same validation as restore doing to the supplied image
+ * of checkpoint file, then returns the reason if not valid, or NULL.
+ */
+Datum
+pgstrom_gstore_fdw_checkpoint_validate(PG_FUNCTION_ARGS)
+{
+	Oid			ftable_oid = PG_GETARG_OID(0);
+	bytea	   *image = PG_GETARG_BYTEA_P(1);
+	size_t		length = VARSIZE(image) - VARHDRSZ;
+	GpuStoreCheckpointHead *cp_head;
+	TupleDesc	tupdesc;
+	const char *reason;
+	int			format;
+
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 (errmsg("only superuser can validate the checkpoint image"))));
+	if (!relation_is_gstore_fdw(ftable_oid))
+		elog(ERROR, "relation %u is not gstore_fdw foreign table",
+			 ftable_oid);
+	/* image must be aligned as if it is mapped */
+	cp_head = palloc0(Max(length, GSTORE_CHECKPOINT_HEAD_SZ));
+	memcpy(cp_head, VARDATA(image), length);
+
+	gstore_fdw_table_options(ftable_oid, NULL, &format);
+	tupdesc = lookup_rowtype_tupdesc(get_rel_type_id(ftable_oid), -1);
+	reason = gstore_checkpoint_validate(cp_head, length,
+										ftable_oid, format, tupdesc);
+	ReleaseTupleDesc(tupdesc);
+	pfree(cp_head);
+
+	if (!reason)
+		PG_RETURN_NULL();
+	PG_RETURN_TEXT_P(cstring_to_text(reason));
+}
+PG_FUNCTION_INFO_V1(pgstrom_gstore_fdw_checkpoint_validate);
@@ -247,7 +247,7 @@ gstoreCreateForeignPath(PlannerInfo *root,
 {
 	ForeignPath *fpath;
 	ParamPathInfo *param_info;
-	double		gpu_ratio = pgstrom_gpu_operator_cost / cpu_operator_cost;
+	double		gpu_ratio;
 	Cost		startup_cost = 0.0;
 	Cost		run_cost = 0.0;
 	size_t		dma_size;
@@ -260,10 +260,15 @@ gstoreCreateForeignPath(PlannerInfo *root,
 	List	   *sort_order = NIL;
 	List	   *sort_null_first = NIL;
 	GpuStoreFdwInfo *gsf_info;
+	pgstromCostFactors cf;
+
+	/* cost factors of the device */
+	pgstrom_get_cost_factors(root, baserel, &cf);
+	gpu_ratio = cf.gpu_operator_cost / cpu_operator_cost;
 
 	/* Cost for GPU setup, if any */
 	if (dev_quals != NIL || query_pathkeys != NIL)
-		startup_cost += pgstrom_gpu_setup_cost;
+		startup_cost += cf.gpu_setup_cost;
 	/* Cost for GPU qualifiers, if any */
 	if (dev_quals)
 	{
@@ -293,7 +298,7 @@ gstoreCreateForeignPath(PlannerInfo *root,
 	}
 	dma_size = (KDS_CALCULATE_HEAD_LENGTH(baserel->max_attr, true) +
 				MAXALIGN(tup_size) * (size_t)dma_nrows);
-	run_cost += pgstrom_gpu_dma_cost *
+	run_cost += cf.gpu_dma_cost *
 		((double)dma_size / (double)pgstrom_chunk_size());
 	/* Cost for CPU qualifiers, if any */
 	if (host_quals)
@@ -319,7 +324,7 @@ gstoreCreateForeignPath(PlannerInfo *root,
 	if (query_pathkeys != NIL)
 	{
 		ListCell   *lc1, *lc2;
-		Cost		comparison_cost = 2.0 * pgstrom_gpu_operator_cost;
+		Cost		comparison_cost = 2.0 * cf.gpu_operator_cost;
 
 		foreach (lc1, query_pathkeys)
 		{
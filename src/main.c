@@ -25,6 +25,8 @@ PG_MODULE_MAGIC;
 bool		pgstrom_enabled;
 bool		pgstrom_debug_kernel_source;
 bool		pgstrom_cpu_fallback_enabled;
+bool		pgstrom_cpu_fallback_during_build;
+bool		pgstrom_debug_force_cpu_fallback;
 static int	pgstrom_chunk_size_kb;
 
 /* cost factors */
@@ -67,6 +69,24 @@ pgstrom_init_misc_guc(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* turn on/off CPU fallback while GPU program is not built yet */
+	DefineCustomBoolVariable("pg_strom.cpu_fallback_during_build",
+							 "Runs chunks on CPU while GPU program is being built",
+							 NULL,
+							 &pgstrom_cpu_fallback_during_build,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* process all the chunks by CPU fallback, for debugging */
+	DefineCustomBoolVariable("pg_strom.debug_force_cpu_fallback",
+							 "Runs all the chunks on CPU fallback, for debugging",
+							 NULL,
+							 &pgstrom_debug_force_cpu_fallback,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/* turn on/off cuda kernel source saving */
 	DefineCustomBoolVariable("pg_strom.debug_kernel_source",
 							 "Turn on/off to display the kernel source path",
@@ -530,13 +550,18 @@ _PG_init(void)
 	pgstrom_init_gpuscan();
 	pgstrom_init_gpujoin();
 	pgstrom_init_gpupreagg();
+	pgstrom_init_gpusort();
 	pgstrom_init_relscan();
+	pgstrom_init_ccache();
 
 	/* miscellaneous initializations */
 	pgstrom_init_codegen();
 	pgstrom_init_plcuda();
 	pgstrom_init_gstore_buf();
 	pgstrom_init_gstore_fdw();
+	pgstrom_init_arrow_fdw();
+	pgstrom_init_zonemap();
+	pgstrom_init_costmodel();
 
 	/* check commercial license, if any */
 	check_heterodb_license();
@@ -56,6 +56,7 @@ typedef struct PCIDevEntry	PCIDevEntry;
 /* static variables/functions */
 static HTAB		   *nvmeHash = NULL;
 static bool			nvme_strom_enabled;			/* GUC */
+static bool			nvme_strom_emulation;		/* GUC */
 static int			nvme_strom_threshold_kb;	/* GUC */
 static char		   *nvme_manual_distance_map;	/* GUC */
 static void			apply_nvme_manual_distance_map(void);
@@ -753,7 +754,7 @@ GetOptimalGpuForVolume(int major, int minor)
 	return nvme->nvme_optimal_gpu;
 }
 
-static cl_int
+int
 GetOptimalGpuForTablespace(Oid tablespace_oid)
 {
 	vfs_nvme_status *entry;
@@ -762,7 +763,7 @@ GetOptimalGpuForTablespace(Oid tablespace_oid)
 	bool		found;
 
 	if (!nvme_strom_enabled)
-		return false;	/* nvme_strom is not configured or disabled */
+		return -1;		/* nvme_strom is not configured or disabled */
 
 	if (!OidIsValid(tablespace_oid))
 		tablespace_oid = MyDatabaseTableSpace;
@@ -796,7 +797,7 @@ GetOptimalGpuForTablespace(Oid tablespace_oid)
 	{
 		elog(WARNING, "failed on open('%s') of tablespace %u: %m",
 			 pathname, tablespace_oid);
-		return false;
+		return -1;
 	}
 
 	PG_TRY();
@@ -859,6 +860,7 @@ GetOptimalGpuForRelation(PlannerInfo *root, RelOptInfo *rel)
 {
 	RangeTblEntry *rte;
 	HeapTuple	tup;
+	char		relkind;
 	char		relpersistence;
 	cl_int		cuda_dindex;
 
@@ -871,9 +873,15 @@ GetOptimalGpuForRelation(PlannerInfo *root, RelOptInfo *rel)
 	tup = SearchSysCache1(RELOID, ObjectIdGetDatum(rte->relid));
 	if (!HeapTupleIsValid(tup))
 		elog(ERROR, "cache lookup failed for relation %u", rte->relid);
+	relkind = ((Form_pg_class) GETSTRUCT(tup))->relkind;
 	relpersistence = ((Form_pg_class) GETSTRUCT(tup))->relpersistence;
 	ReleaseSysCache(tup);
 
+	/* only heap relations are stored on the tablespace */
+	if (relkind != RELKIND_RELATION &&
+		relkind != RELKIND_MATVIEW)
+		return -1;
+
 	if (relpersistence == RELPERSISTENCE_PERMANENT ||
 		relpersistence == RELPERSISTENCE_UNLOGGED)
 		return cuda_dindex;
@@ -889,11 +897,58 @@ RelationCanUseNvmeStrom(Relation relation)
 	/* SSD2GPU on temp relation is not supported */
 	if (RelationUsesLocalBuffers(relation))
 		return false;
+	/* SSD2GPU on foreign tables is not supported */
+	if (RelationGetForm(relation)->relkind != RELKIND_RELATION &&
+		RelationGetForm(relation)->relkind != RELKIND_MATVIEW)
+		return false;
 	cuda_dindex = GetOptimalGpuForTablespace(tablespace_oid);
 	return (cuda_dindex >= 0 &&
 			cuda_dindex <  numDevAttrs);
 }
 
+/*
+ * RelationCanUseNvmeStromEmulation
+ *
+ * It returns true, if uncached blocks of the relation shall be loaded by
+ * the userspace emulation (O_DIRECT async reads to the host buffer),
+ * instead of the SSD-to-GPU P2P DMA by nvme_strom.
+ */
+bool
+RelationCanUseNvmeStromEmulation(Relation relation)
+{
+	if (!nvme_strom_emulation)
+		return false;
+	/* temp relation is on the local buffer */
+	if (RelationUsesLocalBuffers(relation))
+		return false;
+	/* only heap relations are stored on the tablespace */
+	if (RelationGetForm(relation)->relkind != RELKIND_RELATION &&
+		RelationGetForm(relation)->relkind != RELKIND_MATVIEW)
+		return false;
+	/* real nvme_strom is preferable, if available */
+	return !RelationCanUseNvmeStrom(relation);
+}
+
+/*
+ * baseRelCanUseNvmeStromEmulation
+ */
+static bool
+baseRelCanUseNvmeStromEmulation(PlannerInfo *root, RelOptInfo *rel)
+{
+	RangeTblEntry *rte = root->simple_rte_array[rel->relid];
+	char		relpersistence;
+
+	if (!nvme_strom_emulation)
+		return false;
+	if (rte->rtekind != RTE_RELATION ||
+		(rte->relkind != RELKIND_RELATION &&
+		 rte->relkind != RELKIND_MATVIEW))
+		return false;
+	relpersistence = get_rel_persistence(rte->relid);
+	return (relpersistence == RELPERSISTENCE_PERMANENT ||
+			relpersistence == RELPERSISTENCE_UNLOGGED);
+}
+
 /*
  * ScanPathWillUseNvmeStrom - Optimizer Hint
  */
@@ -902,7 +957,7 @@ ScanPathWillUseNvmeStrom(PlannerInfo *root, RelOptInfo *baserel)
 {
 	size_t		num_scan_pages = 0;
 
-	if (!nvme_strom_enabled)
+	if (!nvme_strom_enabled && !nvme_strom_emulation)
 		return false;
 
 	/*
@@ -915,7 +970,8 @@ ScanPathWillUseNvmeStrom(PlannerInfo *root, RelOptInfo *baserel)
 	 */
 	if (baserel->reloptkind == RELOPT_BASEREL)
 	{
-		if (GetOptimalGpuForRelation(root, baserel) >= 0)
+		if (GetOptimalGpuForRelation(root, baserel) >= 0 ||
+			baseRelCanUseNvmeStromEmulation(root, baserel))
 			num_scan_pages = baserel->pages;
 	}
 	else if (baserel->reloptkind == RELOPT_OTHER_MEMBER_REL)
@@ -948,7 +1004,8 @@ ScanPathWillUseNvmeStrom(PlannerInfo *root, RelOptInfo *baserel)
 			if (appinfo->parent_relid != parent_relid)
 				continue;
 			rel = root->simple_rel_array[appinfo->child_relid];
-			if (GetOptimalGpuForRelation(root, rel) >= 0)
+			if (GetOptimalGpuForRelation(root, rel) >= 0 ||
+				baseRelCanUseNvmeStromEmulation(root, rel))
 				num_scan_pages += rel->pages;
 		}
 	}
@@ -996,6 +1053,15 @@ pgstrom_init_nvme_strom(void)
 							 PGC_SUSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* pg_strom.nvme_strom_emulation */
+	DefineCustomBoolVariable("pg_strom.nvme_strom_emulation",
+							 "Emulates SSD-to-GPU P2P DMA by O_DIRECT async reads if nvme_strom is not available",
+							 NULL,
+							 &nvme_strom_emulation,
+							 false,
+							 PGC_SUSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/*
 	 * MEMO: Threshold of table's physical size to use NVMe-Strom:
 	 *   ((System RAM size) -
@@ -91,4 +91,25 @@
 	extract_actual_join_clauses((a),(c),(d))
 #endif
 
+/*
+ * MEMO: PG11 adds 'flags' argument to BackgroundWorkerInitializeConnection
+ */
+#if PG_VERSION_NUM < 110000
+#define BackgroundWorkerInitializeConnection(dbname,username,flags)	\
+	BackgroundWorkerInitializeConnection((dbname),(username))
+#endif
+
+/*
+ * MEMO: PG10 adds 'copy' argument to tuplesort_gettupleslot, and PG11 adds
+ * 'coordinate' argument to tuplesort_begin_heap for parallel sort.
+ */
+#if PG_VERSION_NUM < 100000
+#define tuplesort_gettupleslot(a,b,c,d,e)		\
+	tuplesort_gettupleslot((a),(b),(d),(e))
+#endif
+#if PG_VERSION_NUM < 110000
+#define tuplesort_begin_heap(a,b,c,d,e,f,g,h,i)	\
+	tuplesort_begin_heap((a),(b),(c),(d),(e),(f),(g),(i))
+#endif
+
 #endif	/* PG_COMPAT_H */
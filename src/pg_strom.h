@@ -15,6 +15,7 @@
 #include "postgres.h"
 #include "access/brin.h"
 #include "access/brin_revmap.h"
+#include "access/genam.h"
 #include "access/hash.h"
 #include "access/htup_details.h"
 #include "access/reloptions.h"
@@ -96,6 +97,7 @@
 #include "parser/parse_func.h"
 #include "pgstat.h"
 #include "port/atomics.h"
+#include "port/pg_crc32c.h"
 #include "postmaster/bgworker.h"
 #include "postmaster/postmaster.h"
 #include "storage/buf.h"
@@ -140,9 +142,11 @@
 #include "utils/ruleutils.h"
 #include "utils/selfuncs.h"
 #include "utils/snapmgr.h"
+#include "utils/sortsupport.h"
 #include "utils/spccache.h"
 #include "utils/syscache.h"
 #include "utils/tqual.h"
+#include "utils/tuplesort.h"
 #include "utils/typcache.h"
 #include "utils/uuid.h"
 #include "utils/varbit.h"
@@ -154,9 +158,12 @@
 #include <cuda.h>
 #include <nvrtc.h>
 
+#include <aio.h>
 #include <assert.h>
+#include <dirent.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <utime.h>
 #include <float.h>
 #include <limits.h>
 #include <math.h>
@@ -282,6 +289,7 @@ typedef struct GpuTaskSharedState	GpuTaskSharedState;
  */
 struct NVMEScanState;
 struct GpuTaskSharedState;
+struct ArrowFdwState;
 
 struct GpuTaskState
 {
@@ -315,6 +323,17 @@ struct GpuTaskState
 	 */
 	struct NVMEScanState *nvme_sstate;
 	long			nvme_count;			/* # of blocks loaded by SSD2GPU */
+	long			ccache_count;		/* # of chunks loaded from ccache */
+
+	/* A state object for Arrow_fdw, if outer relation is Arrow file */
+	struct ArrowFdwState *af_state;
+
+	/* A state object for zone map on outer relation, if any */
+	struct zoneMapState *zm_state;
+	long			outer_zonemap_count; /* # of blocks skipped by zone map */
+
+	/* Tuple deformers specialized for the TupleDesc of PDS_fetch_tuple() */
+	struct KDSDeformer *deformers;
 
 	/*
 	 * fields to fetch rows from the current task
@@ -341,6 +360,8 @@ struct GpuTaskState
 	int			  (*cb_process_task)(GpuTask *gtask,
 									 CUmodule cuda_module);
 	void		  (*cb_release_task)(GpuTask *gtask);
+	/* optional; prepares CPU fallback while JIT build is in-progress */
+	bool		  (*cb_build_fallback)(GpuTask *gtask);
 	/* list of GpuTasks (protexted with GpuContext->mutex) */
 	dlist_head		ready_tasks;	/* list of tasks already processed */
 	cl_uint			num_running_tasks;	/* # of running tasks */
@@ -348,6 +369,8 @@ struct GpuTaskState
 
 	/* misc fields */
 	cl_long			num_cpu_fallbacks;	/* # of CPU fallback chunks */
+	cl_long			num_build_fallbacks;/* # of chunks on CPU during build */
+	cl_long			num_build_switched;	/* # of chunks on GPU after build */
 
 	/* co-operation with CPU parallel */
 	GpuTaskSharedState *gtss;		/* DSM segment of GTS if any */
@@ -359,10 +382,13 @@ struct GpuTaskState
  */
 struct GpuTaskSharedState
 {
-	uint64		nr_allocated;	/* number of blocks already allocated to
-								 * workers; almost equivalent to the
-								 * @phs_nallocated in PG11 or later.
-								 */
+	pg_atomic_uint64 nr_allocated;	/* number of blocks already allocated
+									 * to workers; almost equivalent to the
+									 * @phs_nallocated in PG11 or later.
+									 */
+	pg_atomic_uint32 nr_workers;	/* number of workers including the
+									 * leader; published by the leader
+									 * once workers are launched */
 	ParallelHeapScanDescData	phscan;
 	/* variable length */
 };
@@ -377,8 +403,12 @@ typedef struct
 	pg_atomic_uint64	source_nitems;
 	pg_atomic_uint64	nitems_filtered;
 	pg_atomic_uint64	nvme_count;
+	pg_atomic_uint64	ccache_count;
 	pg_atomic_uint64	brin_count;
+	pg_atomic_uint64	zonemap_count;
 	pg_atomic_uint64	fallback_count;
+	pg_atomic_uint64	build_fallback_count;
+	pg_atomic_uint64	build_switched_count;
 } GpuTaskRuntimeStat;
 
 static inline void
@@ -393,9 +423,16 @@ mergeGpuTaskRuntimeStatParallelWorker(GpuTaskState *gts,
 				 &gts->outer_instrument);
 	SpinLockRelease(&gt_rtstat->lock);
 	pg_atomic_add_fetch_u64(&gt_rtstat->nvme_count, gts->nvme_count);
+	pg_atomic_add_fetch_u64(&gt_rtstat->ccache_count, gts->ccache_count);
 	pg_atomic_add_fetch_u64(&gt_rtstat->brin_count, gts->outer_brin_count);
+	pg_atomic_add_fetch_u64(&gt_rtstat->zonemap_count,
+							gts->outer_zonemap_count);
 	pg_atomic_add_fetch_u64(&gt_rtstat->fallback_count,
 							gts->num_cpu_fallbacks);
+	pg_atomic_add_fetch_u64(&gt_rtstat->build_fallback_count,
+							gts->num_build_fallbacks);
+	pg_atomic_add_fetch_u64(&gt_rtstat->build_switched_count,
+							gts->num_build_switched);
 }
 
 static inline void
@@ -409,8 +446,15 @@ mergeGpuTaskRuntimeStat(GpuTaskState *gts,
 	gts->outer_instrument.nfiltered1 = (double)
 		pg_atomic_read_u64(&gt_rtstat->nitems_filtered);
 	gts->nvme_count += pg_atomic_read_u64(&gt_rtstat->nvme_count);
+	gts->ccache_count += pg_atomic_read_u64(&gt_rtstat->ccache_count);
 	gts->outer_brin_count += pg_atomic_read_u64(&gt_rtstat->brin_count);
+	gts->outer_zonemap_count +=
+		pg_atomic_read_u64(&gt_rtstat->zonemap_count);
 	gts->num_cpu_fallbacks += pg_atomic_read_u64(&gt_rtstat->fallback_count);
+	gts->num_build_fallbacks +=
+		pg_atomic_read_u64(&gt_rtstat->build_fallback_count);
+	gts->num_build_switched +=
+		pg_atomic_read_u64(&gt_rtstat->build_switched_count);
 }
 
 /*
@@ -436,6 +480,7 @@ struct GpuTask
 #define DEVKERNEL_NEEDS_GPUJOIN			0x00000002	/* GpuJoin logic */
 #define DEVKERNEL_NEEDS_GPUPREAGG		0x00000004	/* GpuPreAgg logic */
 #define DEVKERNEL_NEEDS_GPUSTORE		0x00000008	/* for GpuStoreFdw */
+#define DEVKERNEL_NEEDS_GPUSORT			0x00000010	/* GpuSort logic */
 #define DEVKERNEL_NEEDS_MATRIX			0x00000200
 #define DEVKERNEL_NEEDS_TIMELIB			0x00000400
 #define DEVKERNEL_NEEDS_TEXTLIB			0x00000800
@@ -535,6 +580,10 @@ typedef struct NVMEScanState
 	BlockNumber		curr_segno;
 	Buffer			curr_vmbuffer;
 	BlockNumber		nr_segs;
+	bool			direct_load;/* false, if whole-page copy of the buffered
+								 * blocks only */
+	bool			emulated;	/* true, if nvme_strom emulation */
+	char		   *bounce_buffer;	/* aligned buffer for O_DIRECT reads */
 	int				fdesc[FLEXIBLE_ARRAY_MEMBER];
 } NVMEScanState;
 
@@ -905,11 +954,13 @@ extern void pgstrom_init_gputasks(void);
  * nvme_strom.c
  */
 extern int	nvme_strom_ioctl(int cmd, void *arg);
+extern int	GetOptimalGpuForTablespace(Oid tablespace_oid);
 extern int	GetOptimalGpuForRelation(PlannerInfo *root,
 									 RelOptInfo *rel);
 extern bool ScanPathWillUseNvmeStrom(PlannerInfo *root,
 									 RelOptInfo *baserel);
 extern bool RelationCanUseNvmeStrom(Relation relation);
+extern bool RelationCanUseNvmeStromEmulation(Relation relation);
 extern void	pgstrom_init_nvme_strom(void);
 
 /*
@@ -927,6 +978,7 @@ extern ProgramId __pgstrom_create_cuda_program(GpuContext *gcontext,
 #define pgstrom_create_cuda_program(a,b,c,d,e,f,g)				\
 	__pgstrom_create_cuda_program((a),(b),(c),(d),(e),(f),(g),	\
 								  __FILE__,__LINE__)
+extern bool pgstrom_cuda_program_is_ready(ProgramId program_id);
 extern CUmodule pgstrom_load_cuda_program(ProgramId program_id);
 extern void pgstrom_put_cuda_program(GpuContext *gcontext,
 									 ProgramId program_id);
@@ -955,6 +1007,8 @@ typedef struct {
 	const char *kds_label;	/* label to reference kds, if exist */
 	const char *kds_index_label;/* label to reference kds_index, if exist */
 	List	   *pseudo_tlist;	/* pseudo tlist expression, if any */
+	List	   *cse_exprs;	/* list of common sub-expressions */
+	Bitmapset  *cse_refs;	/* referenced common sub-expressions */
 	int			extra_flags;	/* external libraries to be included */
 	int			varlena_bufsz;	/* required size of temporary varlena buffer */
 } codegen_context;
@@ -970,9 +1024,14 @@ extern devfunc_info *pgstrom_devfunc_lookup_type_compare(devtype_info *dtype,
 extern void pgstrom_devfunc_track(codegen_context *context,
 								  devfunc_info *dfunc);
 
+extern kern_hashset *pgstrom_build_array_hashset(ArrayType *array);
+extern kern_hashset *pgstrom_scalar_array_hashset(ScalarArrayOpExpr *opexpr);
 extern char *pgstrom_codegen_expression(Node *expr, codegen_context *context);
 extern void pgstrom_codegen_param_declarations(StringInfo buf,
 											   codegen_context *context);
+extern void pgstrom_codegen_cse_setup(codegen_context *context, List *exprs);
+extern void pgstrom_codegen_cse_declarations(StringInfo buf,
+											 codegen_context *context);
 extern bool __pgstrom_device_expression(PlannerInfo *root, Expr *expr,
 										const char *filename, int lineno);
 
@@ -1059,6 +1118,9 @@ extern cl_uint NVMESS_NBlocksPerChunk(struct NVMEScanState *nvme_sstate);
 													 (pds)->kds.nrooms) - \
 				(sizeof(loff_t) * (pds)->nblocks_uncached)))
 extern void PDS_fillup_blocks(pgstrom_data_store *pds);
+extern void PDS_fillup_blocks_direct(pgstrom_data_store *pds,
+									 NVMEScanState *nvme_sstate,
+									 struct zoneMapState *zm_state);
 
 extern bool KDS_insert_tuple(kern_data_store *kds,
 							 TupleTableSlot *slot);
@@ -1072,6 +1134,7 @@ extern void pgstrom_init_datastore(void);
 /*
  * relscan.c
  */
+extern bool		pgstrom_enable_page_copy;		/* GUC */
 extern IndexOptInfo *pgstrom_tryfind_brinindex(PlannerInfo *root,
 											   RelOptInfo *baserel,
 											   List **p_indexConds,
@@ -1120,10 +1183,29 @@ extern void pgstromExplainOuterScan(GpuTaskState *gts,
 
 extern void pgstrom_init_relscan(void);
 
+/*
+ * ccache.c
+ */
+#define CCACHE_CHUNK_SIZE		(128L << 20)	/* 128MB */
+#define CCACHE_CHUNK_NBLOCKS	(CCACHE_CHUNK_SIZE / BLCKSZ)
+
+typedef struct ccacheChunk		ccacheChunk;
+
+extern bool RelationCanUseColumnarCache(Relation relation);
+extern ccacheChunk *pgstrom_ccache_get_chunk(Relation relation,
+											 BlockNumber block_nr);
+extern void pgstrom_ccache_put_chunk(ccacheChunk *cc_chunk);
+extern pgstrom_data_store *pgstrom_ccache_load_chunk(ccacheChunk *cc_chunk,
+													 GpuContext *gcontext,
+													 Relation relation,
+													 Bitmapset *ccache_refs);
+extern void pgstrom_init_ccache(void);
+
 /*
  * gpuscan.c
  */
-extern Cost cost_for_dma_receive(RelOptInfo *rel, double ntuples);
+extern Cost cost_for_dma_receive(PlannerInfo *root,
+								 RelOptInfo *rel, double ntuples);
 extern void codegen_gpuscan_quals(StringInfo kern,
 								  codegen_context *context,
 								  Index scanrelid,
@@ -1213,6 +1295,11 @@ extern void assign_gpupreagg_session_info(StringInfo buf,
 										  GpuTaskState *gts);
 extern void pgstrom_init_gpupreagg(void);
 
+/*
+ * gpusort.c
+ */
+extern void pgstrom_init_gpusort(void);
+
 /*
  * pl_cuda.c
  */
@@ -1232,6 +1319,71 @@ extern Oid	get_reggstore_type_oid(void);
 #define REGGSTOREOID		get_reggstore_type_oid()
 extern void pgstrom_init_gstore_fdw(void);
 
+/*
+ * arrow_fdw.c
+ */
+typedef struct ArrowFdwState	ArrowFdwState;
+
+extern bool baseRelIsArrowFdw(RelOptInfo *baserel);
+extern bool RelationIsArrowFdw(Relation frel);
+extern ArrowFdwState *ExecInitArrowFdw(Relation relation,
+									   Bitmapset *referenced,
+									   List *outer_quals);
+extern pgstrom_data_store *ExecScanChunkArrowFdw(GpuTaskState *gts);
+extern void ExecReScanArrowFdw(ArrowFdwState *af_state);
+extern void ExecEndArrowFdw(ArrowFdwState *af_state);
+extern void ExplainArrowFdw(ArrowFdwState *af_state,
+							Relation frel, ExplainState *es);
+extern void pgstrom_init_arrow_fdw(void);
+
+/*
+ * zonemap.c
+ */
+typedef struct zoneMapState		zoneMapState;
+
+extern void pgstromExecInitZoneMap(GpuTaskState *gts, List *outer_quals);
+extern void pgstromExecSetZoneMapRuntimeQuals(GpuTaskState *gts,
+											  List *quals);
+extern cl_long pgstromZoneMapSkipBlocks(GpuTaskState *gts, BlockNumber page);
+extern void pgstromZoneMapExpect(zoneMapState *zm_state,
+								 BlockNumber blknum);
+extern void pgstromZoneMapObserve(zoneMapState *zm_state,
+								  BlockNumber blknum, Page page);
+extern void pgstromExecRewindZoneMap(GpuTaskState *gts);
+extern void pgstromExecEndZoneMap(GpuTaskState *gts);
+extern void pgstromExplainZoneMap(GpuTaskState *gts, ExplainState *es);
+extern void pgstrom_init_zonemap(void);
+
+/*
+ * deform.c
+ */
+typedef struct KDSDeformer		KDSDeformer;
+
+extern KDSDeformer *KDS_create_deformer(TupleDesc tupdesc);
+extern KDSDeformer *pgstromGetTupleDeformer(GpuTaskState *gts,
+											TupleDesc tupdesc);
+extern void pgstromResetTupleDeformers(GpuTaskState *gts);
+extern bool KDS_deform_tuple(KDSDeformer *dfm,
+							 TupleTableSlot *slot,
+							 kern_data_store *kds,
+							 HeapTuple tuple_buf,
+							 size_t row_index);
+
+/*
+ * costmodel.c
+ */
+typedef struct
+{
+	double		gpu_setup_cost;		/* cost to setup GPU device */
+	double		gpu_dma_cost;		/* cost of DMA transfer per chunk */
+	double		gpu_operator_cost;	/* cost of an operator on GPU */
+	double		cpu_repack_cost;	/* cost to load a tuple onto chunk */
+} pgstromCostFactors;
+
+extern void pgstrom_get_cost_factors(PlannerInfo *root, RelOptInfo *rel,
+									 pgstromCostFactors *cf);
+extern void pgstrom_init_costmodel(void);
+
 /*
  * gstore_buf.c
  */
@@ -1292,6 +1444,8 @@ extern bool		pgstrom_enabled;
 extern bool		pgstrom_debug_kernel_source;
 extern bool		pgstrom_bulkexec_enabled;
 extern bool		pgstrom_cpu_fallback_enabled;
+extern bool		pgstrom_cpu_fallback_during_build;
+extern bool		pgstrom_debug_force_cpu_fallback;
 extern int		pgstrom_max_async_tasks;
 extern double	pgstrom_gpu_setup_cost;
 extern double	pgstrom_gpu_dma_cost;
@@ -17,6 +17,13 @@
  */
 #include "pg_strom.h"
 
+#define RELSCAN_ATOMIC_U64				pg_atomic_uint64
+#define RELSCAN_ATOMIC_READ_U64(p)		pg_atomic_read_u64(p)
+#define RELSCAN_ATOMIC_CAS_U64(p,e,n)	pg_atomic_compare_exchange_u64((p),(e),(n))
+#define RELSCAN_BRIN_SKIPPED(map,pos)	\
+	bms_is_member((pos), (const Bitmapset *)(map))
+#include "relscan_claim.h"
+
 /* Data structure for collecting qual clauses that match an index */
 typedef struct
 {
@@ -25,8 +32,14 @@ typedef struct
 	List	   *indexclauses[INDEX_MAX_KEYS];
 } IndexClauseSet;
 
+/*
+ * Upper limit of block claims on the parallel scan; see relscan_claim.h
+ */
+#define RELSCAN_CLAIM_MAX_NBLOCKS	(128 * 1024 * 1024 / BLCKSZ)
+
 /*--- static variables ---*/
 static bool		pgstrom_enable_brin;
+bool			pgstrom_enable_page_copy;		/* GUC */
 
 #if PG_VERSION_NUM < 100000
 /* several BRIN-index stuff are not implemented at PG9.6 */
@@ -63,62 +76,193 @@ brinGetStats(Relation index, BrinStatsData *stats)
 }
 #endif	/* <PG10.x */
 
+/*
+ * __fixup_indexqual_operand
+ *
+ * It replaces the indexkey expression with an index Var.
+ */
+static Node *
+__fixup_indexqual_operand(Node *node, IndexOptInfo *indexOpt)
+{
+	ListCell   *lc;
+
+	if (!node)
+		return NULL;
+
+	if (IsA(node, RelabelType))
+	{
+		RelabelType *relabel = (RelabelType *) node;
+
+		return __fixup_indexqual_operand((Node *)relabel->arg, indexOpt);
+	}
+
+	foreach (lc, indexOpt->indextlist)
+	{
+		TargetEntry *tle = lfirst(lc);
+
+		if (equal(node, tle->expr))
+		{
+			return (Node *)makeVar(INDEX_VAR,
+								   tle->resno,
+								   exprType((Node *)tle->expr),
+								   exprTypmod((Node *) tle->expr),
+								   exprCollation((Node *) tle->expr),
+								   0);
+		}
+	}
+	if (IsA(node, Var))
+		elog(ERROR, "Bug? variable is not found at index tlist");
+	return expression_tree_mutator(node, __fixup_indexqual_operand, indexOpt);
+}
+
 /*
  * simple_match_clause_to_indexcol
  *
  * It is a simplified version of match_clause_to_indexcol.
  * Also see optimizer/path/indxpath.c
+ *
+ * It returns an index condition, if the clause is one of the form below.
+ *    (indexkey operator constant) OR
+ *    (constant operator indexkey) OR
+ *    (indexkey operator ANY/ALL (array))
+ * Elsewhere, NULL shall be returned.
  */
-static bool
+static Expr *
 simple_match_clause_to_indexcol(IndexOptInfo *index,
 								int indexcol,
-								RestrictInfo *rinfo)
+								Expr *clause)
 {
-	Expr	   *clause = rinfo->clause;
 	Index		index_relid = index->rel->relid;
 	Oid			opfamily = index->opfamily[indexcol];
 	Oid			idxcollation = index->indexcollations[indexcol];
 	Node	   *leftop;
 	Node	   *rightop;
-	Relids		left_relids;
-	Relids		right_relids;
 	Oid			expr_op;
 	Oid			expr_coll;
 
-	/* Clause must be a binary opclause */
-	if (!is_opclause(clause))
-		return false;
+	if (is_opclause(clause))
+	{
+		OpExpr	   *op;
+
+		leftop = get_leftop(clause);
+		rightop = get_rightop(clause);
+		if (!leftop || !rightop)
+			return NULL;
+		expr_op = ((OpExpr *) clause)->opno;
+		expr_coll = ((OpExpr *) clause)->inputcollid;
+
+		if (OidIsValid(idxcollation) && idxcollation != expr_coll)
+			return NULL;
+
+		if (match_index_to_operand(leftop, indexcol, index) &&
+			!bms_is_member(index_relid, pull_varnos(rightop)) &&
+			!contain_volatile_functions(rightop) &&
+			op_in_opfamily(expr_op, opfamily))
+		{
+			op = (OpExpr *) copyObject(clause);
+		}
+		else if (match_index_to_operand(rightop, indexcol, index) &&
+				 !bms_is_member(index_relid, pull_varnos(leftop)) &&
+				 !contain_volatile_functions(leftop) &&
+				 op_in_opfamily(get_commutator(expr_op), opfamily))
+		{
+			op = (OpExpr *) copyObject(clause);
+			CommuteOpExpr(op);
+		}
+		else
+			return NULL;
+		/* replace the indexkey expression with an index Var */
+		linitial(op->args) = __fixup_indexqual_operand(linitial(op->args),
+													   index);
+		return (Expr *) op;
+	}
+	else if (IsA(clause, ScalarArrayOpExpr))
+	{
+		ScalarArrayOpExpr *saop = (ScalarArrayOpExpr *) clause;
 
-	leftop = get_leftop(clause);
-	rightop = get_rightop(clause);
-	if (!leftop || !rightop)
-		return false;
-	left_relids = rinfo->left_relids;
-	right_relids = rinfo->right_relids;
-	expr_op = ((OpExpr *) clause)->opno;
-	expr_coll = ((OpExpr *) clause)->inputcollid;
+		leftop = linitial(saop->args);
+		rightop = lsecond(saop->args);
+		expr_op = saop->opno;
+		expr_coll = saop->inputcollid;
 
-	if (OidIsValid(idxcollation) && idxcollation != expr_coll)
-		return false;
+		if (OidIsValid(idxcollation) && idxcollation != expr_coll)
+			return NULL;
 
-	/*
-	 * Check for clauses of the form:
-	 *    (indexkey operator constant) OR
-	 *    (constant operator indexkey)
-	 */
-	if (match_index_to_operand(leftop, indexcol, index) &&
-		!bms_is_member(index_relid, right_relids) &&
-		!contain_volatile_functions(rightop) &&
-		op_in_opfamily(expr_op, opfamily))
-		return true;
-
-	if (match_index_to_operand(rightop, indexcol, index) &&
-		!bms_is_member(index_relid, left_relids) &&
-		!contain_volatile_functions(leftop) &&
-		op_in_opfamily(get_commutator(expr_op), opfamily))
-		return true;
-
-	return false;
+		if (match_index_to_operand(leftop, indexcol, index) &&
+			!bms_is_member(index_relid, pull_varnos(rightop)) &&
+			!contain_volatile_functions(rightop) &&
+			op_in_opfamily(expr_op, opfamily))
+		{
+			saop = (ScalarArrayOpExpr *) copyObject(saop);
+			/* replace the indexkey expression with an index Var */
+			linitial(saop->args) =
+				__fixup_indexqual_operand(linitial(saop->args), index);
+			return (Expr *) saop;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * simple_match_expr_to_index
+ *
+ * It returns an index condition which is consistent with the clause, or
+ * NULL if the clause is not usable for the index. OR-clause is usable only
+ * if all the arms are usable. AND-clause is usable if any of the arms are
+ * usable, because a subset of the arms is always weaker than the original.
+ * @p_indexcol is set on the index column of the first matched clause.
+ */
+static Expr *
+simple_match_expr_to_index(IndexOptInfo *index,
+						   Expr *clause,
+						   int *p_indexcol)
+{
+	List	   *args = NIL;
+	ListCell   *lc;
+	int			indexcol;
+
+	if (IsA(clause, RestrictInfo))
+		clause = ((RestrictInfo *) clause)->clause;
+
+	if (or_clause((Node *) clause))
+	{
+		foreach (lc, ((BoolExpr *) clause)->args)
+		{
+			Expr   *cond = simple_match_expr_to_index(index, lfirst(lc),
+													  p_indexcol);
+			if (!cond)
+				return NULL;
+			args = lappend(args, cond);
+		}
+		return make_orclause(args);
+	}
+	else if (and_clause((Node *) clause))
+	{
+		foreach (lc, ((BoolExpr *) clause)->args)
+		{
+			Expr   *cond = simple_match_expr_to_index(index, lfirst(lc),
+													  p_indexcol);
+			if (cond)
+				args = lappend(args, cond);
+		}
+		if (args == NIL)
+			return NULL;
+		return make_ands_explicit(args);
+	}
+
+	for (indexcol = 0; indexcol < index->ncolumns; indexcol++)
+	{
+		Expr   *cond = simple_match_clause_to_indexcol(index,
+													   indexcol,
+													   clause);
+		if (cond)
+		{
+			if (*p_indexcol < 0)
+				*p_indexcol = indexcol;
+			return cond;
+		}
+	}
+	return NULL;
 }
 
 /*
@@ -132,7 +276,7 @@ simple_match_clause_to_index(IndexOptInfo *index,
 							 RestrictInfo *rinfo,
 							 IndexClauseSet *clauseset)
 {
-	int		indexcol;
+	int		indexcol = -1;
 
     /*
      * Never match pseudoconstants to indexes.  (Normally a match could not
@@ -152,19 +296,14 @@ simple_match_clause_to_index(IndexOptInfo *index,
         return;
 #endif
 
-	/* OK, check each index column for a match */
-	for (indexcol = 0; indexcol < index->ncolumns; indexcol++)
+	/* OK, check the clause (may be OR/AND tree) for a match */
+	if (simple_match_expr_to_index(index, rinfo->clause, &indexcol))
 	{
-		if (simple_match_clause_to_indexcol(index,
-											indexcol,
-											rinfo))
-		{
-			clauseset->indexclauses[indexcol] =
-				list_append_unique_ptr(clauseset->indexclauses[indexcol],
-									   rinfo);
-			clauseset->nonempty = true;
-			break;
-		}
+		Assert(indexcol >= 0 && indexcol < index->ncolumns);
+		clauseset->indexclauses[indexcol] =
+			list_append_unique_ptr(clauseset->indexclauses[indexcol],
+								   rinfo);
+		clauseset->nonempty = true;
 	}
 }
 
@@ -319,40 +458,6 @@ estimate_brinindex_scan_nblocks(PlannerInfo *root,
 /*
  * extract_index_conditions
  */
-static Node *
-__fixup_indexqual_operand(Node *node, IndexOptInfo *indexOpt)
-{
-	ListCell   *lc;
-
-	if (!node)
-		return NULL;
-
-	if (IsA(node, RelabelType))
-	{
-		RelabelType *relabel = (RelabelType *) node;
-
-		return __fixup_indexqual_operand((Node *)relabel->arg, indexOpt);
-	}
-
-	foreach (lc, indexOpt->indextlist)
-	{
-		TargetEntry *tle = lfirst(lc);
-
-		if (equal(node, tle->expr))
-		{
-			return (Node *)makeVar(INDEX_VAR,
-								   tle->resno,
-								   exprType((Node *)tle->expr),
-								   exprTypmod((Node *) tle->expr),
-								   exprCollation((Node *) tle->expr),
-								   0);
-		}
-	}
-	if (IsA(node, Var))
-		elog(ERROR, "Bug? variable is not found at index tlist");
-	return expression_tree_mutator(node, __fixup_indexqual_operand, indexOpt);
-}
-
 static List *
 extract_index_conditions(List *index_quals, IndexOptInfo *indexOpt)
 {
@@ -362,20 +467,14 @@ extract_index_conditions(List *index_quals, IndexOptInfo *indexOpt)
 	foreach (lc, index_quals)
 	{
 		RestrictInfo *rinfo = lfirst(lc);
-		OpExpr	   *op = (OpExpr *) rinfo->clause;
+		Expr	   *cond;
+		int			indexcol = -1;
 
-		if (!IsA(rinfo->clause, OpExpr))
+		cond = simple_match_expr_to_index(indexOpt, rinfo->clause, &indexcol);
+		if (!cond)
 			elog(ERROR, "Bug? unexpected index clause: %s",
 				 nodeToString(rinfo->clause));
-		if (list_length(((OpExpr *)rinfo->clause)->args) != 2)
-			elog(ERROR, "indexqual clause must be binary opclause");
-		op = (OpExpr *)copyObject(rinfo->clause);
-		if (!bms_equal(rinfo->left_relids, indexOpt->rel->relids))
-			CommuteOpExpr(op);
-		/* replace the indexkey expression with an index Var */
-		linitial(op->args) = __fixup_indexqual_operand(linitial(op->args),
-													   indexOpt);
-		result = lappend(result, op);
+		result = lappend(result, cond);
 	}
 	return result;
 }
@@ -484,7 +583,7 @@ pgstrom_common_relscan_cost(PlannerInfo *root,
 	Cost		run_cost = 0.0;
 	Cost		index_scan_cost = 0.0;
 	Cost		disk_scan_cost;
-	double		gpu_ratio = pgstrom_gpu_operator_cost / cpu_operator_cost;
+	double		gpu_ratio;
 	double		parallel_divisor = (double) parallel_workers;
 	double		ntuples = scan_rel->tuples;
 	double		nblocks = scan_rel->pages;
@@ -497,6 +596,7 @@ pgstrom_common_relscan_cost(PlannerInfo *root,
 	Size		htup_size;
 	Size		kds_head_sz;
 	QualCost	qcost;
+	pgstromCostFactors cf;
 	ListCell   *lc;
 
 	Assert((scan_rel->reloptkind == RELOPT_BASEREL ||
@@ -504,6 +604,10 @@ pgstrom_common_relscan_cost(PlannerInfo *root,
 		   scan_rel->relid > 0 &&
 		   scan_rel->relid < root->simple_rel_array_size);
 
+	/* cost factors of the device / tablespace */
+	pgstrom_get_cost_factors(root, scan_rel, &cf);
+	gpu_ratio = cf.gpu_operator_cost / cpu_operator_cost;
+
 	/* selectivity of device executable qualifiers */
 	selectivity = clauselist_selectivity(root,
 										 scan_quals,
@@ -573,7 +677,7 @@ pgstrom_common_relscan_cost(PlannerInfo *root,
 		 * be shared with all the worker process, so we can discount the
 		 * cost by parallel_divisor.
 		 */
-		startup_cost += pgstrom_gpu_setup_cost / parallel_divisor;
+		startup_cost += cf.gpu_setup_cost / parallel_divisor;
 
 		/*
 		 * Cost discount for more efficient I/O with multiplexing.
@@ -591,7 +695,7 @@ pgstrom_common_relscan_cost(PlannerInfo *root,
 	else
 	{
 		parallel_divisor = 1.0;
-		startup_cost += pgstrom_gpu_setup_cost;
+		startup_cost += cf.gpu_setup_cost;
 	}
 	run_cost += disk_scan_cost;
 
@@ -624,6 +728,10 @@ pgstrom_common_relscan_cost(PlannerInfo *root,
 		nrows_per_block = (BLCKSZ - SizeOfPageHeaderData) / tuple_width;
 	}
 
+	/* Cost to load heap tuples onto the chunks, unless SSD-to-GPU */
+	if ((scan_mode & PGSTROM_RELSCAN_SSD2GPU) == 0)
+		run_cost += cf.cpu_repack_cost * ntuples;
+
 	/* Cost for GPU qualifiers */
 	cost_qual_eval_node(&qcost, (Node *)scan_quals, root);
 	startup_cost += qcost.startup;
@@ -631,7 +739,7 @@ pgstrom_common_relscan_cost(PlannerInfo *root,
 	ntuples *= selectivity;
 
 	/* Cost for DMA transfer (host/storage --> GPU) */
-	run_cost += pgstrom_gpu_dma_cost * nchunks;
+	run_cost += cf.gpu_dma_cost * nchunks;
 
 	*p_parallel_divisor = parallel_divisor;
 	*p_scan_ntuples = ntuples / parallel_divisor;
@@ -644,6 +752,29 @@ pgstrom_common_relscan_cost(PlannerInfo *root,
 	return scan_mode;
 }
 
+/*
+ * pgstromBrinCond - a node of the BRIN-index condition tree
+ */
+#define BRIN_COND__SCANKEY		1	/* (indexkey OP value) */
+#define BRIN_COND__ARRAYKEY		2	/* (indexkey OP ANY/ALL (array)) */
+#define BRIN_COND__AND			3
+#define BRIN_COND__OR			4
+
+typedef struct pgstromBrinCond
+{
+	int			kind;
+	int			keyno;			/* index of scan_keys, if SCANKEY */
+	List	   *args;			/* list of pgstromBrinCond, if AND/OR */
+	/* properties if ARRAYKEY */
+	bool		array_any;		/* true, if ANY. false, if ALL */
+	ScanKeyData	array_key;		/* scan key without argument */
+	ExprState  *array_expr;		/* expression to be evaluated on runtime */
+	bool		array_isnull;
+	int			num_elems;
+	Datum	   *elem_values;
+	bool	   *elem_isnull;
+} pgstromBrinCond;
+
 /*
  * pgstromIndexState - runtime status of BRIN-index for relation scan
  */
@@ -652,18 +783,96 @@ typedef struct pgstromIndexState
 	Oid			index_oid;
 	Relation	index_rel;
 	Node	   *index_conds;	/* for EXPLAIN */
+	pgstromBrinCond *brin_cond;	/* condition tree to be evaluated */
 	BlockNumber	nblocks;
 	BlockNumber	range_sz;
 	BrinRevmap *brin_revmap;
 	BrinDesc   *brin_desc;
 	ScanKey		scan_keys;
 	int			num_scan_keys;
+	int			num_array_keys;
+	int			num_runtime_arrays;
 	IndexRuntimeKeyInfo *runtime_keys_info;
 	int			num_runtime_keys;
 	bool		runtime_key_ready;
 	ExprContext *runtime_econtext;
 } pgstromIndexState;
 
+/*
+ * pgstromBuildBrinCond - construct BRIN-index condition tree from the
+ * index conditions. (indexkey OP value) form is also added to @p_key_quals
+ * to build scan keys by ExecIndexBuildScanKeys.
+ */
+static pgstromBrinCond *
+pgstromBuildBrinCond(GpuTaskState *gts,
+					 pgstromIndexState *pi_state,
+					 Expr *expr,
+					 List **p_key_quals)
+{
+	pgstromBrinCond *cond = palloc0(sizeof(pgstromBrinCond));
+	ListCell   *lc;
+
+	if (and_clause((Node *) expr) || or_clause((Node *) expr))
+	{
+		cond->kind = (and_clause((Node *) expr)
+					  ? BRIN_COND__AND
+					  : BRIN_COND__OR);
+		foreach (lc, ((BoolExpr *) expr)->args)
+		{
+			cond->args = lappend(cond->args,
+								 pgstromBuildBrinCond(gts, pi_state,
+													  lfirst(lc),
+													  p_key_quals));
+		}
+	}
+	else if (IsA(expr, OpExpr))
+	{
+		cond->kind = BRIN_COND__SCANKEY;
+		cond->keyno = list_length(*p_key_quals);
+		*p_key_quals = lappend(*p_key_quals, expr);
+	}
+	else if (IsA(expr, ScalarArrayOpExpr))
+	{
+		ScalarArrayOpExpr *saop = (ScalarArrayOpExpr *) expr;
+		Var		   *var = linitial(saop->args);
+		Oid			opfamily;
+		int			op_strategy;
+		Oid			op_lefttype;
+		Oid			op_righttype;
+
+		if (!IsA(var, Var) || var->varno != INDEX_VAR)
+			elog(ERROR, "Bug? indexkey is not an index Var: %s",
+				 nodeToString(var));
+		opfamily = pi_state->index_rel->rd_opfamily[var->varattno - 1];
+		get_op_opfamily_properties(saop->opno,
+								   opfamily,
+								   false,
+								   &op_strategy,
+								   &op_lefttype,
+								   &op_righttype);
+		cond->kind = BRIN_COND__ARRAYKEY;
+		cond->array_any = saop->useOr;
+		ScanKeyEntryInitialize(&cond->array_key,
+							   0,
+							   var->varattno,
+							   op_strategy,
+							   op_righttype,
+							   saop->inputcollid,
+							   get_opcode(saop->opno),
+							   (Datum) 0);
+		cond->array_expr = ExecInitExpr(lsecond(saop->args),
+										&gts->css.ss.ps);
+		pi_state->num_array_keys++;
+		if (!IsA(lsecond(saop->args), Const))
+			pi_state->num_runtime_arrays++;
+	}
+	else
+		elog(ERROR, "Bug? unexpected BRIN-index condition: %s",
+			 nodeToString(expr));
+
+	return cond;
+}
+
 /*
  * pgstromExecInitBrinIndexMap
  */
@@ -675,6 +884,7 @@ pgstromExecInitBrinIndexMap(GpuTaskState *gts,
 	pgstromIndexState *pi_state = NULL;
 	Relation	relation = gts->css.ss.ss_currentRelation;
 	EState	   *estate = gts->css.ss.ps.state;
+	List	   *key_quals = NIL;
 	Index		scanrelid;
 	LOCKMODE	lockmode = NoLock;
 
@@ -693,9 +903,12 @@ pgstromExecInitBrinIndexMap(GpuTaskState *gts,
 	pi_state->index_oid = index_oid;
 	pi_state->index_rel = index_open(index_oid, lockmode);
 	pi_state->index_conds = (Node *)make_ands_explicit(index_conds);
+	pi_state->brin_cond = pgstromBuildBrinCond(gts, pi_state,
+											   (Expr *)pi_state->index_conds,
+											   &key_quals);
 	ExecIndexBuildScanKeys(&gts->css.ss.ps,
 						   pi_state->index_rel,
-						   index_conds,
+						   key_quals,
 						   false,
 						   &pi_state->scan_keys,
 						   &pi_state->num_scan_keys,
@@ -705,7 +918,7 @@ pgstromExecInitBrinIndexMap(GpuTaskState *gts,
 						   NULL);
 
 	/* ExprContext to evaluate runtime keys, if any */
-	if (pi_state->num_runtime_keys != 0)
+	if (pi_state->num_runtime_keys != 0 || pi_state->num_array_keys != 0)
 		pi_state->runtime_econtext = CreateExprContext(estate);
 	else
 		pi_state->runtime_econtext = NULL;
@@ -740,6 +953,172 @@ pgstromSizeOfBrinIndexMap(GpuTaskState *gts)
 
 }
 
+/*
+ * pgstromPrepareBrinCond - evaluates the runtime keys and arrays
+ */
+static void
+pgstromPrepareBrinCond(pgstromIndexState *pi_state, pgstromBrinCond *cond)
+{
+	ExprContext *econtext = pi_state->runtime_econtext;
+	MemoryContext oldcxt;
+	ListCell   *lc;
+
+	switch (cond->kind)
+	{
+		case BRIN_COND__AND:
+		case BRIN_COND__OR:
+			foreach (lc, cond->args)
+				pgstromPrepareBrinCond(pi_state, lfirst(lc));
+			break;
+
+		case BRIN_COND__ARRAYKEY:
+			oldcxt = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+			{
+				Datum		datum;
+				ArrayType  *array;
+				int16		elmlen;
+				bool		elmbyval;
+				char		elmalign;
+
+#if PG_VERSION_NUM < 100000
+				datum = ExecEvalExpr(cond->array_expr, econtext,
+									 &cond->array_isnull, NULL);
+#else
+				datum = ExecEvalExpr(cond->array_expr, econtext,
+									 &cond->array_isnull);
+#endif
+				cond->num_elems = 0;
+				if (!cond->array_isnull)
+				{
+					array = DatumGetArrayTypeP(datum);
+					get_typlenbyvalalign(ARR_ELEMTYPE(array),
+										 &elmlen, &elmbyval, &elmalign);
+					deconstruct_array(array,
+									  ARR_ELEMTYPE(array),
+									  elmlen, elmbyval, elmalign,
+									  &cond->elem_values,
+									  &cond->elem_isnull,
+									  &cond->num_elems);
+				}
+			}
+			MemoryContextSwitchTo(oldcxt);
+			break;
+
+		default:
+			break;
+	}
+}
+
+/*
+ * pgstromBrinKeyIsConsistent - true, if the page range may contain rows
+ * which satisfy the scan key
+ */
+static bool
+pgstromBrinKeyIsConsistent(pgstromIndexState *pi_state,
+						   ScanKey key,
+						   BrinMemTuple *dtup,
+						   FmgrInfo *consistentFn)
+{
+	BrinDesc   *bdesc = pi_state->brin_desc;
+	AttrNumber	keyattno = key->sk_attno;
+	BrinValues *bval = &dtup->bt_columns[keyattno - 1];
+	Datum		rv;
+	Form_pg_attribute keyattr __attribute__((unused));
+
+#if PG_VERSION_NUM < 110000
+	keyattr = bdesc->bd_tupdesc->attrs[keyattno - 1];
+#else
+	keyattr = &bdesc->bd_tupdesc->attrs[keyattno - 1];
+#endif
+	Assert((key->sk_flags & SK_ISNULL) ||
+		   (key->sk_collation == keyattr->attcollation));
+	/* First time this column? look up consistent function */
+	if (consistentFn[keyattno - 1].fn_oid == InvalidOid)
+	{
+		FmgrInfo   *tmp;
+
+		tmp = index_getprocinfo(pi_state->index_rel, keyattno,
+								BRIN_PROCNUM_CONSISTENT);
+		fmgr_info_copy(&consistentFn[keyattno - 1], tmp,
+					   CurrentMemoryContext);
+	}
+	rv = FunctionCall3Coll(&consistentFn[keyattno - 1],
+						   key->sk_collation,
+						   PointerGetDatum(bdesc),
+						   PointerGetDatum(bval),
+						   PointerGetDatum(key));
+	return DatumGetBool(rv);
+}
+
+/*
+ * pgstromBrinCondIsConsistent - true, if the page range may contain rows
+ * which satisfy the condition tree
+ */
+static bool
+pgstromBrinCondIsConsistent(pgstromIndexState *pi_state,
+							pgstromBrinCond *cond,
+							BrinMemTuple *dtup,
+							FmgrInfo *consistentFn)
+{
+	ListCell   *lc;
+	int			i;
+
+	switch (cond->kind)
+	{
+		case BRIN_COND__SCANKEY:
+			return pgstromBrinKeyIsConsistent(pi_state,
+											  &pi_state->scan_keys[cond->keyno],
+											  dtup, consistentFn);
+		case BRIN_COND__ARRAYKEY:
+			/* strict operators never match NULL array */
+			if (cond->array_isnull)
+				return false;
+			for (i=0; i < cond->num_elems; i++)
+			{
+				ScanKeyData	key;
+				bool		rv;
+
+				/* strict operators never match NULL element */
+				if (cond->elem_isnull[i])
+					rv = false;
+				else
+				{
+					memcpy(&key, &cond->array_key, sizeof(ScanKeyData));
+					key.sk_argument = cond->elem_values[i];
+					rv = pgstromBrinKeyIsConsistent(pi_state, &key,
+													dtup, consistentFn);
+				}
+				if (cond->array_any ? rv : !rv)
+					return rv;
+			}
+			/* ANY on empty array is false, ALL on empty array is true */
+			return !cond->array_any;
+
+		case BRIN_COND__AND:
+			foreach (lc, cond->args)
+			{
+				if (!pgstromBrinCondIsConsistent(pi_state, lfirst(lc),
+												 dtup, consistentFn))
+					return false;
+			}
+			return true;
+
+		case BRIN_COND__OR:
+			foreach (lc, cond->args)
+			{
+				if (pgstromBrinCondIsConsistent(pi_state, lfirst(lc),
+												dtup, consistentFn))
+					return true;
+			}
+			return false;
+
+		default:
+			elog(ERROR, "Bug? unexpected BRIN-index condition: %d",
+				 cond->kind);
+	}
+	return true;	/* not reachable */
+}
+
 /*
  * pgstromExecGetBrinIndexMap
  *
@@ -766,6 +1145,13 @@ __pgstromExecGetBrinIndexMap(pgstromIndexState *pi_state,
 	MemoryContext	oldcxt;
 	MemoryContext	perRangeCxt;
 
+	/* evaluation of the runtime keys and arrays, if any */
+	if (pi_state->num_runtime_keys > 0)
+		ExecIndexEvalRuntimeKeys(pi_state->runtime_econtext,
+								 pi_state->runtime_keys_info,
+								 pi_state->num_runtime_keys);
+	pgstromPrepareBrinCond(pi_state, pi_state->brin_cond);
+
 	/* rooms for the consistent support procedures of indexed columns */
 	consistentFn = palloc0(sizeof(FmgrInfo) * bd_tupdesc->natts);
 	/* allocate an initial in-memory tuple */
@@ -794,7 +1180,6 @@ __pgstromExecGetBrinIndexMap(pgstromIndexState *pi_state,
 		BrinTuple  *tup;
 		OffsetNumber off;
 		Size		size;
-		int			keyno;
 
 		CHECK_FOR_INTERRUPTS();
 
@@ -817,52 +1202,20 @@ __pgstromExecGetBrinIndexMap(pgstromIndexState *pi_state,
 #else
 			dtup = brin_deform_tuple(bdesc, btup);
 #endif
-			if (!dtup->bt_placeholder)
+			/*
+			 * Check whether the condition tree is consistent with the page
+			 * range values; if not, pages in the range shall be skipped on
+			 * the scan.
+			 */
+			if (!dtup->bt_placeholder &&
+				!pgstromBrinCondIsConsistent(pi_state,
+											 pi_state->brin_cond,
+											 dtup,
+											 consistentFn))
 			{
-				for (keyno = 0; keyno < pi_state->num_scan_keys; keyno++)
-				{
-					ScanKey		key = &pi_state->scan_keys[keyno];
-					AttrNumber	keyattno = key->sk_attno;
-					BrinValues *bval = &dtup->bt_columns[keyattno - 1];
-					Datum		rv;
-					Form_pg_attribute keyattr __attribute__((unused));
-
-#if PG_VERSION_NUM < 110000
-					keyattr = bd_tupdesc->attrs[keyattno - 1];
-#else
-					keyattr = &bd_tupdesc->attrs[keyattno - 1];
-#endif
-					Assert((key->sk_flags & SK_ISNULL) ||
-						   (key->sk_collation == keyattr->attcollation));
-					/* First time this column? look up consistent function */
-					if (consistentFn[keyattno - 1].fn_oid == InvalidOid)
-					{
-						FmgrInfo   *tmp;
-
-						tmp = index_getprocinfo(pi_state->index_rel, keyattno,
-												BRIN_PROCNUM_CONSISTENT);
-						fmgr_info_copy(&consistentFn[keyattno - 1], tmp,
-									   CurrentMemoryContext);
-					}
-
-					/*
-					 * Check whether the scan key is consistent with the page
-					 * range values; if so, pages in the range shall be
-					 * skipped on the scan.
-					 */
-					rv = FunctionCall3Coll(&consistentFn[keyattno - 1],
-										   key->sk_collation,
-										   PointerGetDatum(bdesc),
-										   PointerGetDatum(bval),
-										   PointerGetDatum(key));
-					if (!DatumGetBool(rv))
-					{
-						if (index / BITS_PER_BITMAPWORD < nwords)
-							brin_map->words[index / BITS_PER_BITMAPWORD]
-								|= (1U << (index % BITS_PER_BITMAPWORD));
-						break;
-					}
-				}
+				if (index / BITS_PER_BITMAPWORD < nwords)
+					brin_map->words[index / BITS_PER_BITMAPWORD]
+						|= (1U << (index % BITS_PER_BITMAPWORD));
 			}
 		}
 	}
@@ -964,7 +1317,14 @@ pgstromExecEndBrinIndexMap(GpuTaskState *gts)
 
 void
 pgstromExecRewindBrinIndexMap(GpuTaskState *gts)
-{}
+{
+	pgstromIndexState *pi_state = gts->outer_index_state;
+
+	/* BRIN-index map must be rebuilt, if it depends on runtime values */
+	if (pi_state && gts->outer_index_map &&
+		(pi_state->num_runtime_keys > 0 || pi_state->num_runtime_arrays > 0))
+		gts->outer_index_map->nwords = -1;
+}
 
 /*
  * pgstromExplainBrinIndexMap
@@ -1006,6 +1366,200 @@ pgstromExplainBrinIndexMap(GpuTaskState *gts,
 	}
 }
 
+/*
+ * pgstromScanCanUseColumnarCache
+ *
+ * columnar cache keeps only all-visible user columns, so we can use it
+ * only if the scan does not reference system columns under MVCC snapshot.
+ */
+static bool
+pgstromScanCanUseColumnarCache(GpuTaskState *gts)
+{
+	Relation	relation = gts->css.ss.ss_currentRelation;
+	EState	   *estate = gts->css.ss.ps.state;
+	int			k = bms_next_member(gts->outer_refs, -1);
+
+	if (!IsMVCCSnapshot(estate->es_snapshot))
+		return false;
+	if (k >= 0 && k + FirstLowInvalidHeapAttributeNumber <= 0)
+		return false;
+	return RelationCanUseColumnarCache(relation);
+}
+
+/*
+ * pgstromTryLoadColumnarCache
+ *
+ * It returns a PDS of KDS_FORMAT_COLUMN if the chunk that begins from
+ * @block_nr is already cached. Elsewhere, NULL shall be returned.
+ */
+static pgstrom_data_store *
+pgstromTryLoadColumnarCache(GpuTaskState *gts, BlockNumber block_nr)
+{
+	Relation	relation = gts->css.ss.ss_currentRelation;
+	ccacheChunk *cc_chunk;
+	pgstrom_data_store *pds;
+
+	cc_chunk = pgstrom_ccache_get_chunk(relation, block_nr);
+	if (!cc_chunk)
+		return NULL;
+	PG_TRY();
+	{
+		pds = pgstrom_ccache_load_chunk(cc_chunk,
+										gts->gcontext,
+										relation,
+										gts->outer_refs);
+	}
+	PG_CATCH();
+	{
+		pgstrom_ccache_put_chunk(cc_chunk);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	pgstrom_ccache_put_chunk(cc_chunk);
+
+	if (pds)
+		gts->ccache_count++;
+	return pds;
+}
+
+/*
+ * pgstromClaimParallelBlocks - claims a continuous range of blocks to be
+ * read by the caller under CPU parallel execution.
+ *
+ * The shared cursor (@gtss->nr_allocated) is advanced by compare-and-swap,
+ * so workers never serialize on the spinlock except for the first call to
+ * determine the start block of the synchronized scan.
+ * Claim size is large on the beginning of the scan, then shrinks toward
+ * the tail, so that all the workers finish their jobs at the same time.
+ * A claim never crosses the RELSEG_SIZE or the BRIN-index range boundary,
+ * and the whole chunk is claimed at once if columnar cache is available,
+ * unless it exceeds @nr_limit or BRIN-index can skip a part of the chunk.
+ * The logic of claims is in relscan_claim.h.
+ *
+ * It returns the number of claimed blocks, or 0 if end of the scan.
+ * If @p_skipped is set, the claimed blocks shall be skipped because the
+ * BRIN-index says no tuples can match.
+ */
+static cl_long
+pgstromClaimParallelBlocks(GpuTaskState *gts,
+						   cl_long nr_limit,
+						   Bitmapset *brin_map,
+						   cl_long brin_range_sz,
+						   bool use_ccache,
+						   cl_long *p_page,
+						   bool *p_skipped)
+{
+	GpuTaskSharedState *gtss = gts->gtss;
+	HeapScanDesc	scan = gts->css.ss.ss_currentScanDesc;
+	cl_long			nblocks = (cl_long)scan->rs_nblocks;
+	BlockNumber		startblock;
+	relscanClaimArgs args;
+	long			page = 0;
+	long			nr_blocks;
+
+	/*
+	 * If the scan's startblock has not yet been initialized, we must
+	 * do it now. If this is not a synchronized scan, we just start
+	 * at block 0, but if it is a synchronized scan, we must get
+	 * the starting position from the synchronized scan facility.
+	 * We can't hold the spinlock while doing that, though, so release
+	 * the spinlock once, get the information we need, and retry.
+	 * If nobody else has initialized the scan in the meantime,
+	 * we'll fill in the value we fetched on the second time through.
+	 * Once startblock is initialized, it is never changed during the scan.
+	 */
+	startblock = gtss->phscan.phs_startblock;
+	if (startblock == InvalidBlockNumber)
+	{
+		BlockNumber	sync_startpage = InvalidBlockNumber;
+
+	retry_lock:
+		SpinLockAcquire(&gtss->phscan.phs_mutex);
+		if (gtss->phscan.phs_startblock == InvalidBlockNumber)
+		{
+			if (!gtss->phscan.phs_syncscan)
+				gtss->phscan.phs_startblock = 0;
+			else if (sync_startpage != InvalidBlockNumber)
+				gtss->phscan.phs_startblock = sync_startpage;
+			else
+			{
+				SpinLockRelease(&gtss->phscan.phs_mutex);
+				sync_startpage = ss_get_location(scan->rs_rd,
+												 scan->rs_nblocks);
+				goto retry_lock;
+			}
+		}
+		startblock = gtss->phscan.phs_startblock;
+		SpinLockRelease(&gtss->phscan.phs_mutex);
+	}
+	else
+		pg_read_barrier();
+	scan->rs_startblock = startblock;
+
+	/*
+	 * The leader knows the number of workers actually launched, which may
+	 * be less than the planned one, so publishes it on the first claim.
+	 * Workers which start the scan prior to the update use the planned one,
+	 * that only makes their claims smaller.
+	 */
+	if (gts->pcxt &&
+		pg_atomic_read_u32(&gtss->nr_workers) !=
+		gts->pcxt->nworkers_launched + 1)
+		pg_atomic_write_u32(&gtss->nr_workers,
+							gts->pcxt->nworkers_launched + 1);
+
+	memset(&args, 0, sizeof(relscanClaimArgs));
+	args.nblocks		= nblocks;
+	args.startblock		= startblock;
+	args.nr_workers		= pg_atomic_read_u32(&gtss->nr_workers);
+	args.nr_limit		= nr_limit;
+	args.relseg_size	= RELSEG_SIZE;
+	args.brin_map		= brin_map;
+	args.brin_range_sz	= brin_range_sz;
+	args.chunk_nblocks	= (use_ccache ? CCACHE_CHUNK_NBLOCKS : 0);
+
+	nr_blocks = __relscanClaimBlocks(&gtss->nr_allocated, &args,
+									 &page, p_skipped);
+	*p_page = page;
+
+	return nr_blocks;
+}
+
+/*
+ * pgstromCreateScanChunk - allocation of a PDS for the heap scan, which
+ * begins at @blknum
+ *
+ * KDS_FORMAT_BLOCK is used if NVMe-Strom (or its emulation) is available.
+ * Elsewhere, on the whole-page copy mode, the format of the chunk is chosen
+ * by the visibility map of the first block. All-visible blocks are copied
+ * page-by-page with no per-tuple works, and other blocks are loaded onto
+ * KDS_FORMAT_ROW tuple-by-tuple, because their invisible tuples have to be
+ * checked anyway.
+ */
+static pgstrom_data_store *
+pgstromCreateScanChunk(GpuTaskState *gts, BlockNumber blknum)
+{
+	Relation		relation = gts->css.ss.ss_currentRelation;
+	HeapScanDesc	scan = gts->css.ss.ss_currentScanDesc;
+	NVMEScanState  *nvme_sstate = gts->nvme_sstate;
+	pgstrom_data_store *pds;
+
+	if (nvme_sstate &&
+		(nvme_sstate->direct_load ||
+		 (!scan->rs_snapshot->takenDuringRecovery &&
+		  VM_ALL_VISIBLE(relation, blknum, &nvme_sstate->curr_vmbuffer))))
+		pds = PDS_create_block(gts->gcontext,
+							   RelationGetDescr(relation),
+							   nvme_sstate);
+	else
+		pds = PDS_create_row(gts->gcontext,
+							 RelationGetDescr(relation),
+							 pgstrom_chunk_size());
+	pds->kds.table_oid = RelationGetRelid(relation);
+
+	return pds;
+}
+
 /*
  * pgstromExecScanChunkParallel - read the relation with parallel scan
  */
@@ -1013,9 +1567,9 @@ static pgstrom_data_store *
 pgstromExecScanChunkParallel(GpuTaskState *gts,
 							 pgstrom_data_store *pds,
 							 Bitmapset *brin_map,
-							 cl_long brin_range_sz)
+							 cl_long brin_range_sz,
+							 bool use_ccache)
 {
-	GpuTaskSharedState *gtss = gts->gtss;
 	Relation	relation = gts->css.ss.ss_currentRelation;
 	HeapScanDesc scan = gts->css.ss.ss_currentScanDesc;
 
@@ -1042,11 +1596,10 @@ pgstromExecScanChunkParallel(GpuTaskState *gts,
 		if (scan->rs_numblocks == 0)
 		{
 			NVMEScanState *nvme_sstate = gts->nvme_sstate;
-			BlockNumber	sync_startpage = InvalidBlockNumber;
-			cl_long		nr_allocated;
-			cl_long		startblock;
+			cl_long		nr_limit;
 			cl_long		nr_blocks;
 			cl_long		page;
+			bool		skipped;
 
 			/*
 			 * MEMO: A key of i/o performance is consolidation of continuous
@@ -1062,135 +1615,94 @@ pgstromExecScanChunkParallel(GpuTaskState *gts,
 			 * number of DMA requests.
 			 */
 			if (!nvme_sstate)
-				nr_blocks = 8;
+				nr_limit = RELSCAN_CLAIM_MAX_NBLOCKS;
 			else if (pds)
 			{
 				if (pds->kds.nitems >= pds->kds.nrooms)
 					break;	/* no more rooms in this PDS */
-				nr_blocks = pds->kds.nrooms - pds->kds.nitems;
+				nr_limit = pds->kds.nrooms - pds->kds.nitems;
 			}
 			else
-				nr_blocks = nvme_sstate->nblocks_per_chunk;
-
-		retry_lock:
-			SpinLockAcquire(&gtss->phscan.phs_mutex);
-			/*
-			 * If the scan's startblock has not yet been initialized, we must
-			 * do it now. If this is not a synchronized scan, we just start
-			 * at block 0, but if it is a synchronized scan, we must get
-			 * the starting position from the synchronized scan facility.
-			 * We can't hold the spinlock while doing that, though, so release
-			 * the spinlock once, get the information we need, and retry.
-			 * If nobody else has initialized the scan in the meantime,
-			 * we'll fill in the value we fetched on the second time through.
-			 */
-			if (gtss->phscan.phs_startblock == InvalidBlockNumber)
-			{
-				if (!gtss->phscan.phs_syncscan)
-					gtss->phscan.phs_startblock = 0;
-				else if (sync_startpage != InvalidBlockNumber)
-					gtss->phscan.phs_startblock = sync_startpage;
-				else
-				{
-					SpinLockRelease(&gtss->phscan.phs_mutex);
-					sync_startpage = ss_get_location(relation,
-													 scan->rs_nblocks);
-					goto retry_lock;
-				}
-			}
-			scan->rs_startblock = startblock = gtss->phscan.phs_startblock;
-			nr_allocated = gtss->nr_allocated;
+				nr_limit = nvme_sstate->nblocks_per_chunk;
 
-			if (nr_allocated >= (cl_long)scan->rs_nblocks)
+			nr_blocks = pgstromClaimParallelBlocks(gts, nr_limit,
+												   brin_map, brin_range_sz,
+												   use_ccache,
+												   &page, &skipped);
+			if (nr_blocks == 0)
 			{
-				SpinLockRelease(&gtss->phscan.phs_mutex);
 				scan->rs_cblock = InvalidBlockNumber;	/* end of the scan */
 				break;
 			}
-			if (nr_allocated + nr_blocks >= (cl_long)scan->rs_nblocks)
-				nr_blocks = (cl_long)scan->rs_nblocks - nr_allocated;
-			page = (startblock + nr_allocated) % (cl_long)scan->rs_nblocks;
-			if (page + nr_blocks >= (cl_long)scan->rs_nblocks)
-				nr_blocks = (cl_long)scan->rs_nblocks - page;
-
-			/* should never read the blocks across segment boundary */
-			Assert(nr_blocks > 0 && nr_blocks <= RELSEG_SIZE);
-			if ((page / RELSEG_SIZE) != (page + nr_blocks - 1) / RELSEG_SIZE)
-				nr_blocks = RELSEG_SIZE - (page % RELSEG_SIZE);
-			Assert(nr_blocks > 0);
-
-			if (brin_map)
+			if (skipped)
 			{
-				long	pos = page / brin_range_sz;
-				long	end = (page + nr_blocks - 1) / brin_range_sz;
-				long	s_page = -1;
-				long	e_page = page + nr_blocks;
-
-				/* find the first valid range */
-				while (pos <= end)
-				{
-					if (!bms_is_member(pos, brin_map))
-					{
-						s_page = Max(page, pos * brin_range_sz);
-						break;
-					}
-					pos++;
-				}
+				/* BRIN-index says no tuples can match in the range */
+				gts->outer_brin_count += nr_blocks;
+				continue;
+			}
+			scan->rs_cblock = page;
+			scan->rs_numblocks = nr_blocks;
+			continue;
+		}
+		/* try to load the columnar cache, if whole chunk is allocated */
+		if (use_ccache &&
+			scan->rs_numblocks == CCACHE_CHUNK_NBLOCKS &&
+			(scan->rs_cblock & (CCACHE_CHUNK_NBLOCKS - 1)) == 0)
+		{
+			pgstrom_data_store *pds_cc;
 
-				if (s_page < 0)
+			if (pds && pds->kds.nitems > 0)
+				break;	/* hand over the current PDS first */
+			pds_cc = pgstromTryLoadColumnarCache(gts, scan->rs_cblock);
+			if (pds_cc)
+			{
+				if (pds)
+					PDS_release(pds);
+				pds = NULL;
+				/* move to the next chunk */
+				scan->rs_numblocks = 0;
+				scan->rs_cblock += CCACHE_CHUNK_NBLOCKS;
+				if (scan->rs_cblock >= scan->rs_nblocks)
+					scan->rs_cblock = 0;
+				if (scan->rs_syncscan)
+					ss_report_location(relation, scan->rs_cblock);
+				/* end of the scan? */
+				if (scan->rs_cblock == scan->rs_startblock)
+					scan->rs_cblock = InvalidBlockNumber;
+				if (pds_cc->kds.nitems == 0)
 				{
-					/* Oops, here is no valid range, so just skip it */
-					gts->outer_brin_count += nr_blocks;
-					nr_allocated += nr_blocks;
-					nr_blocks = 0;
-				}
-				else
-				{
-					long	prev = page;
-					/* find the continuous valid ranges */
-					Assert(pos <= end);
-					Assert(!bms_is_member(pos, brin_map));
-					while (pos <= end)
-					{
-						if (bms_is_member(pos, brin_map))
-						{
-							e_page = Min(e_page, pos * brin_range_sz);
-							break;
-						}
-						pos++;
-					}
-					nr_allocated += (e_page - page);
-					nr_blocks = e_page - s_page;
-					page = s_page;
-					gts->outer_brin_count += page - prev;
+					PDS_release(pds_cc);
+					continue;
 				}
+				pds = pds_cc;
+				break;
 			}
-			else
+		}
+		/* skip the blocks, if zone map says no tuple can match */
+		if (gts->zm_state)
+		{
+			cl_long		nskips = pgstromZoneMapSkipBlocks(gts,
+														  scan->rs_cblock);
+			if (nskips > 0)
 			{
-				/* elsewhere, just walk on the following blocks */
-				nr_allocated += nr_blocks;
+				nskips = Min(nskips, (cl_long)scan->rs_numblocks);
+				gts->outer_zonemap_count += nskips;
+				/* move to the next block to be read */
+				scan->rs_numblocks -= nskips;
+				scan->rs_cblock += nskips;
+				if (scan->rs_cblock >= scan->rs_nblocks)
+					scan->rs_cblock = 0;
+				if (scan->rs_syncscan)
+					ss_report_location(relation, scan->rs_cblock);
+				/* end of the scan? */
+				if (scan->rs_cblock == scan->rs_startblock)
+					scan->rs_cblock = InvalidBlockNumber;
+				continue;
 			}
-			/* update # of blocks already allocated to workers */
-			gtss->nr_allocated = nr_allocated;
-			SpinLockRelease(&gtss->phscan.phs_mutex);
-
-			scan->rs_cblock = page;
-			scan->rs_numblocks = nr_blocks;
-			continue;
 		}
-		/* allocation of row-based PDS on demand */
+		/* allocation of PDS on demand */
 		if (!pds)
-		{
-			if (gts->nvme_sstate)
-				pds = PDS_create_block(gts->gcontext,
-									   RelationGetDescr(relation),
-									   gts->nvme_sstate);
-			else
-				pds = PDS_create_row(gts->gcontext,
-									 RelationGetDescr(relation),
-									 pgstrom_chunk_size());
-			pds->kds.table_oid = RelationGetRelid(relation);
-		}
+			pds = pgstromCreateScanChunk(gts, scan->rs_cblock);
 		/* scan next block */
 		if (!PDS_exec_heapscan(gts, pds))
 			break;
@@ -1218,8 +1730,19 @@ pgstromExecScanChunk(GpuTaskState *gts)
 	HeapScanDesc	scan = gts->css.ss.ss_currentScanDesc;
 	Bitmapset	   *brin_map;
 	cl_long			brin_range_sz = 0;
+	bool			use_ccache;
 	pgstrom_data_store *pds = NULL;
 
+	/* Arrow_fdw loads record batches without heap scan */
+	if (gts->af_state)
+	{
+		InstrStartNode(&gts->outer_instrument);
+		pds = ExecScanChunkArrowFdw(gts);
+		InstrStopNode(&gts->outer_instrument,
+					  !pds ? 0.0 : (double)pds->kds.nitems);
+		return pds;
+	}
+
 	/*
 	 * Setup scan-descriptor, if the scan is not parallel, of if we're
 	 * executing a scan that was intended to be parallel serially.
@@ -1248,10 +1771,12 @@ pgstromExecScanChunk(GpuTaskState *gts)
 	brin_map = gts->outer_index_map;
 	if (brin_map)
 		brin_range_sz = gts->outer_index_state->range_sz;
+	use_ccache = pgstromScanCanUseColumnarCache(gts);
 
 	if (gts->gtss)
 	{
-		pds = pgstromExecScanChunkParallel(gts, pds, brin_map, brin_range_sz);
+		pds = pgstromExecScanChunkParallel(gts, pds, brin_map, brin_range_sz,
+										   use_ccache);
 	}
 	else
 	{
@@ -1297,19 +1822,54 @@ pgstromExecScanChunk(GpuTaskState *gts)
 				}
 			}
 
-			/* allocation of row-based PDS on demand */
-			if (!pds)
+			/*
+			 * If any, check the zone map, then moves to the next range
+			 * boundary if no tuple can match in this range.
+			 */
+			if (gts->zm_state)
 			{
-				if (gts->nvme_sstate)
-					pds =  PDS_create_block(gts->gcontext,
-											RelationGetDescr(rel),
-											gts->nvme_sstate);
-				else
-					pds = PDS_create_row(gts->gcontext,
-										 RelationGetDescr(rel),
-										 pgstrom_chunk_size());
-				pds->kds.table_oid = RelationGetRelid(rel);
+				cl_long		nskips = pgstromZoneMapSkipBlocks(gts, page);
+
+				if (nskips > 0)
+				{
+					scan->rs_cblock = (BlockNumber)(page + nskips);
+					gts->outer_zonemap_count += nskips;
+					goto skip;
+				}
+			}
+
+			/*
+			 * If any, load the columnar cache of the chunk, unless the
+			 * chunk contains the start block of synchronized scan.
+			 */
+			if (use_ccache &&
+				(page & (CCACHE_CHUNK_NBLOCKS - 1)) == 0 &&
+				page + CCACHE_CHUNK_NBLOCKS <= (cl_long)scan->rs_nblocks &&
+				(scan->rs_startblock <= page ||
+				 scan->rs_startblock >= page + CCACHE_CHUNK_NBLOCKS))
+			{
+				pgstrom_data_store *pds_cc;
+
+				if (pds && pds->kds.nitems > 0)
+					break;	/* hand over the current PDS first */
+				pds_cc = pgstromTryLoadColumnarCache(gts, page);
+				if (pds_cc)
+				{
+					if (pds)
+						PDS_release(pds);
+					pds = NULL;
+					if (pds_cc->kds.nitems > 0)
+						pds = pds_cc;
+					else
+						PDS_release(pds_cc);
+					scan->rs_cblock = page + CCACHE_CHUNK_NBLOCKS;
+					goto skip;
+				}
 			}
+
+			/* allocation of PDS on demand */
+			if (!pds)
+				pds = pgstromCreateScanChunk(gts, scan->rs_cblock);
 			/* scan the next block */
 			if (!PDS_exec_heapscan(gts, pds))
 				break;		/* no more tuples we can store now! */
@@ -1324,6 +1884,9 @@ pgstromExecScanChunk(GpuTaskState *gts)
 			/* end of the scan? */
 			if (scan->rs_cblock == scan->rs_startblock)
 				scan->rs_cblock = InvalidBlockNumber;
+			/* columnar cache is returned as is */
+			if (pds && pds->kds.format == KDS_FORMAT_COLUMN)
+				break;
 		}
 	}
 
@@ -1367,6 +1930,12 @@ pgstromExecScanChunk(GpuTaskState *gts)
 		if (pds->kds.format == KDS_FORMAT_BLOCK)
 			gts->nvme_count += pds->nblocks_uncached;
 	}
+	/* NVMe-Strom emulation loads uncached blocks by itself */
+	if (pds &&
+		pds->kds.format == KDS_FORMAT_BLOCK &&
+		pds->nblocks_uncached > 0 &&
+		gts->nvme_sstate->emulated)
+		PDS_fillup_blocks_direct(pds, gts->nvme_sstate, gts->zm_state);
 	InstrStopNode(&gts->outer_instrument,
 				  !pds ? 0.0 : (double)pds->kds.nitems);
 	return pds;
@@ -1381,7 +1950,15 @@ pgstromRewindScanChunk(GpuTaskState *gts)
 	HeapScanDesc	scan = gts->css.ss.ss_currentScanDesc;
 
 	InstrEndLoop(&gts->outer_instrument);
+	if (gts->af_state)
+	{
+		ExecReScanArrowFdw(gts->af_state);
+		ExecScanReScan(&gts->css.ss);
+		return;
+	}
 	heap_rescan(scan, NULL);
+	pgstromExecRewindBrinIndexMap(gts);
+	pgstromExecRewindZoneMap(gts);
 #if PG_VERSION_NUM < 100000
 	/*
 	 * In PG9.6, re-initialization of DSM segment is a role of ReScan method,
@@ -1584,4 +2161,13 @@ pgstrom_init_relscan(void)
 							 PGC_USERSET,
                              GUC_NOT_IN_SAMPLE,
                              NULL, NULL, NULL);
+	/* pg_strom.enable_page_copy */
+	DefineCustomBoolVariable("pg_strom.enable_page_copy",
+							 "Enables whole-page copy of the buffered blocks",
+							 NULL,
+							 &pgstrom_enable_page_copy,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 }
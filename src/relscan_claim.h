@@ -0,0 +1,170 @@
+/*
+ * relscan_claim.h
+ *
+ * Block claims on the parallel relation scan. It is shared by relscan.c
+ * and the micro-benchmark (test/bench_blkalloc.c), so it depends on no
+ * PostgreSQL headers. The includer has to define the types and macros below
+ * prior to the inclusion.
+ *
+ *   uint64, bool
+ *   RELSCAN_ATOMIC_U64             ... type of the shared cursor
+ *   RELSCAN_ATOMIC_READ_U64(p)     ... reads the shared cursor
+ *   RELSCAN_ATOMIC_CAS_U64(p,e,n)  ... compare-and-swap on the shared cursor;
+ *                                      @e is updated to the current value on
+ *                                      failure
+ *   RELSCAN_BRIN_SKIPPED(map,pos)  ... true, if BRIN-index says no tuples can
+ *                                      match in the @pos'th range
+ * ----
+ * Copyright 2011-2018 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2018 (C) The PG-Strom Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef RELSCAN_CLAIM_H
+#define RELSCAN_CLAIM_H
+
+/*
+ * A claim is (remaining blocks) divided by (RELSCAN_CLAIM_DIVISOR * number
+ * of workers), but bounded by the limits.
+ */
+#define RELSCAN_CLAIM_DIVISOR		4
+#define RELSCAN_CLAIM_MIN_NBLOCKS	8
+
+typedef struct
+{
+	long		nblocks;		/* number of blocks of the relation */
+	long		startblock;		/* start block of the scan */
+	long		nr_workers;		/* number of workers including the leader */
+	long		nr_limit;		/* max number of blocks to be read at once */
+	long		relseg_size;	/* number of blocks per segment file */
+	const void *brin_map;		/* BRIN-map, or NULL if no BRIN-index */
+	long		brin_range_sz;	/* number of blocks per BRIN range */
+	long		chunk_nblocks;	/* number of blocks per columnar cache
+								 * chunk, or 0 if not available */
+} relscanClaimArgs;
+
+/*
+ * __relscanClaimWholeChunk - true, if the chunk which begins at @page can
+ * be claimed as a whole; no part of the chunk is skippable by BRIN-index.
+ */
+static inline bool
+__relscanClaimWholeChunk(const relscanClaimArgs *args,
+						 uint64 nr_allocated, long page)
+{
+	long		chunk_nblocks = args->chunk_nblocks;
+	long		pos;
+
+	if ((page % chunk_nblocks) != 0 ||
+		page + chunk_nblocks > args->nblocks ||
+		(long)nr_allocated + chunk_nblocks > args->nblocks ||
+		chunk_nblocks > args->nr_limit)
+		return false;
+	if (args->brin_map)
+	{
+		for (pos = page / args->brin_range_sz;
+			 pos <= (page + chunk_nblocks - 1) / args->brin_range_sz;
+			 pos++)
+		{
+			if (RELSCAN_BRIN_SKIPPED(args->brin_map, pos))
+				return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * __relscanClaimBlocks - claims a continuous range of blocks by advance of
+ * the shared cursor (@nr_allocated_p) with compare-and-swap.
+ *
+ * It returns the number of claimed blocks, or 0 if end of the scan.
+ * If @p_skipped is set, the claimed blocks shall be skipped because the
+ * BRIN-index says no tuples can match.
+ */
+static inline long
+__relscanClaimBlocks(RELSCAN_ATOMIC_U64 *nr_allocated_p,
+					 const relscanClaimArgs *args,
+					 long *p_page, bool *p_skipped)
+{
+	long		nblocks = args->nblocks;
+	uint64		nr_allocated = RELSCAN_ATOMIC_READ_U64(nr_allocated_p);
+
+	for (;;)
+	{
+		long		remain;
+		long		nr_blocks;
+		long		page;
+		bool		skipped = false;
+
+		if (nr_allocated >= (uint64)nblocks)
+			return 0;		/* end of the scan */
+		remain = nblocks - (long)nr_allocated;
+		page = (args->startblock + (long)nr_allocated) % nblocks;
+
+		/* adaptive claim size; shrinks toward the tail of the scan */
+		nr_blocks = remain / (RELSCAN_CLAIM_DIVISOR * args->nr_workers);
+		if (nr_blocks < RELSCAN_CLAIM_MIN_NBLOCKS)
+			nr_blocks = RELSCAN_CLAIM_MIN_NBLOCKS;
+		if (nr_blocks > args->nr_limit)
+			nr_blocks = args->nr_limit;
+		if (nr_blocks > remain)
+			nr_blocks = remain;
+		if (page + nr_blocks > nblocks)
+			nr_blocks = nblocks - page;
+
+		if (args->brin_map &&
+			RELSCAN_BRIN_SKIPPED(args->brin_map, page / args->brin_range_sz))
+		{
+			long	e_page = (page / args->brin_range_sz + 1) *
+							 args->brin_range_sz;
+
+			/* skip the rest of this range */
+			if (e_page > nblocks)
+				e_page = nblocks;
+			nr_blocks = e_page - page;
+			if (nr_blocks > remain)
+				nr_blocks = remain;
+			skipped = true;
+		}
+		else if (args->chunk_nblocks > 0 &&
+				 __relscanClaimWholeChunk(args, nr_allocated, page))
+		{
+			/*
+			 * If columnar cache is available, we allocate an entire chunk
+			 * to a worker at once, to load the cached chunk if any.
+			 */
+			nr_blocks = args->chunk_nblocks;
+		}
+		else if (args->brin_map)
+		{
+			long	e_page = (page / args->brin_range_sz + 1) *
+							 args->brin_range_sz;
+
+			/* never read the blocks across BRIN range boundary */
+			if (page + nr_blocks > e_page)
+				nr_blocks = e_page - page;
+		}
+		/* should never read the blocks across segment boundary */
+		if ((page / args->relseg_size) !=
+			(page + nr_blocks - 1) / args->relseg_size)
+			nr_blocks = args->relseg_size - (page % args->relseg_size);
+
+		/* on failure, @nr_allocated is updated to the current value */
+		if (RELSCAN_ATOMIC_CAS_U64(nr_allocated_p,
+								   &nr_allocated,
+								   nr_allocated + nr_blocks))
+		{
+			*p_page = page;
+			*p_skipped = skipped;
+			return nr_blocks;
+		}
+	}
+}
+
+#endif	/* RELSCAN_CLAIM_H */
@@ -0,0 +1,1140 @@
+/*
+ * zonemap.c
+ *
+ * Per block-range zone map (min/max/null-count) on the shared memory,
+ * gathered as a side effect of the heap scan.
+ * ----
+ * Copyright 2011-2018 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2018 (C) The PG-Strom Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "pg_strom.h"
+
+/*
+ * NOTE: A zone map entry summarizes a particular column of a block range
+ * with ZONEMAP_RANGE_NBLOCKS blocks (same size with a data chunk).
+ * It is built only when all the blocks in the range are all-visible, and
+ * it remembers LSN of the visibility-map pages which cover the head and
+ * the tail of the range. Any heap writes clear the all-visible bit of
+ * the block, and vacuum that sets the bit again updates LSN of the
+ * visibility-map page, so we can detect staled entries without triggers.
+ * Blocks of a range may be observed in any order, and either from the
+ * shared buffer or from the storage (NVMe-Strom emulation); a range under
+ * construction remembers which blocks are already observed by a bitmap.
+ * Blocks loaded by the real NVMe-Strom go to GPU directly, so we cannot
+ * observe them.
+ */
+#define ZONEMAP_RANGE_NBLOCKS	((64UL << 20) / BLCKSZ)
+#define ZONEMAP_MAX_PENDING_RANGES	4
+
+/*
+ * Layout of the visibility-map page; see access/heap/visibilitymap.c.
+ * All-visible bit is the lower bit of the BITS_PER_HEAPBLOCK bits of
+ * the heap block, so ZONEMAP_VM_ALL_VISIBLE_MASK picks up all-visible
+ * bits of 32 heap blocks at once.
+ */
+#define ZONEMAP_VM_MAPSIZE			(BLCKSZ - MAXALIGN(SizeOfPageHeaderData))
+#define ZONEMAP_VM_HEAPBLOCKS_PER_BYTE	(BITS_PER_BYTE / BITS_PER_HEAPBLOCK)
+#define ZONEMAP_VM_HEAPBLOCKS_PER_PAGE	\
+	(ZONEMAP_VM_MAPSIZE * ZONEMAP_VM_HEAPBLOCKS_PER_BYTE)
+#define ZONEMAP_VM_ALL_VISIBLE_MASK	UINT64CONST(0x5555555555555555)
+
+/*
+ * zoneMapEntry - an entry of zone map on the shared memory
+ */
+typedef struct
+{
+	dlist_node	hash_chain;		/* link to the hash slot or free list */
+	dlist_node	lru_chain;		/* link to LRU list */
+	pg_crc32	hash;			/* hash value */
+	Oid			database_oid;	/* OID of the database */
+	Oid			table_oid;		/* OID of the table */
+	Oid			relfilenode;	/* relfilenode of the table on build */
+	BlockNumber	block_nr;		/* head block of the range */
+	AttrNumber	attnum;			/* attribute number of the column */
+	Oid			atttypid;		/* type of the column on build */
+	XLogRecPtr	vm_lsn_head;	/* LSN of the VM page of the head block */
+	XLogRecPtr	vm_lsn_tail;	/* LSN of the VM page of the tail block */
+	cl_uint		nitems;			/* number of tuples in the range */
+	cl_uint		nullcount;		/* number of NULLs in the range */
+	Datum		min_value;		/* valid only if nitems > nullcount */
+	Datum		max_value;		/* valid only if nitems > nullcount */
+} zoneMapEntry;
+
+/*
+ * zoneMapHead - shared state of the zone map
+ */
+typedef struct
+{
+	slock_t		lock;
+	dlist_head	lru_list;
+	dlist_head	free_list;
+	dlist_head	slots[FLEXIBLE_ARRAY_MEMBER];
+} zoneMapHead;
+
+/*
+ * zoneMapColumn - a column to be summarized
+ */
+typedef struct
+{
+	AttrNumber	attnum;
+	Oid			atttypid;
+	Oid			attcollation;
+	FmgrInfo	cmp_proc;		/* btree comparison function */
+} zoneMapColumn;
+
+/*
+ * zoneMapAccum - accumulator of a column in the range under construction
+ */
+typedef struct
+{
+	cl_uint		nullcount;
+	bool		has_value;
+	Datum		min_value;
+	Datum		max_value;
+} zoneMapAccum;
+
+/*
+ * zoneMapRange - a range under construction
+ */
+typedef struct
+{
+	BlockNumber	range;			/* head block, or InvalidBlockNumber */
+	bool		failed;			/* range contains non-all-visible blocks */
+	cl_uint		nblocks;		/* # of blocks already observed */
+	cl_uint		generation;		/* to choose the victim range */
+	XLogRecPtr	lsn_head;
+	XLogRecPtr	lsn_tail;
+	cl_uint		nitems;
+	bits8		observed[ZONEMAP_RANGE_NBLOCKS / BITS_PER_BYTE];
+	zoneMapAccum *accums;		/* per column accumulator */
+} zoneMapRange;
+
+/*
+ * zoneMapHint - a qualifier we can evaluate on the zone map
+ */
+#define ZONEMAP_HINT__OPEXPR		1
+#define ZONEMAP_HINT__IS_NULL		2
+#define ZONEMAP_HINT__IS_NOT_NULL	3
+
+typedef struct
+{
+	int			kind;
+	int			cindex;			/* index of zoneMapState->columns */
+	Oid			collid;
+	Datum		value;
+	bool		use_min;
+	bool		use_max;
+	FmgrInfo	flinfo_min;
+	FmgrInfo	flinfo_max;
+} zoneMapHint;
+
+/*
+ * zoneMapState - per-scan state of the zone map
+ */
+struct zoneMapState
+{
+	Relation	relation;
+	MemoryContext memcxt;
+	List	   *hints;
+	List	   *rt_hints;		/* hints given at run-time, if any */
+	int			ncols;
+	zoneMapColumn *columns;
+	Buffer		vm_buffer;
+	/* cache of the last decision */
+	BlockNumber	last_range;
+	bool		last_skip;
+	BlockNumber	nblocks;		/* # of blocks to be scanned, for EXPLAIN */
+	/* ranges under construction */
+	cl_uint		generation;
+	zoneMapRange *pending[ZONEMAP_MAX_PENDING_RANGES];
+};
+
+/* static variables */
+static shmem_startup_hook_type shmem_startup_next = NULL;
+static bool			pgstrom_enable_zonemap;		/* GUC */
+static int			zonemap_num_entries;		/* GUC */
+static int			zonemap_num_slots;
+static bool			zonemap_shmem_requested = false;
+static zoneMapHead *zonemap_head = NULL;		/* shmem */
+
+/*
+ * zonemap_compute_hashvalue
+ */
+static inline pg_crc32
+zonemap_compute_hashvalue(Oid database_oid, Oid table_oid,
+						  BlockNumber block_nr, AttrNumber attnum)
+{
+	pg_crc32	hash;
+
+	Assert((block_nr % ZONEMAP_RANGE_NBLOCKS) == 0);
+	INIT_LEGACY_CRC32(hash);
+	COMP_LEGACY_CRC32(hash, &database_oid, sizeof(Oid));
+	COMP_LEGACY_CRC32(hash, &table_oid, sizeof(Oid));
+	COMP_LEGACY_CRC32(hash, &block_nr, sizeof(BlockNumber));
+	COMP_LEGACY_CRC32(hash, &attnum, sizeof(AttrNumber));
+	FIN_LEGACY_CRC32(hash);
+
+	return hash;
+}
+
+/*
+ * zonemap_lookup_entry - lookup an entry; caller must hold the lock
+ */
+static zoneMapEntry *
+zonemap_lookup_entry(pg_crc32 hash, Oid table_oid,
+					 BlockNumber block_nr, AttrNumber attnum)
+{
+	int			hindex = hash % zonemap_num_slots;
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &zonemap_head->slots[hindex])
+	{
+		zoneMapEntry *entry = dlist_container(zoneMapEntry,
+											  hash_chain, iter.cur);
+		if (entry->hash == hash &&
+			entry->database_oid == MyDatabaseId &&
+			entry->table_oid == table_oid &&
+			entry->block_nr == block_nr &&
+			entry->attnum == attnum)
+			return entry;
+	}
+	return NULL;
+}
+
+/*
+ * zonemap_release_entry - detach the entry; caller must hold the lock
+ */
+static void
+zonemap_release_entry(zoneMapEntry *entry)
+{
+	dlist_delete(&entry->hash_chain);
+	dlist_delete(&entry->lru_chain);
+	memset(entry, 0, sizeof(zoneMapEntry));
+	dlist_push_head(&zonemap_head->free_list, &entry->hash_chain);
+}
+
+/*
+ * zonemap_read_vm_lsn - LSN of the visibility-map page which covers
+ * the supplied block, or InvalidXLogRecPtr if not available
+ */
+static XLogRecPtr
+zonemap_read_vm_lsn(zoneMapState *zm_state, BlockNumber blknum)
+{
+	visibilitymap_get_status(zm_state->relation, blknum,
+							 &zm_state->vm_buffer);
+	if (!BufferIsValid(zm_state->vm_buffer))
+		return InvalidXLogRecPtr;
+	return BufferGetLSNAtomic(zm_state->vm_buffer);
+}
+
+/*
+ * zonemap_add_column - add a column to be summarized, or returns index of
+ * the column already added. -1 shall be returned if not supported.
+ */
+static int
+zonemap_add_column(zoneMapState *zm_state, AttrNumber attnum)
+{
+	TupleDesc	tupdesc = RelationGetDescr(zm_state->relation);
+	Form_pg_attribute attr;
+	TypeCacheEntry *tcache;
+	zoneMapColumn *zm_col;
+	int			i;
+
+	if (attnum <= 0 || attnum > tupdesc->natts)
+		return -1;
+	for (i=0; i < zm_state->ncols; i++)
+	{
+		if (zm_state->columns[i].attnum == attnum)
+			return i;
+	}
+	attr = tupleDescAttr(tupdesc, attnum - 1);
+	if (attr->attisdropped)
+		return -1;
+	/* only fixed-length inline types are summarized */
+	if (!attr->attbyval || attr->attlen <= 0)
+		return -1;
+	tcache = lookup_type_cache(attr->atttypid, TYPECACHE_CMP_PROC_FINFO);
+	if (!OidIsValid(tcache->cmp_proc_finfo.fn_oid))
+		return -1;
+
+	if (!zm_state->columns)
+		zm_state->columns = palloc0(sizeof(zoneMapColumn) * tupdesc->natts);
+	zm_col = &zm_state->columns[zm_state->ncols];
+	zm_col->attnum = attnum;
+	zm_col->atttypid = attr->atttypid;
+	zm_col->attcollation = attr->attcollation;
+	fmgr_info_copy(&zm_col->cmp_proc, &tcache->cmp_proc_finfo,
+				   CurrentMemoryContext);
+
+	return zm_state->ncols++;
+}
+
+/*
+ * zonemap_add_hint - checks whether the qualifier is (Var OP Const) form,
+ * or NullTest on the Var, then adds a hint if possible.
+ */
+static void
+zonemap_add_hint(zoneMapState *zm_state, Expr *expr)
+{
+	zoneMapHint *hint;
+	Var		   *var;
+	int			cindex;
+
+	if (IsA(expr, NullTest))
+	{
+		NullTest   *nulltest = (NullTest *) expr;
+
+		if (!IsA(nulltest->arg, Var) || nulltest->argisrow)
+			return;
+		var = (Var *) nulltest->arg;
+		cindex = zonemap_add_column(zm_state, var->varattno);
+		if (cindex < 0)
+			return;
+		hint = palloc0(sizeof(zoneMapHint));
+		hint->kind = (nulltest->nulltesttype == IS_NULL
+					  ? ZONEMAP_HINT__IS_NULL
+					  : ZONEMAP_HINT__IS_NOT_NULL);
+		hint->cindex = cindex;
+	}
+	else if (IsA(expr, OpExpr))
+	{
+		OpExpr	   *op = (OpExpr *) expr;
+		Const	   *con;
+		Oid			opno;
+		TypeCacheEntry *tcache;
+		int			strategy;
+
+		if (list_length(op->args) != 2)
+			return;
+		if (IsA(linitial(op->args), Var) && IsA(lsecond(op->args), Const))
+		{
+			var = linitial(op->args);
+			con = lsecond(op->args);
+			opno = op->opno;
+		}
+		else if (IsA(linitial(op->args), Const) &&
+				 IsA(lsecond(op->args), Var))
+		{
+			var = lsecond(op->args);
+			con = linitial(op->args);
+			opno = get_commutator(op->opno);
+			if (!OidIsValid(opno))
+				return;
+		}
+		else
+			return;
+
+		if (con->constisnull)
+			return;
+		tcache = lookup_type_cache(var->vartype, TYPECACHE_BTREE_OPFAMILY);
+		if (!OidIsValid(tcache->btree_opf))
+			return;
+		strategy = get_op_opfamily_strategy(opno, tcache->btree_opf);
+		if (strategy < BTLessStrategyNumber ||
+			strategy > BTGreaterStrategyNumber)
+			return;
+		cindex = zonemap_add_column(zm_state, var->varattno);
+		if (cindex < 0)
+			return;
+
+		hint = palloc0(sizeof(zoneMapHint));
+		hint->kind = ZONEMAP_HINT__OPEXPR;
+		hint->cindex = cindex;
+		hint->collid = op->inputcollid;
+		hint->value = con->constvalue;
+		switch (strategy)
+		{
+			case BTLessStrategyNumber:
+			case BTLessEqualStrategyNumber:
+				/* skip, if NOT (min_value OP const) */
+				hint->use_min = true;
+				fmgr_info(get_opcode(opno), &hint->flinfo_min);
+				break;
+
+			case BTGreaterStrategyNumber:
+			case BTGreaterEqualStrategyNumber:
+				/* skip, if NOT (max_value OP const) */
+				hint->use_max = true;
+				fmgr_info(get_opcode(opno), &hint->flinfo_max);
+				break;
+
+			case BTEqualStrategyNumber:
+				/* skip, if NOT (min_value <= const AND max_value >= const) */
+				{
+					Oid		le_opno = get_opfamily_member(tcache->btree_opf,
+														  var->vartype,
+														  con->consttype,
+													BTLessEqualStrategyNumber);
+					Oid		ge_opno = get_opfamily_member(tcache->btree_opf,
+														  var->vartype,
+														  con->consttype,
+												BTGreaterEqualStrategyNumber);
+					if (!OidIsValid(le_opno) || !OidIsValid(ge_opno))
+					{
+						pfree(hint);
+						return;
+					}
+					hint->use_min = true;
+					hint->use_max = true;
+					fmgr_info(get_opcode(le_opno), &hint->flinfo_min);
+					fmgr_info(get_opcode(ge_opno), &hint->flinfo_max);
+				}
+				break;
+
+			default:
+				pfree(hint);
+				return;
+		}
+	}
+	else
+		return;
+
+	zm_state->hints = lappend(zm_state->hints, hint);
+}
+
+static void
+zonemap_setup_hints(zoneMapState *zm_state, List *quals)
+{
+	ListCell   *lc;
+
+	foreach (lc, quals)
+	{
+		Expr   *expr = lfirst(lc);
+
+		if (IsA(expr, RestrictInfo))
+			expr = ((RestrictInfo *) expr)->clause;
+		if (and_clause((Node *) expr))
+			zonemap_setup_hints(zm_state, ((BoolExpr *) expr)->args);
+		else
+			zonemap_add_hint(zm_state, expr);
+	}
+}
+
+/*
+ * zonemap_reset_ranges - discards the ranges under construction
+ */
+static void
+zonemap_reset_ranges(zoneMapState *zm_state)
+{
+	int			i;
+
+	for (i=0; i < ZONEMAP_MAX_PENDING_RANGES; i++)
+	{
+		if (zm_state->pending[i])
+			zm_state->pending[i]->range = InvalidBlockNumber;
+	}
+}
+
+/*
+ * zonemap_create_state - returns a new zoneMapState, or NULL if the zone map
+ * is not available on the relation
+ */
+static zoneMapState *
+zonemap_create_state(Relation relation)
+{
+	zoneMapState *zm_state;
+
+	/* shared memory is acquired only if enabled on the startup */
+	if (!pgstrom_enable_zonemap || !zonemap_head)
+		return NULL;
+	if (!relation ||
+		(RelationGetForm(relation)->relkind != RELKIND_RELATION &&
+		 RelationGetForm(relation)->relkind != RELKIND_MATVIEW) ||
+		!RelationNeedsWAL(relation))
+		return NULL;
+
+	zm_state = palloc0(sizeof(zoneMapState));
+	zm_state->relation = relation;
+	zm_state->memcxt = CurrentMemoryContext;
+	zm_state->vm_buffer = InvalidBuffer;
+	zm_state->last_range = InvalidBlockNumber;
+
+	return zm_state;
+}
+
+/*
+ * pgstromExecInitZoneMap
+ */
+void
+pgstromExecInitZoneMap(GpuTaskState *gts, List *outer_quals)
+{
+	zoneMapState *zm_state;
+
+	gts->zm_state = NULL;
+	zm_state = zonemap_create_state(gts->css.ss.ss_currentRelation);
+	if (!zm_state)
+		return;
+	zonemap_setup_hints(zm_state, outer_quals);
+	if (zm_state->hints == NIL)
+	{
+		pfree(zm_state);
+		return;
+	}
+	gts->zm_state = zm_state;
+}
+
+/*
+ * pgstromExecSetZoneMapRuntimeQuals
+ *
+ * It replaces the qualifiers which are known only at run-time, like the
+ * range of join-keys on the inner side of GpuJoin. Zone map state shall
+ * be constructed on demand, even if scan qualifiers had no hints; the
+ * column referenced by the qualifiers is also summarized by this scan.
+ * It has to be called prior to the first block is scanned.
+ */
+void
+pgstromExecSetZoneMapRuntimeQuals(GpuTaskState *gts, List *quals)
+{
+	zoneMapState *zm_state = gts->zm_state;
+	List	   *hints_saved;
+
+	if (!zm_state)
+	{
+		if (quals == NIL)
+			return;
+		zm_state = zonemap_create_state(gts->css.ss.ss_currentRelation);
+		if (!zm_state)
+			return;
+		gts->zm_state = zm_state;
+	}
+	list_free_deep(zm_state->rt_hints);
+	zm_state->rt_hints = NIL;
+
+	hints_saved = zm_state->hints;
+	zm_state->hints = NIL;
+	zonemap_setup_hints(zm_state, quals);
+	zm_state->rt_hints = zm_state->hints;
+	zm_state->hints = hints_saved;
+	/* decision of the last range is no longer valid */
+	zm_state->last_range = InvalidBlockNumber;
+	/* ranges under construction may lack the newly added columns */
+	zonemap_reset_ranges(zm_state);
+}
+
+/*
+ * zonemap_eval_hint - true, if the hint tells no rows in the range can
+ * satisfy the qualifier
+ */
+static bool
+zonemap_eval_hint(zoneMapHint *hint, zoneMapEntry *entry)
+{
+	/* no tuples in the range */
+	if (entry->nitems == 0)
+		return true;
+
+	switch (hint->kind)
+	{
+		case ZONEMAP_HINT__IS_NULL:
+			return (entry->nullcount == 0);
+		case ZONEMAP_HINT__IS_NOT_NULL:
+			return (entry->nullcount == entry->nitems);
+		case ZONEMAP_HINT__OPEXPR:
+			/* strict operators never match NULLs */
+			if (entry->nullcount == entry->nitems)
+				return true;
+			if (hint->use_min &&
+				!DatumGetBool(FunctionCall2Coll(&hint->flinfo_min,
+												hint->collid,
+												entry->min_value,
+												hint->value)))
+				return true;
+			if (hint->use_max &&
+				!DatumGetBool(FunctionCall2Coll(&hint->flinfo_max,
+												hint->collid,
+												entry->max_value,
+												hint->value)))
+				return true;
+			break;
+		default:
+			elog(ERROR, "Bug? unexpected zone map hint: %d", hint->kind);
+	}
+	return false;
+}
+
+/*
+ * zonemap_range_all_visible - true, if all the blocks in the range are
+ * all-visible. Unlike VM_ALL_VISIBLE() per block, it walks on the bitmap
+ * of the visibility-map page by 64bit words. Like visibilitymap_get_status,
+ * we don't lock the visibility-map page to read the bits.
+ */
+static bool
+zonemap_range_all_visible(zoneMapState *zm_state, BlockNumber range)
+{
+	BlockNumber	blknum = range;
+	BlockNumber	end = range + ZONEMAP_RANGE_NBLOCKS;
+
+	while (blknum < end)
+	{
+		cl_uint		pg_offset = blknum % ZONEMAP_VM_HEAPBLOCKS_PER_PAGE;
+		cl_uint		nblocks = Min(end - blknum,
+								  ZONEMAP_VM_HEAPBLOCKS_PER_PAGE - pg_offset);
+		cl_uint		nbytes = nblocks / ZONEMAP_VM_HEAPBLOCKS_PER_BYTE;
+		uint8	   *map;
+		uint64		word;
+		cl_uint		i;
+
+		/* also pins the visibility-map page which covers the block */
+		if ((visibilitymap_get_status(zm_state->relation, blknum,
+									  &zm_state->vm_buffer)
+			 & VISIBILITYMAP_ALL_VISIBLE) == 0)
+			return false;
+		map = (uint8 *)PageGetContents(BufferGetPage(zm_state->vm_buffer))
+			+ pg_offset / ZONEMAP_VM_HEAPBLOCKS_PER_BYTE;
+		/* range head and page head are aligned to the byte boundary */
+		Assert(nblocks % ZONEMAP_VM_HEAPBLOCKS_PER_BYTE == 0);
+		for (i=0; i + sizeof(uint64) <= nbytes; i += sizeof(uint64))
+		{
+			memcpy(&word, map + i, sizeof(uint64));
+			if ((word & ZONEMAP_VM_ALL_VISIBLE_MASK) !=
+				ZONEMAP_VM_ALL_VISIBLE_MASK)
+				return false;
+		}
+		for (; i < nbytes; i++)
+		{
+			if ((map[i] & (uint8)ZONEMAP_VM_ALL_VISIBLE_MASK) !=
+				(uint8)ZONEMAP_VM_ALL_VISIBLE_MASK)
+				return false;
+		}
+		blknum += nblocks;
+	}
+	return true;
+}
+
+/*
+ * zonemap_check_range - true, if the range never contains rows which
+ * satisfy the scan qualifiers according to the zone map
+ */
+static bool
+zonemap_check_range(zoneMapState *zm_state, BlockNumber range)
+{
+	Relation	relation = zm_state->relation;
+	Oid			table_oid = RelationGetRelid(relation);
+	Oid			relfilenode = relation->rd_node.relNode;
+	XLogRecPtr	vm_lsn_head;
+	XLogRecPtr	vm_lsn_tail;
+	zoneMapEntry *entries;
+	bool	   *found;
+	bool		can_skip = false;
+	bool		any_found = false;
+	ListCell   *lc;
+	int			i;
+
+	vm_lsn_head = zonemap_read_vm_lsn(zm_state, range);
+	vm_lsn_tail = zonemap_read_vm_lsn(zm_state,
+									  range + ZONEMAP_RANGE_NBLOCKS - 1);
+	if (XLogRecPtrIsInvalid(vm_lsn_head) ||
+		XLogRecPtrIsInvalid(vm_lsn_tail))
+		return false;
+
+	/* fetch the entries for each column */
+	entries = alloca(sizeof(zoneMapEntry) * zm_state->ncols);
+	found = alloca(sizeof(bool) * zm_state->ncols);
+	SpinLockAcquire(&zonemap_head->lock);
+	for (i=0; i < zm_state->ncols; i++)
+	{
+		zoneMapColumn *zm_col = &zm_state->columns[i];
+		zoneMapEntry *entry;
+		pg_crc32	hash;
+
+		hash = zonemap_compute_hashvalue(MyDatabaseId, table_oid,
+										 range, zm_col->attnum);
+		entry = zonemap_lookup_entry(hash, table_oid,
+									 range, zm_col->attnum);
+		found[i] = false;
+		if (!entry)
+			continue;
+		if (entry->relfilenode != relfilenode ||
+			entry->atttypid != zm_col->atttypid ||
+			entry->vm_lsn_head != vm_lsn_head ||
+			entry->vm_lsn_tail != vm_lsn_tail)
+		{
+			/* staled entry */
+			zonemap_release_entry(entry);
+			continue;
+		}
+		memcpy(&entries[i], entry, sizeof(zoneMapEntry));
+		found[i] = any_found = true;
+		/* move to the LRU head */
+		dlist_move_head(&zonemap_head->lru_list, &entry->lru_chain);
+	}
+	SpinLockRelease(&zonemap_head->lock);
+
+	if (!any_found)
+		return false;
+
+	/* evaluation of the hints, including the run-time ones */
+	foreach (lc, zm_state->hints)
+	{
+		zoneMapHint *hint = lfirst(lc);
+
+		if (found[hint->cindex] &&
+			zonemap_eval_hint(hint, &entries[hint->cindex]))
+		{
+			can_skip = true;
+			break;
+		}
+	}
+	if (!can_skip)
+	{
+		foreach (lc, zm_state->rt_hints)
+		{
+			zoneMapHint *hint = lfirst(lc);
+
+			if (found[hint->cindex] &&
+				zonemap_eval_hint(hint, &entries[hint->cindex]))
+			{
+				can_skip = true;
+				break;
+			}
+		}
+	}
+	if (!can_skip)
+		return false;
+
+	/*
+	 * Heap writes clear all-visible bit of the modified blocks, but does not
+	 * update LSN of the visibility-map page. So, we have to ensure all the
+	 * blocks in the range are still all-visible.
+	 */
+	if (!zonemap_range_all_visible(zm_state, range))
+	{
+		SpinLockAcquire(&zonemap_head->lock);
+		for (i=0; i < zm_state->ncols; i++)
+		{
+			zoneMapColumn *zm_col = &zm_state->columns[i];
+			zoneMapEntry *entry;
+			pg_crc32	hash;
+
+			if (!found[i])
+				continue;
+			hash = zonemap_compute_hashvalue(MyDatabaseId, table_oid,
+											 range, zm_col->attnum);
+			entry = zonemap_lookup_entry(hash, table_oid,
+										 range, zm_col->attnum);
+			if (entry)
+				zonemap_release_entry(entry);
+		}
+		SpinLockRelease(&zonemap_head->lock);
+		return false;
+	}
+	return true;
+}
+
+/*
+ * pgstromZoneMapSkipBlocks - returns number of blocks to be skipped from
+ * the supplied block, or zero if we have to read the block.
+ */
+cl_long
+pgstromZoneMapSkipBlocks(GpuTaskState *gts, BlockNumber page)
+{
+	zoneMapState *zm_state = gts->zm_state;
+	HeapScanDesc scan = gts->css.ss.ss_currentScanDesc;
+	BlockNumber	range;
+
+	if (!zm_state)
+		return 0;
+	zm_state->nblocks = scan->rs_nblocks;
+	range = page - (page % ZONEMAP_RANGE_NBLOCKS);
+	/* range must be scanned entirely, and not contain the start block */
+	if ((cl_long)range + ZONEMAP_RANGE_NBLOCKS > (cl_long)scan->rs_nblocks ||
+		(scan->rs_startblock > range &&
+		 scan->rs_startblock < range + ZONEMAP_RANGE_NBLOCKS))
+		return 0;
+
+	if (zm_state->last_range != range)
+	{
+		zm_state->last_range = range;
+		zm_state->last_skip = zonemap_check_range(zm_state, range);
+	}
+	if (!zm_state->last_skip)
+		return 0;
+	return (cl_long)(range + ZONEMAP_RANGE_NBLOCKS - page);
+}
+
+/*
+ * zonemap_store_entries - save the zone map of the completed range
+ */
+static void
+zonemap_store_entries(zoneMapState *zm_state, zoneMapRange *zm_range)
+{
+	Relation	relation = zm_state->relation;
+	Oid			table_oid = RelationGetRelid(relation);
+	BlockNumber	range = zm_range->range;
+	int			i;
+
+	SpinLockAcquire(&zonemap_head->lock);
+	for (i=0; i < zm_state->ncols; i++)
+	{
+		zoneMapColumn *zm_col = &zm_state->columns[i];
+		zoneMapAccum *zm_acc = &zm_range->accums[i];
+		zoneMapEntry *entry;
+		pg_crc32	hash;
+
+		hash = zonemap_compute_hashvalue(MyDatabaseId, table_oid,
+										 range, zm_col->attnum);
+		entry = zonemap_lookup_entry(hash, table_oid,
+									 range, zm_col->attnum);
+		if (entry)
+			dlist_move_head(&zonemap_head->lru_list, &entry->lru_chain);
+		else
+		{
+			if (!dlist_is_empty(&zonemap_head->free_list))
+			{
+				entry = dlist_container(zoneMapEntry, hash_chain,
+							dlist_pop_head_node(&zonemap_head->free_list));
+			}
+			else
+			{
+				/* evict the least recently used entry */
+				Assert(!dlist_is_empty(&zonemap_head->lru_list));
+				entry = dlist_container(zoneMapEntry, lru_chain,
+							dlist_tail_node(&zonemap_head->lru_list));
+				dlist_delete(&entry->hash_chain);
+				dlist_delete(&entry->lru_chain);
+			}
+			memset(entry, 0, sizeof(zoneMapEntry));
+			entry->hash = hash;
+			entry->database_oid = MyDatabaseId;
+			entry->table_oid = table_oid;
+			entry->block_nr = range;
+			entry->attnum = zm_col->attnum;
+			dlist_push_head(&zonemap_head->slots[hash % zonemap_num_slots],
+							&entry->hash_chain);
+			dlist_push_head(&zonemap_head->lru_list, &entry->lru_chain);
+		}
+		entry->relfilenode = relation->rd_node.relNode;
+		entry->atttypid = zm_col->atttypid;
+		entry->vm_lsn_head = zm_range->lsn_head;
+		entry->vm_lsn_tail = zm_range->lsn_tail;
+		entry->nitems = zm_range->nitems;
+		entry->nullcount = zm_acc->nullcount;
+		entry->min_value = (zm_acc->has_value ? zm_acc->min_value : 0);
+		entry->max_value = (zm_acc->has_value ? zm_acc->max_value : 0);
+	}
+	SpinLockRelease(&zonemap_head->lock);
+}
+
+/*
+ * zonemap_get_range - returns the range under construction which contains
+ * the supplied block. A new range is set up on demand, by recycling the
+ * oldest one if all the slots are in use. NULL shall be returned if the
+ * block cannot be summarized.
+ */
+static zoneMapRange *
+zonemap_get_range(zoneMapState *zm_state, BlockNumber blknum)
+{
+	BlockNumber	range = blknum - (blknum % ZONEMAP_RANGE_NBLOCKS);
+	zoneMapRange *zm_range = NULL;
+	int			i;
+
+	for (i=0; i < ZONEMAP_MAX_PENDING_RANGES; i++)
+	{
+		zoneMapRange *temp = zm_state->pending[i];
+
+		if (temp && temp->range == range)
+			return (temp->failed ? NULL : temp);
+	}
+
+	/* choose an empty or the oldest slot */
+	for (i=0; i < ZONEMAP_MAX_PENDING_RANGES; i++)
+	{
+		zoneMapRange *temp = zm_state->pending[i];
+
+		if (!temp)
+		{
+			TupleDesc	tupdesc = RelationGetDescr(zm_state->relation);
+
+			temp = MemoryContextAlloc(zm_state->memcxt,
+									  sizeof(zoneMapRange));
+			temp->accums = MemoryContextAlloc(zm_state->memcxt,
+											  sizeof(zoneMapAccum) *
+											  Max(tupdesc->natts, 1));
+			zm_state->pending[i] = zm_range = temp;
+			break;
+		}
+		if (temp->range == InvalidBlockNumber)
+		{
+			zm_range = temp;
+			break;
+		}
+		if (!zm_range || temp->generation < zm_range->generation)
+			zm_range = temp;
+	}
+	Assert(zm_range != NULL);
+
+	zm_range->range = range;
+	zm_range->generation = zm_state->generation++;
+	zm_range->nblocks = 0;
+	zm_range->nitems = 0;
+	memset(zm_range->observed, 0, sizeof(zm_range->observed));
+	memset(zm_range->accums, 0, sizeof(zoneMapAccum) * zm_state->ncols);
+	/* range must be filled up with blocks */
+	if ((cl_long)range + ZONEMAP_RANGE_NBLOCKS >
+		(cl_long)RelationGetNumberOfBlocks(zm_state->relation))
+	{
+		zm_range->failed = true;
+		return NULL;
+	}
+	zm_range->lsn_head = zonemap_read_vm_lsn(zm_state, range);
+	zm_range->lsn_tail = zonemap_read_vm_lsn(zm_state, range +
+											 ZONEMAP_RANGE_NBLOCKS - 1);
+	zm_range->failed = (XLogRecPtrIsInvalid(zm_range->lsn_head) ||
+						XLogRecPtrIsInvalid(zm_range->lsn_tail));
+	return (zm_range->failed ? NULL : zm_range);
+}
+
+/*
+ * pgstromZoneMapExpect - tells the block shall be loaded from the storage
+ * later. LSN of the visibility-map pages must be sampled prior to the read,
+ * because the block may be updated and vacuumed during the i/o.
+ */
+void
+pgstromZoneMapExpect(zoneMapState *zm_state, BlockNumber blknum)
+{
+	if (!zm_state)
+		return;
+	(void) zonemap_get_range(zm_state, blknum);
+}
+
+/*
+ * pgstromZoneMapObserve - accumulates the contents of the page loaded by
+ * the heap scan. Caller must hold the buffer lock of the page, unless it is
+ * a private copy loaded from the storage.
+ */
+void
+pgstromZoneMapObserve(zoneMapState *zm_state, BlockNumber blknum, Page page)
+{
+	Relation	relation;
+	TupleDesc	tupdesc;
+	zoneMapRange *zm_range;
+	cl_uint		index;
+	OffsetNumber lineoff;
+	OffsetNumber lines;
+	ItemId		lpp;
+	int			i;
+
+	if (!zm_state)
+		return;
+	relation = zm_state->relation;
+	tupdesc = RelationGetDescr(relation);
+
+	zm_range = zonemap_get_range(zm_state, blknum);
+	if (!zm_range)
+		return;
+	index = blknum - zm_range->range;
+	if ((zm_range->observed[index / BITS_PER_BYTE] &
+		 (1 << (index % BITS_PER_BYTE))) != 0)
+		return;		/* already observed */
+
+	/* tuples on the page may not be visible to other transactions */
+	if (!PageIsAllVisible(page))
+	{
+		zm_range->failed = true;
+		return;
+	}
+
+	lines = PageGetMaxOffsetNumber(page);
+	for (lineoff = FirstOffsetNumber, lpp = PageGetItemId(page, lineoff);
+		 lineoff <= lines;
+		 lineoff++, lpp++)
+	{
+		HeapTupleData	tup;
+
+		if (!ItemIdIsNormal(lpp))
+			continue;
+		tup.t_tableOid = RelationGetRelid(relation);
+		tup.t_data = (HeapTupleHeader) PageGetItem(page, lpp);
+		tup.t_len = ItemIdGetLength(lpp);
+		ItemPointerSet(&tup.t_self, blknum, lineoff);
+
+		for (i=0; i < zm_state->ncols; i++)
+		{
+			zoneMapColumn *zm_col = &zm_state->columns[i];
+			zoneMapAccum *zm_acc = &zm_range->accums[i];
+			Datum		datum;
+			bool		isnull;
+
+			datum = heap_getattr(&tup, zm_col->attnum, tupdesc, &isnull);
+			if (isnull)
+				zm_acc->nullcount++;
+			else if (!zm_acc->has_value)
+			{
+				zm_acc->min_value = datum;
+				zm_acc->max_value = datum;
+				zm_acc->has_value = true;
+			}
+			else
+			{
+				if (DatumGetInt32(FunctionCall2Coll(&zm_col->cmp_proc,
+													zm_col->attcollation,
+													datum,
+													zm_acc->min_value)) < 0)
+					zm_acc->min_value = datum;
+				if (DatumGetInt32(FunctionCall2Coll(&zm_col->cmp_proc,
+													zm_col->attcollation,
+													datum,
+													zm_acc->max_value)) > 0)
+					zm_acc->max_value = datum;
+			}
+		}
+		zm_range->nitems++;
+	}
+	zm_range->observed[index / BITS_PER_BYTE] |= (1 << (index % BITS_PER_BYTE));
+
+	if (++zm_range->nblocks == ZONEMAP_RANGE_NBLOCKS)
+	{
+		zonemap_store_entries(zm_state, zm_range);
+		zm_range->range = InvalidBlockNumber;
+	}
+}
+
+/*
+ * pgstromExecRewindZoneMap
+ */
+void
+pgstromExecRewindZoneMap(GpuTaskState *gts)
+{
+	zoneMapState *zm_state = gts->zm_state;
+
+	if (!zm_state)
+		return;
+	zm_state->last_range = InvalidBlockNumber;
+	zonemap_reset_ranges(zm_state);
+}
+
+/*
+ * pgstromExecEndZoneMap
+ */
+void
+pgstromExecEndZoneMap(GpuTaskState *gts)
+{
+	zoneMapState *zm_state = gts->zm_state;
+
+	if (!zm_state)
+		return;
+	if (BufferIsValid(zm_state->vm_buffer))
+		ReleaseBuffer(zm_state->vm_buffer);
+	zm_state->vm_buffer = InvalidBuffer;
+}
+
+/*
+ * pgstromExplainZoneMap
+ */
+void
+pgstromExplainZoneMap(GpuTaskState *gts, ExplainState *es)
+{
+	zoneMapState *zm_state = gts->zm_state;
+	char		temp[128];
+
+	if (!zm_state)
+		return;
+	if (!es->analyze)
+		ExplainPropertyInteger("Zone-Map hints", NULL,
+							   list_length(zm_state->hints), es);
+	else if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		if (zm_state->nblocks > 0)
+			snprintf(temp, sizeof(temp), "%ld of %ld (%.2f%%)",
+					 gts->outer_zonemap_count,
+					 (long)zm_state->nblocks,
+					 100.0 * ((double) gts->outer_zonemap_count /
+							  (double) zm_state->nblocks));
+		else
+			snprintf(temp, sizeof(temp), "%ld", gts->outer_zonemap_count);
+		ExplainPropertyText("Zone-Map skipped", temp, es);
+	}
+	else
+		ExplainPropertyInteger("Zone-Map skipped", NULL,
+							   gts->outer_zonemap_count, es);
+}
+
+/*
+ * pgstrom_startup_zonemap
+ */
+static void
+pgstrom_startup_zonemap(void)
+{
+	zoneMapEntry *entry;
+	size_t		required;
+	bool		found;
+	int			i;
+
+	if (shmem_startup_next)
+		(*shmem_startup_next)();
+	if (!zonemap_shmem_requested)
+		return;
+
+	required = MAXALIGN(offsetof(zoneMapHead, slots[zonemap_num_slots])) +
+		MAXALIGN(sizeof(zoneMapEntry) * zonemap_num_entries);
+	zonemap_head = ShmemInitStruct("Zone Map Shared Segment",
+								   required, &found);
+	if (found)
+		elog(ERROR, "Bug? Zone Map Shared Segment is already built");
+	memset(zonemap_head, 0, required);
+	SpinLockInit(&zonemap_head->lock);
+	dlist_init(&zonemap_head->lru_list);
+	dlist_init(&zonemap_head->free_list);
+	for (i=0; i < zonemap_num_slots; i++)
+		dlist_init(&zonemap_head->slots[i]);
+	entry = (zoneMapEntry *)
+		((char *)zonemap_head +
+		 MAXALIGN(offsetof(zoneMapHead, slots[zonemap_num_slots])));
+	for (i=0; i < zonemap_num_entries; i++)
+	{
+		dlist_push_tail(&zonemap_head->free_list, &entry->hash_chain);
+		entry++;
+	}
+}
+
+/*
+ * pgstrom_init_zonemap
+ */
+void
+pgstrom_init_zonemap(void)
+{
+	/* pg_strom.enable_zonemap */
+	DefineCustomBoolVariable("pg_strom.enable_zonemap",
+							 "Enables to skip block ranges by zone map",
+							 NULL,
+							 &pgstrom_enable_zonemap,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.zonemap_num_entries */
+	DefineCustomIntVariable("pg_strom.zonemap_num_entries",
+							"Number of zone map entries on shared memory",
+							NULL,
+							&zonemap_num_entries,
+							65536,
+							0,
+							INT_MAX / sizeof(zoneMapEntry),
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	zonemap_num_slots = Max(zonemap_num_entries / 4, 64);
+
+	/*
+	 * request for static shared memory, only if zone map is enabled on
+	 * the startup; pg_strom.enable_zonemap turned on later takes effect
+	 * after the restart.
+	 */
+	zonemap_shmem_requested = (pgstrom_enable_zonemap &&
+							   zonemap_num_entries > 0);
+	if (zonemap_shmem_requested)
+		RequestAddinShmemSpace(MAXALIGN(offsetof(zoneMapHead,
+												 slots[zonemap_num_slots])) +
+							   MAXALIGN(sizeof(zoneMapEntry) *
+										zonemap_num_entries));
+	shmem_startup_next = shmem_startup_hook;
+	shmem_startup_hook = pgstrom_startup_zonemap;
+}
@@ -0,0 +1,289 @@
+/*
+ * bench_blkalloc.c
+ *
+ * Micro-benchmark of the block allocation on the parallel relation scan.
+ * It compares the legacy spinlock based allocator that hands out a fixed
+ * number of blocks per call, and the lock-free allocator that claims an
+ * adaptive number of blocks by compare-and-swap. The latter runs the claim
+ * logic of relscan.c as is, by inclusion of src/relscan_claim.h.
+ *
+ * Usage: bench_blkalloc [<nthreads> [<nblocks> [<block cost (loops)>]]]
+ * ----
+ * Copyright 2011-2018 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2018 (C) The PG-Strom Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef uint64_t	uint64;
+
+#define RELSCAN_ATOMIC_U64				uint64
+#define RELSCAN_ATOMIC_READ_U64(p)		__atomic_load_n((p), __ATOMIC_RELAXED)
+#define RELSCAN_ATOMIC_CAS_U64(p,e,n)							\
+	__atomic_compare_exchange_n((p), (e), (n), false,			\
+								__ATOMIC_ACQ_REL, __ATOMIC_RELAXED)
+#define RELSCAN_BRIN_SKIPPED(map,pos)	(((const bool *)(map))[(pos)])
+#include "relscan_claim.h"
+
+#define RELSEG_SIZE					131072	/* 1GB segment with 8KB block */
+#define LEGACY_CLAIM_NBLOCKS		8
+#define RELSCAN_CLAIM_MAX_NBLOCKS	16384	/* 128MB with 8KB block */
+#define CCACHE_CHUNK_NBLOCKS		16384	/* 128MB with 8KB block */
+#define BRIN_RANGE_NBLOCKS			128
+#define BRIN_SKIP_INTERVAL			4		/* every 4th range is skipped */
+
+static long			nblocks = 4 * RELSEG_SIZE;
+static int			nthreads = 8;
+static long			block_cost = 200;
+
+/* shared state */
+static pthread_spinlock_t	alloc_lock;
+static uint64		nr_allocated;
+static uint64		nr_claims;
+static uint64		nr_blocks_total;
+static uint64		nr_blocks_skipped;
+static volatile int	start_flag;
+static relscanClaimArgs	claim_args;
+static bool		   *brin_map = NULL;
+
+typedef struct
+{
+	pthread_t	thread;
+	double		finish_sec;
+	long		nclaims;
+	long		nblocks;
+	long		nskipped;
+} worker_t;
+
+static struct timespec	tv_begin;
+
+static double
+elapsed_sec(void)
+{
+	struct timespec	tv;
+
+	clock_gettime(CLOCK_MONOTONIC, &tv);
+	return ((double)(tv.tv_sec - tv_begin.tv_sec) +
+			(double)(tv.tv_nsec - tv_begin.tv_nsec) / 1000000000.0);
+}
+
+/* emulation of the per-block workload */
+static void
+process_blocks(long page, long count)
+{
+	volatile long	dummy = page;
+	long			i, j;
+
+	for (i=0; i < count; i++)
+	{
+		for (j=0; j < block_cost; j++)
+			dummy += j ^ (page + i);
+	}
+}
+
+/* legacy allocator; a fixed claim under the spinlock */
+static long
+claim_legacy(long *p_page, bool *p_skipped)
+{
+	long	count = 0;
+
+	pthread_spin_lock(&alloc_lock);
+	if (nr_allocated < (uint64)nblocks)
+	{
+		*p_page = (long)nr_allocated;
+		count = nblocks - (long)nr_allocated;
+		if (count > LEGACY_CLAIM_NBLOCKS)
+			count = LEGACY_CLAIM_NBLOCKS;
+		nr_allocated += count;
+	}
+	pthread_spin_unlock(&alloc_lock);
+	*p_skipped = false;
+
+	return count;
+}
+
+/* lock-free allocator of relscan.c; adaptive claim by compare-and-swap */
+static long
+claim_adaptive(long *p_page, bool *p_skipped)
+{
+	return __relscanClaimBlocks(&nr_allocated, &claim_args,
+								p_page, p_skipped);
+}
+
+static long (*claim_blocks)(long *p_page, bool *p_skipped);
+
+static void
+claim_error(const char *reason, long page, long count)
+{
+	fprintf(stderr, "claim [%ld..%ld] %s\n", page, page + count - 1, reason);
+	exit(1);
+}
+
+static void *
+worker_main(void *arg)
+{
+	worker_t   *w = arg;
+	long		page;
+	long		count;
+	bool		skipped;
+
+	while (!start_flag)
+		;
+	while ((count = claim_blocks(&page, &skipped)) > 0)
+	{
+		/* claims must be contiguous within a segment */
+		if ((page / RELSEG_SIZE) != (page + count - 1) / RELSEG_SIZE)
+			claim_error("crosses segment boundary", page, count);
+		if (claim_blocks == claim_adaptive)
+		{
+			long	pos;
+
+			if (count > claim_args.nr_limit)
+				claim_error("exceeds the limit", page, count);
+			/* a claim is either skipped or scanned as a whole */
+			for (pos = page / BRIN_RANGE_NBLOCKS;
+				 brin_map && pos <= (page + count - 1) / BRIN_RANGE_NBLOCKS;
+				 pos++)
+			{
+				if (brin_map[pos] != skipped)
+					claim_error("mixes skipped and scanned ranges",
+								page, count);
+			}
+		}
+		if (skipped)
+			w->nskipped += count;
+		else
+			process_blocks(page, count);
+		w->nclaims++;
+		w->nblocks += count;
+	}
+	w->finish_sec = elapsed_sec();
+	__atomic_add_fetch(&nr_claims, w->nclaims, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&nr_blocks_total, w->nblocks, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&nr_blocks_skipped, w->nskipped, __ATOMIC_RELAXED);
+
+	return NULL;
+}
+
+static void
+run_bench(const char *label,
+		  long (*claim_fn)(long *, bool *),
+		  long chunk_nblocks, bool with_brin)
+{
+	worker_t   *workers = calloc(nthreads, sizeof(worker_t));
+	double		t_min = -1.0;
+	double		t_max = 0.0;
+	int			i;
+
+	if (!workers)
+	{
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	nr_allocated = 0;
+	nr_claims = 0;
+	nr_blocks_total = 0;
+	nr_blocks_skipped = 0;
+	start_flag = 0;
+	claim_blocks = claim_fn;
+
+	claim_args.nblocks = nblocks;
+	claim_args.startblock = 0;
+	claim_args.nr_workers = nthreads;
+	claim_args.nr_limit = RELSCAN_CLAIM_MAX_NBLOCKS;
+	claim_args.relseg_size = RELSEG_SIZE;
+	claim_args.brin_map = NULL;
+	claim_args.brin_range_sz = BRIN_RANGE_NBLOCKS;
+	claim_args.chunk_nblocks = chunk_nblocks;
+	if (with_brin)
+	{
+		long	nranges = (nblocks + BRIN_RANGE_NBLOCKS - 1) / BRIN_RANGE_NBLOCKS;
+
+		brin_map = calloc(nranges, sizeof(bool));
+		if (!brin_map)
+		{
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+		for (i=0; i < nranges; i++)
+			brin_map[i] = (i % BRIN_SKIP_INTERVAL == BRIN_SKIP_INTERVAL - 1);
+		claim_args.brin_map = brin_map;
+	}
+
+	for (i=0; i < nthreads; i++)
+	{
+		if (pthread_create(&workers[i].thread, NULL,
+						   worker_main, &workers[i]) != 0)
+		{
+			fprintf(stderr, "failed on pthread_create\n");
+			exit(1);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &tv_begin);
+	start_flag = 1;
+	for (i=0; i < nthreads; i++)
+	{
+		pthread_join(workers[i].thread, NULL);
+		if (t_min < 0.0 || workers[i].finish_sec < t_min)
+			t_min = workers[i].finish_sec;
+		if (workers[i].finish_sec > t_max)
+			t_max = workers[i].finish_sec;
+	}
+	if (nr_blocks_total != (uint64)nblocks)
+	{
+		fprintf(stderr, "%s: %lu blocks were claimed, but expected %ld\n",
+				label, (unsigned long)nr_blocks_total, nblocks);
+		exit(1);
+	}
+	printf("%-12s  elapsed: %.3fs  %.1f Mblocks/s  claims: %lu  "
+		   "skipped: %lu  tail imbalance: %.2fms\n",
+		   label, t_max,
+		   (double)nblocks / t_max / 1000000.0,
+		   (unsigned long)nr_claims,
+		   (unsigned long)nr_blocks_skipped,
+		   (t_max - t_min) * 1000.0);
+	free(brin_map);
+	brin_map = NULL;
+	free(workers);
+}
+
+int
+main(int argc, char *argv[])
+{
+	if (argc > 1)
+		nthreads = atoi(argv[1]);
+	if (argc > 2)
+		nblocks = atol(argv[2]);
+	if (argc > 3)
+		block_cost = atol(argv[3]);
+	if (nthreads < 1 || nblocks < 1 || block_cost < 0)
+	{
+		fprintf(stderr, "usage: %s [<nthreads> [<nblocks> [<block cost>]]]\n",
+				argv[0]);
+		return 1;
+	}
+	pthread_spin_init(&alloc_lock, PTHREAD_PROCESS_PRIVATE);
+
+	printf("nthreads: %d, nblocks: %ld, block cost: %ld\n",
+		   nthreads, nblocks, block_cost);
+	run_bench("legacy", claim_legacy, 0, false);
+	run_bench("adaptive", claim_adaptive, 0, false);
+	run_bench("ccache", claim_adaptive, CCACHE_CHUNK_NBLOCKS, false);
+	run_bench("brin", claim_adaptive, 0, true);
+	run_bench("ccache+brin", claim_adaptive, CCACHE_CHUNK_NBLOCKS, true);
+
+	return 0;
+}
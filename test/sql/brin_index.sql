@@ -0,0 +1,95 @@
+---
+--- Test cases for BRIN index with IN-lists and OR/AND trees
+---
+RESET pg_strom.enabled;
+SET max_parallel_workers_per_gather = 0;
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+CREATE FUNCTION pg_temp.brin_skipped(query text)
+RETURNS bool AS $$
+DECLARE
+  line  text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN (analyze, costs off, timing off) ' || query
+  LOOP
+    IF substring(line from 'BRIN skipped: (\d+) of')::int > 0 THEN
+      RETURN true;
+    END IF;
+  END LOOP;
+  RETURN false;
+END
+$$ LANGUAGE plpgsql;
+-- table sorted by id, many block ranges
+CREATE TABLE brin_t1 (id int, a int, c text);
+INSERT INTO brin_t1
+     SELECT x, x % 1000, md5(x::text)
+       FROM generate_series(1,500000) x;
+CREATE INDEX brin_t1_id ON brin_t1 USING brin (id)
+  WITH (pages_per_range = 8);
+VACUUM ANALYZE brin_t1;
+
+-- IN-list and = ANY(array) skip the ranges without any elements
+SELECT pg_temp.brin_skipped('SELECT * FROM brin_t1
+                              WHERE id IN (100, 250000, 499000)
+                                AND a >= 0')
+    AS brin_inlist;
+SELECT pg_temp.brin_skipped('SELECT * FROM brin_t1
+                              WHERE id = ANY(ARRAY[2000, 400000])
+                                AND a >= 0')
+    AS brin_any;
+-- OR tree, and AND arms inside of the OR tree
+SELECT pg_temp.brin_skipped('SELECT * FROM brin_t1
+                              WHERE (id < 1000 OR id > 499000)
+                                AND a >= 0')
+    AS brin_or;
+SELECT pg_temp.brin_skipped('SELECT * FROM brin_t1
+                              WHERE ((id > 1000 AND id < 2000 AND a > 500)
+                                     OR id IN (300000, 300001))')
+    AS brin_or_and;
+SELECT id, a, c
+  INTO pg_temp.test_b01a
+  FROM brin_t1
+ WHERE id IN (100, 250000, 499000) AND a >= 0;
+SELECT id, a, c
+  INTO pg_temp.test_b02a
+  FROM brin_t1
+ WHERE id = ANY(ARRAY[2000, 400000]) AND a >= 0;
+SELECT id, a, c
+  INTO pg_temp.test_b03a
+  FROM brin_t1
+ WHERE (id < 1000 OR id > 499000) AND a >= 0;
+SELECT id, a, c
+  INTO pg_temp.test_b04a
+  FROM brin_t1
+ WHERE ((id > 1000 AND id < 2000 AND a > 500) OR id IN (300000, 300001));
+
+SET pg_strom.enabled = off;
+SELECT id, a, c
+  INTO pg_temp.test_b01b
+  FROM brin_t1
+ WHERE id IN (100, 250000, 499000) AND a >= 0;
+SELECT id, a, c
+  INTO pg_temp.test_b02b
+  FROM brin_t1
+ WHERE id = ANY(ARRAY[2000, 400000]) AND a >= 0;
+SELECT id, a, c
+  INTO pg_temp.test_b03b
+  FROM brin_t1
+ WHERE (id < 1000 OR id > 499000) AND a >= 0;
+SELECT id, a, c
+  INTO pg_temp.test_b04b
+  FROM brin_t1
+ WHERE ((id > 1000 AND id < 2000 AND a > 500) OR id IN (300000, 300001));
+RESET pg_strom.enabled;
+
+(SELECT * FROM pg_temp.test_b01a EXCEPT ALL SELECT * FROM pg_temp.test_b01b);
+(SELECT * FROM pg_temp.test_b01b EXCEPT ALL SELECT * FROM pg_temp.test_b01a);
+(SELECT * FROM pg_temp.test_b02a EXCEPT ALL SELECT * FROM pg_temp.test_b02b);
+(SELECT * FROM pg_temp.test_b02b EXCEPT ALL SELECT * FROM pg_temp.test_b02a);
+(SELECT * FROM pg_temp.test_b03a EXCEPT ALL SELECT * FROM pg_temp.test_b03b);
+(SELECT * FROM pg_temp.test_b03b EXCEPT ALL SELECT * FROM pg_temp.test_b03a);
+(SELECT * FROM pg_temp.test_b04a EXCEPT ALL SELECT * FROM pg_temp.test_b04b);
+(SELECT * FROM pg_temp.test_b04b EXCEPT ALL SELECT * FROM pg_temp.test_b04a);
+
+-- cleanup
+DROP TABLE brin_t1;
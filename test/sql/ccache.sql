@@ -0,0 +1,48 @@
+---
+--- Test cases for columnar cache
+---
+RESET pg_strom.enabled;
+-- one row per block, so the table has one full chunk and a partial one
+CREATE TABLE ccache_t1 (id int, a int, b float8, c text)
+  WITH (fillfactor = 10);
+INSERT INTO ccache_t1 (SELECT x, x % 1000, x / 7.0,
+                              md5(x::text) || repeat('-', 400)
+                         FROM generate_series(1,20000) x);
+SELECT pgstrom_ccache_enabled('ccache_t1');
+VACUUM ANALYZE ccache_t1;
+
+-- load the chunk, then scan it
+SELECT pgstrom_ccache_prewarm('ccache_t1') = 1 AS ok;
+SELECT block_nr, nitems FROM pgstrom.ccache_info
+ WHERE table_id = 'ccache_t1'::regclass;
+SET pg_strom.enabled = off;
+SELECT id, a, b, c INTO pg_temp.test_c01a
+  FROM ccache_t1 WHERE a % 7 = 3;
+SET pg_strom.enabled = on;
+SELECT id, a, b, c INTO pg_temp.test_c01b
+  FROM ccache_t1 WHERE a % 7 = 3;
+(SELECT * FROM pg_temp.test_c01a EXCEPT ALL SELECT * FROM pg_temp.test_c01b);
+(SELECT * FROM pg_temp.test_c01b EXCEPT ALL SELECT * FROM pg_temp.test_c01a);
+
+-- invalidation by the trigger
+UPDATE ccache_t1 SET a = a + 1 WHERE id = 100;
+SELECT count(*) = 0 AS ok FROM pgstrom.ccache_info
+ WHERE table_id = 'ccache_t1'::regclass;
+SET pg_strom.enabled = off;
+SELECT id, a, b, c INTO pg_temp.test_c02a
+  FROM ccache_t1 WHERE a % 7 = 3;
+SET pg_strom.enabled = on;
+SELECT id, a, b, c INTO pg_temp.test_c02b
+  FROM ccache_t1 WHERE a % 7 = 3;
+(SELECT * FROM pg_temp.test_c02a EXCEPT ALL SELECT * FROM pg_temp.test_c02b);
+(SELECT * FROM pg_temp.test_c02b EXCEPT ALL SELECT * FROM pg_temp.test_c02a);
+
+-- reload, then release the chunk by TRUNCATE
+VACUUM ccache_t1;
+SELECT pgstrom_ccache_prewarm('ccache_t1') = 1 AS ok;
+SELECT count(*) = 1 AS ok FROM pgstrom.ccache_info
+ WHERE table_id = 'ccache_t1'::regclass;
+TRUNCATE ccache_t1;
+SELECT count(*) = 0 AS ok FROM pgstrom.ccache_info
+ WHERE table_id = 'ccache_t1'::regclass;
+DROP TABLE ccache_t1;
@@ -0,0 +1,76 @@
+---
+--- Test cases for common sub-expression elimination on the device code
+---
+RESET pg_strom.enabled;
+SET enable_indexscan = off;
+SET pg_strom.debug_kernel_source = on;
+-- common sub-expressions in the device quals / projection
+SET pg_strom.enable_device_cse = on;
+SELECT regress_kernel_source($$
+  SELECT id, (c::bigint + d) % 100 v1
+    FROM t_int1
+   WHERE (c::bigint + d) % 100 BETWEEN 10 AND 50$$) ~ 'PG_CSE_EVAL\(KCSE_0, ' AS cse;
+SELECT regress_kernel_source($$
+  SELECT x.id, y.id
+    FROM t_int1 x, t_int2 y
+   WHERE x.id = y.id AND (x.c::bigint + y.c) % 7 BETWEEN 2 AND 4$$) ~ 'PG_CSE_EVAL\(KCSE_0, ' AS cse;
+SELECT regress_kernel_source($$
+  SELECT (a::int + b) % 10 k, sum((a::int + b) % 10 * c::bigint)
+    FROM t_int1
+   GROUP BY 1$$) ~ 'PG_CSE_EVAL\(KCSE_0, ' AS cse;
+SET pg_strom.enable_device_cse = off;
+SELECT regress_kernel_source($$
+  SELECT id, (c::bigint + d) % 100 v1
+    FROM t_int1
+   WHERE (c::bigint + d) % 100 BETWEEN 10 AND 50$$) ~ 'PG_CSE_EVAL' AS cse;
+RESET pg_strom.enable_device_cse;
+RESET pg_strom.debug_kernel_source;
+
+-- results must be identical to CPU execution
+SELECT id, (c::bigint + d) % 100 v1
+  INTO pg_temp.test_c01a
+  FROM t_int1
+ WHERE (c::bigint + d) % 100 BETWEEN 10 AND 50;
+SELECT x.id, (x.c::bigint + y.c) % 7 v1
+  INTO pg_temp.test_c02a
+  FROM t_int1 x, t_int2 y
+ WHERE x.id = y.id AND (x.c::bigint + y.c) % 7 BETWEEN 2 AND 4;
+SELECT (a::int + b) % 10 k, sum((a::int + b) % 10 * c::bigint) v1
+  INTO pg_temp.test_c03a
+  FROM t_int1
+ GROUP BY 1;
+SELECT id, CASE WHEN e % 3 = 0 THEN (e % 1000) * 2
+                WHEN e % 3 = 1 THEN (e % 1000) * 3
+                ELSE -(e % 1000) END v1
+  INTO pg_temp.test_c04a
+  FROM t_int1
+ WHERE e % 1000 > 100 OR e IS NULL;
+
+SET pg_strom.enabled = off;
+SELECT id, (c::bigint + d) % 100 v1
+  INTO pg_temp.test_c01b
+  FROM t_int1
+ WHERE (c::bigint + d) % 100 BETWEEN 10 AND 50;
+SELECT x.id, (x.c::bigint + y.c) % 7 v1
+  INTO pg_temp.test_c02b
+  FROM t_int1 x, t_int2 y
+ WHERE x.id = y.id AND (x.c::bigint + y.c) % 7 BETWEEN 2 AND 4;
+SELECT (a::int + b) % 10 k, sum((a::int + b) % 10 * c::bigint) v1
+  INTO pg_temp.test_c03b
+  FROM t_int1
+ GROUP BY 1;
+SELECT id, CASE WHEN e % 3 = 0 THEN (e % 1000) * 2
+                WHEN e % 3 = 1 THEN (e % 1000) * 3
+                ELSE -(e % 1000) END v1
+  INTO pg_temp.test_c04b
+  FROM t_int1
+ WHERE e % 1000 > 100 OR e IS NULL;
+RESET pg_strom.enabled;
+(SELECT * FROM pg_temp.test_c01a EXCEPT ALL SELECT * FROM pg_temp.test_c01b);
+(SELECT * FROM pg_temp.test_c01b EXCEPT ALL SELECT * FROM pg_temp.test_c01a);
+(SELECT * FROM pg_temp.test_c02a EXCEPT ALL SELECT * FROM pg_temp.test_c02b);
+(SELECT * FROM pg_temp.test_c02b EXCEPT ALL SELECT * FROM pg_temp.test_c02a);
+(SELECT * FROM pg_temp.test_c03a EXCEPT ALL SELECT * FROM pg_temp.test_c03b);
+(SELECT * FROM pg_temp.test_c03b EXCEPT ALL SELECT * FROM pg_temp.test_c03a);
+(SELECT * FROM pg_temp.test_c04a EXCEPT ALL SELECT * FROM pg_temp.test_c04b);
+(SELECT * FROM pg_temp.test_c04b EXCEPT ALL SELECT * FROM pg_temp.test_c04a);
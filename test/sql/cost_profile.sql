@@ -0,0 +1,53 @@
+---
+--- Test cases for the calibrated cost profiles
+---
+RESET pg_strom.enabled;
+SET max_parallel_workers_per_gather = 0;
+SELECT dattablespace AS tblspc FROM pg_database
+ WHERE datname = current_database() \gset
+
+-- profiles are private to the transaction until commit
+BEGIN;
+DELETE FROM pgstrom.cost_profile;
+INSERT INTO pgstrom.cost_profile (device_nr, tablespace, gpu_setup_cost)
+     VALUES (-1, 0, 1.0e9);
+SELECT regress_plan_uses('SELECT id FROM t_int1 WHERE a + b > c',
+                         'GpuScan') AS gpuscan;
+-- profile of the default tablespace is preferred to any tablespace
+INSERT INTO pgstrom.cost_profile (device_nr, tablespace, gpu_setup_cost)
+     VALUES (-1, :tblspc, 0.0);
+SELECT regress_plan_uses('SELECT id FROM t_int1 WHERE a + b > c',
+                         'GpuScan') AS gpuscan;
+UPDATE pgstrom.cost_profile SET gpu_setup_cost = 1.0e9
+ WHERE tablespace = :tblspc;
+SELECT regress_plan_uses('SELECT id FROM t_int1 WHERE a + b > c',
+                         'GpuScan') AS gpuscan;
+-- NULL coefficient falls back to the less specific profile
+UPDATE pgstrom.cost_profile SET gpu_setup_cost = NULL
+ WHERE tablespace = :tblspc;
+SELECT regress_plan_uses('SELECT id FROM t_int1 WHERE a + b > c',
+                         'GpuScan') AS gpuscan;
+SET pg_strom.enable_cost_profile = off;
+SELECT regress_plan_uses('SELECT id FROM t_int1 WHERE a + b > c',
+                         'GpuScan') AS gpuscan;
+ROLLBACK;
+
+-- cache is reloaded after the rollback
+SELECT count(*) = 0 AS ok FROM pgstrom.cost_profile
+ WHERE gpu_setup_cost >= 1.0e9;
+SELECT regress_plan_uses('SELECT id FROM t_int1 WHERE a + b > c',
+                         'GpuScan') AS gpuscan;
+
+-- calibrate_host_repack needs SELECT privilege on the table
+CREATE ROLE regress_cost_profile_user;
+SET SESSION AUTHORIZATION regress_cost_profile_user;
+DO $$
+BEGIN
+  PERFORM pgstrom.calibrate_host_repack('t_int1', 1);
+  RAISE NOTICE 'calibrate_host_repack: allowed';
+EXCEPTION WHEN insufficient_privilege THEN
+  RAISE NOTICE 'calibrate_host_repack: permission denied';
+END
+$$;
+RESET SESSION AUTHORIZATION;
+DROP ROLE regress_cost_profile_user;
@@ -0,0 +1,98 @@
+---
+--- Test cases for CPU fallback of GpuScan
+---
+RESET pg_strom.enabled;
+SET max_parallel_workers_per_gather = 0;
+SET pg_strom.debug_force_cpu_fallback = on;
+-- simple qualifiers are evaluated on the column vectors
+SELECT regress_explain_uses('SELECT id, c FROM t_int1 WHERE c > 0 AND e % 7 = 2',
+                            'CPU Fallback Vectorized') AS vectorized;
+SELECT id, a, c, e
+  INTO pg_temp.test_v01a
+  FROM t_int1
+ WHERE c > 0 AND d < 500000 AND e % 7 = 2;
+SELECT id, c, e
+  INTO pg_temp.test_v02a
+  FROM t_float1
+ WHERE e > 0.0 AND d < 1000.0;
+SELECT id, c + d AS x, e * 2 AS y
+  INTO pg_temp.test_v03a
+  FROM t_int1
+ WHERE c <= 200000 AND f IS NOT NULL;
+SELECT id, d
+  INTO pg_temp.test_v04a
+  FROM t_int1
+ WHERE d = ANY(ARRAY[11,23,37,41,53,67,71,83,97,101,
+                     113,127,131,149,151,163,173,181,191,199,
+                     211,223,233,241,251,263,271,281,293,307,
+                     311,331,347,353,367,373,383,397,401,419]);
+-- system column needs to fetch the rows again
+SELECT ctid, id, c
+  INTO pg_temp.test_v05a
+  FROM t_int1
+ WHERE c > 900000;
+RESET pg_strom.debug_force_cpu_fallback;
+
+SET pg_strom.enabled = off;
+SELECT id, a, c, e
+  INTO pg_temp.test_v01b
+  FROM t_int1
+ WHERE c > 0 AND d < 500000 AND e % 7 = 2;
+SELECT id, c, e
+  INTO pg_temp.test_v02b
+  FROM t_float1
+ WHERE e > 0.0 AND d < 1000.0;
+SELECT id, c + d AS x, e * 2 AS y
+  INTO pg_temp.test_v03b
+  FROM t_int1
+ WHERE c <= 200000 AND f IS NOT NULL;
+SELECT id, d
+  INTO pg_temp.test_v04b
+  FROM t_int1
+ WHERE d = ANY(ARRAY[11,23,37,41,53,67,71,83,97,101,
+                     113,127,131,149,151,163,173,181,191,199,
+                     211,223,233,241,251,263,271,281,293,307,
+                     311,331,347,353,367,373,383,397,401,419]);
+SELECT ctid, id, c
+  INTO pg_temp.test_v05b
+  FROM t_int1
+ WHERE c > 900000;
+
+(SELECT * FROM pg_temp.test_v01a EXCEPT ALL SELECT * FROM pg_temp.test_v01b);
+(SELECT * FROM pg_temp.test_v01b EXCEPT ALL SELECT * FROM pg_temp.test_v01a);
+(SELECT * FROM pg_temp.test_v02a EXCEPT ALL SELECT * FROM pg_temp.test_v02b);
+(SELECT * FROM pg_temp.test_v02b EXCEPT ALL SELECT * FROM pg_temp.test_v02a);
+(SELECT * FROM pg_temp.test_v03a EXCEPT ALL SELECT * FROM pg_temp.test_v03b);
+(SELECT * FROM pg_temp.test_v03b EXCEPT ALL SELECT * FROM pg_temp.test_v03a);
+(SELECT * FROM pg_temp.test_v04a EXCEPT ALL SELECT * FROM pg_temp.test_v04b);
+(SELECT * FROM pg_temp.test_v04b EXCEPT ALL SELECT * FROM pg_temp.test_v04a);
+(SELECT * FROM pg_temp.test_v05a EXCEPT ALL SELECT * FROM pg_temp.test_v05b);
+(SELECT * FROM pg_temp.test_v05b EXCEPT ALL SELECT * FROM pg_temp.test_v05a);
+
+-- GpuPreAgg chunks are processed by CPU while GPU program is being built
+SET pg_strom.enabled = on;
+SET pg_strom.debug_force_cpu_fallback = on;
+SELECT regress_explain_uses('SELECT b % 10, count(*), sum(c) FROM t_int1 GROUP BY b % 10',
+                            'JIT Build Fallback') AS preagg_fallback;
+SELECT b % 10 AS k, count(*) AS n, sum(c) AS s, min(e) AS mn, max(e) AS mx
+  INTO pg_temp.test_a01a
+  FROM t_int1
+ GROUP BY b % 10;
+SELECT count(*) AS n, sum(d) AS s
+  INTO pg_temp.test_a02a
+  FROM t_int1
+ WHERE c > 0;
+RESET pg_strom.debug_force_cpu_fallback;
+SET pg_strom.enabled = off;
+SELECT b % 10 AS k, count(*) AS n, sum(c) AS s, min(e) AS mn, max(e) AS mx
+  INTO pg_temp.test_a01b
+  FROM t_int1
+ GROUP BY b % 10;
+SELECT count(*) AS n, sum(d) AS s
+  INTO pg_temp.test_a02b
+  FROM t_int1
+ WHERE c > 0;
+(SELECT * FROM pg_temp.test_a01a EXCEPT ALL SELECT * FROM pg_temp.test_a01b);
+(SELECT * FROM pg_temp.test_a01b EXCEPT ALL SELECT * FROM pg_temp.test_a01a);
+(SELECT * FROM pg_temp.test_a02a EXCEPT ALL SELECT * FROM pg_temp.test_a02b);
+(SELECT * FROM pg_temp.test_a02b EXCEPT ALL SELECT * FROM pg_temp.test_a02a);
@@ -0,0 +1,90 @@
+---
+--- Test cases for bloom filter on the inner join-keys of GpuJoin
+---
+RESET pg_strom.enabled;
+SET pg_strom.enable_gpujoin_bloom_filter = on;
+SET pg_strom.pullup_outer_scan = off;
+SELECT l.id, l.a, r.c
+  INTO pg_temp.test_b01a
+  FROM t_int1 l, t_int2 r
+ WHERE l.a = r.a AND r.b % 100 = 7;
+SELECT id, b, e
+  INTO pg_temp.test_b02a
+  FROM t_int1 l
+ WHERE EXISTS (SELECT 1 FROM t_int2 r WHERE r.b = l.b AND r.d < 0);
+SELECT l.id, r.id rid
+  INTO pg_temp.test_b03a
+  FROM t_int1 l, t_int2 r
+ WHERE l.a = r.a AND l.b = r.b AND r.c % 10 = 3;
+SELECT l.id, x.e xe, y.e ye
+  INTO pg_temp.test_b04a
+  FROM t_int1 l, t_int2 x, t_int2 y
+ WHERE l.c = x.c AND l.d = y.d AND x.a % 50 = 1;
+SELECT l.id, l.c, r.id rid
+  INTO pg_temp.test_b05a
+  FROM t_float1 l, (SELECT id, c::float8 v FROM t_float1 WHERE id % 50 = 1) r
+ WHERE l.c = r.v;
+SET pg_strom.pullup_outer_scan = on;
+SELECT l.id, l.a, r.c
+  INTO pg_temp.test_b01p
+  FROM t_int1 l, t_int2 r
+ WHERE l.a = r.a AND r.b % 100 = 7;
+SELECT id, b, e
+  INTO pg_temp.test_b02p
+  FROM t_int1 l
+ WHERE EXISTS (SELECT 1 FROM t_int2 r WHERE r.b = l.b AND r.d < 0);
+SELECT l.id, r.id rid
+  INTO pg_temp.test_b03p
+  FROM t_int1 l, t_int2 r
+ WHERE l.a = r.a AND l.b = r.b AND r.c % 10 = 3;
+SELECT l.id, x.e xe, y.e ye
+  INTO pg_temp.test_b04p
+  FROM t_int1 l, t_int2 x, t_int2 y
+ WHERE l.c = x.c AND l.d = y.d AND x.a % 50 = 1;
+SELECT l.id, l.c, r.id rid
+  INTO pg_temp.test_b05p
+  FROM t_float1 l, (SELECT id, c::float8 v FROM t_float1 WHERE id % 50 = 1) r
+ WHERE l.c = r.v;
+RESET pg_strom.pullup_outer_scan;
+
+SET pg_strom.enabled = off;
+SELECT l.id, l.a, r.c
+  INTO pg_temp.test_b01b
+  FROM t_int1 l, t_int2 r
+ WHERE l.a = r.a AND r.b % 100 = 7;
+SELECT id, b, e
+  INTO pg_temp.test_b02b
+  FROM t_int1 l
+ WHERE EXISTS (SELECT 1 FROM t_int2 r WHERE r.b = l.b AND r.d < 0);
+SELECT l.id, r.id rid
+  INTO pg_temp.test_b03b
+  FROM t_int1 l, t_int2 r
+ WHERE l.a = r.a AND l.b = r.b AND r.c % 10 = 3;
+SELECT l.id, x.e xe, y.e ye
+  INTO pg_temp.test_b04b
+  FROM t_int1 l, t_int2 x, t_int2 y
+ WHERE l.c = x.c AND l.d = y.d AND x.a % 50 = 1;
+SELECT l.id, l.c, r.id rid
+  INTO pg_temp.test_b05b
+  FROM t_float1 l, (SELECT id, c::float8 v FROM t_float1 WHERE id % 50 = 1) r
+ WHERE l.c = r.v;
+(SELECT * FROM pg_temp.test_b01a EXCEPT ALL SELECT * FROM pg_temp.test_b01b);
+(SELECT * FROM pg_temp.test_b01b EXCEPT ALL SELECT * FROM pg_temp.test_b01a);
+(SELECT * FROM pg_temp.test_b01p EXCEPT ALL SELECT * FROM pg_temp.test_b01b);
+(SELECT * FROM pg_temp.test_b01b EXCEPT ALL SELECT * FROM pg_temp.test_b01p);
+(SELECT * FROM pg_temp.test_b02a EXCEPT ALL SELECT * FROM pg_temp.test_b02b);
+(SELECT * FROM pg_temp.test_b02b EXCEPT ALL SELECT * FROM pg_temp.test_b02a);
+(SELECT * FROM pg_temp.test_b02p EXCEPT ALL SELECT * FROM pg_temp.test_b02b);
+(SELECT * FROM pg_temp.test_b02b EXCEPT ALL SELECT * FROM pg_temp.test_b02p);
+(SELECT * FROM pg_temp.test_b03a EXCEPT ALL SELECT * FROM pg_temp.test_b03b);
+(SELECT * FROM pg_temp.test_b03b EXCEPT ALL SELECT * FROM pg_temp.test_b03a);
+(SELECT * FROM pg_temp.test_b03p EXCEPT ALL SELECT * FROM pg_temp.test_b03b);
+(SELECT * FROM pg_temp.test_b03b EXCEPT ALL SELECT * FROM pg_temp.test_b03p);
+(SELECT * FROM pg_temp.test_b04a EXCEPT ALL SELECT * FROM pg_temp.test_b04b);
+(SELECT * FROM pg_temp.test_b04b EXCEPT ALL SELECT * FROM pg_temp.test_b04a);
+(SELECT * FROM pg_temp.test_b04p EXCEPT ALL SELECT * FROM pg_temp.test_b04b);
+(SELECT * FROM pg_temp.test_b04b EXCEPT ALL SELECT * FROM pg_temp.test_b04p);
+(SELECT * FROM pg_temp.test_b05a EXCEPT ALL SELECT * FROM pg_temp.test_b05b);
+(SELECT * FROM pg_temp.test_b05b EXCEPT ALL SELECT * FROM pg_temp.test_b05a);
+(SELECT * FROM pg_temp.test_b05p EXCEPT ALL SELECT * FROM pg_temp.test_b05b);
+(SELECT * FROM pg_temp.test_b05b EXCEPT ALL SELECT * FROM pg_temp.test_b05p);
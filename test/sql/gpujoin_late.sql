@@ -0,0 +1,129 @@
+---
+--- Test cases for late materialization of wide outer columns on GpuJoin
+---
+RESET pg_strom.enabled;
+SET pg_strom.pullup_outer_scan = on;
+CREATE TABLE t_late AS
+  SELECT x id, (x * 7) % 800000 + 1 key,
+         CASE WHEN x % 13 = 0 THEN NULL
+              ELSE repeat(md5(x::text), 32) END wide,
+         CASE WHEN x % 17 = 0 THEN NULL
+              ELSE repeat(md5((x+1)::text), 4) END note
+    FROM generate_series(1,200000) x;
+ANALYZE t_late;
+SET pg_strom.enable_gpujoin_late_materialization = on;
+SELECT regress_plan_uses('SELECT l.id, l.wide, r.c
+                            FROM t_late l, t_int2 r
+                           WHERE l.key = r.id AND r.c % 10 = 3',
+                         'Late Materialization',
+                         'costs off, verbose') AS late_l01;
+SELECT regress_plan_uses('SELECT l.id, l.wide, r.id rid
+                            FROM t_late l RIGHT JOIN t_int2 r
+                              ON l.key = r.id AND l.id % 3 = 0
+                           WHERE r.id % 20 = 0',
+                         'Late Materialization',
+                         'costs off, verbose') AS late_l05;
+SELECT l.id, l.wide, r.c
+  INTO pg_temp.test_l01a
+  FROM t_late l, t_int2 r
+ WHERE l.key = r.id AND r.c % 10 = 3;
+SELECT l.id, l.wide, l.note, r.a
+  INTO pg_temp.test_l02a
+  FROM t_late l LEFT JOIN t_int2 r ON l.key = r.id AND r.a % 5 = 1;
+SELECT l.id, r.id rid, l.wide, length(l.wide) len
+  INTO pg_temp.test_l03a
+  FROM t_late l, t_int2 r
+ WHERE l.key = r.id AND l.wide LIKE '%a0%';
+SELECT l.id, x.id xid, y.id yid, l.wide
+  INTO pg_temp.test_l04a
+  FROM t_late l, t_int2 x, t_int2 y
+ WHERE l.key = x.id AND l.id = y.id AND x.b % 7 = 2;
+-- outer side is empty, so ctid is NULL
+SELECT l.id, l.wide, r.id rid
+  INTO pg_temp.test_l05a
+  FROM t_late l RIGHT JOIN t_int2 r ON l.key = r.id AND l.id % 3 = 0
+ WHERE r.id % 20 = 0;
+SELECT l.id, l.note, r.id rid
+  INTO pg_temp.test_l06a
+  FROM t_late l FULL JOIN (SELECT * FROM t_int2 WHERE id % 20 = 0 OFFSET 0) r
+    ON l.key = r.id AND l.id % 3 = 0;
+SET pg_strom.enable_gpujoin_late_materialization = off;
+SELECT l.id, l.wide, r.c
+  INTO pg_temp.test_l01n
+  FROM t_late l, t_int2 r
+ WHERE l.key = r.id AND r.c % 10 = 3;
+SELECT l.id, l.wide, l.note, r.a
+  INTO pg_temp.test_l02n
+  FROM t_late l LEFT JOIN t_int2 r ON l.key = r.id AND r.a % 5 = 1;
+SELECT l.id, r.id rid, l.wide, length(l.wide) len
+  INTO pg_temp.test_l03n
+  FROM t_late l, t_int2 r
+ WHERE l.key = r.id AND l.wide LIKE '%a0%';
+SELECT l.id, x.id xid, y.id yid, l.wide
+  INTO pg_temp.test_l04n
+  FROM t_late l, t_int2 x, t_int2 y
+ WHERE l.key = x.id AND l.id = y.id AND x.b % 7 = 2;
+-- outer side is empty, so ctid is NULL
+SELECT l.id, l.wide, r.id rid
+  INTO pg_temp.test_l05n
+  FROM t_late l RIGHT JOIN t_int2 r ON l.key = r.id AND l.id % 3 = 0
+ WHERE r.id % 20 = 0;
+SELECT l.id, l.note, r.id rid
+  INTO pg_temp.test_l06n
+  FROM t_late l FULL JOIN (SELECT * FROM t_int2 WHERE id % 20 = 0 OFFSET 0) r
+    ON l.key = r.id AND l.id % 3 = 0;
+RESET pg_strom.enable_gpujoin_late_materialization;
+
+SET pg_strom.enabled = off;
+SELECT l.id, l.wide, r.c
+  INTO pg_temp.test_l01b
+  FROM t_late l, t_int2 r
+ WHERE l.key = r.id AND r.c % 10 = 3;
+SELECT l.id, l.wide, l.note, r.a
+  INTO pg_temp.test_l02b
+  FROM t_late l LEFT JOIN t_int2 r ON l.key = r.id AND r.a % 5 = 1;
+SELECT l.id, r.id rid, l.wide, length(l.wide) len
+  INTO pg_temp.test_l03b
+  FROM t_late l, t_int2 r
+ WHERE l.key = r.id AND l.wide LIKE '%a0%';
+SELECT l.id, x.id xid, y.id yid, l.wide
+  INTO pg_temp.test_l04b
+  FROM t_late l, t_int2 x, t_int2 y
+ WHERE l.key = x.id AND l.id = y.id AND x.b % 7 = 2;
+-- outer side is empty, so ctid is NULL
+SELECT l.id, l.wide, r.id rid
+  INTO pg_temp.test_l05b
+  FROM t_late l RIGHT JOIN t_int2 r ON l.key = r.id AND l.id % 3 = 0
+ WHERE r.id % 20 = 0;
+SELECT l.id, l.note, r.id rid
+  INTO pg_temp.test_l06b
+  FROM t_late l FULL JOIN (SELECT * FROM t_int2 WHERE id % 20 = 0 OFFSET 0) r
+    ON l.key = r.id AND l.id % 3 = 0;
+RESET pg_strom.enabled;
+(SELECT * FROM pg_temp.test_l01a EXCEPT ALL SELECT * FROM pg_temp.test_l01b);
+(SELECT * FROM pg_temp.test_l01b EXCEPT ALL SELECT * FROM pg_temp.test_l01a);
+(SELECT * FROM pg_temp.test_l01n EXCEPT ALL SELECT * FROM pg_temp.test_l01b);
+(SELECT * FROM pg_temp.test_l01b EXCEPT ALL SELECT * FROM pg_temp.test_l01n);
+(SELECT * FROM pg_temp.test_l02a EXCEPT ALL SELECT * FROM pg_temp.test_l02b);
+(SELECT * FROM pg_temp.test_l02b EXCEPT ALL SELECT * FROM pg_temp.test_l02a);
+(SELECT * FROM pg_temp.test_l02n EXCEPT ALL SELECT * FROM pg_temp.test_l02b);
+(SELECT * FROM pg_temp.test_l02b EXCEPT ALL SELECT * FROM pg_temp.test_l02n);
+(SELECT * FROM pg_temp.test_l03a EXCEPT ALL SELECT * FROM pg_temp.test_l03b);
+(SELECT * FROM pg_temp.test_l03b EXCEPT ALL SELECT * FROM pg_temp.test_l03a);
+(SELECT * FROM pg_temp.test_l03n EXCEPT ALL SELECT * FROM pg_temp.test_l03b);
+(SELECT * FROM pg_temp.test_l03b EXCEPT ALL SELECT * FROM pg_temp.test_l03n);
+(SELECT * FROM pg_temp.test_l04a EXCEPT ALL SELECT * FROM pg_temp.test_l04b);
+(SELECT * FROM pg_temp.test_l04b EXCEPT ALL SELECT * FROM pg_temp.test_l04a);
+(SELECT * FROM pg_temp.test_l04n EXCEPT ALL SELECT * FROM pg_temp.test_l04b);
+(SELECT * FROM pg_temp.test_l04b EXCEPT ALL SELECT * FROM pg_temp.test_l04n);
+SELECT count(*) > 0 AS null_outer FROM pg_temp.test_l05a WHERE id IS NULL;
+(SELECT * FROM pg_temp.test_l05a EXCEPT ALL SELECT * FROM pg_temp.test_l05b);
+(SELECT * FROM pg_temp.test_l05b EXCEPT ALL SELECT * FROM pg_temp.test_l05a);
+(SELECT * FROM pg_temp.test_l05n EXCEPT ALL SELECT * FROM pg_temp.test_l05b);
+(SELECT * FROM pg_temp.test_l05b EXCEPT ALL SELECT * FROM pg_temp.test_l05n);
+SELECT count(*) > 0 AS null_outer FROM pg_temp.test_l06a WHERE id IS NULL;
+(SELECT * FROM pg_temp.test_l06a EXCEPT ALL SELECT * FROM pg_temp.test_l06b);
+(SELECT * FROM pg_temp.test_l06b EXCEPT ALL SELECT * FROM pg_temp.test_l06a);
+(SELECT * FROM pg_temp.test_l06n EXCEPT ALL SELECT * FROM pg_temp.test_l06b);
+(SELECT * FROM pg_temp.test_l06b EXCEPT ALL SELECT * FROM pg_temp.test_l06n);
+DROP TABLE t_late;
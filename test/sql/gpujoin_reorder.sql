@@ -0,0 +1,77 @@
+---
+--- Test cases for reordering of inner relations on GpuJoin
+---
+RESET pg_strom.enabled;
+SET max_parallel_workers_per_gather = 0;
+CREATE TABLE reorder_o AS
+  SELECT x id, x % 1000 + 1 a, x % 5000 + 1 b, md5(x::text) c
+    FROM generate_series(1,1000000) x;
+-- every outer row matches one row of reorder_i1, 1% of them reorder_i2
+CREATE TABLE reorder_i1 AS
+  SELECT x id, md5((x+1)::text) v
+    FROM generate_series(1,1000) x;
+CREATE TABLE reorder_i2 AS
+  SELECT x * 100 id, md5((x+2)::text) v
+    FROM generate_series(1,50) x;
+ANALYZE reorder_o;
+ANALYZE reorder_i1;
+ANALYZE reorder_i2;
+-- join search of PostgreSQL keeps the syntactic order (o, i1, i2)
+SET join_collapse_limit = 1;
+SELECT regress_plan_uses('SELECT o.id, i1.v, i2.v
+                            FROM reorder_o o
+                            JOIN reorder_i1 i1 ON o.a = i1.id
+                            JOIN reorder_i2 i2 ON o.b = i2.id',
+                         'Inner Order: i2, i1') AS reordered;
+SELECT o.id, o.c, i1.v v1, i2.v v2
+  INTO pg_temp.test_r01a
+  FROM reorder_o o
+  JOIN reorder_i1 i1 ON o.a = i1.id
+  JOIN reorder_i2 i2 ON o.b = i2.id;
+SELECT o.id, i1.v v1, i2.v v2
+  INTO pg_temp.test_r02a
+  FROM reorder_o o
+  JOIN reorder_i1 i1 ON o.a = i1.id
+  JOIN reorder_i2 i2 ON o.b = i2.id AND i2.id < o.a * 10;
+
+SET pg_strom.enable_gpujoin_inner_reorder = off;
+SELECT regress_plan_uses('SELECT o.id, i1.v, i2.v
+                            FROM reorder_o o
+                            JOIN reorder_i1 i1 ON o.a = i1.id
+                            JOIN reorder_i2 i2 ON o.b = i2.id',
+                         'Inner Order') AS reordered;
+SELECT o.id, o.c, i1.v v1, i2.v v2
+  INTO pg_temp.test_r01n
+  FROM reorder_o o
+  JOIN reorder_i1 i1 ON o.a = i1.id
+  JOIN reorder_i2 i2 ON o.b = i2.id;
+SELECT o.id, i1.v v1, i2.v v2
+  INTO pg_temp.test_r02n
+  FROM reorder_o o
+  JOIN reorder_i1 i1 ON o.a = i1.id
+  JOIN reorder_i2 i2 ON o.b = i2.id AND i2.id < o.a * 10;
+RESET pg_strom.enable_gpujoin_inner_reorder;
+
+SET pg_strom.enabled = off;
+SELECT o.id, o.c, i1.v v1, i2.v v2
+  INTO pg_temp.test_r01b
+  FROM reorder_o o
+  JOIN reorder_i1 i1 ON o.a = i1.id
+  JOIN reorder_i2 i2 ON o.b = i2.id;
+SELECT o.id, i1.v v1, i2.v v2
+  INTO pg_temp.test_r02b
+  FROM reorder_o o
+  JOIN reorder_i1 i1 ON o.a = i1.id
+  JOIN reorder_i2 i2 ON o.b = i2.id AND i2.id < o.a * 10;
+RESET pg_strom.enabled;
+(SELECT * FROM pg_temp.test_r01a EXCEPT ALL SELECT * FROM pg_temp.test_r01b);
+(SELECT * FROM pg_temp.test_r01b EXCEPT ALL SELECT * FROM pg_temp.test_r01a);
+(SELECT * FROM pg_temp.test_r01n EXCEPT ALL SELECT * FROM pg_temp.test_r01b);
+(SELECT * FROM pg_temp.test_r01b EXCEPT ALL SELECT * FROM pg_temp.test_r01n);
+(SELECT * FROM pg_temp.test_r02a EXCEPT ALL SELECT * FROM pg_temp.test_r02b);
+(SELECT * FROM pg_temp.test_r02b EXCEPT ALL SELECT * FROM pg_temp.test_r02a);
+(SELECT * FROM pg_temp.test_r02n EXCEPT ALL SELECT * FROM pg_temp.test_r02b);
+(SELECT * FROM pg_temp.test_r02b EXCEPT ALL SELECT * FROM pg_temp.test_r02n);
+DROP TABLE reorder_o;
+DROP TABLE reorder_i1;
+DROP TABLE reorder_i2;
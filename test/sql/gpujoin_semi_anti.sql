@@ -0,0 +1,114 @@
+---
+--- Test cases for SEMI/ANTI JOIN by GpuJoin
+---
+RESET pg_strom.enabled;
+SELECT regress_plan_uses('SELECT id, a, b FROM t_int1 l
+                           WHERE EXISTS (SELECT 1 FROM t_int2 r
+                                          WHERE r.a = l.a AND r.c < 0)',
+                         'GpuHashSemiJoin') AS semi_join;
+SELECT regress_plan_uses('SELECT id, c FROM t_int1 l
+                           WHERE NOT EXISTS (SELECT 1 FROM t_int2 r
+                                              WHERE r.a = l.b)',
+                         'GpuHashAntiJoin') AS anti_join;
+SELECT id, a, b
+  INTO pg_temp.test_j01a
+  FROM t_int1 l
+ WHERE EXISTS (SELECT 1 FROM t_int2 r WHERE r.a = l.a AND r.c < 0);
+SELECT id, c
+  INTO pg_temp.test_j02a
+  FROM t_int1 l
+ WHERE NOT EXISTS (SELECT 1 FROM t_int2 r WHERE r.a = l.b);
+SELECT id, e
+  INTO pg_temp.test_j03a
+  FROM t_int1
+ WHERE a IN (SELECT b FROM t_int2 WHERE d > 0);
+SELECT id, b
+  INTO pg_temp.test_j04a
+  FROM t_int1 l
+ WHERE l.a % 100 = 37
+   AND EXISTS (SELECT 1 FROM t_int2 r WHERE r.b % 100 = 28 AND l.b < r.b);
+SELECT id, b
+  INTO pg_temp.test_j05a
+  FROM t_int1 l
+ WHERE l.a % 100 = 37
+   AND NOT EXISTS (SELECT 1 FROM t_int2 r WHERE r.b % 1000 = 28 AND l.b > r.b);
+SELECT l.id, r.c
+  INTO pg_temp.test_j06a
+  FROM t_int1 l, t_int2 r
+ WHERE l.id = r.id
+   AND NOT EXISTS (SELECT 1 FROM t_int2 x WHERE x.c = l.c);
+
+-- SEMI/ANTI JOIN by CPU fallback
+SET pg_strom.debug_force_cpu_fallback = on;
+SELECT regress_explain_uses('SELECT id, a, b FROM t_int1 l
+                              WHERE EXISTS (SELECT 1 FROM t_int2 r
+                                             WHERE r.a = l.a AND r.c < 0)',
+                            'chunks on CPU') AS semi_fallback;
+SELECT id, a, b
+  INTO pg_temp.test_j01f
+  FROM t_int1 l
+ WHERE EXISTS (SELECT 1 FROM t_int2 r WHERE r.a = l.a AND r.c < 0);
+SELECT id, c
+  INTO pg_temp.test_j02f
+  FROM t_int1 l
+ WHERE NOT EXISTS (SELECT 1 FROM t_int2 r WHERE r.a = l.b);
+SELECT id, b
+  INTO pg_temp.test_j04f
+  FROM t_int1 l
+ WHERE l.a % 100 = 37
+   AND EXISTS (SELECT 1 FROM t_int2 r WHERE r.b % 100 = 28 AND l.b < r.b);
+SELECT id, b
+  INTO pg_temp.test_j05f
+  FROM t_int1 l
+ WHERE l.a % 100 = 37
+   AND NOT EXISTS (SELECT 1 FROM t_int2 r WHERE r.b % 1000 = 28 AND l.b > r.b);
+RESET pg_strom.debug_force_cpu_fallback;
+
+SET pg_strom.enabled = off;
+SELECT id, a, b
+  INTO pg_temp.test_j01b
+  FROM t_int1 l
+ WHERE EXISTS (SELECT 1 FROM t_int2 r WHERE r.a = l.a AND r.c < 0);
+SELECT id, c
+  INTO pg_temp.test_j02b
+  FROM t_int1 l
+ WHERE NOT EXISTS (SELECT 1 FROM t_int2 r WHERE r.a = l.b);
+SELECT id, e
+  INTO pg_temp.test_j03b
+  FROM t_int1
+ WHERE a IN (SELECT b FROM t_int2 WHERE d > 0);
+SELECT id, b
+  INTO pg_temp.test_j04b
+  FROM t_int1 l
+ WHERE l.a % 100 = 37
+   AND EXISTS (SELECT 1 FROM t_int2 r WHERE r.b % 100 = 28 AND l.b < r.b);
+SELECT id, b
+  INTO pg_temp.test_j05b
+  FROM t_int1 l
+ WHERE l.a % 100 = 37
+   AND NOT EXISTS (SELECT 1 FROM t_int2 r WHERE r.b % 1000 = 28 AND l.b > r.b);
+SELECT l.id, r.c
+  INTO pg_temp.test_j06b
+  FROM t_int1 l, t_int2 r
+ WHERE l.id = r.id
+   AND NOT EXISTS (SELECT 1 FROM t_int2 x WHERE x.c = l.c);
+(SELECT * FROM pg_temp.test_j01a EXCEPT ALL SELECT * FROM pg_temp.test_j01b);
+(SELECT * FROM pg_temp.test_j01b EXCEPT ALL SELECT * FROM pg_temp.test_j01a);
+(SELECT * FROM pg_temp.test_j02a EXCEPT ALL SELECT * FROM pg_temp.test_j02b);
+(SELECT * FROM pg_temp.test_j02b EXCEPT ALL SELECT * FROM pg_temp.test_j02a);
+(SELECT * FROM pg_temp.test_j03a EXCEPT ALL SELECT * FROM pg_temp.test_j03b);
+(SELECT * FROM pg_temp.test_j03b EXCEPT ALL SELECT * FROM pg_temp.test_j03a);
+(SELECT * FROM pg_temp.test_j04a EXCEPT ALL SELECT * FROM pg_temp.test_j04b);
+(SELECT * FROM pg_temp.test_j04b EXCEPT ALL SELECT * FROM pg_temp.test_j04a);
+(SELECT * FROM pg_temp.test_j05a EXCEPT ALL SELECT * FROM pg_temp.test_j05b);
+(SELECT * FROM pg_temp.test_j05b EXCEPT ALL SELECT * FROM pg_temp.test_j05a);
+(SELECT * FROM pg_temp.test_j06a EXCEPT ALL SELECT * FROM pg_temp.test_j06b);
+(SELECT * FROM pg_temp.test_j06b EXCEPT ALL SELECT * FROM pg_temp.test_j06a);
+(SELECT * FROM pg_temp.test_j01f EXCEPT ALL SELECT * FROM pg_temp.test_j01b);
+(SELECT * FROM pg_temp.test_j01b EXCEPT ALL SELECT * FROM pg_temp.test_j01f);
+(SELECT * FROM pg_temp.test_j02f EXCEPT ALL SELECT * FROM pg_temp.test_j02b);
+(SELECT * FROM pg_temp.test_j02b EXCEPT ALL SELECT * FROM pg_temp.test_j02f);
+(SELECT * FROM pg_temp.test_j04f EXCEPT ALL SELECT * FROM pg_temp.test_j04b);
+(SELECT * FROM pg_temp.test_j04b EXCEPT ALL SELECT * FROM pg_temp.test_j04f);
+(SELECT * FROM pg_temp.test_j05f EXCEPT ALL SELECT * FROM pg_temp.test_j05b);
+(SELECT * FROM pg_temp.test_j05b EXCEPT ALL SELECT * FROM pg_temp.test_j05f);
@@ -0,0 +1,73 @@
+---
+--- Test cases for DISTINCT aggregates by GpuPreAgg
+---
+RESET pg_strom.enabled;
+SELECT c % 100 k, count(DISTINCT a) cnt, count(*) n
+  INTO pg_temp.test_p01a
+  FROM t_int1
+ GROUP BY k;
+SELECT a % 10 k, count(DISTINCT b) c1, sum(DISTINCT d) c2, max(e) c3
+  INTO pg_temp.test_p02a
+  FROM t_int1
+ WHERE c > 0
+ GROUP BY k;
+SELECT count(DISTINCT b) c1, count(DISTINCT d % 1000) c2
+  INTO pg_temp.test_p03a
+  FROM t_int1;
+SELECT b % 50 k, count(DISTINCT a) c1
+  INTO pg_temp.test_p04a
+  FROM t_int1
+ GROUP BY k
+HAVING count(DISTINCT a) > 10;
+SELECT r.a % 20 k, count(DISTINCT l.b) c1, sum(r.c) c2
+  INTO pg_temp.test_p05a
+  FROM t_int1 l, t_int2 r
+ WHERE l.id = r.id
+ GROUP BY k;
+SELECT a, count(DISTINCT a) c1, count(DISTINCT c) c2
+  INTO pg_temp.test_p06a
+  FROM t_int1
+ WHERE e > 0
+ GROUP BY a;
+
+SET pg_strom.enabled = off;
+SELECT c % 100 k, count(DISTINCT a) cnt, count(*) n
+  INTO pg_temp.test_p01b
+  FROM t_int1
+ GROUP BY k;
+SELECT a % 10 k, count(DISTINCT b) c1, sum(DISTINCT d) c2, max(e) c3
+  INTO pg_temp.test_p02b
+  FROM t_int1
+ WHERE c > 0
+ GROUP BY k;
+SELECT count(DISTINCT b) c1, count(DISTINCT d % 1000) c2
+  INTO pg_temp.test_p03b
+  FROM t_int1;
+SELECT b % 50 k, count(DISTINCT a) c1
+  INTO pg_temp.test_p04b
+  FROM t_int1
+ GROUP BY k
+HAVING count(DISTINCT a) > 10;
+SELECT r.a % 20 k, count(DISTINCT l.b) c1, sum(r.c) c2
+  INTO pg_temp.test_p05b
+  FROM t_int1 l, t_int2 r
+ WHERE l.id = r.id
+ GROUP BY k;
+SELECT a, count(DISTINCT a) c1, count(DISTINCT c) c2
+  INTO pg_temp.test_p06b
+  FROM t_int1
+ WHERE e > 0
+ GROUP BY a;
+
+(SELECT * FROM pg_temp.test_p01a EXCEPT ALL SELECT * FROM pg_temp.test_p01b);
+(SELECT * FROM pg_temp.test_p01b EXCEPT ALL SELECT * FROM pg_temp.test_p01a);
+(SELECT * FROM pg_temp.test_p02a EXCEPT ALL SELECT * FROM pg_temp.test_p02b);
+(SELECT * FROM pg_temp.test_p02b EXCEPT ALL SELECT * FROM pg_temp.test_p02a);
+(SELECT * FROM pg_temp.test_p03a EXCEPT ALL SELECT * FROM pg_temp.test_p03b);
+(SELECT * FROM pg_temp.test_p03b EXCEPT ALL SELECT * FROM pg_temp.test_p03a);
+(SELECT * FROM pg_temp.test_p04a EXCEPT ALL SELECT * FROM pg_temp.test_p04b);
+(SELECT * FROM pg_temp.test_p04b EXCEPT ALL SELECT * FROM pg_temp.test_p04a);
+(SELECT * FROM pg_temp.test_p05a EXCEPT ALL SELECT * FROM pg_temp.test_p05b);
+(SELECT * FROM pg_temp.test_p05b EXCEPT ALL SELECT * FROM pg_temp.test_p05a);
+(SELECT * FROM pg_temp.test_p06a EXCEPT ALL SELECT * FROM pg_temp.test_p06b);
+(SELECT * FROM pg_temp.test_p06b EXCEPT ALL SELECT * FROM pg_temp.test_p06a);
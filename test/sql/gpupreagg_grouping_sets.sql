@@ -0,0 +1,73 @@
+---
+--- Test cases for GROUPING SETS / ROLLUP / CUBE by GpuPreAgg
+---
+RESET pg_strom.enabled;
+SELECT a % 10 k1, b % 10 k2, count(*) n, sum(c) s
+  INTO pg_temp.test_g01a
+  FROM t_int1
+ GROUP BY ROLLUP(a % 10, b % 10);
+SELECT a % 5 k1, c % 7 k2, avg(d) v1, max(e) v2
+  INTO pg_temp.test_g02a
+  FROM t_int1
+ WHERE b > 0
+ GROUP BY CUBE(a % 5, c % 7);
+SELECT a % 10 k1, d % 10 k2, GROUPING(a % 10, d % 10) g, count(*) n, min(e) v
+  INTO pg_temp.test_g03a
+  FROM t_int1
+ GROUP BY GROUPING SETS ((a % 10), (d % 10), ());
+SELECT b % 20 k1, c % 3 k2, sum(d) s
+  INTO pg_temp.test_g04a
+  FROM t_int1
+ GROUP BY ROLLUP(b % 20, c % 3)
+HAVING sum(d) > 0;
+SELECT a % 10 k1, b % 5 k2, count(DISTINCT c) c1, count(*) n
+  INTO pg_temp.test_g05a
+  FROM t_int1
+ GROUP BY ROLLUP(a % 10, b % 5);
+SELECT l.a % 10 k1, r.a % 10 k2, sum(r.e) s
+  INTO pg_temp.test_g06a
+  FROM t_int1 l, t_int2 r
+ WHERE l.id = r.id
+ GROUP BY ROLLUP(l.a % 10, r.a % 10);
+
+SET pg_strom.enabled = off;
+SELECT a % 10 k1, b % 10 k2, count(*) n, sum(c) s
+  INTO pg_temp.test_g01b
+  FROM t_int1
+ GROUP BY ROLLUP(a % 10, b % 10);
+SELECT a % 5 k1, c % 7 k2, avg(d) v1, max(e) v2
+  INTO pg_temp.test_g02b
+  FROM t_int1
+ WHERE b > 0
+ GROUP BY CUBE(a % 5, c % 7);
+SELECT a % 10 k1, d % 10 k2, GROUPING(a % 10, d % 10) g, count(*) n, min(e) v
+  INTO pg_temp.test_g03b
+  FROM t_int1
+ GROUP BY GROUPING SETS ((a % 10), (d % 10), ());
+SELECT b % 20 k1, c % 3 k2, sum(d) s
+  INTO pg_temp.test_g04b
+  FROM t_int1
+ GROUP BY ROLLUP(b % 20, c % 3)
+HAVING sum(d) > 0;
+SELECT a % 10 k1, b % 5 k2, count(DISTINCT c) c1, count(*) n
+  INTO pg_temp.test_g05b
+  FROM t_int1
+ GROUP BY ROLLUP(a % 10, b % 5);
+SELECT l.a % 10 k1, r.a % 10 k2, sum(r.e) s
+  INTO pg_temp.test_g06b
+  FROM t_int1 l, t_int2 r
+ WHERE l.id = r.id
+ GROUP BY ROLLUP(l.a % 10, r.a % 10);
+
+(SELECT * FROM pg_temp.test_g01a EXCEPT ALL SELECT * FROM pg_temp.test_g01b);
+(SELECT * FROM pg_temp.test_g01b EXCEPT ALL SELECT * FROM pg_temp.test_g01a);
+(SELECT * FROM pg_temp.test_g02a EXCEPT ALL SELECT * FROM pg_temp.test_g02b);
+(SELECT * FROM pg_temp.test_g02b EXCEPT ALL SELECT * FROM pg_temp.test_g02a);
+(SELECT * FROM pg_temp.test_g03a EXCEPT ALL SELECT * FROM pg_temp.test_g03b);
+(SELECT * FROM pg_temp.test_g03b EXCEPT ALL SELECT * FROM pg_temp.test_g03a);
+(SELECT * FROM pg_temp.test_g04a EXCEPT ALL SELECT * FROM pg_temp.test_g04b);
+(SELECT * FROM pg_temp.test_g04b EXCEPT ALL SELECT * FROM pg_temp.test_g04a);
+(SELECT * FROM pg_temp.test_g05a EXCEPT ALL SELECT * FROM pg_temp.test_g05b);
+(SELECT * FROM pg_temp.test_g05b EXCEPT ALL SELECT * FROM pg_temp.test_g05a);
+(SELECT * FROM pg_temp.test_g06a EXCEPT ALL SELECT * FROM pg_temp.test_g06b);
+(SELECT * FROM pg_temp.test_g06b EXCEPT ALL SELECT * FROM pg_temp.test_g06a);
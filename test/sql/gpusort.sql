@@ -0,0 +1,147 @@
+---
+--- Test cases for GpuSort
+---
+RESET pg_strom.enabled;
+-- GpuSort shall be chosen for the sort on GpuScan
+SELECT regress_plan_uses('SELECT a, c FROM t_int1 WHERE b > 0 ORDER BY a, c DESC',
+                         'GpuSort') AS gpusort;
+SELECT row_number() OVER () rn, a, c
+  INTO pg_temp.test_s01a
+  FROM (SELECT a, c FROM t_int1
+         WHERE b > 0
+         ORDER BY a, c DESC) s;
+SELECT row_number() OVER () rn, id, e
+  INTO pg_temp.test_s02a
+  FROM (SELECT id, e FROM t_int1
+         WHERE c % 10 = 3
+         ORDER BY e DESC NULLS LAST, id) s;
+SELECT row_number() OVER () rn, d, e
+  INTO pg_temp.test_s03a
+  FROM (SELECT d, e FROM t_float1
+         WHERE c > 0
+         ORDER BY d NULLS FIRST, e) s;
+SELECT row_number() OVER () rn, c, e
+  INTO pg_temp.test_s04a
+  FROM (SELECT l.c, r.e FROM t_int1 l, t_int2 r
+         WHERE l.id = r.id AND l.a > 0
+         ORDER BY r.e, l.c) s;
+SELECT row_number() OVER () rn, id, c
+  INTO pg_temp.test_s05a
+  FROM (SELECT id, c FROM t_int1
+         WHERE a > 0
+         ORDER BY c DESC, id
+         LIMIT 100) s;
+SELECT row_number() OVER () rn, id, e
+  INTO pg_temp.test_s06a
+  FROM (SELECT l.id, r.e FROM t_int1 l, t_int2 r
+         WHERE l.id = r.id AND l.b > 0
+         ORDER BY r.e NULLS FIRST, l.id
+         LIMIT 1000 OFFSET 50) s;
+
+-- sorted runs beyond work_mem are merged by tuplesort
+SET work_mem = '64kB';
+SELECT row_number() OVER () rn, id, e
+  INTO pg_temp.test_s07a
+  FROM (SELECT id, e FROM t_int1
+         ORDER BY e, id) s;
+RESET work_mem;
+-- chunks are sorted on CPU while GPU program is being built
+SET pg_strom.cpu_fallback_during_build = on;
+SELECT row_number() OVER () rn, id, f
+  INTO pg_temp.test_s08a
+  FROM (SELECT id, f FROM t_int1
+         WHERE a % 7 = 2
+         ORDER BY f DESC, id) s;
+RESET pg_strom.cpu_fallback_during_build;
+-- top-k by the bounded heap of CPU while GPU program is being built
+SET pg_strom.cpu_fallback_during_build = on;
+SELECT row_number() OVER () rn, id, c
+  INTO pg_temp.test_s09a
+  FROM (SELECT id, c FROM t_int1
+         WHERE b % 5 = 1
+         ORDER BY c, id
+         LIMIT 500) s;
+RESET pg_strom.cpu_fallback_during_build;
+-- top-k by the bounded tuplesort
+SET work_mem = '64kB';
+SELECT row_number() OVER () rn, id, e
+  INTO pg_temp.test_s10a
+  FROM (SELECT id, e FROM t_int1
+         ORDER BY e DESC, id
+         LIMIT 2000) s;
+RESET work_mem;
+
+SET pg_strom.enabled = off;
+SELECT row_number() OVER () rn, a, c
+  INTO pg_temp.test_s01b
+  FROM (SELECT a, c FROM t_int1
+         WHERE b > 0
+         ORDER BY a, c DESC) s;
+SELECT row_number() OVER () rn, id, e
+  INTO pg_temp.test_s02b
+  FROM (SELECT id, e FROM t_int1
+         WHERE c % 10 = 3
+         ORDER BY e DESC NULLS LAST, id) s;
+SELECT row_number() OVER () rn, d, e
+  INTO pg_temp.test_s03b
+  FROM (SELECT d, e FROM t_float1
+         WHERE c > 0
+         ORDER BY d NULLS FIRST, e) s;
+SELECT row_number() OVER () rn, c, e
+  INTO pg_temp.test_s04b
+  FROM (SELECT l.c, r.e FROM t_int1 l, t_int2 r
+         WHERE l.id = r.id AND l.a > 0
+         ORDER BY r.e, l.c) s;
+SELECT row_number() OVER () rn, id, c
+  INTO pg_temp.test_s05b
+  FROM (SELECT id, c FROM t_int1
+         WHERE a > 0
+         ORDER BY c DESC, id
+         LIMIT 100) s;
+SELECT row_number() OVER () rn, id, e
+  INTO pg_temp.test_s06b
+  FROM (SELECT l.id, r.e FROM t_int1 l, t_int2 r
+         WHERE l.id = r.id AND l.b > 0
+         ORDER BY r.e NULLS FIRST, l.id
+         LIMIT 1000 OFFSET 50) s;
+SELECT row_number() OVER () rn, id, e
+  INTO pg_temp.test_s07b
+  FROM (SELECT id, e FROM t_int1
+         ORDER BY e, id) s;
+SELECT row_number() OVER () rn, id, f
+  INTO pg_temp.test_s08b
+  FROM (SELECT id, f FROM t_int1
+         WHERE a % 7 = 2
+         ORDER BY f DESC, id) s;
+SELECT row_number() OVER () rn, id, c
+  INTO pg_temp.test_s09b
+  FROM (SELECT id, c FROM t_int1
+         WHERE b % 5 = 1
+         ORDER BY c, id
+         LIMIT 500) s;
+SELECT row_number() OVER () rn, id, e
+  INTO pg_temp.test_s10b
+  FROM (SELECT id, e FROM t_int1
+         ORDER BY e DESC, id
+         LIMIT 2000) s;
+
+(SELECT * FROM pg_temp.test_s01a EXCEPT ALL SELECT * FROM pg_temp.test_s01b);
+(SELECT * FROM pg_temp.test_s01b EXCEPT ALL SELECT * FROM pg_temp.test_s01a);
+(SELECT * FROM pg_temp.test_s02a EXCEPT ALL SELECT * FROM pg_temp.test_s02b);
+(SELECT * FROM pg_temp.test_s02b EXCEPT ALL SELECT * FROM pg_temp.test_s02a);
+(SELECT * FROM pg_temp.test_s03a EXCEPT ALL SELECT * FROM pg_temp.test_s03b);
+(SELECT * FROM pg_temp.test_s03b EXCEPT ALL SELECT * FROM pg_temp.test_s03a);
+(SELECT * FROM pg_temp.test_s04a EXCEPT ALL SELECT * FROM pg_temp.test_s04b);
+(SELECT * FROM pg_temp.test_s04b EXCEPT ALL SELECT * FROM pg_temp.test_s04a);
+(SELECT * FROM pg_temp.test_s05a EXCEPT ALL SELECT * FROM pg_temp.test_s05b);
+(SELECT * FROM pg_temp.test_s05b EXCEPT ALL SELECT * FROM pg_temp.test_s05a);
+(SELECT * FROM pg_temp.test_s06a EXCEPT ALL SELECT * FROM pg_temp.test_s06b);
+(SELECT * FROM pg_temp.test_s06b EXCEPT ALL SELECT * FROM pg_temp.test_s06a);
+(SELECT * FROM pg_temp.test_s07a EXCEPT ALL SELECT * FROM pg_temp.test_s07b);
+(SELECT * FROM pg_temp.test_s07b EXCEPT ALL SELECT * FROM pg_temp.test_s07a);
+(SELECT * FROM pg_temp.test_s08a EXCEPT ALL SELECT * FROM pg_temp.test_s08b);
+(SELECT * FROM pg_temp.test_s08b EXCEPT ALL SELECT * FROM pg_temp.test_s08a);
+(SELECT * FROM pg_temp.test_s09a EXCEPT ALL SELECT * FROM pg_temp.test_s09b);
+(SELECT * FROM pg_temp.test_s09b EXCEPT ALL SELECT * FROM pg_temp.test_s09a);
+(SELECT * FROM pg_temp.test_s10a EXCEPT ALL SELECT * FROM pg_temp.test_s10b);
+(SELECT * FROM pg_temp.test_s10b EXCEPT ALL SELECT * FROM pg_temp.test_s10a);
@@ -0,0 +1,109 @@
+---
+--- Test cases for the checkpoint files of gstore_fdw
+---
+RESET pg_strom.enabled;
+SET pg_strom.gstore_checkpoint = on;
+CREATE FOREIGN TABLE gs_cp_t1 (id int, v float8, memo text)
+  SERVER gstore_fdw OPTIONS (pinning '0', format 'pgstrom');
+CREATE FOREIGN TABLE gs_cp_t2 (id int, v float8, memo text)
+  SERVER gstore_fdw OPTIONS (pinning '0', format 'pgstrom');
+CREATE FOREIGN TABLE gs_cp_t3 (id int, v float8)
+  SERVER gstore_fdw OPTIONS (pinning '0', format 'pgstrom');
+CREATE FOREIGN TABLE gs_cp_t4 (memo text)
+  SERVER gstore_fdw OPTIONS (pinning '0', format 'pgstrom');
+INSERT INTO gs_cp_t1 (SELECT x, x / 7.0,
+                             CASE WHEN x % 10 = 0 THEN NULL ELSE md5(x::text) END
+                        FROM generate_series(1,1000) x);
+INSERT INTO gs_cp_t4 VALUES ('gs_cp_t4 distinctive memo');
+CREATE FUNCTION pg_temp.cp_image(relid regclass)
+RETURNS bytea AS $$
+  SELECT pg_read_binary_file('pg_strom_gstore/' ||
+                             (SELECT oid FROM pg_database
+                               WHERE datname = current_database()) ||
+                             '_' || relid::oid || '.kds')
+$$ LANGUAGE sql;
+-- table_oid of the checkpoint header, stored in little-endian
+CREATE FUNCTION pg_temp.cp_patch_oid(image bytea, relid regclass)
+RETURNS bytea AS $$
+DECLARE
+  ival   bigint := relid::oid::bigint;
+BEGIN
+  FOR i IN 0..3 LOOP
+    image := set_byte(image, 16 + i, ((ival >> (8 * i)) & 255)::int);
+  END LOOP;
+  RETURN image;
+END
+$$ LANGUAGE plpgsql;
+CREATE FUNCTION pg_temp.cp_write(image bytea, relid regclass)
+RETURNS void AS $$
+DECLARE
+  lobj   oid := lo_from_bytea(0, image);
+BEGIN
+  PERFORM lo_export(lobj, current_setting('data_directory') ||
+                          '/pg_strom_gstore/' ||
+                          (SELECT oid FROM pg_database
+                            WHERE datname = current_database()) ||
+                          '_' || relid::oid || '.kds');
+  PERFORM lo_unlink(lobj);
+END
+$$ LANGUAGE plpgsql;
+SELECT pg_temp.cp_image('gs_cp_t1') AS image
+  INTO pg_temp.cp_t1;
+SELECT pg_temp.cp_image('gs_cp_t4') AS image
+  INTO pg_temp.cp_t4;
+
+-- validation of the image as is
+SELECT pgstrom.gstore_fdw_checkpoint_validate('gs_cp_t1', image) IS NULL
+       AS cp_valid
+  FROM pg_temp.cp_t1;
+-- broken header
+SELECT pgstrom.gstore_fdw_checkpoint_validate('gs_cp_t1',
+                                              set_byte(image, 0, 0))
+       = 'wrong magic' AS cp_magic
+  FROM pg_temp.cp_t1;
+SELECT pgstrom.gstore_fdw_checkpoint_validate('gs_cp_t2', image)
+       = 'database or table mismatch' AS cp_table
+  FROM pg_temp.cp_t1;
+SELECT pgstrom.gstore_fdw_checkpoint_validate('gs_cp_t1',
+                                              substring(image, 1, length(image) - 8))
+       = 'wrong image length' AS cp_length
+  FROM pg_temp.cp_t1;
+SELECT pgstrom.gstore_fdw_checkpoint_validate('gs_cp_t3',
+                             pg_temp.cp_patch_oid(image, 'gs_cp_t3'))
+       = 'number of columns mismatch' AS cp_ncols
+  FROM pg_temp.cp_t1;
+-- varlena header which points beyond the column
+SELECT pgstrom.gstore_fdw_checkpoint_validate('gs_cp_t4',
+          set_byte(image, position('gs_cp_t4 distinctive memo'::bytea
+                                   in image) - 2, 127))
+       = 'varlena out of range' AS cp_varlena
+  FROM pg_temp.cp_t4;
+-- broken contents
+SELECT pgstrom.gstore_fdw_checkpoint_validate('gs_cp_t1',
+          set_byte(image, length(image) - 1,
+                   get_byte(image, length(image) - 1) # 255))
+       = 'checksum mismatch' AS cp_checksum
+  FROM pg_temp.cp_t1;
+
+-- restore gs_cp_t2 from the image of gs_cp_t1
+DO $$
+BEGIN
+  PERFORM pg_temp.cp_write(pg_temp.cp_patch_oid(image, 'gs_cp_t2'), 'gs_cp_t2')
+     FROM pg_temp.cp_t1;
+END
+$$;
+SELECT id, v, memo
+  INTO pg_temp.cp_r1
+  FROM gs_cp_t1;
+SELECT id, v, memo
+  INTO pg_temp.cp_r2
+  FROM gs_cp_t2;
+(SELECT * FROM pg_temp.cp_r1 EXCEPT ALL SELECT * FROM pg_temp.cp_r2);
+(SELECT * FROM pg_temp.cp_r2 EXCEPT ALL SELECT * FROM pg_temp.cp_r1);
+SELECT count(*) = 1000 AS cp_restored FROM gs_cp_t2;
+
+-- cleanup
+DROP FOREIGN TABLE gs_cp_t1;
+DROP FOREIGN TABLE gs_cp_t2;
+DROP FOREIGN TABLE gs_cp_t3;
+DROP FOREIGN TABLE gs_cp_t4;
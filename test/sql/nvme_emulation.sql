@@ -0,0 +1,42 @@
+---
+--- Test cases for NVMe-Strom emulation on ordinary files
+---
+RESET pg_strom.enabled;
+SET max_parallel_workers_per_gather = 0;
+SET pg_strom.nvme_strom_emulation = on;
+SET pg_strom.nvme_strom_threshold = '128MB';
+-- sparse table larger than the threshold, mostly not on the shared buffers
+CREATE TABLE nvme_emu_t1 (id int, a int, b float8, c text)
+  WITH (fillfactor = 10);
+INSERT INTO nvme_emu_t1
+     SELECT x, x % 1000, x / 7.0, md5(x::text)
+       FROM generate_series(1,200000) x;
+VACUUM ANALYZE nvme_emu_t1;
+
+-- uncached blocks are loaded by O_DIRECT asynchronous reads
+SELECT regress_explain_uses('SELECT id, c FROM nvme_emu_t1 WHERE a % 7 = 3',
+                            '(emulated)') AS emulated;
+SELECT id, a, b, c
+  INTO pg_temp.test_e01a
+  FROM nvme_emu_t1
+ WHERE a % 7 = 3;
+SELECT id, a, b, c
+  INTO pg_temp.test_e02a
+  FROM nvme_emu_t1
+ WHERE b > 1000.0 AND id % 11 = 5;
+
+SET pg_strom.enabled = off;
+SELECT id, a, b, c
+  INTO pg_temp.test_e01b
+  FROM nvme_emu_t1
+ WHERE a % 7 = 3;
+SELECT id, a, b, c
+  INTO pg_temp.test_e02b
+  FROM nvme_emu_t1
+ WHERE b > 1000.0 AND id % 11 = 5;
+
+(SELECT * FROM pg_temp.test_e01a EXCEPT ALL SELECT * FROM pg_temp.test_e01b);
+(SELECT * FROM pg_temp.test_e01b EXCEPT ALL SELECT * FROM pg_temp.test_e01a);
+(SELECT * FROM pg_temp.test_e02a EXCEPT ALL SELECT * FROM pg_temp.test_e02b);
+(SELECT * FROM pg_temp.test_e02b EXCEPT ALL SELECT * FROM pg_temp.test_e02a);
+DROP TABLE nvme_emu_t1;
@@ -0,0 +1,115 @@
+---
+--- Test cases for whole-page copy of the buffered blocks
+---
+RESET pg_strom.enabled;
+SET max_parallel_workers_per_gather = 0;
+CREATE TABLE page_copy_t1 (id int, a int, b float8, c text);
+INSERT INTO page_copy_t1
+     SELECT x, x % 1000, x / 7.0, md5(x::text)
+       FROM generate_series(1,100000) x;
+VACUUM ANALYZE page_copy_t1;
+
+-- page copy is used by default
+SELECT regress_explain_uses('SELECT id, c FROM page_copy_t1 WHERE a % 7 = 3',
+                            'Page Copy') AS page_copy_default;
+SET pg_strom.enable_page_copy = off;
+SELECT regress_explain_uses('SELECT id, c FROM page_copy_t1 WHERE a % 7 = 3',
+                            'Page Copy') AS page_copy_off;
+SET pg_strom.enable_page_copy = on;
+SELECT regress_explain_uses('SELECT id, c FROM page_copy_t1 WHERE a % 7 = 3',
+                            'Page Copy') AS page_copy;
+
+-- all-visible pages
+SELECT id, a, b, c
+  INTO pg_temp.test_p01a
+  FROM page_copy_t1
+ WHERE a % 7 = 3;
+SELECT id, a * 2 AS x, b + 1.0 AS y
+  INTO pg_temp.test_p02a
+  FROM page_copy_t1
+ WHERE b > 1000.0 AND id % 11 = 5;
+SET pg_strom.enabled = off;
+SELECT id, a, b, c
+  INTO pg_temp.test_p01b
+  FROM page_copy_t1
+ WHERE a % 7 = 3;
+SELECT id, a * 2 AS x, b + 1.0 AS y
+  INTO pg_temp.test_p02b
+  FROM page_copy_t1
+ WHERE b > 1000.0 AND id % 11 = 5;
+(SELECT * FROM pg_temp.test_p01a EXCEPT ALL SELECT * FROM pg_temp.test_p01b);
+(SELECT * FROM pg_temp.test_p01b EXCEPT ALL SELECT * FROM pg_temp.test_p01a);
+(SELECT * FROM pg_temp.test_p02a EXCEPT ALL SELECT * FROM pg_temp.test_p02b);
+(SELECT * FROM pg_temp.test_p02b EXCEPT ALL SELECT * FROM pg_temp.test_p02a);
+
+-- not all-visible pages; line pointers of invisible tuples are invalidated
+DELETE FROM page_copy_t1 WHERE id % 5 = 0;
+UPDATE page_copy_t1 SET a = a + 1 WHERE id % 13 = 0;
+SET pg_strom.enabled = on;
+SELECT id, a, b, c
+  INTO pg_temp.test_p03a
+  FROM page_copy_t1
+ WHERE a % 7 = 3;
+SELECT id, a * 2 AS x, b + 1.0 AS y
+  INTO pg_temp.test_p04a
+  FROM page_copy_t1
+ WHERE b > 1000.0 AND id % 11 = 5;
+SET pg_strom.enabled = off;
+SELECT id, a, b, c
+  INTO pg_temp.test_p03b
+  FROM page_copy_t1
+ WHERE a % 7 = 3;
+SELECT id, a * 2 AS x, b + 1.0 AS y
+  INTO pg_temp.test_p04b
+  FROM page_copy_t1
+ WHERE b > 1000.0 AND id % 11 = 5;
+(SELECT * FROM pg_temp.test_p03a EXCEPT ALL SELECT * FROM pg_temp.test_p03b);
+(SELECT * FROM pg_temp.test_p03b EXCEPT ALL SELECT * FROM pg_temp.test_p03a);
+(SELECT * FROM pg_temp.test_p04a EXCEPT ALL SELECT * FROM pg_temp.test_p04b);
+(SELECT * FROM pg_temp.test_p04b EXCEPT ALL SELECT * FROM pg_temp.test_p04a);
+
+-- tuples removed by the current transaction
+BEGIN;
+DELETE FROM page_copy_t1 WHERE id % 3 = 0;
+SET LOCAL pg_strom.enabled = on;
+SELECT id, a, b, c
+  INTO pg_temp.test_p05a
+  FROM page_copy_t1
+ WHERE a % 7 = 3;
+SET LOCAL pg_strom.enabled = off;
+SELECT id, a, b, c
+  INTO pg_temp.test_p05b
+  FROM page_copy_t1
+ WHERE a % 7 = 3;
+(SELECT * FROM pg_temp.test_p05a EXCEPT ALL SELECT * FROM pg_temp.test_p05b);
+(SELECT * FROM pg_temp.test_p05b EXCEPT ALL SELECT * FROM pg_temp.test_p05a);
+ROLLBACK;
+
+-- mixture of all-visible and not all-visible pages; chunks are built
+-- page-by-page or tuple-by-tuple according to their first block
+VACUUM page_copy_t1;
+DELETE FROM page_copy_t1 WHERE id BETWEEN 40001 AND 42000 AND id % 2 = 0;
+UPDATE page_copy_t1 SET c = 'updated' WHERE id BETWEEN 70001 AND 70500;
+SET pg_strom.enabled = on;
+SELECT id, a, b, c
+  INTO pg_temp.test_p06a
+  FROM page_copy_t1
+ WHERE a % 7 = 3;
+SELECT id, a * 2 AS x, c
+  INTO pg_temp.test_p07a
+  FROM page_copy_t1
+ WHERE id % 3 = 1;
+SET pg_strom.enabled = off;
+SELECT id, a, b, c
+  INTO pg_temp.test_p06b
+  FROM page_copy_t1
+ WHERE a % 7 = 3;
+SELECT id, a * 2 AS x, c
+  INTO pg_temp.test_p07b
+  FROM page_copy_t1
+ WHERE id % 3 = 1;
+(SELECT * FROM pg_temp.test_p06a EXCEPT ALL SELECT * FROM pg_temp.test_p06b);
+(SELECT * FROM pg_temp.test_p06b EXCEPT ALL SELECT * FROM pg_temp.test_p06a);
+(SELECT * FROM pg_temp.test_p07a EXCEPT ALL SELECT * FROM pg_temp.test_p07b);
+(SELECT * FROM pg_temp.test_p07b EXCEPT ALL SELECT * FROM pg_temp.test_p07a);
+DROP TABLE page_copy_t1;
@@ -6,10 +6,28 @@ SHOW pg_strom.enable_gpuscan;
 SHOW pg_strom.enable_gpuhashjoin;
 SHOW pg_strom.enable_gpunestloop;
 SHOW pg_strom.enable_gpupreagg;
+SHOW pg_strom.enable_gpusort;
 SHOW pg_strom.enable_numeric_type;
 SHOW pg_strom.cpu_fallback;
+SHOW pg_strom.cpu_fallback_vectorized;
 SHOW pg_strom.gpu_setup_cost;
 SHOW pg_strom.gpu_operator_cost;
 SHOW pg_strom.gpu_dma_cost;
 SHOW pg_strom.pullup_outer_scan;
 SHOW pg_strom.pullup_outer_join;
+SHOW pg_strom.enable_arrow_fdw;
+SHOW pg_strom.arrow_fdw_stats_hint;
+SHOW pg_strom.gstore_checkpoint;
+SHOW pg_strom.nvme_strom_emulation;
+SHOW pg_strom.enable_zonemap;
+SHOW pg_strom.enable_page_copy;
+SHOW pg_strom.enable_cost_profile;
+SHOW pg_strom.enable_gpupreagg_feedback;
+SHOW pg_strom.enable_gpujoin_inner_reorder;
+SHOW pg_strom.enable_gpujoin_bloom_filter;
+SHOW pg_strom.enable_gpujoin_late_materialization;
+SHOW pg_strom.program_cache_share_literals;
+SHOW pg_strom.cpu_fallback_during_build;
+SHOW pg_strom.debug_force_cpu_fallback;
+SHOW pg_strom.enable_device_cse;
+SHOW pg_strom.scalar_array_hash_threshold;
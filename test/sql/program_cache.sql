@@ -0,0 +1,162 @@
+---
+--- Test cases for the persistent program cache files
+---
+RESET pg_strom.enabled;
+CREATE FUNCTION pg_temp.flip_byte(fname text, pos int)
+RETURNS void AS $$
+DECLARE
+  image  bytea := pg_read_binary_file(fname);
+  lobj   oid;
+BEGIN
+  IF pos < 0 THEN
+    pos := length(image) + pos;
+  END IF;
+  image := set_byte(image, pos, get_byte(image, pos) # 255);
+  lobj := lo_from_bytea(0, image);
+  PERFORM lo_export(lobj, fname);
+  PERFORM lo_unlink(lobj);
+END
+$$ LANGUAGE plpgsql;
+CREATE FUNCTION pg_temp.truncate_file(fname text, len int)
+RETURNS void AS $$
+DECLARE
+  image  bytea := pg_read_binary_file(fname);
+  lobj   oid;
+BEGIN
+  IF len < 0 THEN
+    len := length(image) + len;
+  END IF;
+  lobj := lo_from_bytea(0, substring(image from 1 for len));
+  PERFORM lo_export(lobj, fname);
+  PERFORM lo_unlink(lobj);
+END
+$$ LANGUAGE plpgsql;
+DO $$
+BEGIN
+  PERFORM pgstrom.program_cache_file_evict('pg_strom_program_cache_test', 0);
+END
+$$;
+-- stored binaries; no need to build them by GPU device
+CREATE TABLE pg_temp.pcache_images (name text, kern_define text,
+                                    kern_source text, ptx_image bytea);
+INSERT INTO pg_temp.pcache_images
+     VALUES ('a', '#define KERN_A 1', 'kern_a(void)',
+             convert_to(repeat('a', 1000), 'SQL_ASCII')),
+            ('b', '#define KERN_B 1', 'kern_b(void)',
+             convert_to(repeat('b', 1000), 'SQL_ASCII')),
+            ('c', '#define KERN_C 1', 'kern_c(void)',
+             convert_to(repeat('c', 1000), 'SQL_ASCII'));
+SELECT name, pgstrom.program_cache_file_save('pg_strom_program_cache_test',
+                                             1024, kern_define,
+                                             kern_source, ptx_image) AS fname
+  INTO pg_temp.pcache_files
+  FROM pg_temp.pcache_images
+ WHERE name IN ('a','b');
+
+-- identical program is loaded
+SELECT pgstrom.program_cache_file_load('pg_strom_program_cache_test',
+                                       kern_define, kern_source) = ptx_image
+       AS loaded
+  FROM pg_temp.pcache_images WHERE name = 'a';
+-- different target or build flags are not the identical program
+SELECT pgstrom.program_cache_file_load('pg_strom_program_cache_test',
+                                       kern_define, kern_source,
+                                       75, 0, 0) IS NULL AS rejected_cc
+  FROM pg_temp.pcache_images WHERE name = 'a';
+SELECT pgstrom.program_cache_file_load('pg_strom_program_cache_test',
+                                       kern_define, kern_source,
+                                       0, 1, 0) IS NULL AS rejected_flags
+  FROM pg_temp.pcache_images WHERE name = 'a';
+-- varlena buffer larger than the stored one is not acceptable
+SELECT pgstrom.program_cache_file_load('pg_strom_program_cache_test',
+                                       kern_define, kern_source,
+                                       0, 0, 4096) IS NULL AS rejected_bufsz
+  FROM pg_temp.pcache_images WHERE name = 'a';
+
+-- least recently used files are evicted first
+DO $$
+BEGIN
+  PERFORM pg_sleep(1.1);
+END
+$$;
+SELECT pgstrom.program_cache_file_load('pg_strom_program_cache_test',
+                                       kern_define, kern_source) IS NOT NULL
+       AS loaded
+  FROM pg_temp.pcache_images WHERE name = 'a';
+INSERT INTO pg_temp.pcache_files
+     SELECT name, pgstrom.program_cache_file_save('pg_strom_program_cache_test',
+                                                  1024, kern_define,
+                                                  kern_source, ptx_image)
+       FROM pg_temp.pcache_images
+      WHERE name = 'c';
+SELECT pgstrom.program_cache_file_evict('pg_strom_program_cache_test', 3);
+SELECT name, pgstrom.program_cache_file_load('pg_strom_program_cache_test',
+                                             kern_define, kern_source)
+             IS NOT NULL AS cached
+  FROM pg_temp.pcache_images
+ ORDER BY name;
+
+-- header mismatch (e.g, different cuda_*.h files) is not acceptable
+DO $$
+BEGIN
+  PERFORM pg_temp.flip_byte(fname, 4)
+     FROM pg_temp.pcache_files WHERE name = 'a';
+END
+$$;
+-- corrupted PTX image is not acceptable
+DO $$
+BEGIN
+  PERFORM pg_temp.flip_byte(fname, -1)
+     FROM pg_temp.pcache_files WHERE name = 'c';
+END
+$$;
+SELECT name, pgstrom.program_cache_file_load('pg_strom_program_cache_test',
+                                             kern_define, kern_source)
+             IS NOT NULL AS cached
+  FROM pg_temp.pcache_images
+ ORDER BY name;
+
+-- rejected files are replaced by the rebuilt binaries
+SELECT name, pgstrom.program_cache_file_save('pg_strom_program_cache_test',
+                                             1024, kern_define,
+                                             kern_source, ptx_image)
+             IS NOT NULL AS saved
+  FROM pg_temp.pcache_images
+ ORDER BY name;
+SELECT name, pgstrom.program_cache_file_load('pg_strom_program_cache_test',
+                                             kern_define, kern_source)
+             = ptx_image AS loaded
+  FROM pg_temp.pcache_images
+ ORDER BY name;
+
+-- truncated files are not acceptable
+DO $$
+BEGIN
+  PERFORM pg_temp.truncate_file(fname, -1)
+     FROM pg_temp.pcache_files WHERE name = 'a';
+  PERFORM pg_temp.truncate_file(fname, 16)
+     FROM pg_temp.pcache_files WHERE name = 'b';
+END
+$$;
+SELECT name, pgstrom.program_cache_file_load('pg_strom_program_cache_test',
+                                             kern_define, kern_source)
+             IS NOT NULL AS cached
+  FROM pg_temp.pcache_images
+ ORDER BY name;
+
+-- a stale binary built with smaller varlena buffer is rejected, then
+-- the rebuilt one replaces it
+SELECT pgstrom.program_cache_file_load('pg_strom_program_cache_test',
+                                       kern_define, kern_source,
+                                       0, 0, 4096) IS NULL AS rejected_bufsz
+  FROM pg_temp.pcache_images WHERE name = 'c';
+SELECT pgstrom.program_cache_file_save('pg_strom_program_cache_test',
+                                       1024, kern_define,
+                                       kern_source, ptx_image,
+                                       0, 0, 4096) IS NOT NULL AS saved
+  FROM pg_temp.pcache_images WHERE name = 'c';
+SELECT pgstrom.program_cache_file_load('pg_strom_program_cache_test',
+                                       kern_define, kern_source,
+                                       0, 0, 4096) = ptx_image AS loaded
+  FROM pg_temp.pcache_images WHERE name = 'c';
+SELECT pgstrom.program_cache_file_evict('pg_strom_program_cache_test', 0);
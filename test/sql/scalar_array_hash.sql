@@ -0,0 +1,97 @@
+---
+--- Test cases for hash-based evaluation of large IN-lists
+---
+RESET pg_strom.enabled;
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+SET pg_strom.debug_kernel_source = on;
+SELECT array_agg(x * 7)::text arr4
+  FROM generate_series(1,5000) x \gset
+SELECT array_agg(x::bigint * 13 - 20000)::text arr8
+  FROM generate_series(1,3000) x \gset
+SELECT array_agg(CASE WHEN x % 100 = 0 THEN NULL ELSE x * 3 END)::text arr2
+  FROM generate_series(1,2000) x \gset
+
+-- large IN-list is probed by the hash-set
+SELECT regress_kernel_source('SELECT id, c FROM t_int1 WHERE id = ANY(' ||
+                             quote_literal(:'arr4') || '::int[])')
+       ~ 'PG_SCALAR_ARRAY_HASH' AS hashed;
+SET pg_strom.scalar_array_hash_threshold = 0;
+SELECT regress_kernel_source('SELECT id, c FROM t_int1 WHERE id = ANY(' ||
+                             quote_literal(:'arr4') || '::int[])')
+       ~ 'PG_SCALAR_ARRAY_HASH' AS hashed;
+RESET pg_strom.scalar_array_hash_threshold;
+-- array parameter is always probed by the hash-set, built on execution;
+-- the first five executions run custom plans with the constant array.
+PREPARE p_h06(int[]) AS SELECT id, c FROM t_int1 WHERE id = ANY($1);
+SET pg_strom.scalar_array_hash_threshold = 100000;
+SELECT x, regress_kernel_source('EXECUTE p_h06(' || quote_literal(:'arr4') || ')')
+          ~ 'PG_SCALAR_ARRAY_HASH' AS hashed
+  FROM generate_series(1,6) x;
+RESET pg_strom.scalar_array_hash_threshold;
+RESET pg_strom.debug_kernel_source;
+
+SELECT id, c
+  INTO pg_temp.test_h01a
+  FROM t_int1
+ WHERE id = ANY(:'arr4'::int[]);
+SELECT id, e
+  INTO pg_temp.test_h02a
+  FROM t_int1
+ WHERE e % 40000 = ANY(:'arr8'::bigint[]);
+SELECT id, a
+  INTO pg_temp.test_h03a
+  FROM t_int1
+ WHERE a = ANY(:'arr2'::smallint[]);
+SELECT id, a
+  INTO pg_temp.test_h04a
+  FROM t_int1
+ WHERE NOT (a = ANY(:'arr2'::smallint[])) AND id % 20 = 0;
+SELECT e % 10 k, count(*) v1
+  INTO pg_temp.test_h05a
+  FROM t_int1
+ WHERE c % 40000 = ANY(:'arr4'::int[])
+ GROUP BY 1;
+CREATE TABLE pg_temp.test_h06a AS EXECUTE p_h06(:'arr4');
+EXECUTE p_h06(NULL);
+
+SET pg_strom.enabled = off;
+SELECT id, c
+  INTO pg_temp.test_h01b
+  FROM t_int1
+ WHERE id = ANY(:'arr4'::int[]);
+SELECT id, e
+  INTO pg_temp.test_h02b
+  FROM t_int1
+ WHERE e % 40000 = ANY(:'arr8'::bigint[]);
+SELECT id, a
+  INTO pg_temp.test_h03b
+  FROM t_int1
+ WHERE a = ANY(:'arr2'::smallint[]);
+SELECT id, a
+  INTO pg_temp.test_h04b
+  FROM t_int1
+ WHERE NOT (a = ANY(:'arr2'::smallint[])) AND id % 20 = 0;
+SELECT e % 10 k, count(*) v1
+  INTO pg_temp.test_h05b
+  FROM t_int1
+ WHERE c % 40000 = ANY(:'arr4'::int[])
+ GROUP BY 1;
+SELECT id, c
+  INTO pg_temp.test_h06b
+  FROM t_int1
+ WHERE id = ANY(:'arr4'::int[]);
+RESET pg_strom.enabled;
+(SELECT * FROM pg_temp.test_h01a EXCEPT ALL SELECT * FROM pg_temp.test_h01b);
+(SELECT * FROM pg_temp.test_h01b EXCEPT ALL SELECT * FROM pg_temp.test_h01a);
+(SELECT * FROM pg_temp.test_h02a EXCEPT ALL SELECT * FROM pg_temp.test_h02b);
+(SELECT * FROM pg_temp.test_h02b EXCEPT ALL SELECT * FROM pg_temp.test_h02a);
+(SELECT * FROM pg_temp.test_h03a EXCEPT ALL SELECT * FROM pg_temp.test_h03b);
+(SELECT * FROM pg_temp.test_h03b EXCEPT ALL SELECT * FROM pg_temp.test_h03a);
+(SELECT * FROM pg_temp.test_h04a EXCEPT ALL SELECT * FROM pg_temp.test_h04b);
+(SELECT * FROM pg_temp.test_h04b EXCEPT ALL SELECT * FROM pg_temp.test_h04a);
+(SELECT * FROM pg_temp.test_h05a EXCEPT ALL SELECT * FROM pg_temp.test_h05b);
+(SELECT * FROM pg_temp.test_h05b EXCEPT ALL SELECT * FROM pg_temp.test_h05a);
+(SELECT * FROM pg_temp.test_h06a EXCEPT ALL SELECT * FROM pg_temp.test_h06b);
+(SELECT * FROM pg_temp.test_h06b EXCEPT ALL SELECT * FROM pg_temp.test_h06a);
+DEALLOCATE p_h06;
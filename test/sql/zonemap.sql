@@ -0,0 +1,72 @@
+---
+--- Test cases for zone map built during the heap scan
+---
+RESET pg_strom.enabled;
+SET max_parallel_workers_per_gather = 0;
+SET synchronize_seqscans = off;
+CREATE FUNCTION pg_temp.zonemap_skipped(query text)
+RETURNS bool AS $$
+DECLARE
+  line  text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN (analyze, costs off, timing off) ' || query
+  LOOP
+    IF substring(line from 'Zone-Map skipped: (\d+)')::int > 0 THEN
+      RETURN true;
+    END IF;
+  END LOOP;
+  RETURN false;
+END
+$$ LANGUAGE plpgsql;
+-- sparse table sorted by id, with three or more 64MB block ranges
+CREATE TABLE zonemap_t1 (id int, a int, c text)
+  WITH (fillfactor = 10);
+INSERT INTO zonemap_t1
+     SELECT x, x % 1000, md5(x::text)
+       FROM generate_series(1,300000) x;
+VACUUM (FREEZE, ANALYZE) zonemap_t1;
+
+-- the first scan builds zone map, then the second one skips block ranges
+SELECT pg_temp.zonemap_skipped('SELECT * FROM zonemap_t1 WHERE id > 280000')
+    AS zonemap_first;
+SELECT pg_temp.zonemap_skipped('SELECT * FROM zonemap_t1 WHERE id > 280000')
+    AS zonemap_skipped;
+SELECT id, a, c
+  INTO pg_temp.test_z01a
+  FROM zonemap_t1
+ WHERE id > 280000;
+SELECT id, a, c
+  INTO pg_temp.test_z02a
+  FROM zonemap_t1
+ WHERE id BETWEEN 100000 AND 100100;
+
+-- updates invalidate zone map of the first range, but not others
+UPDATE zonemap_t1 SET id = 999999 WHERE id = 10;
+SELECT pg_temp.zonemap_skipped('SELECT * FROM zonemap_t1 WHERE id > 280000')
+    AS zonemap_updated;
+SELECT id, a, c
+  INTO pg_temp.test_z03a
+  FROM zonemap_t1
+ WHERE id > 280000;
+
+SET pg_strom.enabled = off;
+SELECT id, a, c
+  INTO pg_temp.test_z01b
+  FROM zonemap_t1
+ WHERE id > 280000 AND id <> 999999;
+SELECT id, a, c
+  INTO pg_temp.test_z02b
+  FROM zonemap_t1
+ WHERE id BETWEEN 100000 AND 100100;
+SELECT id, a, c
+  INTO pg_temp.test_z03b
+  FROM zonemap_t1
+ WHERE id > 280000;
+(SELECT * FROM pg_temp.test_z01a EXCEPT ALL SELECT * FROM pg_temp.test_z01b);
+(SELECT * FROM pg_temp.test_z01b EXCEPT ALL SELECT * FROM pg_temp.test_z01a);
+(SELECT * FROM pg_temp.test_z02a EXCEPT ALL SELECT * FROM pg_temp.test_z02b);
+(SELECT * FROM pg_temp.test_z02b EXCEPT ALL SELECT * FROM pg_temp.test_z02a);
+(SELECT * FROM pg_temp.test_z03a EXCEPT ALL SELECT * FROM pg_temp.test_z03b);
+(SELECT * FROM pg_temp.test_z03b EXCEPT ALL SELECT * FROM pg_temp.test_z03a);
+SELECT count(*) AS updated FROM pg_temp.test_z03a WHERE id > 900000;
+DROP TABLE zonemap_t1;
@@ -635,11 +635,55 @@ INSERT INTO t_daterange2 (SELECT x, random_daterange(0.5),
                                     random_daterange(0.5)
                             FROM generate_series(800001,1000000) X);
 
+-- Helper functions shared by the test cases
+CREATE OR REPLACE FUNCTION
+public.regress_plan_uses(query text, node text,
+                         options text = 'costs off')
+RETURNS bool AS $$
+DECLARE
+  line  text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN (' || options || ') ' || query
+  LOOP
+    IF strpos(line, node) > 0 THEN
+      RETURN true;
+    END IF;
+  END LOOP;
+  RETURN false;
+END
+$$ LANGUAGE plpgsql;
+
+CREATE OR REPLACE FUNCTION
+public.regress_explain_uses(query text, node text)
+RETURNS bool AS $$
+BEGIN
+  RETURN regress_plan_uses(query, node, 'analyze, costs off, timing off');
+END
+$$ LANGUAGE plpgsql;
+
+-- device code of the query; needs pg_strom.debug_kernel_source = on
+CREATE OR REPLACE FUNCTION
+public.regress_kernel_source(query text)
+RETURNS text AS $$
+DECLARE
+  line    text;
+  fname   text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN (verbose) ' || query LOOP
+    fname := substring(line from 'Kernel Source: (.*)$');
+    IF fname IS NOT NULL THEN
+      RETURN pg_read_file(fname);
+    END IF;
+  END LOOP;
+  RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
 -- Mark TestDB construction completed
 CREATE OR REPLACE FUNCTION
 public.pgstrom_regression_test_revision()
 RETURNS int
-AS 'SELECT 20180124'
+AS 'SELECT 20261017'
 LANGUAGE 'sql';
 
 COMMIT;